@@ -0,0 +1,144 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <random>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+
+#include "Sha256.h"
+#include "AssetCache.h"
+
+
+namespace Humpback
+{
+	namespace
+	{
+		// Distinguishes the temporary files of engine instances sharing a cache directory.
+		uint64_t GetInstanceNonce()
+		{
+			static const uint64_t nonce = []()
+			{
+				std::random_device device;
+				return ((uint64_t)device() << 32) | device();
+			}();
+
+			return nonce;
+		}
+	}
+
+	const char* const AssetCache::DEFAULT_DIRECTORY = "Cache";
+
+	AssetCache::AssetCache(const std::string& directory) :
+		m_directory(directory)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(m_directory, error);
+	}
+
+	std::string AssetCache::ComputeKey(const std::string& sourcePath, const std::string& salt)
+	{
+		MappedFile source;
+		if (source.Open(sourcePath) == false)
+		{
+			return std::string();
+		}
+
+		return ComputeKey(source.GetData(), source.GetSize(), salt);
+	}
+
+	std::string AssetCache::ComputeKey(const void* sourceData, uint64_t sourceSize, const std::string& salt)
+	{
+		Sha256 hash;
+		hash.Update(salt);
+		hash.Update("\n", 1);
+		hash.Update(sourceData, (size_t)sourceSize);
+
+		return Sha256::ToHex(hash.Finish());
+	}
+
+	bool AssetCache::Load(const std::string& key, MappedFile& file)
+	{
+		if (key.empty() == false && file.Open(_getEntryPath(key)))
+		{
+			m_hits++;
+			m_bytesRead += file.GetSize();
+			return true;
+		}
+
+		m_misses++;
+		return false;
+	}
+
+	void AssetCache::Reject(const MappedFile& file)
+	{
+		m_hits--;
+		m_misses++;
+		m_bytesRead -= file.GetSize();
+	}
+
+	bool AssetCache::Store(const std::string& key, const void* data, uint64_t size)
+	{
+		if (key.empty())
+		{
+			return false;
+		}
+
+		std::string entryPath = _getEntryPath(key);
+		std::string tempPath = entryPath + "." + std::to_string(GetInstanceNonce()) + "." +
+			std::to_string(m_tempCounter++) + ".tmp";
+
+		bool written = false;
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (file.is_open())
+			{
+				file.write((const char*)data, (std::streamsize)size);
+				file.flush();
+				written = file.good();
+			}
+		}
+
+		std::error_code error;
+		if (written)
+		{
+			std::filesystem::rename(tempPath, entryPath, error);
+
+			// On Windows the rename fails while another instance has the entry mapped. The
+			// entry is content-addressed, whatever is there already has the same bytes.
+			if (error && std::filesystem::exists(entryPath))
+			{
+				error.clear();
+			}
+		}
+
+		if (written == false || error)
+		{
+			std::filesystem::remove(tempPath, error);
+			m_writeFailures++;
+			return false;
+		}
+
+		// Only left behind when another instance won the rename.
+		std::filesystem::remove(tempPath, error);
+		m_bytesWritten += size;
+		return true;
+	}
+
+	AssetCacheStats AssetCache::GetStats() const
+	{
+		AssetCacheStats stats;
+		stats.hits = m_hits.load();
+		stats.misses = m_misses.load();
+		stats.bytesRead = m_bytesRead.load();
+		stats.bytesWritten = m_bytesWritten.load();
+		stats.writeFailures = m_writeFailures.load();
+		return stats;
+	}
+
+	std::string AssetCache::_getEntryPath(const std::string& key) const
+	{
+		return (std::filesystem::path(m_directory) / key).string();
+	}
+}
@@ -0,0 +1,72 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "MappedFile.h"
+
+
+namespace Humpback
+{
+	struct AssetCacheStats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t bytesRead = 0;
+		uint64_t bytesWritten = 0;
+		uint64_t writeFailures = 0;
+	};
+
+
+	// Content-addressed store for imported assets. An entry is named by the SHA-256 of the source
+	// bytes plus a salt describing the import (post-process flags, importer and format versions), so
+	// editing the source or changing the importer yields a new key and stale entries are never read.
+	// Entries are written to a unique temporary file and renamed into place, several engine instances
+	// can fill the same directory at once. Entries are immutable, two writers of a key write identical bytes.
+	class AssetCache
+	{
+	public:
+
+		static const char* const DEFAULT_DIRECTORY;
+
+		explicit AssetCache(const std::string& directory);
+
+		AssetCache(const AssetCache&) = delete;
+		AssetCache& operator=(const AssetCache&) = delete;
+
+		// Returns an empty key if the source can't be read.
+		static std::string ComputeKey(const std::string& sourcePath, const std::string& salt);
+		static std::string ComputeKey(const void* sourceData, uint64_t sourceSize, const std::string& salt);
+
+		// Maps the entry of key. Counts a hit or a miss.
+		bool Load(const std::string& key, MappedFile& file);
+
+		// Call when a loaded entry turned out to be unusable, it is counted as a miss instead of a hit.
+		void Reject(const MappedFile& file);
+
+		bool Store(const std::string& key, const void* data, uint64_t size);
+		bool Store(const std::string& key, const std::vector<uint8_t>& bytes) { return Store(key, bytes.data(), bytes.size()); }
+
+		AssetCacheStats GetStats() const;
+		const std::string& GetDirectory() const { return m_directory; }
+
+	private:
+
+		std::string _getEntryPath(const std::string& key) const;
+
+		std::string m_directory;
+
+		std::atomic<uint64_t> m_hits = 0;
+		std::atomic<uint64_t> m_misses = 0;
+		std::atomic<uint64_t> m_bytesRead = 0;
+		std::atomic<uint64_t> m_bytesWritten = 0;
+		std::atomic<uint64_t> m_writeFailures = 0;
+		std::atomic<uint32_t> m_tempCounter = 0;
+	};
+}
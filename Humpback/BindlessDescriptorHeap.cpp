@@ -0,0 +1,82 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <stdexcept>
+
+#include "BindlessDescriptorHeap.h"
+
+
+namespace Humpback
+{
+	void ThrowIfFailed(HRESULT hr);
+
+	BindlessDescriptorHeap::BindlessDescriptorHeap(ID3D12Device* device, uint32_t capacity) :
+		m_device(device),
+		m_indices(capacity)
+	{
+		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+		heapDesc.NumDescriptors = capacity;
+		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+		ThrowIfFailed(m_device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(m_heap.GetAddressOf())));
+
+		m_descriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		m_cpuStart = m_heap->GetCPUDescriptorHandleForHeapStart();
+		m_gpuStart = m_heap->GetGPUDescriptorHandleForHeapStart();
+	}
+
+	uint32_t BindlessDescriptorHeap::Allocate()
+	{
+		uint32_t index = m_indices.Allocate();
+		if (index == DescriptorIndexAllocator::INVALID_INDEX)
+		{
+			throw std::runtime_error("BindlessDescriptorHeap: out of descriptors.");
+		}
+
+		return index;
+	}
+
+	void BindlessDescriptorHeap::Free(uint32_t index, uint64_t fenceValue)
+	{
+		if (fenceValue == 0)
+		{
+			m_indices.Free(index);
+		}
+		else
+		{
+			m_indices.FreeDeferred(index, fenceValue);
+		}
+	}
+
+	void BindlessDescriptorHeap::ReleaseCompleted(uint64_t completedFenceValue)
+	{
+		m_indices.ReleaseCompleted(completedFenceValue);
+	}
+
+	uint32_t BindlessDescriptorHeap::CreateSrv(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc)
+	{
+		uint32_t index = Allocate();
+		UpdateSrv(index, resource, desc);
+		return index;
+	}
+
+	void BindlessDescriptorHeap::UpdateSrv(uint32_t index, ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc)
+	{
+		m_device->CreateShaderResourceView(resource, desc, GetCpuHandle(index));
+	}
+
+	D3D12_CPU_DESCRIPTOR_HANDLE BindlessDescriptorHeap::GetCpuHandle(uint32_t index) const
+	{
+		D3D12_CPU_DESCRIPTOR_HANDLE handle = m_cpuStart;
+		handle.ptr += (SIZE_T)index * m_descriptorSize;
+		return handle;
+	}
+
+	D3D12_GPU_DESCRIPTOR_HANDLE BindlessDescriptorHeap::GetGpuHandle(uint32_t index) const
+	{
+		D3D12_GPU_DESCRIPTOR_HANDLE handle = m_gpuStart;
+		handle.ptr += (UINT64)index * m_descriptorSize;
+		return handle;
+	}
+}
@@ -0,0 +1,59 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "DescriptorIndexAllocator.h"
+
+
+namespace Humpback
+{
+	// One large shader-visible CBV/SRV/UAV heap. Every view lives at a stable index that shaders use to
+	// read the unbounded _Textures[] / _CubeTextures[] arrays, so root tables are bound once at the heap
+	// start and materials or passes only carry indices.
+	class BindlessDescriptorHeap
+	{
+	public:
+
+		static const uint32_t DEFAULT_CAPACITY = 16384;
+
+		BindlessDescriptorHeap(ID3D12Device* device, uint32_t capacity = DEFAULT_CAPACITY);
+
+		BindlessDescriptorHeap(const BindlessDescriptorHeap&) = delete;
+		BindlessDescriptorHeap& operator=(const BindlessDescriptorHeap&) = delete;
+
+		// Throws when the heap is full.
+		uint32_t Allocate();
+
+		// The slot is reused once fenceValue has completed, pass 0 if the GPU never saw it.
+		void Free(uint32_t index, uint64_t fenceValue);
+		void ReleaseCompleted(uint64_t completedFenceValue);
+
+		// Allocates a slot and writes an SRV of the resource into it. desc may be null for the default view.
+		uint32_t CreateSrv(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc = nullptr);
+		void UpdateSrv(uint32_t index, ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc = nullptr);
+
+		D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(uint32_t index) const;
+		D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(uint32_t index) const;
+
+		ID3D12DescriptorHeap* GetHeap() const { return m_heap.Get(); }
+		unsigned int GetDescriptorSize() const { return m_descriptorSize; }
+		uint32_t GetCapacity() const { return m_indices.GetCapacity(); }
+		uint32_t GetAllocatedCount() const { return m_indices.GetAllocatedCount(); }
+
+	private:
+
+		Microsoft::WRL::ComPtr<ID3D12Device> m_device;
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_heap;
+		unsigned int m_descriptorSize;
+
+		D3D12_CPU_DESCRIPTOR_HANDLE m_cpuStart;
+		D3D12_GPU_DESCRIPTOR_HANDLE m_gpuStart;
+
+		DescriptorIndexAllocator m_indices;
+	};
+}
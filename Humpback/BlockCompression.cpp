@@ -0,0 +1,1063 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include <smmintrin.h>
+
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include "BlockCompression.h"
+
+
+namespace Humpback
+{
+	namespace
+	{
+		// Roughly what a job should encode, small levels end up on a single thread.
+		const uint32_t BLOCKS_PER_JOB = 1024;
+
+		// Endpoint refinement passes after the principal axis fit.
+		const int REFINE_ITERATIONS = 2;
+
+		const uint32_t DDS_MAGIC = 0x20534444;				// "DDS "
+		const uint32_t DDS_FOURCC_DX10 = 0x30315844;		// "DX10"
+
+		struct DdsPixelFormat
+		{
+			uint32_t size;
+			uint32_t flags;
+			uint32_t fourCC;
+			uint32_t rgbBitCount;
+			uint32_t rBitMask;
+			uint32_t gBitMask;
+			uint32_t bBitMask;
+			uint32_t aBitMask;
+		};
+
+		struct DdsHeader
+		{
+			uint32_t size;
+			uint32_t flags;
+			uint32_t height;
+			uint32_t width;
+			uint32_t pitchOrLinearSize;
+			uint32_t depth;
+			uint32_t mipMapCount;
+			uint32_t reserved1[11];
+			DdsPixelFormat ddspf;
+			uint32_t caps;
+			uint32_t caps2;
+			uint32_t caps3;
+			uint32_t caps4;
+			uint32_t reserved2;
+		};
+
+		struct DdsHeaderDx10
+		{
+			uint32_t dxgiFormat;
+			uint32_t resourceDimension;
+			uint32_t miscFlag;
+			uint32_t arraySize;
+			uint32_t miscFlags2;
+		};
+
+		static_assert(sizeof(DdsHeader) == 124, "DDS header layout");
+		static_assert(sizeof(DdsHeaderDx10) == 20, "DDS DX10 header layout");
+
+		const uint64_t DDS_DATA_OFFSET = sizeof(uint32_t) + sizeof(DdsHeader) + sizeof(DdsHeaderDx10);
+
+		const uint32_t DDSD_CAPS = 0x1;
+		const uint32_t DDSD_HEIGHT = 0x2;
+		const uint32_t DDSD_WIDTH = 0x4;
+		const uint32_t DDSD_PIXELFORMAT = 0x1000;
+		const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+		const uint32_t DDSD_LINEARSIZE = 0x80000;
+		const uint32_t DDPF_FOURCC = 0x4;
+		const uint32_t DDSCAPS_COMPLEX = 0x8;
+		const uint32_t DDSCAPS_TEXTURE = 0x1000;
+		const uint32_t DDSCAPS_MIPMAP = 0x400000;
+		const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+		const uint32_t DDS_ALPHA_MODE_STRAIGHT = 1;
+
+		// DXGI_FORMAT values, this file doesn't depend on the D3D headers.
+		uint32_t GetDxgiFormat(BlockFormat format, bool srgb)
+		{
+			switch (format)
+			{
+			case BlockFormat::BC1: return srgb ? 72 : 71;
+			case BlockFormat::BC4: return 80;
+			case BlockFormat::BC5: return 83;
+			case BlockFormat::BC7: return srgb ? 99 : 98;
+			default: return 0;
+			}
+		}
+
+		uint32_t GetBlockCount(uint32_t size)
+		{
+			return std::max(1u, (size + 3) / 4);
+		}
+
+		uint64_t GetLevelSize(uint32_t width, uint32_t height, uint32_t level, BlockFormat format)
+		{
+			uint32_t levelWidth = std::max(1u, width >> level);
+			uint32_t levelHeight = std::max(1u, height >> level);
+			return (uint64_t)GetBlockCount(levelWidth) * GetBlockCount(levelHeight) * GetBlockFormatBlockSize(format);
+		}
+
+
+		// A 4x4 block of texels split by channel, in 0-255 units whatever the source depth.
+		struct Block
+		{
+			alignas(16) float c[4][16];
+		};
+
+		const float WEIGHTS_RGBA[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		const float WEIGHTS_RGB[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+		const float WEIGHTS_R[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+		const float WEIGHTS_G[4] = { 0.0f, 1.0f, 0.0f, 0.0f };
+		const float WEIGHTS_A[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+		// Interpolation weights of the BC7 index precisions, out of 64.
+		const int BC7_WEIGHTS2[4] = { 0, 21, 43, 64 };
+		const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		const int MAX_PALETTE = 16;
+
+		// Picks the palette entry closest to every texel under the channel weights and returns the summed squared error.
+		float FindIndicesScalar(const Block& block, const float (*palette)[4], int paletteSize, const float weights[4], uint8_t indices[16])
+		{
+			float total = 0.0f;
+			for (int i = 0; i < 16; i++)
+			{
+				float best = FLT_MAX;
+				int bestIndex = 0;
+				for (int k = 0; k < paletteSize; k++)
+				{
+					float d = 0.0f;
+					for (int ch = 0; ch < 4; ch++)
+					{
+						float t = block.c[ch][i] - palette[k][ch];
+						d += t * t * weights[ch];
+					}
+					if (d < best)
+					{
+						best = d;
+						bestIndex = k;
+					}
+				}
+				total += best;
+				indices[i] = (uint8_t)bestIndex;
+			}
+			return total;
+		}
+
+		// Four texels at a time. Ties go to the lower index as in the scalar loop, so the indices are identical.
+		HB_TARGET_SSE41 float FindIndicesSse41(const Block& block, const float (*palette)[4], int paletteSize, const float weights[4],
+			uint8_t indices[16])
+		{
+			__m128 entries[MAX_PALETTE][4];
+			for (int k = 0; k < paletteSize; k++)
+			{
+				for (int ch = 0; ch < 4; ch++)
+				{
+					entries[k][ch] = _mm_set1_ps(palette[k][ch]);
+				}
+			}
+
+			const __m128 w[4] = { _mm_set1_ps(weights[0]), _mm_set1_ps(weights[1]), _mm_set1_ps(weights[2]), _mm_set1_ps(weights[3]) };
+			alignas(16) float errors[16];
+
+			for (int i = 0; i < 16; i += 4)
+			{
+				const __m128 x[4] =
+				{
+					_mm_load_ps(block.c[0] + i), _mm_load_ps(block.c[1] + i), _mm_load_ps(block.c[2] + i), _mm_load_ps(block.c[3] + i),
+				};
+
+				__m128 best = _mm_set1_ps(FLT_MAX);
+				__m128 bestIndex = _mm_setzero_ps();
+				for (int k = 0; k < paletteSize; k++)
+				{
+					__m128 d = _mm_setzero_ps();
+					for (int ch = 0; ch < 4; ch++)
+					{
+						__m128 t = _mm_sub_ps(x[ch], entries[k][ch]);
+						d = _mm_add_ps(d, _mm_mul_ps(_mm_mul_ps(t, t), w[ch]));
+					}
+
+					__m128 closer = _mm_cmplt_ps(d, best);
+					best = _mm_min_ps(d, best);
+					bestIndex = _mm_blendv_ps(bestIndex, _mm_set1_ps((float)k), closer);
+				}
+
+				_mm_store_ps(errors + i, best);
+
+				__m128i index = _mm_cvtps_epi32(bestIndex);
+				index = _mm_packs_epi32(index, index);
+				index = _mm_packus_epi16(index, index);
+				int packed = _mm_cvtsi128_si32(index);
+				std::memcpy(indices + i, &packed, 4);
+			}
+
+			// Summed in texel order, a different rounding of the total could make the callers pick other endpoints.
+			float total = 0.0f;
+			for (int i = 0; i < 16; i++)
+			{
+				total += errors[i];
+			}
+			return total;
+		}
+
+		float FindIndices(const Block& block, const float (*palette)[4], int paletteSize, const float weights[4], uint8_t indices[16])
+		{
+			if (GetCpuFeatures().sse41)
+			{
+				return FindIndicesSse41(block, palette, paletteSize, weights, indices);
+			}
+			return FindIndicesScalar(block, palette, paletteSize, weights, indices);
+		}
+
+		// Endpoints spanning the texels along their principal axis.
+		void FitPrincipalAxis(const Block& block, const float weights[4], float e0[4], float e1[4])
+		{
+			float mean[4] = {};
+			for (int ch = 0; ch < 4; ch++)
+			{
+				for (int i = 0; i < 16; i++)
+				{
+					mean[ch] += block.c[ch][i];
+				}
+				mean[ch] = weights[ch] > 0.0f ? mean[ch] / 16.0f : 0.0f;
+			}
+
+			float cov[4][4] = {};
+			for (int i = 0; i < 16; i++)
+			{
+				float d[4];
+				for (int ch = 0; ch < 4; ch++)
+				{
+					d[ch] = weights[ch] > 0.0f ? block.c[ch][i] - mean[ch] : 0.0f;
+				}
+				for (int a = 0; a < 4; a++)
+				{
+					for (int b = a; b < 4; b++)
+					{
+						cov[a][b] += d[a] * d[b];
+					}
+				}
+			}
+			for (int a = 0; a < 4; a++)
+			{
+				for (int b = 0; b < a; b++)
+				{
+					cov[a][b] = cov[b][a];
+				}
+			}
+
+			// Power iteration, started from the channel that varies most.
+			float axis[4] = {};
+			int widest = 0;
+			for (int ch = 1; ch < 4; ch++)
+			{
+				widest = cov[ch][ch] > cov[widest][widest] ? ch : widest;
+			}
+			axis[widest] = 1.0f;
+
+			for (int iteration = 0; iteration < 8; iteration++)
+			{
+				float next[4] = {};
+				float length = 0.0f;
+				for (int a = 0; a < 4; a++)
+				{
+					for (int b = 0; b < 4; b++)
+					{
+						next[a] += cov[a][b] * axis[b];
+					}
+					length += next[a] * next[a];
+				}
+				if (length < 1e-12f)
+				{
+					break;
+				}
+				length = 1.0f / std::sqrt(length);
+				for (int a = 0; a < 4; a++)
+				{
+					axis[a] = next[a] * length;
+				}
+			}
+
+			float minT = FLT_MAX;
+			float maxT = -FLT_MAX;
+			for (int i = 0; i < 16; i++)
+			{
+				float t = 0.0f;
+				for (int ch = 0; ch < 4; ch++)
+				{
+					t += (block.c[ch][i] - mean[ch]) * axis[ch] * (weights[ch] > 0.0f ? 1.0f : 0.0f);
+				}
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+
+			for (int ch = 0; ch < 4; ch++)
+			{
+				e0[ch] = std::clamp(mean[ch] + axis[ch] * minT, 0.0f, 255.0f);
+				e1[ch] = std::clamp(mean[ch] + axis[ch] * maxT, 0.0f, 255.0f);
+			}
+		}
+
+		// Least squares endpoints for fixed indices, alphas[k] is where entry k sits between the endpoints.
+		// Leaves the endpoints alone when every texel picked the same weight.
+		void RefineEndpoints(const Block& block, const uint8_t indices[16], const float* alphas, float e0[4], float e1[4])
+		{
+			float aa = 0.0f;
+			float ab = 0.0f;
+			float bb = 0.0f;
+			float x0[4] = {};
+			float x1[4] = {};
+			for (int i = 0; i < 16; i++)
+			{
+				float t = alphas[indices[i]];
+				float s = 1.0f - t;
+				aa += s * s;
+				ab += s * t;
+				bb += t * t;
+				for (int ch = 0; ch < 4; ch++)
+				{
+					x0[ch] += s * block.c[ch][i];
+					x1[ch] += t * block.c[ch][i];
+				}
+			}
+
+			float det = aa * bb - ab * ab;
+			if (std::fabs(det) < 1e-6f)
+			{
+				return;
+			}
+
+			det = 1.0f / det;
+			for (int ch = 0; ch < 4; ch++)
+			{
+				e0[ch] = std::clamp((bb * x0[ch] - ab * x1[ch]) * det, 0.0f, 255.0f);
+				e1[ch] = std::clamp((aa * x1[ch] - ab * x0[ch]) * det, 0.0f, 255.0f);
+			}
+		}
+
+
+		// Packs fields least significant bit first, as every BC format does.
+		class BitWriter
+		{
+		public:
+
+			void Put(uint32_t value, int bits)
+			{
+				if (m_pos < 64)
+				{
+					m_lo |= (uint64_t)value << m_pos;
+					if (m_pos + bits > 64)
+					{
+						m_hi |= (uint64_t)value >> (64 - m_pos);
+					}
+				}
+				else
+				{
+					m_hi |= (uint64_t)value << (m_pos - 64);
+				}
+				m_pos += bits;
+			}
+
+			void Store(uint8_t* dst) const
+			{
+				for (int i = 0; i < 8; i++)
+				{
+					dst[i] = (uint8_t)(m_lo >> (i * 8));
+					dst[i + 8] = (uint8_t)(m_hi >> (i * 8));
+				}
+			}
+
+		private:
+
+			uint64_t m_lo = 0;
+			uint64_t m_hi = 0;
+			int m_pos = 0;
+		};
+
+
+		// BC1: two RGB565 endpoints and 2 bit indices, always in four color mode.
+
+		int Expand5(int v) { return (v << 3) | (v >> 2); }
+		int Expand6(int v) { return (v << 2) | (v >> 4); }
+
+		// The code whose expansion lands closest to v.
+		template <int Bits, int (*Expand)(int)>
+		int QuantizeChannel(float v)
+		{
+			const int maxCode = (1 << Bits) - 1;
+			int guess = (int)std::lround(v * maxCode / 255.0f);
+			int best = 0;
+			float bestError = FLT_MAX;
+			for (int code = std::max(0, guess - 1); code <= std::min(maxCode, guess + 1); code++)
+			{
+				float error = std::fabs((float)Expand(code) - v);
+				if (error < bestError)
+				{
+					bestError = error;
+					best = code;
+				}
+			}
+			return best;
+		}
+
+		int Expand7(int v) { return (v << 1) | (v >> 6); }
+
+		uint16_t QuantizeRgb565(const float c[4])
+		{
+			return (uint16_t)((QuantizeChannel<5, Expand5>(c[0]) << 11) | (QuantizeChannel<6, Expand6>(c[1]) << 5) |
+				QuantizeChannel<5, Expand5>(c[2]));
+		}
+
+		void DecodeRgb565(uint16_t c, float out[4])
+		{
+			out[0] = (float)Expand5(c >> 11);
+			out[1] = (float)Expand6((c >> 5) & 63);
+			out[2] = (float)Expand5(c & 31);
+			out[3] = 0.0f;
+		}
+
+		void EncodeBC1(const Block& block, uint8_t* dst)
+		{
+			// Palette order is c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1.
+			static const float ALPHAS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+			float e0[4];
+			float e1[4];
+			FitPrincipalAxis(block, WEIGHTS_RGB, e0, e1);
+
+			float bestError = FLT_MAX;
+			uint16_t bestC0 = 0;
+			uint16_t bestC1 = 0;
+			uint8_t bestIndices[16] = {};
+
+			for (int iteration = 0; iteration <= REFINE_ITERATIONS; iteration++)
+			{
+				uint16_t c0 = QuantizeRgb565(e0);
+				uint16_t c1 = QuantizeRgb565(e1);
+				// Four color mode needs c0 > c1. Equal endpoints select three color mode, where index 0 is still c0.
+				if (c0 < c1)
+				{
+					std::swap(c0, c1);
+				}
+
+				float palette[4][4];
+				DecodeRgb565(c0, palette[0]);
+				DecodeRgb565(c1, palette[1]);
+				for (int ch = 0; ch < 4; ch++)
+				{
+					palette[2][ch] = (2.0f * palette[0][ch] + palette[1][ch]) / 3.0f;
+					palette[3][ch] = (palette[0][ch] + 2.0f * palette[1][ch]) / 3.0f;
+				}
+
+				uint8_t indices[16];
+				float error = FindIndices(block, palette, c0 == c1 ? 1 : 4, WEIGHTS_RGB, indices);
+				if (error < bestError)
+				{
+					bestError = error;
+					bestC0 = c0;
+					bestC1 = c1;
+					std::memcpy(bestIndices, indices, 16);
+				}
+
+				if (bestError == 0.0f)
+				{
+					break;
+				}
+				RefineEndpoints(block, bestIndices, ALPHAS, e0, e1);
+			}
+
+			uint32_t packedIndices = 0;
+			for (int i = 0; i < 16; i++)
+			{
+				packedIndices |= (uint32_t)bestIndices[i] << (i * 2);
+			}
+
+			std::memcpy(dst, &bestC0, 2);
+			std::memcpy(dst + 2, &bestC1, 2);
+			std::memcpy(dst + 4, &packedIndices, 4);
+		}
+
+
+		// BC4: two 8 bit endpoints and 3 bit indices for one channel. r0 > r1 interpolates six values between
+		// them, r0 <= r1 four and adds 0 and 255.
+
+		int BuildBC4Palette(int r0, int r1, int channel, float palette[8][4])
+		{
+			std::memset(palette, 0, sizeof(float) * 8 * 4);
+			palette[0][channel] = (float)r0;
+			palette[1][channel] = (float)r1;
+			if (r0 > r1)
+			{
+				for (int k = 2; k < 8; k++)
+				{
+					palette[k][channel] = ((8 - k) * r0 + (k - 1) * r1) / 7.0f;
+				}
+			}
+			else
+			{
+				for (int k = 2; k < 6; k++)
+				{
+					palette[k][channel] = ((6 - k) * r0 + (k - 1) * r1) / 5.0f;
+				}
+				palette[6][channel] = 0.0f;
+				palette[7][channel] = 255.0f;
+			}
+			return 8;
+		}
+
+		void EncodeBC4(const Block& block, int channel, uint8_t* dst)
+		{
+			static const float ALPHAS8[8] = { 0.0f, 1.0f, 1.0f / 7, 2.0f / 7, 3.0f / 7, 4.0f / 7, 5.0f / 7, 6.0f / 7 };
+
+			const float* weights = channel == 0 ? WEIGHTS_R : WEIGHTS_G;
+			const float* values = block.c[channel];
+
+			float minValue = 255.0f;
+			float maxValue = 0.0f;
+			float innerMin = 255.0f;
+			float innerMax = 0.0f;
+			for (int i = 0; i < 16; i++)
+			{
+				minValue = std::min(minValue, values[i]);
+				maxValue = std::max(maxValue, values[i]);
+				if (values[i] > 0.5f && values[i] < 254.5f)
+				{
+					innerMin = std::min(innerMin, values[i]);
+					innerMax = std::max(innerMax, values[i]);
+				}
+			}
+
+			float bestError = FLT_MAX;
+			int bestR0 = 0;
+			int bestR1 = 0;
+			uint8_t bestIndices[16] = {};
+
+			auto tryEndpoints = [&](int r0, int r1)
+			{
+				float palette[8][4];
+				uint8_t indices[16];
+				float error = FindIndices(block, palette, BuildBC4Palette(r0, r1, channel, palette), weights, indices);
+				if (error < bestError)
+				{
+					bestError = error;
+					bestR0 = r0;
+					bestR1 = r1;
+					std::memcpy(bestIndices, indices, 16);
+				}
+			};
+
+			// Eight value mode, refined for the picked indices.
+			float e0[4] = {};
+			float e1[4] = {};
+			e0[channel] = maxValue;
+			e1[channel] = minValue;
+			for (int iteration = 0; iteration <= REFINE_ITERATIONS && bestError > 0.0f; iteration++)
+			{
+				int r0 = (int)std::lround(e0[channel]);
+				int r1 = (int)std::lround(e1[channel]);
+				if (r0 == r1)
+				{
+					tryEndpoints(r0, r1);
+					break;
+				}
+				tryEndpoints(std::max(r0, r1), std::min(r0, r1));
+
+				// Refinement needs the entries in the order of the endpoints it solves for.
+				float refined0[4] = {};
+				float refined1[4] = {};
+				refined0[channel] = (float)bestR0;
+				refined1[channel] = (float)bestR1;
+				RefineEndpoints(block, bestIndices, ALPHAS8, refined0, refined1);
+				e0[channel] = refined0[channel];
+				e1[channel] = refined1[channel];
+			}
+
+			// Six value mode helps blocks that touch 0 or 255 and spread in between.
+			if (bestError > 0.0f && (minValue < 0.5f || maxValue > 254.5f) && innerMin <= innerMax)
+			{
+				tryEndpoints((int)std::lround(innerMin), (int)std::lround(innerMax));
+			}
+
+			uint64_t packedIndices = 0;
+			for (int i = 0; i < 16; i++)
+			{
+				packedIndices |= (uint64_t)bestIndices[i] << (i * 3);
+			}
+
+			dst[0] = (uint8_t)bestR0;
+			dst[1] = (uint8_t)bestR1;
+			for (int i = 0; i < 6; i++)
+			{
+				dst[2 + i] = (uint8_t)(packedIndices >> (i * 8));
+			}
+		}
+
+
+		// BC7, limited to the single subset modes: mode 6 (RGBA 7.7.7.7 with a p-bit per endpoint and 4 bit
+		// indices) for every block and mode 5 (RGB 7.7.7 and A 8 with 2 bit indices each) for blocks whose alpha
+		// doesn't line up with the color.
+
+		float InterpolateBC7(int e0, int e1, int weight)
+		{
+			return (float)(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+		}
+
+		struct BC7Candidate
+		{
+			float error = FLT_MAX;
+			int mode = 6;
+			int e0[4] = {};
+			int e1[4] = {};
+			uint8_t colorIndices[16] = {};
+			uint8_t alphaIndices[16] = {};
+		};
+
+		// Mode 6 endpoints are 8 bit values whose lowest bit is the endpoint's p-bit. Returns the squared error.
+		float QuantizeMode6Endpoint(const float e[4], int pBit, int out[4])
+		{
+			float error = 0.0f;
+			for (int ch = 0; ch < 4; ch++)
+			{
+				int code = std::clamp((int)std::lround((e[ch] - pBit) * 0.5f), 0, 127);
+				out[ch] = (code << 1) | pBit;
+				error += (out[ch] - e[ch]) * (out[ch] - e[ch]);
+			}
+			return error;
+		}
+
+		int ChooseMode6PBit(const float e[4])
+		{
+			int q[4];
+			return QuantizeMode6Endpoint(e, 1, q) < QuantizeMode6Endpoint(e, 0, q) ? 1 : 0;
+		}
+
+		void EncodeBC7Mode6(const Block& block, BC7Candidate& best)
+		{
+			float alphas[16];
+			for (int k = 0; k < 16; k++)
+			{
+				alphas[k] = BC7_WEIGHTS4[k] / 64.0f;
+			}
+
+			float e0[4];
+			float e1[4];
+			FitPrincipalAxis(block, WEIGHTS_RGBA, e0, e1);
+
+			for (int iteration = 0; iteration <= REFINE_ITERATIONS; iteration++)
+			{
+				uint8_t iterationIndices[16];
+				float iterationError = FLT_MAX;
+
+				// The p-bits are shared by the channels of an endpoint. While refining take the pair closest to the
+				// unquantized endpoints, the last pass tries all four.
+				const bool lastPass = iteration == REFINE_ITERATIONS;
+				const int closestPBits = ChooseMode6PBit(e0) | (ChooseMode6PBit(e1) << 1);
+				for (int pBits = 0; pBits < 4; pBits++)
+				{
+					if (lastPass == false && pBits != closestPBits)
+					{
+						continue;
+					}
+
+					int q0[4];
+					int q1[4];
+					QuantizeMode6Endpoint(e0, pBits & 1, q0);
+					QuantizeMode6Endpoint(e1, pBits >> 1, q1);
+
+					float palette[16][4];
+					for (int k = 0; k < 16; k++)
+					{
+						for (int ch = 0; ch < 4; ch++)
+						{
+							palette[k][ch] = InterpolateBC7(q0[ch], q1[ch], BC7_WEIGHTS4[k]);
+						}
+					}
+
+					uint8_t indices[16];
+					float error = FindIndices(block, palette, 16, WEIGHTS_RGBA, indices);
+					if (error < iterationError)
+					{
+						iterationError = error;
+						std::memcpy(iterationIndices, indices, 16);
+					}
+					if (error < best.error)
+					{
+						best.error = error;
+						best.mode = 6;
+						std::memcpy(best.e0, q0, sizeof(q0));
+						std::memcpy(best.e1, q1, sizeof(q1));
+						std::memcpy(best.colorIndices, indices, 16);
+					}
+				}
+
+				if (best.error == 0.0f)
+				{
+					break;
+				}
+				RefineEndpoints(block, iterationIndices, alphas, e0, e1);
+			}
+		}
+
+		// Fits the channels of weights with 2 bit indices. Color endpoints are 7 bit, alpha ones 8 bit.
+		float FitMode5Part(const Block& block, const float weights[4], bool alpha, int q0[4], int q1[4], uint8_t outIndices[16])
+		{
+			static const float ALPHAS[4] = { 0.0f, 21.0f / 64.0f, 43.0f / 64.0f, 1.0f };
+
+			float e0[4];
+			float e1[4];
+			FitPrincipalAxis(block, weights, e0, e1);
+
+			float bestError = FLT_MAX;
+			for (int iteration = 0; iteration <= REFINE_ITERATIONS; iteration++)
+			{
+				int c0[4] = {};
+				int c1[4] = {};
+				for (int ch = 0; ch < 4; ch++)
+				{
+					if (weights[ch] == 0.0f)
+					{
+						continue;
+					}
+					if (alpha)
+					{
+						c0[ch] = (int)std::lround(e0[ch]);
+						c1[ch] = (int)std::lround(e1[ch]);
+					}
+					else
+					{
+						c0[ch] = Expand7(QuantizeChannel<7, Expand7>(e0[ch]));
+						c1[ch] = Expand7(QuantizeChannel<7, Expand7>(e1[ch]));
+					}
+				}
+
+				float palette[4][4];
+				for (int k = 0; k < 4; k++)
+				{
+					for (int ch = 0; ch < 4; ch++)
+					{
+						palette[k][ch] = InterpolateBC7(c0[ch], c1[ch], BC7_WEIGHTS2[k]);
+					}
+				}
+
+				uint8_t indices[16];
+				float error = FindIndices(block, palette, 4, weights, indices);
+				if (error < bestError)
+				{
+					bestError = error;
+					std::memcpy(q0, c0, sizeof(c0));
+					std::memcpy(q1, c1, sizeof(c1));
+					std::memcpy(outIndices, indices, 16);
+				}
+
+				if (bestError == 0.0f)
+				{
+					break;
+				}
+				RefineEndpoints(block, indices, ALPHAS, e0, e1);
+			}
+			return bestError;
+		}
+
+		void EncodeBC7Mode5(const Block& block, BC7Candidate& best)
+		{
+			BC7Candidate candidate;
+			candidate.mode = 5;
+
+			int a0[4];
+			int a1[4];
+			candidate.error = FitMode5Part(block, WEIGHTS_RGB, false, candidate.e0, candidate.e1, candidate.colorIndices);
+			candidate.error += FitMode5Part(block, WEIGHTS_A, true, a0, a1, candidate.alphaIndices);
+			candidate.e0[3] = a0[3];
+			candidate.e1[3] = a1[3];
+
+			if (candidate.error < best.error)
+			{
+				best = candidate;
+			}
+		}
+
+		// The index of texel 0 is stored without its top bit, which the endpoint order has to make zero.
+		// The weight tables are symmetric, swapping the endpoints and mirroring the indices decodes the same.
+		void FixAnchor(int* e0, int* e1, int channelBegin, int channelEnd, uint8_t indices[16], int indexBits)
+		{
+			const int highBit = 1 << (indexBits - 1);
+			if ((indices[0] & highBit) == 0)
+			{
+				return;
+			}
+
+			for (int ch = channelBegin; ch < channelEnd; ch++)
+			{
+				std::swap(e0[ch], e1[ch]);
+			}
+			const int maxIndex = (1 << indexBits) - 1;
+			for (int i = 0; i < 16; i++)
+			{
+				indices[i] = (uint8_t)(maxIndex - indices[i]);
+			}
+		}
+
+		void EncodeBC7(const Block& block, uint8_t* dst)
+		{
+			bool opaque = true;
+			for (int i = 0; i < 16; i++)
+			{
+				opaque = opaque && block.c[3][i] >= 254.5f;
+			}
+
+			BC7Candidate best;
+			EncodeBC7Mode6(block, best);
+			if (opaque == false && best.error > 0.0f)
+			{
+				EncodeBC7Mode5(block, best);
+			}
+
+			BitWriter bits;
+			if (best.mode == 6)
+			{
+				FixAnchor(best.e0, best.e1, 0, 4, best.colorIndices, 4);
+
+				bits.Put(1 << 6, 7);
+				for (int ch = 0; ch < 4; ch++)
+				{
+					bits.Put(best.e0[ch] >> 1, 7);
+					bits.Put(best.e1[ch] >> 1, 7);
+				}
+				bits.Put(best.e0[0] & 1, 1);
+				bits.Put(best.e1[0] & 1, 1);
+				for (int i = 0; i < 16; i++)
+				{
+					bits.Put(best.colorIndices[i], i == 0 ? 3 : 4);
+				}
+			}
+			else
+			{
+				FixAnchor(best.e0, best.e1, 0, 3, best.colorIndices, 2);
+				FixAnchor(best.e0, best.e1, 3, 4, best.alphaIndices, 2);
+
+				bits.Put(1 << 5, 6);
+				bits.Put(0, 2);		// No channel rotation.
+				for (int ch = 0; ch < 3; ch++)
+				{
+					bits.Put(best.e0[ch] >> 1, 7);
+					bits.Put(best.e1[ch] >> 1, 7);
+				}
+				bits.Put(best.e0[3], 8);
+				bits.Put(best.e1[3], 8);
+				for (int i = 0; i < 16; i++)
+				{
+					bits.Put(best.colorIndices[i], i == 0 ? 1 : 2);
+				}
+				for (int i = 0; i < 16; i++)
+				{
+					bits.Put(best.alphaIndices[i], i == 0 ? 1 : 2);
+				}
+			}
+			bits.Store(dst);
+		}
+
+
+		// Reads the 4x4 block at (blockX, blockY) of a level, repeating the edge texels past the level's end.
+		void LoadBlock(const uint8_t* level, uint32_t width, uint32_t height, ImageFormat format, uint32_t blockX, uint32_t blockY, Block& block)
+		{
+			const uint64_t rowPitch = (uint64_t)width * GetImageFormatPixelSize(format);
+			for (uint32_t y = 0; y < 4; y++)
+			{
+				const uint8_t* row = level + std::min(blockY * 4 + y, height - 1) * rowPitch;
+				for (uint32_t x = 0; x < 4; x++)
+				{
+					const uint32_t sx = std::min(blockX * 4 + x, width - 1);
+					const int i = y * 4 + x;
+					switch (format)
+					{
+					case ImageFormat::R8:
+						block.c[0][i] = row[sx];
+						block.c[1][i] = block.c[2][i] = 0.0f;
+						block.c[3][i] = 255.0f;
+						break;
+					case ImageFormat::R16:
+					{
+						uint16_t v;
+						std::memcpy(&v, row + sx * 2, 2);
+						block.c[0][i] = v / 257.0f;
+						block.c[1][i] = block.c[2][i] = 0.0f;
+						block.c[3][i] = 255.0f;
+						break;
+					}
+					case ImageFormat::RGBA8:
+						for (int ch = 0; ch < 4; ch++)
+						{
+							block.c[ch][i] = row[sx * 4 + ch];
+						}
+						break;
+					case ImageFormat::RGBA16:
+						for (int ch = 0; ch < 4; ch++)
+						{
+							uint16_t v;
+							std::memcpy(&v, row + sx * 8 + ch * 2, 2);
+							block.c[ch][i] = v / 257.0f;
+						}
+						break;
+					}
+				}
+			}
+		}
+
+		void EncodeBlock(const Block& block, BlockFormat format, uint8_t* dst)
+		{
+			switch (format)
+			{
+			case BlockFormat::BC1:
+				EncodeBC1(block, dst);
+				break;
+			case BlockFormat::BC4:
+				EncodeBC4(block, 0, dst);
+				break;
+			case BlockFormat::BC5:
+				EncodeBC4(block, 0, dst);
+				EncodeBC4(block, 1, dst + 8);
+				break;
+			case BlockFormat::BC7:
+				EncodeBC7(block, dst);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	uint32_t GetBlockFormatBlockSize(BlockFormat format)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1:
+		case BlockFormat::BC4:
+			return 8;
+		case BlockFormat::BC5:
+		case BlockFormat::BC7:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	uint64_t GetBlockCompressedDdsSize(uint32_t width, uint32_t height, uint32_t mipLevels, BlockFormat format)
+	{
+		uint64_t size = DDS_DATA_OFFSET;
+		for (uint32_t level = 0; level < mipLevels; level++)
+		{
+			size += GetLevelSize(width, height, level, format);
+		}
+		return size;
+	}
+
+	void EncodeBlockCompressedDds(const DecodedImage& image, BlockFormat format, std::vector<uint8_t>& dds, JobSystem* pJobSystem)
+	{
+		if (format == BlockFormat::None || CanBlockCompress(image.width, image.height) == false)
+		{
+			throw std::runtime_error("Can't block compress a " + std::to_string(image.width) + "x" + std::to_string(image.height) + " image");
+		}
+
+		dds.assign(GetBlockCompressedDdsSize(image.width, image.height, image.mipLevels, format), 0);
+
+		DdsHeader header = {};
+		header.size = sizeof(DdsHeader);
+		header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+		header.height = image.height;
+		header.width = image.width;
+		header.pitchOrLinearSize = (uint32_t)GetLevelSize(image.width, image.height, 0, format);
+		header.mipMapCount = image.mipLevels;
+		header.ddspf.size = sizeof(DdsPixelFormat);
+		header.ddspf.flags = DDPF_FOURCC;
+		header.ddspf.fourCC = DDS_FOURCC_DX10;
+		header.caps = DDSCAPS_TEXTURE | (image.mipLevels > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+		DdsHeaderDx10 headerDx10 = {};
+		headerDx10.dxgiFormat = GetDxgiFormat(format, image.srgb && image.format == ImageFormat::RGBA8);
+		headerDx10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+		headerDx10.arraySize = 1;
+		headerDx10.miscFlags2 = format == BlockFormat::BC7 ? DDS_ALPHA_MODE_STRAIGHT : 0;
+
+		std::memcpy(dds.data(), &DDS_MAGIC, sizeof(DDS_MAGIC));
+		std::memcpy(dds.data() + sizeof(DDS_MAGIC), &header, sizeof(header));
+		std::memcpy(dds.data() + sizeof(DDS_MAGIC) + sizeof(header), &headerDx10, sizeof(headerDx10));
+
+		// Rows of blocks of every level, batched into jobs of about BLOCKS_PER_JOB blocks.
+		struct Span
+		{
+			uint32_t level;
+			uint32_t firstRow;
+			uint32_t rowCount;
+			uint64_t srcOffset;
+			uint64_t dstOffset;
+		};
+
+		const uint32_t blockSize = GetBlockFormatBlockSize(format);
+		std::vector<Span> spans;
+		uint64_t dstOffset = DDS_DATA_OFFSET;
+		for (uint32_t level = 0; level < image.mipLevels; level++)
+		{
+			ImageMipLayout layout = GetImageMipLayout(image.width, image.height, image.format, level);
+			const uint32_t blocksX = GetBlockCount(layout.width);
+			const uint32_t blocksY = GetBlockCount(layout.height);
+			const uint32_t rowsPerSpan = std::max(1u, BLOCKS_PER_JOB / blocksX);
+
+			for (uint32_t row = 0; row < blocksY; row += rowsPerSpan)
+			{
+				Span span;
+				span.level = level;
+				span.firstRow = row;
+				span.rowCount = std::min(rowsPerSpan, blocksY - row);
+				span.srcOffset = layout.offset;
+				span.dstOffset = dstOffset + (uint64_t)row * blocksX * blockSize;
+				spans.push_back(span);
+			}
+			dstOffset += (uint64_t)blocksX * blocksY * blockSize;
+		}
+
+		auto encodeSpan = [&](unsigned int i)
+		{
+			const Span& span = spans[i];
+			ImageMipLayout layout = GetImageMipLayout(image.width, image.height, image.format, span.level);
+			const uint32_t blocksX = GetBlockCount(layout.width);
+			const uint8_t* src = image.pixels.data() + span.srcOffset;
+			uint8_t* dst = dds.data() + span.dstOffset;
+
+			Block block;
+			for (uint32_t y = span.firstRow; y < span.firstRow + span.rowCount; y++)
+			{
+				for (uint32_t x = 0; x < blocksX; x++, dst += blockSize)
+				{
+					LoadBlock(src, layout.width, layout.height, image.format, x, y, block);
+					EncodeBlock(block, format, dst);
+				}
+			}
+		};
+
+		if (pJobSystem != nullptr && spans.size() > 1)
+		{
+			pJobSystem->ParallelFor((unsigned int)spans.size(), encodeSpan);
+		}
+		else
+		{
+			for (size_t i = 0; i < spans.size(); i++)
+			{
+				encodeSpan((unsigned int)i);
+			}
+		}
+	}
+}
@@ -0,0 +1,40 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "ImageDecoder.h"
+
+
+namespace Humpback
+{
+	class JobSystem;
+
+
+	enum class BlockFormat : uint32_t
+	{
+		None = 0,
+		BC1,	// RGB, alpha is dropped.
+		BC4,	// R.
+		BC5,	// RG.
+		BC7,	// RGBA.
+	};
+
+	uint32_t GetBlockFormatBlockSize(BlockFormat format);
+
+	// The top level of a block compressed texture must be made of whole 4x4 blocks.
+	inline bool CanBlockCompress(uint32_t width, uint32_t height) { return width % 4 == 0 && height % 4 == 0; }
+
+	// A DDS file with a DX10 header holding every level of a 2D texture.
+	uint64_t GetBlockCompressedDdsSize(uint32_t width, uint32_t height, uint32_t mipLevels, BlockFormat format);
+
+	// Encodes every mip level of image into a DDS file DDSTextureLoader can read. BC1 and BC7 take the sRGB flag
+	// of the image. Blocks are split across the threads of pJobSystem. Throws std::runtime_error if the size
+	// can't be block compressed.
+	void EncodeBlockCompressedDds(const DecodedImage& image, BlockFormat format, std::vector<uint8_t>& dds,
+		JobSystem* pJobSystem = nullptr);
+}
@@ -0,0 +1,295 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "BuddyAllocator.h"
+
+
+namespace Humpback
+{
+	BuddyAllocator::BuddyAllocator(uint64_t size, uint64_t minBlockSize) :
+		m_size(size),
+		m_minBlockSize(minBlockSize)
+	{
+		if (minBlockSize == 0 || (minBlockSize & (minBlockSize - 1)) != 0 ||
+			size < minBlockSize || (size & (size - 1)) != 0)
+		{
+			throw std::runtime_error("BuddyAllocator: sizes must be powers of two.");
+		}
+
+		m_maxOrder = _getOrder(size);
+		m_freeLists.resize(m_maxOrder + 1);
+		m_freeLists[m_maxOrder].insert(0);
+
+		m_allocatedOrders.resize((size_t)(size / minBlockSize), 0);
+	}
+
+	uint64_t BuddyAllocator::Allocate(uint64_t size, uint64_t alignment)
+	{
+		uint64_t blockSize = std::max(std::max(size, alignment), m_minBlockSize);
+		if (size == 0 || blockSize > m_size)
+		{
+			return INVALID_OFFSET;
+		}
+
+		unsigned int order = _getOrder(blockSize);
+
+		unsigned int freeOrder = order;
+		while (freeOrder <= m_maxOrder && m_freeLists[freeOrder].empty())
+		{
+			freeOrder++;
+		}
+
+		if (freeOrder > m_maxOrder)
+		{
+			return INVALID_OFFSET;
+		}
+
+		uint64_t offset = *m_freeLists[freeOrder].begin();
+		m_freeLists[freeOrder].erase(m_freeLists[freeOrder].begin());
+
+		// Split down to the requested order, the upper halves go back to the free lists.
+		while (freeOrder > order)
+		{
+			freeOrder--;
+			m_freeLists[freeOrder].insert(offset + _getBlockSize(freeOrder));
+		}
+
+		m_allocatedOrders[(size_t)(offset / m_minBlockSize)] = (uint8_t)(order + 1);
+		m_usedSize += _getBlockSize(order);
+		m_allocationCount++;
+
+		return offset;
+	}
+
+	void BuddyAllocator::Free(uint64_t offset)
+	{
+		size_t index = (size_t)(offset / m_minBlockSize);
+		if (offset % m_minBlockSize != 0 || index >= m_allocatedOrders.size() || m_allocatedOrders[index] == 0)
+		{
+			throw std::runtime_error("BuddyAllocator: freeing an offset that was not allocated.");
+		}
+
+		unsigned int order = m_allocatedOrders[index] - 1u;
+		m_allocatedOrders[index] = 0;
+		m_usedSize -= _getBlockSize(order);
+		m_allocationCount--;
+
+		// Merge with the buddy for as long as it is free as a whole.
+		while (order < m_maxOrder)
+		{
+			uint64_t buddy = offset ^ _getBlockSize(order);
+			auto it = m_freeLists[order].find(buddy);
+			if (it == m_freeLists[order].end())
+			{
+				break;
+			}
+
+			m_freeLists[order].erase(it);
+			offset = std::min(offset, buddy);
+			order++;
+		}
+
+		m_freeLists[order].insert(offset);
+	}
+
+	uint64_t BuddyAllocator::GetLargestFreeBlock() const
+	{
+		for (int order = (int)m_maxOrder; order >= 0; order--)
+		{
+			if (!m_freeLists[order].empty())
+			{
+				return _getBlockSize(order);
+			}
+		}
+
+		return 0;
+	}
+
+	float BuddyAllocator::GetFragmentation() const
+	{
+		uint64_t freeSize = m_size - m_usedSize;
+		if (freeSize == 0)
+		{
+			return 0.0f;
+		}
+
+		return 1.0f - (float)((double)GetLargestFreeBlock() / (double)freeSize);
+	}
+
+	unsigned int BuddyAllocator::_getOrder(uint64_t blockSize) const
+	{
+		unsigned int order = 0;
+		while (_getBlockSize(order) < blockSize)
+		{
+			order++;
+		}
+
+		return order;
+	}
+
+	BuddyBlockPool::BuddyBlockPool(uint64_t blockSize, uint64_t minBlockSize) :
+		m_blockSize(blockSize),
+		m_minBlockSize(minBlockSize)
+	{
+		if (minBlockSize == 0 || (minBlockSize & (minBlockSize - 1)) != 0 ||
+			blockSize < minBlockSize || (blockSize & (blockSize - 1)) != 0)
+		{
+			throw std::runtime_error("BuddyBlockPool: sizes must be powers of two.");
+		}
+	}
+
+	BuddyBlockPool::Allocation BuddyBlockPool::Allocate(uint64_t size, uint64_t alignment)
+	{
+		Allocation allocation;
+		for (uint32_t i = 0; i < (uint32_t)m_blocks.size(); i++)
+		{
+			Block& block = m_blocks[i];
+			if (block.allocator == nullptr || block.retired)
+			{
+				continue;
+			}
+
+			uint64_t offset = block.allocator->Allocate(size, alignment);
+			if (offset != BuddyAllocator::INVALID_OFFSET)
+			{
+				allocation.block = i;
+				allocation.offset = offset;
+				return allocation;
+			}
+		}
+
+		return allocation;
+	}
+
+	void BuddyBlockPool::Free(const Allocation& allocation)
+	{
+		if (allocation.block >= m_blocks.size() || m_blocks[allocation.block].allocator == nullptr)
+		{
+			throw std::runtime_error("BuddyBlockPool: freeing a range of a block that does not exist.");
+		}
+
+		m_blocks[allocation.block].allocator->Free(allocation.offset);
+	}
+
+	uint32_t BuddyBlockPool::AddBlock()
+	{
+		uint32_t index = 0;
+		while (index < m_blocks.size() && m_blocks[index].allocator != nullptr)
+		{
+			index++;
+		}
+
+		if (index == m_blocks.size())
+		{
+			m_blocks.emplace_back();
+		}
+
+		m_blocks[index].allocator = std::make_unique<BuddyAllocator>(m_blockSize, m_minBlockSize);
+		m_blocks[index].retired = false;
+		return index;
+	}
+
+	std::vector<uint32_t> BuddyBlockPool::RetireBlocks(float maxBlockUsage)
+	{
+		std::vector<uint32_t> candidates;
+		unsigned int openCount = 0;
+		for (uint32_t i = 0; i < (uint32_t)m_blocks.size(); i++)
+		{
+			const Block& block = m_blocks[i];
+			if (block.allocator == nullptr || block.retired)
+			{
+				continue;
+			}
+
+			openCount++;
+			if (block.allocator->IsEmpty() == false &&
+				(float)block.allocator->GetUsedSize() / (float)block.allocator->GetSize() < maxBlockUsage)
+			{
+				candidates.push_back(i);
+			}
+		}
+
+		std::stable_sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+			{
+				return m_blocks[a].allocator->GetUsedSize() < m_blocks[b].allocator->GetUsedSize();
+			});
+
+		// Moving everything out of every block would only fill new ones.
+		if (candidates.empty() == false && candidates.size() == openCount)
+		{
+			candidates.pop_back();
+		}
+
+		for (uint32_t block : candidates)
+		{
+			m_blocks[block].retired = true;
+		}
+
+		return candidates;
+	}
+
+	void BuddyBlockPool::FreeAfterCopy(const Allocation& allocation)
+	{
+		if (allocation.block >= m_blocks.size() || m_blocks[allocation.block].retired == false)
+		{
+			throw std::runtime_error("BuddyBlockPool: only ranges of retired blocks are moved.");
+		}
+
+		MovedRange range;
+		range.allocation = allocation;
+		m_movedRanges.push_back(range);
+	}
+
+	void BuddyBlockPool::FinishSubmission(uint64_t fenceValue)
+	{
+		for (MovedRange& range : m_movedRanges)
+		{
+			if (range.fenceValue == 0)
+			{
+				range.fenceValue = fenceValue;
+			}
+		}
+	}
+
+	std::vector<uint32_t> BuddyBlockPool::ReleaseCompleted(uint64_t completedFenceValue)
+	{
+		std::vector<uint8_t> waiting(m_blocks.size(), 0);
+		size_t keptCount = 0;
+		for (const MovedRange& range : m_movedRanges)
+		{
+			if (range.fenceValue != 0 && range.fenceValue <= completedFenceValue)
+			{
+				m_blocks[range.allocation.block].allocator->Free(range.allocation.offset);
+			}
+			else
+			{
+				waiting[range.allocation.block] = 1;
+				m_movedRanges[keptCount++] = range;
+			}
+		}
+		m_movedRanges.resize(keptCount);
+
+		std::vector<uint32_t> released;
+		for (uint32_t i = 0; i < (uint32_t)m_blocks.size(); i++)
+		{
+			Block& block = m_blocks[i];
+			if (block.retired == false || waiting[i])
+			{
+				continue;
+			}
+
+			block.retired = false;
+			if (block.allocator->IsEmpty())
+			{
+				block.allocator.reset();
+				released.push_back(i);
+			}
+		}
+
+		return released;
+	}
+}
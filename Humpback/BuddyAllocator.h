@@ -0,0 +1,140 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <set>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+
+namespace Humpback
+{
+	// Binary buddy allocator over an abstract address range. Blocks are powers of two
+	// starting at minBlockSize, so every block is aligned to its own size. It only hands
+	// out offsets, GpuMemoryAllocator maps them onto ID3D12Heap ranges.
+	class BuddyAllocator
+	{
+	public:
+
+		static const uint64_t INVALID_OFFSET = UINT64_MAX;
+
+		// size and minBlockSize must be powers of two, size >= minBlockSize.
+		BuddyAllocator(uint64_t size, uint64_t minBlockSize);
+
+		BuddyAllocator(const BuddyAllocator&) = delete;
+		BuddyAllocator& operator=(const BuddyAllocator&) = delete;
+
+		// Returns INVALID_OFFSET when no free block is large enough.
+		uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+		void Free(uint64_t offset);
+
+		uint64_t GetSize() const { return m_size; }
+		// Bytes held by allocated blocks, including the rounding up to a power of two.
+		uint64_t GetUsedSize() const { return m_usedSize; }
+		unsigned int GetAllocationCount() const { return m_allocationCount; }
+		bool IsEmpty() const { return m_allocationCount == 0; }
+
+		uint64_t GetLargestFreeBlock() const;
+
+		// 0 when all free space is one block, approaching 1 as it splinters into small blocks.
+		float GetFragmentation() const;
+
+	private:
+
+		unsigned int _getOrder(uint64_t blockSize) const;
+		uint64_t _getBlockSize(unsigned int order) const { return m_minBlockSize << order; }
+
+		uint64_t m_size;
+		uint64_t m_minBlockSize;
+		unsigned int m_maxOrder = 0;
+
+		// Free block offsets per order, ordered so the lowest address is reused first.
+		std::vector<std::set<uint64_t>> m_freeLists;
+
+		// Order + 1 of the allocated block starting at each min block, 0 if none starts there.
+		std::vector<uint8_t> m_allocatedOrders;
+
+		uint64_t m_usedSize = 0;
+		unsigned int m_allocationCount = 0;
+	};
+
+
+	// Equally sized BuddyAllocator blocks filled first block first, with the bookkeeping for defragmenting
+	// them. It only deals in block indices and offsets, GpuMemoryAllocator backs every block with an ID3D12Heap.
+	//
+	// Defragmenting retires the blocks used least: they take no new allocations while the owner copies their
+	// ranges into the other blocks. A moved range stays allocated until the fence of the submission reading
+	// it completed, then a retired block left empty is released.
+	class BuddyBlockPool
+	{
+	public:
+
+		static const uint32_t INVALID_BLOCK = UINT32_MAX;
+
+		struct Allocation
+		{
+			uint32_t block = INVALID_BLOCK;
+			uint64_t offset = BuddyAllocator::INVALID_OFFSET;
+		};
+
+		// blockSize and minBlockSize as for BuddyAllocator.
+		BuddyBlockPool(uint64_t blockSize, uint64_t minBlockSize);
+
+		BuddyBlockPool(const BuddyBlockPool&) = delete;
+		BuddyBlockPool& operator=(const BuddyBlockPool&) = delete;
+
+		// Tries the blocks that aren't retired in order. Returns an invalid block when none has room, the owner
+		// then creates the memory for a new block and calls AddBlock.
+		Allocation Allocate(uint64_t size, uint64_t alignment = 1);
+		void Free(const Allocation& allocation);
+
+		// Reuses the index of a released block if there is one.
+		uint32_t AddBlock();
+
+		// Retires the blocks holding allocations that are used less than maxBlockUsage, least used first.
+		// The most used block stays open when every block qualifies. Returns the retired blocks.
+		std::vector<uint32_t> RetireBlocks(float maxBlockUsage);
+
+		// The range was copied to a new allocation, it is freed once the submission with the copy completed.
+		void FreeAfterCopy(const Allocation& allocation);
+
+		// Call after the copies were submitted and fenceValue was signaled.
+		void FinishSubmission(uint64_t fenceValue);
+
+		// Frees the moved ranges whose copies completed. Retired blocks left empty are released and returned,
+		// the owner destroys their memory. Retired blocks still holding ranges the owner didn't move take
+		// allocations again once all their copies completed.
+		std::vector<uint32_t> ReleaseCompleted(uint64_t completedFenceValue);
+
+		// Number of block indices, released ones included.
+		uint32_t GetBlockCount() const { return (uint32_t)m_blocks.size(); }
+
+		// Null for a released block.
+		const BuddyAllocator* GetBlock(uint32_t block) const { return m_blocks[block].allocator.get(); }
+		bool IsRetired(uint32_t block) const { return m_blocks[block].retired; }
+
+	private:
+
+		struct Block
+		{
+			std::unique_ptr<BuddyAllocator> allocator;
+			bool retired = false;
+		};
+
+		// A fence value of 0 marks a copy that wasn't submitted yet.
+		struct MovedRange
+		{
+			Allocation allocation;
+			uint64_t fenceValue = 0;
+		};
+
+		uint64_t m_blockSize;
+		uint64_t m_minBlockSize;
+
+		std::vector<Block> m_blocks;
+		std::vector<MovedRange> m_movedRanges;
+	};
+}
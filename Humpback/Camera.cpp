@@ -63,9 +63,9 @@ namespace Humpback
 		return XMLoadFloat4x4(&m_projectionMatrix);
 	}
 
-	DirectX::BoundingFrustum& Camera::GetFrustum()
+	FrustumPlanes Camera::GetFrustum()
 	{
-		return m_frustum;
+		return FrustumPlanes::FromViewProj(XMMatrixMultiply(GetViewMatrix(), GetProjectionMatrix()));
 	}
 
 	void Camera::SetPosition(float x, float y, float z)
@@ -176,7 +176,5 @@ namespace Humpback
 	{
 		XMMATRIX p = XMMatrixPerspectiveFovLH(m_fovY, m_aspect, m_near, m_far);
 		XMStoreFloat4x4(&m_projectionMatrix, p);
-
-		BoundingFrustum::CreateFromMatrix(m_frustum, p);
 	}
 }
\ No newline at end of file
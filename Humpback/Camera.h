@@ -7,6 +7,7 @@
 #include <DirectXCollision.h>
 
 #include "HMathHelper.h"
+#include "FrustumCuller.h"
 
 namespace Humpback
 {
@@ -31,7 +32,8 @@ namespace Humpback
 		DirectX::XMMATRIX GetViewMatrix();
 		DirectX::XMMATRIX GetProjectionMatrix();
 
-		DirectX::BoundingFrustum& GetFrustum();
+		// World space planes for the culling queries, from the current view and projection.
+		FrustumPlanes GetFrustum();
 
 		void SetPosition(float x, float y, float z);
 		void SetPosition(DirectX::XMVECTOR pos);
@@ -65,7 +67,5 @@ namespace Humpback
 		DirectX::XMFLOAT4X4 m_projectionMatrix = HMathHelper::Identity4x4();
 
 		DirectX::XMFLOAT3 m_up = { 0.0f, 1.0f, 0.0f};
-
-		DirectX::BoundingFrustum m_frustum;
 	};
 }
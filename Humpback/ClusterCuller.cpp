@@ -0,0 +1,179 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cmath>
+#include <algorithm>
+
+#include "ClusterCuller.h"
+
+
+using namespace DirectX;
+
+
+namespace Humpback
+{
+	namespace
+	{
+		// The rasterizer snaps vertices to 1/256 of a pixel, a triangle may reach that much further than
+		// its float coordinates.
+		const float SNAP_MARGIN = 1.0f / 256.0f;
+
+		float Dot3(const float* a, const float* b)
+		{
+			return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+		}
+
+		// Range of tan(angle) in one view plane covered by a sphere at (x, z) in front of the eye,
+		// the tangent lines from the origin (Mara and McGuire 2013).
+		void ProjectSphereAxis(float x, float z, float radius, float& minTan, float& maxTan)
+		{
+			float t = sqrtf(x * x + z * z - radius * radius);
+			minTan = (x * t - radius * z) / (z * t + x * radius);
+			maxTan = (x * t + radius * z) / (z * t - x * radius);
+		}
+
+		// True when [minPixel, maxPixel] holds no pixel center i + 0.5.
+		bool MissesPixelCenters(float minPixel, float maxPixel)
+		{
+			return floorf(maxPixel + SNAP_MARGIN - 0.5f) < ceilf(minPixel - SNAP_MARGIN - 0.5f);
+		}
+	}
+
+	ClusterCullingStats& ClusterCullingStats::operator+=(const ClusterCullingStats& rhs)
+	{
+		testedCount += rhs.testedCount;
+		visibleCount += rhs.visibleCount;
+		frustumCulledCount += rhs.frustumCulledCount;
+		backfaceCulledCount += rhs.backfaceCulledCount;
+		smallCulledCount += rhs.smallCulledCount;
+		testedTriangles += rhs.testedTriangles;
+		visibleTriangles += rhs.visibleTriangles;
+		rangeCount += rhs.rangeCount;
+		return *this;
+	}
+
+	unsigned int CullMeshlets(const ClusterCullingView& view, const Meshlet* meshlets, unsigned int meshletCount,
+		FXMMATRIX world, std::vector<IndexRange>& ranges, ClusterCullingStats* pStats)
+	{
+		// The meshlet bounds stay in object space, the view is brought there instead. Plane sides are kept
+		// by any affine map, so the frustum and cone tests are exact even under non-uniform scale.
+		XMMATRIX worldT = XMMatrixTranspose(world);
+		float planes[6][4];
+		for (int p = 0; p < 6; p++)
+		{
+			// p_world = p_object * world, so the object space plane is world * plane.
+			XMVECTOR plane = XMVector4Transform(XMLoadFloat4(&view.frustum.planes[p]), worldT);
+			XMVECTOR length = XMVector3Length(plane);
+			XMStoreFloat4((XMFLOAT4*)planes[p], XMVectorDivide(plane, length));
+		}
+
+		XMVECTOR determinant;
+		XMMATRIX invWorld = XMMatrixInverse(&determinant, world);
+
+		// Mirroring flips the winding the rasterizer sees, the cones would then pick the front faces.
+		bool backfaceCulling = view.backfaceCulling && XMVectorGetX(determinant) > 0.0f;
+		float camera[3];
+		XMStoreFloat3((XMFLOAT3*)camera, XMVector3TransformCoord(XMLoadFloat3(&view.cameraPosition), invWorld));
+
+		// The view is rigid, so the largest axis scale of world bounds the radius in view space.
+		XMFLOAT4X4 worldView;
+		XMStoreFloat4x4(&worldView, XMMatrixMultiply(world, XMLoadFloat4x4(&view.view)));
+		float radiusScale = std::max(std::max(
+			XMVectorGetX(XMVector3Length(world.r[0])),
+			XMVectorGetX(XMVector3Length(world.r[1]))),
+			XMVectorGetX(XMVector3Length(world.r[2])));
+
+		bool smallTriangleCulling = view.smallTriangleCulling && view.viewportWidth > 0.0f && view.viewportHeight > 0.0f;
+		float halfWidth = 0.5f * view.viewportWidth;
+		float halfHeight = 0.5f * view.viewportHeight;
+
+		ClusterCullingStats stats;
+		unsigned int firstRange = (unsigned int)ranges.size();
+		for (unsigned int i = 0; i < meshletCount; i++)
+		{
+			const Meshlet& meshlet = meshlets[i];
+			const float* c = meshlet.center;
+			float r = meshlet.radius;
+
+			stats.testedCount++;
+			stats.testedTriangles += meshlet.indexCount / 3;
+
+			bool outside = false;
+			for (int p = 0; p < 6 && outside == false; p++)
+			{
+				outside = Dot3(planes[p], c) + planes[p][3] < -r;
+			}
+			if (outside)
+			{
+				stats.frustumCulledCount++;
+				continue;
+			}
+
+			// The apex is behind every triangle plane, so a camera that sees the whole cone from behind it,
+			// within 90 degrees minus the half angle of the axis, is behind every triangle as well.
+			if (backfaceCulling && meshlet.coneCutoff < 1.0f)
+			{
+				float fromCamera[3] = { meshlet.coneApex[0] - camera[0], meshlet.coneApex[1] - camera[1], meshlet.coneApex[2] - camera[2] };
+				if (Dot3(fromCamera, meshlet.coneAxis) >= meshlet.coneCutoff * sqrtf(Dot3(fromCamera, fromCamera)))
+				{
+					stats.backfaceCulledCount++;
+					continue;
+				}
+			}
+
+			if (smallTriangleCulling)
+			{
+				float x = c[0] * worldView._11 + c[1] * worldView._21 + c[2] * worldView._31 + worldView._41;
+				float y = c[0] * worldView._12 + c[1] * worldView._22 + c[2] * worldView._32 + worldView._42;
+				float z = c[0] * worldView._13 + c[1] * worldView._23 + c[2] * worldView._33 + worldView._43;
+				float viewRadius = r * radiusScale;
+
+				// Spheres reaching the near plane project unbounded, they are kept.
+				if (z - viewRadius > view.nearZ)
+				{
+					float minX, maxX, minY, maxY;
+					ProjectSphereAxis(x, z, viewRadius, minX, maxX);
+					ProjectSphereAxis(y, z, viewRadius, minY, maxY);
+
+					// NDC to pixels, y points down on screen which swaps the ends.
+					float left = (1.0f + minX * view.projScaleX) * halfWidth;
+					float right = (1.0f + maxX * view.projScaleX) * halfWidth;
+					float top = (1.0f - maxY * view.projScaleY) * halfHeight;
+					float bottom = (1.0f - minY * view.projScaleY) * halfHeight;
+
+					if (MissesPixelCenters(left, right) || MissesPixelCenters(top, bottom))
+					{
+						stats.smallCulledCount++;
+						continue;
+					}
+				}
+			}
+
+			stats.visibleCount++;
+			stats.visibleTriangles += meshlet.indexCount / 3;
+
+			if (ranges.size() > firstRange &&
+				ranges.back().startIndexLocation + ranges.back().indexCount == meshlet.startIndexLocation)
+			{
+				ranges.back().indexCount += meshlet.indexCount;
+			}
+			else
+			{
+				IndexRange range;
+				range.startIndexLocation = meshlet.startIndexLocation;
+				range.indexCount = meshlet.indexCount;
+				ranges.push_back(range);
+			}
+		}
+
+		unsigned int rangeCount = (unsigned int)ranges.size() - firstRange;
+		stats.rangeCount = rangeCount;
+		if (pStats != nullptr)
+		{
+			*pStats += stats;
+		}
+
+		return rangeCount;
+	}
+}
@@ -0,0 +1,69 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <DirectXMath.h>
+
+#include "Meshlet.h"
+#include "FrustumCuller.h"
+
+
+namespace Humpback
+{
+	// A run of the index buffer to draw, consecutive visible meshlets share one.
+	struct IndexRange
+	{
+		uint32_t startIndexLocation = 0;
+		uint32_t indexCount = 0;
+		// Added to the baseVertexLocation of the draw, set by the caller for ranges of an IndexBatch.
+		int32_t vertexOffset = 0;
+	};
+
+	// What the clusters are tested against, all in world space.
+	struct ClusterCullingView
+	{
+		FrustumPlanes frustum;
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT3 cameraPosition;
+
+		// _11 and _22 of the perspective projection.
+		float projScaleX = 1.0f;
+		float projScaleY = 1.0f;
+		float nearZ = 0.0f;
+
+		float viewportWidth = 0.0f;
+		float viewportHeight = 0.0f;
+
+		// Only valid when the pass culls back faces.
+		bool backfaceCulling = true;
+		// Only valid without MSAA, the test assumes a single sample at the pixel center.
+		bool smallTriangleCulling = true;
+	};
+
+	struct ClusterCullingStats
+	{
+		unsigned int testedCount = 0;
+		unsigned int visibleCount = 0;
+		unsigned int frustumCulledCount = 0;
+		unsigned int backfaceCulledCount = 0;
+		unsigned int smallCulledCount = 0;
+
+		uint64_t testedTriangles = 0;
+		uint64_t visibleTriangles = 0;
+		unsigned int rangeCount = 0;
+
+		ClusterCullingStats& operator+=(const ClusterCullingStats& rhs);
+	};
+
+
+	// Tests the meshlets of an object placed by world and appends the index ranges of the visible ones.
+	// A meshlet is culled when its sphere is outside the frustum, when the camera is behind every triangle
+	// plane of its normal cone, or when its projected sphere covers no pixel center. Returns the number of
+	// ranges appended, 0 when nothing is visible.
+	unsigned int CullMeshlets(const ClusterCullingView& view, const Meshlet* meshlets, unsigned int meshletCount,
+		DirectX::FXMMATRIX world, std::vector<IndexRange>& ranges, ClusterCullingStats* pStats = nullptr);
+}
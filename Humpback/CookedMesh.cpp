@@ -0,0 +1,274 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cstring>
+
+#include "CookedMesh.h"
+
+
+namespace Humpback
+{
+	namespace
+	{
+		uint64_t AlignUp(uint64_t value, uint64_t alignment)
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+
+		bool InRange(uint64_t offset, uint64_t byteSize, uint64_t fileSize)
+		{
+			return offset <= fileSize && byteSize <= fileSize - offset;
+		}
+	}
+
+	std::vector<uint8_t> BuildCookedMesh(const std::vector<CookedMeshSource>& meshes, const std::vector<CookedNode>& nodes)
+	{
+		const uint64_t recordOffset = sizeof(CookedMeshHeader);
+		const uint64_t nodeOffset = recordOffset + meshes.size() * sizeof(CookedMeshRecord);
+		uint64_t size = nodeOffset + nodes.size() * sizeof(CookedNode);
+
+		// Lay the file out first so the bytes can be written in place without growing the buffer.
+		std::vector<CookedMeshRecord> records(meshes.size());
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			const CookedMeshSource& src = meshes[i];
+			CookedMeshRecord& record = records[i];
+
+			record = {};
+			record.vertexCount = src.vertexCount;
+			record.vertexStride = src.vertexStride;
+			record.indexCount = src.indexCount;
+			record.indexStride = src.indexStride;
+			record.subMeshCount = (uint32_t)src.subMeshes.size();
+			record.meshletCount = (uint32_t)src.meshlets.size();
+			record.batchCount = (uint32_t)src.batches.size();
+			record.node = src.node;
+
+			record.subMeshOffset = AlignUp(size, alignof(CookedSubMesh));
+			size = record.subMeshOffset + src.subMeshes.size() * sizeof(CookedSubMesh);
+
+			record.meshletOffset = AlignUp(size, CookedMeshFormat::BLOB_ALIGNMENT);
+			size = record.meshletOffset + src.meshlets.size() * sizeof(Meshlet);
+
+			record.batchOffset = AlignUp(size, alignof(IndexBatch));
+			size = record.batchOffset + src.batches.size() * sizeof(IndexBatch);
+
+			record.vertexOffset = AlignUp(size, CookedMeshFormat::BLOB_ALIGNMENT);
+			size = record.vertexOffset + (uint64_t)src.vertexCount * src.vertexStride;
+
+			record.indexOffset = AlignUp(size, CookedMeshFormat::BLOB_ALIGNMENT);
+			size = record.indexOffset + (uint64_t)src.indexCount * src.indexStride;
+
+			record.positionOffset = AlignUp(size, CookedMeshFormat::BLOB_ALIGNMENT);
+			size = record.positionOffset + (uint64_t)src.vertexCount * 3 * sizeof(float);
+		}
+
+		std::vector<uint8_t> bytes(size, 0);
+
+		CookedMeshHeader header = {};
+		header.magic = CookedMeshFormat::MAGIC;
+		header.version = CookedMeshFormat::VERSION;
+		header.meshCount = (uint32_t)meshes.size();
+		header.nodeCount = (uint32_t)nodes.size();
+		header.fileSize = size;
+		std::memcpy(bytes.data(), &header, sizeof(header));
+
+		if (records.empty() == false)
+		{
+			std::memcpy(bytes.data() + recordOffset, records.data(), records.size() * sizeof(CookedMeshRecord));
+		}
+		if (nodes.empty() == false)
+		{
+			std::memcpy(bytes.data() + nodeOffset, nodes.data(), nodes.size() * sizeof(CookedNode));
+		}
+
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			const CookedMeshSource& src = meshes[i];
+			const CookedMeshRecord& record = records[i];
+
+			if (src.subMeshes.empty() == false)
+			{
+				std::memcpy(bytes.data() + record.subMeshOffset, src.subMeshes.data(), src.subMeshes.size() * sizeof(CookedSubMesh));
+			}
+			if (src.meshlets.empty() == false)
+			{
+				std::memcpy(bytes.data() + record.meshletOffset, src.meshlets.data(), src.meshlets.size() * sizeof(Meshlet));
+			}
+			if (src.batches.empty() == false)
+			{
+				std::memcpy(bytes.data() + record.batchOffset, src.batches.data(), src.batches.size() * sizeof(IndexBatch));
+			}
+			if (src.vertexCount > 0)
+			{
+				std::memcpy(bytes.data() + record.vertexOffset, src.vertices, (size_t)src.vertexCount * src.vertexStride);
+				std::memcpy(bytes.data() + record.positionOffset, src.positions, (size_t)src.vertexCount * 3 * sizeof(float));
+			}
+			if (src.indexCount > 0)
+			{
+				std::memcpy(bytes.data() + record.indexOffset, src.indices, (size_t)src.indexCount * src.indexStride);
+			}
+		}
+
+		return bytes;
+	}
+
+	bool CookedMeshFile::Open(const std::string& path)
+	{
+		if (m_file.Open(path) == false)
+		{
+			return false;
+		}
+
+		m_data = m_file.GetData();
+		m_size = m_file.GetSize();
+		return _validate();
+	}
+
+	bool CookedMeshFile::Open(const uint8_t* data, uint64_t size)
+	{
+		m_file.Close();
+
+		m_data = data;
+		m_size = size;
+		return _validate();
+	}
+
+	CookedMeshView CookedMeshFile::GetMesh(uint32_t index) const
+	{
+		CookedMeshView view;
+		if (index >= m_meshCount)
+		{
+			return view;
+		}
+
+		CookedMeshRecord record;
+		std::memcpy(&record, m_data + sizeof(CookedMeshHeader) + index * sizeof(CookedMeshRecord), sizeof(record));
+
+		view.vertices = m_data + record.vertexOffset;
+		view.vertexCount = record.vertexCount;
+		view.vertexStride = record.vertexStride;
+		view.vertexByteSize = (uint64_t)record.vertexCount * record.vertexStride;
+
+		view.indices = m_data + record.indexOffset;
+		view.indexCount = record.indexCount;
+		view.indexStride = record.indexStride;
+		view.indexByteSize = (uint64_t)record.indexCount * record.indexStride;
+
+		view.positions = m_data + record.positionOffset;
+		view.positionByteSize = (uint64_t)record.vertexCount * 3 * sizeof(float);
+
+		view.subMeshes = (const CookedSubMesh*)(m_data + record.subMeshOffset);
+		view.subMeshCount = record.subMeshCount;
+
+		view.meshlets = (const Meshlet*)(m_data + record.meshletOffset);
+		view.meshletCount = record.meshletCount;
+
+		view.batches = (const IndexBatch*)(m_data + record.batchOffset);
+		view.batchCount = record.batchCount;
+
+		view.node = record.node;
+
+		return view;
+	}
+
+	CookedNode CookedMeshFile::GetNode(uint32_t index) const
+	{
+		CookedNode node = {};
+		if (index >= m_nodeCount)
+		{
+			node.parent = CookedMeshFormat::NO_NODE;
+			return node;
+		}
+
+		std::memcpy(&node, m_data + sizeof(CookedMeshHeader) + m_meshCount * sizeof(CookedMeshRecord) + index * sizeof(CookedNode), sizeof(node));
+		return node;
+	}
+
+	bool CookedMeshFile::_validate()
+	{
+		m_meshCount = 0;
+		m_nodeCount = 0;
+
+		if (m_data == nullptr || m_size < sizeof(CookedMeshHeader))
+		{
+			return false;
+		}
+
+		CookedMeshHeader header;
+		std::memcpy(&header, m_data, sizeof(header));
+		if (header.magic != CookedMeshFormat::MAGIC || header.version != CookedMeshFormat::VERSION ||
+			header.fileSize != m_size)
+		{
+			return false;
+		}
+
+		const uint64_t nodeOffset = sizeof(CookedMeshHeader) + (uint64_t)header.meshCount * sizeof(CookedMeshRecord);
+		if (InRange(sizeof(CookedMeshHeader), (uint64_t)header.meshCount * sizeof(CookedMeshRecord), m_size) == false ||
+			InRange(nodeOffset, (uint64_t)header.nodeCount * sizeof(CookedNode), m_size) == false)
+		{
+			return false;
+		}
+
+		// Parents first, the transform hierarchy is built in one pass over the nodes.
+		for (uint32_t i = 0; i < header.nodeCount; i++)
+		{
+			CookedNode node;
+			std::memcpy(&node, m_data + nodeOffset + i * sizeof(CookedNode), sizeof(node));
+			if (node.parent != CookedMeshFormat::NO_NODE && node.parent >= i)
+			{
+				return false;
+			}
+		}
+
+		for (uint32_t i = 0; i < header.meshCount; i++)
+		{
+			CookedMeshRecord record;
+			std::memcpy(&record, m_data + sizeof(CookedMeshHeader) + i * sizeof(CookedMeshRecord), sizeof(record));
+
+			if ((record.indexStride != 2 && record.indexStride != 4) ||
+				record.subMeshOffset % alignof(CookedSubMesh) != 0 ||
+				InRange(record.subMeshOffset, (uint64_t)record.subMeshCount * sizeof(CookedSubMesh), m_size) == false ||
+				record.meshletOffset % alignof(Meshlet) != 0 ||
+				InRange(record.meshletOffset, (uint64_t)record.meshletCount * sizeof(Meshlet), m_size) == false ||
+				record.batchOffset % alignof(IndexBatch) != 0 ||
+				InRange(record.batchOffset, (uint64_t)record.batchCount * sizeof(IndexBatch), m_size) == false ||
+				(record.batchCount > 0 && record.indexStride != 2) ||
+				(record.node != CookedMeshFormat::NO_NODE && record.node >= header.nodeCount) ||
+				InRange(record.vertexOffset, (uint64_t)record.vertexCount * record.vertexStride, m_size) == false ||
+				InRange(record.indexOffset, (uint64_t)record.indexCount * record.indexStride, m_size) == false ||
+				InRange(record.positionOffset, (uint64_t)record.vertexCount * 3 * sizeof(float), m_size) == false)
+			{
+				return false;
+			}
+
+			// The culler walks the meshlets and the batches of a submesh on the CPU.
+			for (uint32_t j = 0; j < record.subMeshCount; j++)
+			{
+				CookedSubMesh subMesh;
+				std::memcpy(&subMesh, m_data + record.subMeshOffset + j * sizeof(CookedSubMesh), sizeof(subMesh));
+				if ((uint64_t)subMesh.firstMeshlet + subMesh.meshletCount > record.meshletCount ||
+					(uint64_t)subMesh.firstBatch + subMesh.batchCount > record.batchCount)
+				{
+					return false;
+				}
+
+				for (uint32_t k = 0; k < subMesh.batchCount; k++)
+				{
+					IndexBatch batch;
+					std::memcpy(&batch, m_data + record.batchOffset + (subMesh.firstBatch + k) * sizeof(IndexBatch), sizeof(batch));
+					if ((uint64_t)batch.startIndexLocation + batch.indexCount > record.indexCount ||
+						(uint64_t)batch.firstMeshlet + batch.meshletCount > subMesh.meshletCount)
+					{
+						return false;
+					}
+				}
+			}
+		}
+
+		m_meshCount = header.meshCount;
+		m_nodeCount = header.nodeCount;
+		return true;
+	}
+}
@@ -0,0 +1,173 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "MappedFile.h"
+#include "Meshlet.h"
+#include "IndexPacking.h"
+
+
+namespace Humpback
+{
+	// Layout of a cooked mesh file. Everything is little endian and stored exactly as the GPU consumes it:
+	//
+	//   CookedMeshHeader
+	//   CookedMeshRecord[meshCount]
+	//   CookedNode[nodeCount]
+	//   per mesh: CookedSubMesh[subMeshCount], Meshlet[meshletCount], IndexBatch[batchCount], vertices, indices, positions
+	//   (each blob BLOB_ALIGNMENT aligned)
+	//
+	// VERSION is part of the asset cache key, bump it whenever the layout changes.
+	namespace CookedMeshFormat
+	{
+		static const uint32_t MAGIC = 0x534D4248;	// "HBMS"
+		static const uint32_t VERSION = 4;
+		static const uint64_t BLOB_ALIGNMENT = 256;
+		// Parent of a root node, node of a mesh that isn't placed by the node tree.
+		static const uint32_t NO_NODE = UINT32_MAX;
+	}
+
+	struct CookedMeshHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t meshCount;
+		uint32_t nodeCount;
+		uint64_t fileSize;
+	};
+
+	// Node of the source scene, parents come before their children.
+	struct CookedNode
+	{
+		// Row vectors, relative to the parent.
+		float localTransform[16];
+		uint32_t parent;
+		uint32_t pad;
+	};
+
+	struct CookedSubMesh
+	{
+		char name[32];
+		uint32_t indexCount;
+		uint32_t startIndexLocation;
+		int32_t baseVertexLocation;
+		float aabbCenter[3];
+		float aabbExtents[3];
+		uint32_t firstMeshlet;
+		uint32_t meshletCount;
+		uint32_t firstBatch;
+		uint32_t batchCount;
+	};
+
+	struct CookedMeshRecord
+	{
+		uint32_t vertexCount;
+		uint32_t vertexStride;
+		uint32_t indexCount;
+		uint32_t indexStride;
+		uint32_t subMeshCount;
+		uint32_t meshletCount;
+		uint32_t batchCount;
+		uint32_t node;
+		uint64_t subMeshOffset;
+		uint64_t meshletOffset;
+		uint64_t batchOffset;
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+		uint64_t positionOffset;
+	};
+
+	static_assert(sizeof(CookedMeshHeader) == 24, "CookedMeshHeader layout changed, bump VERSION.");
+	static_assert(sizeof(CookedNode) == 72, "CookedNode layout changed, bump VERSION.");
+	static_assert(sizeof(CookedSubMesh) == 84, "CookedSubMesh layout changed, bump VERSION.");
+	static_assert(sizeof(CookedMeshRecord) == 80, "CookedMeshRecord layout changed, bump VERSION.");
+
+
+	// Input of the cooker, the pointers only need to live until BuildCookedMesh returns.
+	struct CookedMeshSource
+	{
+		const void* vertices = nullptr;
+		uint32_t vertexCount = 0;
+		uint32_t vertexStride = 0;
+
+		const void* indices = nullptr;
+		uint32_t indexCount = 0;
+		uint32_t indexStride = 4;
+
+		// Tightly packed float3 positions, one per vertex.
+		const void* positions = nullptr;
+
+		std::vector<CookedSubMesh> subMeshes;
+		// Indexed by the firstMeshlet and meshletCount of the submeshes.
+		std::vector<Meshlet> meshlets;
+		// Indexed by the firstBatch and batchCount of the submeshes, only 16 bit buffers have any.
+		std::vector<IndexBatch> batches;
+
+		// The node placing the mesh, an index into the nodes passed to BuildCookedMesh.
+		uint32_t node = CookedMeshFormat::NO_NODE;
+	};
+
+	// Pointers into the cooked bytes, valid while the CookedMeshFile is open.
+	struct CookedMeshView
+	{
+		const void* vertices = nullptr;
+		uint64_t vertexByteSize = 0;
+		uint32_t vertexCount = 0;
+		uint32_t vertexStride = 0;
+
+		const void* indices = nullptr;
+		uint64_t indexByteSize = 0;
+		uint32_t indexCount = 0;
+		uint32_t indexStride = 0;
+
+		const void* positions = nullptr;
+		uint64_t positionByteSize = 0;
+
+		const CookedSubMesh* subMeshes = nullptr;
+		uint32_t subMeshCount = 0;
+
+		const Meshlet* meshlets = nullptr;
+		uint32_t meshletCount = 0;
+
+		const IndexBatch* batches = nullptr;
+		uint32_t batchCount = 0;
+
+		uint32_t node = CookedMeshFormat::NO_NODE;
+	};
+
+
+	std::vector<uint8_t> BuildCookedMesh(const std::vector<CookedMeshSource>& meshes, const std::vector<CookedNode>& nodes);
+
+
+	// Validates and reads a cooked mesh either from a memory mapped file or from bytes in memory.
+	// Nothing is copied, the views point into the mapping.
+	class CookedMeshFile
+	{
+	public:
+
+		bool Open(const std::string& path);
+		// The bytes must outlive the CookedMeshFile.
+		bool Open(const uint8_t* data, uint64_t size);
+
+		uint32_t GetMeshCount() const { return m_meshCount; }
+		CookedMeshView GetMesh(uint32_t index) const;
+		uint32_t GetNodeCount() const { return m_nodeCount; }
+		CookedNode GetNode(uint32_t index) const;
+
+	private:
+
+		bool _validate();
+
+		MappedFile m_file;
+		const uint8_t* m_data = nullptr;
+		uint64_t m_size = 0;
+		uint32_t m_meshCount = 0;
+		uint32_t m_nodeCount = 0;
+	};
+}
@@ -0,0 +1,78 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "CpuFeatures.h"
+
+
+namespace Humpback
+{
+	namespace
+	{
+		CpuFeatures DetectCpuFeatures()
+		{
+			CpuFeatures features;
+
+#if defined(_MSC_VER)
+			int info[4] = {};
+			__cpuid(info, 0);
+			int maxLeaf = info[0];
+
+			__cpuid(info, 1);
+			features.sse41 = (info[2] & (1 << 19)) != 0;
+
+			// AVX also needs the OS to save the YMM registers.
+			bool osSavesYmm = false;
+			if ((info[2] & (1 << 27)) != 0)
+			{
+				osSavesYmm = (_xgetbv(0) & 0x6) == 0x6;
+			}
+			features.avx = (info[2] & (1 << 28)) != 0 && osSavesYmm;
+
+			if (maxLeaf >= 7)
+			{
+				__cpuidex(info, 7, 0);
+				features.avx2 = features.avx && (info[1] & (1 << 5)) != 0;
+			}
+#elif defined(__x86_64__) || defined(__i386__)
+			__builtin_cpu_init();
+			features.sse41 = __builtin_cpu_supports("sse4.1");
+			features.avx = __builtin_cpu_supports("avx");
+			features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+			return features;
+		}
+
+		const CpuFeatures& GetDetectedFeatures()
+		{
+			static const CpuFeatures detected = DetectCpuFeatures();
+			return detected;
+		}
+
+		CpuFeatures& GetActiveFeatures()
+		{
+			static CpuFeatures active = GetDetectedFeatures();
+			return active;
+		}
+	}
+
+	const CpuFeatures& GetCpuFeatures()
+	{
+		return GetActiveFeatures();
+	}
+
+	void RestrictCpuFeatures(const CpuFeatures& allowed)
+	{
+		const CpuFeatures& detected = GetDetectedFeatures();
+
+		CpuFeatures& active = GetActiveFeatures();
+		active.sse41 = detected.sse41 && allowed.sse41;
+		active.avx = detected.avx && allowed.avx;
+		active.avx2 = detected.avx2 && allowed.avx2;
+	}
+}
@@ -0,0 +1,37 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+
+// Lets GCC and Clang compile intrinsics of a wider instruction set than the rest of the
+// translation unit, MSVC accepts them without. The caller checks GetCpuFeatures() first.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define HB_TARGET_SSE41
+#define HB_TARGET_AVX
+#define HB_TARGET_AVX2
+#else
+#define HB_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define HB_TARGET_AVX __attribute__((target("avx")))
+#define HB_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+
+namespace Humpback
+{
+	// The project is built for plain x64 (SSE2), the wider code paths are picked at runtime.
+	struct CpuFeatures
+	{
+		bool sse41 = false;
+		bool avx = false;
+		bool avx2 = false;
+	};
+
+	// Features of the running CPU and OS, detected on the first call.
+	const CpuFeatures& GetCpuFeatures();
+
+	// Turns features off so that tests and benchmarks can compare the code paths.
+	// Features the CPU does not have stay off. Not thread safe, call it before any work.
+	void RestrictCpuFeatures(const CpuFeatures& allowed);
+}
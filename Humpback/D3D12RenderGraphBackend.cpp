@@ -0,0 +1,151 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include "../DirectXTK12-main/Src/d3dx12.h"
+#include "D3D12RenderGraphBackend.h"
+
+
+namespace Humpback
+{
+	void ThrowIfFailed(HRESULT hr);
+
+	void D3D12RenderGraphBackend::SetCommandList(ID3D12GraphicsCommandList* cmdList)
+	{
+		m_commandList = cmdList;
+	}
+
+	void D3D12RenderGraphBackend::SetResource(RGResourceHandle handle, ID3D12Resource* pResource)
+	{
+		if (handle >= m_resources.size())
+		{
+			m_resources.resize(handle + 1, nullptr);
+		}
+
+		m_resources[handle] = pResource;
+	}
+
+	ID3D12Resource* D3D12RenderGraphBackend::GetResource(RGResourceHandle handle) const
+	{
+		return handle < m_resources.size() ? m_resources[handle] : nullptr;
+	}
+
+	RGResourceHandle D3D12RenderGraphBackend::CreateTransient(RenderGraph& graph, ID3D12Device* pDevice,
+		const std::string& name, const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* pClearValue)
+	{
+		auto info = pDevice->GetResourceAllocationInfo(0, 1, &desc);
+
+		TransientDesc transient = {};
+		transient.handle = graph.CreateTransient(name, info.SizeInBytes, info.Alignment);
+		transient.desc = desc;
+		transient.hasClearValue = pClearValue != nullptr;
+		if (pClearValue != nullptr)
+		{
+			transient.clearValue = *pClearValue;
+		}
+
+		m_transientDescs.push_back(transient);
+
+		return transient.handle;
+	}
+
+	void D3D12RenderGraphBackend::CreateTransientResources(ID3D12Device* pDevice, const RenderGraph& graph)
+	{
+		for (auto& transient : m_transientDescs)
+		{
+			SetResource(transient.handle, nullptr);
+		}
+		m_transientResources.clear();
+		m_transientHeap = nullptr;
+
+		uint64_t heapSize = graph.GetStats().transientMemoryPeak;
+		if (heapSize == 0)
+		{
+			return;
+		}
+
+		// Only render and depth targets are transient, which keeps resource heap tier 1 happy.
+		CD3DX12_HEAP_DESC heapDesc(heapSize, D3D12_HEAP_TYPE_DEFAULT, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+			D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES);
+		ThrowIfFailed(pDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_transientHeap)));
+
+		for (auto& transient : m_transientDescs)
+		{
+			// Culled passes can leave a transient without any use.
+			if (graph.GetTransientState(transient.handle) == RGResourceState::Undefined)
+			{
+				continue;
+			}
+
+			Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+			ThrowIfFailed(pDevice->CreatePlacedResource(m_transientHeap.Get(), graph.GetTransientOffset(transient.handle),
+				&transient.desc, ToD3D12State(graph.GetTransientState(transient.handle)),
+				transient.hasClearValue ? &transient.clearValue : nullptr, IID_PPV_ARGS(&resource)));
+
+			SetResource(transient.handle, resource.Get());
+			m_transientResources.push_back(resource);
+		}
+	}
+
+	void D3D12RenderGraphBackend::ResourceBarriers(const RGBarrier* barriers, unsigned int count)
+	{
+		if (m_commandList == nullptr || count == 0)
+		{
+			return;
+		}
+
+		m_barriers.clear();
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const RGBarrier& b = barriers[i];
+			ID3D12Resource* pResource = b.resource < m_resources.size() ? m_resources[b.resource] : nullptr;
+			if (pResource == nullptr)
+			{
+				continue;
+			}
+
+			if (b.isAliasing)
+			{
+				ID3D12Resource* pBefore = b.aliasBefore < m_resources.size() ? m_resources[b.aliasBefore] : nullptr;
+				m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(pBefore, pResource));
+			}
+			else
+			{
+				m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(pResource,
+					ToD3D12State(b.before), ToD3D12State(b.after)));
+			}
+		}
+
+		if (m_barriers.empty() == false)
+		{
+			m_commandList->ResourceBarrier((UINT)m_barriers.size(), m_barriers.data());
+		}
+	}
+
+	D3D12_RESOURCE_STATES D3D12RenderGraphBackend::ToD3D12State(RGResourceState state)
+	{
+		switch (state)
+		{
+		case RGResourceState::GenericRead:
+			return D3D12_RESOURCE_STATE_GENERIC_READ;
+		case RGResourceState::ShaderResource:
+			return D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+		case RGResourceState::RenderTarget:
+			return D3D12_RESOURCE_STATE_RENDER_TARGET;
+		case RGResourceState::DepthWrite:
+			return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+		case RGResourceState::DepthRead:
+			return D3D12_RESOURCE_STATE_DEPTH_READ;
+		case RGResourceState::CopySource:
+			return D3D12_RESOURCE_STATE_COPY_SOURCE;
+		case RGResourceState::CopyDest:
+			return D3D12_RESOURCE_STATE_COPY_DEST;
+		case RGResourceState::Present:
+			return D3D12_RESOURCE_STATE_PRESENT;
+		case RGResourceState::Undefined:
+		case RGResourceState::Common:
+		default:
+			return D3D12_RESOURCE_STATE_COMMON;
+		}
+	}
+}
@@ -0,0 +1,60 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <d3d12.h>
+#include <wrl.h>
+
+#include "RenderGraph.h"
+
+
+namespace Humpback
+{
+	// Translates the barrier batches of a compiled render graph into D3D12 barriers
+	// and places the transient resources of the graph in one shared heap.
+	class D3D12RenderGraphBackend : public RenderGraphBackend
+	{
+	public:
+
+		D3D12RenderGraphBackend() = default;
+		D3D12RenderGraphBackend(const D3D12RenderGraphBackend&) = delete;
+		D3D12RenderGraphBackend& operator=(const D3D12RenderGraphBackend&) = delete;
+
+		void SetCommandList(ID3D12GraphicsCommandList* cmdList);
+		void SetResource(RGResourceHandle handle, ID3D12Resource* pResource);
+		ID3D12Resource* GetResource(RGResourceHandle handle) const;
+
+		// Declares a transient in the graph, sized for the given texture description.
+		RGResourceHandle CreateTransient(RenderGraph& graph, ID3D12Device* pDevice, const std::string& name,
+			const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* pClearValue = nullptr);
+
+		// Creates the placed transients of a compiled graph at their aliased offsets.
+		// The previous heap is released, the GPU must not use it any more.
+		void CreateTransientResources(ID3D12Device* pDevice, const RenderGraph& graph);
+
+		void ResourceBarriers(const RGBarrier* barriers, unsigned int count) override;
+
+		static D3D12_RESOURCE_STATES ToD3D12State(RGResourceState state);
+
+	private:
+
+		struct TransientDesc
+		{
+			RGResourceHandle handle;
+			D3D12_RESOURCE_DESC desc;
+			D3D12_CLEAR_VALUE clearValue;
+			bool hasClearValue;
+		};
+
+		ID3D12GraphicsCommandList*			m_commandList = nullptr;
+		std::vector<ID3D12Resource*>		m_resources;
+		std::vector<D3D12_RESOURCE_BARRIER>	m_barriers;
+
+		std::vector<TransientDesc>			m_transientDescs;
+		Microsoft::WRL::ComPtr<ID3D12Heap>	m_transientHeap;
+		std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>>	m_transientResources;
+	};
+}
@@ -32,13 +32,6 @@ namespace Humpback
             return (byteSize + 255) & ~255;
         }
 
-        static Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(
-            ID3D12Device* device, 
-            ID3D12GraphicsCommandList* commandList,
-            const void* initData,
-            uint64_t byteSize,
-            Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer);
-
         static Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(
             const std::wstring& filename,
             const D3D_SHADER_MACRO* defines,
@@ -0,0 +1,88 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <stdexcept>
+
+#include "DescriptorIndexAllocator.h"
+
+
+namespace Humpback
+{
+	DescriptorIndexAllocator::DescriptorIndexAllocator(uint32_t capacity) :
+		m_capacity(capacity),
+		m_head(_pack(0, capacity > 0 ? 0 : INVALID_INDEX)),
+		m_next(std::make_unique<std::atomic<uint32_t>[]>(capacity))
+	{
+		for (uint32_t i = 0; i < capacity; i++)
+		{
+			m_next[i].store(i + 1 < capacity ? i + 1 : INVALID_INDEX, std::memory_order_relaxed);
+		}
+	}
+
+	uint32_t DescriptorIndexAllocator::Allocate()
+	{
+		uint64_t head = m_head.load(std::memory_order_acquire);
+
+		while (true)
+		{
+			uint32_t index = (uint32_t)head;
+			if (index == INVALID_INDEX)
+			{
+				return INVALID_INDEX;
+			}
+
+			// next may be stale if another thread pops index first, the tag makes the CAS fail then.
+			uint32_t next = m_next[index].load(std::memory_order_relaxed);
+			uint64_t newHead = _pack((uint32_t)(head >> 32) + 1, next);
+
+			if (m_head.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				m_allocatedCount.fetch_add(1, std::memory_order_relaxed);
+				return index;
+			}
+		}
+	}
+
+	void DescriptorIndexAllocator::Free(uint32_t index)
+	{
+		if (index >= m_capacity)
+		{
+			throw std::runtime_error("DescriptorIndexAllocator: freeing an index out of range.");
+		}
+
+		// Uncount before the push, once index is on the list another thread may pop and count it,
+		// which would briefly put the count above the capacity.
+		m_allocatedCount.fetch_sub(1, std::memory_order_relaxed);
+
+		uint64_t head = m_head.load(std::memory_order_acquire);
+
+		while (true)
+		{
+			m_next[index].store((uint32_t)head, std::memory_order_relaxed);
+			uint64_t newHead = _pack((uint32_t)(head >> 32) + 1, index);
+
+			if (m_head.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				return;
+			}
+		}
+	}
+
+	void DescriptorIndexAllocator::FreeDeferred(uint32_t index, uint64_t fenceValue)
+	{
+		std::lock_guard<std::mutex> lock(m_deferredMutex);
+		m_deferredFrees.push_back({ fenceValue, index });
+	}
+
+	void DescriptorIndexAllocator::ReleaseCompleted(uint64_t completedFenceValue)
+	{
+		std::lock_guard<std::mutex> lock(m_deferredMutex);
+
+		while (!m_deferredFrees.empty() && m_deferredFrees.front().fenceValue <= completedFenceValue)
+		{
+			Free(m_deferredFrees.front().index);
+			m_deferredFrees.pop_front();
+		}
+	}
+}
@@ -0,0 +1,60 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+
+namespace Humpback
+{
+	// Hands out stable slots in [0, capacity) for a bindless descriptor heap. Allocate and Free are
+	// lock-free (a Treiber stack whose head carries an ABA tag), so loader threads can create views
+	// without a lock. FreeDeferred holds a slot back until the GPU fence of its last use has passed.
+	class DescriptorIndexAllocator
+	{
+	public:
+
+		static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+		explicit DescriptorIndexAllocator(uint32_t capacity);
+
+		DescriptorIndexAllocator(const DescriptorIndexAllocator&) = delete;
+		DescriptorIndexAllocator& operator=(const DescriptorIndexAllocator&) = delete;
+
+		// Returns INVALID_INDEX when every slot is in use.
+		uint32_t Allocate();
+		void Free(uint32_t index);
+
+		void FreeDeferred(uint32_t index, uint64_t fenceValue);
+		void ReleaseCompleted(uint64_t completedFenceValue);
+
+		uint32_t GetCapacity() const { return m_capacity; }
+		uint32_t GetAllocatedCount() const { return m_allocatedCount.load(std::memory_order_relaxed); }
+
+	private:
+
+		static uint64_t _pack(uint32_t tag, uint32_t index) { return ((uint64_t)tag << 32) | index; }
+
+		uint32_t m_capacity;
+
+		// Low 32 bits: first free index, high 32 bits: tag bumped on every change.
+		std::atomic<uint64_t> m_head;
+		std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+		std::atomic<uint32_t> m_allocatedCount = 0;
+
+		struct DeferredFree
+		{
+			uint64_t fenceValue;
+			uint32_t index;
+		};
+
+		std::mutex m_deferredMutex;
+		std::deque<DeferredFree> m_deferredFrees;
+	};
+}
@@ -0,0 +1,108 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "DrawQueue.h"
+
+
+namespace Humpback
+{
+	uint64_t DrawQueue::MakeKey(unsigned int pass, unsigned int pso, unsigned int mesh,
+		unsigned int geometry, unsigned int material, unsigned int depth)
+	{
+		// Masking an id that does not fit would silently alias it with another one.
+		auto field = [](unsigned int value, unsigned int bits, const char* name)
+		{
+			if (value >> bits != 0)
+			{
+				throw std::runtime_error(std::string("DrawQueue: ") + name + " id " + std::to_string(value) +
+					" does not fit in " + std::to_string(bits) + " bits.");
+			}
+
+			return (uint64_t)value;
+		};
+
+		uint64_t key = field(pass, PASS_BITS, "pass");
+		key = (key << PSO_BITS) | field(pso, PSO_BITS, "pso");
+		key = (key << MESH_BITS) | field(mesh, MESH_BITS, "mesh");
+		key = (key << GEOMETRY_BITS) | field(geometry, GEOMETRY_BITS, "geometry");
+		key = (key << MATERIAL_BITS) | field(material, MATERIAL_BITS, "material");
+		key = (key << DEPTH_BITS) | field(depth, DEPTH_BITS, "depth");
+
+		return key;
+	}
+
+	unsigned int DrawQueue::GetMesh(uint64_t key)
+	{
+		return (unsigned int)(key >> (GEOMETRY_BITS + MATERIAL_BITS + DEPTH_BITS)) & ((1u << MESH_BITS) - 1);
+	}
+
+	unsigned int DrawQueue::QuantizeDepth(float depth, float nearZ, float farZ)
+	{
+		const unsigned int maxDepth = (1u << DEPTH_BITS) - 1;
+
+		float t = (depth - nearZ) / (farZ - nearZ);
+		t = std::min(std::max(t, 0.0f), 1.0f);
+
+		return (unsigned int)(t * maxDepth);
+	}
+
+	void DrawQueue::Sort()
+	{
+		const size_t count = m_packets.size();
+		if (count < 2)
+		{
+			return;
+		}
+
+		m_scratch.resize(count);
+
+		// All eight histograms in one pass over the keys.
+		unsigned int histograms[8][256] = {};
+		for (auto& packet : m_packets)
+		{
+			for (int digit = 0; digit < 8; digit++)
+			{
+				++histograms[digit][(packet.key >> (digit * 8)) & 0xff];
+			}
+		}
+
+		DrawPacket* src = m_packets.data();
+		DrawPacket* dst = m_scratch.data();
+
+		for (int digit = 0; digit < 8; digit++)
+		{
+			unsigned int* histogram = histograms[digit];
+
+			// Every key has the same value in this digit, the pass would not move anything.
+			if (histogram[(src[0].key >> (digit * 8)) & 0xff] == count)
+			{
+				continue;
+			}
+
+			unsigned int offset = 0;
+			for (int bucket = 0; bucket < 256; bucket++)
+			{
+				unsigned int bucketCount = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucketCount;
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				dst[histogram[(src[i].key >> (digit * 8)) & 0xff]++] = src[i];
+			}
+
+			std::swap(src, dst);
+		}
+
+		if (src != m_packets.data())
+		{
+			m_packets.swap(m_scratch);
+		}
+	}
+}
@@ -0,0 +1,79 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+
+namespace Humpback
+{
+	class RenderableObject;
+
+	struct DrawPacket
+	{
+		uint64_t key = 0;
+		RenderableObject* object = nullptr;
+	};
+
+	struct DrawSubmissionStats
+	{
+		unsigned int drawCount = 0;
+		unsigned int stateChanges = 0;
+		unsigned int stateChangesAvoided = 0;
+
+		DrawSubmissionStats& operator+=(const DrawSubmissionStats& rhs)
+		{
+			drawCount += rhs.drawCount;
+			stateChanges += rhs.stateChanges;
+			stateChangesAvoided += rhs.stateChangesAvoided;
+			return *this;
+		}
+	};
+
+
+	// Draw packets sorted by a 64 bit key, most significant field first:
+	// pass (4) | pso (6) | mesh (14) | geometry (12) | material (12) | depth (16).
+	// Packets that only differ in material and depth can share one instanced draw.
+	class DrawQueue
+	{
+	public:
+
+		static const unsigned int PASS_BITS = 4;
+		static const unsigned int PSO_BITS = 6;
+		static const unsigned int MESH_BITS = 14;
+		static const unsigned int GEOMETRY_BITS = 12;
+		static const unsigned int MATERIAL_BITS = 12;
+		static const unsigned int DEPTH_BITS = 16;
+
+		// Throws when a value does not fit in its field.
+		static uint64_t MakeKey(unsigned int pass, unsigned int pso, unsigned int mesh,
+			unsigned int geometry, unsigned int material, unsigned int depth);
+
+		// The key without material and depth, equal for packets of the same instanced draw.
+		static uint64_t GetGeometryKey(uint64_t key) { return key >> (MATERIAL_BITS + DEPTH_BITS); }
+		static unsigned int GetMesh(uint64_t key);
+
+		// Quantizes a view depth in [nearZ, farZ] to the depth field.
+		static unsigned int QuantizeDepth(float depth, float nearZ, float farZ);
+
+		DrawQueue() = default;
+		DrawQueue(const DrawQueue&) = delete;
+		DrawQueue& operator=(const DrawQueue&) = delete;
+
+		void Clear() { m_packets.clear(); }
+		void Push(uint64_t key, RenderableObject* object) { m_packets.push_back({ key, object }); }
+
+		// Stable LSD radix sort, 8 bits per pass. Passes whose digit is the same for all keys are skipped.
+		void Sort();
+
+		const std::vector<DrawPacket>& GetPackets() const { return m_packets; }
+
+	private:
+
+		std::vector<DrawPacket> m_packets;
+		std::vector<DrawPacket> m_scratch;
+	};
+}
@@ -5,14 +5,15 @@
 #include <memory>
 
 #include "FrameResource.h"
-#include "RenderableObject.h"
+#include "RenderableStore.h"
 
 
 namespace Humpback
 {
 
-	FrameResource::FrameResource(ID3D12Device* device, unsigned int passCount, unsigned int objectCount, 
-		unsigned int maxInstanceCount, unsigned int materialCount)
+	FrameResource::FrameResource(ID3D12Device* device, unsigned int passCount,
+		unsigned int maxInstanceCount, unsigned int objectCount, unsigned int materialCount, unsigned int recordingListCount,
+		GpuMemoryAllocator* allocator)
 	{
 		if (device == nullptr)
 		{
@@ -23,11 +24,19 @@ namespace Humpback
 			D3D12_COMMAND_LIST_TYPE_DIRECT,
 			IID_PPV_ARGS(cmdAlloc.GetAddressOf())));
 
-		objCBuffer = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, true);
-		passCBuffer = std::make_unique<UploadBuffer<PassConstants>>(device, passCount, true);
-		materialCBuffer = std::make_unique<UploadBuffer<MaterialConstants>>(device, materialCount, false);
-		ssaoCBuffer = std::make_unique<UploadBuffer<SSAOConstants>>(device, 1, true);
-		//instanceBuffer = std::make_unique<UploadBuffer<InstanceData>>(device, maxInstanceCount, false);
+		recordingCmdAllocs.resize(recordingListCount);
+		for (auto& alloc : recordingCmdAllocs)
+		{
+			ThrowIfFailed(device->CreateCommandAllocator(
+				D3D12_COMMAND_LIST_TYPE_DIRECT,
+				IID_PPV_ARGS(alloc.GetAddressOf())));
+		}
+
+		passCBuffer = std::make_unique<UploadBuffer<PassConstants>>(device, passCount, true, allocator);
+		materialCBuffer = std::make_unique<UploadBuffer<MaterialConstants>>(device, materialCount, false, allocator);
+		ssaoCBuffer = std::make_unique<UploadBuffer<SSAOConstants>>(device, 1, true, allocator);
+		instanceBuffer = std::make_unique<UploadBuffer<uint32_t>>(device, maxInstanceCount, false, allocator);
+		objectBuffer = std::make_unique<UploadBuffer<ObjectData>>(device, objectCount, false, allocator);
 	}
 
 	FrameResource::~FrameResource()
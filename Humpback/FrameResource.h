@@ -5,25 +5,18 @@
 #pragma once
 
 
+#include <vector>
 #include <DirectXMath.h>
 
 #include "HMathHelper.h"
 #include "UploadBufferHelper.h"
 #include "Material.h"
+#include "ShadowCascades.h"
 
 
 namespace Humpback
 {
-	struct InstanceData;
-
-	struct ObjectConstants
-	{
-		DirectX::XMFLOAT4X4 worldM = HMathHelper::Identity4x4();
-		unsigned int MaterialIndex;
-		unsigned int pat0;
-		unsigned int pat1;
-		unsigned int pat2;
-	};
+	struct ObjectData;
 
 
 #define MaxLights 16
@@ -46,7 +39,9 @@ namespace Humpback
 		DirectX::XMFLOAT4X4 invProj = HMathHelper::Identity4x4();
 		DirectX::XMFLOAT4X4 viewProj = HMathHelper::Identity4x4();
 		DirectX::XMFLOAT4X4 invViewProj = HMathHelper::Identity4x4();
-		DirectX::XMFLOAT4X4 shadowVPT = HMathHelper::Identity4x4();
+		// World to shadow map texture space, one per cascade.
+		DirectX::XMFLOAT4X4 shadowVPT[ShadowCascades::MAX_CASCADES] = {
+			HMathHelper::Identity4x4(), HMathHelper::Identity4x4(), HMathHelper::Identity4x4(), HMathHelper::Identity4x4() };
 		DirectX::XMFLOAT4X4 viewProjTex = HMathHelper::Identity4x4();
 		DirectX::XMFLOAT3 cameraPosW = { .0f, .0f, .0f };
 		float cbPerObjectPad1 = 0.0f;
@@ -60,6 +55,15 @@ namespace Humpback
 		DirectX::XMFLOAT4 ambient = { 0.0f, 0.0f, 0.0f, 1.0f };
 		
 		LightConstants lights[MaxLights];
+
+		// Bindless heap slots of the textures every pass samples.
+		unsigned int skyCubeMapIndex = 0;
+		unsigned int shadowMapIndex = 0;
+		unsigned int ssaoMapIndex = 0;
+		unsigned int shadowCascadeCount = 0;
+
+		// Far view depth of each cascade, a cascade is used up to its split.
+		DirectX::XMFLOAT4 shadowCascadeSplits = { 0.0f, 0.0f, 0.0f, 0.0f };
 	};
 
 	struct SSAOConstants
@@ -83,8 +87,9 @@ namespace Humpback
 	{
 	public:
 
-		FrameResource(ID3D12Device* device, unsigned int passCount, unsigned int objectCount, 
-			unsigned int maxInstanceCount, unsigned int materialCount);
+		FrameResource(ID3D12Device* device, unsigned int passCount,
+			unsigned int maxInstanceCount, unsigned int objectCount, unsigned int materialCount, unsigned int recordingListCount = 0,
+			GpuMemoryAllocator* allocator = nullptr);
 		FrameResource(const FrameResource& rhs) = delete;
 		FrameResource& operator=(const FrameResource& rhs) = delete;
 		~FrameResource();
@@ -92,7 +97,13 @@ namespace Humpback
 		// We cannot reset the cmd allocator until the GPU is done processing the commands in it.
 		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> cmdAlloc;
 
-		std::unique_ptr<UploadBuffer<ObjectConstants>> objCBuffer = nullptr;
+		// One allocator per command list used for parallel recording, indexed like the lists.
+		std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> recordingCmdAllocs;
+
+		// Object ids of the instances drawn this frame, rebuilt every frame.
+		std::unique_ptr<UploadBuffer<uint32_t>> instanceBuffer = nullptr;
+		// One record per object, only the records that changed since this frame resource was last used are written.
+		std::unique_ptr<UploadBuffer<ObjectData>> objectBuffer = nullptr;
 		std::unique_ptr<UploadBuffer<PassConstants>> passCBuffer = nullptr;
 		std::unique_ptr<UploadBuffer<MaterialConstants>> materialCBuffer = nullptr;
 		std::unique_ptr<UploadBuffer<SSAOConstants>> ssaoCBuffer = nullptr;
@@ -0,0 +1,216 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cfloat>
+#include <cmath>
+#include <immintrin.h>
+
+#include "CpuFeatures.h"
+#include "FrustumCuller.h"
+
+
+using namespace DirectX;
+
+
+namespace Humpback
+{
+	namespace
+	{
+		// A box is outside a plane when even its corner furthest along the normal is behind it:
+		// dot(n, c) + dot(|n|, e) + d < 0. The arrays hold center x, y, z and extent x, y, z.
+		void CullSse(const FrustumPlanes& frustum, const float* const soa[6], size_t padded,
+			std::vector<unsigned int>& visible)
+		{
+			__m128 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+			for (int p = 0; p < 6; p++)
+			{
+				const XMFLOAT4& plane = frustum.planes[p];
+				px[p] = _mm_set1_ps(plane.x);
+				py[p] = _mm_set1_ps(plane.y);
+				pz[p] = _mm_set1_ps(plane.z);
+				pw[p] = _mm_set1_ps(plane.w);
+				ax[p] = _mm_set1_ps(fabsf(plane.x));
+				ay[p] = _mm_set1_ps(fabsf(plane.y));
+				az[p] = _mm_set1_ps(fabsf(plane.z));
+			}
+
+			const __m128 zero = _mm_setzero_ps();
+			for (size_t i = 0; i < padded; i += 4)
+			{
+				__m128 cx = _mm_loadu_ps(soa[0] + i);
+				__m128 cy = _mm_loadu_ps(soa[1] + i);
+				__m128 cz = _mm_loadu_ps(soa[2] + i);
+				__m128 ex = _mm_loadu_ps(soa[3] + i);
+				__m128 ey = _mm_loadu_ps(soa[4] + i);
+				__m128 ez = _mm_loadu_ps(soa[5] + i);
+
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (int p = 0; p < 6; p++)
+				{
+					__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, px[p]), _mm_mul_ps(cy, py[p])),
+						_mm_add_ps(_mm_mul_ps(cz, pz[p]), pw[p]));
+					__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ax[p]), _mm_mul_ps(ey, ay[p])),
+						_mm_mul_ps(ez, az[p]));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, radius), zero));
+				}
+
+				int mask = _mm_movemask_ps(inside);
+				for (int b = 0; mask != 0; b++, mask >>= 1)
+				{
+					if (mask & 1)
+					{
+						visible.push_back((unsigned int)(i + b));
+					}
+				}
+			}
+		}
+
+		HB_TARGET_AVX void CullAvx(const FrustumPlanes& frustum, const float* const soa[6], size_t padded,
+			std::vector<unsigned int>& visible)
+		{
+			__m256 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+			for (int p = 0; p < 6; p++)
+			{
+				const XMFLOAT4& plane = frustum.planes[p];
+				px[p] = _mm256_set1_ps(plane.x);
+				py[p] = _mm256_set1_ps(plane.y);
+				pz[p] = _mm256_set1_ps(plane.z);
+				pw[p] = _mm256_set1_ps(plane.w);
+				ax[p] = _mm256_set1_ps(fabsf(plane.x));
+				ay[p] = _mm256_set1_ps(fabsf(plane.y));
+				az[p] = _mm256_set1_ps(fabsf(plane.z));
+			}
+
+			const __m256 zero = _mm256_setzero_ps();
+			for (size_t i = 0; i < padded; i += 8)
+			{
+				__m256 cx = _mm256_loadu_ps(soa[0] + i);
+				__m256 cy = _mm256_loadu_ps(soa[1] + i);
+				__m256 cz = _mm256_loadu_ps(soa[2] + i);
+				__m256 ex = _mm256_loadu_ps(soa[3] + i);
+				__m256 ey = _mm256_loadu_ps(soa[4] + i);
+				__m256 ez = _mm256_loadu_ps(soa[5] + i);
+
+				__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+				for (int p = 0; p < 6; p++)
+				{
+					__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, px[p]), _mm256_mul_ps(cy, py[p])),
+						_mm256_add_ps(_mm256_mul_ps(cz, pz[p]), pw[p]));
+					__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, ax[p]), _mm256_mul_ps(ey, ay[p])),
+						_mm256_mul_ps(ez, az[p]));
+					inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(dist, radius), zero, _CMP_GE_OQ));
+				}
+
+				int mask = _mm256_movemask_ps(inside);
+				for (int b = 0; mask != 0; b++, mask >>= 1)
+				{
+					if (mask & 1)
+					{
+						visible.push_back((unsigned int)(i + b));
+					}
+				}
+			}
+
+			// The callers are built without VEX, avoid the AVX to SSE transition penalty.
+			_mm256_zeroupper();
+		}
+	}
+
+	FrustumPlanes FrustumPlanes::FromViewProj(FXMMATRIX viewProj)
+	{
+		XMFLOAT4X4 m;
+		XMStoreFloat4x4(&m, viewProj);
+
+		// Row vectors: clip = p * M, so each plane is a combination of the matrix columns.
+		XMVECTOR c0 = XMVectorSet(m._11, m._21, m._31, m._41);
+		XMVECTOR c1 = XMVectorSet(m._12, m._22, m._32, m._42);
+		XMVECTOR c2 = XMVectorSet(m._13, m._23, m._33, m._43);
+		XMVECTOR c3 = XMVectorSet(m._14, m._24, m._34, m._44);
+
+		XMVECTOR planes[6] =
+		{
+			c3 + c0,	// Left.
+			c3 - c0,	// Right.
+			c3 + c1,	// Bottom.
+			c3 - c1,	// Top.
+			c2,			// Near, D3D clip z starts at 0.
+			c3 - c2,	// Far.
+		};
+
+		FrustumPlanes result;
+		for (int i = 0; i < 6; i++)
+		{
+			XMStoreFloat4(&result.planes[i], XMPlaneNormalize(planes[i]));
+		}
+
+		return result;
+	}
+
+	unsigned int FrustumCuller::AddBox(const BoundingBox& box)
+	{
+		unsigned int index = m_count;
+		_resize(m_count + 1);
+		SetBox(index, box);
+
+		return index;
+	}
+
+	void FrustumCuller::SetBox(unsigned int index, const BoundingBox& box)
+	{
+		m_centerX[index] = box.Center.x;
+		m_centerY[index] = box.Center.y;
+		m_centerZ[index] = box.Center.z;
+		m_extentX[index] = box.Extents.x;
+		m_extentY[index] = box.Extents.y;
+		m_extentZ[index] = box.Extents.z;
+	}
+
+	void FrustumCuller::Clear()
+	{
+		m_count = 0;
+		m_centerX.clear();
+		m_centerY.clear();
+		m_centerZ.clear();
+		m_extentX.clear();
+		m_extentY.clear();
+		m_extentZ.clear();
+	}
+
+	void FrustumCuller::_resize(unsigned int count)
+	{
+		m_count = count;
+
+		// Padding boxes have a negative extent so they fail every plane test.
+		size_t padded = (count + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE;
+		m_centerX.resize(padded, 0.0f);
+		m_centerY.resize(padded, 0.0f);
+		m_centerZ.resize(padded, 0.0f);
+		m_extentX.resize(padded, -FLT_MAX);
+		m_extentY.resize(padded, -FLT_MAX);
+		m_extentZ.resize(padded, -FLT_MAX);
+	}
+
+	void FrustumCuller::Cull(const FrustumPlanes& frustum, std::vector<unsigned int>& visible, CullingStats* pStats) const
+	{
+		visible.clear();
+
+		const float* soa[6] = { m_centerX.data(), m_centerY.data(), m_centerZ.data(),
+			m_extentX.data(), m_extentY.data(), m_extentZ.data() };
+
+		if (GetCpuFeatures().avx)
+		{
+			CullAvx(frustum, soa, m_centerX.size(), visible);
+		}
+		else
+		{
+			CullSse(frustum, soa, m_centerX.size(), visible);
+		}
+
+		if (pStats != nullptr)
+		{
+			pStats->testedCount += m_count;
+			pStats->visibleCount += (unsigned int)visible.size();
+		}
+	}
+}
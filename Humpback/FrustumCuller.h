@@ -0,0 +1,65 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+
+namespace Humpback
+{
+	// Six world space planes, inside is where dot(plane.xyz, p) + plane.w >= 0.
+	struct FrustumPlanes
+	{
+		DirectX::XMFLOAT4 planes[6];
+
+		// Extracts the planes from a view-projection matrix. Works for perspective and orthographic projections.
+		static FrustumPlanes FromViewProj(DirectX::FXMMATRIX viewProj);
+	};
+
+	struct CullingStats
+	{
+		unsigned int testedCount = 0;
+		unsigned int visibleCount = 0;
+	};
+
+
+	// Keeps world space AABBs in structure-of-arrays form and tests them 4 (SSE) or 8 (AVX) at a time.
+	// The AVX path is picked at runtime, see CpuFeatures.
+	class FrustumCuller
+	{
+	public:
+
+		FrustumCuller() = default;
+		FrustumCuller(const FrustumCuller&) = delete;
+		FrustumCuller& operator=(const FrustumCuller&) = delete;
+
+		unsigned int AddBox(const DirectX::BoundingBox& box);
+		void SetBox(unsigned int index, const DirectX::BoundingBox& box);
+		void Clear();
+
+		unsigned int GetBoxCount() const { return m_count; }
+
+		// Writes the indices of the boxes intersecting the frustum in ascending order.
+		void Cull(const FrustumPlanes& frustum, std::vector<unsigned int>& visible, CullingStats* pStats = nullptr) const;
+
+	private:
+
+		// Arrays are padded to a multiple of the widest SIMD batch.
+		static const unsigned int BATCH_SIZE = 8;
+
+		void _resize(unsigned int count);
+
+		std::vector<float> m_centerX;
+		std::vector<float> m_centerY;
+		std::vector<float> m_centerZ;
+		std::vector<float> m_extentX;
+		std::vector<float> m_extentY;
+		std::vector<float> m_extentZ;
+
+		unsigned int m_count = 0;
+	};
+}
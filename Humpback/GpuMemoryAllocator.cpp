@@ -0,0 +1,265 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "../DirectXTK12-main/Src/d3dx12.h"
+#include "GpuMemoryAllocator.h"
+
+
+using Microsoft::WRL::ComPtr;
+
+
+namespace Humpback
+{
+	void ThrowIfFailed(HRESULT hr);
+
+	GpuMemoryAllocator::GpuMemoryAllocator(ID3D12Device* device, uint64_t blockSize) :
+		m_device(device),
+		m_blockSize(blockSize)
+	{
+	}
+
+	ComPtr<ID3D12Resource> GpuMemoryAllocator::CreateResource(const D3D12_RESOURCE_DESC& desc, D3D12_HEAP_TYPE heapType,
+		D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* clearValue)
+	{
+		ComPtr<ID3D12Resource> resource;
+
+		D3D12_RESOURCE_ALLOCATION_INFO info = m_device->GetResourceAllocationInfo(0, 1, &desc);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (info.SizeInBytes > m_blockSize)
+		{
+			auto heapProperties = CD3DX12_HEAP_PROPERTIES(heapType);
+			ThrowIfFailed(m_device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc,
+				initialState, clearValue, IID_PPV_ARGS(resource.GetAddressOf())));
+
+			m_placements[resource.Get()] = Placement();
+			return resource;
+		}
+
+		Pool* pool = _getPool(desc, heapType, info.Alignment);
+		Placement placement = _allocate(pool, info.SizeInBytes, info.Alignment);
+
+		ThrowIfFailed(m_device->CreatePlacedResource(pool->heaps[placement.allocation.block].Get(),
+			placement.allocation.offset, &desc, initialState, clearValue, IID_PPV_ARGS(resource.GetAddressOf())));
+
+		m_placements[resource.Get()] = placement;
+		return resource;
+	}
+
+	ComPtr<ID3D12Resource> GpuMemoryAllocator::CreateBuffer(uint64_t byteSize, D3D12_HEAP_TYPE heapType,
+		D3D12_RESOURCE_STATES initialState)
+	{
+		auto desc = CD3DX12_RESOURCE_DESC::Buffer(byteSize);
+		return CreateResource(desc, heapType, initialState);
+	}
+
+	void GpuMemoryAllocator::Release(ID3D12Resource* resource)
+	{
+		if (resource == nullptr)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = m_placements.find(resource);
+		if (it == m_placements.end())
+		{
+			return;
+		}
+
+		if (it->second.pool != nullptr)
+		{
+			it->second.pool->blocks->Free(it->second.allocation);
+		}
+
+		m_placements.erase(it);
+	}
+
+	unsigned int GpuMemoryAllocator::Defragment(const RelocateCallback& relocate, float maxBlockUsage)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		unsigned int moveCount = 0;
+
+		for (auto& pool : m_pools)
+		{
+			// Upload and readback memory can't be the destination of a copy in COPY_DEST state.
+			if (pool->heapType != D3D12_HEAP_TYPE_DEFAULT)
+			{
+				continue;
+			}
+
+			std::vector<uint32_t> retired = pool->blocks->RetireBlocks(maxBlockUsage);
+			if (retired.empty())
+			{
+				continue;
+			}
+
+			std::vector<ID3D12Resource*> resources;
+			for (auto& placement : m_placements)
+			{
+				if (placement.second.pool == pool.get() &&
+					std::find(retired.begin(), retired.end(), placement.second.allocation.block) != retired.end())
+				{
+					resources.push_back(placement.first);
+				}
+			}
+
+			for (auto oldResource : resources)
+			{
+				D3D12_RESOURCE_DESC desc = oldResource->GetDesc();
+				D3D12_RESOURCE_ALLOCATION_INFO info = m_device->GetResourceAllocationInfo(0, 1, &desc);
+
+				Placement target = _allocate(pool.get(), info.SizeInBytes, info.Alignment);
+
+				ComPtr<ID3D12Resource> newResource;
+				ThrowIfFailed(m_device->CreatePlacedResource(pool->heaps[target.allocation.block].Get(),
+					target.allocation.offset, &desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+					IID_PPV_ARGS(newResource.GetAddressOf())));
+
+				if (relocate(oldResource, newResource.Get()) == false)
+				{
+					pool->blocks->Free(target.allocation);
+					continue;
+				}
+
+				// The old range stays allocated until the copy reading it has completed.
+				pool->blocks->FreeAfterCopy(m_placements[oldResource].allocation);
+				m_placements.erase(oldResource);
+				m_placements[newResource.Get()] = target;
+				moveCount++;
+			}
+		}
+
+		return moveCount;
+	}
+
+	void GpuMemoryAllocator::FinishSubmission(uint64_t fenceValue)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (auto& pool : m_pools)
+		{
+			pool->blocks->FinishSubmission(fenceValue);
+		}
+	}
+
+	void GpuMemoryAllocator::ReleaseCompleted(uint64_t completedFenceValue)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (auto& pool : m_pools)
+		{
+			for (uint32_t block : pool->blocks->ReleaseCompleted(completedFenceValue))
+			{
+				pool->heaps[block].Reset();
+			}
+		}
+	}
+
+	GpuMemoryStats GpuMemoryAllocator::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		GpuMemoryStats stats;
+		for (auto& pool : m_pools)
+		{
+			for (uint32_t i = 0; i < pool->blocks->GetBlockCount(); i++)
+			{
+				const BuddyAllocator* block = pool->blocks->GetBlock(i);
+				if (block != nullptr)
+				{
+					stats.heapCount++;
+					stats.reservedBytes += block->GetSize();
+					stats.usedBytes += block->GetUsedSize();
+				}
+			}
+		}
+
+		for (auto& placement : m_placements)
+		{
+			if (placement.second.pool != nullptr)
+			{
+				stats.placedResourceCount++;
+			}
+			else
+			{
+				stats.committedResourceCount++;
+			}
+		}
+
+		return stats;
+	}
+
+	GpuMemoryAllocator::Pool* GpuMemoryAllocator::_getPool(const D3D12_RESOURCE_DESC& desc, D3D12_HEAP_TYPE heapType,
+		uint64_t alignment)
+	{
+		D3D12_HEAP_FLAGS heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+		if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		{
+			heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+		}
+		else if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+		{
+			heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+		}
+
+		uint64_t heapAlignment = alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT ?
+			D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+		for (auto& pool : m_pools)
+		{
+			if (pool->heapType == heapType && pool->heapFlags == heapFlags && pool->alignment == heapAlignment)
+			{
+				return pool.get();
+			}
+		}
+
+		auto pool = std::make_unique<Pool>();
+		pool->heapType = heapType;
+		pool->heapFlags = heapFlags;
+		pool->alignment = heapAlignment;
+
+		// 4 KB granularity so small textures created with that alignment don't take a whole 64 KB block.
+		pool->blocks = std::make_unique<BuddyBlockPool>(m_blockSize, D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT);
+
+		m_pools.push_back(std::move(pool));
+		return m_pools.back().get();
+	}
+
+	GpuMemoryAllocator::Placement GpuMemoryAllocator::_allocate(Pool* pool, uint64_t size, uint64_t alignment)
+	{
+		Placement placement;
+		placement.pool = pool;
+		placement.allocation = pool->blocks->Allocate(size, alignment);
+		if (placement.allocation.block != BuddyBlockPool::INVALID_BLOCK)
+		{
+			return placement;
+		}
+
+		ComPtr<ID3D12Heap> heap;
+		CD3DX12_HEAP_DESC heapDesc(m_blockSize, pool->heapType, pool->alignment, pool->heapFlags);
+		ThrowIfFailed(m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(heap.GetAddressOf())));
+
+		uint32_t block = pool->blocks->AddBlock();
+		if (block >= pool->heaps.size())
+		{
+			pool->heaps.resize(block + 1);
+		}
+		pool->heaps[block] = heap;
+
+		placement.allocation = pool->blocks->Allocate(size, alignment);
+		if (placement.allocation.block != block)
+		{
+			throw std::runtime_error("GpuMemoryAllocator: resource does not fit in a new heap block.");
+		}
+
+		return placement;
+	}
+}
@@ -0,0 +1,104 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "BuddyAllocator.h"
+
+
+namespace Humpback
+{
+	struct GpuMemoryStats
+	{
+		unsigned int heapCount = 0;
+		unsigned int placedResourceCount = 0;
+		unsigned int committedResourceCount = 0;
+		uint64_t reservedBytes = 0;
+		uint64_t usedBytes = 0;
+	};
+
+
+	// Places resources in large ID3D12Heap blocks instead of giving each one its own committed allocation.
+	// Pools are split by heap type, by resource category (buffers, RT/DS textures, other textures, as
+	// resource heap tier 1 requires) and by alignment class (64 KB or 4 MB for MSAA). Offsets inside a
+	// block come from a BuddyAllocator. Resources larger than a block fall back to committed resources.
+	class GpuMemoryAllocator
+	{
+	public:
+
+		static const uint64_t DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+		// Called for every resource Defragment moves. The callee records the copy from the old to the new
+		// resource (the new one starts in COPY_DEST), takes a reference to the new one, swaps its references
+		// and keeps the old resource alive until the copy has executed, without calling back into the allocator.
+		// Returning false leaves the resource in place.
+		using RelocateCallback = std::function<bool(ID3D12Resource* oldResource, ID3D12Resource* newResource)>;
+
+		GpuMemoryAllocator(ID3D12Device* device, uint64_t blockSize = DEFAULT_BLOCK_SIZE);
+
+		GpuMemoryAllocator(const GpuMemoryAllocator&) = delete;
+		GpuMemoryAllocator& operator=(const GpuMemoryAllocator&) = delete;
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> CreateResource(const D3D12_RESOURCE_DESC& desc, D3D12_HEAP_TYPE heapType,
+			D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* clearValue = nullptr);
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> CreateBuffer(uint64_t byteSize, D3D12_HEAP_TYPE heapType,
+			D3D12_RESOURCE_STATES initialState);
+
+		// Returns the memory of a resource made by CreateResource. The GPU must be done with it and
+		// the caller must drop its last reference afterwards, the range is reused right away.
+		void Release(ID3D12Resource* resource);
+
+		// Moves the resources out of default heap blocks used less than maxBlockUsage into the other blocks.
+		// The emptied blocks take no new allocations and their heaps are destroyed once the copies completed.
+		// Returns the move count.
+		unsigned int Defragment(const RelocateCallback& relocate, float maxBlockUsage = 0.25f);
+
+		// Call after the copies recorded by Defragment were submitted and fenceValue was signaled.
+		void FinishSubmission(uint64_t fenceValue);
+		void ReleaseCompleted(uint64_t completedFenceValue);
+
+		GpuMemoryStats GetStats() const;
+
+	private:
+
+		struct Pool
+		{
+			D3D12_HEAP_TYPE heapType;
+			D3D12_HEAP_FLAGS heapFlags;
+			uint64_t alignment;
+			std::unique_ptr<BuddyBlockPool> blocks;
+
+			// The heap of each block index, null for released blocks.
+			std::vector<Microsoft::WRL::ComPtr<ID3D12Heap>> heaps;
+		};
+
+		struct Placement
+		{
+			Pool* pool = nullptr;
+			BuddyBlockPool::Allocation allocation;
+		};
+
+		Pool* _getPool(const D3D12_RESOURCE_DESC& desc, D3D12_HEAP_TYPE heapType, uint64_t alignment);
+		Placement _allocate(Pool* pool, uint64_t size, uint64_t alignment);
+
+		Microsoft::WRL::ComPtr<ID3D12Device> m_device;
+		uint64_t m_blockSize;
+
+		std::vector<std::unique_ptr<Pool>> m_pools;
+
+		// Committed fallbacks are kept with a null pool so Release can tell them apart.
+		std::unordered_map<ID3D12Resource*, Placement> m_placements;
+
+		mutable std::mutex m_mutex;
+	};
+}
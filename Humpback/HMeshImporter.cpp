@@ -1,15 +1,16 @@
 // (c) Li Hongcheng
 // 2023-12-31
 
-#include <iterator>
-#include "assimp/Importer.hpp"
-#include "assimp/postprocess.h"
+#include <cstring>
 #include "HMeshImporter.h"
+#include "MeshCooker.h"
+#include "JobSystem.h"
 #include "Vertex.h"
 #include "D3DUtil.h"
 #include "DDSTextureLoader.h"
 
-#pragma comment(lib, "Assimp/lib/x64/assimp-vc143-mt.lib")
+
+using namespace DirectX;
 
 
 namespace Humpback
@@ -18,8 +19,10 @@ namespace Humpback
 	void GetHardwareAdapter(IDXGIFactory1* pFactory, IDXGIAdapter1** ppAdapter, bool requestHighPerformanceAdapter);
 	std::wstring GetAssetPath(std::wstring str);
 
-	HMeshImporter::HMeshImporter(ID3D12Device* pDevice, ID3D12GraphicsCommandList* pCmdList):
-		m_device(pDevice), m_commandList(pCmdList)
+	HMeshImporter::HMeshImporter(ID3D12Device* pDevice, ID3D12GraphicsCommandList* pCmdList,
+		UploadAllocator* pUploadAllocator, AssetCache* pAssetCache, JobSystem* pJobSystem, bool packedVertices):
+		m_device(pDevice), m_commandList(pCmdList), m_uploadAllocator(pUploadAllocator), m_assetCache(pAssetCache),
+		m_jobSystem(pJobSystem), m_packedVertices(packedVertices)
 	{
 	}
 
@@ -29,17 +32,65 @@ namespace Humpback
 
 	bool HMeshImporter::Load(std::string fileName)
 	{
-		Assimp::Importer importer;
+		std::string key;
+		MappedFile cachedFile;
+		CookedMeshFile cooked;
+		std::vector<uint8_t> cookedBytes;
+
+		bool cached = false;
+		if (m_assetCache != nullptr)
+		{
+			key = MeshCooker::GetCacheKey(fileName);
+			cached = m_assetCache->Load(key, cachedFile);
+
+			// Truncated or written by an incompatible build, cook it again.
+			if (cached && cooked.Open(cachedFile.GetData(), cachedFile.GetSize()) == false)
+			{
+				m_assetCache->Reject(cachedFile);
+				cached = false;
+			}
+		}
+
+		if (cached == false)
+		{
+			if (MeshCooker::Cook(fileName, cookedBytes, m_jobSystem) == false)
+			{
+				return false;
+			}
 
-		const aiScene* pScene = importer.ReadFile(fileName, 
-			aiProcess_Triangulate | aiProcess_ConvertToLeftHanded);
+			// A read-only cache folder only costs the cooking on the next launch.
+			if (m_assetCache != nullptr)
+			{
+				m_assetCache->Store(key, cookedBytes);
+			}
+
+			if (cooked.Open(cookedBytes.data(), cookedBytes.size()) == false)
+			{
+				return false;
+			}
+		}
 
-		if (pScene == nullptr)
+		// Files loaded before keep their nodes, the parents of this one are rebased past them.
+		uint32_t firstNode = (uint32_t)m_nodes.size();
+		for (uint32_t i = 0; i < cooked.GetNodeCount(); i++)
 		{
-			return false;
+			CookedNode node = cooked.GetNode(i);
+			if (node.parent != CookedMeshFormat::NO_NODE)
+			{
+				node.parent += firstNode;
+			}
+			m_nodes.push_back(node);
 		}
 
-		_processNode(pScene->mRootNode, pScene);
+		// Built in place, the deque never moves meshes handed out by GetMesh.
+		for (uint32_t i = 0; i < cooked.GetMeshCount(); i++)
+		{
+			CookedMeshView view = cooked.GetMesh(i);
+			m_meshNodes.push_back(view.node != CookedMeshFormat::NO_NODE ? view.node + firstNode : CookedMeshFormat::NO_NODE);
+
+			m_meshes.emplace_back();
+			_createMesh(view, m_meshes.back());
+		}
 
 		return true;
 	}
@@ -49,97 +100,93 @@ namespace Humpback
 		return &m_meshes[index];
 	}
 
-	void HMeshImporter::_processNode(aiNode* node, const aiScene* scene)
+	void HMeshImporter::AddNodes(TransformHierarchy& hierarchy, uint32_t parent, std::vector<uint32_t>& meshNodes) const
 	{
-		for (size_t i = 0; i < node->mNumMeshes; i++)
+		std::vector<uint32_t> added(m_nodes.size());
+		for (size_t i = 0; i < m_nodes.size(); i++)
 		{
-			aiMesh* pAiMesh = scene->mMeshes[node->mMeshes[i]];
-			m_meshes.push_back(_processMesh(pAiMesh, scene));
+			const CookedNode& node = m_nodes[i];
+			XMFLOAT4X4 localTransform(node.localTransform);
+			added[i] = hierarchy.AddNode(node.parent != CookedMeshFormat::NO_NODE ? added[node.parent] : parent,
+				XMLoadFloat4x4(&localTransform));
 		}
 
-		for (size_t i = 0; i < node->mNumChildren; i++)
+		meshNodes.resize(m_meshNodes.size());
+		for (size_t i = 0; i < m_meshNodes.size(); i++)
 		{
-			_processNode(node->mChildren[i], scene);
+			meshNodes[i] = m_meshNodes[i] != CookedMeshFormat::NO_NODE ? added[m_meshNodes[i]] : parent;
 		}
 	}
 
-	Mesh HMeshImporter::_processMesh(aiMesh* pAiMesh, const aiScene* pAiScene)
+	void HMeshImporter::_createMesh(const CookedMeshView& view, Mesh& mesh)
 	{
-		std::vector<Vertex> vertices;
-		std::vector<unsigned int> indices;
-		std::vector<Texture> textures;
-
-		// Parse vertices.
-		for (size_t i = 0; i < pAiMesh->mNumVertices; i++)
-		{
-			// Position.
-			Vertex v;
-			v.position.x = pAiMesh->mVertices[i].x;
-			v.position.y = pAiMesh->mVertices[i].y;
-			v.position.z = pAiMesh->mVertices[i].z;
-
-			// UV 0
-			if (pAiMesh->mTextureCoords[0])
-			{
-				v.uv.x = pAiMesh->mTextureCoords[0][i].x;
-				v.uv.y = pAiMesh->mTextureCoords[0][i].y;
-			}
-
-			// Normal
-			v.normal.x = pAiMesh->mNormals[i].x;
-			v.normal.y = pAiMesh->mNormals[i].y;
-			v.normal.z = pAiMesh->mNormals[i].z;
 
-			// Tangent
-			v.tangent.x = pAiMesh->mTangents[i].x;
-			v.tangent.y = pAiMesh->mTangents[i].y;
-			v.tangent.z = pAiMesh->mTangents[i].z;
+		// The views point into the mapped file, the upload ring is the only copy on the way to the GPU.
+		mesh.indexBufferGPU = m_uploadAllocator->CreateDefaultBuffer(m_commandList.Get(), view.indices, view.indexByteSize);
+		mesh.indexFormat = view.indexStride == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		mesh.indexBufferByteSize = (unsigned int)view.indexByteSize;
 
-			vertices.push_back(v);
-		}
+		mesh.meshlets.assign(view.meshlets, view.meshlets + view.meshletCount);
+		mesh.indexBatches.assign(view.batches, view.batches + view.batchCount);
 
-		// Parse indices.
-		for (size_t i = 0; i < pAiMesh->mNumFaces; i++)
+		BoundingBox bounds;
+		for (uint32_t i = 0; i < view.subMeshCount; i++)
 		{
-			aiFace face = pAiMesh->mFaces[i];
-			for (size_t j = 0; j < face.mNumIndices; j++)
+			const CookedSubMesh& cookedSubMesh = view.subMeshes[i];
+
+			SubMesh subMesh;
+			subMesh.indexCount = cookedSubMesh.indexCount;
+			subMesh.startIndexLocation = cookedSubMesh.startIndexLocation;
+			subMesh.baseVertexLocation = cookedSubMesh.baseVertexLocation;
+			subMesh.aabb.Center = XMFLOAT3(cookedSubMesh.aabbCenter);
+			subMesh.aabb.Extents = XMFLOAT3(cookedSubMesh.aabbExtents);
+			subMesh.firstMeshlet = cookedSubMesh.firstMeshlet;
+			subMesh.meshletCount = cookedSubMesh.meshletCount;
+			subMesh.firstBatch = cookedSubMesh.firstBatch;
+			subMesh.batchCount = cookedSubMesh.batchCount;
+
+			std::string name(cookedSubMesh.name, strnlen(cookedSubMesh.name, sizeof(cookedSubMesh.name)));
+			mesh.drawArgs[name] = subMesh;
+
+			if (i == 0)
+			{
+				bounds = subMesh.aabb;
+			}
+			else
 			{
-				indices.push_back(face.mIndices[j]);
+				BoundingBox::CreateMerged(bounds, bounds, subMesh.aabb);
 			}
 		}
 
-		Mesh mesh;
-
-		const unsigned int vbByteSize = (unsigned int)vertices.size() * sizeof(Vertex);
-		const unsigned int ibByteSize = (unsigned int)indices.size() * sizeof(unsigned int);
-
-		// Vertex data.
-		ThrowIfFailed(D3DCreateBlob(vbByteSize, &mesh.vertexBufferCPU));
-		CopyMemory(mesh.vertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-		// Indices data.
-		ThrowIfFailed(D3DCreateBlob(ibByteSize, &mesh.indexBufferCPU));
-		CopyMemory(mesh.indexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-		mesh.vertexBufferGPU = D3DUtil::CreateDefaultBuffer(m_device.Get(), m_commandList.Get(),
-			vertices.data(), vbByteSize, mesh.vertexBufferUploader);
+		if (m_packedVertices == false || view.vertexStride != sizeof(Vertex))
+		{
+			mesh.vertexBufferGPU = m_uploadAllocator->CreateDefaultBuffer(m_commandList.Get(), view.vertices, view.vertexByteSize);
+			mesh.positionBufferGPU = m_uploadAllocator->CreateDefaultBuffer(m_commandList.Get(), view.positions, view.positionByteSize);
 
-		mesh.indexBufferGPU = D3DUtil::CreateDefaultBuffer(m_device.Get(), m_commandList.Get(),
-			indices.data(), ibByteSize, mesh.indexBufferUploader);
+			mesh.vertexByteStride = view.vertexStride;
+			mesh.vertexBufferByteSize = (unsigned int)view.vertexByteSize;
+			mesh.positionBufferByteSize = (unsigned int)view.positionByteSize;
+			return;
+		}
 
-		mesh.vertexByteStride = sizeof(Vertex);
-		mesh.vertexBufferByteSize = vbByteSize;
-		mesh.indexFormat = DXGI_FORMAT_R32_UINT;
-		mesh.indexBufferByteSize = ibByteSize;
+		// The importer writes one submesh per mesh, so its bounds are the submesh bounds. Submeshes
+		// sharing a vertex buffer share the quantization of their union.
+		PositionQuantization quantization = GetPositionQuantization(bounds.Center, bounds.Extents);
+		for (auto& drawArg : mesh.drawArgs)
+		{
+			drawArg.second.quantization = quantization;
+		}
 
-		SubMesh mainMesh;
-		mainMesh.indexCount = indices.size();
-		mainMesh.startIndexLocation = 0;
-		mainMesh.baseVertexLocation = 0;
+		std::vector<PackedVertex> packed(view.vertexCount);
+		PackVertices((const Vertex*)view.vertices, view.vertexCount, quantization, packed.data(), nullptr, m_jobSystem);
+		std::vector<PackedPosition> positions = BuildPackedPositionStream(packed);
 
-		mesh.drawArgs["main"] = mainMesh;
+		mesh.vertexByteStride = sizeof(PackedVertex);
+		mesh.vertexBufferByteSize = (unsigned int)(packed.size() * sizeof(PackedVertex));
+		mesh.vertexBufferGPU = m_uploadAllocator->CreateDefaultBuffer(m_commandList.Get(), packed.data(), mesh.vertexBufferByteSize);
 
-		return mesh;
+		mesh.positionByteStride = sizeof(PackedPosition);
+		mesh.positionBufferByteSize = (unsigned int)(positions.size() * sizeof(PackedPosition));
+		mesh.positionBufferGPU = m_uploadAllocator->CreateDefaultBuffer(m_commandList.Get(), positions.data(), mesh.positionBufferByteSize);
 	}
 }
-
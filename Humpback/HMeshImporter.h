@@ -4,37 +4,58 @@
 #pragma once
 
 #include <vector>
+#include <deque>
 #include <string>
 
-#include "assimp/scene.h"
-
 #include "Mesh.h"
 #include "Texture.h"
+#include "Vertex.h"
+#include "UploadAllocator.h"
+#include "CookedMesh.h"
+#include "AssetCache.h"
+#include "TransformHierarchy.h"
 
 
 namespace Humpback
 {
 	using Microsoft::WRL::ComPtr;
 
+	class JobSystem;
+
 
 	class HMeshImporter
 	{
 	public:
-		HMeshImporter(ID3D12Device* pDevice, ID3D12GraphicsCommandList* pCmdList);
+		// pAssetCache may be null, every Load then runs ASSIMP. pJobSystem may be null, cooking then runs on the calling thread.
+		// With packedVertices the meshes are uploaded as PackedVertex, the cooked files hold Vertex either way.
+		HMeshImporter(ID3D12Device* pDevice, ID3D12GraphicsCommandList* pCmdList, UploadAllocator* pUploadAllocator,
+			AssetCache* pAssetCache, JobSystem* pJobSystem, bool packedVertices);
 		~HMeshImporter();
 
+		// Maps the cooked mesh from the asset cache. On a miss the source is cooked by MeshCooker
+		// and stored in the cache for the next launch.
 		bool Load(std::string fileName);
 		
 		Mesh* GetMesh(int index = 0);
 
+		// Adds the node tree of the loaded files below parent, parent may be TransformHierarchy::NO_PARENT.
+		// meshNodes receives the node placing each mesh, in GetMesh order.
+		void AddNodes(TransformHierarchy& hierarchy, uint32_t parent, std::vector<uint32_t>& meshNodes) const;
+
 	private:
 
-		void _processNode(aiNode* node, const aiScene* scene);
-		Mesh _processMesh(aiMesh* pAiMesh, const aiScene* pAiScene);
+		void _createMesh(const CookedMeshView& view, Mesh& mesh);
 		
 		ComPtr<ID3D12Device>	m_device = nullptr;
 		ComPtr<ID3D12GraphicsCommandList>	m_commandList = nullptr;
+		UploadAllocator* m_uploadAllocator = nullptr;
+		AssetCache* m_assetCache = nullptr;
+		JobSystem* m_jobSystem = nullptr;
+		bool m_packedVertices = false;
 		
-		std::vector<Mesh> m_meshes;
+		std::deque<Mesh> m_meshes;
+		// Of every loaded file, parents rebased to this array. m_meshNodes is parallel to m_meshes.
+		std::vector<CookedNode> m_nodes;
+		std::vector<uint32_t> m_meshNodes;
 	};
 }
\ No newline at end of file
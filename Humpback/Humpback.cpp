@@ -2,10 +2,13 @@
 //
 
 #include <windowsx.h>
+#include <shellapi.h>
+#include <filesystem>
 
 #include "framework.h"
 #include "Humpback.h"
 #include "Renderer.h"
+#include "MeshCooker.h"
 
 #define MAX_LOADSTRING 100
 
@@ -21,6 +24,7 @@ LRESULT CALLBACK    WndProc(HWND, UINT, WPARAM, LPARAM);
 INT_PTR CALLBACK    About(HWND, UINT, WPARAM, LPARAM);
 
 void ShutDownEngine();
+bool CookAssetsFromCommandLine(int& exitCode);
 
 namespace 
 {
@@ -38,6 +42,12 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     UNREFERENCED_PARAMETER(hPrevInstance);
     UNREFERENCED_PARAMETER(lpCmdLine);
 
+    int cookExitCode = 0;
+    if (CookAssetsFromCommandLine(cookExitCode))
+    {
+        return cookExitCode;
+    }
+
     // Initialize global strings
     LoadStringW(hInstance, IDS_APP_TITLE, szTitle, MAX_LOADSTRING);
     LoadStringW(hInstance, IDC_HUMPBACK, szWindowClass, MAX_LOADSTRING);
@@ -80,6 +90,40 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 
 
 
+//
+//  FUNCTION: CookAssetsFromCommandLine(int&)
+//
+//  PURPOSE: Offline cooking, "Humpback.exe -cook a.fbx b.fbx" imports the meshes into the asset cache
+//           and exits without creating a window or a device. Returns false if -cook isn't given.
+//
+bool CookAssetsFromCommandLine(int& exitCode)
+{
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv == nullptr || argc < 2 || wcscmp(argv[1], L"-cook") != 0)
+    {
+        LocalFree(argv);
+        return false;
+    }
+
+    Humpback::AssetCache cache(Humpback::AssetCache::DEFAULT_DIRECTORY);
+    Humpback::JobSystem jobSystem;
+
+    exitCode = 0;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string sourcePath = std::filesystem::path(argv[i]).string();
+        if (Humpback::MeshCooker::CookToCache(sourcePath, cache, &jobSystem) == false)
+        {
+            OutputDebugStringW((std::wstring(L"Failed to cook ") + argv[i] + L"\n").c_str());
+            exitCode = 1;
+        }
+    }
+
+    LocalFree(argv);
+    return true;
+}
+
 //
 //  FUNCTION: MyRegisterClass()
 //
@@ -0,0 +1,1003 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "ImageDecoder.h"
+
+
+namespace Humpback
+{
+	namespace
+	{
+		const uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+		// D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION, nothing larger could be created anyway.
+		const uint32_t MAX_IMAGE_DIMENSION = 16384;
+
+		uint32_t ReadBigEndian32(const uint8_t* p)
+		{
+			return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+		}
+
+		// Little endian bit stream as deflate defines it. Reading past the end yields zero bits, Overran tells.
+		class BitReader
+		{
+		public:
+
+			BitReader(const uint8_t* data, size_t size) :
+				m_cur(data), m_end(data + size)
+			{
+			}
+
+			uint32_t Peek(int count)
+			{
+				_refill();
+				return (uint32_t)(m_bits & ((1ull << count) - 1));
+			}
+
+			void Consume(int count)
+			{
+				m_bits >>= count;
+				m_bitCount -= count;
+			}
+
+			uint32_t Get(int count)
+			{
+				uint32_t value = Peek(count);
+				Consume(count);
+				return value;
+			}
+
+			void AlignToByte()
+			{
+				Consume(m_bitCount & 7);
+			}
+
+			bool Overran() const
+			{
+				return m_bitCount < m_paddingBytes * 8;
+			}
+
+		private:
+
+			void _refill()
+			{
+				while (m_bitCount <= 56)
+				{
+					uint64_t byte = 0;
+					if (m_cur < m_end)
+					{
+						byte = *m_cur++;
+					}
+					else
+					{
+						m_paddingBytes++;
+					}
+
+					m_bits |= byte << m_bitCount;
+					m_bitCount += 8;
+				}
+			}
+
+			const uint8_t* m_cur;
+			const uint8_t* m_end;
+			uint64_t m_bits = 0;
+			int m_bitCount = 0;
+			int m_paddingBytes = 0;
+		};
+
+		// Canonical Huffman code. Codes up to FAST_BITS long are resolved with one table lookup,
+		// longer ones are walked bit by bit.
+		class HuffmanTable
+		{
+		public:
+
+			static const int MAX_BITS = 15;
+			static const int FAST_BITS = 10;
+
+			bool Build(const uint8_t* lengths, int symbolCount)
+			{
+				std::memset(m_counts, 0, sizeof(m_counts));
+				for (int i = 0; i < symbolCount; i++)
+				{
+					m_counts[lengths[i]]++;
+				}
+				m_counts[0] = 0;
+
+				// Over-subscribed sets can't be decoded. Incomplete ones are legal, unused codes fail at decode time.
+				int left = 1;
+				for (int len = 1; len <= MAX_BITS; len++)
+				{
+					left = (left << 1) - m_counts[len];
+					if (left < 0)
+					{
+						return false;
+					}
+				}
+
+				uint16_t offsets[MAX_BITS + 1];
+				offsets[1] = 0;
+				for (int len = 1; len < MAX_BITS; len++)
+				{
+					offsets[len + 1] = offsets[len] + m_counts[len];
+				}
+
+				for (int i = 0; i < symbolCount; i++)
+				{
+					if (lengths[i] != 0)
+					{
+						m_symbols[offsets[lengths[i]]++] = (uint16_t)i;
+					}
+				}
+
+				std::memset(m_fast, 0, sizeof(m_fast));
+
+				uint32_t code = 0;
+				int index = 0;
+				for (int len = 1; len <= FAST_BITS; len++)
+				{
+					for (int i = 0; i < m_counts[len]; i++, code++, index++)
+					{
+						// Deflate sends codes most significant bit first, the table is indexed by the stream order.
+						uint32_t reversed = 0;
+						for (int bit = 0; bit < len; bit++)
+						{
+							reversed |= ((code >> bit) & 1) << (len - 1 - bit);
+						}
+
+						uint16_t entry = (uint16_t)((m_symbols[index] << 4) | len);
+						for (uint32_t fill = reversed; fill < (1u << FAST_BITS); fill += 1u << len)
+						{
+							m_fast[fill] = entry;
+						}
+					}
+					code <<= 1;
+				}
+
+				return true;
+			}
+
+			// Returns -1 for a code that isn't in the table.
+			int Decode(BitReader& reader) const
+			{
+				uint16_t entry = m_fast[reader.Peek(FAST_BITS)];
+				if (entry != 0)
+				{
+					reader.Consume(entry & 15);
+					return entry >> 4;
+				}
+
+				int code = 0;
+				int first = 0;
+				int index = 0;
+				for (int len = 1; len <= MAX_BITS; len++)
+				{
+					code |= (int)reader.Get(1);
+					int count = m_counts[len];
+					if (code - count < first)
+					{
+						return m_symbols[index + (code - first)];
+					}
+
+					index += count;
+					first = (first + count) << 1;
+					code <<= 1;
+				}
+
+				return -1;
+			}
+
+		private:
+
+			uint16_t m_counts[MAX_BITS + 1];
+			uint16_t m_symbols[288];
+			uint16_t m_fast[1 << FAST_BITS];
+		};
+
+		const uint16_t LENGTH_BASE[29] =
+		{
+			3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+			35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+		};
+		const uint8_t LENGTH_EXTRA[29] =
+		{
+			0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+			3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+		};
+		const uint16_t DIST_BASE[30] =
+		{
+			1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+			257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+		};
+		const uint8_t DIST_EXTRA[30] =
+		{
+			0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+			7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+		};
+
+		bool InflateBlock(BitReader& reader, const HuffmanTable& litLen, const HuffmanTable& dist,
+			uint8_t* out, size_t outSize, size_t& outPos)
+		{
+			while (true)
+			{
+				int symbol = litLen.Decode(reader);
+				if (symbol < 0)
+				{
+					return false;
+				}
+
+				if (symbol < 256)
+				{
+					if (outPos >= outSize)
+					{
+						return false;
+					}
+					out[outPos++] = (uint8_t)symbol;
+					continue;
+				}
+
+				if (symbol == 256)
+				{
+					return reader.Overran() == false;
+				}
+
+				symbol -= 257;
+				if (symbol >= 29)
+				{
+					return false;
+				}
+				size_t length = LENGTH_BASE[symbol] + reader.Get(LENGTH_EXTRA[symbol]);
+
+				int distSymbol = dist.Decode(reader);
+				if (distSymbol < 0 || distSymbol >= 30)
+				{
+					return false;
+				}
+				size_t distance = DIST_BASE[distSymbol] + reader.Get(DIST_EXTRA[distSymbol]);
+
+				if (distance > outPos || length > outSize - outPos)
+				{
+					return false;
+				}
+
+				const uint8_t* src = out + outPos - distance;
+				uint8_t* dst = out + outPos;
+				if (distance >= length)
+				{
+					std::memcpy(dst, src, length);
+				}
+				else
+				{
+					// The source overlaps the bytes being written, which repeats them.
+					for (size_t i = 0; i < length; i++)
+					{
+						dst[i] = src[i];
+					}
+				}
+				outPos += length;
+			}
+		}
+
+		bool BuildDynamicTables(BitReader& reader, HuffmanTable& litLen, HuffmanTable& dist)
+		{
+			static const uint8_t ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+			int litLenCount = (int)reader.Get(5) + 257;
+			int distCount = (int)reader.Get(5) + 1;
+			int codeLengthCount = (int)reader.Get(4) + 4;
+			if (litLenCount > 286 || distCount > 30)
+			{
+				return false;
+			}
+
+			uint8_t codeLengthLengths[19] = {};
+			for (int i = 0; i < codeLengthCount; i++)
+			{
+				codeLengthLengths[ORDER[i]] = (uint8_t)reader.Get(3);
+			}
+
+			HuffmanTable codeLengths;
+			if (codeLengths.Build(codeLengthLengths, 19) == false)
+			{
+				return false;
+			}
+
+			uint8_t lengths[286 + 30] = {};
+			int count = 0;
+			while (count < litLenCount + distCount)
+			{
+				int symbol = codeLengths.Decode(reader);
+				if (symbol < 0)
+				{
+					return false;
+				}
+
+				if (symbol < 16)
+				{
+					lengths[count++] = (uint8_t)symbol;
+					continue;
+				}
+
+				uint8_t value = 0;
+				int repeat = 0;
+				if (symbol == 16)
+				{
+					if (count == 0)
+					{
+						return false;
+					}
+					value = lengths[count - 1];
+					repeat = 3 + (int)reader.Get(2);
+				}
+				else if (symbol == 17)
+				{
+					repeat = 3 + (int)reader.Get(3);
+				}
+				else
+				{
+					repeat = 11 + (int)reader.Get(7);
+				}
+
+				if (count + repeat > litLenCount + distCount)
+				{
+					return false;
+				}
+				std::fill(lengths + count, lengths + count + repeat, value);
+				count += repeat;
+			}
+
+			// Without an end of block code the block could never finish.
+			if (lengths[256] == 0)
+			{
+				return false;
+			}
+
+			return litLen.Build(lengths, litLenCount) && dist.Build(lengths + litLenCount, distCount);
+		}
+
+		// Inflates a zlib stream whose decompressed size is known up front, anything else is an error.
+		bool Inflate(const uint8_t* data, size_t size, uint8_t* out, size_t outSize, std::string& error)
+		{
+			if (size < 6 || (data[0] & 0x0f) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20) != 0)
+			{
+				error = "unsupported zlib header";
+				return false;
+			}
+
+			BitReader reader(data + 2, size - 6);
+			HuffmanTable litLen;
+			HuffmanTable dist;
+			size_t outPos = 0;
+
+			bool final = false;
+			while (final == false)
+			{
+				final = reader.Get(1) != 0;
+				uint32_t type = reader.Get(2);
+
+				bool ok = false;
+				if (type == 0)
+				{
+					reader.AlignToByte();
+					uint32_t length = reader.Get(16);
+					uint32_t lengthComplement = reader.Get(16);
+
+					ok = (length ^ 0xffff) == lengthComplement && length <= outSize - outPos;
+					for (uint32_t i = 0; ok && i < length; i++)
+					{
+						out[outPos++] = (uint8_t)reader.Get(8);
+					}
+					ok = ok && reader.Overran() == false;
+				}
+				else if (type == 1)
+				{
+					uint8_t lengths[288 + 30];
+					std::fill(lengths, lengths + 144, (uint8_t)8);
+					std::fill(lengths + 144, lengths + 256, (uint8_t)9);
+					std::fill(lengths + 256, lengths + 280, (uint8_t)7);
+					std::fill(lengths + 280, lengths + 288, (uint8_t)8);
+					std::fill(lengths + 288, lengths + 318, (uint8_t)5);
+
+					ok = litLen.Build(lengths, 288) && dist.Build(lengths + 288, 30) &&
+						InflateBlock(reader, litLen, dist, out, outSize, outPos);
+				}
+				else if (type == 2)
+				{
+					ok = BuildDynamicTables(reader, litLen, dist) &&
+						InflateBlock(reader, litLen, dist, out, outSize, outPos);
+				}
+
+				if (ok == false)
+				{
+					error = "corrupt deflate stream";
+					return false;
+				}
+			}
+
+			if (outPos != outSize)
+			{
+				error = "image data is truncated";
+				return false;
+			}
+
+			uint32_t a = 1;
+			uint32_t b = 0;
+			for (size_t i = 0; i < outSize;)
+			{
+				// 5552 bytes is the most that can be summed before b may overflow.
+				size_t end = std::min(outSize, i + 5552);
+				for (; i < end; i++)
+				{
+					a += out[i];
+					b += a;
+				}
+				a %= 65521;
+				b %= 65521;
+			}
+
+			if (((b << 16) | a) != ReadBigEndian32(data + size - 4))
+			{
+				error = "image data checksum mismatch";
+				return false;
+			}
+
+			return true;
+		}
+
+		uint8_t PaethPredictor(int a, int b, int c)
+		{
+			int p = a + b - c;
+			int pa = std::abs(p - a);
+			int pb = std::abs(p - b);
+			int pc = std::abs(p - c);
+			if (pa <= pb && pa <= pc)
+			{
+				return (uint8_t)a;
+			}
+			return (uint8_t)(pb <= pc ? b : c);
+		}
+
+		// Undoes the per row filters in place. Each row keeps its leading filter byte.
+		bool Unfilter(uint8_t* data, uint32_t height, size_t rowSize, size_t bytesPerPixel)
+		{
+			// The row above the first one reads as zeros, that keeps the loops free of edge checks.
+			std::vector<uint8_t> zeroRow(rowSize, 0);
+			const uint8_t* prior = zeroRow.data();
+			const size_t bpp = std::min(bytesPerPixel, rowSize);
+
+			for (uint32_t y = 0; y < height; y++)
+			{
+				uint8_t filter = data[0];
+				uint8_t* row = data + 1;
+
+				switch (filter)
+				{
+				case 0:
+					break;
+
+				case 1:
+					for (size_t i = bpp; i < rowSize; i++)
+					{
+						row[i] = (uint8_t)(row[i] + row[i - bpp]);
+					}
+					break;
+
+				case 2:
+					for (size_t i = 0; i < rowSize; i++)
+					{
+						row[i] = (uint8_t)(row[i] + prior[i]);
+					}
+					break;
+
+				case 3:
+					for (size_t i = 0; i < bpp; i++)
+					{
+						row[i] = (uint8_t)(row[i] + (prior[i] >> 1));
+					}
+					for (size_t i = bpp; i < rowSize; i++)
+					{
+						row[i] = (uint8_t)(row[i] + ((row[i - bpp] + prior[i]) >> 1));
+					}
+					break;
+
+				case 4:
+					// With no left neighbour Paeth picks the byte above.
+					for (size_t i = 0; i < bpp; i++)
+					{
+						row[i] = (uint8_t)(row[i] + prior[i]);
+					}
+					for (size_t i = bpp; i < rowSize; i++)
+					{
+						row[i] = (uint8_t)(row[i] + PaethPredictor(row[i - bpp], prior[i], prior[i - bpp]));
+					}
+					break;
+
+				default:
+					return false;
+				}
+
+				prior = row;
+				data += rowSize + 1;
+			}
+
+			return true;
+		}
+
+		struct PngInfo
+		{
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t bitDepth = 0;
+			uint32_t colorType = 0;
+			uint32_t channels = 0;
+			bool srgb = false;
+
+			uint8_t palette[256][4] = {};
+			uint32_t paletteSize = 0;
+		};
+
+		// Expands unfiltered rows into the output layout.
+		void ConvertRows(const PngInfo& info, const uint8_t* src, size_t rowSize, DecodedImage& image)
+		{
+			const uint32_t width = info.width;
+			const uint32_t depth = info.bitDepth;
+			uint8_t* dst = image.pixels.data();
+
+			for (uint32_t y = 0; y < info.height; y++, src += rowSize + 1)
+			{
+				const uint8_t* row = src + 1;
+
+				if (depth < 8)
+				{
+					// Packed gray or palette indices, most significant bits first.
+					const uint32_t mask = (1u << depth) - 1;
+					const uint32_t scale = 255 / mask;
+					for (uint32_t x = 0; x < width; x++)
+					{
+						uint32_t bit = x * depth;
+						uint32_t value = (row[bit >> 3] >> (8 - depth - (bit & 7))) & mask;
+
+						if (info.colorType == 3)
+						{
+							std::memcpy(dst, info.palette[value], 4);
+							dst += 4;
+						}
+						else
+						{
+							*dst++ = (uint8_t)(value * scale);
+						}
+					}
+				}
+				else if (info.colorType == 3)
+				{
+					for (uint32_t x = 0; x < width; x++, dst += 4)
+					{
+						std::memcpy(dst, info.palette[row[x]], 4);
+					}
+				}
+				else if (depth == 8)
+				{
+					switch (info.colorType)
+					{
+					case 0:
+					case 6:
+						std::memcpy(dst, row, (size_t)width * info.channels);
+						dst += (size_t)width * info.channels;
+						break;
+
+					case 2:
+						for (uint32_t x = 0; x < width; x++, row += 3, dst += 4)
+						{
+							dst[0] = row[0];
+							dst[1] = row[1];
+							dst[2] = row[2];
+							dst[3] = 0xff;
+						}
+						break;
+
+					case 4:
+						for (uint32_t x = 0; x < width; x++, row += 2, dst += 4)
+						{
+							dst[0] = dst[1] = dst[2] = row[0];
+							dst[3] = row[1];
+						}
+						break;
+					}
+				}
+				else
+				{
+					uint16_t* out = (uint16_t*)dst;
+					auto sample = [row](uint32_t i) { return (uint16_t)((row[i * 2] << 8) | row[i * 2 + 1]); };
+
+					switch (info.colorType)
+					{
+					case 0:
+					case 6:
+						for (uint32_t i = 0; i < width * info.channels; i++)
+						{
+							*out++ = sample(i);
+						}
+						break;
+
+					case 2:
+						for (uint32_t x = 0; x < width; x++, out += 4)
+						{
+							out[0] = sample(x * 3 + 0);
+							out[1] = sample(x * 3 + 1);
+							out[2] = sample(x * 3 + 2);
+							out[3] = 0xffff;
+						}
+						break;
+
+					case 4:
+						for (uint32_t x = 0; x < width; x++, out += 4)
+						{
+							out[0] = out[1] = out[2] = sample(x * 2);
+							out[3] = sample(x * 2 + 1);
+						}
+						break;
+					}
+
+					dst = (uint8_t*)out;
+				}
+			}
+		}
+
+		template<typename T>
+		void ResizeArea(const T* src, uint32_t width, uint32_t height, uint32_t channels,
+			T* dst, uint32_t targetWidth, uint32_t targetHeight)
+		{
+			const double scaleX = (double)width / targetWidth;
+			const double scaleY = (double)height / targetHeight;
+
+			// Source span and edge weights of every target column, shared by all rows.
+			struct Span
+			{
+				uint32_t first;
+				uint32_t last;
+				float firstWeight;
+				float lastWeight;
+			};
+
+			auto computeSpans = [](uint32_t count, double scale)
+			{
+				std::vector<Span> spans(count);
+				for (uint32_t i = 0; i < count; i++)
+				{
+					double begin = i * scale;
+					double end = (i + 1) * scale;
+					Span& span = spans[i];
+					span.first = (uint32_t)begin;
+					span.last = std::max(span.first, (uint32_t)std::ceil(end) - 1);
+					span.firstWeight = (float)(std::min(end, span.first + 1.0) - begin);
+					span.lastWeight = span.last == span.first ? span.firstWeight : (float)(end - span.last);
+				}
+				return spans;
+			};
+
+			std::vector<Span> columns = computeSpans(targetWidth, scaleX);
+			std::vector<Span> rows = computeSpans(targetHeight, scaleY);
+
+			// Horizontal pass into floats, then the vertical pass writes the target.
+			std::vector<float> horizontal((size_t)targetWidth * height * channels);
+			for (uint32_t y = 0; y < height; y++)
+			{
+				const T* srcRow = src + (size_t)y * width * channels;
+				float* dstRow = horizontal.data() + (size_t)y * targetWidth * channels;
+
+				for (uint32_t x = 0; x < targetWidth; x++)
+				{
+					const Span& span = columns[x];
+					for (uint32_t c = 0; c < channels; c++)
+					{
+						float sum = srcRow[(size_t)span.first * channels + c] * span.firstWeight;
+						for (uint32_t i = span.first + 1; i < span.last; i++)
+						{
+							sum += srcRow[(size_t)i * channels + c];
+						}
+						if (span.last != span.first)
+						{
+							sum += srcRow[(size_t)span.last * channels + c] * span.lastWeight;
+						}
+						dstRow[(size_t)x * channels + c] = sum;
+					}
+				}
+			}
+
+			const float maxValue = (float)(T)~T(0);
+			const float normalize = (float)(1.0 / (scaleX * scaleY));
+			const size_t rowLength = (size_t)targetWidth * channels;
+			std::vector<float> sums(rowLength);
+
+			for (uint32_t y = 0; y < targetHeight; y++)
+			{
+				const Span& span = rows[y];
+				for (size_t i = 0; i < rowLength; i++)
+				{
+					sums[i] = horizontal[span.first * rowLength + i] * span.firstWeight;
+				}
+				for (uint32_t j = span.first + 1; j < span.last; j++)
+				{
+					for (size_t i = 0; i < rowLength; i++)
+					{
+						sums[i] += horizontal[j * rowLength + i];
+					}
+				}
+				if (span.last != span.first)
+				{
+					for (size_t i = 0; i < rowLength; i++)
+					{
+						sums[i] += horizontal[span.last * rowLength + i] * span.lastWeight;
+					}
+				}
+
+				T* dstRow = dst + (size_t)y * rowLength;
+				for (size_t i = 0; i < rowLength; i++)
+				{
+					dstRow[i] = (T)std::min(maxValue, sums[i] * normalize + 0.5f);
+				}
+			}
+		}
+	}
+
+	uint32_t GetImageFormatPixelSize(ImageFormat format)
+	{
+		switch (format)
+		{
+		case ImageFormat::R8:		return 1;
+		case ImageFormat::R16:		return 2;
+		case ImageFormat::RGBA8:	return 4;
+		case ImageFormat::RGBA16:	return 8;
+		}
+		return 0;
+	}
+
+	ImageMipLayout GetImageMipLayout(uint32_t width, uint32_t height, ImageFormat format, uint32_t level)
+	{
+		ImageMipLayout layout = {};
+		for (uint32_t i = 0; i <= level; i++)
+		{
+			layout.offset += layout.slicePitch;
+			layout.width = std::max(1u, width >> i);
+			layout.height = std::max(1u, height >> i);
+			layout.rowPitch = (uint64_t)layout.width * GetImageFormatPixelSize(format);
+			layout.slicePitch = layout.rowPitch * layout.height;
+		}
+		return layout;
+	}
+
+	uint64_t GetImageByteSize(uint32_t width, uint32_t height, ImageFormat format, uint32_t mipLevels)
+	{
+		if (mipLevels == 0)
+		{
+			return 0;
+		}
+
+		ImageMipLayout last = GetImageMipLayout(width, height, format, mipLevels - 1);
+		return last.offset + last.slicePitch;
+	}
+
+	uint32_t GetFullMipCount(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+		{
+			levels++;
+		}
+		return levels;
+	}
+
+	bool DecodePng(const uint8_t* data, uint64_t size, DecodedImage& image, std::string& error)
+	{
+		if (size < sizeof(PNG_SIGNATURE) || std::memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0)
+		{
+			error = "not a PNG file";
+			return false;
+		}
+
+		PngInfo info;
+		bool hasHeader = false;
+		bool interlaced = false;
+		std::vector<uint8_t> compressed;
+
+		uint64_t pos = sizeof(PNG_SIGNATURE);
+		while (true)
+		{
+			if (size - pos < 12)
+			{
+				error = "truncated chunk";
+				return false;
+			}
+
+			uint32_t length = ReadBigEndian32(data + pos);
+			const uint8_t* type = data + pos + 4;
+			const uint8_t* body = data + pos + 8;
+			if (length > size - pos - 12)
+			{
+				error = "truncated chunk";
+				return false;
+			}
+			pos += 12 + (uint64_t)length;
+
+			// Chunk CRCs are not checked, the Adler-32 of the zlib stream covers the pixel data.
+			if (std::memcmp(type, "IHDR", 4) == 0)
+			{
+				if (length != 13)
+				{
+					error = "bad IHDR";
+					return false;
+				}
+
+				info.width = ReadBigEndian32(body);
+				info.height = ReadBigEndian32(body + 4);
+				info.bitDepth = body[8];
+				info.colorType = body[9];
+				interlaced = body[12] != 0;
+				hasHeader = true;
+
+				static const uint32_t CHANNELS[7] = { 1, 0, 3, 1, 2, 0, 4 };
+				info.channels = info.colorType < 7 ? CHANNELS[info.colorType] : 0;
+
+				bool validDepth = false;
+				switch (info.colorType)
+				{
+				case 0: validDepth = info.bitDepth == 1 || info.bitDepth == 2 || info.bitDepth == 4 || info.bitDepth == 8 || info.bitDepth == 16; break;
+				case 3: validDepth = info.bitDepth == 1 || info.bitDepth == 2 || info.bitDepth == 4 || info.bitDepth == 8; break;
+				case 2:
+				case 4:
+				case 6: validDepth = info.bitDepth == 8 || info.bitDepth == 16; break;
+				}
+
+				if (info.channels == 0 || validDepth == false || body[10] != 0 || body[11] != 0)
+				{
+					error = "unsupported IHDR";
+					return false;
+				}
+				if (info.width == 0 || info.height == 0 || info.width > MAX_IMAGE_DIMENSION || info.height > MAX_IMAGE_DIMENSION)
+				{
+					error = "unsupported image size";
+					return false;
+				}
+			}
+			else if (std::memcmp(type, "PLTE", 4) == 0)
+			{
+				info.paletteSize = std::min(length / 3, 256u);
+				for (uint32_t i = 0; i < info.paletteSize; i++)
+				{
+					info.palette[i][0] = body[i * 3 + 0];
+					info.palette[i][1] = body[i * 3 + 1];
+					info.palette[i][2] = body[i * 3 + 2];
+					info.palette[i][3] = 0xff;
+				}
+			}
+			else if (std::memcmp(type, "tRNS", 4) == 0)
+			{
+				// Only palette transparency is applied, color key transparency is rare enough to ignore.
+				for (uint32_t i = 0; info.colorType == 3 && i < std::min(length, 256u); i++)
+				{
+					info.palette[i][3] = body[i];
+				}
+			}
+			else if (std::memcmp(type, "sRGB", 4) == 0)
+			{
+				info.srgb = true;
+			}
+			else if (std::memcmp(type, "gAMA", 4) == 0 && length == 4)
+			{
+				info.srgb = info.srgb || ReadBigEndian32(body) == 45455;
+			}
+			else if (std::memcmp(type, "IDAT", 4) == 0)
+			{
+				compressed.insert(compressed.end(), body, body + length);
+			}
+			else if (std::memcmp(type, "IEND", 4) == 0)
+			{
+				break;
+			}
+			else if ((type[0] & 0x20) == 0)
+			{
+				error = "unknown critical chunk";
+				return false;
+			}
+		}
+
+		if (hasHeader == false || compressed.empty())
+		{
+			error = "missing IHDR or IDAT";
+			return false;
+		}
+		if (interlaced)
+		{
+			error = "interlaced PNGs are not supported";
+			return false;
+		}
+		if (info.colorType == 3 && info.paletteSize == 0)
+		{
+			error = "missing PLTE";
+			return false;
+		}
+
+		const size_t bitsPerPixel = (size_t)info.bitDepth * info.channels;
+		const size_t rowSize = (info.width * bitsPerPixel + 7) / 8;
+		const size_t bytesPerPixel = std::max<size_t>(1, bitsPerPixel / 8);
+
+		std::vector<uint8_t> filtered((rowSize + 1) * info.height);
+		if (Inflate(compressed.data(), compressed.size(), filtered.data(), filtered.size(), error) == false)
+		{
+			return false;
+		}
+		compressed = std::vector<uint8_t>();
+
+		if (Unfilter(filtered.data(), info.height, rowSize, bytesPerPixel) == false)
+		{
+			error = "bad row filter";
+			return false;
+		}
+
+		image.width = info.width;
+		image.height = info.height;
+		if (info.colorType == 0)
+		{
+			image.format = info.bitDepth == 16 ? ImageFormat::R16 : ImageFormat::R8;
+		}
+		else
+		{
+			image.format = info.bitDepth == 16 ? ImageFormat::RGBA16 : ImageFormat::RGBA8;
+		}
+		image.srgb = info.srgb && image.format == ImageFormat::RGBA8;
+		image.mipLevels = 1;
+		image.pixels.resize(image.GetRowPitch() * image.height);
+
+		ConvertRows(info, filtered.data(), rowSize, image);
+		return true;
+	}
+
+	void FitImageToSize(DecodedImage& image, uint32_t maxSize)
+	{
+		if (maxSize == 0 || (image.width <= maxSize && image.height <= maxSize))
+		{
+			return;
+		}
+
+		uint32_t targetWidth = maxSize;
+		uint32_t targetHeight = maxSize;
+		const float aspectRatio = (float)image.height / (float)image.width;
+		if (image.width > image.height)
+		{
+			targetHeight = std::max<uint32_t>(1, (uint32_t)((float)maxSize * aspectRatio));
+		}
+		else
+		{
+			targetWidth = std::max<uint32_t>(1, (uint32_t)((float)maxSize / aspectRatio));
+		}
+
+		DecodedImage resized;
+		resized.width = targetWidth;
+		resized.height = targetHeight;
+		resized.format = image.format;
+		resized.srgb = image.srgb;
+		resized.pixels.resize(resized.GetRowPitch() * targetHeight);
+
+		switch (image.format)
+		{
+		case ImageFormat::R8:
+		case ImageFormat::RGBA8:
+			ResizeArea(image.pixels.data(), image.width, image.height, GetImageFormatPixelSize(image.format),
+				resized.pixels.data(), targetWidth, targetHeight);
+			break;
+
+		case ImageFormat::R16:
+		case ImageFormat::RGBA16:
+			ResizeArea((const uint16_t*)image.pixels.data(), image.width, image.height, GetImageFormatPixelSize(image.format) / 2,
+				(uint16_t*)resized.pixels.data(), targetWidth, targetHeight);
+			break;
+		}
+
+		image = std::move(resized);
+	}
+}
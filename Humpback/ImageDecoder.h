@@ -0,0 +1,67 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+namespace Humpback
+{
+	// Pixel layouts the decoder produces, chosen to match what the WIC loader picks for the same file:
+	// gray stays single channel, everything else is expanded to four channels of the source depth.
+	// 16 bit samples are little endian.
+	enum class ImageFormat : uint32_t
+	{
+		R8 = 0,
+		R16,
+		RGBA8,
+		RGBA16,
+	};
+
+	uint32_t GetImageFormatPixelSize(ImageFormat format);
+
+
+	// Mip levels are stored one after another, largest first, with tightly packed rows.
+	struct ImageMipLayout
+	{
+		uint32_t width;
+		uint32_t height;
+		uint64_t offset;
+		uint64_t rowPitch;
+		uint64_t slicePitch;
+	};
+
+	ImageMipLayout GetImageMipLayout(uint32_t width, uint32_t height, ImageFormat format, uint32_t level);
+	uint64_t GetImageByteSize(uint32_t width, uint32_t height, ImageFormat format, uint32_t mipLevels);
+	// Levels down to 1x1.
+	uint32_t GetFullMipCount(uint32_t width, uint32_t height);
+
+
+	struct DecodedImage
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		ImageFormat format = ImageFormat::RGBA8;
+		// Only meaningful for RGBA8, the other formats have no sRGB variant.
+		bool srgb = false;
+		uint32_t mipLevels = 1;
+		// Every mip level, laid out as GetImageMipLayout describes.
+		std::vector<uint8_t> pixels;
+
+		// Of level 0.
+		uint64_t GetRowPitch() const { return (uint64_t)width * GetImageFormatPixelSize(format); }
+	};
+
+
+	// Decodes a non-interlaced PNG of any color type and bit depth. The image is flagged sRGB when the file
+	// has an sRGB chunk or a 1/2.2 gAMA chunk, as the WIC loader does. Returns false and fills error on failure.
+	bool DecodePng(const uint8_t* data, uint64_t size, DecodedImage& image, std::string& error);
+
+	// Area-averages level 0 down until neither side exceeds maxSize and drops the other levels. The target size
+	// keeps the aspect ratio the same way the WIC loader computes it. Does nothing if level 0 already fits.
+	void FitImageToSize(DecodedImage& image, uint32_t maxSize);
+}
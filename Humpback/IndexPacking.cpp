@@ -0,0 +1,173 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+
+#include "IndexPacking.h"
+
+
+namespace Humpback
+{
+	namespace
+	{
+		// A run of indices a batch boundary can't fall into.
+		struct Piece
+		{
+			uint32_t begin;
+			uint32_t end;
+			uint32_t meshletCount;
+		};
+
+		// The meshlets of the submesh when they tile it, its triangles otherwise.
+		std::vector<Piece> GetPieces(const IndexSubRange& subRange, const Meshlet* meshlets)
+		{
+			std::vector<Piece> pieces;
+			uint32_t end = subRange.startIndexLocation + subRange.indexCount;
+
+			uint32_t next = subRange.startIndexLocation;
+			for (uint32_t i = 0; meshlets != nullptr && i < subRange.meshletCount && next == meshlets[subRange.firstMeshlet + i].startIndexLocation; i++)
+			{
+				const Meshlet& meshlet = meshlets[subRange.firstMeshlet + i];
+				pieces.push_back({ meshlet.startIndexLocation, meshlet.startIndexLocation + meshlet.indexCount, 1 });
+				next += meshlet.indexCount;
+			}
+
+			if (subRange.meshletCount > 0 && pieces.size() == subRange.meshletCount && next == end)
+			{
+				return pieces;
+			}
+
+			pieces.clear();
+			for (uint32_t i = subRange.startIndexLocation; i < end; i += 3)
+			{
+				pieces.push_back({ i, std::min(i + 3, end), 0 });
+			}
+			return pieces;
+		}
+	}
+
+	bool PackIndices16(const uint32_t* indices, size_t indexCount, const Meshlet* meshlets,
+		std::vector<IndexSubRange>& subRanges, std::vector<uint16_t>& indices16, std::vector<IndexBatch>& batches)
+	{
+		indices16.assign(indexCount, 0);
+		batches.clear();
+
+		// Submeshes may share indices, they must then agree on the values. Indices outside every submesh are
+		// never drawn and stay 0.
+		std::vector<bool> written(indexCount, false);
+		auto write = [&](uint32_t first, uint32_t end, uint32_t vertexOffset)
+		{
+			for (uint32_t i = first; i < end; i++)
+			{
+				uint16_t value = (uint16_t)(indices[i] - vertexOffset);
+				if (written[i] && indices16[i] != value)
+				{
+					return false;
+				}
+				indices16[i] = value;
+				written[i] = true;
+			}
+			return true;
+		};
+
+		auto fail = [&]()
+		{
+			indices16.clear();
+			batches.clear();
+			return false;
+		};
+
+		for (IndexSubRange& subRange : subRanges)
+		{
+			subRange.firstBatch = (uint32_t)batches.size();
+			subRange.batchCount = 0;
+
+			uint32_t end = subRange.startIndexLocation + subRange.indexCount;
+			if (end < subRange.startIndexLocation || end > indexCount)
+			{
+				return fail();
+			}
+
+			uint32_t maxIndex = 0;
+			for (uint32_t i = subRange.startIndexLocation; i < end; i++)
+			{
+				maxIndex = std::max(maxIndex, indices[i]);
+			}
+
+			if (maxIndex < INDEX16_MAX_VERTICES)
+			{
+				if (write(subRange.startIndexLocation, end, 0) == false)
+				{
+					return fail();
+				}
+				continue;
+			}
+
+			// Grow the batch piece by piece while its vertices fit one 16 bit window.
+			IndexBatch batch = {};
+			uint32_t batchMin = 0;
+			uint32_t batchMax = 0;
+			uint32_t meshletIndex = 0;
+
+			auto close = [&]()
+			{
+				batch.vertexOffset = (int32_t)batchMin;
+				batches.push_back(batch);
+				subRange.batchCount++;
+				return write(batch.startIndexLocation, batch.startIndexLocation + batch.indexCount, batchMin);
+			};
+
+			for (const Piece& piece : GetPieces(subRange, meshlets))
+			{
+				uint32_t pieceMin = UINT32_MAX;
+				uint32_t pieceMax = 0;
+				for (uint32_t i = piece.begin; i < piece.end; i++)
+				{
+					pieceMin = std::min(pieceMin, indices[i]);
+					pieceMax = std::max(pieceMax, indices[i]);
+				}
+
+				if (pieceMax - pieceMin >= INDEX16_MAX_VERTICES)
+				{
+					return fail();
+				}
+
+				uint32_t newMin = std::min(batchMin, pieceMin);
+				uint32_t newMax = std::max(batchMax, pieceMax);
+				if (batch.indexCount > 0 && newMax - newMin >= INDEX16_MAX_VERTICES)
+				{
+					if (close() == false)
+					{
+						return fail();
+					}
+					batch = {};
+				}
+
+				if (batch.indexCount == 0)
+				{
+					batch.startIndexLocation = piece.begin;
+					batch.firstMeshlet = meshletIndex;
+					batchMin = pieceMin;
+					batchMax = pieceMax;
+				}
+				else
+				{
+					batchMin = newMin;
+					batchMax = newMax;
+				}
+
+				batch.indexCount += piece.end - piece.begin;
+				batch.meshletCount += piece.meshletCount;
+				meshletIndex += piece.meshletCount;
+			}
+
+			if (batch.indexCount > 0 && close() == false)
+			{
+				return fail();
+			}
+		}
+
+		return true;
+	}
+}
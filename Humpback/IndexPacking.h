@@ -0,0 +1,57 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "Meshlet.h"
+
+
+namespace Humpback
+{
+	// Vertices one 16 bit draw can address. 0xFFFF is kept free, it is the strip cut value.
+	const uint32_t INDEX16_MAX_VERTICES = 0xFFFF;
+
+
+	// Part of a submesh drawn on its own because the whole submesh spans too many vertices for 16 bit indices.
+	// Its indices are relative to the baseVertexLocation of the submesh plus vertexOffset. The layout is part
+	// of the cooked mesh format.
+	struct IndexBatch
+	{
+		uint32_t startIndexLocation;
+		uint32_t indexCount;
+		int32_t vertexOffset;
+
+		// Relative to the first meshlet of the submesh, a batch never cuts a meshlet.
+		uint32_t firstMeshlet;
+		uint32_t meshletCount;
+	};
+
+	static_assert(sizeof(IndexBatch) == 20, "IndexBatch is part of the cooked mesh format.");
+
+
+	// A submesh as seen by PackIndices16.
+	struct IndexSubRange
+	{
+		uint32_t startIndexLocation = 0;
+		uint32_t indexCount = 0;
+		uint32_t firstMeshlet = 0;
+		uint32_t meshletCount = 0;
+
+		// Range of the batches, empty when the submesh fits 16 bits as a whole.
+		uint32_t firstBatch = 0;
+		uint32_t batchCount = 0;
+	};
+
+
+	// Converts a 32 bit index buffer to 16 bit. Submeshes spanning more than INDEX16_MAX_VERTICES vertices are
+	// split into batches, cut between meshlets, or between triangles when the submesh has none, and their
+	// indices are rebased per batch. Returns false and leaves the outputs empty when a piece that can't be cut
+	// spans too many vertices on its own, the buffer then has to stay 32 bit. Nothing is ever truncated.
+	bool PackIndices16(const uint32_t* indices, size_t indexCount, const Meshlet* meshlets,
+		std::vector<IndexSubRange>& subRanges, std::vector<uint16_t>& indices16, std::vector<IndexBatch>& batches);
+}
@@ -0,0 +1,173 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <exception>
+
+#include "JobSystem.h"
+
+
+namespace Humpback
+{
+	JobSystem::JobSystem(unsigned int workerCount)
+	{
+		if (workerCount == 0)
+		{
+			unsigned int hwThreads = std::thread::hardware_concurrency();
+			workerCount = hwThreads > 1 ? hwThreads - 1 : 1;
+		}
+
+		for (unsigned int i = 0; i < workerCount; i++)
+		{
+			m_workers.emplace_back([this]() { _workerMain(); });
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_cv.notify_all();
+
+		for (auto& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	unsigned int JobSystem::GetThreadCount() const
+	{
+		return (unsigned int)m_workers.size() + 1;
+	}
+
+	std::future<void> JobSystem::Submit(std::function<void()> job)
+	{
+		auto task = std::make_shared<std::packaged_task<void()>>(std::move(job));
+		std::future<void> result = task->get_future();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queue.push_back([task]() { (*task)(); });
+		}
+		m_cv.notify_one();
+
+		return result;
+	}
+
+	void JobSystem::ParallelFor(unsigned int count, const std::function<void(unsigned int)>& job)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		if (count == 1)
+		{
+			job(0);
+			return;
+		}
+
+		std::atomic<unsigned int> remaining(count);
+		std::mutex doneMutex;
+		std::condition_variable doneCv;
+		std::exception_ptr firstError;
+
+		// An exception must not escape a worker, and the caller may only leave once no job
+		// references this frame any more. So the first one is kept and rethrown at the end.
+		auto runJob = [&](unsigned int i)
+		{
+			try
+			{
+				job(i);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> doneLock(doneMutex);
+				if (firstError == nullptr)
+				{
+					firstError = std::current_exception();
+				}
+			}
+		};
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (unsigned int i = 1; i < count; i++)
+			{
+				m_queue.push_back([&, i]()
+					{
+						runJob(i);
+
+						// Decrement under the lock so the caller cannot return while we still notify.
+						std::lock_guard<std::mutex> doneLock(doneMutex);
+						if (--remaining == 0)
+						{
+							doneCv.notify_one();
+						}
+					});
+			}
+		}
+		m_cv.notify_all();
+
+		runJob(0);
+		{
+			std::lock_guard<std::mutex> doneLock(doneMutex);
+			--remaining;
+		}
+
+		// Help with the queue while the workers finish the rest.
+		while (remaining > 0 && _runOne())
+		{
+		}
+
+		std::unique_lock<std::mutex> lock(doneMutex);
+		doneCv.wait(lock, [&]() { return remaining == 0; });
+
+		if (firstError != nullptr)
+		{
+			std::rethrow_exception(firstError);
+		}
+	}
+
+	void JobSystem::_workerMain()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_cv.wait(lock, [this]() { return m_quit || m_queue.empty() == false; });
+
+				if (m_quit && m_queue.empty())
+				{
+					return;
+				}
+
+				job = std::move(m_queue.front());
+				m_queue.pop_front();
+			}
+
+			job();
+		}
+	}
+
+	bool JobSystem::_runOne()
+	{
+		std::function<void()> job;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_queue.empty())
+			{
+				return false;
+			}
+
+			job = std::move(m_queue.front());
+			m_queue.pop_front();
+		}
+
+		job();
+		return true;
+	}
+}
@@ -0,0 +1,51 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <atomic>
+
+
+namespace Humpback
+{
+	// A small pool of worker threads.
+	// The thread calling ParallelFor takes part in the work instead of idling.
+	class JobSystem
+	{
+	public:
+
+		// workerCount == 0 picks one worker per hardware thread except the calling one.
+		explicit JobSystem(unsigned int workerCount = 0);
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+		~JobSystem();
+
+		// Number of threads that can run jobs concurrently, including the caller.
+		unsigned int GetThreadCount() const;
+
+		std::future<void> Submit(std::function<void()> job);
+
+		// Runs job(i) for i in [0, count) and returns once all of them finished.
+		// If jobs throw, the first exception is rethrown on the calling thread after the others finished.
+		void ParallelFor(unsigned int count, const std::function<void(unsigned int)>& job);
+
+	private:
+
+		void _workerMain();
+		bool _runOne();
+
+		std::vector<std::thread>			m_workers;
+		std::deque<std::function<void()>>	m_queue;
+		std::mutex							m_mutex;
+		std::condition_variable				m_cv;
+		bool								m_quit = false;
+	};
+}
@@ -0,0 +1,45 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+
+namespace Humpback
+{
+	// Read-only memory mapping of a whole file. The pages are faulted in by the OS on first touch,
+	// so callers can hand pointers into the file straight to the upload path without reading it first.
+	class MappedFile
+	{
+	public:
+
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Returns false if the file can't be opened or is empty.
+		bool Open(const std::string& path);
+		void Close();
+
+		bool IsOpen() const { return m_data != nullptr; }
+		const uint8_t* GetData() const { return m_data; }
+		uint64_t GetSize() const { return m_size; }
+
+	private:
+
+		const uint8_t* m_data = nullptr;
+		uint64_t m_size = 0;
+
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#else
+		int m_file = -1;
+#endif
+	};
+}
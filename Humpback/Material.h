@@ -32,11 +32,9 @@ namespace Humpback
 		std::string name;
 		
 		int matCBIdx = 0;
-		int diffuseSrvHeapIndex = 0;
-		int normalSrvHeapIndex = 0;
-		int metallicSmothnessSrvHeapIndex = 0;
-		
-		int numFramesDirty = FRAME_RESOURCE_COUNT;
+		unsigned int diffuseSrvHeapIndex = 0;
+		unsigned int normalSrvHeapIndex = 0;
+		unsigned int metallicSmothnessSrvHeapIndex = 0;
 
 		DirectX::XMFLOAT4 diffuseAlbedo = { 1.0f, 1.0f, 1.0f, 1.0f };
 
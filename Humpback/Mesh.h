@@ -12,6 +12,10 @@
 #include <d3d12.h>
 #include <DirectXCollision.h>
 
+#include "VertexPacking.h"
+#include "Meshlet.h"
+#include "IndexPacking.h"
+
 
 namespace Humpback 
 {
@@ -24,20 +28,28 @@ namespace Humpback
 		int baseVertexLocation;
 
 		DirectX::BoundingBox aabb;
+
+		// Maps packed positions back to object space, identity for float vertices.
+		PositionQuantization quantization;
+
+		// Range of Mesh::meshlets covering the submesh, empty when it has none.
+		unsigned int firstMeshlet = 0;
+		unsigned int meshletCount = 0;
+
+		// Range of Mesh::indexBatches, the submesh is drawn batch by batch when it has any.
+		unsigned int firstBatch = 0;
+		unsigned int batchCount = 0;
 	};
 
 	class Mesh
 	{
 	public:
 
-		Microsoft::WRL::ComPtr<ID3DBlob> vertexBufferCPU = nullptr;
-		Microsoft::WRL::ComPtr<ID3DBlob> indexBufferCPU = nullptr;
-
 		Microsoft::WRL::ComPtr<ID3D12Resource> vertexBufferGPU = nullptr;
 		Microsoft::WRL::ComPtr<ID3D12Resource> indexBufferGPU = nullptr;
 
-		Microsoft::WRL::ComPtr<ID3D12Resource> vertexBufferUploader = nullptr;
-		Microsoft::WRL::ComPtr<ID3D12Resource> indexBufferUploader = nullptr;
+		// Position only copy of the vertex buffer, used by the shadow pass.
+		Microsoft::WRL::ComPtr<ID3D12Resource> positionBufferGPU = nullptr;
 
 		// Data about the buffers.
 		unsigned int vertexByteStride = 0;
@@ -46,10 +58,19 @@ namespace Humpback
 
 		unsigned int indexBufferByteSize = 0;
 
+		unsigned int positionBufferByteSize = 0;
+		unsigned int positionByteStride = sizeof(DirectX::XMFLOAT3);
+
 		std::string Name;
 
 		std::unordered_map<std::string, SubMesh> drawArgs;
 
+		// Clusters of every submesh for the CPU cluster culler, in index buffer order.
+		std::vector<Meshlet> meshlets;
+
+		// Parts of the submeshes too large for one 16 bit draw.
+		std::vector<IndexBatch> indexBatches;
+
 		D3D12_VERTEX_BUFFER_VIEW VertexBufferView() const
 		{
 			D3D12_VERTEX_BUFFER_VIEW vbv;
@@ -59,6 +80,15 @@ namespace Humpback
 			return vbv;
 		}
 
+		D3D12_VERTEX_BUFFER_VIEW PositionBufferView() const
+		{
+			D3D12_VERTEX_BUFFER_VIEW vbv;
+			vbv.BufferLocation = positionBufferGPU->GetGPUVirtualAddress();
+			vbv.StrideInBytes = positionByteStride;
+			vbv.SizeInBytes = positionBufferByteSize;
+			return vbv;
+		}
+
 		D3D12_INDEX_BUFFER_VIEW IndexBufferView() const
 		{
 			D3D12_INDEX_BUFFER_VIEW ibv;
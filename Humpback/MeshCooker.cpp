@@ -0,0 +1,428 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+#include <cfloat>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+#include "assimp/Importer.hpp"
+#include "assimp/postprocess.h"
+#include "assimp/version.h"
+#include "MeshCooker.h"
+#include "JobSystem.h"
+#include "MeshOptimizer.h"
+
+#ifdef _MSC_VER
+#pragma comment(lib, "Assimp/lib/x64/assimp-vc143-mt.lib")
+#endif
+
+
+using namespace DirectX;
+
+
+namespace Humpback
+{
+	namespace
+	{
+		// Bump when the conversion changes what it produces, cached meshes are then re-imported.
+		const unsigned int COOKER_VERSION = 3;
+		// The FBX loader emits a vertex per face corner, joining them is what gives the vertex cache
+		// optimization shared vertices to work with.
+		const unsigned int IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_ConvertToLeftHanded;
+
+		// Vertices or faces converted by one job, small enough to spread a single large mesh over the workers.
+		const uint32_t CONVERSION_SLICE = 16384;
+	}
+
+	bool MeshCooker::Cook(const std::string& sourcePath, std::vector<uint8_t>& cookedBytes, JobSystem* pJobSystem)
+	{
+		Assimp::Importer importer;
+
+		const aiScene* pScene = importer.ReadFile(sourcePath, IMPORT_FLAGS);
+
+		if (pScene == nullptr)
+		{
+			return false;
+		}
+
+		return CookScene(pScene, cookedBytes, pJobSystem);
+	}
+
+	bool MeshCooker::CookScene(const aiScene* pScene, std::vector<uint8_t>& cookedBytes, JobSystem* pJobSystem)
+	{
+		std::vector<aiMesh*> nodeMeshes;
+		std::vector<uint32_t> meshNodes;
+		std::vector<CookedNode> nodes;
+		_processNode(pScene->mRootNode, CookedMeshFormat::NO_NODE, pScene, nodeMeshes, meshNodes, nodes);
+
+		// Phase one lays the scene out. A mesh shared by several nodes is converted once, every mesh gets
+		// its range of the shared buffers from the prefix sums of the counts.
+		std::unordered_map<const aiMesh*, uint32_t> meshIndices;
+		std::vector<uint32_t> meshOfNode(nodeMeshes.size());
+		std::vector<ImportedMesh> meshes;
+		for (size_t i = 0; i < nodeMeshes.size(); i++)
+		{
+			auto inserted = meshIndices.emplace(nodeMeshes[i], (uint32_t)meshes.size());
+			if (inserted.second)
+			{
+				meshes.emplace_back();
+				meshes.back().source = nodeMeshes[i];
+			}
+			meshOfNode[i] = inserted.first->second;
+		}
+
+		size_t vertexTotal = 0;
+		size_t indexTotal = 0;
+		for (ImportedMesh& mesh : meshes)
+		{
+			mesh.vertexCount = mesh.source->mNumVertices;
+			mesh.indexCount = _countTriangleIndices(mesh.source);
+			vertexTotal += mesh.vertexCount;
+			indexTotal += mesh.indexCount;
+		}
+
+		// Left uninitialized, the conversion writes every element.
+		std::unique_ptr<Vertex[]> vertices(new Vertex[vertexTotal]);
+		std::unique_ptr<uint32_t[]> indices(new uint32_t[indexTotal]);
+		std::unique_ptr<XMFLOAT3[]> positions(new XMFLOAT3[vertexTotal]);
+
+		std::vector<ConversionJob> jobs;
+		size_t vertexOffset = 0;
+		size_t indexOffset = 0;
+		for (uint32_t i = 0; i < meshes.size(); i++)
+		{
+			ImportedMesh& mesh = meshes[i];
+			mesh.vertices = vertices.get() + vertexOffset;
+			mesh.positions = positions.get() + vertexOffset;
+			mesh.indices = indices.get() + indexOffset;
+			vertexOffset += mesh.vertexCount;
+			indexOffset += mesh.indexCount;
+
+			// Large meshes are cut into slices so they don't hold up the conversion. Faces of meshes that
+			// aren't pure triangle lists are filtered by one job.
+			for (uint32_t first = 0; first < mesh.vertexCount; first += CONVERSION_SLICE)
+			{
+				jobs.push_back({ i, first, std::min(CONVERSION_SLICE, mesh.vertexCount - first), false });
+			}
+
+			uint32_t faceCount = mesh.source->mNumFaces;
+			uint32_t sliceSize = mesh.indexCount == faceCount * 3 ? CONVERSION_SLICE : faceCount;
+			for (uint32_t first = 0; first < faceCount; first += sliceSize)
+			{
+				jobs.push_back({ i, first, std::min(sliceSize, faceCount - first), true });
+			}
+		}
+
+		auto convert = [&](unsigned int i)
+		{
+			ConversionJob& job = jobs[i];
+			if (job.faces)
+			{
+				_convertFaces(meshes[job.meshIndex], job.first, job.count);
+			}
+			else
+			{
+				_convertVertices(meshes[job.meshIndex], job.first, job.count, job.boundsMin, job.boundsMax);
+			}
+		};
+
+		if (pJobSystem != nullptr)
+		{
+			pJobSystem->ParallelFor((unsigned int)jobs.size(), convert);
+		}
+		else
+		{
+			for (unsigned int i = 0; i < jobs.size(); i++)
+			{
+				convert(i);
+			}
+		}
+
+		std::vector<XMFLOAT3> boundsMin(meshes.size(), XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX));
+		std::vector<XMFLOAT3> boundsMax(meshes.size(), XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+		for (const ConversionJob& job : jobs)
+		{
+			if (job.faces == false)
+			{
+				XMStoreFloat3(&boundsMin[job.meshIndex], XMVectorMin(XMLoadFloat3(&boundsMin[job.meshIndex]), XMLoadFloat3(&job.boundsMin)));
+				XMStoreFloat3(&boundsMax[job.meshIndex], XMVectorMax(XMLoadFloat3(&boundsMax[job.meshIndex]), XMLoadFloat3(&job.boundsMax)));
+			}
+		}
+
+		for (uint32_t i = 0; i < meshes.size(); i++)
+		{
+			XMVECTOR vMin = XMLoadFloat3(&boundsMin[i]);
+			XMVECTOR vMax = XMLoadFloat3(&boundsMax[i]);
+
+			CookedSubMesh& mainMesh = meshes[i].subMesh;
+			mainMesh = {};
+			std::strncpy(mainMesh.name, "main", sizeof(mainMesh.name) - 1);
+			mainMesh.indexCount = meshes[i].indexCount;
+			mainMesh.startIndexLocation = 0;
+			mainMesh.baseVertexLocation = 0;
+			XMStoreFloat3((XMFLOAT3*)mainMesh.aabbCenter, 0.5f * (vMin + vMax));
+			XMStoreFloat3((XMFLOAT3*)mainMesh.aabbExtents, 0.5f * (vMax - vMin));
+		}
+
+		// Phase two optimizes the meshes, largest first so a big one doesn't start last.
+		std::vector<uint32_t> order(meshes.size());
+		for (uint32_t i = 0; i < order.size(); i++)
+		{
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+			{
+				return meshes[a].indexCount > meshes[b].indexCount;
+			});
+
+		std::vector<char> failed(meshes.size(), 0);
+		auto optimize = [&](unsigned int i)
+		{
+			// A mesh that fails to optimize fails the cook, reported by the return value like a failed import.
+			try
+			{
+				_optimizeMesh(meshes[order[i]]);
+			}
+			catch (...)
+			{
+				failed[order[i]] = 1;
+			}
+		};
+
+		if (pJobSystem != nullptr)
+		{
+			pJobSystem->ParallelFor((unsigned int)meshes.size(), optimize);
+		}
+		else
+		{
+			for (unsigned int i = 0; i < meshes.size(); i++)
+			{
+				optimize(i);
+			}
+		}
+
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			if (failed[i])
+			{
+				return false;
+			}
+		}
+
+		// One cooked mesh per node, shared meshes point at the same data.
+		std::vector<CookedMeshSource> sources(nodeMeshes.size());
+		for (size_t i = 0; i < nodeMeshes.size(); i++)
+		{
+			const ImportedMesh& mesh = meshes[meshOfNode[i]];
+			sources[i].vertices = mesh.vertices;
+			sources[i].vertexCount = mesh.vertexCount;
+			sources[i].vertexStride = sizeof(Vertex);
+			if (mesh.indices16.empty() == false)
+			{
+				sources[i].indices = mesh.indices16.data();
+				sources[i].indexStride = sizeof(uint16_t);
+			}
+			else
+			{
+				sources[i].indices = mesh.indices;
+				sources[i].indexStride = sizeof(uint32_t);
+			}
+			sources[i].indexCount = mesh.indexCount;
+			sources[i].positions = mesh.positions;
+			sources[i].subMeshes.push_back(mesh.subMesh);
+			sources[i].meshlets = mesh.meshlets;
+			sources[i].batches = mesh.batches;
+			sources[i].node = meshNodes[i];
+		}
+
+		cookedBytes = BuildCookedMesh(sources, nodes);
+		return true;
+	}
+
+	bool MeshCooker::CookToCache(const std::string& sourcePath, AssetCache& cache, JobSystem* pJobSystem)
+	{
+		std::vector<uint8_t> cookedBytes;
+		if (Cook(sourcePath, cookedBytes, pJobSystem) == false)
+		{
+			return false;
+		}
+
+		return cache.Store(GetCacheKey(sourcePath), cookedBytes);
+	}
+
+	std::string MeshCooker::GetCacheKey(const std::string& sourcePath)
+	{
+		std::string salt = "HMeshImporter " + std::to_string(COOKER_VERSION) +
+			" flags " + std::to_string(IMPORT_FLAGS) +
+			" format " + std::to_string(CookedMeshFormat::VERSION) +
+			" vertex " + std::to_string(sizeof(Vertex)) +
+			" assimp " + std::to_string(aiGetVersionMajor()) + "." + std::to_string(aiGetVersionMinor()) +
+			"." + std::to_string(aiGetVersionRevision());
+
+		return AssetCache::ComputeKey(sourcePath, salt);
+	}
+
+	void MeshCooker::_processNode(const aiNode* node, uint32_t parent, const aiScene* scene, std::vector<aiMesh*>& aiMeshes,
+		std::vector<uint32_t>& meshNodes, std::vector<CookedNode>& nodes)
+	{
+		// ASSIMP transforms column vectors, the renderer row vectors.
+		CookedNode cookedNode = {};
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				cookedNode.localTransform[row * 4 + column] = node->mTransformation[column][row];
+			}
+		}
+		cookedNode.parent = parent;
+
+		uint32_t index = (uint32_t)nodes.size();
+		nodes.push_back(cookedNode);
+
+		for (size_t i = 0; i < node->mNumMeshes; i++)
+		{
+			aiMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+			meshNodes.push_back(index);
+		}
+
+		for (size_t i = 0; i < node->mNumChildren; i++)
+		{
+			_processNode(node->mChildren[i], index, scene, aiMeshes, meshNodes, nodes);
+		}
+	}
+
+	uint32_t MeshCooker::_countTriangleIndices(const aiMesh* pAiMesh)
+	{
+		if (pAiMesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+		{
+			return pAiMesh->mNumFaces * 3;
+		}
+
+		// Points and lines left by aiProcess_Triangulate can't go into a triangle list.
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < pAiMesh->mNumFaces; i++)
+		{
+			count += pAiMesh->mFaces[i].mNumIndices == 3 ? 3 : 0;
+		}
+		return count;
+	}
+
+	void MeshCooker::_convertVertices(ImportedMesh& mesh, uint32_t first, uint32_t count, XMFLOAT3& boundsMin, XMFLOAT3& boundsMax)
+	{
+		const aiMesh* pAiMesh = mesh.source;
+		static_assert(sizeof(aiVector3D) == sizeof(XMFLOAT3), "ASSIMP must be built with single precision.");
+
+		// One pass per attribute, each reads a single source stream front to back.
+		Vertex* vertices = mesh.vertices + first;
+		XMFLOAT3* positions = mesh.positions + first;
+		const XMFLOAT3* srcPositions = (const XMFLOAT3*)pAiMesh->mVertices + first;
+
+		XMFLOAT3 vMinF(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 vMaxF(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+		XMVECTOR vMin = XMLoadFloat3(&vMinF);
+		XMVECTOR vMax = XMLoadFloat3(&vMaxF);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			XMVECTOR p = XMLoadFloat3(&srcPositions[i]);
+			vMin = XMVectorMin(p, vMin);
+			vMax = XMVectorMax(p, vMax);
+			XMStoreFloat3(&vertices[i].position, p);
+			XMStoreFloat3(&positions[i], p);
+		}
+		XMStoreFloat3(&boundsMin, vMin);
+		XMStoreFloat3(&boundsMax, vMax);
+
+		auto copyStream = [&](const aiVector3D* src, XMFLOAT3 Vertex::* attribute)
+		{
+			if (src == nullptr)
+			{
+				for (uint32_t i = 0; i < count; i++)
+				{
+					vertices[i].*attribute = XMFLOAT3(0.0f, 0.0f, 0.0f);
+				}
+				return;
+			}
+
+			const XMFLOAT3* stream = (const XMFLOAT3*)src + first;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				XMStoreFloat3(&(vertices[i].*attribute), XMLoadFloat3(&stream[i]));
+			}
+		};
+
+		copyStream(pAiMesh->mNormals, &Vertex::normal);
+		copyStream(pAiMesh->mTangents, &Vertex::tangent);
+
+		// UV 0
+		const aiVector3D* uvs = pAiMesh->mTextureCoords[0];
+		for (uint32_t i = 0; i < count; i++)
+		{
+			vertices[i].uv = uvs != nullptr ? XMFLOAT2(uvs[first + i].x, uvs[first + i].y) : XMFLOAT2(0.0f, 0.0f);
+		}
+	}
+
+	void MeshCooker::_convertFaces(ImportedMesh& mesh, uint32_t firstFace, uint32_t faceCount)
+	{
+		const aiMesh* pAiMesh = mesh.source;
+
+		// A slice of a triangle list starts at three indices per face, a filtered mesh is a single slice.
+		uint32_t* indices = mesh.indices + (size_t)firstFace * 3;
+		for (uint32_t i = firstFace; i < firstFace + faceCount; i++)
+		{
+			const aiFace& face = pAiMesh->mFaces[i];
+			if (face.mNumIndices == 3)
+			{
+				indices[0] = face.mIndices[0];
+				indices[1] = face.mIndices[1];
+				indices[2] = face.mIndices[2];
+				indices += 3;
+			}
+		}
+	}
+
+	void MeshCooker::_optimizeMesh(ImportedMesh& mesh)
+	{
+		Vertex* vertices = mesh.vertices;
+		uint32_t* indices = mesh.indices;
+		size_t vertexCount = mesh.vertexCount;
+		size_t indexCount = mesh.indexCount;
+
+		// Triangle order for the post-transform cache, then clusters reordered against overdraw,
+		// then vertices renumbered for fetch. Each step keeps what the previous one achieved.
+		std::vector<uint32_t> clusters;
+		OptimizeVertexCache(indices, indexCount, vertexCount, DEFAULT_VERTEX_CACHE_SIZE, &clusters);
+
+		OptimizeOverdraw(indices, indexCount, (const float*)mesh.positions, vertexCount, clusters,
+			DEFAULT_VERTEX_CACHE_SIZE, DEFAULT_OVERDRAW_THRESHOLD);
+
+		OptimizeVertexFetch(indices, indexCount, vertices, vertexCount, sizeof(Vertex));
+
+		// The position stream follows the new vertex order.
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			mesh.positions[i] = vertices[i].position;
+		}
+
+		// Meshlets follow the optimized triangle order, each one stays a contiguous index range.
+		mesh.meshlets.clear();
+		BuildMeshlets(indices, indexCount, (const float*)mesh.positions, vertexCount,
+			mesh.subMesh.startIndexLocation, mesh.meshlets);
+		mesh.subMesh.firstMeshlet = 0;
+		mesh.subMesh.meshletCount = (uint32_t)mesh.meshlets.size();
+
+		// Halves the index bandwidth. Meshes with too many vertices are drawn in batches, the few whose
+		// meshlets can't be batched keep 32 bit indices.
+		std::vector<IndexSubRange> subRanges(1);
+		subRanges[0].startIndexLocation = mesh.subMesh.startIndexLocation;
+		subRanges[0].indexCount = mesh.subMesh.indexCount;
+		subRanges[0].firstMeshlet = mesh.subMesh.firstMeshlet;
+		subRanges[0].meshletCount = mesh.subMesh.meshletCount;
+		if (PackIndices16(indices, indexCount, mesh.meshlets.data(), subRanges, mesh.indices16, mesh.batches))
+		{
+			mesh.subMesh.firstBatch = subRanges[0].firstBatch;
+			mesh.subMesh.batchCount = subRanges[0].batchCount;
+		}
+	}
+}
@@ -0,0 +1,83 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "assimp/scene.h"
+
+#include "Vertex.h"
+#include "CookedMesh.h"
+#include "AssetCache.h"
+
+
+namespace Humpback
+{
+	class JobSystem;
+
+
+	// Turns source files into cooked meshes. Needs ASSIMP but no device, HMeshImporter loads what it produces
+	// and the -cook command line option uses CookToCache to fill the cache offline.
+	class MeshCooker
+	{
+	public:
+		// Imports a source file with ASSIMP, optimizes every mesh for the vertex cache, overdraw and vertex
+		// fetch, cuts it into meshlets for the cluster culler, stores 16 bit indices where they fit and returns
+		// the cooked bytes. The conversion runs in slices and the optimization per mesh in parallel on pJobSystem.
+		static bool Cook(const std::string& sourcePath, std::vector<uint8_t>& cookedBytes, JobSystem* pJobSystem = nullptr);
+		// The part of Cook after ASSIMP read the file.
+		static bool CookScene(const aiScene* pScene, std::vector<uint8_t>& cookedBytes, JobSystem* pJobSystem = nullptr);
+		static bool CookToCache(const std::string& sourcePath, AssetCache& cache, JobSystem* pJobSystem = nullptr);
+
+		// Covers the source bytes, the ASSIMP post-process flags and version, the cooker version and the cooked format.
+		static std::string GetCacheKey(const std::string& sourcePath);
+
+	private:
+
+		// Vertices, indices and positions in GPU layout, the input of the optimization. They point into buffers
+		// shared by every mesh of the scene, allocated once before the conversion.
+		struct ImportedMesh
+		{
+			const aiMesh* source = nullptr;
+
+			Vertex* vertices = nullptr;
+			uint32_t vertexCount = 0;
+			uint32_t* indices = nullptr;
+			uint32_t indexCount = 0;
+			DirectX::XMFLOAT3* positions = nullptr;
+
+			std::vector<Meshlet> meshlets;
+			// The 16 bit copy of indices the cooker stores instead when the mesh allows it.
+			std::vector<uint16_t> indices16;
+			std::vector<IndexBatch> batches;
+			CookedSubMesh subMesh;
+		};
+
+		// A slice of the vertices or of the faces of one mesh.
+		struct ConversionJob
+		{
+			uint32_t meshIndex;
+			uint32_t first;
+			uint32_t count;
+			bool faces;
+
+			// Of the converted positions.
+			DirectX::XMFLOAT3 boundsMin = {};
+			DirectX::XMFLOAT3 boundsMax = {};
+		};
+
+		// Collects the meshes of the node tree in draw order, a mesh shared by several nodes appears for each.
+		// The nodes are written before their children, meshNodes holds the node of each collected mesh.
+		static void _processNode(const aiNode* node, uint32_t parent, const aiScene* scene, std::vector<aiMesh*>& aiMeshes,
+			std::vector<uint32_t>& meshNodes, std::vector<CookedNode>& nodes);
+		static uint32_t _countTriangleIndices(const aiMesh* pAiMesh);
+		static void _convertVertices(ImportedMesh& mesh, uint32_t first, uint32_t count,
+			DirectX::XMFLOAT3& boundsMin, DirectX::XMFLOAT3& boundsMax);
+		static void _convertFaces(ImportedMesh& mesh, uint32_t firstFace, uint32_t faceCount);
+		static void _optimizeMesh(ImportedMesh& mesh);
+	};
+}
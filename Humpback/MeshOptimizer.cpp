@@ -0,0 +1,388 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+
+#include "MeshOptimizer.h"
+
+
+namespace Humpback
+{
+	namespace
+	{
+		const uint32_t INVALID_INDEX = ~0u;
+
+		// FIFO cache simulated with timestamps: a vertex is cached while fewer than cacheSize misses happened
+		// since it was loaded. Advancing the time by cacheSize + 1 flushes it.
+		class FifoCache
+		{
+		public:
+
+			FifoCache(size_t vertexCount, uint32_t cacheSize) :
+				m_loadTime(vertexCount, 0), m_time(cacheSize + 1), m_cacheSize(cacheSize)
+			{
+			}
+
+			// Returns 1 on a miss.
+			uint32_t Touch(uint32_t vertex)
+			{
+				if (m_time - m_loadTime[vertex] > m_cacheSize)
+				{
+					m_loadTime[vertex] = m_time++;
+					return 1;
+				}
+				return 0;
+			}
+
+			uint32_t TouchTriangle(const uint32_t* triangle)
+			{
+				return Touch(triangle[0]) + Touch(triangle[1]) + Touch(triangle[2]);
+			}
+
+			void Flush()
+			{
+				m_time += m_cacheSize + 1;
+			}
+
+		private:
+
+			std::vector<uint64_t> m_loadTime;
+			uint64_t m_time;
+			uint32_t m_cacheSize;
+		};
+
+		// Triangles around every vertex.
+		struct Adjacency
+		{
+			std::vector<uint32_t> offsets;
+			std::vector<uint32_t> triangles;
+
+			Adjacency(const uint32_t* indices, size_t indexCount, size_t vertexCount) :
+				offsets(vertexCount + 1, 0), triangles(indexCount)
+			{
+				for (size_t i = 0; i < indexCount; i++)
+				{
+					offsets[indices[i] + 1]++;
+				}
+				std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+				std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+				for (size_t i = 0; i < indexCount; i++)
+				{
+					triangles[fill[indices[i]]++] = (uint32_t)(i / 3);
+				}
+			}
+
+			uint32_t GetCount(uint32_t vertex) const { return offsets[vertex + 1] - offsets[vertex]; }
+		};
+
+		struct Float3
+		{
+			float x, y, z;
+
+			Float3 operator+(const Float3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+			Float3 operator-(const Float3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+			Float3 operator*(float s) const { return { x * s, y * s, z * s }; }
+		};
+
+		Float3 Cross(const Float3& a, const Float3& b)
+		{
+			return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+		}
+
+		float Dot(const Float3& a, const Float3& b)
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+	}
+
+	VertexCacheStats& VertexCacheStats::operator+=(const VertexCacheStats& other)
+	{
+		triangleCount += other.triangleCount;
+		vertexCount += other.vertexCount;
+		transformedVertices += other.transformedVertices;
+		return *this;
+	}
+
+	VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+	{
+		VertexCacheStats stats;
+		stats.triangleCount = indexCount / 3;
+
+		FifoCache cache(vertexCount, cacheSize);
+		std::vector<bool> referenced(vertexCount, false);
+		for (size_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			stats.transformedVertices += cache.TouchTriangle(indices + i);
+			for (size_t j = i; j < i + 3; j++)
+			{
+				stats.vertexCount += referenced[indices[j]] ? 0 : 1;
+				referenced[indices[j]] = true;
+			}
+		}
+
+		return stats;
+	}
+
+	void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize,
+		std::vector<uint32_t>* pClusters)
+	{
+		const size_t triangleCount = indexCount / 3;
+		if (pClusters != nullptr)
+		{
+			pClusters->clear();
+		}
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		Adjacency adjacency(indices, triangleCount * 3, vertexCount);
+
+		std::vector<uint32_t> liveTriangles(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			liveTriangles[v] = adjacency.GetCount(v);
+		}
+
+		// Tipsify keeps its own timestamps, it needs the time since a vertex was loaded to rank candidates.
+		std::vector<uint64_t> loadTime(vertexCount, 0);
+		uint64_t time = cacheSize + 1;
+
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnds;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> result;
+		result.reserve(triangleCount * 3);
+
+		uint32_t cursor = 0;
+		uint32_t fanning = 0;
+		if (pClusters != nullptr)
+		{
+			pClusters->push_back(0);
+		}
+
+		while (fanning != INVALID_INDEX)
+		{
+			// Emit every remaining triangle around the fanning vertex.
+			candidates.clear();
+			for (uint32_t a = adjacency.offsets[fanning]; a < adjacency.offsets[fanning + 1]; a++)
+			{
+				const uint32_t triangle = adjacency.triangles[a];
+				if (emitted[triangle])
+				{
+					continue;
+				}
+				emitted[triangle] = true;
+
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					const uint32_t v = indices[triangle * 3 + k];
+					result.push_back(v);
+					deadEnds.push_back(v);
+					candidates.push_back(v);
+					liveTriangles[v]--;
+					if (time - loadTime[v] > cacheSize)
+					{
+						loadTime[v] = time++;
+					}
+				}
+			}
+
+			// Next fanning vertex: the oldest candidate that will still be cached after emitting its triangles.
+			uint32_t next = INVALID_INDEX;
+			int64_t bestPriority = -1;
+			for (uint32_t v : candidates)
+			{
+				if (liveTriangles[v] == 0)
+				{
+					continue;
+				}
+
+				int64_t priority = 0;
+				if (time - loadTime[v] + 2 * liveTriangles[v] <= cacheSize)
+				{
+					priority = (int64_t)(time - loadTime[v]);
+				}
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					next = v;
+				}
+			}
+
+			if (next == INVALID_INDEX)
+			{
+				// Dead end: back up to the most recent vertex with triangles left, then scan in input order.
+				while (deadEnds.empty() == false && next == INVALID_INDEX)
+				{
+					uint32_t v = deadEnds.back();
+					deadEnds.pop_back();
+					next = liveTriangles[v] > 0 ? v : INVALID_INDEX;
+				}
+				while (next == INVALID_INDEX && cursor < vertexCount)
+				{
+					next = liveTriangles[cursor] > 0 ? cursor : INVALID_INDEX;
+					cursor++;
+				}
+
+				if (next != INVALID_INDEX && pClusters != nullptr && result.size() / 3 > pClusters->back())
+				{
+					pClusters->push_back((uint32_t)(result.size() / 3));
+				}
+			}
+
+			fanning = next;
+		}
+
+		std::memcpy(indices, result.data(), result.size() * sizeof(uint32_t));
+	}
+
+	void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+		const std::vector<uint32_t>& clusters, uint32_t cacheSize, float threshold)
+	{
+		const uint32_t triangleCount = (uint32_t)(indexCount / 3);
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		std::vector<uint32_t> hardBoundaries = clusters;
+		if (hardBoundaries.empty() || hardBoundaries.front() != 0)
+		{
+			hardBoundaries.insert(hardBoundaries.begin(), 0);
+		}
+		hardBoundaries.push_back(triangleCount);
+
+		// Soft boundaries: within a cluster, start a new one as soon as the running ACMR drops to the
+		// cluster's own times threshold. Each piece starts with a cold cache, as it may be drawn after anything.
+		std::vector<uint32_t> boundaries;
+		FifoCache cache(vertexCount, cacheSize);
+		for (size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+		{
+			const uint32_t begin = hardBoundaries[c];
+			const uint32_t end = hardBoundaries[c + 1];
+
+			cache.Flush();
+			uint32_t clusterMisses = 0;
+			for (uint32_t t = begin; t < end; t++)
+			{
+				clusterMisses += cache.TouchTriangle(indices + t * 3);
+			}
+			const float targetAcmr = (float)clusterMisses / (end - begin) * threshold;
+
+			cache.Flush();
+			boundaries.push_back(begin);
+			uint32_t runningMisses = 0;
+			uint32_t runningTriangles = 0;
+			for (uint32_t t = begin; t < end; t++)
+			{
+				runningMisses += cache.TouchTriangle(indices + t * 3);
+				runningTriangles++;
+
+				if (t + 1 < end && (float)runningMisses / runningTriangles <= targetAcmr)
+				{
+					boundaries.push_back(t + 1);
+					cache.Flush();
+					runningMisses = 0;
+					runningTriangles = 0;
+				}
+			}
+		}
+		boundaries.push_back(triangleCount);
+
+		// Area weighted centroid and normal of every cluster and of the mesh.
+		const size_t clusterCount = boundaries.size() - 1;
+		std::vector<Float3> centroids(clusterCount, Float3{ 0.0f, 0.0f, 0.0f });
+		std::vector<Float3> normals(clusterCount, Float3{ 0.0f, 0.0f, 0.0f });
+		std::vector<float> areas(clusterCount, 0.0f);
+		Float3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+		float meshArea = 0.0f;
+
+		auto position = [&](uint32_t vertex) -> Float3
+		{
+			return { positions[vertex * 3], positions[vertex * 3 + 1], positions[vertex * 3 + 2] };
+		};
+
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			for (uint32_t t = boundaries[c]; t < boundaries[c + 1]; t++)
+			{
+				const Float3 p0 = position(indices[t * 3]);
+				const Float3 p1 = position(indices[t * 3 + 1]);
+				const Float3 p2 = position(indices[t * 3 + 2]);
+
+				// Points out of the front face for clockwise triangles in left handed space, the import convention.
+				const Float3 normal = Cross(p1 - p0, p2 - p0);
+				const float area = std::sqrt(Dot(normal, normal));
+
+				centroids[c] = centroids[c] + (p0 + p1 + p2) * (area / 3.0f);
+				normals[c] = normals[c] + normal;
+				areas[c] += area;
+			}
+
+			meshCentroid = meshCentroid + centroids[c];
+			meshArea += areas[c];
+			centroids[c] = areas[c] > 0.0f ? centroids[c] * (1.0f / areas[c]) : centroids[c];
+		}
+		meshCentroid = meshArea > 0.0f ? meshCentroid * (1.0f / meshArea) : meshCentroid;
+
+		std::vector<float> sortKeys(clusterCount, 0.0f);
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			const float length = std::sqrt(Dot(normals[c], normals[c]));
+			if (length > 0.0f)
+			{
+				sortKeys[c] = Dot(centroids[c] - meshCentroid, normals[c]) / length;
+			}
+		}
+
+		std::vector<uint32_t> order(clusterCount);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> result;
+		result.reserve(triangleCount * 3);
+		for (uint32_t c : order)
+		{
+			result.insert(result.end(), indices + boundaries[c] * 3, indices + boundaries[c + 1] * 3);
+		}
+
+		std::memcpy(indices, result.data(), result.size() * sizeof(uint32_t));
+	}
+
+	void OptimizeVertexFetch(uint32_t* indices, size_t indexCount, void* vertices, size_t vertexCount, size_t vertexStride)
+	{
+		std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+		uint32_t nextVertex = 0;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			uint32_t& target = remap[indices[i]];
+			if (target == INVALID_INDEX)
+			{
+				target = nextVertex++;
+			}
+			indices[i] = target;
+		}
+
+		for (uint32_t& target : remap)
+		{
+			if (target == INVALID_INDEX)
+			{
+				target = nextVertex++;
+			}
+		}
+
+		std::vector<uint8_t> reordered(vertexCount * vertexStride);
+		const uint8_t* src = (const uint8_t*)vertices;
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			std::memcpy(reordered.data() + remap[v] * vertexStride, src + v * vertexStride, vertexStride);
+		}
+		std::memcpy(vertices, reordered.data(), reordered.size());
+	}
+}
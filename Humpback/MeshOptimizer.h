@@ -0,0 +1,55 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace Humpback
+{
+	// Post-transform cache size the optimizations and the statistics assume. Recent GPUs don't have a true
+	// FIFO cache but orders tuned for a small one carry over.
+	const uint32_t DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+	// Overdraw optimization may raise the ACMR of a cluster by this factor when splitting it.
+	const float DEFAULT_OVERDRAW_THRESHOLD = 1.05f;
+
+
+	struct VertexCacheStats
+	{
+		uint64_t triangleCount = 0;
+		uint64_t vertexCount = 0;			// Referenced by the indices.
+		uint64_t transformedVertices = 0;	// Cache misses.
+
+		// Average cache miss ratio, transformed vertices per triangle. 0.5 is the best a regular grid allows.
+		float GetAcmr() const { return triangleCount > 0 ? (float)transformedVertices / triangleCount : 0.0f; }
+		// Average transform to vertex ratio, 1.0 means every vertex is transformed once.
+		float GetAtvr() const { return vertexCount > 0 ? (float)transformedVertices / vertexCount : 0.0f; }
+
+		VertexCacheStats& operator+=(const VertexCacheStats& other);
+	};
+
+	// Simulates a FIFO cache of cacheSize entries over a triangle list.
+	VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize);
+
+
+	// Tipsify (Sander, Nehab and Barczak 2007): reorders the triangles of a list for the post-transform cache
+	// in linear time. When pClusters is given it receives the first triangle of every run that started at a
+	// dead end, the boundaries OptimizeOverdraw may reorder around.
+	void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize,
+		std::vector<uint32_t>* pClusters = nullptr);
+
+	// Splits the clusters further where that costs less than threshold times their ACMR, then sorts them so
+	// the ones facing away from the mesh center draw first. That order occludes more of the rest from any
+	// direction, so it needs no view. positions are tightly packed float3, one per vertex.
+	void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+		const std::vector<uint32_t>& clusters, uint32_t cacheSize, float threshold);
+
+	// Renumbers the vertices in the order the indices first use them, so fetching walks the vertex buffer
+	// forwards. Vertices no index uses are moved to the end.
+	void OptimizeVertexFetch(uint32_t* indices, size_t indexCount, void* vertices, size_t vertexCount, size_t vertexStride);
+}
@@ -0,0 +1,283 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include "Meshlet.h"
+
+
+namespace Humpback
+{
+	namespace
+	{
+		float Dot(const float* a, const float* b)
+		{
+			return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+		}
+
+		float Distance(const float* a, const float* b)
+		{
+			float dx = a[0] - b[0];
+			float dy = a[1] - b[1];
+			float dz = a[2] - b[2];
+			return sqrtf(dx * dx + dy * dy + dz * dz);
+		}
+
+		// Ritter's sphere started from the most distant pair of axis extremes. Usually tighter than the box
+		// sphere on elongated clusters, the caller keeps whichever is smaller.
+		void RitterSphere(const uint32_t* indices, size_t indexCount, const float* positions, float center[3], float& radius)
+		{
+			uint32_t minVertex[3] = { indices[0], indices[0], indices[0] };
+			uint32_t maxVertex[3] = { indices[0], indices[0], indices[0] };
+			for (size_t i = 1; i < indexCount; i++)
+			{
+				const float* p = positions + indices[i] * 3;
+				for (int axis = 0; axis < 3; axis++)
+				{
+					if (p[axis] < positions[minVertex[axis] * 3 + axis])
+					{
+						minVertex[axis] = indices[i];
+					}
+					if (p[axis] > positions[maxVertex[axis] * 3 + axis])
+					{
+						maxVertex[axis] = indices[i];
+					}
+				}
+			}
+
+			int spanAxis = 0;
+			float span = -1.0f;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float d = Distance(positions + minVertex[axis] * 3, positions + maxVertex[axis] * 3);
+				if (d > span)
+				{
+					span = d;
+					spanAxis = axis;
+				}
+			}
+
+			const float* a = positions + minVertex[spanAxis] * 3;
+			const float* b = positions + maxVertex[spanAxis] * 3;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				center[axis] = 0.5f * (a[axis] + b[axis]);
+			}
+			radius = 0.5f * span;
+
+			// Grow the sphere just enough to take in every point outside it.
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				const float* p = positions + indices[i] * 3;
+				float d = Distance(p, center);
+				if (d > radius)
+				{
+					float newRadius = 0.5f * (radius + d);
+					float shift = (newRadius - radius) / d;
+					for (int axis = 0; axis < 3; axis++)
+					{
+						center[axis] += (p[axis] - center[axis]) * shift;
+					}
+					radius = newRadius;
+				}
+			}
+		}
+	}
+
+	void BuildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+		uint32_t startIndexLocation, std::vector<Meshlet>& meshlets)
+	{
+		// Marks the vertices of the open meshlet with its number + 1.
+		std::vector<uint32_t> owner(vertexCount, 0);
+		uint32_t current = (uint32_t)meshlets.size() + 1;
+
+		size_t first = 0;
+		uint32_t meshletVertices = 0;
+
+		auto close = [&](size_t end)
+		{
+			Meshlet meshlet = {};
+			meshlet.startIndexLocation = startIndexLocation + (uint32_t)first;
+			meshlet.indexCount = (uint32_t)(end - first);
+			meshlet.vertexCount = meshletVertices;
+			ComputeMeshletBounds(indices + first, end - first, positions, meshlet);
+			meshlets.push_back(meshlet);
+
+			first = end;
+			meshletVertices = 0;
+			current++;
+		};
+
+		// Distinct vertices of the triangle the open meshlet doesn't have yet.
+		auto countNewVertices = [&](const uint32_t* triangle)
+		{
+			uint32_t count = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				bool repeated = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+				if (owner[triangle[k]] != current && repeated == false)
+				{
+					count++;
+				}
+			}
+			return count;
+		};
+
+		for (size_t i = 0; i + 3 <= indexCount; i += 3)
+		{
+			const uint32_t* triangle = indices + i;
+
+			uint32_t newVertices = countNewVertices(triangle);
+			if (meshletVertices + newVertices > MESHLET_MAX_VERTICES || (i - first) / 3 >= MESHLET_MAX_TRIANGLES)
+			{
+				close(i);
+				newVertices = countNewVertices(triangle);
+			}
+
+			for (int k = 0; k < 3; k++)
+			{
+				owner[triangle[k]] = current;
+			}
+			meshletVertices += newVertices;
+		}
+
+		if (indexCount - indexCount % 3 > first)
+		{
+			close(indexCount - indexCount % 3);
+		}
+	}
+
+	void ComputeMeshletBounds(const uint32_t* indices, size_t indexCount, const float* positions, Meshlet& meshlet)
+	{
+		if (indexCount == 0)
+		{
+			meshlet = {};
+			meshlet.coneCutoff = 1.0f;
+			return;
+		}
+
+		// Sphere around the box, or Ritter's when it is smaller.
+		float boxMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float boxMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			const float* p = positions + indices[i] * 3;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				boxMin[axis] = std::min(boxMin[axis], p[axis]);
+				boxMax[axis] = std::max(boxMax[axis], p[axis]);
+			}
+		}
+
+		float center[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			center[axis] = 0.5f * (boxMin[axis] + boxMax[axis]);
+		}
+
+		float radius = 0.0f;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			radius = std::max(radius, Distance(positions + indices[i] * 3, center));
+		}
+
+		float ritterCenter[3];
+		float ritterRadius;
+		RitterSphere(indices, indexCount, positions, ritterCenter, ritterRadius);
+		if (ritterRadius < radius)
+		{
+			radius = ritterRadius;
+			std::copy(ritterCenter, ritterCenter + 3, center);
+		}
+
+		std::copy(center, center + 3, meshlet.center);
+		meshlet.radius = radius;
+
+		// Cone around the mean of the unit face normals. Degenerate triangles cover no pixels and are left out.
+		// The normals follow the clockwise front faces of D3D: cross(p1 - p0, p2 - p0) points at the viewer.
+		std::vector<float> normals;
+		normals.reserve(indexCount);
+		std::vector<bool> degenerate(indexCount / 3, false);
+
+		float axis[3] = { 0.0f, 0.0f, 0.0f };
+		for (size_t i = 0; i + 3 <= indexCount; i += 3)
+		{
+			const float* p0 = positions + indices[i + 0] * 3;
+			const float* p1 = positions + indices[i + 1] * 3;
+			const float* p2 = positions + indices[i + 2] * 3;
+
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+
+			float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (length == 0.0f)
+			{
+				degenerate[i / 3] = true;
+				continue;
+			}
+
+			for (int k = 0; k < 3; k++)
+			{
+				n[k] /= length;
+				axis[k] += n[k];
+				normals.push_back(n[k]);
+			}
+		}
+
+		float axisLength = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		meshlet.coneCutoff = 1.0f;
+		std::copy(center, center + 3, meshlet.coneApex);
+		std::fill(meshlet.coneAxis, meshlet.coneAxis + 3, 0.0f);
+		if (normals.empty() || axisLength == 0.0f)
+		{
+			return;
+		}
+
+		for (int k = 0; k < 3; k++)
+		{
+			meshlet.coneAxis[k] = axis[k] / axisLength;
+		}
+
+		float minDot = 1.0f;
+		for (size_t i = 0; i < normals.size(); i += 3)
+		{
+			minDot = std::min(minDot, Dot(&normals[i], meshlet.coneAxis));
+		}
+
+		// Rounding may leave the normals a hair outside, widen the cone instead of trusting the last bit.
+		minDot -= 1e-4f;
+		if (minDot <= 0.0f)
+		{
+			return;
+		}
+
+		// Slide the apex back from the center along the axis until it is behind every triangle plane:
+		// dot(n, p - (center - t * axis)) >= 0 for a vertex p of each triangle.
+		float t = -FLT_MAX;
+		size_t n = 0;
+		for (size_t i = 0; i + 3 <= indexCount; i += 3)
+		{
+			if (degenerate[i / 3])
+			{
+				continue;
+			}
+
+			const float* normal = &normals[n];
+			n += 3;
+
+			const float* p = positions + indices[i] * 3;
+			float toCenter[3] = { center[0] - p[0], center[1] - p[1], center[2] - p[2] };
+			t = std::max(t, Dot(normal, toCenter) / std::max(Dot(normal, meshlet.coneAxis), minDot));
+		}
+
+		for (int k = 0; k < 3; k++)
+		{
+			meshlet.coneApex[k] = center[k] - meshlet.coneAxis[k] * t;
+		}
+		meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+	}
+}
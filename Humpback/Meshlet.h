@@ -0,0 +1,53 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace Humpback
+{
+	// Limits of a cluster. 64 vertices and 124 triangles fit the mesh shader sizes recommended by the vendors,
+	// so the clusters can feed a mesh shader path later without being rebuilt.
+	const uint32_t MESHLET_MAX_VERTICES = 64;
+	const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+
+	// A run of triangles of the index buffer with the bounds the cluster culler tests. The layout is part of
+	// the cooked mesh format.
+	struct Meshlet
+	{
+		// Object space sphere around the triangles.
+		float center[3];
+		float radius;
+
+		// Every triangle normal is within the cone around coneAxis, and coneApex is behind every triangle plane.
+		// coneCutoff is the sine of the half angle, 1 when the normals spread over a hemisphere or more and
+		// the cluster can't be back facing as a whole.
+		float coneApex[3];
+		float coneCutoff;
+		float coneAxis[3];
+
+		// In the index buffer, the indices are relative to the baseVertexLocation of the submesh.
+		uint32_t startIndexLocation;
+		uint32_t indexCount;
+		uint32_t vertexCount;
+	};
+
+	static_assert(sizeof(Meshlet) == 56, "Meshlet is part of the cooked mesh format.");
+
+
+	// Cuts the triangle list into consecutive runs of at most MESHLET_MAX_VERTICES distinct vertices and
+	// MESHLET_MAX_TRIANGLES triangles, so each meshlet is drawable as a plain index range. The triangles
+	// are not reordered, run it after OptimizeVertexCache whose order is already local. positions are tightly
+	// packed float3, one per vertex, and startIndexLocation is where indices starts in the index buffer.
+	void BuildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+		uint32_t startIndexLocation, std::vector<Meshlet>& meshlets);
+
+	// Fills the sphere and cone of a meshlet from its triangles.
+	void ComputeMeshletBounds(const uint32_t* indices, size_t indexCount, const float* positions, Meshlet& meshlet);
+}
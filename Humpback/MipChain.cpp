@@ -0,0 +1,656 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cmath>
+#include <mutex>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+#include <smmintrin.h>
+
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include "MipChain.h"
+
+
+namespace Humpback
+{
+	namespace
+	{
+		// Roughly what a job should filter, small levels end up on a single thread.
+		const uint32_t PIXELS_PER_JOB = 16384;
+
+		const int COVERAGE_BINS = 4096;
+		const int SRGB_ENCODE_STEPS = 4096;
+
+		float SrgbToLinear(float c)
+		{
+			return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		float LinearToSrgbExact(float c)
+		{
+			return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+		}
+
+		struct SrgbTables
+		{
+			float decode8[256];
+			std::vector<float> decode16;
+			// Sampled curve, interpolating it stays within one 16 bit step of the exact encode.
+			float encode[SRGB_ENCODE_STEPS + 1];
+		};
+
+		const SrgbTables& GetSrgbTables()
+		{
+			static const SrgbTables tables = []()
+			{
+				SrgbTables t;
+				for (int i = 0; i < 256; i++)
+				{
+					t.decode8[i] = SrgbToLinear(i / 255.0f);
+				}
+				t.decode16.resize(65536);
+				for (int i = 0; i < 65536; i++)
+				{
+					t.decode16[i] = SrgbToLinear(i / 65535.0f);
+				}
+				for (int i = 0; i <= SRGB_ENCODE_STEPS; i++)
+				{
+					t.encode[i] = LinearToSrgbExact((float)i / SRGB_ENCODE_STEPS);
+				}
+				return t;
+			}();
+
+			return tables;
+		}
+
+		// c must be in [0, 1].
+		float LinearToSrgb(const SrgbTables& tables, float c)
+		{
+			float pos = c * SRGB_ENCODE_STEPS;
+			int i = std::min((int)pos, SRGB_ENCODE_STEPS - 1);
+			return tables.encode[i] + (tables.encode[i + 1] - tables.encode[i]) * (pos - (float)i);
+		}
+
+		// Source texels and weights of one target texel along one axis. Even sizes take two texels at 1/2,
+		// odd sizes spread the footprint over three.
+		struct Taps
+		{
+			uint32_t first;
+			uint32_t count;
+			float weights[3];
+		};
+
+		std::vector<Taps> ComputeTaps(uint32_t srcSize, uint32_t dstSize)
+		{
+			std::vector<Taps> taps(dstSize);
+			const double scale = (double)srcSize / dstSize;
+			for (uint32_t i = 0; i < dstSize; i++)
+			{
+				double begin = i * scale;
+				double end = (i + 1) * scale;
+
+				Taps& t = taps[i];
+				t.first = (uint32_t)begin;
+				uint32_t last = std::min(srcSize - 1, (uint32_t)std::ceil(end) - 1);
+				t.count = last - t.first + 1;
+
+				for (uint32_t j = 0; j < t.count; j++)
+				{
+					double texelBegin = std::max(begin, (double)(t.first + j));
+					double texelEnd = std::min(end, (double)(t.first + j + 1));
+					t.weights[j] = (float)((texelEnd - texelBegin) / scale);
+				}
+			}
+			return taps;
+		}
+
+		struct Level
+		{
+			uint32_t width;
+			uint32_t height;
+		};
+
+		// Row kernels. The SSE4.1 variants are picked at runtime, see CpuFeatures. They sum the filter taps
+		// in a different order and round halfway values to even, so results can differ in the last bit
+		// of the float chain and by one step after quantization.
+		template<typename T>
+		void UnormToFloatRow(const T* src, uint32_t width, float maxValue, float* dst)
+		{
+			for (uint32_t i = 0; i < width * 4; i++)
+			{
+				dst[i] = src[i] / maxValue;
+			}
+		}
+
+		HB_TARGET_SSE41 void Unorm8ToFloatRowSse41(const uint8_t* src, uint32_t width, float* dst)
+		{
+			for (uint32_t x = 0; x < width; x++, src += 4, dst += 4)
+			{
+				int packed;
+				std::memcpy(&packed, src, 4);
+				__m128 v = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)));
+				_mm_storeu_ps(dst, _mm_mul_ps(v, _mm_set1_ps(1.0f / 255.0f)));
+			}
+		}
+
+		HB_TARGET_SSE41 void Unorm16ToFloatRowSse41(const uint16_t* src, uint32_t width, float* dst)
+		{
+			for (uint32_t x = 0; x < width; x++, src += 4, dst += 4)
+			{
+				__m128 v = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)src)));
+				_mm_storeu_ps(dst, _mm_mul_ps(v, _mm_set1_ps(1.0f / 65535.0f)));
+			}
+		}
+
+		void FilterRow(const float* const* srcRows, const Taps& rowTaps, const std::vector<Taps>& columns,
+			uint32_t width, bool normalMap, float* dst)
+		{
+			for (uint32_t x = 0; x < width; x++, dst += 4)
+			{
+				const Taps& colTaps = columns[x];
+				float sum[4] = {};
+				for (uint32_t r = 0; r < rowTaps.count; r++)
+				{
+					const float* row = srcRows[r] + (size_t)colTaps.first * 4;
+					for (uint32_t c = 0; c < colTaps.count; c++)
+					{
+						float weight = rowTaps.weights[r] * colTaps.weights[c];
+						for (int i = 0; i < 4; i++)
+						{
+							sum[i] += row[c * 4 + i] * weight;
+						}
+					}
+				}
+
+				if (normalMap)
+				{
+					// Back to [-1, 1], normalize xyz, back to [0, 1]. w is left alone.
+					float n[3] = { sum[0] * 2.0f - 1.0f, sum[1] * 2.0f - 1.0f, sum[2] * 2.0f - 1.0f };
+					float lengthSq = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+					if (lengthSq > 1e-12f)
+					{
+						float invLength = 1.0f / std::sqrt(lengthSq);
+						for (int i = 0; i < 3; i++)
+						{
+							sum[i] = n[i] * invLength * 0.5f + 0.5f;
+						}
+					}
+				}
+
+				std::memcpy(dst, sum, sizeof(sum));
+			}
+		}
+
+		HB_TARGET_SSE41 void FilterRowSse41(const float* const* srcRows, const Taps& rowTaps, const std::vector<Taps>& columns,
+			uint32_t width, bool normalMap, float* dst)
+		{
+			for (uint32_t x = 0; x < width; x++, dst += 4)
+			{
+				const Taps& colTaps = columns[x];
+				__m128 sum = _mm_setzero_ps();
+				for (uint32_t r = 0; r < rowTaps.count; r++)
+				{
+					const float* row = srcRows[r] + (size_t)colTaps.first * 4;
+					__m128 h = _mm_mul_ps(_mm_loadu_ps(row), _mm_set1_ps(colTaps.weights[0]));
+					for (uint32_t c = 1; c < colTaps.count; c++)
+					{
+						h = _mm_add_ps(h, _mm_mul_ps(_mm_loadu_ps(row + c * 4), _mm_set1_ps(colTaps.weights[c])));
+					}
+					sum = _mm_add_ps(sum, _mm_mul_ps(h, _mm_set1_ps(rowTaps.weights[r])));
+				}
+
+				if (normalMap)
+				{
+					const __m128 two = _mm_set1_ps(2.0f);
+					const __m128 one = _mm_set1_ps(1.0f);
+					const __m128 half = _mm_set1_ps(0.5f);
+					__m128 n = _mm_sub_ps(_mm_mul_ps(sum, two), one);
+					__m128 lengthSq = _mm_dp_ps(n, n, 0x7f);
+					if (_mm_cvtss_f32(lengthSq) > 1e-12f)
+					{
+						n = _mm_div_ps(n, _mm_sqrt_ps(lengthSq));
+						sum = _mm_blend_ps(_mm_add_ps(_mm_mul_ps(n, half), half), sum, 0x8);
+					}
+				}
+
+				_mm_storeu_ps(dst, sum);
+			}
+		}
+
+		// Clamps to [0, 1], scales alpha and sRGB encodes the color when pTables isn't null.
+		void PrepareTexel(const float* src, float alphaScale, const SrgbTables* pTables, float texel[4])
+		{
+			texel[0] = src[0];
+			texel[1] = src[1];
+			texel[2] = src[2];
+			texel[3] = src[3] * alphaScale;
+			for (int c = 0; c < 4; c++)
+			{
+				texel[c] = std::min(std::max(texel[c], 0.0f), 1.0f);
+			}
+			if (pTables != nullptr)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					texel[c] = LinearToSrgb(*pTables, texel[c]);
+				}
+			}
+		}
+
+		void StoreRgbaRow(const float* src, uint32_t width, float alphaScale, const SrgbTables* pTables, bool is16, uint8_t* dst)
+		{
+			const float maxValue = is16 ? 65535.0f : 255.0f;
+			for (uint32_t x = 0; x < width; x++, src += 4)
+			{
+				float texel[4];
+				PrepareTexel(src, alphaScale, pTables, texel);
+				for (int c = 0; c < 4; c++)
+				{
+					uint32_t value = (uint32_t)(texel[c] * maxValue + 0.5f);
+					if (is16)
+					{
+						((uint16_t*)dst)[x * 4 + c] = (uint16_t)value;
+					}
+					else
+					{
+						dst[x * 4 + c] = (uint8_t)value;
+					}
+				}
+			}
+		}
+
+		HB_TARGET_SSE41 void StoreRgbaRowSse41(const float* src, uint32_t width, float alphaScale, const SrgbTables* pTables,
+			bool is16, uint8_t* dst)
+		{
+			const __m128 maxValue = _mm_set1_ps(is16 ? 65535.0f : 255.0f);
+			for (uint32_t x = 0; x < width; x++, src += 4)
+			{
+				float texel[4];
+				PrepareTexel(src, alphaScale, pTables, texel);
+				__m128i quantized = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(texel), maxValue));
+				__m128i packed16 = _mm_packus_epi32(quantized, quantized);
+				if (is16)
+				{
+					_mm_storel_epi64((__m128i*)(dst + x * 8), packed16);
+				}
+				else
+				{
+					int packed8 = _mm_cvtsi128_si32(_mm_packus_epi16(packed16, packed16));
+					std::memcpy(dst + x * 4, &packed8, 4);
+				}
+			}
+		}
+
+		class MipChainBuilder
+		{
+		public:
+
+			MipChainBuilder(DecodedImage& image, const MipChainSettings& settings, JobSystem* pJobSystem) :
+				m_image(image), m_pJobSystem(pJobSystem), m_tables(GetSrgbTables())
+			{
+				m_fourChannels = image.format == ImageFormat::RGBA8 || image.format == ImageFormat::RGBA16;
+				m_srgb = settings.srgb && m_fourChannels;
+				m_normalMap = settings.normalMap && m_fourChannels;
+				m_preserveCoverage = settings.preserveAlphaCoverage && m_fourChannels;
+				m_alphaReference = settings.alphaReference;
+				m_sse41 = GetCpuFeatures().sse41;
+			}
+
+			void Build()
+			{
+				const uint32_t levelCount = GetFullMipCount(m_image.width, m_image.height);
+				m_image.pixels.resize(GetImageByteSize(m_image.width, m_image.height, m_image.format, levelCount));
+				m_image.mipLevels = levelCount;
+
+				if (m_preserveCoverage)
+				{
+					m_targetCoverage = _computeLevel0Coverage();
+				}
+
+				// Level 1 reads the quantized level 0, every later level the float result of the one above,
+				// so the rounding of a level never feeds into the next.
+				std::vector<float> src;
+				std::vector<float> dst;
+				for (uint32_t level = 1; level < levelCount; level++)
+				{
+					ImageMipLayout srcLayout = GetImageMipLayout(m_image.width, m_image.height, m_image.format, level - 1);
+					ImageMipLayout dstLayout = GetImageMipLayout(m_image.width, m_image.height, m_image.format, level);
+
+					dst.resize((size_t)dstLayout.width * dstLayout.height * 4);
+					_filterLevel(level == 1 ? nullptr : src.data(), { srcLayout.width, srcLayout.height },
+						{ dstLayout.width, dstLayout.height }, dst.data());
+
+					float alphaScale = m_preserveCoverage ? _findAlphaScale() : 1.0f;
+					_storeLevel(dst.data(), dstLayout, alphaScale);
+
+					std::swap(src, dst);
+				}
+			}
+
+		private:
+
+			void _forEachRowBlock(uint32_t rows, uint32_t width, const std::function<void(uint32_t, uint32_t)>& job)
+			{
+				uint32_t rowsPerJob = std::max(1u, PIXELS_PER_JOB / width);
+				uint32_t jobCount = (rows + rowsPerJob - 1) / rowsPerJob;
+
+				auto runBlock = [&](unsigned int i)
+				{
+					job(i * rowsPerJob, std::min(rows, (i + 1) * rowsPerJob));
+				};
+
+				if (m_pJobSystem != nullptr && jobCount > 1)
+				{
+					m_pJobSystem->ParallelFor(jobCount, runBlock);
+				}
+				else
+				{
+					for (uint32_t i = 0; i < jobCount; i++)
+					{
+						runBlock(i);
+					}
+				}
+			}
+
+			// Converts a row of level 0 to linear float4.
+			void _loadLevel0Row(uint32_t y, float* dst) const
+			{
+				const uint32_t width = m_image.width;
+				const uint8_t* src = m_image.pixels.data() + y * m_image.GetRowPitch();
+
+				switch (m_image.format)
+				{
+				case ImageFormat::R8:
+				case ImageFormat::R16:
+					for (uint32_t x = 0; x < width; x++, dst += 4)
+					{
+						dst[0] = m_image.format == ImageFormat::R8 ? src[x] / 255.0f : ((const uint16_t*)src)[x] / 65535.0f;
+						dst[1] = 0.0f;
+						dst[2] = 0.0f;
+						dst[3] = 1.0f;
+					}
+					break;
+
+				case ImageFormat::RGBA8:
+					if (m_srgb == false)
+					{
+						if (m_sse41)
+						{
+							Unorm8ToFloatRowSse41(src, width, dst);
+						}
+						else
+						{
+							UnormToFloatRow(src, width, 255.0f, dst);
+						}
+						break;
+					}
+					for (uint32_t x = 0; x < width; x++, src += 4, dst += 4)
+					{
+						dst[0] = m_tables.decode8[src[0]];
+						dst[1] = m_tables.decode8[src[1]];
+						dst[2] = m_tables.decode8[src[2]];
+						dst[3] = src[3] / 255.0f;
+					}
+					break;
+
+				case ImageFormat::RGBA16:
+				{
+					const uint16_t* src16 = (const uint16_t*)src;
+					if (m_srgb == false)
+					{
+						if (m_sse41)
+						{
+							Unorm16ToFloatRowSse41(src16, width, dst);
+						}
+						else
+						{
+							UnormToFloatRow(src16, width, 65535.0f, dst);
+						}
+						break;
+					}
+					for (uint32_t x = 0; x < width; x++, src16 += 4, dst += 4)
+					{
+						dst[0] = m_tables.decode16[src16[0]];
+						dst[1] = m_tables.decode16[src16[1]];
+						dst[2] = m_tables.decode16[src16[2]];
+						dst[3] = src16[3] / 65535.0f;
+					}
+					break;
+				}
+				}
+			}
+
+			// src is null for level 1, the rows are converted from level 0 on the fly.
+			void _filterLevel(const float* src, Level srcLevel, Level dstLevel, float* dst)
+			{
+				std::vector<Taps> columns = ComputeTaps(srcLevel.width, dstLevel.width);
+				std::vector<Taps> rows = ComputeTaps(srcLevel.height, dstLevel.height);
+
+				m_coverageHistogram.assign(COVERAGE_BINS, 0);
+
+				_forEachRowBlock(dstLevel.height, dstLevel.width, [&](uint32_t begin, uint32_t end)
+					{
+						// Level 0 rows converted by this block, consecutive target rows share source rows.
+						std::vector<float> converted[3];
+						uint32_t convertedRow[3] = { UINT32_MAX, UINT32_MAX, UINT32_MAX };
+						std::vector<uint32_t> histogram(m_preserveCoverage ? COVERAGE_BINS : 0, 0);
+
+						for (uint32_t y = begin; y < end; y++)
+						{
+							const Taps& rowTaps = rows[y];
+							const float* srcRows[3] = {};
+							for (uint32_t t = 0; t < rowTaps.count; t++)
+							{
+								uint32_t srcY = rowTaps.first + t;
+								if (src != nullptr)
+								{
+									srcRows[t] = src + (size_t)srcY * srcLevel.width * 4;
+									continue;
+								}
+
+								uint32_t slot = srcY % 3;
+								if (convertedRow[slot] != srcY)
+								{
+									converted[slot].resize((size_t)srcLevel.width * 4);
+									_loadLevel0Row(srcY, converted[slot].data());
+									convertedRow[slot] = srcY;
+								}
+								srcRows[t] = converted[slot].data();
+							}
+
+							float* dstRow = dst + (size_t)y * dstLevel.width * 4;
+							_filterRow(srcRows, rowTaps, columns, dstLevel.width, dstRow);
+
+							if (m_preserveCoverage)
+							{
+								for (uint32_t x = 0; x < dstLevel.width; x++)
+								{
+									float alpha = std::min(std::max(dstRow[x * 4 + 3], 0.0f), 1.0f);
+									histogram[std::min((int)(alpha * COVERAGE_BINS), COVERAGE_BINS - 1)]++;
+								}
+							}
+						}
+
+						if (m_preserveCoverage)
+						{
+							std::lock_guard<std::mutex> lock(m_histogramMutex);
+							for (int i = 0; i < COVERAGE_BINS; i++)
+							{
+								m_coverageHistogram[i] += histogram[i];
+							}
+						}
+					});
+			}
+
+			void _filterRow(const float* const* srcRows, const Taps& rowTaps, const std::vector<Taps>& columns,
+				uint32_t width, float* dst) const
+			{
+				if (m_sse41)
+				{
+					FilterRowSse41(srcRows, rowTaps, columns, width, m_normalMap, dst);
+				}
+				else
+				{
+					FilterRow(srcRows, rowTaps, columns, width, m_normalMap, dst);
+				}
+			}
+
+			void _storeLevel(const float* src, const ImageMipLayout& layout, float alphaScale)
+			{
+				uint8_t* base = m_image.pixels.data() + layout.offset;
+
+				_forEachRowBlock(layout.height, layout.width, [&](uint32_t begin, uint32_t end)
+					{
+						for (uint32_t y = begin; y < end; y++)
+						{
+							_storeRow(src + (size_t)y * layout.width * 4, layout.width, alphaScale, base + y * layout.rowPitch);
+						}
+					});
+			}
+
+			void _storeRow(const float* src, uint32_t width, float alphaScale, uint8_t* dst) const
+			{
+				if (m_fourChannels == false)
+				{
+					for (uint32_t x = 0; x < width; x++)
+					{
+						float v = std::min(std::max(src[x * 4], 0.0f), 1.0f);
+						if (m_image.format == ImageFormat::R8)
+						{
+							dst[x] = (uint8_t)(v * 255.0f + 0.5f);
+						}
+						else
+						{
+							((uint16_t*)dst)[x] = (uint16_t)(v * 65535.0f + 0.5f);
+						}
+					}
+					return;
+				}
+
+				const bool is16 = m_image.format == ImageFormat::RGBA16;
+				const SrgbTables* pTables = m_srgb ? &m_tables : nullptr;
+				if (m_sse41)
+				{
+					StoreRgbaRowSse41(src, width, alphaScale, pTables, is16, dst);
+				}
+				else
+				{
+					StoreRgbaRow(src, width, alphaScale, pTables, is16, dst);
+				}
+			}
+
+			float _computeLevel0Coverage()
+			{
+				const bool is16 = m_image.format == ImageFormat::RGBA16;
+				const float maxValue = is16 ? 65535.0f : 255.0f;
+				const uint32_t threshold = (uint32_t)std::min(maxValue, std::max(0.0f, std::floor(m_alphaReference * maxValue)));
+
+				std::mutex mutex;
+				uint64_t covered = 0;
+				_forEachRowBlock(m_image.height, m_image.width, [&](uint32_t begin, uint32_t end)
+					{
+						uint64_t count = 0;
+						for (uint32_t y = begin; y < end; y++)
+						{
+							const uint8_t* row = m_image.pixels.data() + y * m_image.GetRowPitch();
+							for (uint32_t x = 0; x < m_image.width; x++)
+							{
+								uint32_t alpha = is16 ? ((const uint16_t*)row)[x * 4 + 3] : row[x * 4 + 3];
+								count += alpha > threshold ? 1 : 0;
+							}
+						}
+
+						std::lock_guard<std::mutex> lock(mutex);
+						covered += count;
+					});
+
+				return (float)((double)covered / ((double)m_image.width * m_image.height));
+			}
+
+			// Scale that brings the coverage of the level just filtered closest to the one of level 0. The
+			// search starts at 1 and stops on an exact match, so levels that already match are left alone.
+			float _findAlphaScale() const
+			{
+				std::vector<uint64_t> above(COVERAGE_BINS + 1, 0);
+				for (int i = COVERAGE_BINS - 1; i >= 0; i--)
+				{
+					above[i] = above[i + 1] + m_coverageHistogram[i];
+				}
+				const double total = (double)above[0];
+
+				auto coverage = [&](float scale)
+				{
+					float threshold = m_alphaReference / scale;
+					if (threshold >= 1.0f)
+					{
+						return 0.0;
+					}
+					int bin = std::max(0, std::min((int)(threshold * COVERAGE_BINS) + 1, COVERAGE_BINS));
+					return above[bin] / total;
+				};
+
+				float low = 0.0f;
+				float high = 4.0f;
+				float scale = 1.0f;
+				float bestScale = 1.0f;
+				double bestError = 2.0;
+				for (int i = 0; i < 16; i++)
+				{
+					double current = coverage(scale);
+					double error = std::abs(current - m_targetCoverage);
+					if (error < bestError)
+					{
+						bestError = error;
+						bestScale = scale;
+					}
+
+					if (current < m_targetCoverage)
+					{
+						low = scale;
+					}
+					else if (current > m_targetCoverage)
+					{
+						high = scale;
+					}
+					else
+					{
+						break;
+					}
+					scale = 0.5f * (low + high);
+				}
+				return bestScale;
+			}
+
+			DecodedImage& m_image;
+			JobSystem* m_pJobSystem;
+			const SrgbTables& m_tables;
+
+			bool m_fourChannels = false;
+			bool m_srgb = false;
+			bool m_normalMap = false;
+			bool m_preserveCoverage = false;
+			bool m_sse41 = false;
+			float m_alphaReference = 0.5f;
+			float m_targetCoverage = 0.0f;
+
+			std::vector<uint64_t> m_coverageHistogram;
+			std::mutex m_histogramMutex;
+		};
+	}
+
+	void GenerateMipChain(DecodedImage& image, const MipChainSettings& settings, JobSystem* pJobSystem)
+	{
+		if (image.width == 0 || image.height == 0)
+		{
+			return;
+		}
+
+		MipChainBuilder builder(image, settings, pJobSystem);
+		builder.Build();
+	}
+}
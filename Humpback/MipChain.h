@@ -0,0 +1,33 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include "ImageDecoder.h"
+
+
+namespace Humpback
+{
+	class JobSystem;
+
+
+	struct MipChainSettings
+	{
+		// The texels are sRGB encoded, filter in linear space. Alpha is always linear.
+		bool srgb = false;
+		// RGB holds a unit vector mapped to [0, 1], renormalize it after filtering.
+		bool normalMap = false;
+		// Scale the alpha of each level so as many texels pass an alpha test against alphaReference as in level 0.
+		bool preserveAlphaCoverage = false;
+		float alphaReference = 0.5f;
+	};
+
+
+	// Replaces the levels below 0 with a full chain down to 1x1, each level a 2x2 box filter of the one above.
+	// An odd side is area-weighted over three texels instead, so nothing is dropped or shifted. Filtering runs
+	// in float and each level is quantized once, from a chain that stays in float.
+	// With a job system the rows of every level are split across its threads. The single channel formats
+	// ignore the settings.
+	void GenerateMipChain(DecodedImage& image, const MipChainSettings& settings, JobSystem* pJobSystem = nullptr);
+}
@@ -0,0 +1,658 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+#include <immintrin.h>
+
+#include "OcclusionCuller.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+
+
+using namespace DirectX;
+
+
+namespace Humpback
+{
+	namespace
+	{
+		const unsigned int MAX_SIZE = 1024;
+
+		// Triangles are set up on the job system in chunks of this many.
+		const unsigned int SETUP_CHUNK_SIZE = 1024;
+
+		// Clip space x and y are clipped at this multiple of w, the edge functions of what is left stay
+		// within 32 bits over a tile.
+		const float GUARD_BAND = 4.0f;
+
+		const int SUBPIXEL_BITS = 4;
+		const int SUBPIXELS = 1 << SUBPIXEL_BITS;
+
+		// Edge functions are clamped to this at a tile's first pixel. The steps over the rest of the tile
+		// stay below 2^24 inside the guard band, so the sign of a clamped value never changes.
+		const int64_t EDGE_CLAMP = (int64_t)1 << 30;
+
+		const uint32_t FULL_MASK = 0xFFFFFFFFu;
+
+		// Box corners are indexed by bit 0 = max x, bit 1 = max y, bit 2 = max z. Clockwise seen from
+		// outside, as D3D keeps front faces.
+		const uint32_t BOX_INDICES[36] =
+		{
+			0, 2, 3,	0, 3, 1,	// -z
+			5, 7, 6,	5, 6, 4,	// +z
+			4, 6, 2,	4, 2, 0,	// -x
+			1, 3, 7,	1, 7, 5,	// +x
+			1, 5, 4,	1, 4, 0,	// -y
+			2, 6, 7,	2, 7, 3,	// +y
+		};
+
+		void GetBoxCorners(const XMFLOAT3& center, const XMFLOAT3& extents, XMFLOAT3* corners)
+		{
+			for (unsigned int i = 0; i < 8; ++i)
+			{
+				corners[i].x = center.x + ((i & 1) ? extents.x : -extents.x);
+				corners[i].y = center.y + ((i & 2) ? extents.y : -extents.y);
+				corners[i].z = center.z + ((i & 4) ? extents.z : -extents.z);
+			}
+		}
+
+		float PlaneDistance(const XMFLOAT4& v, unsigned int plane)
+		{
+			switch (plane)
+			{
+			case 0: return v.z;
+			case 1: return GUARD_BAND * v.w + v.x;
+			case 2: return GUARD_BAND * v.w - v.x;
+			case 3: return GUARD_BAND * v.w + v.y;
+			default: return GUARD_BAND * v.w - v.y;
+			}
+		}
+
+		static_assert(OcclusionCuller::TILE_WIDTH == 8 && OcclusionCuller::TILE_HEIGHT == 4, "The coverage masks assume 8x4 tiles.");
+
+		// Coverage of the pixels of a tile, bit row * TILE_WIDTH + column. edge holds the edge functions at the
+		// tile's first pixel, laneOffset their offsets along a row and rowStep their step to the next row.
+		typedef uint32_t (*TileCoverageFunction)(const int32_t* edge, const int32_t (*laneOffset)[8], const int32_t* rowStep);
+
+		uint32_t TileCoverageSse(const int32_t* edge, const int32_t (*laneOffset)[8], const int32_t* rowStep)
+		{
+			const __m128i step0 = _mm_set1_epi32(rowStep[0]);
+			const __m128i step1 = _mm_set1_epi32(rowStep[1]);
+			const __m128i step2 = _mm_set1_epi32(rowStep[2]);
+
+			uint32_t coverage = 0;
+			for (unsigned int half = 0; half < 2; ++half)
+			{
+				__m128i e0 = _mm_add_epi32(_mm_set1_epi32(edge[0]), _mm_loadu_si128((const __m128i*)(laneOffset[0] + half * 4)));
+				__m128i e1 = _mm_add_epi32(_mm_set1_epi32(edge[1]), _mm_loadu_si128((const __m128i*)(laneOffset[1] + half * 4)));
+				__m128i e2 = _mm_add_epi32(_mm_set1_epi32(edge[2]), _mm_loadu_si128((const __m128i*)(laneOffset[2] + half * 4)));
+
+				for (unsigned int row = 0; row < OcclusionCuller::TILE_HEIGHT; ++row)
+				{
+					// A lane is outside when any edge function is negative.
+					__m128i outside = _mm_or_si128(_mm_or_si128(e0, e1), e2);
+					uint32_t rowMask = ~(uint32_t)_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xFu;
+					coverage |= rowMask << (row * OcclusionCuller::TILE_WIDTH + half * 4);
+
+					e0 = _mm_add_epi32(e0, step0);
+					e1 = _mm_add_epi32(e1, step1);
+					e2 = _mm_add_epi32(e2, step2);
+				}
+			}
+
+			return coverage;
+		}
+
+		HB_TARGET_AVX2 uint32_t TileCoverageAvx2(const int32_t* edge, const int32_t (*laneOffset)[8], const int32_t* rowStep)
+		{
+			const __m256i step0 = _mm256_set1_epi32(rowStep[0]);
+			const __m256i step1 = _mm256_set1_epi32(rowStep[1]);
+			const __m256i step2 = _mm256_set1_epi32(rowStep[2]);
+
+			__m256i e0 = _mm256_add_epi32(_mm256_set1_epi32(edge[0]), _mm256_loadu_si256((const __m256i*)laneOffset[0]));
+			__m256i e1 = _mm256_add_epi32(_mm256_set1_epi32(edge[1]), _mm256_loadu_si256((const __m256i*)laneOffset[1]));
+			__m256i e2 = _mm256_add_epi32(_mm256_set1_epi32(edge[2]), _mm256_loadu_si256((const __m256i*)laneOffset[2]));
+
+			uint32_t coverage = 0;
+			for (unsigned int row = 0; row < OcclusionCuller::TILE_HEIGHT; ++row)
+			{
+				__m256i outside = _mm256_or_si256(_mm256_or_si256(e0, e1), e2);
+				uint32_t rowMask = ~(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFFu;
+				coverage |= rowMask << (row * OcclusionCuller::TILE_WIDTH);
+
+				e0 = _mm256_add_epi32(e0, step0);
+				e1 = _mm256_add_epi32(e1, step1);
+				e2 = _mm256_add_epi32(e2, step2);
+			}
+
+			// The callers are built without VEX, avoid the AVX to SSE transition penalty.
+			_mm256_zeroupper();
+			return coverage;
+		}
+
+		// Sutherland-Hodgman against the near plane and the guard band. in and out hold up to 8 vertices,
+		// returns the vertex count of the clipped polygon.
+		unsigned int ClipPolygon(XMFLOAT4* in, unsigned int count, XMFLOAT4* out, unsigned int planeMask)
+		{
+			for (unsigned int plane = 0; plane < 5 && count > 0; ++plane)
+			{
+				if ((planeMask & (1u << plane)) == 0)
+				{
+					continue;
+				}
+
+				unsigned int outCount = 0;
+				for (unsigned int i = 0; i < count; ++i)
+				{
+					const XMFLOAT4& a = in[i];
+					const XMFLOAT4& b = in[(i + 1) % count];
+					float da = PlaneDistance(a, plane);
+					float db = PlaneDistance(b, plane);
+
+					if (da >= 0.0f)
+					{
+						out[outCount++] = a;
+					}
+					if ((da >= 0.0f) != (db >= 0.0f))
+					{
+						float t = da / (da - db);
+						out[outCount++] = XMFLOAT4(
+							a.x + (b.x - a.x) * t,
+							a.y + (b.y - a.y) * t,
+							a.z + (b.z - a.z) * t,
+							a.w + (b.w - a.w) * t);
+					}
+				}
+
+				std::copy(out, out + outCount, in);
+				count = outCount;
+			}
+
+			return count;
+		}
+	}
+
+
+	OcclusionCuller::OcclusionCuller(unsigned int width, unsigned int height, JobSystem* jobSystem)
+		: m_width(width), m_height(height), m_jobSystem(jobSystem)
+	{
+		if (width == 0 || height == 0 || width % TILE_WIDTH != 0 || height % TILE_HEIGHT != 0)
+		{
+			throw std::runtime_error("OcclusionCuller: Buffer size has to be a multiple of the tile size.");
+		}
+		if (width > MAX_SIZE || height > MAX_SIZE)
+		{
+			throw std::runtime_error("OcclusionCuller: Buffer size is too large.");
+		}
+
+		m_tilesX = width / TILE_WIDTH;
+		m_tilesY = height / TILE_HEIGHT;
+
+		m_tileDepth.assign(m_tilesX * m_tilesY, 1.0f);
+		m_maskDepth.assign(m_tilesX * m_tilesY, 0.0f);
+		m_mask.assign(m_tilesX * m_tilesY, 0);
+
+		XMStoreFloat4x4(&m_viewProj, XMMatrixIdentity());
+	}
+
+	void OcclusionCuller::Begin(FXMMATRIX viewProj)
+	{
+		XMStoreFloat4x4(&m_viewProj, viewProj);
+
+		m_clipVertices.clear();
+		for (auto& chunk : m_triangleChunks)
+		{
+			chunk.clear();
+		}
+
+		std::fill(m_tileDepth.begin(), m_tileDepth.end(), 1.0f);
+		std::fill(m_maskDepth.begin(), m_maskDepth.end(), 0.0f);
+		std::fill(m_mask.begin(), m_mask.end(), 0u);
+
+		m_stats = OcclusionCullingStats();
+	}
+
+	void OcclusionCuller::AddOccluder(FXMMATRIX world, const XMFLOAT3* vertices, unsigned int vertexCount,
+		const uint32_t* indices, unsigned int indexCount)
+	{
+		XMMATRIX worldViewProj = XMMatrixMultiply(world, XMLoadFloat4x4(&m_viewProj));
+
+		// Triangles with all vertices outside one of the frustum planes are dropped here, before setup.
+		m_transformedVertices.resize(vertexCount);
+		m_outcodes.resize(vertexCount);
+
+		uint32_t allOutside = 0x3F;
+		for (unsigned int i = 0; i < vertexCount; ++i)
+		{
+			XMFLOAT4& clip = m_transformedVertices[i];
+			XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&vertices[i]), worldViewProj));
+
+			uint32_t outcode = (clip.x < -clip.w ? 0x01 : 0) | (clip.x > clip.w ? 0x02 : 0) |
+				(clip.y < -clip.w ? 0x04 : 0) | (clip.y > clip.w ? 0x08 : 0) |
+				(clip.z < 0.0f ? 0x10 : 0) | (clip.z > clip.w ? 0x20 : 0);
+			m_outcodes[i] = (uint8_t)outcode;
+			allOutside &= outcode;
+		}
+
+		m_stats.occluderCount++;
+		m_stats.triangleCount += indexCount / 3;
+
+		if (allOutside != 0)
+		{
+			return;
+		}
+
+		// A mirroring transform turns the winding around.
+		bool flip = XMVectorGetX(XMMatrixDeterminant(world)) < 0.0f;
+
+		for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+		{
+			uint32_t i0 = indices[i];
+			uint32_t i1 = indices[flip ? i + 2 : i + 1];
+			uint32_t i2 = indices[flip ? i + 1 : i + 2];
+			if ((m_outcodes[i0] & m_outcodes[i1] & m_outcodes[i2]) != 0)
+			{
+				continue;
+			}
+
+			m_clipVertices.push_back(m_transformedVertices[i0]);
+			m_clipVertices.push_back(m_transformedVertices[i1]);
+			m_clipVertices.push_back(m_transformedVertices[i2]);
+		}
+	}
+
+	void OcclusionCuller::AddOccluder(FXMMATRIX world, const BoundingBox& localBox)
+	{
+		XMFLOAT3 corners[8];
+		GetBoxCorners(localBox.Center, localBox.Extents, corners);
+		AddOccluder(world, corners, 8, BOX_INDICES, 36);
+	}
+
+	void OcclusionCuller::Rasterize()
+	{
+		unsigned int triangleCount = (unsigned int)(m_clipVertices.size() / 3);
+		unsigned int chunkCount = (triangleCount + SETUP_CHUNK_SIZE - 1) / SETUP_CHUNK_SIZE;
+
+		if (m_triangleChunks.size() < chunkCount)
+		{
+			m_triangleChunks.resize(chunkCount);
+		}
+
+		auto setupChunk = [this, triangleCount](unsigned int chunk)
+		{
+			std::vector<ScreenTriangle>& triangles = m_triangleChunks[chunk];
+			triangles.clear();
+
+			unsigned int end = std::min(triangleCount, (chunk + 1) * SETUP_CHUNK_SIZE);
+			for (unsigned int i = chunk * SETUP_CHUNK_SIZE; i < end; ++i)
+			{
+				_setupTriangle(&m_clipVertices[i * 3], triangles);
+			}
+		};
+
+		// Every band walks the triangles in the same order, so the result doesn't depend on the bands.
+		unsigned int threadCount = m_jobSystem ? m_jobSystem->GetThreadCount() : 1;
+		unsigned int rowsPerBand = std::max(1u, m_tilesY / (threadCount * 2));
+		unsigned int bandCount = (m_tilesY + rowsPerBand - 1) / rowsPerBand;
+
+		auto rasterizeBand = [this, chunkCount, rowsPerBand](unsigned int band)
+		{
+			int minY = (int)(band * rowsPerBand);
+			int maxY = std::min((int)m_tilesY, minY + (int)rowsPerBand) - 1;
+
+			for (unsigned int chunk = 0; chunk < chunkCount; ++chunk)
+			{
+				for (const ScreenTriangle& triangle : m_triangleChunks[chunk])
+				{
+					if (triangle.tileMaxY >= minY && triangle.tileMinY <= maxY)
+					{
+						_rasterizeTriangle(triangle, minY, maxY);
+					}
+				}
+			}
+		};
+
+		if (m_jobSystem)
+		{
+			m_jobSystem->ParallelFor(chunkCount, setupChunk);
+			m_jobSystem->ParallelFor(bandCount, rasterizeBand);
+		}
+		else
+		{
+			for (unsigned int chunk = 0; chunk < chunkCount; ++chunk)
+			{
+				setupChunk(chunk);
+			}
+			for (unsigned int band = 0; band < bandCount; ++band)
+			{
+				rasterizeBand(band);
+			}
+		}
+
+		m_stats.rasterizedTriangleCount = 0;
+		for (unsigned int chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			m_stats.rasterizedTriangleCount += (unsigned int)m_triangleChunks[chunk].size();
+		}
+	}
+
+	bool OcclusionCuller::IsVisible(const BoundingBox& worldBox)
+	{
+		m_stats.testedCount++;
+
+		XMFLOAT3 corners[8];
+		GetBoxCorners(worldBox.Center, worldBox.Extents, corners);
+
+		XMMATRIX viewProj = XMLoadFloat4x4(&m_viewProj);
+
+		float minX = FLT_MAX;
+		float minY = FLT_MAX;
+		float maxX = -FLT_MAX;
+		float maxY = -FLT_MAX;
+		float minZ = FLT_MAX;
+
+		for (unsigned int i = 0; i < 8; ++i)
+		{
+			XMFLOAT4 clip;
+			XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&corners[i]), viewProj));
+
+			// Boxes crossing the near plane aren't tested.
+			if (clip.w <= FLT_EPSILON || clip.z < 0.0f)
+			{
+				return true;
+			}
+
+			float invW = 1.0f / clip.w;
+			minX = std::min(minX, clip.x * invW);
+			maxX = std::max(maxX, clip.x * invW);
+			minY = std::min(minY, clip.y * invW);
+			maxY = std::max(maxY, clip.y * invW);
+			minZ = std::min(minZ, clip.z * invW);
+		}
+
+		// Every pixel the screen rectangle touches.
+		float width = (float)m_width;
+		float height = (float)m_height;
+		int pixelMinX = (int)std::floor((minX * 0.5f + 0.5f) * width);
+		int pixelMaxX = (int)std::floor((maxX * 0.5f + 0.5f) * width);
+		int pixelMinY = (int)std::floor((0.5f - maxY * 0.5f) * height);
+		int pixelMaxY = (int)std::floor((0.5f - minY * 0.5f) * height);
+
+		// Boxes off the screen are left to frustum culling.
+		if (pixelMaxX < 0 || pixelMaxY < 0 || pixelMinX >= (int)m_width || pixelMinY >= (int)m_height)
+		{
+			return true;
+		}
+
+		pixelMinX = std::max(pixelMinX, 0);
+		pixelMinY = std::max(pixelMinY, 0);
+		pixelMaxX = std::min(pixelMaxX, (int)m_width - 1);
+		pixelMaxY = std::min(pixelMaxY, (int)m_height - 1);
+
+		for (int ty = pixelMinY / (int)TILE_HEIGHT; ty <= pixelMaxY / (int)TILE_HEIGHT; ++ty)
+		{
+			int rowBegin = std::max(pixelMinY - ty * (int)TILE_HEIGHT, 0);
+			int rowEnd = std::min(pixelMaxY - ty * (int)TILE_HEIGHT, (int)TILE_HEIGHT - 1);
+
+			uint32_t rowMask = 0;
+			for (int row = rowBegin; row <= rowEnd; ++row)
+			{
+				rowMask |= 0xFFu << (row * TILE_WIDTH);
+			}
+
+			for (int tx = pixelMinX / (int)TILE_WIDTH; tx <= pixelMaxX / (int)TILE_WIDTH; ++tx)
+			{
+				int columnBegin = std::max(pixelMinX - tx * (int)TILE_WIDTH, 0);
+				int columnEnd = std::min(pixelMaxX - tx * (int)TILE_WIDTH, (int)TILE_WIDTH - 1);
+				uint32_t columns = (0xFFu >> (TILE_WIDTH - 1 - columnEnd)) & (0xFFu << columnBegin);
+				uint32_t rect = rowMask & (columns * 0x01010101u);
+
+				uint32_t tile = ty * m_tilesX + tx;
+				uint32_t mask = m_mask[tile];
+
+				if ((rect & ~mask) != 0 && minZ <= m_tileDepth[tile])
+				{
+					return true;
+				}
+				if ((rect & mask) != 0 && minZ <= m_maskDepth[tile])
+				{
+					return true;
+				}
+			}
+		}
+
+		m_stats.occludedCount++;
+		return false;
+	}
+
+	void OcclusionCuller::GetPixelDepths(std::vector<float>& depths) const
+	{
+		depths.resize(m_width * m_height);
+
+		for (unsigned int y = 0; y < m_height; ++y)
+		{
+			for (unsigned int x = 0; x < m_width; ++x)
+			{
+				uint32_t tile = (y / TILE_HEIGHT) * m_tilesX + x / TILE_WIDTH;
+				uint32_t bit = 1u << ((y % TILE_HEIGHT) * TILE_WIDTH + x % TILE_WIDTH);
+				depths[y * m_width + x] = (m_mask[tile] & bit) ? m_maskDepth[tile] : m_tileDepth[tile];
+			}
+		}
+	}
+
+	void OcclusionCuller::_setupTriangle(const XMFLOAT4* clip, std::vector<ScreenTriangle>& triangles) const
+	{
+		XMFLOAT4 polygon[8] = { clip[0], clip[1], clip[2] };
+		unsigned int count = 3;
+
+		// The planes of PlaneDistance the triangle crosses.
+		unsigned int planeMask = 0;
+		for (unsigned int i = 0; i < 3; ++i)
+		{
+			float guardBand = GUARD_BAND * clip[i].w;
+			planeMask |= (clip[i].z < 0.0f ? 0x01 : 0) | (clip[i].x < -guardBand ? 0x02 : 0) | (clip[i].x > guardBand ? 0x04 : 0) |
+				(clip[i].y < -guardBand ? 0x08 : 0) | (clip[i].y > guardBand ? 0x10 : 0);
+		}
+
+		if (planeMask != 0)
+		{
+			XMFLOAT4 scratch[8];
+			count = ClipPolygon(polygon, count, scratch, planeMask);
+			if (count < 3)
+			{
+				return;
+			}
+		}
+
+		int32_t x[8];
+		int32_t y[8];
+		float z[8];
+
+		float width = (float)m_width;
+		float height = (float)m_height;
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			float invW = 1.0f / polygon[i].w;
+			float screenX = (polygon[i].x * invW * 0.5f + 0.5f) * width;
+			float screenY = (0.5f - polygon[i].y * invW * 0.5f) * height;
+			x[i] = (int32_t)std::floor(screenX * SUBPIXELS + 0.5f);
+			y[i] = (int32_t)std::floor(screenY * SUBPIXELS + 0.5f);
+			z[i] = polygon[i].z * invW;
+		}
+
+		for (unsigned int k = 1; k + 1 < count; ++k)
+		{
+			const unsigned int v[3] = { 0, k, k + 1 };
+
+			// Counter-clockwise and degenerate triangles are culled.
+			int64_t area = (int64_t)(x[v[1]] - x[v[0]]) * (y[v[2]] - y[v[0]]) - (int64_t)(y[v[1]] - y[v[0]]) * (x[v[2]] - x[v[0]]);
+			if (area <= 0)
+			{
+				continue;
+			}
+
+			float zMin = std::min(z[v[0]], std::min(z[v[1]], z[v[2]]));
+			if (zMin >= 1.0f)
+			{
+				continue;
+			}
+
+			// Pixels whose center lies inside the bounds, the arithmetic shifts round towards negative infinity.
+			int32_t boundsMinX = std::min(x[v[0]], std::min(x[v[1]], x[v[2]]));
+			int32_t boundsMaxX = std::max(x[v[0]], std::max(x[v[1]], x[v[2]]));
+			int32_t boundsMinY = std::min(y[v[0]], std::min(y[v[1]], y[v[2]]));
+			int32_t boundsMaxY = std::max(y[v[0]], std::max(y[v[1]], y[v[2]]));
+
+			int32_t pixelMinX = std::max((boundsMinX + SUBPIXELS / 2 - 1) >> SUBPIXEL_BITS, 0);
+			int32_t pixelMaxX = std::min((boundsMaxX - SUBPIXELS / 2) >> SUBPIXEL_BITS, (int32_t)m_width - 1);
+			int32_t pixelMinY = std::max((boundsMinY + SUBPIXELS / 2 - 1) >> SUBPIXEL_BITS, 0);
+			int32_t pixelMaxY = std::min((boundsMaxY - SUBPIXELS / 2) >> SUBPIXEL_BITS, (int32_t)m_height - 1);
+			if (pixelMinX > pixelMaxX || pixelMinY > pixelMaxY)
+			{
+				continue;
+			}
+
+			ScreenTriangle triangle;
+			triangle.tileMinX = pixelMinX / (int32_t)TILE_WIDTH;
+			triangle.tileMaxX = pixelMaxX / (int32_t)TILE_WIDTH;
+			triangle.tileMinY = pixelMinY / (int32_t)TILE_HEIGHT;
+			triangle.tileMaxY = pixelMaxY / (int32_t)TILE_HEIGHT;
+
+			for (unsigned int e = 0; e < 3; ++e)
+			{
+				unsigned int i = v[e];
+				unsigned int j = v[(e + 1) % 3];
+
+				int32_t a = y[i] - y[j];
+				int32_t b = x[j] - x[i];
+				int64_t c = -((int64_t)a * x[i] + (int64_t)b * y[i]);
+
+				// Top-left rule: a pixel center on an edge belongs to one of the two triangles sharing it.
+				bool owned = a > 0 || (a == 0 && b > 0);
+
+				triangle.edgeA[e] = a;
+				triangle.edgeB[e] = b;
+				triangle.edgeC[e] = owned ? c : c - 1;
+			}
+
+			// Depth plane over pixel coordinates from the snapped positions.
+			float x0 = x[v[0]] / (float)SUBPIXELS;
+			float y0 = y[v[0]] / (float)SUBPIXELS;
+			float dx1 = x[v[1]] / (float)SUBPIXELS - x0;
+			float dy1 = y[v[1]] / (float)SUBPIXELS - y0;
+			float dx2 = x[v[2]] / (float)SUBPIXELS - x0;
+			float dy2 = y[v[2]] / (float)SUBPIXELS - y0;
+			float dz1 = z[v[1]] - z[v[0]];
+			float dz2 = z[v[2]] - z[v[0]];
+			float invDet = 1.0f / (dx1 * dy2 - dy1 * dx2);
+
+			triangle.zA = (dz1 * dy2 - dz2 * dy1) * invDet;
+			triangle.zB = (dz2 * dx1 - dz1 * dx2) * invDet;
+			triangle.zC = z[v[0]] - triangle.zA * x0 - triangle.zB * y0;
+			triangle.zMax = std::max(z[v[0]], std::max(z[v[1]], z[v[2]]));
+
+			triangles.push_back(triangle);
+		}
+	}
+
+	void OcclusionCuller::_rasterizeTriangle(const ScreenTriangle& triangle, int tileMinY, int tileMaxY)
+	{
+		const int32_t tileStepX = (int32_t)TILE_WIDTH * SUBPIXELS;
+		const int32_t tileStepY = (int32_t)TILE_HEIGHT * SUBPIXELS;
+
+		int32_t stepX[3];
+		int32_t stepY[3];
+		for (unsigned int e = 0; e < 3; ++e)
+		{
+			stepX[e] = triangle.edgeA[e] * SUBPIXELS;
+			stepY[e] = triangle.edgeB[e] * SUBPIXELS;
+		}
+
+		// Offsets of the edge functions along a tile row, one lane per pixel.
+		int32_t laneOffset[3][TILE_WIDTH];
+		for (unsigned int e = 0; e < 3; ++e)
+		{
+			for (unsigned int lane = 0; lane < TILE_WIDTH; ++lane)
+			{
+				laneOffset[e][lane] = (int32_t)((uint32_t)lane * (uint32_t)stepX[e]);
+			}
+		}
+
+		const TileCoverageFunction tileCoverage = GetCpuFeatures().avx2 ? TileCoverageAvx2 : TileCoverageSse;
+
+		int minY = std::max(triangle.tileMinY, tileMinY);
+		int maxY = std::min(triangle.tileMaxY, tileMaxY);
+
+		for (int ty = minY; ty <= maxY; ++ty)
+		{
+			// Pixel center of the first pixel in the tile.
+			int64_t originY = (int64_t)ty * tileStepY + SUBPIXELS / 2;
+			float pixelY0 = ty * (float)TILE_HEIGHT + 0.5f;
+			float pixelY1 = pixelY0 + (float)(TILE_HEIGHT - 1);
+			float zRow = triangle.zC + std::max(triangle.zB * pixelY0, triangle.zB * pixelY1);
+
+			for (int tx = triangle.tileMinX; tx <= triangle.tileMaxX; ++tx)
+			{
+				uint32_t tile = ty * m_tilesX + tx;
+
+				// Farthest depth of the triangle's plane over the tile.
+				float pixelX0 = tx * (float)TILE_WIDTH + 0.5f;
+				float pixelX1 = pixelX0 + (float)(TILE_WIDTH - 1);
+				float depth = std::min(zRow + std::max(triangle.zA * pixelX0, triangle.zA * pixelX1), triangle.zMax);
+				if (depth >= m_tileDepth[tile])
+				{
+					continue;
+				}
+
+				int64_t originX = (int64_t)tx * tileStepX + SUBPIXELS / 2;
+
+				int32_t edge[3];
+				for (unsigned int e = 0; e < 3; ++e)
+				{
+					int64_t value = triangle.edgeA[e] * originX + triangle.edgeB[e] * originY + triangle.edgeC[e];
+					edge[e] = (int32_t)std::max(-EDGE_CLAMP, std::min(value, EDGE_CLAMP));
+				}
+
+				uint32_t coverage = tileCoverage(edge, laneOffset, stepY);
+				if (coverage != 0)
+				{
+					_updateTile(tile, coverage, depth);
+				}
+			}
+		}
+	}
+
+	void OcclusionCuller::_updateTile(uint32_t tile, uint32_t coverage, float depth)
+	{
+		float& tileDepth = m_tileDepth[tile];
+		float& maskDepth = m_maskDepth[tile];
+		uint32_t& mask = m_mask[tile];
+
+		if (depth >= tileDepth)
+		{
+			return;
+		}
+
+		// A triangle much nearer than the masked pixels starts a new mask, the old one falls back to the
+		// tile depth.
+		if (maskDepth - depth > tileDepth - maskDepth)
+		{
+			maskDepth = 0.0f;
+			mask = 0;
+		}
+
+		maskDepth = std::max(maskDepth, depth);
+		mask |= coverage;
+
+		if (mask == FULL_MASK)
+		{
+			tileDepth = maskDepth;
+			maskDepth = 0.0f;
+			mask = 0;
+		}
+	}
+}
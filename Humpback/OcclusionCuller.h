@@ -0,0 +1,128 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+
+namespace Humpback
+{
+	class JobSystem;
+
+	struct OcclusionCullingStats
+	{
+		unsigned int occluderCount = 0;
+		unsigned int triangleCount = 0;
+		unsigned int rasterizedTriangleCount = 0;
+		unsigned int testedCount = 0;
+		unsigned int occludedCount = 0;
+	};
+
+
+	// Masked software occlusion culling. Occluder triangles are rasterized on the CPU into a small depth
+	// buffer of 8x4 pixel tiles, a tile holds a 32 bit coverage mask and two depths instead of 32 pixels:
+	// the farthest depth of the whole tile, and the farthest depth of the pixels in the mask. Triangles are
+	// merged into the mask until it covers the tile, which then moves the tile depth nearer. The tile depths
+	// are the coarse level objects are tested against.
+	//
+	// Edge functions are evaluated in 28.4 fixed point, so coverage doesn't depend on the SIMD width. Tiles
+	// are rasterized 8 pixels a row at a time with AVX2 (two SSE2 batches without it, the path is picked at
+	// runtime, see CpuFeatures), in bands of tile rows on the job system. The result is the same for any
+	// thread count and either path.
+	//
+	// Depth is the D3D clip space z / w, 0 at the near plane. An object is only reported hidden if every
+	// buffer pixel its screen rectangle touches is covered by nearer occluders. Coverage is sampled at the
+	// buffer's pixel centers, so that holds at the buffer resolution, not at the resolution drawn at.
+	class OcclusionCuller
+	{
+	public:
+
+		static const unsigned int TILE_WIDTH = 8;
+		static const unsigned int TILE_HEIGHT = 4;
+
+		// The size has to be a multiple of the tile size and at most 1024 pixels on either side.
+		OcclusionCuller(unsigned int width, unsigned int height, JobSystem* jobSystem = nullptr);
+		OcclusionCuller(const OcclusionCuller&) = delete;
+		OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+		// Clears the buffer and the occluders of the previous view.
+		void Begin(DirectX::FXMMATRIX viewProj);
+
+		// Triangles facing away (counter-clockwise on screen, as D3D culls them) are skipped, the geometry
+		// has to lie inside the object it stands for.
+		void AddOccluder(DirectX::FXMMATRIX world, const DirectX::XMFLOAT3* vertices, unsigned int vertexCount,
+			const uint32_t* indices, unsigned int indexCount);
+		// For objects that fill their box, like the boxes and walls of a level.
+		void AddOccluder(DirectX::FXMMATRIX world, const DirectX::BoundingBox& localBox);
+
+		// Rasterizes the occluders added since Begin.
+		void Rasterize();
+
+		// False when the world space box is hidden behind the rasterized occluders.
+		bool IsVisible(const DirectX::BoundingBox& worldBox);
+
+		// Farthest depth each pixel can have, for validation and debug views.
+		void GetPixelDepths(std::vector<float>& depths) const;
+
+		unsigned int GetWidth() const { return m_width; }
+		unsigned int GetHeight() const { return m_height; }
+		const OcclusionCullingStats& GetStats() const { return m_stats; }
+
+	private:
+
+		// Triangle in screen space, ready to rasterize.
+		struct ScreenTriangle
+		{
+			// Edge function i is edgeA[i] * X + edgeB[i] * Y + edgeC[i] with X, Y in 28.4 fixed point,
+			// biased so a pixel is covered when all three are >= 0.
+			int32_t edgeA[3];
+			int32_t edgeB[3];
+			int64_t edgeC[3];
+
+			// Depth plane over pixel coordinates, and the farthest vertex depth.
+			float zA;
+			float zB;
+			float zC;
+			float zMax;
+
+			// Inclusive tile range.
+			int32_t tileMinX;
+			int32_t tileMinY;
+			int32_t tileMaxX;
+			int32_t tileMaxY;
+		};
+
+		void _setupTriangle(const DirectX::XMFLOAT4* clip, std::vector<ScreenTriangle>& triangles) const;
+		void _rasterizeTriangle(const ScreenTriangle& triangle, int tileMinY, int tileMaxY);
+		void _updateTile(uint32_t tile, uint32_t coverage, float depth);
+
+		unsigned int m_width = 0;
+		unsigned int m_height = 0;
+		unsigned int m_tilesX = 0;
+		unsigned int m_tilesY = 0;
+
+		JobSystem* m_jobSystem = nullptr;
+
+		DirectX::XMFLOAT4X4 m_viewProj;
+
+		// Vertices of the occluder being added, in clip space, and the frustum planes each one is outside of.
+		std::vector<DirectX::XMFLOAT4> m_transformedVertices;
+		std::vector<uint8_t> m_outcodes;
+
+		// Occluder triangles in clip space, three vertices each.
+		std::vector<DirectX::XMFLOAT4> m_clipVertices;
+		std::vector<std::vector<ScreenTriangle>> m_triangleChunks;
+
+		// Per tile: the depth of the whole tile, the depth of the covered pixels and their mask.
+		std::vector<float> m_tileDepth;
+		std::vector<float> m_maskDepth;
+		std::vector<uint32_t> m_mask;
+
+		OcclusionCullingStats m_stats;
+	};
+}
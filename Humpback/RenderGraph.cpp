@@ -0,0 +1,464 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "RenderGraph.h"
+
+
+namespace Humpback
+{
+	void RenderGraph::PassBuilder::Read(RGResourceHandle resource, RGResourceState state)
+	{
+		if (resource >= m_graph->m_resources.size())
+		{
+			throw std::runtime_error("Invalid render graph resource.");
+		}
+
+		m_graph->m_passes[m_passIndex].accesses.push_back({ resource, state, false });
+	}
+
+	void RenderGraph::PassBuilder::Write(RGResourceHandle resource, RGResourceState state)
+	{
+		if (resource >= m_graph->m_resources.size())
+		{
+			throw std::runtime_error("Invalid render graph resource.");
+		}
+
+		m_graph->m_passes[m_passIndex].accesses.push_back({ resource, state, true });
+	}
+
+	void RenderGraph::PassBuilder::HasSideEffect()
+	{
+		m_graph->m_passes[m_passIndex].hasSideEffect = true;
+	}
+
+	RGResourceHandle RenderGraph::ImportResource(const std::string& name, RGResourceState initialState,
+		RGResourceState finalState, bool isOutput)
+	{
+		ResourceNode node;
+		node.name = name;
+		node.isImported = true;
+		node.isOutput = isOutput;
+		node.initialState = initialState;
+		node.finalState = finalState;
+
+		m_resources.push_back(node);
+		m_compiled = false;
+
+		return (RGResourceHandle)(m_resources.size() - 1);
+	}
+
+	RGResourceHandle RenderGraph::CreateTransient(const std::string& name, uint64_t sizeInBytes, uint64_t alignment)
+	{
+		ResourceNode node;
+		node.name = name;
+		node.size = sizeInBytes;
+		node.alignment = alignment == 0 ? 1 : alignment;
+
+		m_resources.push_back(node);
+		m_compiled = false;
+
+		return (RGResourceHandle)(m_resources.size() - 1);
+	}
+
+	void RenderGraph::AddPass(const std::string& name, const SetupFunc& setup, const ExecuteFunc& execute)
+	{
+		PassNode pass;
+		pass.name = name;
+		pass.execute = execute;
+		m_passes.push_back(pass);
+
+		PassBuilder builder(this, (unsigned int)(m_passes.size() - 1));
+		if (setup)
+		{
+			setup(builder);
+		}
+
+		m_compiled = false;
+	}
+
+	void RenderGraph::Clear()
+	{
+		m_resources.clear();
+		m_passes.clear();
+		m_schedule.clear();
+		m_batches.clear();
+		m_stats = RenderGraphStats();
+		m_compiled = false;
+	}
+
+	bool RenderGraph::IsPassCulled(const std::string& name) const
+	{
+		for (auto& pass : m_passes)
+		{
+			if (pass.name == name)
+			{
+				return pass.culled;
+			}
+		}
+
+		return true;
+	}
+
+	bool RenderGraph::IsTransient(RGResourceHandle resource) const
+	{
+		return m_resources[resource].isImported == false;
+	}
+
+	uint64_t RenderGraph::GetTransientOffset(RGResourceHandle resource) const
+	{
+		return m_resources[resource].aliasOffset;
+	}
+
+	RGResourceState RenderGraph::GetTransientState(RGResourceHandle resource) const
+	{
+		return m_resources[resource].initialState;
+	}
+
+	const std::string& RenderGraph::GetResourceName(RGResourceHandle resource) const
+	{
+		return m_resources[resource].name;
+	}
+
+	void RenderGraph::Compile()
+	{
+		m_stats = RenderGraphStats();
+
+		_cullPasses();
+		_buildSchedule();
+		_computeLifetimes();
+		_aliasTransients();
+		_buildBarriers();
+
+		m_compiled = true;
+	}
+
+	void RenderGraph::Execute(RenderGraphBackend& backend)
+	{
+		if (m_compiled == false)
+		{
+			Compile();
+		}
+
+		for (size_t i = 0; i < m_schedule.size(); i++)
+		{
+			auto& batch = m_batches[i];
+			if (batch.empty() == false)
+			{
+				backend.ResourceBarriers(batch.data(), (unsigned int)batch.size());
+			}
+
+			auto& pass = m_passes[m_schedule[i]];
+			backend.BeginPass(pass.name);
+			if (pass.execute)
+			{
+				pass.execute();
+			}
+			backend.EndPass();
+		}
+
+		auto& finalBatch = m_batches.back();
+		if (finalBatch.empty() == false)
+		{
+			backend.ResourceBarriers(finalBatch.data(), (unsigned int)finalBatch.size());
+		}
+	}
+
+	void RenderGraph::_cullPasses()
+	{
+		// Walk the passes backwards. A pass survives if it has side effects or writes
+		// a resource which is an output or read by a surviving pass.
+		std::vector<bool> needed(m_resources.size(), false);
+		for (size_t i = 0; i < m_resources.size(); i++)
+		{
+			needed[i] = m_resources[i].isOutput;
+		}
+
+		for (int i = (int)m_passes.size() - 1; i >= 0; i--)
+		{
+			auto& pass = m_passes[i];
+
+			bool alive = pass.hasSideEffect;
+			for (auto& access : pass.accesses)
+			{
+				if (access.isWrite && needed[access.resource])
+				{
+					alive = true;
+					break;
+				}
+			}
+
+			pass.culled = !alive;
+			if (pass.culled)
+			{
+				++m_stats.culledPassCount;
+				continue;
+			}
+
+			for (auto& access : pass.accesses)
+			{
+				if (access.isWrite == false)
+				{
+					needed[access.resource] = true;
+				}
+			}
+		}
+	}
+
+	void RenderGraph::_buildSchedule()
+	{
+		const size_t passCount = m_passes.size();
+
+		// Derive the dependencies from the declaration order of the accesses:
+		// read after write, write after read and write after write.
+		std::vector<std::vector<unsigned int>> successors(passCount);
+		std::vector<unsigned int> inDegree(passCount, 0);
+
+		auto addEdge = [&](int from, unsigned int to)
+		{
+			if (from < 0 || (unsigned int)from == to)
+			{
+				return;
+			}
+
+			auto& succ = successors[from];
+			if (std::find(succ.begin(), succ.end(), to) == succ.end())
+			{
+				succ.push_back(to);
+				++inDegree[to];
+			}
+		};
+
+		std::vector<int> lastWriter(m_resources.size(), -1);
+		std::vector<std::vector<unsigned int>> readersSinceWrite(m_resources.size());
+
+		for (unsigned int p = 0; p < passCount; p++)
+		{
+			if (m_passes[p].culled)
+			{
+				continue;
+			}
+
+			for (auto& access : m_passes[p].accesses)
+			{
+				auto r = access.resource;
+				addEdge(lastWriter[r], p);
+
+				if (access.isWrite)
+				{
+					for (auto reader : readersSinceWrite[r])
+					{
+						addEdge((int)reader, p);
+					}
+					readersSinceWrite[r].clear();
+					lastWriter[r] = (int)p;
+				}
+				else
+				{
+					readersSinceWrite[r].push_back(p);
+				}
+			}
+		}
+
+		// Kahn's algorithm, ties are broken by the declaration order.
+		m_schedule.clear();
+		std::vector<unsigned int> ready;
+		for (unsigned int p = 0; p < passCount; p++)
+		{
+			if (m_passes[p].culled == false && inDegree[p] == 0)
+			{
+				ready.push_back(p);
+			}
+		}
+
+		while (ready.empty() == false)
+		{
+			auto it = std::min_element(ready.begin(), ready.end());
+			unsigned int p = *it;
+			ready.erase(it);
+
+			m_schedule.push_back(p);
+
+			for (auto s : successors[p])
+			{
+				if (--inDegree[s] == 0)
+				{
+					ready.push_back(s);
+				}
+			}
+		}
+
+		m_stats.passCount = (unsigned int)m_schedule.size();
+	}
+
+	void RenderGraph::_computeLifetimes()
+	{
+		for (auto& res : m_resources)
+		{
+			res.firstUse = -1;
+			res.lastUse = -1;
+		}
+
+		for (int i = 0; i < (int)m_schedule.size(); i++)
+		{
+			for (auto& access : m_passes[m_schedule[i]].accesses)
+			{
+				auto& res = m_resources[access.resource];
+				if (res.firstUse < 0)
+				{
+					res.firstUse = i;
+
+					// A transient is created in the state of its first access and returned to it.
+					if (res.isImported == false)
+					{
+						res.initialState = access.state;
+						res.finalState = access.state;
+					}
+				}
+				res.lastUse = i;
+			}
+		}
+	}
+
+	void RenderGraph::_aliasTransients()
+	{
+		std::vector<unsigned int> transients;
+		for (unsigned int i = 0; i < m_resources.size(); i++)
+		{
+			auto& res = m_resources[i];
+			if (res.isImported == false && res.firstUse >= 0)
+			{
+				transients.push_back(i);
+				m_stats.transientMemoryUnaliased += res.size;
+			}
+		}
+
+		// Place the biggest resources first, each one at the lowest offset which
+		// does not overlap a placed resource with an intersecting lifetime.
+		std::stable_sort(transients.begin(), transients.end(), [&](unsigned int a, unsigned int b)
+			{
+				return m_resources[a].size > m_resources[b].size;
+			});
+
+		std::vector<unsigned int> placed;
+		for (auto idx : transients)
+		{
+			auto& res = m_resources[idx];
+
+			std::vector<std::pair<uint64_t, uint64_t>> occupied;
+			for (auto other : placed)
+			{
+				auto& o = m_resources[other];
+				if (o.firstUse <= res.lastUse && res.firstUse <= o.lastUse)
+				{
+					occupied.push_back({ o.aliasOffset, o.aliasOffset + o.size });
+				}
+			}
+			std::sort(occupied.begin(), occupied.end());
+
+			uint64_t offset = 0;
+			for (auto& range : occupied)
+			{
+				uint64_t aligned = (offset + res.alignment - 1) / res.alignment * res.alignment;
+				if (aligned + res.size <= range.first)
+				{
+					break;
+				}
+				offset = std::max(offset, range.second);
+			}
+			offset = (offset + res.alignment - 1) / res.alignment * res.alignment;
+
+			res.aliasOffset = offset;
+			placed.push_back(idx);
+
+			m_stats.transientMemoryPeak = std::max(m_stats.transientMemoryPeak, offset + res.size);
+		}
+	}
+
+	void RenderGraph::_buildBarriers()
+	{
+		m_batches.clear();
+		m_batches.resize(m_schedule.size() + 1);
+
+		std::vector<RGResourceState> curState(m_resources.size());
+		std::vector<int> lastAccess(m_resources.size(), -1);
+		for (size_t i = 0; i < m_resources.size(); i++)
+		{
+			curState[i] = m_resources[i].initialState;
+		}
+
+		for (int i = 0; i < (int)m_schedule.size(); i++)
+		{
+			for (auto& access : m_passes[m_schedule[i]].accesses)
+			{
+				auto r = access.resource;
+				auto& res = m_resources[r];
+
+				if (lastAccess[r] == i)
+				{
+					if (curState[r] != access.state)
+					{
+						throw std::runtime_error("Conflicting states for " + res.name + " in one pass.");
+					}
+					continue;
+				}
+
+				if (res.isImported == false && res.firstUse == i)
+				{
+					// Activate the memory of a transient which may be shared with a retired one.
+					RGBarrier alias;
+					alias.resource = r;
+					alias.isAliasing = true;
+					alias.after = access.state;
+					for (unsigned int o = 0; o < m_resources.size(); o++)
+					{
+						auto& other = m_resources[o];
+						if (o != r && other.isImported == false && other.firstUse >= 0 && other.lastUse < i &&
+							other.aliasOffset < res.aliasOffset + res.size &&
+							res.aliasOffset < other.aliasOffset + other.size)
+						{
+							alias.aliasBefore = o;
+						}
+					}
+					m_batches[i].push_back(alias);
+				}
+				else if (curState[r] != access.state)
+				{
+					// Hoist the transition right after the previous access so that
+					// transitions of different resources end up in the same batch.
+					RGBarrier transition;
+					transition.resource = r;
+					transition.before = curState[r];
+					transition.after = access.state;
+					m_batches[lastAccess[r] + 1].push_back(transition);
+				}
+
+				curState[r] = access.state;
+				lastAccess[r] = i;
+			}
+		}
+
+		for (unsigned int r = 0; r < m_resources.size(); r++)
+		{
+			auto& res = m_resources[r];
+			bool isUsed = res.isImported || res.firstUse >= 0;
+			if (isUsed && res.finalState != RGResourceState::Undefined && curState[r] != res.finalState)
+			{
+				RGBarrier transition;
+				transition.resource = r;
+				transition.before = curState[r];
+				transition.after = res.finalState;
+				m_batches[lastAccess[r] + 1].push_back(transition);
+			}
+		}
+
+		for (auto& batch : m_batches)
+		{
+			m_stats.barrierCount += (unsigned int)batch.size();
+			m_stats.barrierBatchCount += batch.empty() ? 0 : 1;
+		}
+	}
+}
@@ -0,0 +1,207 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+
+namespace Humpback
+{
+	// Backend agnostic resource states used by the render graph.
+	// The backend maps them to the native API states.
+	enum class RGResourceState : unsigned int
+	{
+		Undefined = 0,
+		Common,
+		GenericRead,
+		ShaderResource,
+		RenderTarget,
+		DepthWrite,
+		DepthRead,
+		CopySource,
+		CopyDest,
+		Present,
+	};
+
+	using RGResourceHandle = unsigned int;
+
+	static const RGResourceHandle RG_INVALID_HANDLE = 0xffffffff;
+
+	struct RGBarrier
+	{
+		RGResourceHandle resource = RG_INVALID_HANDLE;
+		RGResourceState before = RGResourceState::Undefined;
+		RGResourceState after = RGResourceState::Undefined;
+
+		// Aliasing barriers activate a transient resource that shares memory with another one.
+		bool isAliasing = false;
+		RGResourceHandle aliasBefore = RG_INVALID_HANDLE;
+	};
+
+	class RenderGraphBackend
+	{
+	public:
+		virtual ~RenderGraphBackend() = default;
+
+		// Called once per merged barrier batch.
+		virtual void ResourceBarriers(const RGBarrier* barriers, unsigned int count) = 0;
+
+		virtual void BeginPass(const std::string&) {}
+		virtual void EndPass() {}
+	};
+
+	// Backend which only records what the graph asks for.
+	// Used to inspect a compiled schedule without a GPU.
+	class RecordingRenderGraphBackend : public RenderGraphBackend
+	{
+	public:
+		void ResourceBarriers(const RGBarrier* pBarriers, unsigned int count) override
+		{
+			++batchCount;
+			barrierCount += count;
+			barriers.insert(barriers.end(), pBarriers, pBarriers + count);
+		}
+
+		void BeginPass(const std::string& passName) override
+		{
+			passes.push_back(passName);
+		}
+
+		void Reset()
+		{
+			batchCount = 0;
+			barrierCount = 0;
+			barriers.clear();
+			passes.clear();
+		}
+
+		unsigned int batchCount = 0;
+		unsigned int barrierCount = 0;
+		std::vector<RGBarrier> barriers;
+		std::vector<std::string> passes;
+	};
+
+	struct RenderGraphStats
+	{
+		unsigned int passCount = 0;
+		unsigned int culledPassCount = 0;
+		unsigned int barrierCount = 0;
+		unsigned int barrierBatchCount = 0;
+
+		uint64_t transientMemoryUnaliased = 0;
+		uint64_t transientMemoryPeak = 0;
+	};
+
+
+	class RenderGraph
+	{
+	public:
+
+		class PassBuilder
+		{
+		public:
+			void Read(RGResourceHandle resource, RGResourceState state);
+			void Write(RGResourceHandle resource, RGResourceState state);
+
+			// Passes with side effects are never culled.
+			void HasSideEffect();
+
+		private:
+			friend class RenderGraph;
+
+			PassBuilder(RenderGraph* graph, unsigned int passIndex) :
+				m_graph(graph), m_passIndex(passIndex) {}
+
+			RenderGraph* m_graph;
+			unsigned int m_passIndex;
+		};
+
+		using SetupFunc = std::function<void(PassBuilder&)>;
+		using ExecuteFunc = std::function<void()>;
+
+		RenderGraph() = default;
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph& operator=(const RenderGraph&) = delete;
+
+		// Externally owned resource. Its state is restored to finalState at the end of the graph.
+		RGResourceHandle ImportResource(const std::string& name, RGResourceState initialState,
+			RGResourceState finalState, bool isOutput = false);
+
+		// Graph owned resource whose memory may be aliased with other transients.
+		// Between frames it is kept in the state of its first access.
+		RGResourceHandle CreateTransient(const std::string& name, uint64_t sizeInBytes, uint64_t alignment);
+
+		void AddPass(const std::string& name, const SetupFunc& setup, const ExecuteFunc& execute);
+
+		void Compile();
+		void Execute(RenderGraphBackend& backend);
+		void Clear();
+
+		bool IsCompiled() const { return m_compiled; }
+		bool IsPassCulled(const std::string& name) const;
+		unsigned int GetResourceCount() const { return (unsigned int)m_resources.size(); }
+		bool IsTransient(RGResourceHandle resource) const;
+		uint64_t GetTransientOffset(RGResourceHandle resource) const;
+		RGResourceState GetTransientState(RGResourceHandle resource) const;
+		const std::string& GetResourceName(RGResourceHandle resource) const;
+		const RenderGraphStats& GetStats() const { return m_stats; }
+
+	private:
+
+		struct ResourceAccess
+		{
+			RGResourceHandle resource;
+			RGResourceState state;
+			bool isWrite;
+		};
+
+		struct ResourceNode
+		{
+			std::string name;
+			bool isImported = false;
+			bool isOutput = false;
+			RGResourceState initialState = RGResourceState::Undefined;
+			RGResourceState finalState = RGResourceState::Undefined;
+
+			uint64_t size = 0;
+			uint64_t alignment = 1;
+			uint64_t aliasOffset = 0;
+
+			// Lifetime in schedule order, valid after compilation.
+			int firstUse = -1;
+			int lastUse = -1;
+		};
+
+		struct PassNode
+		{
+			std::string name;
+			ExecuteFunc execute;
+			std::vector<ResourceAccess> accesses;
+			bool hasSideEffect = false;
+			bool culled = false;
+		};
+
+		void _cullPasses();
+		void _buildSchedule();
+		void _computeLifetimes();
+		void _aliasTransients();
+		void _buildBarriers();
+
+		std::vector<ResourceNode>	m_resources;
+		std::vector<PassNode>		m_passes;
+
+		// Compiled data.
+		std::vector<unsigned int>	m_schedule;
+
+		// m_batches[i] is issued before m_schedule[i], the last one after the final pass.
+		std::vector<std::vector<RGBarrier>> m_batches;
+
+		RenderGraphStats			m_stats;
+		bool						m_compiled = false;
+	};
+}
@@ -9,53 +9,68 @@
 #include <DirectXMath.h>
 #include <DirectXCollision.h>
 
-#include "HMathHelper.h"
 #include "Mesh.h"
 #include "Material.h"
 
 
-using DirectX::XMFLOAT4X4;
-
 namespace Humpback
 {
 
 	extern const int FRAME_RESOURCE_COUNT;
 
-	struct InstanceData
+	class RenderableObject;
+
+	// Visible objects sharing geometry, drawn with one DrawIndexedInstanced call.
+	// Their object ids are stored contiguously in the instance buffer from firstInstance on.
+	struct InstanceGroup
 	{
-		DirectX::XMFLOAT4X4 worldMatrix = HMathHelper::Identity4x4();
-		unsigned int materialIndex = 0;
-		unsigned int pad0 = 0;
-		unsigned int pad1 = 0;
-		unsigned int pad2 = 0;
+		RenderableObject* object = nullptr;
+		unsigned int firstInstance = 0;
+		unsigned int instanceCount = 0;
+
+		// Visible meshlet ranges of a single instance after cluster culling, one draw each.
+		// Without ranges the whole submesh is drawn.
+		unsigned int firstRange = 0;
+		unsigned int rangeCount = 0;
 	};
 
+	// What to draw, fixed once created. The state that changes per frame, the world transform, the bounds
+	// and the material index, lives in the RenderableStore under id.
 	class RenderableObject
 	{
 	public:
 		RenderableObject() = default;
 
 
-		XMFLOAT4X4 worldM = HMathHelper::Identity4x4();
+		unsigned int id = 0;
+		unsigned int transformNode = 0;
 
-		XMFLOAT4X4 texTrans = HMathHelper::Identity4x4();
+		// Where the world bounds live in the scene BVHs.
+		unsigned int layer = 0;
+		unsigned int cullIndex = 0;
 
-		int NumFramesDirty = FRAME_RESOURCE_COUNT;
+		// Solid objects filling their local bounds, rasterized into the occlusion buffers as boxes.
+		bool occluder = false;
 
 		Mesh* mesh = nullptr;
 		Material* material = nullptr;
-		
-		DirectX::BoundingBox aabb;
 
 		D3D12_PRIMITIVE_TOPOLOGY primitiveTopology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
-		std::vector<InstanceData> instances;
+		// Small ids packed into the draw sort key: one per mesh, and one per drawn range counted within its mesh.
+		unsigned int meshId = 0;
+		unsigned int geometryId = 0;
 
-		unsigned int cbIndex = 0;
-
-		unsigned int instanceCount = 0;
 		unsigned int indexCount = 0;
 		unsigned int startIndexLocation = 0;
 		unsigned int baseVertexLocation = 0;
+
+		// Meshlets of the drawn submesh, they point into the mesh.
+		const Meshlet* meshlets = nullptr;
+		unsigned int meshletCount = 0;
+
+		// Batches of the drawn submesh, one draw each instead of the whole range when there are any.
+		const IndexBatch* indexBatches = nullptr;
+		unsigned int indexBatchCount = 0;
 	};
 }
\ No newline at end of file
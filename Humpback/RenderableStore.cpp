@@ -0,0 +1,71 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include "RenderableStore.h"
+
+
+using namespace DirectX;
+
+
+namespace Humpback
+{
+	RenderableStore::RenderableStore(unsigned int frameResourceCount) :
+		m_uploads(frameResourceCount)
+	{
+	}
+
+	uint32_t RenderableStore::Add(const BoundingBox& localBounds, const PositionQuantization& quantization, uint32_t materialIndex)
+	{
+		uint32_t id = GetCount();
+
+		ObjectData data;
+		data.positionScale = quantization.scale;
+		data.positionOffset = quantization.offset;
+		data.materialIndex = materialIndex;
+
+		m_worldTransforms.push_back(HMathHelper::Identity4x4());
+		m_localBounds.push_back(localBounds);
+		m_objectData.push_back(data);
+		m_flags.push_back(0);
+
+		// New records are pending for every frame resource.
+		m_uploads.Resize(id + 1);
+
+		return id;
+	}
+
+	void RenderableStore::SetWorldTransform(uint32_t id, FXMMATRIX world)
+	{
+		XMStoreFloat4x4(&m_worldTransforms[id], world);
+		XMStoreFloat4x4(&m_objectData[id].worldMatrix, XMMatrixTranspose(world));
+		m_uploads.Mark(id);
+
+		if ((m_flags[id] & FLAG_MOVED) == 0)
+		{
+			m_flags[id] |= FLAG_MOVED;
+			m_moved.push_back(id);
+		}
+	}
+
+	void RenderableStore::SetMaterial(uint32_t id, uint32_t materialIndex)
+	{
+		m_objectData[id].materialIndex = materialIndex;
+		m_uploads.Mark(id);
+	}
+
+	XMFLOAT3 RenderableStore::GetPosition(uint32_t id) const
+	{
+		const XMFLOAT4X4& world = m_worldTransforms[id];
+		return XMFLOAT3(world._41, world._42, world._43);
+	}
+
+	void RenderableStore::ClearMoved()
+	{
+		for (uint32_t id : m_moved)
+		{
+			m_flags[id] &= ~FLAG_MOVED;
+		}
+		m_moved.clear();
+	}
+}
@@ -0,0 +1,76 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+#include "HMathHelper.h"
+#include "VertexPacking.h"
+#include "UploadTracker.h"
+
+
+namespace Humpback
+{
+	// What the vertex shaders read per object, indexed through the object index of each instance.
+	struct ObjectData
+	{
+		DirectX::XMFLOAT4X4 worldMatrix = HMathHelper::Identity4x4();
+		DirectX::XMFLOAT3 positionScale = { 1.0f, 1.0f, 1.0f };
+		unsigned int materialIndex = 0;
+		DirectX::XMFLOAT3 positionOffset = { 0.0f, 0.0f, 0.0f };
+		unsigned int pad0 = 0;
+	};
+
+	static_assert(sizeof(ObjectData) == 96, "ObjectData must match the struct in Common.hlsl.");
+
+
+	// The state of the renderable objects that changes while the scene runs, in structure-of-arrays form
+	// indexed by object id. The GPU records are kept in upload layout: a change is transposed and packed
+	// once, then copied as is into the object buffer of each frame resource, in runs of consecutive ids.
+	class RenderableStore
+	{
+	public:
+
+		explicit RenderableStore(unsigned int frameResourceCount);
+		RenderableStore(const RenderableStore&) = delete;
+		RenderableStore& operator=(const RenderableStore&) = delete;
+
+		// Ids are handed out in order from 0. The object starts at the origin.
+		uint32_t Add(const DirectX::BoundingBox& localBounds, const PositionQuantization& quantization, uint32_t materialIndex);
+
+		uint32_t GetCount() const { return (uint32_t)m_localBounds.size(); }
+
+		void SetWorldTransform(uint32_t id, DirectX::FXMMATRIX world);
+		void SetMaterial(uint32_t id, uint32_t materialIndex);
+
+		DirectX::XMMATRIX GetWorldTransform(uint32_t id) const { return DirectX::XMLoadFloat4x4(&m_worldTransforms[id]); }
+		DirectX::XMFLOAT3 GetPosition(uint32_t id) const;
+		const DirectX::BoundingBox& GetLocalBounds(uint32_t id) const { return m_localBounds[id]; }
+		uint32_t GetMaterial(uint32_t id) const { return m_objectData[id].materialIndex; }
+
+		// Ids whose world transform changed since the last ClearMoved, each once, in the order they moved.
+		const std::vector<uint32_t>& GetMoved() const { return m_moved; }
+		void ClearMoved();
+
+		// Appends the runs of records the object buffer of frameResource is missing and marks them written.
+		void CollectUploads(unsigned int frameResource, std::vector<UploadTracker::Run>& runs) { m_uploads.Collect(frameResource, runs); }
+		const ObjectData* GetObjectData() const { return m_objectData.data(); }
+
+	private:
+
+		static const uint8_t FLAG_MOVED = 1;
+
+		std::vector<DirectX::XMFLOAT4X4> m_worldTransforms;
+		std::vector<DirectX::BoundingBox> m_localBounds;
+		std::vector<ObjectData> m_objectData;
+		std::vector<uint8_t> m_flags;
+
+		std::vector<uint32_t> m_moved;
+		UploadTracker m_uploads;
+	};
+}
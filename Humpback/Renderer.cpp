@@ -2,7 +2,11 @@
 // 2021-10-28
 
 #include <array>
+#include <chrono>
 #include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
 
 #include <wrl.h>
 #include <dxgi1_6.h>
@@ -19,6 +23,7 @@
 
 #include "DDSTextureLoader.h"
 #include "WICTextureLoader.h"
+#include "ResourceUploadBatch.h"
 
 using namespace Microsoft::WRL;
 using namespace DirectX;
@@ -29,7 +34,27 @@ namespace Humpback
 {
 	namespace {
 		int g_matIdx = 0;
-		int g_constantBufferIdx = 0;
+
+		const uint32_t MAX_TEXTURE_SIZE = 2048;
+
+		const D3D_SHADER_MACRO PACKED_VERTEX_DEFINES[] = { { "PACKED_VERTEX", "1" }, { nullptr, nullptr } };
+
+		DXGI_FORMAT ToDxgiFormat(ImageFormat format, bool srgb)
+		{
+			switch (format)
+			{
+			case ImageFormat::R8:		return DXGI_FORMAT_R8_UNORM;
+			case ImageFormat::R16:		return DXGI_FORMAT_R16_UNORM;
+			case ImageFormat::RGBA8:	return srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+			case ImageFormat::RGBA16:	return DXGI_FORMAT_R16G16B16A16_UNORM;
+			}
+			return DXGI_FORMAT_UNKNOWN;
+		}
+
+		double MillisecondsSince(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
 	}
 
 	class Material;
@@ -55,7 +80,9 @@ namespace Humpback
 	void Renderer::Initialize()
 	{
 		_initTimer();
+		_initJobSystem();
 		_initD3D12();
+		m_assetCache = std::make_unique<AssetCache>(AssetCache::DEFAULT_DIRECTORY);
 		_initCamera();
 
 		OnResize();
@@ -73,6 +100,7 @@ namespace Humpback
 		_createSceneLights();
 		_createSceneGeometry();
 		_loadGeometryFromFileASSIMP();
+
 		_createAllMaterials();
 		_createAllRenderableObjects();
 
@@ -81,11 +109,22 @@ namespace Humpback
 
 		m_featureSSAO->SetPSOs(m_psos["ssao"].Get(), m_psos["blur"].Get());
 
+		_buildRenderGraph();
+
 		ThrowIfFailed(m_commandList->Close());
 		ID3D12CommandList* commandLists[] = { m_commandList.Get() };
 		m_commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
 
 		_waitForPreviousFrame();
+
+		// The load time uploads have landed, their staging space can be reused.
+		m_uploadAllocator->FinishSubmission(m_fenceValue);
+		m_uploadAllocator->ReleaseCompleted(m_fence->GetCompletedValue());
+
+		// The rest of the scene was loaded while the copy queue uploaded the textures.
+		auto uploadWaitStart = std::chrono::steady_clock::now();
+		m_textureUpload.get();
+		m_textureLoadTimings.uploadWaitMs = MillisecondsSince(uploadWaitStart);
 	}
 
 
@@ -94,6 +133,7 @@ namespace Humpback
 		_onKeyboardInput();
 
 		_updateCamera();
+		_updateTransforms();
 
 		m_curFrameResourceIdx = (m_curFrameResourceIdx + 1) % FRAME_RESOURCE_COUNT;
 		m_curFrameResource = m_frameResources[m_curFrameResourceIdx].get();
@@ -108,7 +148,13 @@ namespace Humpback
 			CloseHandle(m_fenceEvent);
 		}
 
+		m_uploadAllocator->ReleaseCompleted(m_fence->GetCompletedValue());
+		m_bindlessHeap->ReleaseCompleted(m_fence->GetCompletedValue());
+		m_gpuMemory->ReleaseCompleted(m_fence->GetCompletedValue());
+
+		_updateSceneBvhs();
 		_updateShadowMap();
+		_updateCulling();
 		_updateCBuffers();
 	}
 
@@ -117,6 +163,20 @@ namespace Humpback
 		m_mainCamera->Update();
 	}
 
+	void Renderer::_updateTransforms()
+	{
+		m_nodeObjects.resize(m_transforms.GetNodeCount(), nullptr);
+
+		for (uint32_t node : m_transforms.Update())
+		{
+			RenderableObject* obj = m_nodeObjects[node];
+			if (obj != nullptr)
+			{
+				m_renderables->SetWorldTransform(obj->id, m_transforms.GetWorldTransform(node));
+			}
+		}
+	}
+
 	void Renderer::_onKeyboardInput()
 	{
 		float deltaT = m_timer->DeltaTime();
@@ -148,20 +208,28 @@ namespace Humpback
 			auto newPos = pos + (m_mainCamera->GetRightVector() * 10.f * deltaT);
 			m_mainCamera->SetPosition(newPos);
 		}
-	}
 
-	CD3DX12_CPU_DESCRIPTOR_HANDLE Renderer::_getCpuSrv(int idx) const
-	{
-		auto srv = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_srvHeap->GetCPUDescriptorHandleForHeapStart());
-		srv.Offset(idx, m_cbvSrvUavDescriptorSize);
-		return srv;
-	}
+		// Toggle on key press so the GPU cost of both modes can be compared.
+		bool depthPrepassKeyDown = (GetAsyncKeyState('Z') & 0x8000) != 0;
+		if (depthPrepassKeyDown && m_depthPrepassKeyDown == false)
+		{
+			m_enableDepthPrepassReuse = !m_enableDepthPrepassReuse;
+		}
+		m_depthPrepassKeyDown = depthPrepassKeyDown;
 
-	CD3DX12_GPU_DESCRIPTOR_HANDLE Renderer::_getGpuSrv(int idx) const
-	{
-		auto srv = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_srvHeap->GetGPUDescriptorHandleForHeapStart());
-		srv.Offset(idx, m_cbvSrvUavDescriptorSize);
-		return srv;
+		bool clusterCullingKeyDown = (GetAsyncKeyState('C') & 0x8000) != 0;
+		if (clusterCullingKeyDown && m_clusterCullingKeyDown == false)
+		{
+			m_enableClusterCulling = !m_enableClusterCulling;
+		}
+		m_clusterCullingKeyDown = clusterCullingKeyDown;
+
+		bool occlusionCullingKeyDown = (GetAsyncKeyState('O') & 0x8000) != 0;
+		if (occlusionCullingKeyDown && m_occlusionCullingKeyDown == false)
+		{
+			m_enableOcclusionCulling = !m_enableOcclusionCulling;
+		}
+		m_occlusionCullingKeyDown = occlusionCullingKeyDown;
 	}
 
 	CD3DX12_CPU_DESCRIPTOR_HANDLE Renderer::_getDsv(int idx) const
@@ -178,41 +246,198 @@ namespace Humpback
 		return rtv;
 	}
 
-	void Renderer::_bindMaterialBuffer()
+	void Renderer::_bindMaterialBuffer(ID3D12GraphicsCommandList* cmdList)
 	{
 		auto matBuffer = m_curFrameResource->materialCBuffer->Resource();
-		m_commandList->SetGraphicsRootShaderResourceView(2, matBuffer->GetGPUVirtualAddress());
+		cmdList->SetGraphicsRootShaderResourceView(2, matBuffer->GetGPUVirtualAddress());
+	}
+
+	void Renderer::_bindCommonState(ID3D12GraphicsCommandList* cmdList)
+	{
+		ID3D12DescriptorHeap* srvHeaps[] = { m_bindlessHeap->GetHeap() };
+		cmdList->SetDescriptorHeaps(_countof(srvHeaps), srvHeaps);
+
+		cmdList->SetGraphicsRootSignature(m_rootSignature.Get());
+
+		_bindMaterialBuffer(cmdList);
+		cmdList->SetGraphicsRootShaderResourceView(5, m_curFrameResource->objectBuffer->Resource()->GetGPUVirtualAddress());
 	}
 
 	void Renderer::_updateCBuffers()
 	{
-		_updateCBufferPerObject();
+		_updateObjectBuffer();
+		_updateInstanceBuffer();
 		_updateMatCBuffer();
 		_updateCBufferPerPass();
 		_updateShadowCB();
 		_updateSsaoCB();
 	}
 
-	void Renderer::_updateCBufferPerObject()
+	void Renderer::_updateObjectBuffer()
+	{
+		m_uploadRuns.clear();
+		m_renderables->CollectUploads(m_curFrameResourceIdx, m_uploadRuns);
+
+		auto objectBuffer = m_curFrameResource->objectBuffer.get();
+		for (const UploadTracker::Run& run : m_uploadRuns)
+		{
+			objectBuffer->CopyData(run.first, m_renderables->GetObjectData() + run.first, run.count);
+		}
+	}
+
+	void Renderer::_updateInstanceBuffer()
+	{
+		// Shadow casters and camera layers share the instance buffer of the frame.
+		unsigned int instanceOffset = 0;
+
+		m_clusterRanges.clear();
+		m_clusterCullingStats = ClusterCullingStats();
+
+		// Depth order does not matter for the shadow map, so it is left out of the key there.
+		for (unsigned int i = 0; i < m_shadowCascades.GetCascadeCount(); i++)
+		{
+			_buildInstanceGroups(m_visibleCascadeCasters[i], 0, RenderLayer::Opaque, false,
+				m_cascadeCasterGroups[i], instanceOffset);
+		}
+
+		for (int layer = 0; layer < (int)RenderLayer::Count; layer++)
+		{
+			_buildInstanceGroups(m_visibleLayers[layer], 1 + layer, (RenderLayer)layer, true,
+				m_layerGroups[layer], instanceOffset);
+		}
+
+		// The sky is drawn at the far plane without back face culling, only the opaque layer qualifies.
+		// The shadow casters keep whole draws.
+		_cullClusters(m_layerGroups[(int)RenderLayer::Opaque]);
+	}
+
+	void Renderer::_cullClusters(std::vector<InstanceGroup>& groups)
 	{
-		auto curObjCBuffer = m_curFrameResource->objCBuffer.get();
-		for (auto& obj : m_renderableList)
+		if (m_enableClusterCulling == false)
 		{
-			if (obj->NumFramesDirty > 0)
+			return;
+		}
+
+		XMMATRIX view = m_mainCamera->GetViewMatrix();
+		XMMATRIX proj = m_mainCamera->GetProjectionMatrix();
+
+		XMFLOAT4X4 projF;
+		XMStoreFloat4x4(&projF, proj);
+
+		ClusterCullingView cullingView;
+		cullingView.frustum = FrustumPlanes::FromViewProj(XMMatrixMultiply(view, proj));
+		XMStoreFloat4x4(&cullingView.view, view);
+		cullingView.cameraPosition = m_mainCamera->GetPosition();
+		cullingView.projScaleX = projF._11;
+		cullingView.projScaleY = projF._22;
+		cullingView.nearZ = m_mainCamera->GetNearZ();
+		cullingView.viewportWidth = m_viewPort.Width;
+		cullingView.viewportHeight = m_viewPort.Height;
+		cullingView.smallTriangleCulling = m_4xMsaaState == false;
+
+		size_t kept = 0;
+		for (size_t i = 0; i < groups.size(); i++)
+		{
+			InstanceGroup group = groups[i];
+			auto obj = group.object;
+
+			// The instances of a group share its draws, so only single instances get their own ranges.
+			if (group.instanceCount == 1 && obj->meshletCount > 1)
 			{
-				XMMATRIX worldM = XMLoadFloat4x4(&(obj->worldM));
+				XMMATRIX world = m_renderables->GetWorldTransform(obj->id);
+				group.firstRange = (unsigned int)m_clusterRanges.size();
+
+				if (obj->indexBatchCount == 0)
+				{
+					group.rangeCount = CullMeshlets(cullingView, obj->meshlets, obj->meshletCount,
+						world, m_clusterRanges, &m_clusterCullingStats);
+				}
+				else
+				{
+					// Ranges never span batches, each one is drawn with the vertex offset of its batch.
+					for (unsigned int b = 0; b < obj->indexBatchCount; b++)
+					{
+						const IndexBatch& batch = obj->indexBatches[b];
+						size_t first = m_clusterRanges.size();
+
+						// Batches cut between triangles have no meshlets, they are drawn whole.
+						if (batch.meshletCount == 0)
+						{
+							m_clusterRanges.push_back({ batch.startIndexLocation, batch.indexCount, batch.vertexOffset });
+							group.rangeCount++;
+							continue;
+						}
+
+						group.rangeCount += CullMeshlets(cullingView, obj->meshlets + batch.firstMeshlet, batch.meshletCount,
+							world, m_clusterRanges, &m_clusterCullingStats);
+						for (size_t r = first; r < m_clusterRanges.size(); r++)
+						{
+							m_clusterRanges[r].vertexOffset = batch.vertexOffset;
+						}
+					}
+				}
 
-				ObjectConstants objConstants;
-				XMStoreFloat4x4(&(objConstants.worldM), XMMatrixTranspose(worldM));
-				if (obj->material != nullptr)
+				// Every cluster culled, the instance data written for it is left unused.
+				if (group.rangeCount == 0)
 				{
-					objConstants.MaterialIndex = obj->material->matCBIdx;
+					continue;
 				}
+			}
+
+			groups[kept++] = group;
+		}
+
+		groups.resize(kept);
+	}
+
+	void Renderer::_buildInstanceGroups(const std::vector<RenderableObject*>& objList, unsigned int pass, RenderLayer layer,
+		bool sortByDepth, std::vector<InstanceGroup>& groups, unsigned int& instanceOffset)
+	{
+		XMMATRIX view = m_mainCamera->GetViewMatrix();
+		float nearZ = m_mainCamera->GetNearZ();
+		float farZ = m_mainCamera->GetFarZ();
+
+		m_drawQueue.Clear();
+		for (auto obj : objList)
+		{
+			unsigned int materialIndex = m_renderables->GetMaterial(obj->id);
+
+			unsigned int depth = 0;
+			if (sortByDepth)
+			{
+				XMFLOAT3 position = m_renderables->GetPosition(obj->id);
+				XMVECTOR posW = XMVectorSet(position.x, position.y, position.z, 1.0f);
+				depth = DrawQueue::QuantizeDepth(XMVectorGetZ(XMVector3TransformCoord(posW, view)), nearZ, farZ);
+			}
+
+			m_drawQueue.Push(DrawQueue::MakeKey(pass, (unsigned int)layer, obj->meshId, obj->geometryId,
+				materialIndex, depth), obj);
+		}
+
+		m_drawQueue.Sort();
 
-				curObjCBuffer->CopyData(obj->cbIndex, objConstants);
+		// Consecutive packets with the same geometry become one instanced draw.
+		groups.clear();
 
-				obj->NumFramesDirty--;
+		uint64_t groupKey = 0;
+		auto instanceBuffer = m_curFrameResource->instanceBuffer.get();
+		for (auto& packet : m_drawQueue.GetPackets())
+		{
+			auto obj = packet.object;
+
+			if (groups.empty() || DrawQueue::GetGeometryKey(packet.key) != groupKey)
+			{
+				InstanceGroup group;
+				group.object = obj;
+				group.firstInstance = instanceOffset;
+				groups.push_back(group);
+
+				groupKey = DrawQueue::GetGeometryKey(packet.key);
 			}
+
+			// The object buffer already holds the transform, an instance is just the id of its object.
+			instanceBuffer->CopyData(instanceOffset++, obj->id);
+			++groups.back().instanceCount;
 		}
 	}
 
@@ -224,14 +449,12 @@ namespace Humpback
 		XMMATRIX invProj = XMMatrixInverse(&XMMatrixDeterminant(proj), proj);
 		XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(view), view);
 		XMMATRIX invViewProj = XMMatrixInverse(&XMMatrixDeterminant(viewProj), viewProj);
-		XMMATRIX shadowVPT = XMLoadFloat4x4(&m_shadowVPTMatrix);
 		
 		XMMATRIX viewProjTex = viewProj * DirectX::XMLoadFloat4x4(&HMathHelper::NDCToTexCoord());
 
 		XMStoreFloat4x4(&m_mainPassCB.view, XMMatrixTranspose(view));
 		XMStoreFloat4x4(&m_mainPassCB.proj, XMMatrixTranspose(proj));
 		XMStoreFloat4x4(&m_mainPassCB.viewProj, XMMatrixTranspose(viewProj));
-		XMStoreFloat4x4(&m_mainPassCB.shadowVPT, XMMatrixTranspose(shadowVPT));
 		XMStoreFloat4x4(&m_mainPassCB.invProj, XMMatrixTranspose(invProj));
 		XMStoreFloat4x4(&m_mainPassCB.invView, XMMatrixTranspose(invView));
 		XMStoreFloat4x4(&m_mainPassCB.invViewProj, XMMatrixTranspose(invViewProj));
@@ -240,6 +463,24 @@ namespace Humpback
 		m_mainPassCB.farZ = m_mainCamera->GetFarZ();
 		m_mainPassCB.cameraPosW = m_mainCamera->GetPosition();
 		m_mainPassCB.ambient = XMFLOAT4(0.2f, 0.2f, 0.2f, 1.0f);
+		m_mainPassCB.skyCubeMapIndex = m_skyCubeSrvIndex;
+		m_mainPassCB.shadowMapIndex = m_shadowMapSrvIndex;
+		m_mainPassCB.ssaoMapIndex = m_featureSSAO->GetAmbientSrvIndex();
+
+		// Unused splits repeat the last one, so the shader finds no cascade past the shadow distance.
+		unsigned int cascadeCount = m_shadowCascades.GetCascadeCount();
+		float splits[ShadowCascades::MAX_CASCADES];
+		for (unsigned int i = 0; i < ShadowCascades::MAX_CASCADES; i++)
+		{
+			const ShadowCascade& cascade = m_shadowCascades.GetCascade(std::min(i, cascadeCount - 1));
+			splits[i] = cascade.splitFar;
+
+			XMMATRIX shadowVPT = XMLoadFloat4x4(&cascade.view) * XMLoadFloat4x4(&cascade.proj) *
+				XMLoadFloat4x4(&HMathHelper::NDCToTexCoord());
+			XMStoreFloat4x4(&m_mainPassCB.shadowVPT[i], XMMatrixTranspose(shadowVPT));
+		}
+		m_mainPassCB.shadowCascadeCount = cascadeCount;
+		m_mainPassCB.shadowCascadeSplits = XMFLOAT4(splits);
 
 		for (size_t i = 0; i < 3; i++)
 		{
@@ -253,13 +494,15 @@ namespace Humpback
 	void Renderer::_updateMatCBuffer()
 	{
 		auto curMatCB = m_curFrameResource->materialCBuffer.get();
-		for (auto& m : m_materials)
-		{
-			Material* pMat = m.second.get();
 
-			if (pMat != nullptr && pMat->numFramesDirty > 0)
+		m_uploadRuns.clear();
+		m_materialUploads->Collect(m_curFrameResourceIdx, m_uploadRuns);
+		for (const UploadTracker::Run& run : m_uploadRuns)
+		{
+			for (uint32_t i = run.first; i < run.first + run.count; i++)
 			{
-				
+				Material* pMat = m_materialList[i];
+
 				MaterialConstants matConstants;
 				matConstants.diffuseAlbedo = pMat->diffuseAlbedo;
 
@@ -271,25 +514,27 @@ namespace Humpback
 				XMStoreFloat4x4(&matConstants.matTransform, XMMatrixTranspose(matrixMatTrans));
 
 				curMatCB->CopyData(pMat->matCBIdx, matConstants);
-
-				--pMat->numFramesDirty;
 			}
 		}
 	}
 
 	void Renderer::_updateShadowCB()
 	{
-		XMMATRIX lightView = XMLoadFloat4x4(&m_lightViewMatrix);
-		XMMATRIX lightProj = XMLoadFloat4x4(&m_lightProjMatrix);
+		// Cascade i renders with the pass constants after the main pass, at 1 + i.
+		for (unsigned int i = 0; i < m_shadowCascades.GetCascadeCount(); i++)
+		{
+			const ShadowCascade& cascade = m_shadowCascades.GetCascade(i);
+			XMMATRIX lightView = XMLoadFloat4x4(&cascade.view);
+			XMMATRIX lightProj = XMLoadFloat4x4(&cascade.proj);
 
-		XMMATRIX lightVP = XMMatrixMultiply(lightView, lightProj);
+			XMMATRIX lightVP = XMMatrixMultiply(lightView, lightProj);
 
-		XMStoreFloat4x4(&m_shadowPassCB.view, XMMatrixTranspose(lightView));
-		XMStoreFloat4x4(&m_shadowPassCB.proj, XMMatrixTranspose(lightProj));
-		XMStoreFloat4x4(&m_shadowPassCB.viewProj, XMMatrixTranspose(lightVP));
-		m_shadowPassCB.cameraPosW = m_mainLightPos;
+			XMStoreFloat4x4(&m_shadowPassCB.view, XMMatrixTranspose(lightView));
+			XMStoreFloat4x4(&m_shadowPassCB.proj, XMMatrixTranspose(lightProj));
+			XMStoreFloat4x4(&m_shadowPassCB.viewProj, XMMatrixTranspose(lightVP));
 
-		m_curFrameResource->passCBuffer->CopyData(1, m_shadowPassCB);
+			m_curFrameResource->passCBuffer->CopyData(1 + i, m_shadowPassCB);
+		}
 	}
 
 	void Renderer::_updateSsaoCB()
@@ -323,34 +568,191 @@ namespace Humpback
 		curSsaoCB->CopyData(0, constants);
 	}
 
+	void Renderer::_updateSceneBvhs()
+	{
+		// Refresh the world bounds of objects that moved.
+		for (uint32_t id : m_renderables->GetMoved())
+		{
+			const RenderableObject* obj = m_renderableList[id].get();
+
+			BoundingBox worldAabb;
+			m_renderables->GetLocalBounds(id).Transform(worldAabb, m_renderables->GetWorldTransform(id));
+			m_layerBvhs[obj->layer]->SetBox(obj->cullIndex, worldAabb);
+		}
+		m_renderables->ClearMoved();
+
+		for (int layer = 0; layer < (int)RenderLayer::Count; layer++)
+		{
+			m_layerBvhs[layer]->Update();
+		}
+	}
+
 	void Renderer::_updateShadowMap()
 	{
-		// Only the main directional light cast shadow.
+		// Only the main directional light cast shadow. Every opaque object can cast into a cascade.
 		DirectionalLight mainLight = m_directionalLights[0];
 		XMVECTOR lightDir = XMLoadFloat3(&mainLight.GetDirection());
-		XMVECTOR lightPos = -2.0f * m_sceneBoundingSphere.Radius * lightDir;
-		XMVECTOR targetPos = XMLoadFloat3(&m_sceneBoundingSphere.Center);
-		XMVECTOR lightUp = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-		XMMATRIX lightView = XMMatrixLookAtLH(lightPos, targetPos, lightUp);
+		BoundingBox casterBounds = m_layerBvhs[(int)RenderLayer::Opaque]->GetBounds();
+
+		m_shadowCascades.Update(m_mainCamera->GetViewMatrix(), m_mainCamera->GetProjectionMatrix(),
+			m_mainCamera->GetNearZ(), m_mainCamera->GetFarZ(), lightDir, casterBounds);
+	}
+
+	void Renderer::_updateCulling()
+	{
+		m_cameraCullingStats = CullingStats();
+		m_shadowCullingStats = CullingStats();
+
+		XMMATRIX cameraVP = XMMatrixMultiply(m_mainCamera->GetViewMatrix(), m_mainCamera->GetProjectionMatrix());
+		FrustumPlanes cameraFrustum = m_mainCamera->GetFrustum();
+
+		for (int layer = 0; layer < (int)RenderLayer::Count; layer++)
+		{
+			_cullRenderLayer((RenderLayer)layer, cameraFrustum, m_visibleLayers[layer], m_cameraCullingStats);
+		}
+
+		// The normal-depth pass draws the same opaque list as the main pass.
+		_cullOccluded(*m_cameraOcclusion, cameraVP, m_visibleLayers[(int)RenderLayer::Opaque]);
+
+		// Shadow casters are culled against the volume of each cascade instead of the camera.
+		for (unsigned int i = 0; i < m_shadowCascades.GetCascadeCount(); i++)
+		{
+			const ShadowCascade& cascade = m_shadowCascades.GetCascade(i);
+			XMMATRIX lightVP = XMMatrixMultiply(XMLoadFloat4x4(&cascade.view), XMLoadFloat4x4(&cascade.proj));
+			_cullRenderLayer(RenderLayer::Opaque, FrustumPlanes::FromViewProj(lightVP),
+				m_visibleCascadeCasters[i], m_shadowCullingStats);
+
+			// A caster hidden from the light behind other casters adds nothing to the shadow map.
+			_cullOccluded(*m_shadowOcclusion[i], lightVP, m_visibleCascadeCasters[i]);
+		}
+	}
+
+	void Renderer::_cullRenderLayer(RenderLayer layer, const FrustumPlanes& frustum,
+		std::vector<RenderableObject*>& visible, CullingStats& stats)
+	{
+		auto& objList = m_renderLayers[(int)layer];
+
+		if (m_enableFrustumCulling == false)
+		{
+			visible = objList;
+			stats.testedCount += (unsigned int)objList.size();
+			stats.visibleCount += (unsigned int)objList.size();
+			return;
+		}
+
+		m_layerBvhs[(int)layer]->Cull(frustum, m_visibleIndices, &stats);
 
-		XMStoreFloat3(&m_mainLightPos, lightPos);
+		visible.clear();
+		for (auto index : m_visibleIndices)
+		{
+			visible.push_back(objList[index]);
+		}
+	}
+
+	void Renderer::_cullOccluded(OcclusionCuller& culler, FXMMATRIX viewProj, std::vector<RenderableObject*>& visible)
+	{
+		culler.Begin(viewProj);
+
+		if (m_enableOcclusionCulling == false)
+		{
+			return;
+		}
+
+		for (const RenderableObject* obj : visible)
+		{
+			if (obj->occluder)
+			{
+				culler.AddOccluder(m_renderables->GetWorldTransform(obj->id), m_renderables->GetLocalBounds(obj->id));
+			}
+		}
+		culler.Rasterize();
 
-		XMFLOAT3 sphereCenterLS;
-		XMStoreFloat3(&sphereCenterLS, XMVector3TransformCoord(targetPos, lightView));
+		// Occluders are tested as well, they can be hidden behind each other. The order is kept.
+		auto hidden = std::remove_if(visible.begin(), visible.end(), [&](const RenderableObject* obj)
+			{
+				return culler.IsVisible(m_layerBvhs[obj->layer]->GetBox(obj->cullIndex)) == false;
+			});
+		visible.erase(hidden, visible.end());
+	}
 
-		float l = sphereCenterLS.x - m_sceneBoundingSphere.Radius;
-		float r = sphereCenterLS.x + m_sceneBoundingSphere.Radius;
-		float b = sphereCenterLS.y - m_sceneBoundingSphere.Radius;
-		float u = sphereCenterLS.y + m_sceneBoundingSphere.Radius;
-		float n = sphereCenterLS.z - m_sceneBoundingSphere.Radius;
-		float f = sphereCenterLS.z + m_sceneBoundingSphere.Radius;
+	void Renderer::_buildRenderGraph()
+	{
+		m_renderGraph = std::make_unique<RenderGraph>();
+		m_renderGraphBackend = std::make_unique<D3D12RenderGraphBackend>();
+
+		m_rgShadowMap = m_renderGraph->ImportResource("ShadowMap",
+			RGResourceState::GenericRead, RGResourceState::GenericRead);
+		m_rgDepthStencil = m_renderGraph->ImportResource("DepthStencil",
+			RGResourceState::DepthWrite, RGResourceState::DepthWrite);
+		m_rgBackBuffer = m_renderGraph->ImportResource("BackBuffer",
+			RGResourceState::Present, RGResourceState::Present, true);
+
+		// The SSAO targets only live within the frame, the graph places them in its transient heap.
+		D3D12_CLEAR_VALUE normalDepthClear;
+		D3D12_CLEAR_VALUE ambientClear;
+		auto normalDepthDesc = m_featureSSAO->GetNormalDepthDesc(&normalDepthClear);
+		auto ambientDesc = m_featureSSAO->GetAmbientDesc(&ambientClear);
+
+		m_rgNormalDepth = m_renderGraphBackend->CreateTransient(*m_renderGraph, m_device.Get(), "NormalDepth",
+			normalDepthDesc, &normalDepthClear);
+		m_rgAmbientMap = m_renderGraphBackend->CreateTransient(*m_renderGraph, m_device.Get(), "AmbientMap",
+			ambientDesc, &ambientClear);
+		m_rgAmbientBlur = m_renderGraphBackend->CreateTransient(*m_renderGraph, m_device.Get(), "AmbientBlur",
+			ambientDesc, &ambientClear);
+
+		m_renderGraph->AddPass("ShadowMap",
+			[this](RenderGraph::PassBuilder& builder)
+			{
+				builder.Write(m_rgShadowMap, RGResourceState::DepthWrite);
+			},
+			[this]() { _renderShadowMap(); });
 
-		XMMATRIX lightProj = XMMatrixOrthographicOffCenterLH(l, r, b, u, n, f);
+		m_renderGraph->AddPass("NormalDepth",
+			[this](RenderGraph::PassBuilder& builder)
+			{
+				builder.Write(m_rgNormalDepth, RGResourceState::RenderTarget);
+				builder.Write(m_rgDepthStencil, RGResourceState::DepthWrite);
+			},
+			[this]() { _renderNormalDepth(); });
+
+		// The SSAO feature ping-pongs between the ambient and blur targets and leaves both readable.
+		m_renderGraph->AddPass("SSAO",
+			[this](RenderGraph::PassBuilder& builder)
+			{
+				builder.Read(m_rgNormalDepth, RGResourceState::GenericRead);
+				builder.Read(m_rgDepthStencil, RGResourceState::ShaderResource);
+				builder.Write(m_rgAmbientMap, RGResourceState::GenericRead);
+				builder.Write(m_rgAmbientBlur, RGResourceState::GenericRead);
+			},
+			[this]() { _renderAO(); });
+
+		m_renderGraph->AddPass("Main",
+			[this](RenderGraph::PassBuilder& builder)
+			{
+				builder.Read(m_rgShadowMap, RGResourceState::GenericRead);
+				builder.Read(m_rgAmbientMap, RGResourceState::GenericRead);
+				// Stays a write in prepass reuse mode, the sky still writes depth there.
+				builder.Write(m_rgDepthStencil, RGResourceState::DepthWrite);
+				builder.Write(m_rgBackBuffer, RGResourceState::RenderTarget);
+			},
+			[this]() { _renderMainPass(); });
+
+		m_renderGraph->Compile();
+		m_renderGraphBackend->CreateTransientResources(m_device.Get(), *m_renderGraph);
+
+		m_featureSSAO->SetResources(m_renderGraphBackend->GetResource(m_rgNormalDepth),
+			m_renderGraphBackend->GetResource(m_rgAmbientMap), m_renderGraphBackend->GetResource(m_rgAmbientBlur),
+			m_depthStencilBuffer.Get());
+	}
 
-		XMMATRIX VPT = lightView * lightProj * XMLoadFloat4x4(&HMathHelper::NDCToTexCoord());
-		XMStoreFloat4x4(&m_lightViewMatrix, lightView);
-		XMStoreFloat4x4(&m_lightProjMatrix, lightProj);
-		XMStoreFloat4x4(&m_shadowVPTMatrix,  VPT);
+	void Renderer::_bindRenderGraphResources()
+	{
+		// Imported resources are re-bound every frame since the back buffer flips and
+		// the depth buffer is recreated on resize. The transients belong to the backend.
+		m_renderGraphBackend->SetCommandList(m_frameCommandList);
+		m_renderGraphBackend->SetResource(m_rgShadowMap, m_shadowMap->Resource());
+		m_renderGraphBackend->SetResource(m_rgDepthStencil, m_depthStencilBuffer.Get());
+		m_renderGraphBackend->SetResource(m_rgBackBuffer, _getCurrentBackbuffer());
 	}
 
 	void Renderer::_render()
@@ -364,83 +766,84 @@ namespace Humpback
 		//A command list can be reset after it has been added to the command queue.
 		ThrowIfFailed(m_commandList->Reset(cmdAllocator.Get(), m_psos["opaque"].Get()));
 
-		ID3D12DescriptorHeap* srvHeaps[] = {m_srvHeap.Get()};
-		m_commandList->SetDescriptorHeaps(_countof(srvHeaps), srvHeaps);
+		m_frameCommandList = m_commandList.Get();
+		m_usedRecordingCommandLists = 0;
+		m_submitCommandLists.clear();
+		m_drawStats = DrawSubmissionStats();
 
-		m_commandList->SetGraphicsRootSignature(m_rootSignature.Get());
-		
-		_bindMaterialBuffer();
+		_bindCommonState(m_frameCommandList);
 
-		// Shadow map pass.
-		_renderShadowMap();
+		// Shadow map, normal depth, AO and main pass. The graph issues the barriers between them.
+		_bindRenderGraphResources();
+		m_renderGraph->Execute(*m_renderGraphBackend);
 
-		// Normal depth pass.
-		_renderNormalDepth();
+		ThrowIfFailed(m_frameCommandList->Close());
+		m_submitCommandLists.push_back(m_frameCommandList);
 
-		// Generate AO.
-		_renderAO();
+		// Add the commands to the command queue.
+		m_commandQueue->ExecuteCommandLists((UINT)m_submitCommandLists.size(), m_submitCommandLists.data());
 
+		ThrowIfFailed(m_swapChain->Present(0, 0));
+		m_frameIndex = (m_frameIndex + 1) % FrameBufferCount;
 
-		// Main pass.
-		m_commandList->SetGraphicsRootSignature(m_rootSignature.Get());
+		m_curFrameResource->fence = (++m_fenceValue);
 
-		_bindMaterialBuffer();
+		m_commandQueue->Signal(m_fence.Get(), m_fenceValue);
+		m_uploadAllocator->FinishSubmission(m_fenceValue);
+		m_gpuMemory->FinishSubmission(m_fenceValue);
+	}
 
+	void Renderer::_renderMainPass()
+	{
 		auto backbufferView = _getCurrentBackBufferView();
 		auto dsView = _getCurrentDSBufferView();
-		m_commandList->OMSetRenderTargets(1, &backbufferView, true, &dsView);
-
-		m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(_getCurrentBackbuffer(),
-			D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
-
-		m_commandList->RSSetViewports(1, &m_viewPort);
-		m_commandList->RSSetScissorRects(1, &m_scissorRect);
 
-		// Clear depth and color buffers.
-		m_commandList->ClearRenderTargetView(_getCurrentBackBufferView(), Colors::DarkGray, 0, nullptr);
-		m_commandList->ClearDepthStencilView(_getCurrentDSBufferView(),
-			D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
-
-		m_commandList->SetGraphicsRootDescriptorTable(4, m_srvHeap->GetGPUDescriptorHandleForHeapStart());
-
-		// set skybox root descriptor.
-		CD3DX12_GPU_DESCRIPTOR_HANDLE skyDesHandle(m_srvHeap->GetGPUDescriptorHandleForHeapStart());
-		skyDesHandle.Offset(m_skyTexHeapIndex, m_cbvSrvUavDescriptorSize);
-		m_commandList->SetGraphicsRootDescriptorTable(3, skyDesHandle);
+		// Clear depth and color buffers. With prepass reuse the depth of the normal-depth pass is kept.
+		m_frameCommandList->ClearRenderTargetView(backbufferView, Colors::DarkGray, 0, nullptr);
+		if (m_enableDepthPrepassReuse == false)
+		{
+			m_frameCommandList->ClearDepthStencilView(dsView,
+				D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+		}
 
+		// All texture tables cover the whole bindless heap, shaders pick views by index.
+		auto bindlessStart = m_bindlessHeap->GetGpuHandle(0);
 
-		// Bind per-pass constant buffer.
 		auto passCB = m_curFrameResource->passCBuffer->Resource();
-		m_commandList->SetGraphicsRootConstantBufferView(1, passCB->GetGPUVirtualAddress());
-
-		// Opaque pass.
-		m_commandList->SetPipelineState(m_psos["opaque"].Get());
-		_renderRenderableObjects(m_commandList.Get(), m_renderLayers[(int)RenderLayer::Opaque]);
+		auto opaquePso = m_enableDepthPrepassReuse ? m_psos["opaqueDepthReuse"].Get() : m_psos["opaque"].Get();
 
-		// Sky box pass.
-		m_commandList->SetPipelineState(m_psos["skybox"].Get());
-		_renderRenderableObjects(m_commandList.Get(), m_renderLayers[(int)RenderLayer::Sky]);
+		auto bindPassState = [=, this](ID3D12GraphicsCommandList* cmdList)
+		{
+			_bindCommonState(cmdList);
 
+			cmdList->OMSetRenderTargets(1, &backbufferView, true, &dsView);
 
-		m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-			_getCurrentBackbuffer(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+			cmdList->RSSetViewports(1, &m_viewPort);
+			cmdList->RSSetScissorRects(1, &m_scissorRect);
 
-		ThrowIfFailed(m_commandList->Close());
+			cmdList->SetGraphicsRootDescriptorTable(3, bindlessStart);
+			cmdList->SetGraphicsRootDescriptorTable(4, bindlessStart);
+			cmdList->SetGraphicsRootDescriptorTable(6, bindlessStart);
 
-		// Add the commands to the command queue.
-		ID3D12CommandList* commands[] = { m_commandList.Get() };
-		m_commandQueue->ExecuteCommandLists(_countof(commands), commands);
+			// Bind per-pass constant buffer.
+			cmdList->SetGraphicsRootConstantBufferView(1, passCB->GetGPUVirtualAddress());
 
-		ThrowIfFailed(m_swapChain->Present(0, 0));
-		m_frameIndex = (m_frameIndex + 1) % FrameBufferCount;
+			cmdList->SetPipelineState(opaquePso);
+		};
 
-		m_curFrameResource->fence = (++m_fenceValue);
+		// Opaque pass.
+		bindPassState(m_frameCommandList);
+		_recordRenderLayer(m_layerGroups[(int)RenderLayer::Opaque], bindPassState);
 
-		m_commandQueue->Signal(m_fence.Get(), m_fenceValue);
+		// Sky box pass.
+		m_frameCommandList->SetPipelineState(m_psos["skybox"].Get());
+		auto& skyLayer = m_layerGroups[(int)RenderLayer::Sky];
+		m_drawStats += _renderRenderableObjects(m_frameCommandList, skyLayer, 0, skyLayer.size());
 	}
 
 
-	void Renderer::_renderRenderableObjects(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderableObject*>& objList)
+	DrawSubmissionStats Renderer::_renderRenderableObjects(ID3D12GraphicsCommandList* cmdList, const std::vector<InstanceGroup>& groups,
+		size_t begin, size_t end, bool positionOnly)
 	{
 		if (cmdList == nullptr)
 		{
@@ -448,93 +851,223 @@ namespace Humpback
 		}
 
 
-		auto objCB = m_curFrameResource->objCBuffer->Resource();
-		auto objCBByteSize = D3DUtil::CalConstantBufferByteSize(sizeof(ObjectConstants));
+		DrawSubmissionStats stats;
+
+		auto instanceBufferAddress = m_curFrameResource->instanceBuffer->Resource()->GetGPUVirtualAddress();
 
-		for (size_t i = 0; i < objList.size(); i++)
+		// Groups arrive sorted by mesh, so the input assembler state only changes at mesh boundaries.
+		const Mesh* lastMesh = nullptr;
+		D3D12_PRIMITIVE_TOPOLOGY lastTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+		for (size_t i = begin; i < end; i++)
 		{
-			auto obj = objList[i];
+			auto& group = groups[i];
+			auto obj = group.object;
 			if (obj == nullptr)
 			{
 				continue;
 			}
 
-			auto vbv = obj->mesh->VertexBufferView();
-			cmdList->IASetVertexBuffers(0, 1, &vbv);
+			if (obj->mesh != lastMesh)
+			{
+				auto vbv = positionOnly ? obj->mesh->PositionBufferView() : obj->mesh->VertexBufferView();
+				cmdList->IASetVertexBuffers(0, 1, &vbv);
 
-			auto ibv = obj->mesh->IndexBufferView();
-			cmdList->IASetIndexBuffer(&ibv);
+				auto ibv = obj->mesh->IndexBufferView();
+				cmdList->IASetIndexBuffer(&ibv);
 
-			cmdList->IASetPrimitiveTopology(obj->primitiveTopology);
+				lastMesh = obj->mesh;
+				stats.stateChanges += 2;
+			}
+			else
+			{
+				stats.stateChangesAvoided += 2;
+			}
 
+			if (obj->primitiveTopology != lastTopology)
+			{
+				cmdList->IASetPrimitiveTopology(obj->primitiveTopology);
 
-			D3D12_GPU_VIRTUAL_ADDRESS objCBAddress = objCB->GetGPUVirtualAddress();
-			objCBAddress += obj->cbIndex * objCBByteSize;
+				lastTopology = obj->primitiveTopology;
+				++stats.stateChanges;
+			}
+			else
+			{
+				++stats.stateChangesAvoided;
+			}
 
-			cmdList->SetGraphicsRootConstantBufferView(0, objCBAddress);
+			// SV_InstanceID restarts at 0 for every draw, so the view starts at the group.
+			cmdList->SetGraphicsRootShaderResourceView(0,
+				instanceBufferAddress + group.firstInstance * sizeof(uint32_t));
+			++stats.stateChanges;
 
-			cmdList->DrawIndexedInstanced(obj->indexCount, 1, obj->startIndexLocation, obj->baseVertexLocation, 0);
+			if (group.rangeCount > 0)
+			{
+				for (unsigned int r = 0; r < group.rangeCount; r++)
+				{
+					const IndexRange& range = m_clusterRanges[group.firstRange + r];
+					cmdList->DrawIndexedInstanced(range.indexCount, group.instanceCount,
+						range.startIndexLocation, obj->baseVertexLocation + range.vertexOffset, 0);
+					++stats.drawCount;
+				}
+			}
+			else if (obj->indexBatchCount > 0)
+			{
+				for (unsigned int b = 0; b < obj->indexBatchCount; b++)
+				{
+					const IndexBatch& batch = obj->indexBatches[b];
+					cmdList->DrawIndexedInstanced(batch.indexCount, group.instanceCount,
+						batch.startIndexLocation, obj->baseVertexLocation + batch.vertexOffset, 0);
+					++stats.drawCount;
+				}
+			}
+			else
+			{
+				cmdList->DrawIndexedInstanced(obj->indexCount, group.instanceCount,
+					obj->startIndexLocation, obj->baseVertexLocation, 0);
+				++stats.drawCount;
+			}
 		}
+
+		return stats;
 	}
 
-	void Renderer::_renderShadowMap()
+	void Renderer::_recordRenderLayer(const std::vector<InstanceGroup>& groups, const PassStateFunc& bindPassState,
+		bool positionOnly)
 	{
-		m_commandList->RSSetViewports(1, &(m_shadowMap->GetViewPort()));
-		m_commandList->RSSetScissorRects(1, &(m_shadowMap->GetScissorRect()));
+		unsigned int chunkCount = (unsigned int)((groups.size() + MinDrawsPerRecordingJob - 1) / MinDrawsPerRecordingJob);
+		chunkCount = std::min(chunkCount, m_jobSystem->GetThreadCount());
 
-		m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_shadowMap->Resource(), 
-			D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_DEPTH_WRITE));
+		// Each parallel layer takes one list per chunk plus one to continue the frame on.
+		if (chunkCount <= 1 ||
+			m_usedRecordingCommandLists + chunkCount + 1 > m_recordingCommandLists.size())
+		{
+			m_drawStats += _renderRenderableObjects(m_frameCommandList, groups, 0, groups.size(), positionOnly);
+			return;
+		}
 
-		m_commandList->ClearDepthStencilView(m_shadowMap->DSV(),
-			D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+		// Everything recorded so far has to execute before the chunks.
+		ThrowIfFailed(m_frameCommandList->Close());
+		m_submitCommandLists.push_back(m_frameCommandList);
+
+		unsigned int firstList = m_usedRecordingCommandLists;
+		m_usedRecordingCommandLists += chunkCount;
+
+		size_t chunkSize = (groups.size() + chunkCount - 1) / chunkCount;
+
+		std::vector<DrawSubmissionStats> chunkStats(chunkCount);
+
+		m_jobSystem->ParallelFor(chunkCount, [&](unsigned int chunk)
+			{
+				auto cmdList = _resetRecordingCommandList(firstList + chunk);
+				bindPassState(cmdList);
+
+				size_t begin = chunk * chunkSize;
+				size_t end = std::min(begin + chunkSize, groups.size());
+				chunkStats[chunk] = _renderRenderableObjects(cmdList, groups, begin, end, positionOnly);
+
+				ThrowIfFailed(cmdList->Close());
+			});
+
+		for (unsigned int i = 0; i < chunkCount; i++)
+		{
+			m_submitCommandLists.push_back(m_recordingCommandLists[firstList + i].Get());
+			m_drawStats += chunkStats[i];
+		}
 
-		m_commandList->OMSetRenderTargets(0, nullptr, false, &m_shadowMap->DSV());
+		// Continue the frame on a fresh list, the pass may still record after the layer.
+		m_frameCommandList = _resetRecordingCommandList(m_usedRecordingCommandLists++);
+		m_renderGraphBackend->SetCommandList(m_frameCommandList);
+		bindPassState(m_frameCommandList);
+	}
+
+	ID3D12GraphicsCommandList* Renderer::_resetRecordingCommandList(unsigned int index)
+	{
+		// Every list is used at most once per frame, so its allocator can be reset here.
+		auto cmdAlloc = m_curFrameResource->recordingCmdAllocs[index].Get();
+		ThrowIfFailed(cmdAlloc->Reset());
+
+		auto cmdList = m_recordingCommandLists[index].Get();
+		ThrowIfFailed(cmdList->Reset(cmdAlloc, nullptr));
 
-		// Bind shadow map pass constants.
+		return cmdList;
+	}
+
+	void Renderer::_renderShadowMap()
+	{
 		unsigned int passCBByteSize = D3DUtil::CalConstantBufferByteSize(sizeof(PassConstants));
 		auto passCB = m_curFrameResource->passCBuffer->Resource();
-		D3D12_GPU_VIRTUAL_ADDRESS passCBAddress = passCB->GetGPUVirtualAddress() + passCBByteSize;
-		m_commandList->SetGraphicsRootConstantBufferView(1, passCBAddress);
-		
-		m_commandList->SetPipelineState(m_psos["shadowMap"].Get());
 
-		_renderRenderableObjects(m_commandList.Get(), m_renderLayers[(int)RenderLayer::Opaque]);
+		auto viewPort = m_shadowMap->GetViewPort();
+		auto scissorRect = m_shadowMap->GetScissorRect();
+		auto shadowPso = m_psos["shadowMap"].Get();
+
+		for (unsigned int i = 0; i < m_shadowCascades.GetCascadeCount(); i++)
+		{
+			auto dsv = m_shadowMap->DSV(i);
+
+			m_frameCommandList->ClearDepthStencilView(dsv,
+				D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+
+			// Bind the pass constants of the cascade.
+			D3D12_GPU_VIRTUAL_ADDRESS passCBAddress = passCB->GetGPUVirtualAddress() + (1 + i) * passCBByteSize;
 
-		m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-			m_shadowMap->Resource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_GENERIC_READ));
+			auto bindPassState = [=, this](ID3D12GraphicsCommandList* cmdList)
+			{
+				_bindCommonState(cmdList);
+
+				cmdList->RSSetViewports(1, &viewPort);
+				cmdList->RSSetScissorRects(1, &scissorRect);
+
+				cmdList->OMSetRenderTargets(0, nullptr, false, &dsv);
+
+				cmdList->SetGraphicsRootConstantBufferView(1, passCBAddress);
+
+				cmdList->SetPipelineState(shadowPso);
+			};
+
+			bindPassState(m_frameCommandList);
+			// Shadow casting only needs positions, fetch them from the packed stream.
+			_recordRenderLayer(m_cascadeCasterGroups[i], bindPassState, true);
+		}
 	}
 
 	void Renderer::_renderNormalDepth()
 	{
-		m_commandList->RSSetViewports(1, &m_viewPort);
-		m_commandList->RSSetScissorRects(1, &m_scissorRect);
-
-		m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_featureSSAO->GetNormalResource(),
-			D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_RENDER_TARGET));
+		auto normalRtv = m_featureSSAO->GetNormalRTV();
+		auto dsView = _getCurrentDSBufferView();
 
 		float clearValue[] = { 0.0f, 0.0f, 1.0f, 0.0f };
-		m_commandList->ClearRenderTargetView(m_featureSSAO->GetNormalRTV(), clearValue, 0, nullptr);
+		m_frameCommandList->ClearRenderTargetView(normalRtv, clearValue, 0, nullptr);
 
-		m_commandList->ClearDepthStencilView(_getCurrentDSBufferView(),
+		m_frameCommandList->ClearDepthStencilView(dsView,
 			D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 
-		m_commandList->OMSetRenderTargets(1, &m_featureSSAO->GetNormalRTV(), true, &_getCurrentDSBufferView());
-
 		auto passCB = m_curFrameResource->passCBuffer->Resource();
-		m_commandList->SetGraphicsRootConstantBufferView(1, passCB->GetGPUVirtualAddress());
+		auto normalDepthPso = m_psos["normalDepth"].Get();
+
+		auto bindPassState = [=, this](ID3D12GraphicsCommandList* cmdList)
+		{
+			_bindCommonState(cmdList);
+
+			cmdList->RSSetViewports(1, &m_viewPort);
+			cmdList->RSSetScissorRects(1, &m_scissorRect);
 
-		m_commandList->SetPipelineState(m_psos["normalDepth"].Get());
+			cmdList->OMSetRenderTargets(1, &normalRtv, true, &dsView);
 
-		_renderRenderableObjects(m_commandList.Get(), m_renderLayers[(int)RenderLayer::Opaque]);
+			cmdList->SetGraphicsRootConstantBufferView(1, passCB->GetGPUVirtualAddress());
 
-		m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-			m_featureSSAO->GetNormalResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_GENERIC_READ));
+			cmdList->SetPipelineState(normalDepthPso);
+		};
+
+		bindPassState(m_frameCommandList);
+		_recordRenderLayer(m_layerGroups[(int)RenderLayer::Opaque], bindPassState);
 	}
 
 	void Renderer::_renderAO()
 	{
-		m_commandList->SetGraphicsRootSignature(m_rootSignatureSSAO.Get());
-		m_featureSSAO->Execute(m_commandList.Get(), m_curFrameResource, 3);
+		m_frameCommandList->SetGraphicsRootSignature(m_rootSignatureSSAO.Get());
+		m_featureSSAO->Execute(m_frameCommandList, m_curFrameResource, 3);
 	}
 
 	void Renderer::OnResize()
@@ -609,7 +1142,12 @@ namespace Humpback
 		if (m_featureSSAO != nullptr)
 		{
 			m_featureSSAO->OnResize(m_width, m_height);
-			m_featureSSAO->RebuildDescriptors(m_depthStencilBuffer.Get());
+		}
+
+		// The transients are sized for the screen, the GPU is idle so their heap can be replaced.
+		if (m_renderGraph != nullptr)
+		{
+			_buildRenderGraph();
 		}
 
 		m_mainCamera->SetFrustum(0.25f * HMathHelper::PI, m_aspectRatio, 1.0f, 1000.0f);
@@ -692,6 +1230,11 @@ namespace Humpback
 		m_timer->Reset();
 	}
 
+	void Renderer::_initJobSystem()
+	{
+		m_jobSystem = std::make_unique<JobSystem>();
+	}
+
 	void Renderer::_initCamera()
 	{
 		_createCamera();
@@ -705,10 +1248,6 @@ namespace Humpback
 
 	void Renderer::_createSceneGeometry()
 	{
-		// Build the bounding sphere of the scene.
-		m_sceneBoundingSphere.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
-		m_sceneBoundingSphere.Radius = sqrtf(10.0f * 10.0f + 15.0f * 15.0f);
-
 		_createSimpleGeometry();
 	}
 
@@ -803,40 +1342,34 @@ namespace Humpback
 			vertices[k].tangent = cylinder.vertices[i].TangentU;
 		}
 
-		std::vector<std::uint16_t> indices;
-		indices.insert(indices.end(), std::begin(box.GetIndices16()), std::end(box.GetIndices16()));
-		indices.insert(indices.end(), std::begin(grid.GetIndices16()), std::end(grid.GetIndices16()));
-		indices.insert(indices.end(), std::begin(sphere.GetIndices16()), std::end(sphere.GetIndices16()));
-		indices.insert(indices.end(), std::begin(cylinder.GetIndices16()), std::end(cylinder.GetIndices16()));
-
-		const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-		const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
+		// Kept at 32 bit until _uploadIndices has checked that 16 bit holds them.
+		std::vector<std::uint32_t> indices;
+		indices.insert(indices.end(), std::begin(box.indices32), std::end(box.indices32));
+		indices.insert(indices.end(), std::begin(grid.indices32), std::end(grid.indices32));
+		indices.insert(indices.end(), std::begin(sphere.indices32), std::end(sphere.indices32));
+		indices.insert(indices.end(), std::begin(cylinder.indices32), std::end(cylinder.indices32));
 
 		auto geo = std::make_unique<Mesh>();
 		geo->Name = "shapeGeo";
 
-		ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->vertexBufferCPU));
-		CopyMemory(geo->vertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-		ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->indexBufferCPU));
-		CopyMemory(geo->indexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-		geo->vertexBufferGPU = D3DUtil::CreateDefaultBuffer(m_device.Get(),
-			m_commandList.Get(), vertices.data(), vbByteSize, geo->vertexBufferUploader);
-
-		geo->indexBufferGPU = D3DUtil::CreateDefaultBuffer(m_device.Get(),
-			m_commandList.Get(), indices.data(), ibByteSize, geo->indexBufferUploader);
-
-		geo->vertexByteStride = sizeof(Vertex);
-		geo->vertexBufferByteSize = vbByteSize;
-		geo->indexFormat = DXGI_FORMAT_R16_UINT;
-		geo->indexBufferByteSize = ibByteSize;
+		BoundingBox::CreateFromPoints(boxSubmesh.aabb, box.vertices.size(),
+			&box.vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+		BoundingBox::CreateFromPoints(gridSubmesh.aabb, grid.vertices.size(),
+			&grid.vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+		BoundingBox::CreateFromPoints(sphereSubmesh.aabb, sphere.vertices.size(),
+			&sphere.vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+		BoundingBox::CreateFromPoints(cylinderSubmesh.aabb, cylinder.vertices.size(),
+			&cylinder.vertices[0].Position, sizeof(GeometryGenerator::Vertex));
 
 		geo->drawArgs["box"] = boxSubmesh;
 		geo->drawArgs["grid"] = gridSubmesh;
 		geo->drawArgs["sphere"] = sphereSubmesh;
 		geo->drawArgs["cylinder"] = cylinderSubmesh;
 
+		_uploadVertices(*geo, vertices);
+		_buildMeshlets(*geo, vertices, indices);
+		_uploadIndices(*geo, indices);
+
 		m_meshes[geo->Name] = std::move(geo);
 	}
 
@@ -896,7 +1429,7 @@ namespace Humpback
 
 		fin >> ignore >> ignore >> ignore;
 
-		std::vector<std::int32_t> indices(primCount * 3);
+		std::vector<std::uint32_t> indices(primCount * 3);
 		for (size_t i = 0; i < primCount; i++)
 		{
 			fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
@@ -904,29 +1437,9 @@ namespace Humpback
 
 		fin.close();
 
-		unsigned int vbByteSize = vertices.size() * sizeof(Vertex);
-		unsigned int ibByteSize = indices.size() * sizeof(std::uint32_t);
-
 		auto skullMesh = std::make_unique<Mesh>();
 		skullMesh->Name = "skullGeo";
 
-		ThrowIfFailed(D3DCreateBlob(vbByteSize, &(skullMesh->vertexBufferCPU)));
-		CopyMemory(skullMesh->vertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-		ThrowIfFailed(D3DCreateBlob(ibByteSize, &(skullMesh->indexBufferCPU)));
-		CopyMemory(skullMesh->indexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-		skullMesh->vertexBufferGPU = D3DUtil::CreateDefaultBuffer(m_device.Get(), m_commandList.Get(),
-			vertices.data(), vbByteSize, skullMesh->vertexBufferUploader);
-
-		skullMesh->indexBufferGPU = D3DUtil::CreateDefaultBuffer(m_device.Get(), m_commandList.Get(),
-			indices.data(), ibByteSize, skullMesh->indexBufferUploader);
-
-		skullMesh->vertexByteStride = sizeof(Vertex);
-		skullMesh->vertexBufferByteSize = vbByteSize;
-		skullMesh->indexFormat = DXGI_FORMAT_R32_UINT;
-		skullMesh->indexBufferByteSize = ibByteSize;
-
 		SubMesh skullSM;
 		skullSM.indexCount = indices.size();
 		skullSM.baseVertexLocation = 0;
@@ -940,18 +1453,141 @@ namespace Humpback
 
 		skullMesh->drawArgs["skull"] = skullSM;
 
+		_uploadVertices(*skullMesh, vertices);
+		_buildMeshlets(*skullMesh, vertices, indices);
+		_uploadIndices(*skullMesh, indices);
+
 		m_meshes[skullMesh->Name] = std::move(skullMesh);
 	}
 
+	void Renderer::_uploadVertices(Mesh& mesh, const std::vector<Vertex>& vertices)
+	{
+		auto upload = [&](const void* vertexData, UINT vertexStride, const void* positionData, UINT positionStride)
+		{
+			UINT vbByteSize = (UINT)vertices.size() * vertexStride;
+			mesh.vertexBufferGPU = m_uploadAllocator->CreateDefaultBuffer(m_commandList.Get(), vertexData, vbByteSize);
+			mesh.vertexByteStride = vertexStride;
+			mesh.vertexBufferByteSize = vbByteSize;
+
+			mesh.positionBufferByteSize = (UINT)vertices.size() * positionStride;
+			mesh.positionBufferGPU = m_uploadAllocator->CreateDefaultBuffer(m_commandList.Get(),
+				positionData, mesh.positionBufferByteSize);
+			mesh.positionByteStride = positionStride;
+		};
+
+		if (m_packedVertices == false)
+		{
+			std::vector<XMFLOAT3> positions = BuildPositionStream(vertices);
+			upload(vertices.data(), sizeof(Vertex), positions.data(), sizeof(XMFLOAT3));
+			return;
+		}
+
+		// Each submesh owns the vertices from its baseVertexLocation up to the next one
+		// and is quantized against its own bounds.
+		std::vector<SubMesh*> subMeshes;
+		for (auto& drawArg : mesh.drawArgs)
+		{
+			subMeshes.push_back(&drawArg.second);
+		}
+
+		std::sort(subMeshes.begin(), subMeshes.end(), [](const SubMesh* a, const SubMesh* b)
+			{
+				return a->baseVertexLocation < b->baseVertexLocation;
+			});
+
+		std::vector<PackedVertex> packed(vertices.size());
+		for (size_t i = 0; i < subMeshes.size(); i++)
+		{
+			size_t first = subMeshes[i]->baseVertexLocation;
+			size_t end = i + 1 < subMeshes.size() ? subMeshes[i + 1]->baseVertexLocation : vertices.size();
+
+			SubMesh* subMesh = subMeshes[i];
+			subMesh->quantization = GetPositionQuantization(subMesh->aabb.Center, subMesh->aabb.Extents);
+			PackVertices(vertices.data() + first, end - first, subMesh->quantization, packed.data() + first,
+				nullptr, m_jobSystem.get());
+		}
+
+		std::vector<PackedPosition> positions = BuildPackedPositionStream(packed);
+		upload(packed.data(), sizeof(PackedVertex), positions.data(), sizeof(PackedPosition));
+	}
+
+	void Renderer::_uploadIndices(Mesh& mesh, const std::vector<uint32_t>& indices)
+	{
+		std::vector<IndexSubRange> subRanges;
+		std::vector<SubMesh*> subMeshes;
+		for (auto& drawArg : mesh.drawArgs)
+		{
+			IndexSubRange subRange;
+			subRange.startIndexLocation = drawArg.second.startIndexLocation;
+			subRange.indexCount = drawArg.second.indexCount;
+			subRange.firstMeshlet = drawArg.second.firstMeshlet;
+			subRange.meshletCount = drawArg.second.meshletCount;
+			subRanges.push_back(subRange);
+			subMeshes.push_back(&drawArg.second);
+		}
+
+		std::vector<uint16_t> indices16;
+		mesh.indexBatches.clear();
+
+		const void* indexData = indices.data();
+		UINT ibByteSize = (UINT)(indices.size() * sizeof(uint32_t));
+		mesh.indexFormat = DXGI_FORMAT_R32_UINT;
+
+		if (PackIndices16(indices.data(), indices.size(), mesh.meshlets.data(), subRanges, indices16, mesh.indexBatches))
+		{
+			for (size_t i = 0; i < subMeshes.size(); i++)
+			{
+				subMeshes[i]->firstBatch = subRanges[i].firstBatch;
+				subMeshes[i]->batchCount = subRanges[i].batchCount;
+			}
+
+			indexData = indices16.data();
+			ibByteSize = (UINT)(indices16.size() * sizeof(uint16_t));
+			mesh.indexFormat = DXGI_FORMAT_R16_UINT;
+		}
+
+		mesh.indexBufferGPU = m_uploadAllocator->CreateDefaultBuffer(m_commandList.Get(), indexData, ibByteSize);
+		mesh.indexBufferByteSize = ibByteSize;
+	}
+
+	void Renderer::_buildMeshlets(Mesh& mesh, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		// Meshlets are stored in index buffer order like the imported ones.
+		std::vector<SubMesh*> subMeshes;
+		for (auto& drawArg : mesh.drawArgs)
+		{
+			subMeshes.push_back(&drawArg.second);
+		}
+
+		std::sort(subMeshes.begin(), subMeshes.end(), [](const SubMesh* a, const SubMesh* b)
+			{
+				return a->startIndexLocation < b->startIndexLocation;
+			});
+
+		std::vector<XMFLOAT3> positions = BuildPositionStream(vertices);
+
+		mesh.meshlets.clear();
+		for (SubMesh* subMesh : subMeshes)
+		{
+			subMesh->firstMeshlet = (unsigned int)mesh.meshlets.size();
+			BuildMeshlets(indices.data() + subMesh->startIndexLocation, subMesh->indexCount,
+				&positions[subMesh->baseVertexLocation].x, vertices.size() - subMesh->baseVertexLocation,
+				subMesh->startIndexLocation, mesh.meshlets);
+			subMesh->meshletCount = (unsigned int)mesh.meshlets.size() - subMesh->firstMeshlet;
+		}
+	}
+
 	void Renderer::_loadGeometryFromFileASSIMP()
 	{
-		m_modelLoader = std::make_unique<HMeshImporter>(m_device.Get(), m_commandList.Get());
+		m_modelLoader = std::make_unique<HMeshImporter>(m_device.Get(), m_commandList.Get(), m_uploadAllocator.get(), m_assetCache.get(),
+			m_jobSystem.get(), m_packedVertices);
 		if (m_modelLoader->Load("Assets/PreviewSphere.fbx") == false)
 		{
 			MessageBox(0, L"Can NOT load Assets/PreviewSphere.fbx", 0, 0);
 		}
 
-		auto modelImporter = std::make_unique<HMeshImporter>(m_device.Get(), m_commandList.Get());
+		auto modelImporter = std::make_unique<HMeshImporter>(m_device.Get(), m_commandList.Get(), m_uploadAllocator.get(), m_assetCache.get(),
+			m_jobSystem.get(), m_packedVertices);
 		if (modelImporter->Load("Assets/MeetMat/MeetMat.fbx") == false)
 		{
 			MessageBox(0, L"Can NOT load MeetMat.fbx", 0, 0);
@@ -1004,9 +1640,12 @@ namespace Humpback
 
 		_createRtvAndDsvDescriptorHeaps();
 		m_rtvDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-		m_cbvSrvUavDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 		m_dsvDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
 		ThrowIfFailed(m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
+
+		m_gpuMemory = std::make_unique<GpuMemoryAllocator>(m_device.Get());
+		m_uploadAllocator = std::make_unique<UploadAllocator>(m_device.Get(), m_gpuMemory.get());
+		m_bindlessHeap = std::make_unique<BindlessDescriptorHeap>(m_device.Get());
 		
 		_createCommandObjects();
 		_createSwapChain(factory.Get());
@@ -1014,8 +1653,11 @@ namespace Humpback
 
 	void Renderer::_initRendererFeatures()
 	{
-		m_shadowMap = std::make_unique<ShadowMap>(m_device.Get(), 2048, 2048);
-		m_featureSSAO = std::make_unique<SSAO>(m_width, m_height, m_device.Get(), m_commandList.Get());
+		unsigned int shadowResolution = m_shadowCascades.GetResolution();
+		m_shadowMap = std::make_unique<ShadowMap>(m_device.Get(), shadowResolution, shadowResolution,
+			(unsigned int)ShadowCascades::MAX_CASCADES);
+		m_featureSSAO = std::make_unique<SSAO>(m_width, m_height, m_device.Get(), m_commandList.Get(),
+			m_uploadAllocator.get(), m_gpuMemory.get());
 	}
 
 	void Renderer::_createCommandObjects()
@@ -1025,6 +1667,9 @@ namespace Humpback
 		queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
 		ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
 
+		queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+		ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_copyQueue)));
+
 		ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_commandAllocator)));
 
 		ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
@@ -1071,30 +1716,37 @@ namespace Humpback
 		D3D12_DESCRIPTOR_HEAP_DESC dsvDesc = {};
 		dsvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
 		dsvDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-		dsvDesc.NumDescriptors = FrameBufferCount;
+		dsvDesc.NumDescriptors = 1 + ShadowCascades::MAX_CASCADES;	// The depth buffer and a shadow map slice per cascade.
 		dsvDesc.NodeMask = 0;
 		ThrowIfFailed(m_device->CreateDescriptorHeap(&dsvDesc, IID_PPV_ARGS(&m_dsvHeap)));
 	}
 
 	void Renderer::_createRootSignature()
 	{
+		// Unbounded ranges over the bindless heap: _Textures[] in space2, _CubeTextures[] in space3
+		// and _TextureArrays[] in space4.
 		CD3DX12_DESCRIPTOR_RANGE texTable0;
-		texTable0.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 3, 0, 0);
+		texTable0.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 2);
 
 		CD3DX12_DESCRIPTOR_RANGE texTable1;
-		texTable1.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 10, 3, 0);
+		texTable1.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 3);
 
-		CD3DX12_ROOT_PARAMETER slotRootParameter[5];
+		CD3DX12_DESCRIPTOR_RANGE texTable2;
+		texTable2.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 4);
 
-		slotRootParameter[0].InitAsConstantBufferView(0);
+		CD3DX12_ROOT_PARAMETER slotRootParameter[7];
+
+		slotRootParameter[0].InitAsShaderResourceView(1, 1);
 		slotRootParameter[1].InitAsConstantBufferView(1);
 		slotRootParameter[2].InitAsShaderResourceView(0, 1);
 		slotRootParameter[3].InitAsDescriptorTable(1, &texTable0, D3D12_SHADER_VISIBILITY_PIXEL);
 		slotRootParameter[4].InitAsDescriptorTable(1, &texTable1, D3D12_SHADER_VISIBILITY_PIXEL);
+		slotRootParameter[5].InitAsShaderResourceView(2, 1);
+		slotRootParameter[6].InitAsDescriptorTable(1, &texTable2, D3D12_SHADER_VISIBILITY_PIXEL);
 
 		auto staticSamplers = D3DUtil::GetCommonStaticSamplers();
 
-		CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(5, slotRootParameter, staticSamplers.size(),
+		CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(7, slotRootParameter, staticSamplers.size(),
 			staticSamplers.data(), D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
 		ComPtr<ID3DBlob> serializedRootSig = nullptr;
@@ -1116,17 +1768,14 @@ namespace Humpback
 
 	void Renderer::_createRootSignatureSSAO()
 	{
-		CD3DX12_DESCRIPTOR_RANGE texTable0;
-		texTable0.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 2, 0, 0);
+		CD3DX12_DESCRIPTOR_RANGE texTable;
+		texTable.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 2);
 
-		CD3DX12_DESCRIPTOR_RANGE texTable1;
-		texTable1.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 2, 0);
-
-		CD3DX12_ROOT_PARAMETER rootParams[4];
+		// The blur direction followed by the bindless indices of the normal, depth and input maps.
+		CD3DX12_ROOT_PARAMETER rootParams[3];
 		rootParams[0].InitAsConstantBufferView(0);
-		rootParams[1].InitAsConstants(1, 1);
-		rootParams[2].InitAsDescriptorTable(1, &texTable0, D3D12_SHADER_VISIBILITY_PIXEL);
-		rootParams[3].InitAsDescriptorTable(1, &texTable1, D3D12_SHADER_VISIBILITY_PIXEL);
+		rootParams[1].InitAsConstants(SSAO::ROOT_CONSTANT_COUNT, 1);
+		rootParams[2].InitAsDescriptorTable(1, &texTable, D3D12_SHADER_VISIBILITY_PIXEL);
 
 		const CD3DX12_STATIC_SAMPLER_DESC pointClamp(0,
 			D3D12_FILTER_MIN_MAG_MIP_POINT,
@@ -1156,7 +1805,7 @@ namespace Humpback
 		std::array<CD3DX12_STATIC_SAMPLER_DESC, 4> staticSamps = {
 			pointClamp, linearClamp, depthSamp, linearWrap };
 
-		CD3DX12_ROOT_SIGNATURE_DESC rsDesc(4, rootParams, staticSamps.size(), 
+		CD3DX12_ROOT_SIGNATURE_DESC rsDesc(3, rootParams, staticSamps.size(), 
 			staticSamps.data(), D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
 		ComPtr<ID3DBlob> serializedRootSig = nullptr;
@@ -1199,12 +1848,33 @@ namespace Humpback
 		_createVertexShader(normalOnlyFullPath, "normalOnlyVS");
 		_createPixelShader(normalOnlyFullPath, "normalOnlyPS");
 
-		m_inputLayout = {
-			{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-			{"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-			{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-			{"TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 32, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		};
+		if (m_packedVertices)
+		{
+			// PackedVertex, the shaders decode it with PACKED_VERTEX defined.
+			m_inputLayout = {
+				{"POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+				{"NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+				{"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+				{"TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			};
+
+			m_positionOnlyInputLayout = {
+				{"POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+			};
+		}
+		else
+		{
+			m_inputLayout = {
+				{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+				{"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+				{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+				{"TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 32, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			};
+
+			m_positionOnlyInputLayout = {
+				{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+			};
+		}
 	}
 
 	void Renderer::_createPso()
@@ -1239,6 +1909,14 @@ namespace Humpback
 		opaquePsoDesc.DSVFormat = m_dsFormat;
 		ThrowIfFailed(m_device->CreateGraphicsPipelineState(&opaquePsoDesc, IID_PPV_ARGS(&m_psos["opaque"])));
 		// --------------------------------------------------------------------------------
+
+		// PSO for opaque objects on top of the normal-depth prepass.
+		// Only the nearest surface passes, so the PBR pixel shader runs once per pixel.
+		// LESS_EQUAL instead of EQUAL tolerates the two vertex shaders rounding differently.
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC opaqueDepthReusePsoDesc = opaquePsoDesc;
+		opaqueDepthReusePsoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+		opaqueDepthReusePsoDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+		ThrowIfFailed(m_device->CreateGraphicsPipelineState(&opaqueDepthReusePsoDesc, IID_PPV_ARGS(&m_psos["opaqueDepthReuse"])));
 		
 		// PSO for sky box.
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC skyBoxPSODesc = opaquePsoDesc;
@@ -1262,6 +1940,7 @@ namespace Humpback
 
 		// PSO for shadow map.
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC sm_PSO_desc = opaquePsoDesc;
+		sm_PSO_desc.InputLayout = { m_positionOnlyInputLayout.data(), (UINT)m_positionOnlyInputLayout.size() };
 		sm_PSO_desc.VS =
 		{
 			reinterpret_cast<BYTE*>(m_shaders["shadowMapVS"]->GetBufferPointer()),
@@ -1336,7 +2015,9 @@ namespace Humpback
 
 	void Renderer::_createVertexShader(const std::wstring& fullPath, const std::string& shaderName)
 	{
-		m_shaders[shaderName] = D3DUtil::CompileShader(fullPath, nullptr, "VS", Renderer::SHADER_MODEL_VERTEX);
+		// Only the vertex shaders read the vertex layout.
+		m_shaders[shaderName] = D3DUtil::CompileShader(fullPath, m_packedVertices ? PACKED_VERTEX_DEFINES : nullptr,
+			"VS", Renderer::SHADER_MODEL_VERTEX);
 	}
 
 	void Renderer::_createPixelShader(const std::wstring& fullPath, const std::string& shaderName)
@@ -1346,60 +2027,156 @@ namespace Humpback
 
 	void Renderer::_createAllRenderableObjects()
 	{
-		g_constantBufferIdx = 0;
+		m_renderables = std::make_unique<RenderableStore>(FRAME_RESOURCE_COUNT);
+		for (int layer = 0; layer < (int)RenderLayer::Count; layer++)
+		{
+			m_layerBvhs[layer] = std::make_unique<SceneBvh>(m_jobSystem.get());
+		}
+
+		// A quarter of a 720p view per side, the shadow map is square.
+		m_cameraOcclusion = std::make_unique<OcclusionCuller>(320, 180, m_jobSystem.get());
+		for (auto& shadowOcclusion : m_shadowOcclusion)
+		{
+			shadowOcclusion = std::make_unique<OcclusionCuller>(256, 256, m_jobSystem.get());
+		}
 
 		_createRenderableObject("mat_sky", m_meshes["shapeGeo"].get(), "sphere", RenderLayer::Sky, XMMatrixScaling(5000.0f, 5000.0f, 5000.0f));
-		_createRenderableObject("mat_bricks", m_meshes["shapeGeo"].get(), "grid", RenderLayer::Opaque, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-		_createRenderableObject("mat_preview_sphere", m_modelLoader->GetMesh(), "main", RenderLayer::Opaque, XMMatrixScaling(2.0f, 2.0f, 2.0f) * XMMatrixTranslation(2.0f, 2.5f, 0.0f));
-		_createRenderableObject("mat_character", m_modelImporters[0]->GetMesh(), "main", RenderLayer::Opaque, XMMatrixScaling(.5f, .5f, .5f) * XMMatrixTranslation(-4.0f, 0.0f, 0.0f));
-		_createRenderableObject("mat_char_body", m_modelImporters[0]->GetMesh(1), "main", RenderLayer::Opaque, XMMatrixScaling(.5f, .5f, .5f) * XMMatrixTranslation(-4.0f, 0.0f, 0.0f));
-		_createRenderableObject("mat_char_base", m_modelImporters[0]->GetMesh(2), "main", RenderLayer::Opaque, XMMatrixScaling(.5f, .5f, .5f) * XMMatrixTranslation(-4.0f, 0.0f, 0.0f));
+		_createRenderableObject("mat_bricks", m_meshes["shapeGeo"].get(), "grid", RenderLayer::Opaque, XMMatrixScaling(1.0f, 1.0f, 1.0f))->occluder = true;
+
+		// Imported models hang their node tree below a root placing the whole model.
+		std::vector<uint32_t> meshNodes;
+		uint32_t sphereRoot = m_transforms.AddNode(TransformHierarchy::NO_PARENT, XMMatrixScaling(2.0f, 2.0f, 2.0f) * XMMatrixTranslation(2.0f, 2.5f, 0.0f));
+		m_modelLoader->AddNodes(m_transforms, sphereRoot, meshNodes);
+		_createRenderableObject("mat_preview_sphere", m_modelLoader->GetMesh(), "main", RenderLayer::Opaque, XMMatrixIdentity(), meshNodes[0]);
+
+		uint32_t characterRoot = m_transforms.AddNode(TransformHierarchy::NO_PARENT, XMMatrixScaling(.5f, .5f, .5f) * XMMatrixTranslation(-4.0f, 0.0f, 0.0f));
+		m_modelImporters[0]->AddNodes(m_transforms, characterRoot, meshNodes);
+		_createRenderableObject("mat_character", m_modelImporters[0]->GetMesh(), "main", RenderLayer::Opaque, XMMatrixIdentity(), meshNodes[0]);
+		_createRenderableObject("mat_char_body", m_modelImporters[0]->GetMesh(1), "main", RenderLayer::Opaque, XMMatrixIdentity(), meshNodes[1]);
+		_createRenderableObject("mat_char_base", m_modelImporters[0]->GetMesh(2), "main", RenderLayer::Opaque, XMMatrixIdentity(), meshNodes[2]);
+
+		if (m_createInstancingStressScene)
+		{
+			_createInstancingStressScene();
+		}
+
+		// Every object can be drawn once for the camera and opaque ones once more for each shadow cascade.
+		m_instanceCount = (unsigned int)(m_renderableList.size() +
+			ShadowCascades::MAX_CASCADES * m_renderLayers[(int)RenderLayer::Opaque].size());
+
+		// World matrices and culling boxes of the new objects.
+		_updateTransforms();
 	}
 
-	void Renderer::_createRenderableObject(const std::string& matName, Mesh* pMesh,
-		const std::string& drawArgs, RenderLayer layer, DirectX::XMMATRIX scaleTranslate)
+	void Renderer::_createInstancingStressScene()
+	{
+		// 50k identical boxes, drawn as one instanced draw per pass.
+		const int sideX = 250;
+		const int sideZ = 200;
+		const float spacing = 2.0f;
+
+		for (int z = 0; z < sideZ; z++)
+		{
+			for (int x = 0; x < sideX; x++)
+			{
+				XMMATRIX translate = XMMatrixTranslation((x - sideX / 2) * spacing, 0.25f, (z - sideZ / 2) * spacing);
+				_createRenderableObject("mat_bricks", m_meshes["shapeGeo"].get(), "box", RenderLayer::Opaque, translate)->occluder = true;
+			}
+		}
+	}
+
+	RenderableObject* Renderer::_createRenderableObject(const std::string& matName, Mesh* pMesh,
+		const std::string& drawArgs, RenderLayer layer, DirectX::XMMATRIX localTransform, uint32_t parentNode)
 	{
 		auto ro = std::make_unique<RenderableObject>();
-		XMStoreFloat4x4(&ro->worldM, scaleTranslate);
-		ro->texTrans = HMathHelper::Identity4x4();
-		ro->cbIndex = g_constantBufferIdx;
+		ro->transformNode = m_transforms.AddNode(parentNode, localTransform);
 		ro->material = m_materials[matName].get();
 		ro->mesh = pMesh;
 		ro->indexCount = ro->mesh->drawArgs[drawArgs].indexCount;
 		ro->startIndexLocation = ro->mesh->drawArgs[drawArgs].startIndexLocation;
 		ro->baseVertexLocation = ro->mesh->drawArgs[drawArgs].baseVertexLocation;
-		m_renderLayers[(int)layer].push_back(ro.get());
+		ro->meshlets = ro->mesh->meshlets.data() + ro->mesh->drawArgs[drawArgs].firstMeshlet;
+		ro->meshletCount = ro->mesh->drawArgs[drawArgs].meshletCount;
+		ro->indexBatches = ro->mesh->indexBatches.data() + ro->mesh->drawArgs[drawArgs].firstBatch;
+		ro->indexBatchCount = ro->mesh->drawArgs[drawArgs].batchCount;
+
+		// Ids are handed out in creation order, the first object of a mesh defines it. Geometries are numbered
+		// per mesh, the mesh field of the sort key already tells meshes apart.
+		auto meshId = m_meshIds.try_emplace(pMesh, (unsigned int)m_meshIds.size());
+		ro->meshId = meshId.first->second;
+		unsigned int& geometryCount = m_meshGeometryCounts[pMesh];
+		auto geometryId = m_geometryIds.try_emplace(std::make_pair(pMesh, drawArgs), geometryCount);
+		geometryCount += geometryId.second ? 1 : 0;
+		ro->geometryId = geometryId.first->second;
+
+		// Checked once here, so building the sort keys every frame can't fail.
+		if (ro->meshId >> DrawQueue::MESH_BITS != 0 || ro->geometryId >> DrawQueue::GEOMETRY_BITS != 0 ||
+			(unsigned int)ro->material->matCBIdx >> DrawQueue::MATERIAL_BITS != 0)
+		{
+			throw std::runtime_error("Renderer: Too many meshes, geometries of a mesh or materials for the draw sort key.");
+		}
+
+		// Placed at the origin, _updateTransforms moves the object and its box.
+		const SubMesh& subMesh = ro->mesh->drawArgs[drawArgs];
+		ro->id = m_renderables->Add(subMesh.aabb, subMesh.quantization, ro->material->matCBIdx);
+		ro->layer = (unsigned int)layer;
+		ro->cullIndex = m_layerBvhs[(int)layer]->AddBox(subMesh.aabb);
+
+		m_nodeObjects.resize(m_transforms.GetNodeCount(), nullptr);
+		m_nodeObjects[ro->transformNode] = ro.get();
+
+		RenderableObject* pObj = ro.get();
+		m_renderLayers[(int)layer].push_back(pObj);
 		m_renderableList.push_back(std::move(ro));
-		++g_constantBufferIdx;
+
+		return pObj;
 	}
 
 	void Renderer::_createAllMaterials()
 	{
 		g_matIdx = 0;
-
-		_createMaterial("mat_bricks", m_defaultWhiteIndex, m_defaultNormalMapIndex, m_defaultBlackIndex, XMFLOAT4(Colors::DarkGray));
-		_createMaterial("mat_sky", m_skyTexHeapIndex, m_defaultNormalMapIndex, m_defaultBlackIndex, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
-		_createMaterial("mat_preview_sphere", 0, 1, 2, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
-		_createMaterial("mat_character", 3, m_defaultNormalMapIndex, 4, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
-		_createMaterial("mat_char_body", 5, m_defaultNormalMapIndex, 6, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
-		_createMaterial("mat_char_base", 7, m_defaultNormalMapIndex, 8, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+		m_materialUploads = std::make_unique<UploadTracker>(FRAME_RESOURCE_COUNT);
+
+		_createMaterial("mat_bricks", "tex_default_white", "tex_default_normal", "tex_default_black", XMFLOAT4(Colors::DarkGray));
+		_createMaterial("mat_sky", "tex_default_white", "tex_default_normal", "tex_default_black", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+		_createMaterial("mat_preview_sphere", "tex_sphere_albedo", "tex_sphere_normal", "tex_sphere_metallic", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+		_createMaterial("mat_character", "tex_char_albedo", "tex_default_normal", "tex_char_metallic_smoothness", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+		_createMaterial("mat_char_body", "tex_char_body_albedo", "tex_default_normal", "tex_char_body_met_smo", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+		_createMaterial("mat_char_base", "tex_char_base_albedo", "tex_default_normal", "tex_char_base_met_smo", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
 	}
 
-	void Renderer::_createMaterial(const std::string& matName, int diffuseSrvIdx, int normalSrvIdx, int metallicSmoothnessSrvIdx, XMFLOAT4& diffuseTint)
+	void Renderer::_createMaterial(const std::string& matName, const std::string& diffuseTex, const std::string& normalTex,
+		const std::string& metallicSmoothnessTex, XMFLOAT4& diffuseTint)
 	{
 		auto mat = std::make_unique<Material>();
 		mat->name = matName;
 		mat->matCBIdx = g_matIdx;
-		mat->diffuseSrvHeapIndex = diffuseSrvIdx;
-		mat->normalSrvHeapIndex = normalSrvIdx;
-		mat->metallicSmothnessSrvHeapIndex = metallicSmoothnessSrvIdx;
+		mat->diffuseSrvHeapIndex = _getTextureSrvIndex(diffuseTex);
+		mat->normalSrvHeapIndex = _getTextureSrvIndex(normalTex);
+		mat->metallicSmothnessSrvHeapIndex = _getTextureSrvIndex(metallicSmoothnessTex);
 		mat->diffuseAlbedo = diffuseTint;
 
 		g_matIdx += 1;
 
+		m_materialList.push_back(mat.get());
+		m_materialUploads->Resize((uint32_t)m_materialList.size());
+
 		m_materials[matName] = std::move(mat);
 	}
 
+	uint32_t Renderer::_getTextureSrvIndex(const std::string& texName) const
+	{
+		for (auto& tex : m_textures)
+		{
+			if (tex->name == texName)
+			{
+				return tex->srvIndex;
+			}
+		}
+
+		throw std::runtime_error("Texture not found: " + texName);
+	}
+
 	void Renderer::_loadTextures()
 	{
 		std::vector<std::string> texNames =
@@ -1421,159 +2198,211 @@ namespace Humpback
 			"tex_default_normal",
 		};
 
-		std::vector<std::wstring> texPaths =
+		std::vector<TextureSource> texSources =
 		{
-			L"Assets/PreviewSphere_Sphere_AlbedoTransparency.png",
-			L"Assets/PreviewSphere_Sphere_Normal.png",
-			L"Assets/PreviewSphere_Sphere_MetallicSmoothness.png",
-			L"Assets/MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_01_Head_AlbedoTransparency.png",
-			L"Assets/MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_01_Head_MetallicSmoothness.png",
-			L"Assets/MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_02_Body_AlbedoTransparency.png",
-			L"Assets/MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_02_Body_MetallicSmoothness.png",
-			L"Assets/MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_03_Base_AlbedoTransparency.png",
-			L"Assets/MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_03_Base_MetallicSmoothness.png",
+			{ "Assets/PreviewSphere_Sphere_AlbedoTransparency.png", TextureRole::Albedo },
+			{ "Assets/PreviewSphere_Sphere_Normal.png", TextureRole::NormalMap },
+			{ "Assets/PreviewSphere_Sphere_MetallicSmoothness.png", TextureRole::Linear },
+			{ "Assets/MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_01_Head_AlbedoTransparency.png", TextureRole::Albedo },
+			{ "Assets/MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_01_Head_MetallicSmoothness.png", TextureRole::Linear },
+			{ "Assets/MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_02_Body_AlbedoTransparency.png", TextureRole::Albedo },
+			{ "Assets/MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_02_Body_MetallicSmoothness.png", TextureRole::Linear },
+			{ "Assets/MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_03_Base_AlbedoTransparency.png", TextureRole::Albedo },
+			{ "Assets/MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_03_Base_MetallicSmoothness.png", TextureRole::Linear },
+
 
 
-			L"Assets/white.png",
-			L"Assets/black.png",
-			L"Assets/default_normal_map.png",
+			{ "Assets/white.png", TextureRole::Linear },
+			{ "Assets/black.png", TextureRole::Linear },
+			{ "Assets/default_normal_map.png", TextureRole::NormalMap },
 		};
 
-		m_defaultNormalMapIndex = texPaths.size() - 1;
-		m_defaultBlackIndex = texPaths.size() - 2;
-		m_defaultWhiteIndex = texPaths.size() - 3;
+		// The skybox cubemap is a DDS, already in GPU layout, so it only needs reading. That
+		// overlaps the PNG decoding, and it bypasses the cache since parsing it is as cheap as an entry.
+		auto sky = std::make_unique<Texture>();
+		sky->name = "sky_box";
+		sky->filePath = L"Assets/grasscube1024.dds";
+		sky->viewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+		std::unique_ptr<uint8_t[]> skyData;
+		std::vector<D3D12_SUBRESOURCE_DATA> skySubresources;
+		std::future<void> skyLoaded = m_jobSystem->Submit([&]()
+			{
+				ThrowIfFailed(LoadDDSTextureFromFile(m_device.Get(), sky->filePath.c_str(),
+					sky->resource.GetAddressOf(), skyData, skySubresources));
+			});
 
-		for (size_t i = 0; i < texPaths.size(); i++)
+		TextureLoadPipeline pipeline(*m_jobSystem, m_assetCache.get(), MAX_TEXTURE_SIZE, true);
+		pipeline.SetFallbackDecoder([this](const std::string& path, DecodedImage& image) { return _decodeWICTexture(path, image); });
+
+		std::vector<std::unique_ptr<DecodedTexture>> decoded;
+		try
+		{
+			decoded = pipeline.Decode(texSources, m_textureLoadTimings);
+		}
+		catch (...)
+		{
+			// The sky job writes to the locals above.
+			skyLoaded.wait();
+			throw;
+		}
+		skyLoaded.get();
+
+		// Everything goes out in one batch on the copy queue. The batch copies the pixels into its own
+		// staging buffers, the decoded images and cache mappings can be released once it is recorded.
+		auto recordStart = std::chrono::steady_clock::now();
+		ResourceUploadBatch uploadBatch(m_device.Get());
+		uploadBatch.Begin(D3D12_COMMAND_LIST_TYPE_COPY);
+
+		for (size_t i = 0; i < decoded.size(); i++)
 		{
-			std::wstring path = texPaths[i];
+			const DecodedTexture& src = *decoded[i];
+
 			auto tex = std::make_unique<Texture>();
 			tex->name = texNames[i];
-			tex->filePath = texPaths[i];
-			D3D12_SUBRESOURCE_DATA subresource;
-			std::unique_ptr<uint8_t[]> decodedData;
-			ThrowIfFailed(LoadWICTextureFromFile(m_device.Get(), path.c_str(), 
-				tex->resource.GetAddressOf(), decodedData, subresource, 2048));
-
-			const UINT64 uploadBufferSize = GetRequiredIntermediateSize(tex->resource.Get(), 0, 1);
-
-			CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
-
-			auto desc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
-
-			// Create the GPU upload buffer.
-			ThrowIfFailed(
-				m_device->CreateCommittedResource(
-					&heapProps,
-					D3D12_HEAP_FLAG_NONE,
-					&desc,
-					D3D12_RESOURCE_STATE_GENERIC_READ,
-					nullptr,
-					IID_PPV_ARGS(tex->uploadHeap.GetAddressOf())));
-		
-			UpdateSubresources<1>(m_commandList.Get(), tex->resource.Get(), tex->uploadHeap.Get(),
-				0, 0, 1, &subresource);
+			tex->filePath = std::filesystem::path(src.sourcePath).wstring();
 
-			auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(tex->resource.Get(),
-				D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-			m_commandList->ResourceBarrier(1, &barrier);
+			if (src.blockFormat != BlockFormat::None)
+			{
+				// Block compressed textures come out of the pipeline as DDS files, loaded like the sky box.
+				std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+				ThrowIfFailed(LoadDDSTextureFromMemory(m_device.Get(), src.pixels, (size_t)src.dataSize,
+					tex->resource.GetAddressOf(), subresources));
+				_placeTexture(tex.get());
+				uploadBatch.Upload(tex->resource.Get(), 0, subresources.data(), (UINT)subresources.size());
+
+				m_textures.push_back(std::move(tex));
+				continue;
+			}
 
-			m_textures.push_back(std::move(tex));
-		}
+			auto desc = CD3DX12_RESOURCE_DESC::Tex2D(ToDxgiFormat(src.format, src.srgb), src.width, src.height, 1, (UINT16)src.mipLevels);
+			tex->resource = m_gpuMemory->CreateResource(desc, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST);
 
-		// Create the skybox cubemap from the dds texture file.
-		{
-			auto tex = std::make_unique<Texture>();
-			tex->name = "sky_box";
-			ThrowIfFailed(CreateDDSTextureFromFile12(m_device.Get(), m_commandList.Get(), L"Assets/grasscube1024.dds",
-				tex->resource, tex->uploadHeap));
+			std::vector<D3D12_SUBRESOURCE_DATA> subresources(src.mipLevels);
+			for (uint32_t level = 0; level < src.mipLevels; level++)
+			{
+				ImageMipLayout layout = GetImageMipLayout(src.width, src.height, src.format, level);
+				subresources[level].pData = src.pixels + layout.offset;
+				subresources[level].RowPitch = (LONG_PTR)layout.rowPitch;
+				subresources[level].SlicePitch = (LONG_PTR)layout.slicePitch;
+			}
+			uploadBatch.Upload(tex->resource.Get(), 0, subresources.data(), src.mipLevels);
 
 			m_textures.push_back(std::move(tex));
 		}
-	}
 
-	void Renderer::_createDescriptorHeaps()
-	{
-		D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-		srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-		srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-		srvHeapDesc.NumDescriptors = 30;
-		ThrowIfFailed(m_device->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&m_srvHeap)));
-
-		CD3DX12_CPU_DESCRIPTOR_HANDLE srvDescHandle(m_srvHeap->GetCPUDescriptorHandleForHeapStart());
+		_placeTexture(sky.get());
+		uploadBatch.Upload(sky->resource.Get(), 0, skySubresources.data(), (UINT)skySubresources.size());
+		m_textures.push_back(std::move(sky));
 
+		// Resources used on a copy queue decay to COMMON once it finishes, the first draw sampling them
+		// promotes them to PIXEL_SHADER_RESOURCE implicitly, so no barriers are recorded.
+		m_textureUpload = uploadBatch.End(m_copyQueue.Get());
+		m_textureLoadTimings.uploadRecordMs = MillisecondsSince(recordStart);
+	}
 
-		std::vector<ComPtr<ID3D12Resource>> tex2DList;
-		for (size_t i = 0; i < m_textures.size() - 1; i++)
+	bool Renderer::_decodeWICTexture(const std::string& path, DecodedImage& image)
+	{
+		// Forced to RGBA8 so the pixels fit DecodedImage. The pipeline fits the size, the committed
+		// resource the loader creates alongside is dropped.
+		ComPtr<ID3D12Resource> resource;
+		std::unique_ptr<uint8_t[]> decodedData;
+		D3D12_SUBRESOURCE_DATA subresource = {};
+		if (FAILED(LoadWICTextureFromFileEx(m_device.Get(), std::filesystem::path(path).wstring().c_str(), 0,
+			D3D12_RESOURCE_FLAG_NONE, WIC_LOADER_FORCE_RGBA32, resource.GetAddressOf(), decodedData, subresource)))
 		{
-			tex2DList.push_back(m_textures[i]->resource);
+			return false;
 		}
 
+		D3D12_RESOURCE_DESC desc = resource->GetDesc();
+		image.width = (uint32_t)desc.Width;
+		image.height = desc.Height;
+		image.format = ImageFormat::RGBA8;
+		image.srgb = desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
 
-		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-		srvDesc.Texture2D.MostDetailedMip = 0;
-		srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-
-		for (size_t i = 0; i < tex2DList.size(); i++)
+		const uint64_t rowPitch = image.GetRowPitch();
+		image.pixels.resize(rowPitch * image.height);
+		for (uint32_t y = 0; y < image.height; y++)
 		{
-			srvDesc.Format = tex2DList[i]->GetDesc().Format;
-			srvDesc.Texture2D.MipLevels = tex2DList[i]->GetDesc().MipLevels;
-			m_device->CreateShaderResourceView(tex2DList[i].Get(), &srvDesc, srvDescHandle);
-
-			srvDescHandle.Offset(1, m_cbvSrvUavDescriptorSize);
+			memcpy(image.pixels.data() + y * rowPitch, (const uint8_t*)subresource.pData + y * subresource.RowPitch, rowPitch);
 		}
 
-		// Create srv for sky box.
-		m_skyTexHeapIndex = tex2DList.size();
-		auto skyCubeMap = m_textures[m_skyTexHeapIndex]->resource;
-		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
-		srvDesc.TextureCube.MipLevels = skyCubeMap->GetDesc().MipLevels;
-		srvDesc.Format = skyCubeMap->GetDesc().Format;
-		srvDesc.TextureCube.MostDetailedMip = 0;
-		srvDesc.TextureCube.ResourceMinLODClamp = 0.0f;
-		m_device->CreateShaderResourceView(skyCubeMap.Get(), &srvDesc, srvDescHandle);
+		return true;
+	}
 
-		m_shadowMapHeapIndex = m_skyTexHeapIndex + 1;
-		m_ssaoHeapIndexStart = m_shadowMapHeapIndex + 1;
-		m_ssaoAmbientMapIndex = m_ssaoHeapIndexStart + 3;
-		int nullCubeSrvIndex = m_ssaoHeapIndexStart + 5;
-		int nullTexSrvIndex1 = nullCubeSrvIndex + 1;
-		int nullTexSrvIndex2 = nullTexSrvIndex1 + 1;
+	void Renderer::_placeTexture(Texture* tex)
+	{
+		// The texture loaders create committed resources. Nothing is recorded for them yet,
+		// so swap in a placed resource with the same description before the upload.
+		D3D12_RESOURCE_DESC desc = tex->resource->GetDesc();
+		tex->resource = m_gpuMemory->CreateResource(desc, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST);
+	}
 
-		auto nullSrv = _getCpuSrv(nullCubeSrvIndex);
-		m_nullSrv = _getGpuSrv(nullCubeSrvIndex);
+	void Renderer::_createDescriptorHeaps()
+	{
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
 
-		m_device->CreateShaderResourceView(nullptr, &srvDesc, nullSrv);
-		nullSrv.Offset(1, m_cbvSrvUavDescriptorSize);
+		for (auto& tex : m_textures)
+		{
+			auto texDesc = tex->resource->GetDesc();
+			srvDesc.Format = texDesc.Format;
+			srvDesc.ViewDimension = tex->viewDimension;
 
-		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-		srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		srvDesc.Texture2D.MostDetailedMip = 0;
-		srvDesc.Texture2D.MipLevels = 1;
-		srvDesc.Texture1D.ResourceMinLODClamp = 0.0f;
+			if (tex->viewDimension == D3D12_SRV_DIMENSION_TEXTURECUBE)
+			{
+				srvDesc.TextureCube.MostDetailedMip = 0;
+				srvDesc.TextureCube.MipLevels = texDesc.MipLevels;
+				srvDesc.TextureCube.ResourceMinLODClamp = 0.0f;
+			}
+			else
+			{
+				srvDesc.Texture2D.MostDetailedMip = 0;
+				srvDesc.Texture2D.MipLevels = texDesc.MipLevels;
+				srvDesc.Texture2D.PlaneSlice = 0;
+				srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+			}
 
-		// Create null srv for shadow map.
-		m_device->CreateShaderResourceView(nullptr, &srvDesc, nullSrv);
+			tex->srvIndex = m_bindlessHeap->CreateSrv(tex->resource.Get(), &srvDesc);
+		}
 
-		nullSrv.Offset(1, m_cbvSrvUavDescriptorSize);
-		m_device->CreateShaderResourceView(nullptr, &srvDesc, nullSrv);
+		m_skyCubeSrvIndex = _getTextureSrvIndex("sky_box");
 
-		m_shadowMap->BuildDescriptors(_getCpuSrv(m_shadowMapHeapIndex),
-			_getGpuSrv(m_shadowMapHeapIndex), _getDsv(1));
+		m_shadowMapSrvIndex = m_bindlessHeap->Allocate();
+		m_shadowMap->BuildDescriptors(CD3DX12_CPU_DESCRIPTOR_HANDLE(m_bindlessHeap->GetCpuHandle(m_shadowMapSrvIndex)),
+			CD3DX12_GPU_DESCRIPTOR_HANDLE(m_bindlessHeap->GetGpuHandle(m_shadowMapSrvIndex)), _getDsv(1), m_dsvDescriptorSize);
 
-		m_featureSSAO->BuildDescriptors(m_depthStencilBuffer.Get(),
-			_getCpuSrv(m_ssaoHeapIndexStart), _getGpuSrv(m_ssaoHeapIndexStart),
-			_getRtv(Renderer::FrameBufferCount), m_cbvSrvUavDescriptorSize, m_rtvDescriptorSize);
+		m_featureSSAO->BuildDescriptors(m_depthStencilBuffer.Get(), m_bindlessHeap.get(),
+			_getRtv(Renderer::FrameBufferCount), m_rtvDescriptorSize);
 	}
 
 	void Renderer::_createFrameResources()
 	{
+		// Every shadow cascade, normal-depth and opaque are recorded in parallel, each needs
+		// a list per thread and one to continue the frame on.
+		unsigned int recordingListCount = (ShadowCascades::MAX_CASCADES + 2) * (m_jobSystem->GetThreadCount() + 1);
+
 		for (size_t i = 0; i < FRAME_RESOURCE_COUNT; i++)
 		{
 			m_frameResources.push_back(
-				std::make_unique<FrameResource>(m_device.Get(), 2, 
-					m_renderableList.size(), m_instanceCount, m_materials.size()));
+				std::make_unique<FrameResource>(m_device.Get(), 1 + ShadowCascades::MAX_CASCADES, 
+					m_instanceCount, (unsigned int)m_renderableList.size(), m_materials.size(), recordingListCount, m_gpuMemory.get()));
+		}
+
+		_createRecordingCommandLists();
+	}
+
+	void Renderer::_createRecordingCommandLists()
+	{
+		auto& cmdAllocs = m_frameResources[0]->recordingCmdAllocs;
+
+		m_recordingCommandLists.resize(cmdAllocs.size());
+		for (size_t i = 0; i < cmdAllocs.size(); i++)
+		{
+			ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+				cmdAllocs[i].Get(), nullptr, IID_PPV_ARGS(&m_recordingCommandLists[i])));
+
+			// It needs to be closed before resetting it.
+			m_recordingCommandLists[i]->Close();
 		}
 	}
 
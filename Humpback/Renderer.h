@@ -6,6 +6,7 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <functional>
 
 #include "Camera.h"
 #include "Mesh.h"
@@ -14,11 +15,28 @@
 #include "UploadBufferHelper.h"
 #include "HMathHelper.h"
 #include "RenderableObject.h"
+#include "RenderableStore.h"
+#include "UploadTracker.h"
 #include "Texture.h"
 #include "ShadowMap.h"
+#include "ShadowCascades.h"
 #include "Light.h"
 #include "SSAO.h"
 #include "HMeshImporter.h"
+#include "RenderGraph.h"
+#include "D3D12RenderGraphBackend.h"
+#include "JobSystem.h"
+#include "FrustumCuller.h"
+#include "SceneBvh.h"
+#include "OcclusionCuller.h"
+#include "ClusterCuller.h"
+#include "DrawQueue.h"
+#include "UploadAllocator.h"
+#include "GpuMemoryAllocator.h"
+#include "BindlessDescriptorHeap.h"
+#include "AssetCache.h"
+#include "TextureLoadPipeline.h"
+#include "TransformHierarchy.h"
 
 
 using Microsoft::WRL::ComPtr;
@@ -45,6 +63,9 @@ namespace Humpback
 		~Renderer();
 
 		static const unsigned int FrameBufferCount = 2;
+
+		// Layers shorter than this are recorded on the calling thread.
+		static const unsigned int MinDrawsPerRecordingJob = 256;
 		
 		static std::string_view SHADER_MODEL_VERTEX;
 		static std::string_view SHADER_MODEL_FRAGMENT;
@@ -60,11 +81,39 @@ namespace Humpback
 		void OnMouseMove(WPARAM btnState, int x, int y);
 		void OnMouseWheel(short delta);
 
+		const CullingStats& GetCameraCullingStats() const { return m_cameraCullingStats; }
+		const CullingStats& GetShadowCullingStats() const { return m_shadowCullingStats; }
+		const ClusterCullingStats& GetClusterCullingStats() const { return m_clusterCullingStats; }
+		const OcclusionCullingStats& GetCameraOcclusionStats() const { return m_cameraOcclusion->GetStats(); }
+		const OcclusionCullingStats& GetShadowOcclusionStats(unsigned int cascade) const { return m_shadowOcclusion[cascade]->GetStats(); }
+		const DrawSubmissionStats& GetDrawStats() const { return m_drawStats; }
+		AssetCacheStats GetAssetCacheStats() const { return m_assetCache->GetStats(); }
+		const TextureLoadTimings& GetTextureLoadTimings() const { return m_textureLoadTimings; }
+
+		// The main pass tests against the normal-depth pass depth instead of rendering its own.
+		void SetDepthPrepassReuse(bool enable) { m_enableDepthPrepassReuse = enable; }
+		bool IsDepthPrepassReuseEnabled() const { return m_enableDepthPrepassReuse; }
+
+		// Splits the single-instance opaque draws into the index ranges of their visible meshlets.
+		void SetClusterCulling(bool enable) { m_enableClusterCulling = enable; }
+		bool IsClusterCullingEnabled() const { return m_enableClusterCulling; }
+
+		// Drops opaque objects and shadow casters hidden behind the occluders, tested on the CPU.
+		void SetOcclusionCulling(bool enable) { m_enableOcclusionCulling = enable; }
+		bool IsOcclusionCullingEnabled() const { return m_enableOcclusionCulling; }
+
+		// The shadow map array always holds ShadowCascades::MAX_CASCADES slices, fewer cascades leave some unused.
+		void SetShadowCascadeCount(unsigned int count) { m_shadowCascades.SetCascadeCount(count); }
+		void SetShadowSplitLambda(float lambda) { m_shadowCascades.SetSplitLambda(lambda); }
+		void SetShadowDistance(float distance) { m_shadowCascades.SetShadowDistance(distance); }
+		const ShadowCascades& GetShadowCascades() const { return m_shadowCascades; }
+
 	private:
 
 		void _initD3D12();
 		void _initRendererFeatures();
 		void _initTimer();
+		void _initJobSystem();
 		void _initCamera();
 		void _createCommandObjects();
 		void _createSwapChain(IDXGIFactory4*);
@@ -77,6 +126,10 @@ namespace Humpback
 		void _createSimpleGeometry();
 		void _loadGeometryFromFile();
 		void _loadGeometryFromFileASSIMP();
+		void _uploadVertices(Mesh& mesh, const std::vector<Vertex>& vertices);
+		void _buildMeshlets(Mesh& mesh, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+		// Picks 16 bit indices when they hold the mesh, after _buildMeshlets so batches can follow the meshlets.
+		void _uploadIndices(Mesh& mesh, const std::vector<uint32_t>& indices);
 		void _createSceneLights();
 
 		void _createRootSignature();
@@ -86,36 +139,62 @@ namespace Humpback
 		void _createPixelShader(const std::wstring& fullPath, const std::string& shaderName);
 		void _createPso();
 		void _createFrameResources();
+		void _createRecordingCommandLists();
 		void _createAllRenderableObjects();
-		void _createRenderableObject(const std::string& matName, Mesh* pMesh, const std::string& drawArgs, RenderLayer layer, DirectX::XMMATRIX scaleTranslate);
+		void _createInstancingStressScene();
+		// The object gets a node of its own below parentNode, localTransform places it relative to the parent.
+		RenderableObject* _createRenderableObject(const std::string& matName, Mesh* pMesh, const std::string& drawArgs, RenderLayer layer,
+			DirectX::XMMATRIX localTransform, uint32_t parentNode = TransformHierarchy::NO_PARENT);
 		void _createAllMaterials();
-		void _createMaterial(const std::string& matName, int diffuseSrvIdx, int normalSrvIdx, int metallicSmoothnessSrvIdx, DirectX::XMFLOAT4& diffuseTint);
+		void _createMaterial(const std::string& matName, const std::string& diffuseTex, const std::string& normalTex,
+			const std::string& metallicSmoothnessTex, DirectX::XMFLOAT4& diffuseTint);
+		uint32_t _getTextureSrvIndex(const std::string& texName) const;
 		
 		void _loadTextures();
+		void _placeTexture(Texture* tex);
+		bool _decodeWICTexture(const std::string& path, DecodedImage& image);
 		void _createDescriptorHeaps();
 		void _updateTheViewport();
-		CD3DX12_CPU_DESCRIPTOR_HANDLE _getCpuSrv(int idx) const;
-		CD3DX12_GPU_DESCRIPTOR_HANDLE _getGpuSrv(int idx) const;
 		CD3DX12_CPU_DESCRIPTOR_HANDLE _getDsv(int idx) const;
 		CD3DX12_CPU_DESCRIPTOR_HANDLE _getRtv(int idx) const;
 
-		void _bindMaterialBuffer();
+		void _bindMaterialBuffer(ID3D12GraphicsCommandList* cmdList);
+		void _bindCommonState(ID3D12GraphicsCommandList* cmdList);
+
+		void _buildRenderGraph();
+		void _bindRenderGraphResources();
+
+		using PassStateFunc = std::function<void(ID3D12GraphicsCommandList*)>;
 
 		void _render();			// Render per frame.
-		void _renderRenderableObjects(ID3D12GraphicsCommandList*, const std::vector<RenderableObject*>&);
+		DrawSubmissionStats _renderRenderableObjects(ID3D12GraphicsCommandList*, const std::vector<InstanceGroup>&,
+			size_t begin, size_t end, bool positionOnly = false);
+		void _recordRenderLayer(const std::vector<InstanceGroup>&, const PassStateFunc& bindPassState, bool positionOnly = false);
+		ID3D12GraphicsCommandList* _resetRecordingCommandList(unsigned int index);
 		void _renderShadowMap();
 		void _renderNormalDepth();
 		void _renderAO();
+		void _renderMainPass();
 
 		void _update();			// Update per frame.
 		void _updateCamera();
+		void _updateTransforms();
 		void _updateCBuffers();
-		void _updateCBufferPerObject();
+		void _updateObjectBuffer();
+		void _updateInstanceBuffer();
+		void _buildInstanceGroups(const std::vector<RenderableObject*>& objList, unsigned int pass, RenderLayer layer,
+			bool sortByDepth, std::vector<InstanceGroup>& groups, unsigned int& instanceOffset);
+		void _cullClusters(std::vector<InstanceGroup>& groups);
 		void _updateCBufferPerPass();
 		void _updateShadowCB();
 		void _updateSsaoCB();
 		void _updateMatCBuffer();
+		void _updateSceneBvhs();
 		void _updateShadowMap();
+		void _updateCulling();
+		void _cullRenderLayer(RenderLayer layer, const FrustumPlanes& frustum,
+			std::vector<RenderableObject*>& visible, CullingStats& stats);
+		void _cullOccluded(OcclusionCuller& culler, DirectX::FXMMATRIX viewProj, std::vector<RenderableObject*>& visible);
 		void _onKeyboardInput();
 
 
@@ -124,13 +203,19 @@ namespace Humpback
 		ID3D12Resource* _getCurrentBackbuffer();
 
 		std::unique_ptr<Timer>				m_timer = nullptr;
+		std::unique_ptr<JobSystem>			m_jobSystem = nullptr;
 
 		ComPtr<ID3D12Device>				m_device = nullptr;
+		// Declared right after the device so it outlives every resource placed in its heaps.
+		std::unique_ptr<GpuMemoryAllocator>	m_gpuMemory = nullptr;
 		ComPtr<ID3D12CommandQueue>			m_commandQueue = nullptr;
+		// Texture uploads at load time, they overlap the rest of the initialization.
+		ComPtr<ID3D12CommandQueue>			m_copyQueue = nullptr;
 		ComPtr<IDXGISwapChain4>				m_swapChain = nullptr;
 		ComPtr<ID3D12DescriptorHeap>		m_rtvHeap = nullptr;
 		ComPtr<ID3D12DescriptorHeap>		m_dsvHeap = nullptr;
-		ComPtr<ID3D12DescriptorHeap>		m_srvHeap = nullptr;
+		// Every shader-visible SRV lives here, shaders index it through the unbounded texture arrays.
+		std::unique_ptr<BindlessDescriptorHeap>	m_bindlessHeap = nullptr;
 		ComPtr<ID3D12Resource>				m_frameBuffers[Renderer::FrameBufferCount];
 		ComPtr<ID3D12Resource>				m_depthStencilBuffer = nullptr;
 		ComPtr<ID3D12CommandAllocator>		m_commandAllocator = nullptr;
@@ -141,11 +226,21 @@ namespace Humpback
 		std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> m_psos;
 
 		ComPtr<ID3D12GraphicsCommandList>	m_commandList = nullptr;
+
+		// Lists recorded by the job system, their allocators live in the frame resources.
+		std::vector<ComPtr<ID3D12GraphicsCommandList>>	m_recordingCommandLists;
+		unsigned int						m_usedRecordingCommandLists = 0;
+
+		// The list currently receiving the serial commands of the frame, and
+		// all lists closed so far in submission order.
+		ID3D12GraphicsCommandList*			m_frameCommandList = nullptr;
+		std::vector<ID3D12CommandList*>		m_submitCommandLists;
 		ComPtr<ID3D12Resource>				m_vertexBuffer = nullptr;
 
 		std::unordered_map<std::string, ComPtr<ID3DBlob>> m_shaders;
 
 		std::vector<D3D12_INPUT_ELEMENT_DESC> m_inputLayout;
+		std::vector<D3D12_INPUT_ELEMENT_DESC> m_positionOnlyInputLayout;
 
 		std::vector<std::unique_ptr<FrameResource>>			m_frameResources;
 		FrameResource*						m_curFrameResource = nullptr;
@@ -171,7 +266,6 @@ namespace Humpback
 		CD3DX12_RECT						m_scissorRect;
 		unsigned int						m_rtvDescriptorSize = 0;
 		POINT								m_lastMousePoint = {0, 0};
-		unsigned int						m_cbvSrvUavDescriptorSize = 0;
 		unsigned int						m_dsvDescriptorSize = 0;
 		unsigned int						m_passCbvOffset = 0;
 		
@@ -181,42 +275,101 @@ namespace Humpback
 
 		std::unique_ptr<Camera>				m_mainCamera = nullptr;
 
+		// Staging memory for every mesh and texture upload, recycled by fence value.
+		std::unique_ptr<UploadAllocator>	m_uploadAllocator = nullptr;
+
+		// Imported meshes and decoded textures keyed by source content, warm starts skip ASSIMP and PNG decoding.
+		std::unique_ptr<AssetCache>			m_assetCache = nullptr;
+
+		// Signaled when the copy queue finished the texture batch.
+		std::future<void>					m_textureUpload;
+		TextureLoadTimings					m_textureLoadTimings;
+
 		std::unique_ptr<HMeshImporter>		m_modelLoader = nullptr;
 		std::unordered_map<std::string, std::unique_ptr<Mesh>>		m_meshes;
 		std::unordered_map<std::string, std::unique_ptr<Material>>	m_materials;
+		// Indexed by matCBIdx, the material buffer is rewritten from here for the indices m_materialUploads holds.
+		std::vector<Material*>										m_materialList;
+		std::unique_ptr<UploadTracker>								m_materialUploads = nullptr;
 		std::vector<std::unique_ptr<Texture>>	m_textures;
 		std::vector<std::unique_ptr<HMeshImporter>>					m_modelImporters;
 
+		// Indexed by the object id, m_renderables holds the state that changes per frame under the same id.
 		std::vector<std::unique_ptr<RenderableObject>>				m_renderableList;
+		std::unique_ptr<RenderableStore>							m_renderables = nullptr;
+		std::vector<UploadTracker::Run>								m_uploadRuns;
 		std::vector<RenderableObject*>								m_renderLayers[(int)RenderLayer::Count];
-		DirectX::BoundingSphere										m_sceneBoundingSphere;
+
+		// Places every object, moving a node moves everything below it on the next _updateTransforms.
+		TransformHierarchy											m_transforms;
+		// Indexed by node, null for nodes that only group others.
+		std::vector<RenderableObject*>								m_nodeObjects;
 
 		PassConstants												m_mainPassCB;
 		PassConstants												m_shadowPassCB;
 
 		unsigned int	m_instanceCount = 0;
 
-		bool			m_enableFrustumCulling = true;
+		// Per pass draw lists, rebuilt each frame from the visible objects.
+		std::vector<InstanceGroup>					m_layerGroups[(int)RenderLayer::Count];
+		std::vector<InstanceGroup>					m_cascadeCasterGroups[ShadowCascades::MAX_CASCADES];
 
-		int				m_skyTexHeapIndex = 0;
-		int				m_defaultNormalMapIndex = 0;
-		int				m_defaultBlackIndex = 0;
-		int				m_defaultWhiteIndex = 0;
+		DrawQueue									m_drawQueue;
+		DrawSubmissionStats							m_drawStats;
+		std::unordered_map<const Mesh*, unsigned int>	m_meshIds;
+		std::map<std::pair<const Mesh*, std::string>, unsigned int>	m_geometryIds;
+		std::unordered_map<const Mesh*, unsigned int>	m_meshGeometryCounts;
 
-		int				m_shadowMapHeapIndex = 0;
-		int				m_ssaoHeapIndexStart = 0;
-		int				m_ssaoAmbientMapIndex = 0;
-		CD3DX12_GPU_DESCRIPTOR_HANDLE	m_nullSrv;
+		// Adds a grid of identical boxes to exercise the instancing path.
+		bool			m_createInstancingStressScene = false;
 
-		XMFLOAT4X4		m_lightViewMatrix;
-		XMFLOAT4X4		m_lightProjMatrix;
-		XMFLOAT4X4		m_shadowVPTMatrix;
+		// Meshes are uploaded as PackedVertex and the vertex shaders compiled to decode it.
+		// Fixed for the lifetime of the renderer, every mesh and PSO uses the same layout.
+		bool			m_packedVertices = true;
 
+		bool			m_enableFrustumCulling = true;
+		bool			m_enableDepthPrepassReuse = true;
+		bool			m_depthPrepassKeyDown = false;
+		bool			m_enableClusterCulling = true;
+		bool			m_clusterCullingKeyDown = false;
+		bool			m_enableOcclusionCulling = true;
+		bool			m_occlusionCullingKeyDown = false;
+
+		// One culler per layer, box i belongs to m_renderLayers[layer][i].
+		std::unique_ptr<SceneBvh>					m_layerBvhs[(int)RenderLayer::Count];
+		std::vector<RenderableObject*>				m_visibleLayers[(int)RenderLayer::Count];
+		std::vector<RenderableObject*>				m_visibleCascadeCasters[ShadowCascades::MAX_CASCADES];
+		std::vector<unsigned int>					m_visibleIndices;
+		CullingStats								m_cameraCullingStats;
+		CullingStats								m_shadowCullingStats;	// Summed over the cascades.
+
+		// Low resolution depth of the occluders seen from the camera and from the light.
+		std::unique_ptr<OcclusionCuller>			m_cameraOcclusion;
+		std::unique_ptr<OcclusionCuller>			m_shadowOcclusion[ShadowCascades::MAX_CASCADES];
+
+		// Index ranges of the cluster culled groups of the frame, referenced by InstanceGroup::firstRange.
+		std::vector<IndexRange>						m_clusterRanges;
+		ClusterCullingStats							m_clusterCullingStats;
+
+		uint32_t		m_skyCubeSrvIndex = DescriptorIndexAllocator::INVALID_INDEX;
+		uint32_t		m_shadowMapSrvIndex = DescriptorIndexAllocator::INVALID_INDEX;
+
+		// Cascades of the main light, fitted to the camera every frame. One shadow map slice per cascade.
+		ShadowCascades				m_shadowCascades{ 2048 };
 		std::unique_ptr<ShadowMap>	m_shadowMap = nullptr;
-		DirectX::XMFLOAT3					m_mainLightPos = { 0.0f, 0.0f, 0.0f };
 
 		std::unique_ptr<DirectionalLight[]> m_directionalLights = nullptr;
 
 		std::unique_ptr<SSAO> m_featureSSAO;
+
+		std::unique_ptr<RenderGraph>				m_renderGraph = nullptr;
+		std::unique_ptr<D3D12RenderGraphBackend>	m_renderGraphBackend = nullptr;
+
+		RGResourceHandle	m_rgShadowMap = RG_INVALID_HANDLE;
+		RGResourceHandle	m_rgNormalDepth = RG_INVALID_HANDLE;
+		RGResourceHandle	m_rgDepthStencil = RG_INVALID_HANDLE;
+		RGResourceHandle	m_rgAmbientMap = RG_INVALID_HANDLE;
+		RGResourceHandle	m_rgAmbientBlur = RG_INVALID_HANDLE;
+		RGResourceHandle	m_rgBackBuffer = RG_INVALID_HANDLE;
 	};
 }
\ No newline at end of file
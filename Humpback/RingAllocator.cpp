@@ -0,0 +1,87 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include "RingAllocator.h"
+
+
+namespace Humpback
+{
+	RingAllocator::RingAllocator(uint64_t size) :
+		m_size(size)
+	{
+	}
+
+	uint64_t RingAllocator::Allocate(uint64_t size, uint64_t alignment)
+	{
+		if (size == 0 || size > m_size || IsFull())
+		{
+			return INVALID_OFFSET;
+		}
+
+		const uint64_t alignedHead = (m_head + alignment - 1) & ~(alignment - 1);
+
+		// Used space is [tail, head), free space is [head, size) plus [0, tail).
+		if (m_head >= m_tail)
+		{
+			if (alignedHead + size <= m_size)
+			{
+				uint64_t consumed = alignedHead - m_head + size;
+				m_head = alignedHead + size;
+				m_usedSize += consumed;
+				m_pendingSize += consumed;
+				return alignedHead;
+			}
+
+			// Skip the rest of the buffer and start again from zero, the skipped bytes are
+			// owned by this submission so they come back when it retires.
+			if (size <= m_tail)
+			{
+				uint64_t consumed = m_size - m_head + size;
+				m_head = size;
+				m_usedSize += consumed;
+				m_pendingSize += consumed;
+				return 0;
+			}
+		}
+		// Used space wraps around, free space is [head, tail).
+		else if (alignedHead + size <= m_tail)
+		{
+			uint64_t consumed = alignedHead - m_head + size;
+			m_head = alignedHead + size;
+			m_usedSize += consumed;
+			m_pendingSize += consumed;
+			return alignedHead;
+		}
+
+		return INVALID_OFFSET;
+	}
+
+	void RingAllocator::FinishSubmission(uint64_t fenceValue)
+	{
+		if (m_pendingSize == 0)
+		{
+			return;
+		}
+
+		m_submissions.push_back({ fenceValue, m_head, m_pendingSize });
+		m_pendingSize = 0;
+	}
+
+	void RingAllocator::ReleaseCompleted(uint64_t completedFenceValue)
+	{
+		while (!m_submissions.empty() && m_submissions.front().fenceValue <= completedFenceValue)
+		{
+			m_tail = m_submissions.front().tail;
+			m_usedSize -= m_submissions.front().size;
+			m_submissions.pop_front();
+		}
+
+		// Nothing in flight, start from the beginning to get the longest contiguous range.
+		if (m_usedSize == 0)
+		{
+			m_head = 0;
+			m_tail = 0;
+		}
+	}
+}
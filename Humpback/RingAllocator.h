@@ -0,0 +1,62 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <deque>
+#include <cstdint>
+
+
+namespace Humpback
+{
+	// Offset bookkeeping for a circular buffer whose space is returned in submission order.
+	// Allocations made between two FinishSubmission calls belong to that submission and are
+	// released together once the GPU fence passed to FinishSubmission has completed.
+	// No graphics API types, the D3D12 side lives in UploadAllocator.
+	class RingAllocator
+	{
+	public:
+
+		static const uint64_t INVALID_OFFSET = UINT64_MAX;
+
+		explicit RingAllocator(uint64_t size);
+
+		RingAllocator(const RingAllocator&) = delete;
+		RingAllocator& operator=(const RingAllocator&) = delete;
+
+		// Returns the offset of the block or INVALID_OFFSET when the ring has no room for it.
+		// alignment must be a power of two.
+		uint64_t Allocate(uint64_t size, uint64_t alignment);
+
+		// Tags everything allocated since the previous call with the fence value of the submission.
+		void FinishSubmission(uint64_t fenceValue);
+
+		// Frees the blocks of all submissions whose fence value is <= completedFenceValue.
+		void ReleaseCompleted(uint64_t completedFenceValue);
+
+		uint64_t GetSize() const { return m_size; }
+		uint64_t GetUsedSize() const { return m_usedSize; }
+		bool IsEmpty() const { return m_usedSize == 0; }
+		bool IsFull() const { return m_usedSize == m_size; }
+
+	private:
+
+		struct Submission
+		{
+			uint64_t fenceValue;
+			// Head position when the submission was closed, the new tail once it retires.
+			uint64_t tail;
+			// Bytes held by the submission, including alignment padding and wrap waste.
+			uint64_t size;
+		};
+
+		std::deque<Submission> m_submissions;
+
+		uint64_t m_size = 0;
+		uint64_t m_head = 0;
+		uint64_t m_tail = 0;
+		uint64_t m_usedSize = 0;
+		uint64_t m_pendingSize = 0;
+	};
+}
@@ -13,14 +13,16 @@ using namespace DirectX::PackedVector;
 
 namespace Humpback
 {
-	SSAO::SSAO(UINT width, UINT height, ID3D12Device* pDevice, ID3D12GraphicsCommandList* cmdList)
+	SSAO::SSAO(UINT width, UINT height, ID3D12Device* pDevice, ID3D12GraphicsCommandList* cmdList,
+		UploadAllocator* pUploadAllocator, GpuMemoryAllocator* pGpuMemory)
 	{
 		m_device = pDevice;
+		m_gpuMemory = pGpuMemory;
 
 		_onResize(width, height);
 
 		_buildOffsetVectors();
-		_buildRandomVectorTex(cmdList);
+		_buildRandomVectorTex(cmdList, pUploadAllocator);
 	}
 
 	void SSAO::SetPSOs(ID3D12PipelineState* ssaoPSO, ID3D12PipelineState* blurPSO)
@@ -44,7 +46,7 @@ namespace Humpback
 		cmdList->RSSetViewports(1, &m_viewPort);
 		cmdList->RSSetScissorRects(1, &m_scissorRect);
 
-		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_SSAOTexture0.Get(),
+		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_SSAOTexture0,
 			D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_RENDER_TARGET));
 
 		cmdList->OMSetRenderTargets(1, &m_SSAOTex0CPURtv, true, nullptr);
@@ -54,10 +56,8 @@ namespace Humpback
 
 		auto cBufferAddress = curFrame->ssaoCBuffer->Resource()->GetGPUVirtualAddress();
 		cmdList->SetGraphicsRootConstantBufferView(0, cBufferAddress);
-		cmdList->SetGraphicsRoot32BitConstant(1, 0, 0);
-
-		cmdList->SetGraphicsRootDescriptorTable(2, m_normalGPUSrv);
-		cmdList->SetGraphicsRootDescriptorTable(3, m_randomVectorGPUSrv);
+		_setRootConstants(cmdList, false, m_randomVectorSrvIndex);
+		cmdList->SetGraphicsRootDescriptorTable(2, m_bindlessHeap->GetGpuHandle(0));
 
 		cmdList->SetPipelineState(m_SSAOPipelineState);
 
@@ -66,7 +66,7 @@ namespace Humpback
 		cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 		cmdList->DrawInstanced(6, 1, 0, 0);
 
-		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_SSAOTexture0.Get(),
+		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_SSAOTexture0,
 			D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_GENERIC_READ));
 
 		_doBlur(cmdList, blurCount, curFrame);
@@ -80,28 +80,28 @@ namespace Humpback
 		srvDesc.Format = NORMAL_DEPTH_FORMAT;
 		srvDesc.Texture2D.MostDetailedMip = 0;
 		srvDesc.Texture2D.MipLevels = 1;
-		m_device->CreateShaderResourceView(m_normalTexture.Get(), &srvDesc, m_normalCpuSrv);
+		m_bindlessHeap->UpdateSrv(m_normalSrvIndex, m_normalTexture, &srvDesc);
 
 		srvDesc.Format = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
-		m_device->CreateShaderResourceView(depthStencilBuffer, &srvDesc, m_depthTexCpuSrv);
+		m_bindlessHeap->UpdateSrv(m_depthTexSrvIndex, depthStencilBuffer, &srvDesc);
 
 		srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		m_device->CreateShaderResourceView(m_randomVectorTex.Get(), &srvDesc, m_randomVectorCpuSrv);
+		m_bindlessHeap->UpdateSrv(m_randomVectorSrvIndex, m_randomVectorTex.Get(), &srvDesc);
 
 		srvDesc.Format = AMBIENT_FORMAT;
-		m_device->CreateShaderResourceView(m_SSAOTexture0.Get(), &srvDesc, m_SSAOTex0CPUSrv);
-		m_device->CreateShaderResourceView(m_SSAOTexture1.Get(), &srvDesc, m_SSAOTex1CPUSrv);
+		m_bindlessHeap->UpdateSrv(m_SSAOTex0SrvIndex, m_SSAOTexture0, &srvDesc);
+		m_bindlessHeap->UpdateSrv(m_SSAOTex1SrvIndex, m_SSAOTexture1, &srvDesc);
 
 		D3D12_RENDER_TARGET_VIEW_DESC rtvDesc = {};
 		rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
 		rtvDesc.Format = NORMAL_DEPTH_FORMAT;
 		rtvDesc.Texture2D.MipSlice = 0;
 		rtvDesc.Texture2D.PlaneSlice = 0;
-		m_device->CreateRenderTargetView(m_normalTexture.Get(), &rtvDesc, m_normalCpuRtv);
+		m_device->CreateRenderTargetView(m_normalTexture, &rtvDesc, m_normalCpuRtv);
 
 		rtvDesc.Format = AMBIENT_FORMAT;
-		m_device->CreateRenderTargetView(m_SSAOTexture0.Get(), &rtvDesc, m_SSAOTex0CPURtv);
-		m_device->CreateRenderTargetView(m_SSAOTexture1.Get(), &rtvDesc, m_SSAOTex1CPURtv);
+		m_device->CreateRenderTargetView(m_SSAOTexture0, &rtvDesc, m_SSAOTex0CPURtv);
+		m_device->CreateRenderTargetView(m_SSAOTexture1, &rtvDesc, m_SSAOTex1CPURtv);
 	}
 
 	void SSAO::GetOffsetVectors(DirectX::XMFLOAT4 offsets[])
@@ -144,14 +144,15 @@ namespace Humpback
 		return m_height;
 	}
 
-	ID3D12Resource* SSAO::GetNormalResource()
+	CD3DX12_CPU_DESCRIPTOR_HANDLE SSAO::GetNormalRTV()
 	{
-		return m_normalTexture.Get();
+		return m_normalCpuRtv;
 	}
 
-	CD3DX12_CPU_DESCRIPTOR_HANDLE SSAO::GetNormalRTV()
+	uint32_t SSAO::GetAmbientSrvIndex() const
 	{
-		return m_normalCpuRtv;
+		// The last blur pass is vertical and writes back into the first texture.
+		return m_SSAOTex0SrvIndex;
 	}
 
 	void SSAO::_doBlur(ID3D12GraphicsCommandList* cmdList, int blurCount, FrameResource* frameRes)
@@ -186,17 +187,10 @@ namespace Humpback
 		m_viewPort.MaxDepth = 1.0f;
 
 		m_scissorRect = { 0, 0, (int)m_width / 2, (int)m_height / 2 };
-
-		_buildResources();
 	}
 
-	void SSAO::_buildResources()
+	D3D12_RESOURCE_DESC SSAO::GetNormalDepthDesc(D3D12_CLEAR_VALUE* pClearValue) const
 	{
-		m_normalTexture = nullptr;
-		m_SSAOTexture0 = nullptr;
-		m_SSAOTexture1 = nullptr;
-
-		// Normal depth texture.
 		D3D12_RESOURCE_DESC texDesc;
 		ZeroMemory(&texDesc, sizeof(D3D12_RESOURCE_DESC));
 		texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
@@ -211,27 +205,40 @@ namespace Humpback
 		texDesc.SampleDesc.Count = 1;
 		texDesc.SampleDesc.Quality = 0;
 
-		float normalDepthClearVal[] = { 0.0f, 0.0f, 1.0f, 0.0f };
-		CD3DX12_CLEAR_VALUE optClear(NORMAL_DEPTH_FORMAT, normalDepthClearVal);
-		ThrowIfFailed(m_device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-			D3D12_HEAP_FLAG_NONE, &texDesc, D3D12_RESOURCE_STATE_GENERIC_READ, &optClear,
-			IID_PPV_ARGS(&m_normalTexture)));
+		if (pClearValue != nullptr)
+		{
+			float normalDepthClearVal[] = { 0.0f, 0.0f, 1.0f, 0.0f };
+			*pClearValue = CD3DX12_CLEAR_VALUE(NORMAL_DEPTH_FORMAT, normalDepthClearVal);
+		}
+
+		return texDesc;
+	}
 
-		// AO texture.
+	D3D12_RESOURCE_DESC SSAO::GetAmbientDesc(D3D12_CLEAR_VALUE* pClearValue) const
+	{
+		// The AO is computed at half resolution.
+		D3D12_RESOURCE_DESC texDesc = GetNormalDepthDesc(nullptr);
 		texDesc.Width = m_width / 2;
 		texDesc.Height = m_height / 2;
 		texDesc.Format = AMBIENT_FORMAT;
 
-		float ambientClearVal[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-		optClear = CD3DX12_CLEAR_VALUE(AMBIENT_FORMAT, ambientClearVal);
-		
-		ThrowIfFailed(m_device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-			D3D12_HEAP_FLAG_NONE, &texDesc, D3D12_RESOURCE_STATE_GENERIC_READ, &optClear,
-			IID_PPV_ARGS(&m_SSAOTexture0)));
+		if (pClearValue != nullptr)
+		{
+			float ambientClearVal[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			*pClearValue = CD3DX12_CLEAR_VALUE(AMBIENT_FORMAT, ambientClearVal);
+		}
+
+		return texDesc;
+	}
+
+	void SSAO::SetResources(ID3D12Resource* normalDepth, ID3D12Resource* ambient, ID3D12Resource* ambientBlur,
+		ID3D12Resource* depthStencilBuffer)
+	{
+		m_normalTexture = normalDepth;
+		m_SSAOTexture0 = ambient;
+		m_SSAOTexture1 = ambientBlur;
 
-		ThrowIfFailed(m_device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-			D3D12_HEAP_FLAG_NONE, &texDesc, D3D12_RESOURCE_STATE_GENERIC_READ, &optClear,
-			IID_PPV_ARGS(&m_SSAOTexture1)));
+		RebuildDescriptors(depthStencilBuffer);
 	}
 
 	void SSAO::_buildOffsetVectors()
@@ -270,7 +277,7 @@ namespace Humpback
 		}
 	}
 
-	void SSAO::_buildRandomVectorTex(ID3D12GraphicsCommandList* cmdList)
+	void SSAO::_buildRandomVectorTex(ID3D12GraphicsCommandList* cmdList, UploadAllocator* pUploadAllocator)
 	{
 		D3D12_RESOURCE_DESC texDesc;
 		ZeroMemory(&texDesc, sizeof(D3D12_RESOURCE_DESC));
@@ -286,26 +293,8 @@ namespace Humpback
 		texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
 		texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-		ThrowIfFailed(m_device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-			D3D12_HEAP_FLAG_NONE,
-			&texDesc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&m_randomVectorTex)
-		));
-
-
-		UINT64 uploadBufferSize = GetRequiredIntermediateSize(m_randomVectorTex.Get(), 0, 1);
-
-		ThrowIfFailed(m_device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&m_randomVectorTexUpload)
-		));
+		m_randomVectorTex = m_gpuMemory->CreateResource(texDesc, D3D12_HEAP_TYPE_DEFAULT,
+			D3D12_RESOURCE_STATE_GENERIC_READ);
 
 		XMCOLOR texData[256 * 256];
 		for (size_t i = 0; i < 256; i++)
@@ -326,57 +315,51 @@ namespace Humpback
 			m_randomVectorTex.Get(),
 			D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST));
 
-		UpdateSubresources(cmdList, m_randomVectorTex.Get(), 
-			m_randomVectorTexUpload.Get(), 0, 0, 1, &resData);
+		pUploadAllocator->UploadSubresources(cmdList, m_randomVectorTex.Get(), 0, 1, &resData);
 
 		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
 			m_randomVectorTex.Get(),
 			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
 	}
 
-	void SSAO::BuildDescriptors(
-		ID3D12Resource* depthStencilBuffer, CD3DX12_CPU_DESCRIPTOR_HANDLE hCpuSrv,
-		CD3DX12_GPU_DESCRIPTOR_HANDLE hGpuSrv, CD3DX12_CPU_DESCRIPTOR_HANDLE hCpuRtv,
-		unsigned int cbvSrvUavDescriptorSize, unsigned int rtvDescriptorSize)
+	void SSAO::BuildDescriptors(ID3D12Resource* depthStencilBuffer, BindlessDescriptorHeap* pBindlessHeap,
+		CD3DX12_CPU_DESCRIPTOR_HANDLE hCpuRtv, unsigned int rtvDescriptorSize)
 	{
-		m_SSAOTex0CPUSrv = hCpuSrv;
-		m_SSAOTex1CPUSrv = hCpuSrv.Offset(1, cbvSrvUavDescriptorSize);
-		m_normalCpuSrv = hCpuSrv.Offset(1, cbvSrvUavDescriptorSize);
-		m_depthTexCpuSrv = hCpuSrv.Offset(1, cbvSrvUavDescriptorSize);
-		m_randomVectorCpuSrv = hCpuSrv.Offset(1, cbvSrvUavDescriptorSize);
-
-		m_SSAOTex0GPUSrv = hGpuSrv;
-		m_SSAOTex1GPUSrv = hGpuSrv.Offset(1, cbvSrvUavDescriptorSize);
-		m_normalGPUSrv = hGpuSrv.Offset(1, cbvSrvUavDescriptorSize);
-		m_depthTexGpuSrv = hGpuSrv.Offset(1, cbvSrvUavDescriptorSize);
-		m_randomVectorGPUSrv = hGpuSrv.Offset(1, cbvSrvUavDescriptorSize);
+		m_bindlessHeap = pBindlessHeap;
+
+		m_SSAOTex0SrvIndex = m_bindlessHeap->Allocate();
+		m_SSAOTex1SrvIndex = m_bindlessHeap->Allocate();
+		m_normalSrvIndex = m_bindlessHeap->Allocate();
+		m_depthTexSrvIndex = m_bindlessHeap->Allocate();
+		m_randomVectorSrvIndex = m_bindlessHeap->Allocate();
 
 		m_normalCpuRtv = hCpuRtv;
 		m_SSAOTex0CPURtv = hCpuRtv.Offset(1, rtvDescriptorSize);
 		m_SSAOTex1CPURtv = hCpuRtv.Offset(1, rtvDescriptorSize);
 
-		RebuildDescriptors(depthStencilBuffer);
+		// The targets only exist once the render graph placed them.
+		if (m_normalTexture != nullptr)
+		{
+			RebuildDescriptors(depthStencilBuffer);
+		}
 	}
 
 	void SSAO::_doBlur(ID3D12GraphicsCommandList* cmdList, bool isHorizontal)
 	{
 		ID3D12Resource* output = nullptr;
-		CD3DX12_GPU_DESCRIPTOR_HANDLE inputSrv;
 		CD3DX12_CPU_DESCRIPTOR_HANDLE outputRtv;
 
 		if (isHorizontal)
 		{
-			output = m_SSAOTexture1.Get();
-			inputSrv = m_SSAOTex0GPUSrv;
+			output = m_SSAOTexture1;
 			outputRtv = m_SSAOTex1CPURtv;
-			cmdList->SetGraphicsRoot32BitConstant(1, 1, 0);
+			_setRootConstants(cmdList, true, m_SSAOTex0SrvIndex);
 		}
 		else
 		{
-			output = m_SSAOTexture0.Get();
-			inputSrv = m_SSAOTex1GPUSrv;
+			output = m_SSAOTexture0;
 			outputRtv = m_SSAOTex0CPURtv;
-			cmdList->SetGraphicsRoot32BitConstant(1, 0, 0);
+			_setRootConstants(cmdList, false, m_SSAOTex1SrvIndex);
 		}
 
 		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(output, 
@@ -387,9 +370,7 @@ namespace Humpback
 
 		cmdList->OMSetRenderTargets(1, &outputRtv, true, nullptr);
 
-		cmdList->SetGraphicsRootDescriptorTable(2, m_normalGPUSrv);
-
-		cmdList->SetGraphicsRootDescriptorTable(3, inputSrv); // Bind input texture.
+		cmdList->SetGraphicsRootDescriptorTable(2, m_bindlessHeap->GetGpuHandle(0));
 
 		_drawFullScreenQuad(cmdList);
 
@@ -397,6 +378,19 @@ namespace Humpback
 			D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_GENERIC_READ));
 	}
 
+	void SSAO::_setRootConstants(ID3D12GraphicsCommandList* cmdList, bool horizontalBlur, uint32_t inputSrvIndex)
+	{
+		uint32_t constants[ROOT_CONSTANT_COUNT] =
+		{
+			horizontalBlur ? 1u : 0u,
+			m_normalSrvIndex,
+			m_depthTexSrvIndex,
+			inputSrvIndex,
+		};
+
+		cmdList->SetGraphicsRoot32BitConstants(1, ROOT_CONSTANT_COUNT, constants, 0);
+	}
+
 	void SSAO::_drawFullScreenQuad(ID3D12GraphicsCommandList* cmdList)
 	{
 		cmdList->IASetVertexBuffers(0, 0, nullptr);
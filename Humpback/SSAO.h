@@ -6,6 +6,8 @@
 
 #include "D3DUtil.h"
 #include "FrameResource.h"
+#include "UploadAllocator.h"
+#include "BindlessDescriptorHeap.h"
 
 
 namespace Humpback
@@ -14,7 +16,8 @@ namespace Humpback
 	{
 	public:
 
-		SSAO(UINT width, UINT height, ID3D12Device* pDevice, ID3D12GraphicsCommandList* cmdList);
+		SSAO(UINT width, UINT height, ID3D12Device* pDevice, ID3D12GraphicsCommandList* cmdList,
+			UploadAllocator* pUploadAllocator, GpuMemoryAllocator* pGpuMemory);
 
 		SSAO(const SSAO& rhs) = delete;
 		SSAO& operator=(const SSAO& rhs) = delete;
@@ -26,19 +29,29 @@ namespace Humpback
 		std::vector<float> GetWeights(float sigma);
 		float GetAOTextureWidth();
 		float GetAOTextureHeight();
-		ID3D12Resource* GetNormalResource();
 		CD3DX12_CPU_DESCRIPTOR_HANDLE GetNormalRTV();
+		uint32_t GetAmbientSrvIndex() const;
+
+		// The normal-depth and ambient targets are render graph transients. The graph sizes
+		// them from these descriptions and hands the placed resources back through SetResources.
+		D3D12_RESOURCE_DESC GetNormalDepthDesc(D3D12_CLEAR_VALUE* pClearValue) const;
+		D3D12_RESOURCE_DESC GetAmbientDesc(D3D12_CLEAR_VALUE* pClearValue) const;
+		void SetResources(ID3D12Resource* normalDepth, ID3D12Resource* ambient, ID3D12Resource* ambientBlur,
+			ID3D12Resource* depthStencilBuffer);
 
 		void Execute(ID3D12GraphicsCommandList* cmdList, FrameResource* pCurFrameRes, int blurCount);
 
-		void BuildDescriptors(ID3D12Resource* depthStencilBuffer, CD3DX12_CPU_DESCRIPTOR_HANDLE hCpuSrv,
-			CD3DX12_GPU_DESCRIPTOR_HANDLE hGpuSrv, CD3DX12_CPU_DESCRIPTOR_HANDLE hCpuRtv,
-			unsigned int cbvSrvUavDescriptorSize, unsigned int rtvDescriptorSize);
+		// The SRVs are allocated from the bindless heap once, RebuildDescriptors rewrites them in place.
+		void BuildDescriptors(ID3D12Resource* depthStencilBuffer, BindlessDescriptorHeap* pBindlessHeap,
+			CD3DX12_CPU_DESCRIPTOR_HANDLE hCpuRtv, unsigned int rtvDescriptorSize);
 		void RebuildDescriptors(ID3D12Resource* depthStencilBuffer);
 
 		static const DXGI_FORMAT NORMAL_DEPTH_FORMAT = DXGI_FORMAT_R16G16B16A16_FLOAT;
 		static const DXGI_FORMAT AMBIENT_FORMAT = DXGI_FORMAT_R16_UNORM;
 
+		// cbRootConstants: horizontal blur flag, normal, depth and input (or random vector) map indices.
+		static const unsigned int ROOT_CONSTANT_COUNT = 4;
+
 
 
 	private:
@@ -48,40 +61,38 @@ namespace Humpback
 		
 		void _doBlur(ID3D12GraphicsCommandList* cmdList, bool isHorizontal);
 		void _doBlur(ID3D12GraphicsCommandList* cmdList, int blurCount, FrameResource* frameRes);
+		void _setRootConstants(ID3D12GraphicsCommandList* cmdList, bool horizontalBlur, uint32_t inputSrvIndex);
 
 		void _onResize(unsigned int width, unsigned int height);
 		
-		void _buildResources();
 		void _buildOffsetVectors();
-		void _buildRandomVectorTex(ID3D12GraphicsCommandList* cmdList);
+		void _buildRandomVectorTex(ID3D12GraphicsCommandList* cmdList, UploadAllocator* pUploadAllocator);
 		
 
 		ID3D12Device* m_device;
+		GpuMemoryAllocator* m_gpuMemory;
+
+		// Owned by the render graph backend.
+		ID3D12Resource* m_SSAOTexture0 = nullptr;
+		ID3D12Resource* m_SSAOTexture1 = nullptr;
+		ID3D12Resource* m_normalTexture = nullptr;
 
-		Microsoft::WRL::ComPtr<ID3D12Resource> m_SSAOTexture0;
-		Microsoft::WRL::ComPtr<ID3D12Resource> m_SSAOTexture1;
-		Microsoft::WRL::ComPtr<ID3D12Resource> m_normalTexture;
 		Microsoft::WRL::ComPtr<ID3D12Resource> m_randomVectorTex;
-		Microsoft::WRL::ComPtr<ID3D12Resource> m_randomVectorTexUpload;
 
 
-		CD3DX12_CPU_DESCRIPTOR_HANDLE m_SSAOTex0CPUSrv;
+		BindlessDescriptorHeap* m_bindlessHeap = nullptr;
+
+		uint32_t m_SSAOTex0SrvIndex = DescriptorIndexAllocator::INVALID_INDEX;
 		CD3DX12_CPU_DESCRIPTOR_HANDLE m_SSAOTex0CPURtv;
-		CD3DX12_GPU_DESCRIPTOR_HANDLE m_SSAOTex0GPUSrv;
 
-		CD3DX12_CPU_DESCRIPTOR_HANDLE m_SSAOTex1CPUSrv;
+		uint32_t m_SSAOTex1SrvIndex = DescriptorIndexAllocator::INVALID_INDEX;
 		CD3DX12_CPU_DESCRIPTOR_HANDLE m_SSAOTex1CPURtv;
-		CD3DX12_GPU_DESCRIPTOR_HANDLE m_SSAOTex1GPUSrv;
 
-		CD3DX12_CPU_DESCRIPTOR_HANDLE m_normalCpuSrv;
-		CD3DX12_GPU_DESCRIPTOR_HANDLE m_normalGPUSrv;
+		uint32_t m_normalSrvIndex = DescriptorIndexAllocator::INVALID_INDEX;
 		CD3DX12_CPU_DESCRIPTOR_HANDLE m_normalCpuRtv;
 
-		CD3DX12_CPU_DESCRIPTOR_HANDLE m_depthTexCpuSrv;
-		CD3DX12_GPU_DESCRIPTOR_HANDLE m_depthTexGpuSrv;
-
-		CD3DX12_CPU_DESCRIPTOR_HANDLE m_randomVectorCpuSrv;
-		CD3DX12_GPU_DESCRIPTOR_HANDLE m_randomVectorGPUSrv;
+		uint32_t m_depthTexSrvIndex = DescriptorIndexAllocator::INVALID_INDEX;
+		uint32_t m_randomVectorSrvIndex = DescriptorIndexAllocator::INVALID_INDEX;
 
 		ID3D12PipelineState* m_SSAOPipelineState;
 		ID3D12PipelineState* m_blurPipelineState;
@@ -0,0 +1,786 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <immintrin.h>
+
+#include "SceneBvh.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+
+
+using namespace DirectX;
+
+
+namespace Humpback
+{
+	namespace
+	{
+		const unsigned int BIN_COUNT = 16;
+
+		// Node of the binary SAH tree the 8-wide tree is collapsed from. count == 1 is a leaf.
+		struct BinaryNode
+		{
+			float min[3];
+			float max[3];
+			uint32_t left = 0;
+			uint32_t right = 0;
+			uint32_t first = 0;
+			uint32_t count = 0;
+		};
+
+		// The boxes are copied into one array the build partitions in place, so every pass over a range
+		// reads memory in order instead of gathering from the SoA arrays. The fourth lane of min carries
+		// the box index and is masked off before use.
+		struct BuildBox
+		{
+			float min[3];
+			uint32_t index;
+			float max[4];
+		};
+
+		struct Bin
+		{
+			__m128 min = _mm_set1_ps(FLT_MAX);
+			__m128 max = _mm_set1_ps(-FLT_MAX);
+			uint32_t count = 0;
+
+			void Grow(__m128 boxMin, __m128 boxMax)
+			{
+				min = _mm_min_ps(min, boxMin);
+				max = _mm_max_ps(max, boxMax);
+			}
+
+			void Grow(const Bin& bin)
+			{
+				Grow(bin.min, bin.max);
+				count += bin.count;
+			}
+		};
+
+		float SurfaceArea(const float* min, const float* max)
+		{
+			float dx = max[0] - min[0];
+			float dy = max[1] - min[1];
+			float dz = max[2] - min[2];
+			if (dx < 0.0f || dy < 0.0f || dz < 0.0f)
+			{
+				return 0.0f;
+			}
+
+			return 2.0f * (dx * dy + dy * dz + dz * dx);
+		}
+
+		float SurfaceArea(const Bin& bin)
+		{
+			float min[4], max[4];
+			_mm_storeu_ps(min, bin.min);
+			_mm_storeu_ps(max, bin.max);
+			return SurfaceArea(min, max);
+		}
+
+		// Splits every range down to single boxes. The split plane is picked among BIN_COUNT bins of the box
+		// centroids, ranges whose centroids coincide are halved.
+		// minMax holds the min and max corner of each box in turn.
+		void BuildBinary(const XMFLOAT3* minMax, std::vector<uint32_t>& order, std::vector<BinaryNode>& nodes)
+		{
+			uint32_t count = (uint32_t)order.size();
+
+			std::vector<BuildBox> boxes(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const XMFLOAT3& min = minMax[2 * i];
+				const XMFLOAT3& max = minMax[2 * i + 1];
+				boxes[i] = { { min.x, min.y, min.z }, i, { max.x, max.y, max.z, 0.0f } };
+			}
+
+			const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+			const __m128 half = _mm_set1_ps(0.5f);
+			auto loadMin = [&](const BuildBox& box) { return _mm_and_ps(_mm_loadu_ps(box.min), xyzMask); };
+			auto loadCentroid = [&](const BuildBox& box)
+				{
+					return _mm_mul_ps(_mm_add_ps(loadMin(box), _mm_loadu_ps(box.max)), half);
+				};
+
+			nodes.clear();
+			nodes.reserve(2 * (size_t)count);
+			nodes.emplace_back();
+			nodes[0].count = count;
+
+			std::vector<uint32_t> work = { 0 };
+			while (work.empty() == false)
+			{
+				uint32_t n = work.back();
+				work.pop_back();
+
+				BuildBox* const first = boxes.data() + nodes[n].first;
+				BuildBox* const last = first + nodes[n].count;
+
+				Bin bounds;
+				Bin centroids;
+				for (const BuildBox* box = first; box != last; box++)
+				{
+					bounds.Grow(loadMin(*box), _mm_loadu_ps(box->max));
+					__m128 centroid = loadCentroid(*box);
+					centroids.Grow(centroid, centroid);
+				}
+
+				float boundsMin[4], boundsMax[4];
+				_mm_storeu_ps(boundsMin, bounds.min);
+				_mm_storeu_ps(boundsMax, bounds.max);
+				for (int a = 0; a < 3; a++)
+				{
+					nodes[n].min[a] = boundsMin[a];
+					nodes[n].max[a] = boundsMax[a];
+				}
+
+				if (nodes[n].count == 1)
+				{
+					continue;
+				}
+
+				// Binned along the axis the centroids spread furthest on. Small ranges get fewer bins, the sweeps
+				// over the bins would cost more than the boxes.
+				float centroidMin[4], centroidMax[4];
+				_mm_storeu_ps(centroidMin, centroids.min);
+				_mm_storeu_ps(centroidMax, centroids.max);
+
+				int axis = 0;
+				for (int a = 1; a < 3; a++)
+				{
+					if (centroidMax[a] - centroidMin[a] > centroidMax[axis] - centroidMin[axis])
+					{
+						axis = a;
+					}
+				}
+
+				const uint32_t binCount = std::min(BIN_COUNT, nodes[n].count);
+				const float offset = centroidMin[axis];
+				const float extent = centroidMax[axis] - offset;
+				const float scale = extent > 0.0f ? binCount * 0.9999f / extent : 0.0f;
+				auto binOf = [&](const BuildBox& box)
+					{
+						float centroid = 0.5f * (box.min[axis] + box.max[axis]);
+						return std::min((uint32_t)(int)((centroid - offset) * scale), binCount - 1);
+					};
+
+				Bin bins[BIN_COUNT];
+				for (const BuildBox* box = first; box != last; box++)
+				{
+					Bin& bin = bins[binOf(*box)];
+					bin.Grow(loadMin(*box), _mm_loadu_ps(box->max));
+					bin.count++;
+				}
+
+				// Cost of splitting after bin k: boxes on each side times the area of their bounds.
+				float rightArea[BIN_COUNT];
+				uint32_t rightCount[BIN_COUNT];
+				Bin right;
+				for (uint32_t k = binCount - 1; k > 0; k--)
+				{
+					right.Grow(bins[k]);
+					rightArea[k - 1] = SurfaceArea(right);
+					rightCount[k - 1] = right.count;
+				}
+
+				int bestBin = -1;
+				float bestCost = FLT_MAX;
+				Bin left;
+				for (uint32_t k = 0; k < binCount - 1; k++)
+				{
+					left.Grow(bins[k]);
+					if (left.count == 0 || rightCount[k] == 0)
+					{
+						continue;
+					}
+
+					float cost = left.count * SurfaceArea(left) + rightCount[k] * rightArea[k];
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						bestBin = (int)k;
+					}
+				}
+
+				BuildBox* mid = first + (last - first) / 2;
+				if (bestBin >= 0)
+				{
+					mid = std::partition(first, last, [&](const BuildBox& box) { return binOf(box) <= (uint32_t)bestBin; });
+				}
+
+				// Only float trouble could leave a side empty, halving still terminates.
+				if (mid == first || mid == last)
+				{
+					mid = first + (last - first) / 2;
+				}
+
+				uint32_t splitIndex = (uint32_t)(mid - boxes.data());
+
+				uint32_t leftNode = (uint32_t)nodes.size();
+				nodes.emplace_back();
+				nodes[leftNode].first = nodes[n].first;
+				nodes[leftNode].count = splitIndex - nodes[n].first;
+
+				uint32_t rightNode = (uint32_t)nodes.size();
+				nodes.emplace_back();
+				nodes[rightNode].first = splitIndex;
+				nodes[rightNode].count = nodes[n].first + nodes[n].count - splitIndex;
+
+				nodes[n].left = leftNode;
+				nodes[n].right = rightNode;
+
+				work.push_back(rightNode);
+				work.push_back(leftNode);
+			}
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				order[i] = boxes[i].index;
+			}
+		}
+
+		// Per plane the box corner furthest along the normal decides whether a box is outside, the nearest
+		// corner whether it is inside. The corner depends only on the signs of the normal.
+		struct FrustumBatch
+		{
+			float nx[6], ny[6], nz[6], w[6];
+			bool positiveX[6], positiveY[6], positiveZ[6];
+
+			explicit FrustumBatch(const FrustumPlanes& frustum)
+			{
+				for (int p = 0; p < 6; p++)
+				{
+					const XMFLOAT4& plane = frustum.planes[p];
+					nx[p] = plane.x;
+					ny[p] = plane.y;
+					nz[p] = plane.z;
+					w[p] = plane.w;
+					positiveX[p] = plane.x >= 0.0f;
+					positiveY[p] = plane.y >= 0.0f;
+					positiveZ[p] = plane.z >= 0.0f;
+				}
+			}
+		};
+
+		// Tests 8 boxes given as min and max arrays, bit i of the masks is box i.
+		typedef void (*TestBoxesFunction)(const FrustumBatch& f, const float* minX, const float* minY, const float* minZ,
+			const float* maxX, const float* maxY, const float* maxZ, int& intersectMask, int& insideMask);
+
+		void TestBoxesSse(const FrustumBatch& f, const float* minX, const float* minY, const float* minZ,
+			const float* maxX, const float* maxY, const float* maxZ, int& intersectMask, int& insideMask)
+		{
+			intersectMask = 0;
+			insideMask = 0;
+
+			const __m128 zero = _mm_setzero_ps();
+			for (int half = 0; half < 8; half += 4)
+			{
+				const __m128 x0 = _mm_loadu_ps(minX + half), x1 = _mm_loadu_ps(maxX + half);
+				const __m128 y0 = _mm_loadu_ps(minY + half), y1 = _mm_loadu_ps(maxY + half);
+				const __m128 z0 = _mm_loadu_ps(minZ + half), z1 = _mm_loadu_ps(maxZ + half);
+
+				__m128 intersect = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				__m128 inside = intersect;
+				for (int p = 0; p < 6; p++)
+				{
+					const __m128 nx = _mm_set1_ps(f.nx[p]), ny = _mm_set1_ps(f.ny[p]);
+					const __m128 nz = _mm_set1_ps(f.nz[p]), w = _mm_set1_ps(f.w[p]);
+
+					__m128 farX = f.positiveX[p] ? x1 : x0, nearX = f.positiveX[p] ? x0 : x1;
+					__m128 farY = f.positiveY[p] ? y1 : y0, nearY = f.positiveY[p] ? y0 : y1;
+					__m128 farZ = f.positiveZ[p] ? z1 : z0, nearZ = f.positiveZ[p] ? z0 : z1;
+
+					__m128 farDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(farX, nx), _mm_mul_ps(farY, ny)),
+						_mm_add_ps(_mm_mul_ps(farZ, nz), w));
+					__m128 nearDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nearX, nx), _mm_mul_ps(nearY, ny)),
+						_mm_add_ps(_mm_mul_ps(nearZ, nz), w));
+
+					intersect = _mm_and_ps(intersect, _mm_cmpge_ps(farDist, zero));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(nearDist, zero));
+				}
+
+				intersectMask |= _mm_movemask_ps(intersect) << half;
+				insideMask |= _mm_movemask_ps(inside) << half;
+			}
+		}
+
+		HB_TARGET_AVX void TestBoxesAvx(const FrustumBatch& f, const float* minX, const float* minY, const float* minZ,
+			const float* maxX, const float* maxY, const float* maxZ, int& intersectMask, int& insideMask)
+		{
+			const __m256 x0 = _mm256_loadu_ps(minX), x1 = _mm256_loadu_ps(maxX);
+			const __m256 y0 = _mm256_loadu_ps(minY), y1 = _mm256_loadu_ps(maxY);
+			const __m256 z0 = _mm256_loadu_ps(minZ), z1 = _mm256_loadu_ps(maxZ);
+			const __m256 zero = _mm256_setzero_ps();
+
+			__m256 intersect = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			__m256 inside = intersect;
+			for (int p = 0; p < 6; p++)
+			{
+				const __m256 nx = _mm256_broadcast_ss(&f.nx[p]), ny = _mm256_broadcast_ss(&f.ny[p]);
+				const __m256 nz = _mm256_broadcast_ss(&f.nz[p]), w = _mm256_broadcast_ss(&f.w[p]);
+
+				__m256 farX = f.positiveX[p] ? x1 : x0, nearX = f.positiveX[p] ? x0 : x1;
+				__m256 farY = f.positiveY[p] ? y1 : y0, nearY = f.positiveY[p] ? y0 : y1;
+				__m256 farZ = f.positiveZ[p] ? z1 : z0, nearZ = f.positiveZ[p] ? z0 : z1;
+
+				__m256 farDist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(farX, nx), _mm256_mul_ps(farY, ny)),
+					_mm256_add_ps(_mm256_mul_ps(farZ, nz), w));
+				__m256 nearDist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nearX, nx), _mm256_mul_ps(nearY, ny)),
+					_mm256_add_ps(_mm256_mul_ps(nearZ, nz), w));
+
+				intersect = _mm256_and_ps(intersect, _mm256_cmp_ps(farDist, zero, _CMP_GE_OQ));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(nearDist, zero, _CMP_GE_OQ));
+			}
+
+			intersectMask = _mm256_movemask_ps(intersect);
+			insideMask = _mm256_movemask_ps(inside);
+
+			// The callers are built without VEX, avoid the AVX to SSE transition penalty.
+			_mm256_zeroupper();
+		}
+	}
+
+
+	SceneBvh::SceneBvh(JobSystem* jobSystem) :
+		m_jobSystem(jobSystem)
+	{
+	}
+
+	SceneBvh::~SceneBvh()
+	{
+		// The job owns what it touches, but there is no point in letting it run on.
+		if (m_pendingBuild.valid())
+		{
+			m_pendingBuild.wait();
+		}
+	}
+
+	unsigned int SceneBvh::AddBox(const BoundingBox& box)
+	{
+		unsigned int index = m_count++;
+
+		m_boxes.emplace_back();
+		SetBox(index, box);
+
+		return index;
+	}
+
+	void SceneBvh::SetBox(unsigned int index, const BoundingBox& box)
+	{
+		Bounds& bounds = m_boxes[index];
+		bounds.min = XMFLOAT3(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+		bounds.max = XMFLOAT3(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+
+		// Until the next Update builds a tree that covers added boxes there is nothing to refit.
+		if (m_tree.boxCount == m_count)
+		{
+			_markBox(index);
+
+			if (m_pendingBuild.valid())
+			{
+				m_boxesSetDuringBuild.push_back(index);
+			}
+		}
+	}
+
+	BoundingBox SceneBvh::GetBox(unsigned int index) const
+	{
+		BoundingBox box;
+		BoundingBox::CreateFromPoints(box, XMLoadFloat3(&m_boxes[index].min), XMLoadFloat3(&m_boxes[index].max));
+		return box;
+	}
+
+	BoundingBox SceneBvh::GetBounds() const
+	{
+		// The root is the first node, refit along with the nodes below it.
+		if (m_tree.nodeBounds.empty())
+		{
+			return BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+		}
+
+		BoundingBox box;
+		BoundingBox::CreateFromPoints(box, XMLoadFloat3(&m_tree.nodeBounds[0].min), XMLoadFloat3(&m_tree.nodeBounds[0].max));
+		return box;
+	}
+
+	void SceneBvh::Clear()
+	{
+		if (m_pendingBuild.valid())
+		{
+			m_pendingBuild.wait();
+			m_pendingBuild = std::future<void>();
+		}
+		m_buildJob.reset();
+		m_boxesSetDuringBuild.clear();
+
+		m_boxes.clear();
+		m_count = 0;
+		m_tree = Tree();
+	}
+
+	void SceneBvh::Update()
+	{
+		if (m_tree.boxCount != m_count)
+		{
+			// A rebuild started before the boxes were added misses them.
+			if (m_pendingBuild.valid())
+			{
+				m_pendingBuild.get();
+			}
+			m_buildJob.reset();
+			m_boxesSetDuringBuild.clear();
+
+			_build(m_boxes, m_tree);
+			return;
+		}
+
+		_refitDirty();
+
+		if (m_pendingBuild.valid())
+		{
+			if (m_pendingBuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			{
+				_finishRebuild();
+			}
+		}
+		else if (GetCostRatio() > m_rebuildThreshold)
+		{
+			_startRebuild();
+		}
+	}
+
+	void SceneBvh::Cull(const FrustumPlanes& frustum, std::vector<unsigned int>& visible, CullingStats* pStats) const
+	{
+		visible.clear();
+
+		if (m_tree.boxCount != m_count)
+		{
+			throw std::runtime_error("SceneBvh: Update has to run after boxes are added.");
+		}
+
+		unsigned int testedCount = 0;
+		if (m_count > 0)
+		{
+			FrustumBatch batch(frustum);
+			const TestBoxesFunction testBoxes = GetCpuFeatures().avx ? TestBoxesAvx : TestBoxesSse;
+
+			std::vector<uint32_t> stack;
+			stack.reserve(64);
+			stack.push_back(0);
+
+			while (stack.empty() == false)
+			{
+				const Node& node = m_tree.nodes[stack.back()];
+				stack.pop_back();
+
+				int intersectMask, insideMask;
+				testBoxes(batch, node.minX, node.minY, node.minZ, node.maxX, node.maxY, node.maxZ, intersectMask, insideMask);
+				intersectMask &= (1 << node.childCount) - 1;
+				testedCount += node.childCount;
+
+				for (uint32_t i = 0; intersectMask != 0; i++, intersectMask >>= 1, insideMask >>= 1)
+				{
+					if ((intersectMask & 1) == 0)
+					{
+						continue;
+					}
+
+					uint32_t child = node.children[i];
+					if (child & BOX_BIT)
+					{
+						visible.push_back(child & ~BOX_BIT);
+					}
+					else if (insideMask & 1)
+					{
+						const Node& inner = m_tree.nodes[child];
+						auto first = m_tree.order.begin() + inner.firstBox;
+						visible.insert(visible.end(), first, first + inner.boxCount);
+					}
+					else
+					{
+						stack.push_back(child);
+					}
+				}
+			}
+		}
+
+		if (pStats != nullptr)
+		{
+			pStats->testedCount += testedCount;
+			pStats->visibleCount += (unsigned int)visible.size();
+		}
+	}
+
+	float SceneBvh::GetCostRatio() const
+	{
+		if (m_tree.buildCost <= 0.0)
+		{
+			return 1.0f;
+		}
+
+		return (float)(_getCost(m_tree) / m_tree.buildCost);
+	}
+
+	void SceneBvh::_build(const std::vector<Bounds>& boxes, Tree& tree)
+	{
+		static_assert(sizeof(Bounds) == 2 * sizeof(XMFLOAT3), "BuildBinary reads the boxes as corner pairs.");
+
+		uint32_t count = (uint32_t)boxes.size();
+		tree = Tree();
+		tree.boxCount = count;
+		tree.order.resize(count);
+		std::iota(tree.order.begin(), tree.order.end(), 0u);
+		tree.boxNodes.assign(count, (uint32_t)NO_NODE);
+
+		if (count == 0)
+		{
+			return;
+		}
+
+		std::vector<BinaryNode> binary;
+		BuildBinary(&boxes[0].min, tree.order, binary);
+
+		// Each wide node takes the two children of its binary node, then keeps opening the largest inner
+		// node among its children until it has WIDTH of them.
+		struct Pending
+		{
+			uint32_t binary;
+			uint32_t node;
+		};
+
+		tree.nodes.reserve(count / 4 + 1);
+		tree.nodes.emplace_back();
+		tree.nodes[0].boxCount = count;
+		tree.parents.push_back((uint32_t)NO_NODE);
+
+		std::vector<Pending> work = { { 0, 0 } };
+		while (work.empty() == false)
+		{
+			Pending pending = work.back();
+			work.pop_back();
+
+			uint32_t candidates[WIDTH];
+			uint32_t candidateCount = 0;
+
+			const BinaryNode& source = binary[pending.binary];
+			if (source.count == 1)
+			{
+				candidates[candidateCount++] = pending.binary;
+			}
+			else
+			{
+				candidates[candidateCount++] = source.left;
+				candidates[candidateCount++] = source.right;
+			}
+
+			while (candidateCount < WIDTH)
+			{
+				int largest = -1;
+				float largestArea = -1.0f;
+				for (uint32_t c = 0; c < candidateCount; c++)
+				{
+					const BinaryNode& candidate = binary[candidates[c]];
+					float area = SurfaceArea(candidate.min, candidate.max);
+					if (candidate.count > 1 && area > largestArea)
+					{
+						largest = (int)c;
+						largestArea = area;
+					}
+				}
+
+				if (largest < 0)
+				{
+					break;
+				}
+
+				const BinaryNode& opened = binary[candidates[largest]];
+				candidates[largest] = opened.left;
+				candidates[candidateCount++] = opened.right;
+			}
+
+			for (uint32_t c = 0; c < candidateCount; c++)
+			{
+				const BinaryNode& candidate = binary[candidates[c]];
+				if (candidate.count == 1)
+				{
+					uint32_t box = tree.order[candidate.first];
+					tree.nodes[pending.node].children[c] = box | BOX_BIT;
+					tree.boxNodes[box] = pending.node;
+					continue;
+				}
+
+				uint32_t child = (uint32_t)tree.nodes.size();
+				tree.nodes.emplace_back();
+				tree.parents.push_back(pending.node);
+				tree.nodes[child].firstBox = candidate.first;
+				tree.nodes[child].boxCount = candidate.count;
+
+				tree.nodes[pending.node].children[c] = child;
+				work.push_back({ candidates[c], child });
+			}
+
+			// Unused slots are empty boxes, Cull masks them out.
+			Node& node = tree.nodes[pending.node];
+			node.childCount = candidateCount;
+			for (uint32_t c = candidateCount; c < WIDTH; c++)
+			{
+				node.children[c] = NO_NODE;
+				node.minX[c] = node.minY[c] = node.minZ[c] = 0.0f;
+				node.maxX[c] = node.maxY[c] = node.maxZ[c] = 0.0f;
+			}
+		}
+
+		tree.dirty.assign(tree.nodes.size(), 0);
+		_refitAll(tree, boxes);
+		tree.buildCost = _getCost(tree);
+	}
+
+	void SceneBvh::_refitNode(Tree& tree, const std::vector<Bounds>& boxes, uint32_t node)
+	{
+		Node& n = tree.nodes[node];
+
+		Bounds bounds;
+		bounds.min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+		bounds.max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+		for (uint32_t c = 0; c < n.childCount; c++)
+		{
+			uint32_t child = n.children[c];
+			const Bounds& childBounds = (child & BOX_BIT) ? boxes[child & ~BOX_BIT] : tree.nodeBounds[child];
+			n.minX[c] = childBounds.min.x;
+			n.minY[c] = childBounds.min.y;
+			n.minZ[c] = childBounds.min.z;
+			n.maxX[c] = childBounds.max.x;
+			n.maxY[c] = childBounds.max.y;
+			n.maxZ[c] = childBounds.max.z;
+
+			bounds.min.x = std::min(bounds.min.x, n.minX[c]);
+			bounds.min.y = std::min(bounds.min.y, n.minY[c]);
+			bounds.min.z = std::min(bounds.min.z, n.minZ[c]);
+			bounds.max.x = std::max(bounds.max.x, n.maxX[c]);
+			bounds.max.y = std::max(bounds.max.y, n.maxY[c]);
+			bounds.max.z = std::max(bounds.max.z, n.maxZ[c]);
+		}
+
+		Bounds& stored = tree.nodeBounds[node];
+		tree.areaSum += (double)SurfaceArea(&bounds.min.x, &bounds.max.x) - SurfaceArea(&stored.min.x, &stored.max.x);
+		stored = bounds;
+	}
+
+	void SceneBvh::_refitAll(Tree& tree, const std::vector<Bounds>& boxes)
+	{
+		tree.nodeBounds.assign(tree.nodes.size(), Bounds());
+		tree.areaSum = 0.0;
+
+		for (size_t i = tree.nodes.size(); i > 0; i--)
+		{
+			_refitNode(tree, boxes, (uint32_t)(i - 1));
+		}
+	}
+
+	double SceneBvh::_getCost(const Tree& tree)
+	{
+		if (tree.nodes.empty())
+		{
+			return 0.0;
+		}
+
+		// A frustum inside the root reaches a node about as often as its area is a share of the root area.
+		const Bounds& root = tree.nodeBounds[0];
+		double rootArea = SurfaceArea(&root.min.x, &root.max.x);
+		return rootArea > 0.0 ? tree.areaSum / rootArea : (double)tree.nodes.size();
+	}
+
+	void SceneBvh::_markBox(uint32_t box)
+	{
+		uint32_t node = m_tree.boxNodes[box];
+		while (node != NO_NODE && m_tree.dirty[node] == 0)
+		{
+			m_tree.dirty[node] = 1;
+			m_tree.dirtyNodes.push_back(node);
+			node = m_tree.parents[node];
+		}
+	}
+
+	void SceneBvh::_refitDirty()
+	{
+		if (m_tree.dirtyNodes.empty())
+		{
+			return;
+		}
+
+		// Children have larger indices than their parents, so they are refit first. Once a good share of
+		// the nodes is dirty, walking the flags beats sorting the list.
+		if (m_tree.dirtyNodes.size() * 8 < m_tree.nodes.size())
+		{
+			std::sort(m_tree.dirtyNodes.begin(), m_tree.dirtyNodes.end(), std::greater<uint32_t>());
+			for (uint32_t node : m_tree.dirtyNodes)
+			{
+				_refitNode(m_tree, m_boxes, node);
+				m_tree.dirty[node] = 0;
+			}
+		}
+		else
+		{
+			for (size_t i = m_tree.nodes.size(); i > 0; i--)
+			{
+				if (m_tree.dirty[i - 1])
+				{
+					_refitNode(m_tree, m_boxes, (uint32_t)(i - 1));
+					m_tree.dirty[i - 1] = 0;
+				}
+			}
+		}
+		m_tree.dirtyNodes.clear();
+	}
+
+	void SceneBvh::_startRebuild()
+	{
+		if (m_jobSystem == nullptr)
+		{
+			_build(m_boxes, m_tree);
+			m_rebuildCount++;
+			return;
+		}
+
+		auto job = std::make_shared<BuildJob>();
+		job->boxes = m_boxes;
+
+		m_buildJob = job;
+		m_pendingBuild = m_jobSystem->Submit([job]() { _build(job->boxes, job->tree); });
+	}
+
+	void SceneBvh::_finishRebuild()
+	{
+		// Rethrows what the build threw.
+		m_pendingBuild.get();
+
+		m_tree = std::move(m_buildJob->tree);
+		m_buildJob.reset();
+
+		// The new tree has the bounds of the copy it was built from. Past a node count of boxes set since,
+		// a full refit is cheaper than walking up from each.
+		if (m_boxesSetDuringBuild.size() > m_tree.nodes.size())
+		{
+			_refitAll(m_tree, m_boxes);
+		}
+		else
+		{
+			for (uint32_t box : m_boxesSetDuringBuild)
+			{
+				_markBox(box);
+			}
+			_refitDirty();
+		}
+		m_boxesSetDuringBuild.clear();
+
+		m_rebuildCount++;
+	}
+}
@@ -0,0 +1,147 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <future>
+#include <cstdint>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+#include "FrustumCuller.h"
+
+
+namespace Humpback
+{
+	class JobSystem;
+
+
+	// World space AABBs under an 8-wide bounding volume hierarchy, queried with the same frustum planes as
+	// FrustumCuller. The tree is built with the binned surface area heuristic (SAH) and collapsed so a node
+	// holds up to 8 children, which one AVX batch (two SSE batches) tests against a plane at once. The AVX path
+	// is picked at runtime, see CpuFeatures.
+	//
+	// Moving a box refits the nodes above it in place. Refitting keeps the tree correct but loosens it, so
+	// the SAH cost is tracked against the cost at build time. Past the rebuild threshold a new tree is built
+	// on the job system from a copy of the boxes and swapped in by a later Update.
+	class SceneBvh
+	{
+	public:
+
+		// Without a job system rebuilds run inside Update.
+		explicit SceneBvh(JobSystem* jobSystem = nullptr);
+		SceneBvh(const SceneBvh&) = delete;
+		SceneBvh& operator=(const SceneBvh&) = delete;
+		~SceneBvh();
+
+		unsigned int AddBox(const DirectX::BoundingBox& box);
+		void SetBox(unsigned int index, const DirectX::BoundingBox& box);
+		void Clear();
+
+		unsigned int GetBoxCount() const { return m_count; }
+		DirectX::BoundingBox GetBox(unsigned int index) const;
+
+		// Box around every box as of the last Update, empty without boxes.
+		DirectX::BoundingBox GetBounds() const;
+
+		// Brings the tree up to date with the boxes: builds it when boxes were added, refits the nodes above
+		// moved boxes, then swaps in a finished rebuild or starts one. Cull needs it after boxes changed.
+		void Update();
+
+		// Writes the indices of the boxes intersecting the frustum, in no particular order. Subtrees inside
+		// the frustum are written without testing their boxes.
+		void Cull(const FrustumPlanes& frustum, std::vector<unsigned int>& visible, CullingStats* pStats = nullptr) const;
+
+		// SAH cost of the refit tree relative to the cost it had when it was built.
+		float GetCostRatio() const;
+		void SetRebuildThreshold(float costRatio) { m_rebuildThreshold = costRatio; }
+
+		unsigned int GetNodeCount() const { return (unsigned int)m_tree.nodes.size(); }
+		unsigned int GetRebuildCount() const { return m_rebuildCount; }
+		bool IsRebuilding() const { return m_pendingBuild.valid(); }
+
+	private:
+
+		static const unsigned int WIDTH = 8;
+		static const uint32_t NO_NODE = UINT32_MAX;
+
+		// Set in a child reference when it is a box index instead of a node index.
+		static const uint32_t BOX_BIT = 0x80000000u;
+
+		struct Node
+		{
+			float minX[WIDTH];
+			float minY[WIDTH];
+			float minZ[WIDTH];
+			float maxX[WIDTH];
+			float maxY[WIDTH];
+			float maxZ[WIDTH];
+
+			uint32_t children[WIDTH];
+			uint32_t childCount = 0;
+
+			// The boxes below the node are order[firstBox, firstBox + boxCount).
+			uint32_t firstBox = 0;
+			uint32_t boxCount = 0;
+		};
+
+		struct Bounds
+		{
+			DirectX::XMFLOAT3 min;
+			DirectX::XMFLOAT3 max;
+		};
+
+		// Nodes come after their parent, so refitting from the last node to the first sees children first.
+		// What the refit walks is kept apart from the nodes the queries read.
+		struct Tree
+		{
+			std::vector<Node> nodes;
+			std::vector<Bounds> nodeBounds;
+			std::vector<uint32_t> parents;
+			std::vector<uint32_t> order;
+			std::vector<uint32_t> boxNodes;
+			uint32_t boxCount = 0;
+
+			std::vector<uint8_t> dirty;
+			std::vector<uint32_t> dirtyNodes;
+
+			// Sum of the node surface areas, the SAH cost up to the root area it is divided by.
+			double areaSum = 0.0;
+			double buildCost = 0.0;
+		};
+
+		struct BuildJob
+		{
+			std::vector<Bounds> boxes;
+			Tree tree;
+		};
+
+		static void _build(const std::vector<Bounds>& boxes, Tree& tree);
+		static void _refitNode(Tree& tree, const std::vector<Bounds>& boxes, uint32_t node);
+		static void _refitAll(Tree& tree, const std::vector<Bounds>& boxes);
+		static double _getCost(const Tree& tree);
+
+		void _markBox(uint32_t box);
+		void _refitDirty();
+		void _startRebuild();
+		void _finishRebuild();
+
+		std::vector<Bounds> m_boxes;
+		unsigned int m_count = 0;
+
+		Tree m_tree;
+
+		JobSystem* m_jobSystem = nullptr;
+		std::shared_ptr<BuildJob> m_buildJob;
+		std::future<void> m_pendingBuild;
+
+		// Boxes set while a rebuild runs, the new tree has the old bounds for them.
+		std::vector<uint32_t> m_boxesSetDuringBuild;
+
+		float m_rebuildThreshold = 1.5f;
+		unsigned int m_rebuildCount = 0;
+	};
+}
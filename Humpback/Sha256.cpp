@@ -0,0 +1,161 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cstring>
+#include <algorithm>
+
+#include "Sha256.h"
+
+
+namespace Humpback
+{
+	namespace
+	{
+		const uint32_t K[64] =
+		{
+			0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+			0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+			0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+			0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+			0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+			0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+			0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+			0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+		};
+
+		inline uint32_t RotateRight(uint32_t x, int n)
+		{
+			return (x >> n) | (x << (32 - n));
+		}
+	}
+
+	Sha256::Sha256()
+	{
+		m_state[0] = 0x6a09e667;
+		m_state[1] = 0xbb67ae85;
+		m_state[2] = 0x3c6ef372;
+		m_state[3] = 0xa54ff53a;
+		m_state[4] = 0x510e527f;
+		m_state[5] = 0x9b05688c;
+		m_state[6] = 0x1f83d9ab;
+		m_state[7] = 0x5be0cd19;
+	}
+
+	void Sha256::Update(const void* data, size_t size)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		m_totalSize += size;
+
+		if (m_bufferSize > 0)
+		{
+			size_t count = std::min(size, sizeof(m_buffer) - m_bufferSize);
+			std::memcpy(m_buffer + m_bufferSize, bytes, count);
+			m_bufferSize += count;
+			bytes += count;
+			size -= count;
+
+			if (m_bufferSize < sizeof(m_buffer))
+			{
+				return;
+			}
+
+			_processBlock(m_buffer);
+			m_bufferSize = 0;
+		}
+
+		// Whole blocks are hashed straight from the input.
+		for (; size >= 64; bytes += 64, size -= 64)
+		{
+			_processBlock(bytes);
+		}
+
+		std::memcpy(m_buffer, bytes, size);
+		m_bufferSize = size;
+	}
+
+	Sha256::Digest Sha256::Finish()
+	{
+		uint64_t bitCount = m_totalSize * 8;
+
+		uint8_t padding[72] = { 0x80 };
+		size_t paddingSize = (m_bufferSize < 56 ? 56 : 120) - m_bufferSize;
+		for (int i = 0; i < 8; i++)
+		{
+			padding[paddingSize + i] = (uint8_t)(bitCount >> (56 - 8 * i));
+		}
+		Update(padding, paddingSize + 8);
+
+		Digest digest;
+		for (int i = 0; i < 8; i++)
+		{
+			digest[i * 4 + 0] = (uint8_t)(m_state[i] >> 24);
+			digest[i * 4 + 1] = (uint8_t)(m_state[i] >> 16);
+			digest[i * 4 + 2] = (uint8_t)(m_state[i] >> 8);
+			digest[i * 4 + 3] = (uint8_t)(m_state[i]);
+		}
+
+		return digest;
+	}
+
+	std::string Sha256::ToHex(const Digest& digest)
+	{
+		static const char* HEX = "0123456789abcdef";
+
+		std::string text(digest.size() * 2, '0');
+		for (size_t i = 0; i < digest.size(); i++)
+		{
+			text[i * 2 + 0] = HEX[digest[i] >> 4];
+			text[i * 2 + 1] = HEX[digest[i] & 0xf];
+		}
+
+		return text;
+	}
+
+	void Sha256::_processBlock(const uint8_t* block)
+	{
+		uint32_t w[64];
+		for (int i = 0; i < 16; i++)
+		{
+			w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+				((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+		}
+		for (int i = 16; i < 64; i++)
+		{
+			uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+			uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+
+		uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+		uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+
+		for (int i = 0; i < 64; i++)
+		{
+			uint32_t s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+			uint32_t ch = (e & f) ^ (~e & g);
+			uint32_t t1 = h + s1 + ch + K[i] + w[i];
+			uint32_t s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+			uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+			uint32_t t2 = s0 + maj;
+
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		m_state[0] += a;
+		m_state[1] += b;
+		m_state[2] += c;
+		m_state[3] += d;
+		m_state[4] += e;
+		m_state[5] += f;
+		m_state[6] += g;
+		m_state[7] += h;
+	}
+}
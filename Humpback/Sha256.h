@@ -0,0 +1,38 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <cstdint>
+
+
+namespace Humpback
+{
+	// FIPS 180-4 SHA-256, used to key cached assets by content.
+	class Sha256
+	{
+	public:
+
+		using Digest = std::array<uint8_t, 32>;
+
+		Sha256();
+
+		void Update(const void* data, size_t size);
+		void Update(const std::string& text) { Update(text.data(), text.size()); }
+		Digest Finish();
+
+		static std::string ToHex(const Digest& digest);
+
+	private:
+
+		void _processBlock(const uint8_t* block);
+
+		uint32_t m_state[8];
+		uint8_t m_buffer[64];
+		size_t m_bufferSize = 0;
+		uint64_t m_totalSize = 0;
+	};
+}
@@ -21,11 +21,12 @@ cbuffer cbSSAO : register(b0)
 cbuffer cbRootConstants : register(b1)
 {
     bool _HorizontalBlur;
+    uint _NormalMapIndex;
+    uint _DepthMapIndex;
+    uint _InputMapIndex;
 };
 
-Texture2D _NormalMap : register(t0);
-Texture2D _DepthMap : register(t1);
-Texture2D _InputMap : register(t2);
+Texture2D _Textures[] : register(t0, space2);
 
 
 SamplerState _PointClampSampler : register(s0);
@@ -86,11 +87,11 @@ float4 PS(VertexOut pin) : SV_Target
         texOffset = float2(0.0f, _PixelSize.y);
     }
 
-    float4 color = blurWeights[_BlurRadius] * _InputMap.SampleLevel(_PointClampSampler, pin.uv, 0.0);
+    float4 color = blurWeights[_BlurRadius] * _Textures[_InputMapIndex].SampleLevel(_PointClampSampler, pin.uv, 0.0);
     float totalWeights = blurWeights[_BlurRadius];
 
-    float3 centerNormal = _NormalMap.SampleLevel(_PointClampSampler, pin.uv, 0.0f).xyz;
-    float depth = _DepthMap.SampleLevel(_DepthSampler, pin.uv, 0.0f).r;
+    float3 centerNormal = _Textures[_NormalMapIndex].SampleLevel(_PointClampSampler, pin.uv, 0.0f).xyz;
+    float depth = _Textures[_DepthMapIndex].SampleLevel(_DepthSampler, pin.uv, 0.0f).r;
     float linearDepth = NDC2LinearDepth(depth);
 
     for(float i = -_BlurRadius; i <= _BlurRadius; ++i)
@@ -102,16 +103,16 @@ float4 PS(VertexOut pin) : SV_Target
 
         float2 tex = pin.uv + i * texOffset;
 
-        float3 neighborNormal = _NormalMap.SampleLevel(_PointClampSampler, tex, 0.0f).xyz;
+        float3 neighborNormal = _Textures[_NormalMapIndex].SampleLevel(_PointClampSampler, tex, 0.0f).xyz;
         float neighborLinearDepth = NDC2LinearDepth(
-            _DepthMap.SampleLevel(_DepthSampler, tex, 0.0).r
+            _Textures[_DepthMapIndex].SampleLevel(_DepthSampler, tex, 0.0).r
         );
 
         // Discard samples if they are deffer too much in normal and depth.
         if(dot(neighborNormal, centerNormal) >= 0.8 && abs(neighborLinearDepth - linearDepth) <= 0.2)
         {
             float weight = blurWeights[i + _BlurRadius];
-            color += weight * _InputMap.SampleLevel(_PointClampSampler, tex, 0.0);
+            color += weight * _Textures[_InputMapIndex].SampleLevel(_PointClampSampler, tex, 0.0);
             totalWeights += weight;
         }
     }
@@ -5,6 +5,9 @@
 #include "Lighting.hlsl"
 
 
+// ShadowCascades::MAX_CASCADES on the CPU.
+#define MaxShadowCascades 4
+
 SamplerState _SamplerPointWrap : register(s0);
 SamplerState _SamplerPointClamp : register(s1);
 SamplerState _SamplerLinearWrap : register(s2);
@@ -24,27 +27,27 @@ struct MaterialData
 };
 
 
-cbuffer cbPerObject : register(b0)
+struct ObjectData
 {
-    float4x4 _World;
-    uint _MatIndex;
+    float4x4 world;
+    float3 positionScale;   // Packed positions are offset + unorm * scale in object space.
+    uint materialIndex;
+    float3 positionOffset;
     uint pad0;
-    uint pad1;
-    uint pad2;
 };
 
+StructuredBuffer<MaterialData> _MaterialDataBuffer : register(t0, space1);
 
-//struct InstanceData
-//{
-//    float4x4 world;
-//    uint materialIndex;
-//    uint pad0;
-//    uint pad1;
-//    uint pad2;
-//};
+// Object ids, bound at the first instance of the current draw, so SV_InstanceID indexes it directly.
+StructuredBuffer<uint> _InstanceBuffer : register(t1, space1);
 
-//StructuredBuffer<InstanceData> gInstanceBuffer : register(t0, space1);
-StructuredBuffer<MaterialData> _MaterialDataBuffer : register(t0, space1);
+// One record per object, rewritten only when the object changes.
+StructuredBuffer<ObjectData> _ObjectBuffer : register(t2, space1);
+
+ObjectData GetObjectData(uint instanceID)
+{
+    return _ObjectBuffer[_InstanceBuffer[instanceID]];
+}
 
 cbuffer cbPass : register(b1)
 {
@@ -54,7 +57,7 @@ cbuffer cbPass : register(b1)
     float4x4 _InvProj;
     float4x4 _ViewProj;
     float4x4 _InvViewProj;
-    float4x4 _ShadowVPT;
+    float4x4 _ShadowVPT[MaxShadowCascades];
     float4x4 _ViewProjTex;
     float3 _EyePosW;
     float _PerObjectPad1;
@@ -67,25 +70,98 @@ cbuffer cbPass : register(b1)
     float4 _AmbientLight;
     
     Light _lights[MaxLights];
+
+    uint _SkyCubeMapIndex;
+    uint _ShadowMapIndex;
+    uint _SsaoMapIndex;
+    uint _ShadowCascadeCount;
+
+    // Far view depth of each cascade. Past the last cascade the entries repeat its split.
+    float4 _ShadowCascadeSplits;
+};
+
+// Every SRV lives in one bindless heap, materials and passes carry indices into these arrays.
+Texture2D _Textures[] : register(t0, space2);
+TextureCube _CubeTextures[] : register(t0, space3);
+Texture2DArray _TextureArrays[] : register(t0, space4);
+
+
+// Mesh vertices as the input assembler delivers them. The renderer defines PACKED_VERTEX when the meshes
+// are uploaded as PackedVertex (VertexPacking.h), DecodeMeshVertex hides the difference.
+#if PACKED_VERTEX
+typedef float4 MeshPosition;    // Unorm inside the submesh bounds, w is the tangent sign.
+#else
+typedef float3 MeshPosition;
+#endif
+
+struct MeshVertexIn
+{
+    MeshPosition pos : POSITION;
+#if PACKED_VERTEX
+    float2 normal : NORMAL;     // Octahedral.
+    float2 uv : TEXCOORD;
+    float2 tangent : TANGENT;   // Octahedral.
+#else
+    float3 normal : NORMAL;
+    float2 uv : TEXCOORD;
+    float3 tangent : TANGENT;
+#endif
 };
 
-TextureCube _SkyCubeMap : register(t0);
-Texture2D _ShadowMap : register(t1);
+struct MeshVertex
+{
+    float3 posL;
+    float3 normal;
+    float2 uv;
+    float4 tangent;     // w is the sign of the bitangent.
+};
+
+float3 DecodeOctahedral(float2 e)
+{
+    float3 n = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+float3 DecodeMeshPosition(MeshPosition pos, ObjectData instData)
+{
+#if PACKED_VERTEX
+    return instData.positionOffset + pos.xyz * instData.positionScale;
+#else
+    return pos;
+#endif
+}
 
-Texture2D _SsaoMap : register(t2);
-Texture2D _DiffuseMapArray[10] : register(t3);
+MeshVertex DecodeMeshVertex(MeshVertexIn vin, ObjectData instData)
+{
+    MeshVertex v;
+    v.posL = DecodeMeshPosition(vin.pos, instData);
+    v.uv = vin.uv;
+#if PACKED_VERTEX
+    v.normal = DecodeOctahedral(vin.normal);
+    v.tangent = float4(DecodeOctahedral(vin.tangent), vin.pos.w * 2.0f - 1.0f);
+#else
+    v.normal = vin.normal;
+    v.tangent = float4(vin.tangent, 1.0f);
+#endif
+    return v;
+}
 
 
-float3 UnpackNormal(float3 normalMapSample, float3 unitNormalW, float3 tangentW)
+// tangentW.w is the sign of the bitangent.
+float3 UnpackNormal(float3 normalMapSample, float3 unitNormalW, float4 tangentW)
 {
     float3 result = 0;
     
     // Scale normal frome [0, 1] - [-1, 1];
     result = normalMapSample * 2.0f - 1.0f;
+    // BC5 normal maps only store X and Y.
+    result.z = sqrt(saturate(1.0f - dot(result.xy, result.xy)));
     
     float3 N = unitNormalW;
-    float3 T = normalize(tangentW - dot(tangentW, N) * N);
-    float3 B = cross(N, T);
+    float3 T = normalize(tangentW.xyz - dot(tangentW.xyz, N) * N);
+    float3 B = cross(N, T) * tangentW.w;
     
     // Transform normal from TBN space to world sapce.
     float3x3 tbn2World = float3x3(T, B, N);
@@ -94,31 +170,40 @@ float3 UnpackNormal(float3 normalMapSample, float3 unitNormalW, float3 tangentW)
     return result;
 }
 
-float CalShadowFactor(float4 posH)
+// The cascade is picked by the view depth of the point, points past the last cascade are lit.
+float CalShadowFactor(float3 posW)
 {
-    posH.xyz /= posH.w;
-    
-    float depth = posH.z;
-    uint width, height, mipsCount;
-    _ShadowMap.GetDimensions(0, width, height, mipsCount);
-    
-    float dx = 1.0f / width;    // Texel size.
-    
-    const float2 offsets[9] =
+    float viewDepth = mul(float4(posW, 1.0f), _View).z;
+    uint cascade = (uint)dot((float4)(viewDepth > _ShadowCascadeSplits), 1.0f);
+    if (cascade >= _ShadowCascadeCount)
     {
-        float2(-dx, -dx), float2(0.0f, -dx), float2(dx, -dx),
-        float2(-dx, 0.0f), float2(0.0f, 0.0f), float2(dx, 0.0f),
-        float2(dx, -dx), float2(dx, dx), float2(0.0f, dx)
-    };
-    
+        return 1.0f;
+    }
+
+    float4x4 shadowVPT = _ShadowVPT[cascade];
+    float3 posT = mul(float4(posW, 1.0f), shadowVPT).xyz;
+
+    uint width, height, elements, mipsCount;
+    Texture2DArray shadowMap = _TextureArrays[_ShadowMapIndex];
+    shadowMap.GetDimensions(0, width, height, elements, mipsCount);
+
+    float dx = 1.0f / width;    // Texel size.
+
+    // Cascades cover different depth ranges, so the bias is two texels in world space converted to depth.
+    float texelWorld = dx / length(shadowVPT._11_21_31);
+    float bias = 2.0f * texelWorld * length(shadowVPT._13_23_33);
+
     float shadowFactor = 0.0f;
-    
-    float bias = 0.004f;
-    
+
     [unroll]
-    for (int i = 0; i < 9; ++i)
+    for (int y = -1; y <= 1; ++y)
     {
-        shadowFactor += _ShadowMap.SampleCmpLevelZero(_SamplerShadow, posH.xy + offsets[i], posH.z - bias).r;
+        [unroll]
+        for (int x = -1; x <= 1; ++x)
+        {
+            float3 uv = float3(posT.xy + float2(x, y) * dx, cascade);
+            shadowFactor += shadowMap.SampleCmpLevelZero(_SamplerShadow, uv, posT.z - bias).r;
+        }
     }
 
     return shadowFactor / 9.0f;
@@ -5,14 +5,6 @@
 #include "Common.hlsl"
 
 
-struct VertexIn
-{
-    float3 pos : POSITION;
-    float3 normal : NORMAL;
-    float2 uv : TEXCOORD0;
-    float3 tangentU : TANGENT;
-};
-
 struct VertexOut
 {
     float4 posCS : SV_Position;
@@ -21,17 +13,21 @@ struct VertexOut
     float2 uv : TEXCOORD0;
 };
 
-VertexOut VS(VertexIn i)
+VertexOut VS(MeshVertexIn vin, uint instanceID : SV_InstanceID)
 {
     VertexOut o;
     
-    o.posCS = mul(float4(i.pos, 1.0), _World);
+    ObjectData instData = GetObjectData(instanceID);
+    float4x4 world = instData.world;
+    MeshVertex i = DecodeMeshVertex(vin, instData);
+    
+    o.posCS = mul(float4(i.posL, 1.0), world);
     o.posCS = mul(o.posCS, _ViewProj);
     
     o.uv = i.uv;
     
-    o.normalWS = mul(i.normal, (float3x3) _World);
-    o.tangentWS = mul(i.tangentU, (float3x3) _World);
+    o.normalWS = mul(i.normal, (float3x3) world);
+    o.tangentWS = mul(i.tangent.xyz, (float3x3) world);
     
     return o;
 }
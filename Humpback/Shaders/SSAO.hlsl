@@ -18,9 +18,15 @@ cbuffer cbSSAO : register(b0)
     float _OcclusionFadeEnd;
 }
 
-Texture2D _NormalMap : register(t0);
-Texture2D _DepthTexture : register(t1);
-Texture2D _RandomVectorMap : register(t2);
+cbuffer cbRootConstants : register(b1)
+{
+    bool _HorizontalBlur;
+    uint _NormalMapIndex;
+    uint _DepthMapIndex;
+    uint _RandomVectorMapIndex;
+};
+
+Texture2D _Textures[] : register(t0, space2);
 
 SamplerState _SamplerPointClamp : register(s0);
 SamplerState _SamplerDepthClamp : register(s1);
@@ -88,8 +94,8 @@ float4 PS(VSOut i) : SV_Target
     float2 screen_uv = i.texC;
 
     
-    float3 n = normalize(_NormalMap.Sample(_SamplerPointClamp, i.texC).xyz);    // View space normal.
-    float z = _DepthTexture.Sample(_SamplerDepthClamp, i.texC).r;   // NDC depth.
+    float3 n = normalize(_Textures[_NormalMapIndex].Sample(_SamplerPointClamp, i.texC).xyz);    // View space normal.
+    float z = _Textures[_DepthMapIndex].Sample(_SamplerDepthClamp, i.texC).r;   // NDC depth.
     z = NDCDepth2ViewDepth(z);
     
     // Conclude view space postion from position on the near plane.
@@ -98,7 +104,7 @@ float4 PS(VSOut i) : SV_Target
     // t = pView.z / pNearPlane.z
     float3 p = (z / i.posV.z) * i.posV;
     
-    float3 randomV = _RandomVectorMap.Sample(_SamplerLinearWrap, screen_uv).rgb;
+    float3 randomV = _Textures[_RandomVectorMapIndex].Sample(_SamplerLinearWrap, screen_uv).rgb;
     randomV = 2.0f * randomV - 1.0f;
     
     float occlusionSum = 0.0f;
@@ -113,7 +119,7 @@ float4 PS(VSOut i) : SV_Target
         float4 samp_texPos = mul(float4(samp_vPos, 1.0f), _ProjTex);
         samp_texPos.xyz /= samp_texPos.w;
         
-        float samp_depth = _DepthTexture.Sample(_SamplerDepthClamp, samp_texPos.xy).r;
+        float samp_depth = _Textures[_DepthMapIndex].Sample(_SamplerDepthClamp, samp_texPos.xy).r;
         samp_depth = NDCDepth2ViewDepth(samp_depth);
         
         // Reconstruct the point on real scene geometry corresponding to the sample point.
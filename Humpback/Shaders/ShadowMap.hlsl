@@ -6,13 +6,14 @@
 
 struct VSIN
 {
-    float3 pos : POSITION;
+    MeshPosition pos : POSITION;
 };
 
 
-float4 VS(VSIN vsin) : SV_POSITION
+float4 VS(VSIN vsin, uint instanceID : SV_InstanceID) : SV_POSITION
 {
-    float4 posW = mul(float4(vsin.pos, 1.0f), _World);
+    ObjectData instData = GetObjectData(instanceID);
+    float4 posW = mul(float4(DecodeMeshPosition(vsin.pos, instData), 1.0f), instData.world);
     float4 posH = mul(posW, _ViewProj);
     
 	return posH;
@@ -5,18 +5,9 @@
 #include "Common.hlsl"
 
 
-struct VertexIn
-{
-    float3 posL  : POSITION;
-    float3 normal : NORMAL;
-    float2 uv : TEXCOORD;
-    float3 tangent : TANGENT;
-};
-
 struct VertexOut
 {
     float4 posH  : SV_POSITION;
-    float4 shadowPosCS : POSITION0;
     float4 ssaoPosCS : POSITION1;
     float3 posW : POSITION2;
     float3 normal : NORMAL;
@@ -26,23 +17,25 @@ struct VertexOut
     nointerpolation uint matIdx : MATINDEX;
 };
 
-VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
+VertexOut VS(MeshVertexIn vin, uint instanceID : SV_InstanceID)
 {
     VertexOut vout;
     
+    ObjectData instData = GetObjectData(instanceID);
+    MeshVertex v = DecodeMeshVertex(vin, instData);
+    
     // Transform to homogeneous clip space.
-    float4 posW = mul(float4(vin.posL, 1.0f), _World);
+    float4 posW = mul(float4(v.posL, 1.0f), instData.world);
     vout.posW = posW.xyz;
     vout.posH = mul(posW, _ViewProj);
-    vout.shadowPosCS = mul(posW, _ShadowVPT);
     vout.ssaoPosCS = mul(posW, _ViewProjTex);
     
-    vout.tangent = mul(float4(vin.tangent, 0.0f), _World).xyz;
+    vout.tangent = mul(float4(v.tangent.xyz, 0.0f), instData.world).xyz;
 
-    vout.normal = mul(vin.normal, (float3x3)_World);
-    vout.uv = vin.uv;
+    vout.normal = mul(v.normal, (float3x3)instData.world);
+    vout.uv = v.uv;
     
-    vout.matIdx = _MatIndex;
+    vout.matIdx = instData.materialIndex;
 
     return vout;
 }
@@ -5,26 +5,20 @@
 #include "Common.hlsl"
 
 
-struct VertexIn
-{
-    float3 posL : POSITION;
-    float3 normalL : NORMAL;
-    float2 uv : TEXCOORD;
-};
-
 struct VertexOut
 {
     float4 posH : SV_POSITION;
     float3 posL : POSITION;
 };
 
-VertexOut VS(VertexIn vsIn)
+VertexOut VS(MeshVertexIn vsIn, uint instanceID : SV_InstanceID)
 {
     VertexOut vsOut;
     
-    vsOut.posL = vsIn.posL;
+    ObjectData instData = GetObjectData(instanceID);
+    vsOut.posL = DecodeMeshPosition(vsIn.pos, instData);
     
-    float4 posW = mul(float4(vsIn.posL, 1.0f), _World);
+    float4 posW = mul(float4(vsOut.posL, 1.0f), instData.world);
     
     posW.xyz += _EyePosW;
     
@@ -36,5 +30,5 @@ VertexOut VS(VertexIn vsIn)
 
 float4 PS(VertexOut psIn) : SV_Target
 {
-    return _SkyCubeMap.Sample(_SamplerLinearWrap, psIn.posL);
+    return _CubeTextures[_SkyCubeMapIndex].Sample(_SamplerLinearWrap, psIn.posL);
 }
\ No newline at end of file
@@ -5,44 +5,38 @@
 #include "Common.hlsl"
 
 
-struct VertexIn
-{
-    float3 posL : POSITION;
-    float3 normal : NORMAL;
-    float2 uv : TEXCOORD;
-    float3 tangent : TANGENT;
-};
-
 struct VertexOut
 {
     float4 posH : SV_POSITION;
-    float4 shadowPosCS : POSITION0;
     float4 ssaoPosCS : POSITION1;
     float3 posW : POSITION2;
     float3 normal : NORMAL;
     float2 uv : TEXCOORD;
-    float3 tangent : TANGENT;
+    float4 tangent : TANGENT;
     
     nointerpolation uint matIdx : MATINDEX;
 };
 
-VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
+VertexOut VS(MeshVertexIn vin, uint instanceID : SV_InstanceID)
 {
     VertexOut vout;
     
+    ObjectData instData = GetObjectData(instanceID);
+    float4x4 world = instData.world;
+    MeshVertex v = DecodeMeshVertex(vin, instData);
+    
     // Transform to homogeneous clip space.
-    float4 posW = mul(float4(vin.posL, 1.0f), _World);
+    float4 posW = mul(float4(v.posL, 1.0f), world);
     vout.posW = posW.xyz;
     vout.posH = mul(posW, _ViewProj);
-    vout.shadowPosCS = mul(posW, _ShadowVPT);
     vout.ssaoPosCS = mul(posW, _ViewProjTex);
     
-    vout.tangent = mul(float4(vin.tangent, 0.0f), _World).xyz;
+    vout.tangent = float4(mul(float4(v.tangent.xyz, 0.0f), world).xyz, v.tangent.w);
 
-    vout.normal = mul(vin.normal, (float3x3) _World);
-    vout.uv = vin.uv;
+    vout.normal = mul(v.normal, (float3x3) world);
+    vout.uv = v.uv;
     
-    vout.matIdx = _MatIndex;
+    vout.matIdx = instData.materialIndex;
 
     return vout;
 }
@@ -51,15 +45,15 @@ float4 PS(VertexOut pin) : SV_Target
 {
     MaterialData matData = _MaterialDataBuffer[pin.matIdx];
 
-    float3 albedo = _DiffuseMapArray[matData.diffuseMapIndex].Sample(_SamplerLinearWrap, pin.uv);
+    float3 albedo = _Textures[NonUniformResourceIndex(matData.diffuseMapIndex)].Sample(_SamplerLinearWrap, pin.uv);
     albedo *= matData.albedo;
-    float4 metallicSmothness = _DiffuseMapArray[matData.metallicSmothnessMapIndex].Sample(_SamplerLinearWrap, pin.uv);
+    float4 metallicSmothness = _Textures[NonUniformResourceIndex(matData.metallicSmothnessMapIndex)].Sample(_SamplerLinearWrap, pin.uv);
     float smoothness = metallicSmothness.a;
     float metallic = metallicSmothness.r;
     BRDFData brdfData = InitializeBRDFData(albedo, metallic, smoothness);
     Light mainLight = GetMainLight();
-    float shadowFactor = CalShadowFactor(pin.shadowPosCS);
-    float4 normalSample = _DiffuseMapArray[matData.normalMapIndex].Sample(_SamplerLinearWrap, pin.uv);
+    float shadowFactor = CalShadowFactor(pin.posW);
+    float4 normalSample = _Textures[NonUniformResourceIndex(matData.normalMapIndex)].Sample(_SamplerLinearWrap, pin.uv);
     pin.normal = normalize(pin.normal);
     normalSample.xyz = UnpackNormal(normalSample.xyz, pin.normal, pin.tangent);
     float3 eyeDir = normalize(_EyePosW - pin.posW);
@@ -67,7 +61,7 @@ float4 PS(VertexOut pin) : SV_Target
     float3 directLight = LightingPhysicallyBased(brdfData, mainLight, shadowFactor, normalSample.xyz, eyeDir);
 
     float2 uvAO = pin.ssaoPosCS / pin.ssaoPosCS.w;
-    float ao = _SsaoMap.Sample(_SamplerLinearWrap, uvAO).r;
+    float ao = _Textures[_SsaoMapIndex].Sample(_SamplerLinearWrap, uvAO).r;
 
     float3 ambient = _AmbientLight.rgb * albedo.rgb * ao;
 
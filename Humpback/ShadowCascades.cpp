@@ -0,0 +1,147 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
+#include "ShadowCascades.h"
+
+
+using namespace DirectX;
+
+
+namespace Humpback
+{
+	namespace
+	{
+		// Border texels left around the sphere: one for snapping the projection, one for the filter kernel.
+		const unsigned int BORDER_TEXELS = 2;
+
+		XMMATRIX GetLightView(FXMVECTOR lightDir)
+		{
+			// Fixed for a light direction, so the texel grid only moves with the projection.
+			XMVECTOR up = std::fabs(XMVectorGetY(lightDir)) > 0.99f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+			return XMMatrixLookToLH(XMVectorZero(), lightDir, up);
+		}
+	}
+
+
+	ShadowCascades::ShadowCascades(unsigned int resolution, unsigned int cascadeCount)
+		: m_resolution(resolution)
+	{
+		if (resolution <= 2 * BORDER_TEXELS || resolution % 2 != 0)
+		{
+			throw std::runtime_error("ShadowCascades: Resolution has to be even and larger than the border.");
+		}
+
+		SetCascadeCount(cascadeCount);
+	}
+
+	void ShadowCascades::SetCascadeCount(unsigned int count)
+	{
+		if (count == 0 || count > MAX_CASCADES)
+		{
+			throw std::runtime_error("ShadowCascades: Cascade count is out of range.");
+		}
+
+		m_cascadeCount = count;
+	}
+
+	void ShadowCascades::Update(FXMMATRIX view, CXMMATRIX proj, float nearZ, float farZ,
+		FXMVECTOR lightDir, const BoundingBox& casterBounds)
+	{
+		XMFLOAT4X4 projection;
+		XMStoreFloat4x4(&projection, proj);
+		float tanHalfFovX = 1.0f / projection._11;
+		float tanHalfFovY = 1.0f / projection._22;
+
+		XMMATRIX invView = XMMatrixInverse(nullptr, view);
+		XMVECTOR direction = XMVector3Normalize(lightDir);
+
+		float splits[MAX_CASCADES + 1];
+		ComputeSplits(nearZ, std::min(farZ, m_shadowDistance), m_cascadeCount, m_splitLambda, splits);
+
+		for (unsigned int i = 0; i < m_cascadeCount; ++i)
+		{
+			BoundingSphere sphere = GetSliceSphere(invView, tanHalfFovX, tanHalfFovY, splits[i], splits[i + 1]);
+
+			m_cascades[i] = FitCascade(sphere, direction, m_resolution, casterBounds);
+			m_cascades[i].splitNear = splits[i];
+			m_cascades[i].splitFar = splits[i + 1];
+		}
+	}
+
+	void ShadowCascades::ComputeSplits(float nearZ, float farZ, unsigned int count, float lambda, float* splits)
+	{
+		splits[0] = nearZ;
+		for (unsigned int i = 1; i < count; ++i)
+		{
+			float t = (float)i / (float)count;
+			float logSplit = nearZ * std::pow(farZ / nearZ, t);
+			float uniformSplit = nearZ + (farZ - nearZ) * t;
+			splits[i] = lambda * logSplit + (1.0f - lambda) * uniformSplit;
+		}
+		splits[count] = farZ;
+	}
+
+	BoundingSphere ShadowCascades::GetSliceSphere(FXMMATRIX invView, float tanHalfFovX, float tanHalfFovY,
+		float sliceNear, float sliceFar)
+	{
+		// A corner at view depth z is k * z away from the view axis. The center lies on the axis where the near
+		// and the far corners are equally far away, or on the far plane when the slice is wider than deep.
+		float k2 = tanHalfFovX * tanHalfFovX + tanHalfFovY * tanHalfFovY;
+		float centerZ = 0.5f * (sliceNear + sliceFar) * (1.0f + k2);
+		float radius = 0.0f;
+		if (centerZ >= sliceFar)
+		{
+			centerZ = sliceFar;
+			radius = std::sqrt(k2) * sliceFar;
+		}
+		else
+		{
+			radius = std::sqrt((sliceFar - centerZ) * (sliceFar - centerZ) + k2 * sliceFar * sliceFar);
+		}
+
+		BoundingSphere sphere;
+		XMStoreFloat3(&sphere.Center, XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, centerZ, 1.0f), invView));
+		sphere.Radius = radius;
+		return sphere;
+	}
+
+	ShadowCascade ShadowCascades::FitCascade(const BoundingSphere& sphere, FXMVECTOR lightDir,
+		unsigned int resolution, const BoundingBox& casterBounds)
+	{
+		XMMATRIX lightView = GetLightView(lightDir);
+
+		XMFLOAT3 center;
+		XMStoreFloat3(&center, XMVector3TransformCoord(XMLoadFloat3(&sphere.Center), lightView));
+
+		// The resolution is even, so half the width is a whole number of texels and the edges of a snapped
+		// center stay on the texel grid.
+		float texelSize = 2.0f * sphere.Radius / (float)(resolution - 2 * BORDER_TEXELS);
+		float halfWidth = 0.5f * (float)resolution * texelSize;
+		float centerX = std::floor(center.x / texelSize) * texelSize;
+		float centerY = std::floor(center.y / texelSize) * texelSize;
+
+		// Casters between the light and the sphere have to land in the depth range too.
+		XMFLOAT3 corners[BoundingBox::CORNER_COUNT];
+		casterBounds.GetCorners(corners);
+
+		float nearZ = center.z - sphere.Radius;
+		for (const XMFLOAT3& corner : corners)
+		{
+			nearZ = std::min(nearZ, XMVectorGetZ(XMVector3TransformCoord(XMLoadFloat3(&corner), lightView)));
+		}
+		float farZ = center.z + sphere.Radius;
+
+		ShadowCascade cascade;
+		XMStoreFloat4x4(&cascade.view, lightView);
+		XMStoreFloat4x4(&cascade.proj, XMMatrixOrthographicOffCenterLH(centerX - halfWidth, centerX + halfWidth,
+			centerY - halfWidth, centerY + halfWidth, nearZ, farZ));
+		cascade.texelSize = texelSize;
+		return cascade;
+	}
+}
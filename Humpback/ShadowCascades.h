@@ -0,0 +1,81 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+
+namespace Humpback
+{
+	struct ShadowCascade
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 proj;
+
+		// Camera view depth range the cascade is used for.
+		float splitNear = 0.0f;
+		float splitFar = 0.0f;
+
+		// World space size of a shadow map texel.
+		float texelSize = 0.0f;
+	};
+
+
+	// Fits the cascades of a directional light's shadow map to slices of the camera frustum.
+	//
+	// Every slice is bounded by a sphere that depends only on the slice depths and the lens, so turning the
+	// camera doesn't change the size of a cascade. The projection is moved in whole shadow map texels, so
+	// moving the camera doesn't make shadow edges crawl either. Only CPU math, no device needed.
+	class ShadowCascades
+	{
+	public:
+
+		static const unsigned int MAX_CASCADES = 4;
+
+		explicit ShadowCascades(unsigned int resolution, unsigned int cascadeCount = MAX_CASCADES);
+
+		void SetCascadeCount(unsigned int count);
+		unsigned int GetCascadeCount() const { return m_cascadeCount; }
+
+		// 0 splits the depth range uniformly, 1 logarithmically.
+		void SetSplitLambda(float lambda) { m_splitLambda = lambda; }
+		float GetSplitLambda() const { return m_splitLambda; }
+
+		// The last cascade ends here or at the camera far plane, whichever is nearer.
+		void SetShadowDistance(float distance) { m_shadowDistance = distance; }
+		float GetShadowDistance() const { return m_shadowDistance; }
+
+		unsigned int GetResolution() const { return m_resolution; }
+
+		// Fits every cascade to the camera. proj is a perspective projection, lightDir points from the light
+		// into the scene, and the near plane of each cascade is pulled back to include casterBounds.
+		void Update(DirectX::FXMMATRIX view, DirectX::CXMMATRIX proj, float nearZ, float farZ,
+			DirectX::FXMVECTOR lightDir, const DirectX::BoundingBox& casterBounds);
+
+		const ShadowCascade& GetCascade(unsigned int index) const { return m_cascades[index]; }
+
+		// Practical split scheme: each split distance blends the logarithmic and the uniform split by lambda.
+		// Writes count + 1 distances, from nearZ to farZ.
+		static void ComputeSplits(float nearZ, float farZ, unsigned int count, float lambda, float* splits);
+
+		// Smallest sphere around the slice of a symmetric perspective frustum between two view depths.
+		static DirectX::BoundingSphere GetSliceSphere(DirectX::FXMMATRIX invView, float tanHalfFovX, float tanHalfFovY,
+			float sliceNear, float sliceFar);
+
+		// Orthographic projection looking along lightDir with the sphere inside it, snapped to texels.
+		static ShadowCascade FitCascade(const DirectX::BoundingSphere& sphere, DirectX::FXMVECTOR lightDir,
+			unsigned int resolution, const DirectX::BoundingBox& casterBounds);
+
+	private:
+
+		unsigned int m_resolution = 0;
+		unsigned int m_cascadeCount = MAX_CASCADES;
+		float m_splitLambda = 0.75f;
+		float m_shadowDistance = 150.0f;
+
+		ShadowCascade m_cascades[MAX_CASCADES];
+	};
+}
@@ -9,10 +9,11 @@ namespace Humpback
 {
     void ThrowIfFailed(HRESULT hr);
 
-    ShadowMap::ShadowMap(ID3D12Device* device, unsigned int width, unsigned int height)
+    ShadowMap::ShadowMap(ID3D12Device* device, unsigned int width, unsigned int height, unsigned int arraySize)
     {
         m_width = width;
         m_height = height;
+        m_arraySize = arraySize;
 
         m_device = device;
 
@@ -32,6 +33,11 @@ namespace Humpback
         return m_height;
     }
 
+    unsigned int ShadowMap::ArraySize() const
+    {
+        return m_arraySize;
+    }
+
     D3D12_VIEWPORT ShadowMap::GetViewPort() const
     {
         return m_viewPort;
@@ -47,9 +53,9 @@ namespace Humpback
         return m_gpuSRVHandle;
     }
 
-    CD3DX12_CPU_DESCRIPTOR_HANDLE ShadowMap::DSV() const
+    CD3DX12_CPU_DESCRIPTOR_HANDLE ShadowMap::DSV(unsigned int slice) const
     {
-        return m_cpuDSVHandle;
+        return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_cpuDSVHandle, (INT)slice, m_dsvDescriptorSize);
     }
 
     ID3D12Resource* ShadowMap::Resource()
@@ -57,11 +63,13 @@ namespace Humpback
         return m_shadowMap.Get();
     }
 
-    void ShadowMap::BuildDescriptors(CD3DX12_CPU_DESCRIPTOR_HANDLE cpuSRVHandle, CD3DX12_GPU_DESCRIPTOR_HANDLE gpuSRVHandle, CD3DX12_CPU_DESCRIPTOR_HANDLE cpuDSVHandle)
+    void ShadowMap::BuildDescriptors(CD3DX12_CPU_DESCRIPTOR_HANDLE cpuSRVHandle, CD3DX12_GPU_DESCRIPTOR_HANDLE gpuSRVHandle, CD3DX12_CPU_DESCRIPTOR_HANDLE cpuDSVHandle,
+        unsigned int dsvDescriptorSize)
     {
         m_cpuSRVHandle = cpuSRVHandle;
         m_gpuSRVHandle = gpuSRVHandle;
         m_cpuDSVHandle = cpuDSVHandle;
+        m_dsvDescriptorSize = dsvDescriptorSize;
 
         _buildDescriptors();
     }
@@ -87,7 +95,7 @@ namespace Humpback
         smDesc.Format = m_format;
         smDesc.MipLevels = 1;
         smDesc.Alignment = 0;
-        smDesc.DepthOrArraySize = 1;
+        smDesc.DepthOrArraySize = (UINT16)m_arraySize;
         smDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
         smDesc.Width = m_width;
         smDesc.Height = m_height;
@@ -111,18 +119,25 @@ namespace Humpback
         D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
         srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
         srvDesc.Format = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
-        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-        srvDesc.Texture2D.MostDetailedMip = 0;
-        srvDesc.Texture2D.MipLevels = 1;
-        srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-        srvDesc.Texture2D.PlaneSlice = 0;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+        srvDesc.Texture2DArray.MostDetailedMip = 0;
+        srvDesc.Texture2DArray.MipLevels = 1;
+        srvDesc.Texture2DArray.FirstArraySlice = 0;
+        srvDesc.Texture2DArray.ArraySize = m_arraySize;
+        srvDesc.Texture2DArray.PlaneSlice = 0;
+        srvDesc.Texture2DArray.ResourceMinLODClamp = 0.0f;
         m_device->CreateShaderResourceView(m_shadowMap.Get(), &srvDesc, m_cpuSRVHandle);
 
-        D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc;
-        dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
-        dsvDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-        dsvDesc.Texture2D.MipSlice = 0;
-        dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-        m_device->CreateDepthStencilView(m_shadowMap.Get(), &dsvDesc, m_cpuDSVHandle);
+        for (unsigned int slice = 0; slice < m_arraySize; ++slice)
+        {
+            D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc;
+            dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
+            dsvDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+            dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2DARRAY;
+            dsvDesc.Texture2DArray.MipSlice = 0;
+            dsvDesc.Texture2DArray.FirstArraySlice = slice;
+            dsvDesc.Texture2DArray.ArraySize = 1;
+            m_device->CreateDepthStencilView(m_shadowMap.Get(), &dsvDesc, DSV(slice));
+        }
     }
 }
\ No newline at end of file
@@ -9,11 +9,12 @@
 
 namespace Humpback
 {
+	// A depth texture array, one slice per shadow cascade. The SRV covers the whole array, every slice has its DSV.
 	class ShadowMap
 	{
 	public:
 
-		ShadowMap(ID3D12Device* device, unsigned int width, unsigned int height);
+		ShadowMap(ID3D12Device* device, unsigned int width, unsigned int height, unsigned int arraySize = 1);
 		~ShadowMap() = default;
 
 		ShadowMap(const ShadowMap& rhs) = delete;
@@ -21,19 +22,21 @@ namespace Humpback
 
 		unsigned int Width() const;
 		unsigned int Height() const;
+		unsigned int ArraySize() const;
 
 		D3D12_VIEWPORT GetViewPort() const;
 		D3D12_RECT GetScissorRect() const;
 
 		CD3DX12_GPU_DESCRIPTOR_HANDLE SRV() const;
-		CD3DX12_CPU_DESCRIPTOR_HANDLE DSV() const;
+		CD3DX12_CPU_DESCRIPTOR_HANDLE DSV(unsigned int slice = 0) const;
 
 		ID3D12Resource* Resource();
 
 		void BuildDescriptors(
 			CD3DX12_CPU_DESCRIPTOR_HANDLE cpuSRVHandle,
 			CD3DX12_GPU_DESCRIPTOR_HANDLE gpuSRVHandle,
-			CD3DX12_CPU_DESCRIPTOR_HANDLE cpuDSVHandle
+			CD3DX12_CPU_DESCRIPTOR_HANDLE cpuDSVHandle,	// ArraySize() consecutive descriptors.
+			unsigned int dsvDescriptorSize
 		);
 
 		void OnResize(unsigned int newWidth, unsigned int newHeight);
@@ -47,6 +50,7 @@ namespace Humpback
 
 		unsigned int m_width = 0;
 		unsigned int m_height = 0;
+		unsigned int m_arraySize = 1;
 
 		D3D12_VIEWPORT m_viewPort;
 		D3D12_RECT m_scissorRect;
@@ -56,6 +60,7 @@ namespace Humpback
 		CD3DX12_CPU_DESCRIPTOR_HANDLE m_cpuSRVHandle;
 		CD3DX12_GPU_DESCRIPTOR_HANDLE m_gpuSRVHandle;
 		CD3DX12_CPU_DESCRIPTOR_HANDLE m_cpuDSVHandle;
+		unsigned int m_dsvDescriptorSize = 0;
 
 		Microsoft::WRL::ComPtr<ID3D12Resource> m_shadowMap = nullptr;
 	};
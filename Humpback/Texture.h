@@ -6,6 +6,7 @@
 
 
 #include <string>
+#include <cstdint>
 #include <wrl.h>
 #include <d3d12.h>
 
@@ -21,6 +22,9 @@ namespace Humpback
 		std::wstring filePath;
 
 		Microsoft::WRL::ComPtr<ID3D12Resource> resource = nullptr;
-		Microsoft::WRL::ComPtr<ID3D12Resource> uploadHeap = nullptr;
+
+		// Slot of the SRV in the bindless heap, shaders index _Textures[] or _CubeTextures[] with it.
+		uint32_t srvIndex = UINT32_MAX;
+		D3D12_SRV_DIMENSION viewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 	};
 }
\ No newline at end of file
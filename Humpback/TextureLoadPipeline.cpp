@@ -0,0 +1,292 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include "JobSystem.h"
+#include "AssetCache.h"
+#include "MipChain.h"
+#include "TextureLoadPipeline.h"
+
+
+namespace Humpback
+{
+	namespace
+	{
+		// A decoded texture in the asset cache: this header followed by dataSize bytes holding every mip level,
+		// or a DDS file when blockFormat isn't None.
+		struct CachedTextureHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t width;
+			uint32_t height;
+			uint32_t format;
+			uint32_t srgb;
+			uint32_t mipLevels;
+			uint32_t blockFormat;
+			uint64_t dataSize;
+		};
+
+		const uint32_t CACHED_TEXTURE_MAGIC = 0x58544248;	// "HBTX"
+		const uint32_t CACHED_TEXTURE_VERSION = 4;
+
+		MipChainSettings GetMipChainSettings(TextureRole role)
+		{
+			MipChainSettings settings;
+			settings.srgb = role == TextureRole::Albedo;
+			settings.preserveAlphaCoverage = role == TextureRole::Albedo;
+			settings.normalMap = role == TextureRole::NormalMap;
+			return settings;
+		}
+
+		BlockFormat ChooseBlockFormat(TextureRole role, const DecodedImage& image)
+		{
+			if (CanBlockCompress(image.width, image.height) == false)
+			{
+				return BlockFormat::None;
+			}
+			if (image.format == ImageFormat::R8 || image.format == ImageFormat::R16)
+			{
+				return BlockFormat::BC4;
+			}
+			// The metallic smoothness masks keep smoothness in alpha, so four channel data gets BC7 too.
+			return role == TextureRole::NormalMap ? BlockFormat::BC5 : BlockFormat::BC7;
+		}
+
+		uint64_t GetCachedDataSize(const CachedTextureHeader& header)
+		{
+			if (header.blockFormat == (uint32_t)BlockFormat::None)
+			{
+				return GetImageByteSize(header.width, header.height, (ImageFormat)header.format, header.mipLevels);
+			}
+			if (header.blockFormat <= (uint32_t)BlockFormat::BC7 && CanBlockCompress(header.width, header.height))
+			{
+				return GetBlockCompressedDdsSize(header.width, header.height, header.mipLevels, (BlockFormat)header.blockFormat);
+			}
+			return 0;
+		}
+
+		using Clock = std::chrono::steady_clock;
+
+		double MillisecondsSince(Clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+	}
+
+	struct TextureLoadPipeline::Job
+	{
+		const std::string* path = nullptr;
+		TextureRole role = TextureRole::Linear;
+		DecodedTexture* texture = nullptr;
+
+		std::string cacheKey;
+		bool cacheHit = false;
+		bool needsFallback = false;
+		std::string error;
+
+		double readMs = 0.0;
+		double decodeMs = 0.0;
+		double convertMs = 0.0;
+		double compressMs = 0.0;
+		double cacheWriteMs = 0.0;
+	};
+
+	TextureLoadPipeline::TextureLoadPipeline(JobSystem& jobSystem, AssetCache* pAssetCache, uint32_t maxSize, bool blockCompress) :
+		m_jobSystem(jobSystem), m_pAssetCache(pAssetCache), m_maxSize(maxSize), m_blockCompress(blockCompress),
+		m_cacheSalt("Texture " + std::to_string(CACHED_TEXTURE_VERSION) + " maxSize " + std::to_string(maxSize) +
+			(blockCompress ? " bc" : ""))
+	{
+	}
+
+	std::vector<std::unique_ptr<DecodedTexture>> TextureLoadPipeline::Decode(const std::vector<TextureSource>& sources,
+		TextureLoadTimings& timings)
+	{
+		auto start = Clock::now();
+
+		std::vector<std::unique_ptr<DecodedTexture>> textures(sources.size());
+		std::vector<Job> jobs(sources.size());
+		for (size_t i = 0; i < sources.size(); i++)
+		{
+			textures[i] = std::make_unique<DecodedTexture>();
+			textures[i]->sourcePath = sources[i].path;
+			jobs[i].path = &sources[i].path;
+			jobs[i].role = sources[i].role;
+			jobs[i].texture = textures[i].get();
+		}
+
+		// One file per job, the files are large enough that finer splitting wouldn't pay. The mip
+		// chain of each file is split further across the same threads.
+		m_jobSystem.ParallelFor((unsigned int)jobs.size(), [&](unsigned int i) { _decodeOne(jobs[i]); });
+
+		for (Job& job : jobs)
+		{
+			if (job.needsFallback == false)
+			{
+				continue;
+			}
+
+			auto decodeStart = Clock::now();
+			if (m_fallbackDecoder && m_fallbackDecoder(*job.path, job.texture->image))
+			{
+				job.error.clear();
+				job.decodeMs += MillisecondsSince(decodeStart);
+				_finish(job);
+			}
+		}
+
+		timings.decodeWallMs += MillisecondsSince(start);
+
+		for (Job& job : jobs)
+		{
+			if (job.error.empty() == false)
+			{
+				throw std::runtime_error("Failed to load texture " + *job.path + ": " + job.error);
+			}
+
+			timings.textureCount++;
+			timings.cacheHits += job.cacheHit ? 1 : 0;
+			timings.decodedBytes += job.texture->dataSize;
+			timings.readMs += job.readMs;
+			timings.decodeMs += job.decodeMs;
+			timings.convertMs += job.convertMs;
+			timings.compressMs += job.compressMs;
+			timings.cacheWriteMs += job.cacheWriteMs;
+		}
+
+		return textures;
+	}
+
+	void TextureLoadPipeline::_decodeOne(Job& job)
+	{
+		// Runs on the job system, which can't carry exceptions back. Failures are reported through job.error.
+		try
+		{
+			DecodedTexture& texture = *job.texture;
+
+			auto readStart = Clock::now();
+			MappedFile source;
+			if (source.Open(*job.path) == false)
+			{
+				job.error = "can't read the file";
+				return;
+			}
+
+			if (m_pAssetCache != nullptr)
+			{
+				// The same file loaded in another role is mipped differently.
+				job.cacheKey = AssetCache::ComputeKey(source.GetData(), source.GetSize(),
+					m_cacheSalt + " role " + std::to_string((uint32_t)job.role));
+			}
+			job.readMs = MillisecondsSince(readStart);
+
+			if (m_pAssetCache != nullptr && m_pAssetCache->Load(job.cacheKey, texture.cacheEntry))
+			{
+				CachedTextureHeader header = {};
+				if (texture.cacheEntry.GetSize() >= sizeof(header))
+				{
+					std::memcpy(&header, texture.cacheEntry.GetData(), sizeof(header));
+				}
+
+				if (header.magic == CACHED_TEXTURE_MAGIC && header.version == CACHED_TEXTURE_VERSION &&
+					header.format <= (uint32_t)ImageFormat::RGBA16 && header.width > 0 && header.height > 0 &&
+					header.mipLevels >= 1 && header.mipLevels <= GetFullMipCount(header.width, header.height) &&
+					header.dataSize == GetCachedDataSize(header) && header.dataSize != 0 &&
+					texture.cacheEntry.GetSize() == sizeof(header) + header.dataSize)
+				{
+					texture.width = header.width;
+					texture.height = header.height;
+					texture.format = (ImageFormat)header.format;
+					texture.srgb = header.srgb != 0;
+					texture.mipLevels = header.mipLevels;
+					texture.blockFormat = (BlockFormat)header.blockFormat;
+					texture.dataSize = header.dataSize;
+					texture.pixels = texture.cacheEntry.GetData() + sizeof(header);
+					job.cacheHit = true;
+					return;
+				}
+
+				m_pAssetCache->Reject(texture.cacheEntry);
+				texture.cacheEntry.Close();
+			}
+
+			auto decodeStart = Clock::now();
+			bool decoded = DecodePng(source.GetData(), source.GetSize(), texture.image, job.error);
+			job.decodeMs = MillisecondsSince(decodeStart);
+
+			if (decoded == false)
+			{
+				// Other containers and the PNG variants the decoder skips. If the fallback fails too the decoder's error is reported.
+				job.needsFallback = true;
+				return;
+			}
+
+			_finish(job);
+		}
+		catch (const std::exception& e)
+		{
+			job.error = e.what();
+		}
+	}
+
+	void TextureLoadPipeline::_finish(Job& job)
+	{
+		DecodedTexture& texture = *job.texture;
+		DecodedImage& image = texture.image;
+
+		auto convertStart = Clock::now();
+		FitImageToSize(image, m_maxSize);
+		GenerateMipChain(image, GetMipChainSettings(job.role), &m_jobSystem);
+		job.convertMs += MillisecondsSince(convertStart);
+
+		texture.width = image.width;
+		texture.height = image.height;
+		texture.format = image.format;
+		texture.srgb = image.srgb;
+		texture.mipLevels = image.mipLevels;
+		texture.dataSize = image.pixels.size();
+		texture.pixels = image.pixels.data();
+
+		BlockFormat blockFormat = m_blockCompress ? ChooseBlockFormat(job.role, image) : BlockFormat::None;
+		if (blockFormat != BlockFormat::None)
+		{
+			auto compressStart = Clock::now();
+			EncodeBlockCompressedDds(image, blockFormat, texture.compressed, &m_jobSystem);
+			job.compressMs += MillisecondsSince(compressStart);
+
+			texture.blockFormat = blockFormat;
+			texture.dataSize = texture.compressed.size();
+			texture.pixels = texture.compressed.data();
+			std::vector<uint8_t>().swap(image.pixels);
+		}
+
+		if (m_pAssetCache == nullptr || job.cacheKey.empty())
+		{
+			return;
+		}
+
+		auto writeStart = Clock::now();
+
+		CachedTextureHeader header = {};
+		header.magic = CACHED_TEXTURE_MAGIC;
+		header.version = CACHED_TEXTURE_VERSION;
+		header.width = texture.width;
+		header.height = texture.height;
+		header.format = (uint32_t)texture.format;
+		header.srgb = texture.srgb ? 1 : 0;
+		header.mipLevels = texture.mipLevels;
+		header.blockFormat = (uint32_t)texture.blockFormat;
+		header.dataSize = texture.dataSize;
+
+		std::vector<uint8_t> entry(sizeof(header) + header.dataSize);
+		std::memcpy(entry.data(), &header, sizeof(header));
+		std::memcpy(entry.data() + sizeof(header), texture.pixels, header.dataSize);
+		m_pAssetCache->Store(job.cacheKey, entry);
+
+		job.cacheWriteMs += MillisecondsSince(writeStart);
+	}
+}
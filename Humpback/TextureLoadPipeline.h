@@ -0,0 +1,115 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+#include "ImageDecoder.h"
+#include "BlockCompression.h"
+#include "MappedFile.h"
+
+
+namespace Humpback
+{
+	class JobSystem;
+	class AssetCache;
+
+
+	// Stage times are summed over the threads that ran them, the wall times are what the caller waited.
+	struct TextureLoadTimings
+	{
+		uint32_t textureCount = 0;
+		uint32_t cacheHits = 0;
+		uint64_t decodedBytes = 0;
+
+		double readMs = 0.0;		// Mapping and hashing the source.
+		double decodeMs = 0.0;		// PNG inflate, unfilter and expansion, or the fallback decoder.
+		double convertMs = 0.0;		// Fitting to the size limit and building the mip chain.
+		double compressMs = 0.0;	// Block compression.
+		double cacheWriteMs = 0.0;
+
+		double decodeWallMs = 0.0;
+		double uploadRecordMs = 0.0;
+		double uploadWaitMs = 0.0;	// Blocked on the copy queue after everything else was loaded.
+	};
+
+
+	// Decides how the mip chain of a texture is filtered and which block format it is compressed to.
+	enum class TextureRole : uint32_t
+	{
+		// Masks and other data, filtered as stored. BC7, or BC4 for single channel images.
+		Linear = 0,
+		// sRGB color, filtered in linear space. The alpha is cut out against 0.5 so its coverage is kept per level. BC7.
+		Albedo,
+		// Tangent space normals, renormalized per level. BC5 keeps X and Y, shaders rebuild Z.
+		NormalMap,
+	};
+
+	struct TextureSource
+	{
+		std::string path;
+		TextureRole role = TextureRole::Linear;
+	};
+
+
+	// Pixels of every mip level ready for upload, laid out as GetImageMipLayout describes. When blockFormat
+	// isn't None they are a DDS file of dataSize bytes instead. They live in image, compressed or the mapped cache entry.
+	struct DecodedTexture
+	{
+		std::string sourcePath;
+
+		uint32_t width = 0;
+		uint32_t height = 0;
+		ImageFormat format = ImageFormat::RGBA8;
+		bool srgb = false;
+		uint32_t mipLevels = 0;
+		BlockFormat blockFormat = BlockFormat::None;
+		uint64_t dataSize = 0;
+		const uint8_t* pixels = nullptr;
+
+		DecodedImage image;
+		std::vector<uint8_t> compressed;
+		MappedFile cacheEntry;
+	};
+
+
+	// CPU half of texture loading: reads, decodes, converts, mips and compresses a batch of image files on the job system.
+	// Results already in the asset cache are mapped instead of decoded, fresh ones are stored for the next run.
+	// Nothing here touches D3D12 so the stages can be run and timed headless.
+	class TextureLoadPipeline
+	{
+	public:
+
+		// Decodes what the built-in PNG decoder can't. Called on the thread calling Decode, one file at a time.
+		using FallbackDecoder = std::function<bool(const std::string& path, DecodedImage& image)>;
+
+		// pAssetCache may be null. maxSize == 0 keeps every image at its source size. With blockCompress the
+		// textures whose size allows it are compressed in the format of their role.
+		TextureLoadPipeline(JobSystem& jobSystem, AssetCache* pAssetCache, uint32_t maxSize, bool blockCompress);
+
+		void SetFallbackDecoder(FallbackDecoder decoder) { m_fallbackDecoder = std::move(decoder); }
+
+		// Results are in the order of sources. Throws std::runtime_error naming the first file that failed.
+		std::vector<std::unique_ptr<DecodedTexture>> Decode(const std::vector<TextureSource>& sources, TextureLoadTimings& timings);
+
+	private:
+
+		struct Job;
+
+		void _decodeOne(Job& job);
+		void _finish(Job& job);
+
+		JobSystem&		m_jobSystem;
+		AssetCache*		m_pAssetCache;
+		uint32_t		m_maxSize;
+		bool			m_blockCompress;
+		std::string		m_cacheSalt;
+		FallbackDecoder	m_fallbackDecoder;
+	};
+}
@@ -0,0 +1,90 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <stdexcept>
+
+#include "TransformHierarchy.h"
+
+
+using namespace DirectX;
+
+
+namespace Humpback
+{
+	uint32_t TransformHierarchy::AddNode(uint32_t parent, FXMMATRIX localTransform)
+	{
+		uint32_t node = (uint32_t)m_parents.size();
+		if (parent != NO_PARENT && parent >= node)
+		{
+			throw std::runtime_error("TransformHierarchy: the parent must be added before its children.");
+		}
+
+		m_parents.push_back(parent);
+		m_localTransforms.emplace_back();
+		m_worldTransforms.emplace_back();
+		m_dirty.push_back(0);
+
+		SetLocalTransform(node, localTransform);
+		return node;
+	}
+
+	void TransformHierarchy::SetLocalTransform(uint32_t node, FXMMATRIX localTransform)
+	{
+		XMStoreFloat4x4A(&m_localTransforms[node], localTransform);
+
+		if (m_dirty[node] == 0)
+		{
+			m_dirty[node] = 1;
+			m_firstDirty = node < m_firstDirty ? node : m_firstDirty;
+		}
+	}
+
+	void TransformHierarchy::Clear()
+	{
+		m_localTransforms.clear();
+		m_worldTransforms.clear();
+		m_parents.clear();
+		m_dirty.clear();
+		m_updated.clear();
+		m_firstDirty = 0;
+	}
+
+	const std::vector<uint32_t>& TransformHierarchy::Update()
+	{
+		m_updated.clear();
+
+		// The parent of a node is final by the time the pass reaches it, both its world transform and
+		// whether it moved, so the dirty bits flow down the tree within the same pass.
+		uint32_t count = (uint32_t)m_parents.size();
+		for (uint32_t i = m_firstDirty; i < count; i++)
+		{
+			uint32_t parent = m_parents[i];
+			if (parent == NO_PARENT)
+			{
+				if (m_dirty[i])
+				{
+					m_worldTransforms[i] = m_localTransforms[i];
+					m_updated.push_back(i);
+				}
+				continue;
+			}
+
+			if (m_dirty[i] | m_dirty[parent])
+			{
+				m_dirty[i] = 1;
+				XMMATRIX world = XMMatrixMultiply(XMLoadFloat4x4A(&m_localTransforms[i]), XMLoadFloat4x4A(&m_worldTransforms[parent]));
+				XMStoreFloat4x4A(&m_worldTransforms[i], world);
+				m_updated.push_back(i);
+			}
+		}
+
+		for (uint32_t node : m_updated)
+		{
+			m_dirty[node] = 0;
+		}
+		m_firstDirty = count;
+
+		return m_updated;
+	}
+}
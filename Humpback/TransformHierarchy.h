@@ -0,0 +1,56 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <DirectXMath.h>
+
+
+namespace Humpback
+{
+	// Local and world transforms of a node tree in flat arrays. A node is only ever added after its parent,
+	// so parents come before their children and one linear pass over the arrays updates every level.
+	// Setting a local transform marks the node dirty, Update then recomputes the world matrices of the
+	// dirty nodes and of everything below them and leaves the rest untouched.
+	class TransformHierarchy
+	{
+	public:
+
+		static const uint32_t NO_PARENT = UINT32_MAX;
+
+		TransformHierarchy() = default;
+		TransformHierarchy(const TransformHierarchy&) = delete;
+		TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+		// The parent must already exist. Returns the index of the node, stable for the lifetime of the hierarchy.
+		uint32_t AddNode(uint32_t parent, DirectX::FXMMATRIX localTransform);
+		void SetLocalTransform(uint32_t node, DirectX::FXMMATRIX localTransform);
+		void Clear();
+
+		uint32_t GetNodeCount() const { return (uint32_t)m_parents.size(); }
+		uint32_t GetParent(uint32_t node) const { return m_parents[node]; }
+
+		DirectX::XMMATRIX GetLocalTransform(uint32_t node) const { return DirectX::XMLoadFloat4x4A(&m_localTransforms[node]); }
+		// As of the last Update, row vectors like the rest of the renderer.
+		DirectX::XMMATRIX GetWorldTransform(uint32_t node) const { return DirectX::XMLoadFloat4x4A(&m_worldTransforms[node]); }
+		const DirectX::XMFLOAT4X4A* GetWorldTransforms() const { return m_worldTransforms.data(); }
+
+		// Recomputes the world transforms below the dirty nodes. Returns the nodes whose world transform
+		// was written in ascending order, valid until the next Update.
+		const std::vector<uint32_t>& Update();
+
+	private:
+
+		std::vector<DirectX::XMFLOAT4X4A> m_localTransforms;
+		std::vector<DirectX::XMFLOAT4X4A> m_worldTransforms;
+		std::vector<uint32_t> m_parents;
+		std::vector<uint8_t> m_dirty;
+
+		// Nodes before the first dirty one can't change, Update starts there.
+		uint32_t m_firstDirty = 0;
+		std::vector<uint32_t> m_updated;
+	};
+}
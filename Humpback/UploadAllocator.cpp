@@ -0,0 +1,130 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../DirectXTK12-main/Src/d3dx12.h"
+#include "UploadAllocator.h"
+
+
+using Microsoft::WRL::ComPtr;
+
+
+namespace Humpback
+{
+	void ThrowIfFailed(HRESULT hr);
+
+	UploadAllocator::UploadAllocator(ID3D12Device* device, GpuMemoryAllocator* gpuMemory, uint64_t pageSize) :
+		m_device(device),
+		m_gpuMemory(gpuMemory),
+		m_pageSize(pageSize)
+	{
+	}
+
+	UploadAllocator::~UploadAllocator()
+	{
+		for (auto& page : m_pages)
+		{
+			page->resource->Unmap(0, nullptr);
+			m_gpuMemory->Release(page->resource.Get());
+		}
+	}
+
+	UploadAllocation UploadAllocator::Allocate(uint64_t size, uint64_t alignment)
+	{
+		Page* page = nullptr;
+		uint64_t offset = RingAllocator::INVALID_OFFSET;
+
+		for (auto& candidate : m_pages)
+		{
+			offset = candidate->ring->Allocate(size, alignment);
+			if (offset != RingAllocator::INVALID_OFFSET)
+			{
+				page = candidate.get();
+				break;
+			}
+		}
+
+		// Every page is busy with in-flight uploads, add one. Oversized requests get a page of their own size.
+		if (page == nullptr)
+		{
+			page = _createPage(std::max(m_pageSize, (size + alignment - 1) & ~(alignment - 1)));
+			offset = page->ring->Allocate(size, alignment);
+			if (offset == RingAllocator::INVALID_OFFSET)
+			{
+				throw std::runtime_error("UploadAllocator: allocation does not fit in a new page.");
+			}
+		}
+
+		UploadAllocation allocation;
+		allocation.resource = page->resource.Get();
+		allocation.offset = offset;
+		allocation.cpuAddress = page->cpuAddress + offset;
+		allocation.gpuAddress = page->resource->GetGPUVirtualAddress() + offset;
+
+		return allocation;
+	}
+
+	ComPtr<ID3D12Resource> UploadAllocator::CreateDefaultBuffer(ID3D12GraphicsCommandList* cmdList,
+		const void* initData, uint64_t byteSize)
+	{
+		ComPtr<ID3D12Resource> defaultBuffer = m_gpuMemory->CreateBuffer(byteSize,
+			D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST);
+
+		UploadAllocation staging = Allocate(byteSize, 16);
+		memcpy(staging.cpuAddress, initData, byteSize);
+		cmdList->CopyBufferRegion(defaultBuffer.Get(), 0, staging.resource, staging.offset, byteSize);
+
+		auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(defaultBuffer.Get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
+		cmdList->ResourceBarrier(1, &barrier);
+
+		return defaultBuffer;
+	}
+
+	void UploadAllocator::UploadSubresources(ID3D12GraphicsCommandList* cmdList, ID3D12Resource* resource,
+		unsigned int firstSubresource, unsigned int numSubresources, const D3D12_SUBRESOURCE_DATA* subresources)
+	{
+		uint64_t size = GetRequiredIntermediateSize(resource, firstSubresource, numSubresources);
+		UploadAllocation staging = Allocate(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+		if (UpdateSubresources(cmdList, resource, staging.resource, staging.offset,
+			firstSubresource, numSubresources, subresources) == 0)
+		{
+			throw std::runtime_error("UploadAllocator: failed to record the subresource upload.");
+		}
+	}
+
+	void UploadAllocator::FinishSubmission(uint64_t fenceValue)
+	{
+		for (auto& page : m_pages)
+		{
+			page->ring->FinishSubmission(fenceValue);
+		}
+	}
+
+	void UploadAllocator::ReleaseCompleted(uint64_t completedFenceValue)
+	{
+		for (auto& page : m_pages)
+		{
+			page->ring->ReleaseCompleted(completedFenceValue);
+		}
+	}
+
+	UploadAllocator::Page* UploadAllocator::_createPage(uint64_t size)
+	{
+		auto page = std::make_unique<Page>();
+
+		page->resource = m_gpuMemory->CreateBuffer(size, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+		// Upload heaps may stay mapped for their whole lifetime.
+		ThrowIfFailed(page->resource->Map(0, nullptr, reinterpret_cast<void**>(&page->cpuAddress)));
+		page->ring = std::make_unique<RingAllocator>(size);
+
+		m_pages.push_back(std::move(page));
+		return m_pages.back().get();
+	}
+}
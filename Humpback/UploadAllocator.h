@@ -0,0 +1,77 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "RingAllocator.h"
+#include "GpuMemoryAllocator.h"
+
+
+namespace Humpback
+{
+	struct UploadAllocation
+	{
+		ID3D12Resource* resource = nullptr;
+		uint64_t offset = 0;
+		uint8_t* cpuAddress = nullptr;
+		D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+	};
+
+
+	// Staging memory for GPU uploads. Blocks are carved out of a few large, persistently mapped
+	// upload pages and recycled once the fence of the submission that used them has completed,
+	// so meshes and textures don't keep their own upload heaps alive.
+	class UploadAllocator
+	{
+	public:
+
+		static const uint64_t DEFAULT_PAGE_SIZE = 32 * 1024 * 1024;
+
+		// Pages and default buffers are placed through gpuMemory.
+		UploadAllocator(ID3D12Device* device, GpuMemoryAllocator* gpuMemory, uint64_t pageSize = DEFAULT_PAGE_SIZE);
+		~UploadAllocator();
+
+		UploadAllocator(const UploadAllocator&) = delete;
+		UploadAllocator& operator=(const UploadAllocator&) = delete;
+
+		// The block stays valid until the submission it is recorded into retires.
+		UploadAllocation Allocate(uint64_t size, uint64_t alignment);
+
+		// Creates a default heap buffer in GENERIC_READ state and records the copy of initData into it.
+		Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(ID3D12GraphicsCommandList* cmdList,
+			const void* initData, uint64_t byteSize);
+
+		// Records the copy of the subresources into a resource in COPY_DEST state.
+		void UploadSubresources(ID3D12GraphicsCommandList* cmdList, ID3D12Resource* resource,
+			unsigned int firstSubresource, unsigned int numSubresources, const D3D12_SUBRESOURCE_DATA* subresources);
+
+		// Call after the command lists using the allocations were submitted and fenceValue was signaled.
+		void FinishSubmission(uint64_t fenceValue);
+		void ReleaseCompleted(uint64_t completedFenceValue);
+
+		size_t GetPageCount() const { return m_pages.size(); }
+
+	private:
+
+		struct Page
+		{
+			Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+			uint8_t* cpuAddress = nullptr;
+			std::unique_ptr<RingAllocator> ring;
+		};
+
+		Page* _createPage(uint64_t size);
+
+		Microsoft::WRL::ComPtr<ID3D12Device> m_device;
+		GpuMemoryAllocator* m_gpuMemory;
+		uint64_t m_pageSize;
+
+		std::vector<std::unique_ptr<Page>> m_pages;
+	};
+}
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "D3DUtil.h"
+#include "GpuMemoryAllocator.h"
 #include "../DirectXTK12-main/Src/d3dx12.h"
 
 namespace Humpback 
@@ -14,8 +15,10 @@ namespace Humpback
 	class UploadBuffer
 	{
 	public:
-		UploadBuffer(ID3D12Device* device, unsigned int elementCount, bool isConstantBuffer) :
-			m_isConstantBuffer(isConstantBuffer)
+		// Placed in one of the allocator's upload heaps when an allocator is given, committed otherwise.
+		UploadBuffer(ID3D12Device* device, unsigned int elementCount, bool isConstantBuffer,
+			GpuMemoryAllocator* allocator = nullptr) :
+			m_allocator(allocator), m_isConstantBuffer(isConstantBuffer)
 		{
 			m_elementByteSize = sizeof(T);
 
@@ -31,15 +34,23 @@ namespace Humpback
 				m_elementByteSize = D3DUtil::CalConstantBufferByteSize(m_elementByteSize);
 			}
 
-			auto uploadHeapPro = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-			auto resDesc = CD3DX12_RESOURCE_DESC::Buffer(m_elementByteSize * elementCount);
-			ThrowIfFailed(device->CreateCommittedResource(
-				&uploadHeapPro,
-				D3D12_HEAP_FLAG_NONE,
-				&resDesc,
-				D3D12_RESOURCE_STATE_GENERIC_READ,
-				nullptr,
-				IID_PPV_ARGS(&m_uploadBuffer)));
+			if (m_allocator != nullptr)
+			{
+				m_uploadBuffer = m_allocator->CreateBuffer(m_elementByteSize * elementCount,
+					D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
+			}
+			else
+			{
+				auto uploadHeapPro = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+				auto resDesc = CD3DX12_RESOURCE_DESC::Buffer(m_elementByteSize * elementCount);
+				ThrowIfFailed(device->CreateCommittedResource(
+					&uploadHeapPro,
+					D3D12_HEAP_FLAG_NONE,
+					&resDesc,
+					D3D12_RESOURCE_STATE_GENERIC_READ,
+					nullptr,
+					IID_PPV_ARGS(&m_uploadBuffer)));
+			}
 
 			ThrowIfFailed(m_uploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&m_mappedData)));
 		}
@@ -51,6 +62,11 @@ namespace Humpback
 			if (m_uploadBuffer != nullptr)
 			{
 				m_uploadBuffer->Unmap(0, nullptr);
+
+				if (m_allocator != nullptr)
+				{
+					m_allocator->Release(m_uploadBuffer.Get());
+				}
 			}
 		
 			m_mappedData = nullptr;
@@ -66,9 +82,25 @@ namespace Humpback
 			memcpy(&m_mappedData[elementIndex * m_elementByteSize], &data, sizeof(T));
 		}
 
+		// Consecutive elements in one copy, constant buffers pad their elements so they take one at a time.
+		void CopyData(int firstElement, const T* data, unsigned int count)
+		{
+			if (m_isConstantBuffer)
+			{
+				for (unsigned int i = 0; i < count; i++)
+				{
+					CopyData(firstElement + i, data[i]);
+				}
+				return;
+			}
+
+			memcpy(&m_mappedData[firstElement * m_elementByteSize], data, count * sizeof(T));
+		}
+
 
 	private:
 		Microsoft::WRL::ComPtr<ID3D12Resource> m_uploadBuffer = nullptr;
+		GpuMemoryAllocator* m_allocator = nullptr;
 
 		byte* m_mappedData = nullptr;
 
@@ -0,0 +1,112 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "UploadTracker.h"
+
+
+namespace Humpback
+{
+	UploadTracker::UploadTracker(unsigned int frameResourceCount)
+	{
+		if (frameResourceCount == 0 || frameResourceCount > 8)
+		{
+			throw std::runtime_error("UploadTracker: between 1 and 8 frame resources are supported.");
+		}
+
+		m_allFrames = (uint8_t)((1u << frameResourceCount) - 1);
+		m_dirtyLists.resize(frameResourceCount);
+	}
+
+	void UploadTracker::Resize(uint32_t count)
+	{
+		uint32_t oldCount = (uint32_t)m_pending.size();
+		m_pending.resize(count, m_allFrames);
+
+		for (std::vector<uint32_t>& dirty : m_dirtyLists)
+		{
+			if (count >= oldCount)
+			{
+				for (uint32_t i = oldCount; i < count; i++)
+				{
+					dirty.push_back(i);
+				}
+			}
+			else
+			{
+				// Pending elements past the end are gone.
+				dirty.erase(std::remove_if(dirty.begin(), dirty.end(), [count](uint32_t index) { return index >= count; }),
+					dirty.end());
+			}
+		}
+	}
+
+	void UploadTracker::Mark(uint32_t index)
+	{
+		uint8_t added = m_allFrames & ~m_pending[index];
+		if (added == 0)
+		{
+			return;
+		}
+
+		m_pending[index] = m_allFrames;
+		for (size_t f = 0; f < m_dirtyLists.size(); f++)
+		{
+			if ((added >> f) & 1)
+			{
+				m_dirtyLists[f].push_back(index);
+			}
+		}
+	}
+
+	void UploadTracker::Collect(unsigned int frameResource, std::vector<Run>& runs)
+	{
+		std::vector<uint32_t>& dirty = m_dirtyLists[frameResource];
+		if (dirty.empty())
+		{
+			return;
+		}
+
+		const uint8_t bit = (uint8_t)(1u << frameResource);
+		const size_t firstRun = runs.size();
+		auto addToRuns = [&](uint32_t index)
+			{
+				if (runs.size() > firstRun && runs.back().first + runs.back().count == index)
+				{
+					runs.back().count++;
+				}
+				else
+				{
+					runs.push_back({ index, 1 });
+				}
+			};
+
+		// Sorting costs more than walking the flags once a large share of the elements changed.
+		if (dirty.size() > m_pending.size() / DENSE_SHARE)
+		{
+			for (uint32_t i = 0; i < (uint32_t)m_pending.size(); i++)
+			{
+				if (m_pending[i] & bit)
+				{
+					m_pending[i] &= ~bit;
+					addToRuns(i);
+				}
+			}
+		}
+		else
+		{
+			// Marked in any order, every index is in the list once.
+			std::sort(dirty.begin(), dirty.end());
+			for (uint32_t index : dirty)
+			{
+				m_pending[index] &= ~bit;
+				addToRuns(index);
+			}
+		}
+
+		dirty.clear();
+	}
+}
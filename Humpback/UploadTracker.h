@@ -0,0 +1,54 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+
+namespace Humpback
+{
+	// Tracks which elements of a buffer kept once per frame resource are stale. A changed element has to reach
+	// the copy of every frame resource, each one when it comes around again, so the element stays pending for
+	// the frame resources that haven't written it yet. Every frame resource keeps a list of the elements marked
+	// since it last collected, so collecting costs the changed elements only. Replaces a NumFramesDirty
+	// counter per element, which needed a scan over all of them every frame.
+	class UploadTracker
+	{
+	public:
+
+		// Consecutive stale elements, written with one copy.
+		struct Run
+		{
+			uint32_t first;
+			uint32_t count;
+		};
+
+		// At most 8 frame resources, the pending ones are a bit mask per element.
+		explicit UploadTracker(unsigned int frameResourceCount);
+		UploadTracker(const UploadTracker&) = delete;
+		UploadTracker& operator=(const UploadTracker&) = delete;
+
+		// Added elements start out pending for every frame resource.
+		void Resize(uint32_t count);
+		void Mark(uint32_t index);
+
+		uint32_t GetCount() const { return (uint32_t)m_pending.size(); }
+		uint32_t GetPendingCount(unsigned int frameResource) const { return (uint32_t)m_dirtyLists[frameResource].size(); }
+
+		// Appends the stale elements of frameResource as runs in ascending order and marks them written.
+		void Collect(unsigned int frameResource, std::vector<Run>& runs);
+
+	private:
+
+		// Past one changed element in this many, Collect walks the flags instead of sorting the list.
+		static const uint32_t DENSE_SHARE = 16;
+
+		// The frame resources each element is pending for, so an element enters a list once.
+		std::vector<uint8_t> m_pending;
+		std::vector<std::vector<uint32_t>> m_dirtyLists;
+		uint8_t m_allFrames = 0;
+	};
+}
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <vector>
 #include <DirectXMath.h>
 
 
@@ -15,4 +16,17 @@ namespace Humpback
 		DirectX::XMFLOAT2 uv;
 		DirectX::XMFLOAT3 tangent;
 	};
+
+	// Tightly packed positions for depth-only passes, element i belongs to vertices[i]
+	// so the index buffer works for both streams.
+	inline std::vector<DirectX::XMFLOAT3> BuildPositionStream(const std::vector<Vertex>& vertices)
+	{
+		std::vector<DirectX::XMFLOAT3> positions(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			positions[i] = vertices[i].position;
+		}
+
+		return positions;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,290 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "VertexPacking.h"
+#include "JobSystem.h"
+
+
+using namespace DirectX;
+
+
+namespace Humpback
+{
+	namespace
+	{
+		const float UNORM16_MAX = 65535.0f;
+		const float SNORM16_MAX = 32767.0f;
+		const float INV_SNORM16_MAX = 1.0f / 32767.0f;
+
+		const size_t VERTICES_PER_JOB = 16384;
+
+		uint32_t FloatBits(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		float BitsToFloat(uint32_t bits)
+		{
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		// The octahedral square before quantization, u and v in [-1, 1].
+		bool ProjectOctahedral(const XMFLOAT3& d, float& u, float& v)
+		{
+			float l1 = fabsf(d.x) + fabsf(d.y) + fabsf(d.z);
+			if (!(l1 > 0.0f) || !std::isfinite(l1))
+			{
+				return false;
+			}
+
+			float invL1 = 1.0f / l1;
+			u = d.x * invL1;
+			v = d.y * invL1;
+
+			// Fold the lower hemisphere over the diagonals.
+			if (d.z < 0.0f)
+			{
+				float foldedU = (1.0f - fabsf(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+				float foldedV = (1.0f - fabsf(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+				u = foldedU;
+				v = foldedV;
+			}
+
+			return true;
+		}
+
+		float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+
+		// DecodeOctahedral without the normalize.
+		inline XMFLOAT3 UnfoldOctahedral(int u, int v)
+		{
+			XMFLOAT3 n;
+			n.x = (float)u * INV_SNORM16_MAX;
+			n.y = (float)v * INV_SNORM16_MAX;
+			n.z = 1.0f - fabsf(n.x) - fabsf(n.y);
+
+			// n.x >= 0 ? -t : t, the codes never make a negative zero.
+			float t = std::max(-n.z, 0.0f);
+			n.x -= copysignf(t, n.x);
+			n.y -= copysignf(t, n.y);
+			return n;
+		}
+
+		int FloorToInt(float value)
+		{
+			int i = (int)value;
+			return (float)i > value ? i - 1 : i;
+		}
+
+		uint16_t QuantizeUnorm(float value, float offset, float invScale)
+		{
+			float q = (value - offset) * invScale;
+			q = std::min(std::max(q, 0.0f), UNORM16_MAX);
+			return (uint16_t)(q + 0.5f);
+		}
+	}
+
+	PositionQuantization GetPositionQuantization(const XMFLOAT3& center, const XMFLOAT3& extents)
+	{
+		PositionQuantization quantization;
+		quantization.scale = XMFLOAT3(2.0f * extents.x, 2.0f * extents.y, 2.0f * extents.z);
+		quantization.offset = XMFLOAT3(center.x - extents.x, center.y - extents.y, center.z - extents.z);
+		return quantization;
+	}
+
+	void PackVertices(const Vertex* vertices, size_t count, const PositionQuantization& quantization,
+		PackedVertex* packed, const float* tangentSigns, JobSystem* pJobSystem)
+	{
+		if (pJobSystem != nullptr && count > VERTICES_PER_JOB)
+		{
+			unsigned int jobCount = (unsigned int)((count + VERTICES_PER_JOB - 1) / VERTICES_PER_JOB);
+			pJobSystem->ParallelFor(jobCount, [&](unsigned int job)
+				{
+					size_t first = job * VERTICES_PER_JOB;
+					size_t jobSize = std::min(VERTICES_PER_JOB, count - first);
+					PackVertices(vertices + first, jobSize, quantization, packed + first,
+						tangentSigns != nullptr ? tangentSigns + first : nullptr, nullptr);
+				});
+			return;
+		}
+
+		// A flat axis has a zero scale, every vertex then sits at the offset.
+		const float* scale = &quantization.scale.x;
+		const float* offset = &quantization.offset.x;
+		float invScale[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			invScale[axis] = scale[axis] > 0.0f ? UNORM16_MAX / scale[axis] : 0.0f;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const Vertex& v = vertices[i];
+			PackedVertex& p = packed[i];
+
+			const float* position = &v.position.x;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				p.position[axis] = QuantizeUnorm(position[axis], offset[axis], invScale[axis]);
+			}
+
+			float tangentSign = tangentSigns != nullptr ? tangentSigns[i] : 1.0f;
+			p.position[3] = tangentSign < 0.0f ? 0 : 0xFFFF;
+
+			EncodeOctahedral(v.normal, p.normal);
+			EncodeOctahedral(v.tangent, p.tangent);
+
+			p.uv[0] = FloatToHalf(v.uv.x);
+			p.uv[1] = FloatToHalf(v.uv.y);
+		}
+	}
+
+	Vertex UnpackVertex(const PackedVertex& packed, const PositionQuantization& quantization, float* pTangentSign)
+	{
+		Vertex v;
+
+		const float* scale = &quantization.scale.x;
+		const float* offset = &quantization.offset.x;
+		float* position = &v.position.x;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			position[axis] = offset[axis] + (float)packed.position[axis] / UNORM16_MAX * scale[axis];
+		}
+
+		v.normal = DecodeOctahedral(packed.normal);
+		v.tangent = DecodeOctahedral(packed.tangent);
+		v.uv = XMFLOAT2(HalfToFloat(packed.uv[0]), HalfToFloat(packed.uv[1]));
+
+		if (pTangentSign != nullptr)
+		{
+			*pTangentSign = packed.position[3] != 0 ? 1.0f : -1.0f;
+		}
+
+		return v;
+	}
+
+	std::vector<PackedPosition> BuildPackedPositionStream(const std::vector<PackedVertex>& vertices)
+	{
+		std::vector<PackedPosition> positions(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			memcpy(positions[i].position, vertices[i].position, sizeof(positions[i].position));
+		}
+
+		return positions;
+	}
+
+	void EncodeOctahedral(const XMFLOAT3& direction, int16_t encoded[2])
+	{
+		float u = 0.0f;
+		float v = 0.0f;
+		if (ProjectOctahedral(direction, u, v) == false)
+		{
+			encoded[0] = 0;
+			encoded[1] = 0;
+			return;
+		}
+
+		// Rounding each coordinate on its own isn't the nearest direction after the fold,
+		// try the four codes around the exact point. They are all within a code of the direction,
+		// the squared sine of the angle tells them apart where the cosine is lost to rounding.
+		int baseU = FloorToInt(u * SNORM16_MAX);
+		int baseV = FloorToInt(v * SNORM16_MAX);
+
+		float bestSinSq = 0.0f;
+		float bestLengthSq = 0.0f;
+		for (int i = 0; i < 4; i++)
+		{
+			int cu = std::min(std::max(baseU + (i & 1), -32767), 32767);
+			int cv = std::min(std::max(baseV + (i >> 1), -32767), 32767);
+
+			XMFLOAT3 c = UnfoldOctahedral(cu, cv);
+			XMFLOAT3 cross(c.y * direction.z - c.z * direction.y, c.z * direction.x - c.x * direction.z,
+				c.x * direction.y - c.y * direction.x);
+			float sinSq = Dot(cross, cross);
+			float lengthSq = Dot(c, c);
+			if (i == 0 || sinSq * bestLengthSq < bestSinSq * lengthSq)
+			{
+				bestSinSq = sinSq;
+				bestLengthSq = lengthSq;
+				encoded[0] = (int16_t)cu;
+				encoded[1] = (int16_t)cv;
+			}
+		}
+	}
+
+	XMFLOAT3 DecodeOctahedral(const int16_t encoded[2])
+	{
+		// -32768 decodes as -1 like -32767.
+		XMFLOAT3 n = UnfoldOctahedral(std::max((int)encoded[0], -32767), std::max((int)encoded[1], -32767));
+
+		float invLength = 1.0f / sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+		return XMFLOAT3(n.x * invLength, n.y * invLength, n.z * invLength);
+	}
+
+	uint16_t FloatToHalf(float value)
+	{
+		const uint32_t FLOAT_INFINITY = 255u << 23;
+		const uint32_t HALF_OVERFLOW = (127u + 16u) << 23;		// 65536, everything from 65520 up rounds to infinity.
+		const uint32_t HALF_MIN_NORMAL = 113u << 23;			// 2^-14.
+		const uint32_t DENORMAL_MAGIC = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+		uint32_t bits = FloatBits(value);
+		uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+		bits &= 0x7FFFFFFF;
+
+		uint16_t half;
+		if (bits >= HALF_OVERFLOW)
+		{
+			half = bits > FLOAT_INFINITY ? 0x7E00 : 0x7C00;
+		}
+		else if (bits < HALF_MIN_NORMAL)
+		{
+			// The float adder does the rounding of the denormal mantissa.
+			float shifted = BitsToFloat(bits) + BitsToFloat(DENORMAL_MAGIC);
+			half = (uint16_t)(FloatBits(shifted) - DENORMAL_MAGIC);
+		}
+		else
+		{
+			uint32_t mantissaOdd = (bits >> 13) & 1;
+			bits += ((15u - 127u) << 23) + 0xFFF;
+			bits += mantissaOdd;
+			half = (uint16_t)(bits >> 13);
+		}
+
+		return half | sign;
+	}
+
+	float HalfToFloat(uint16_t value)
+	{
+		uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+		uint32_t exponent = (value >> 10) & 0x1F;
+		uint32_t mantissa = value & 0x3FF;
+
+		if (exponent == 0x1F)
+		{
+			return BitsToFloat(sign | 0x7F800000 | (mantissa << 13));
+		}
+
+		if (exponent == 0)
+		{
+			// Denormals are exact in float.
+			float magnitude = (float)mantissa * (1.0f / 16777216.0f);
+			return sign != 0 ? -magnitude : magnitude;
+		}
+
+		return BitsToFloat(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+	}
+}
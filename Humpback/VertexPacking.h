@@ -0,0 +1,65 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <DirectXMath.h>
+
+#include "Vertex.h"
+
+
+namespace Humpback
+{
+	class JobSystem;
+
+
+	// 20 byte alternative to Vertex, the attributes keep its order so the input layouts line up.
+	struct PackedVertex
+	{
+		uint16_t position[4];	// R16G16B16A16_UNORM inside the submesh bounds, w is the tangent sign (0 is -1).
+		int16_t normal[2];		// R16G16_SNORM octahedral.
+		uint16_t uv[2];			// R16G16_FLOAT.
+		int16_t tangent[2];		// R16G16_SNORM octahedral.
+	};
+
+	// Position stream of packed meshes for the depth-only passes.
+	struct PackedPosition
+	{
+		uint16_t position[4];
+	};
+
+	static_assert(sizeof(PackedVertex) == 20, "PackedVertex must match the packed input layout.");
+	static_assert(sizeof(PackedPosition) == 8, "PackedPosition must match the packed input layout.");
+
+	// Packed positions decode to offset + unorm * scale in object space. The default leaves
+	// float positions unchanged.
+	struct PositionQuantization
+	{
+		DirectX::XMFLOAT3 scale = { 1.0f, 1.0f, 1.0f };
+		DirectX::XMFLOAT3 offset = { 0.0f, 0.0f, 0.0f };
+	};
+
+	// Spreads the 16 bit range over the box, the error on each axis is at most extents / 65535.
+	PositionQuantization GetPositionQuantization(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+
+	// tangentSigns may be null, the bitangent is then cross(normal, tangent) as for Vertex.
+	// Positions outside the quantization box are clamped to it. Large ranges are split across pJobSystem.
+	void PackVertices(const Vertex* vertices, size_t count, const PositionQuantization& quantization,
+		PackedVertex* packed, const float* tangentSigns = nullptr, JobSystem* pJobSystem = nullptr);
+	Vertex UnpackVertex(const PackedVertex& packed, const PositionQuantization& quantization, float* pTangentSign = nullptr);
+
+	std::vector<PackedPosition> BuildPackedPositionStream(const std::vector<PackedVertex>& vertices);
+
+	// The building blocks, DecodeOctahedral mirrors the one in Common.hlsl. The encoder picks the neighbouring
+	// code that decodes closest to direction. Zero or NaN directions encode to +Z.
+	void EncodeOctahedral(const DirectX::XMFLOAT3& direction, int16_t encoded[2]);
+	DirectX::XMFLOAT3 DecodeOctahedral(const int16_t encoded[2]);
+
+	// Round to nearest even, overflow goes to infinity and NaN stays NaN.
+	uint16_t FloatToHalf(float value);
+	float HalfToFloat(uint16_t value);
+}
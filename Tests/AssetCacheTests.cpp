@@ -0,0 +1,219 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "TestHarness.h"
+#include "AssetCache.h"
+#include "CookedMesh.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	// A cache directory of its own, removed again when the test case ends.
+	struct TempDirectory
+	{
+		std::filesystem::path path;
+
+		explicit TempDirectory(const char* name) :
+			path(std::filesystem::temp_directory_path() / name)
+		{
+			std::filesystem::remove_all(path);
+		}
+
+		~TempDirectory()
+		{
+			std::error_code error;
+			std::filesystem::remove_all(path, error);
+		}
+	};
+
+	std::vector<uint8_t> MakeSource(uint8_t seed)
+	{
+		std::vector<uint8_t> bytes(100000);
+		for (size_t i = 0; i < bytes.size(); i++)
+		{
+			bytes[i] = (uint8_t)(i * 31 + seed);
+		}
+		return bytes;
+	}
+
+	std::vector<uint8_t> MakeCookedMesh()
+	{
+		std::vector<float> positions(3 * 300);
+		std::vector<uint32_t> indices(900);
+		for (size_t i = 0; i < positions.size(); i++)
+		{
+			positions[i] = (float)i;
+		}
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			indices[i] = (uint32_t)(i * 7 % 300);
+		}
+
+		CookedMeshSource source;
+		source.vertices = positions.data();
+		source.vertexCount = 300;
+		source.vertexStride = 12;
+		source.indices = indices.data();
+		source.indexCount = 900;
+		source.positions = positions.data();
+
+		CookedSubMesh subMesh = {};
+		subMesh.indexCount = 900;
+		source.subMeshes.push_back(subMesh);
+
+		return BuildCookedMesh({ source }, {});
+	}
+
+	// What HMeshImporter does with a cache entry: map it, validate it and reject it if it is unusable.
+	bool LoadCooked(AssetCache& cache, const std::string& key)
+	{
+		MappedFile file;
+		if (cache.Load(key, file) == false)
+		{
+			return false;
+		}
+
+		CookedMeshFile cooked;
+		if (cooked.Open(file.GetData(), file.GetSize()) == false)
+		{
+			cache.Reject(file);
+			return false;
+		}
+
+		return true;
+	}
+}
+
+
+TEST_CASE("Keys depend on the source bytes and the salt")
+{
+	std::vector<uint8_t> a = MakeSource(1);
+	std::vector<uint8_t> b = MakeSource(2);
+
+	std::string key = AssetCache::ComputeKey(a.data(), a.size(), "flags 1");
+	CHECK(key.size() == 64);
+	CHECK(key == AssetCache::ComputeKey(a.data(), a.size(), "flags 1"));
+	CHECK(key != AssetCache::ComputeKey(b.data(), b.size(), "flags 1"));
+	CHECK(key != AssetCache::ComputeKey(a.data(), a.size(), "flags 2"));
+
+	CHECK(AssetCache::ComputeKey("does/not/exist.fbx", "flags 1").empty());
+}
+
+TEST_CASE("The key of a file matches the key of its bytes")
+{
+	TempDirectory directory("HumpbackAssetCacheKey");
+	std::filesystem::create_directories(directory.path);
+
+	std::vector<uint8_t> bytes = MakeSource(3);
+	std::string path = (directory.path / "source.bin").string();
+	std::ofstream(path, std::ios::binary).write((const char*)bytes.data(), bytes.size());
+
+	CHECK(AssetCache::ComputeKey(path, "salt") == AssetCache::ComputeKey(bytes.data(), bytes.size(), "salt"));
+}
+
+TEST_CASE("A stored entry is a hit after a re-import and a restart")
+{
+	TempDirectory directory("HumpbackAssetCacheHit");
+	std::vector<uint8_t> source = MakeSource(4);
+	std::vector<uint8_t> cooked = MakeCookedMesh();
+	std::string key = AssetCache::ComputeKey(source.data(), source.size(), "importer 1");
+
+	{
+		AssetCache cache(directory.path.string());
+		CHECK(LoadCooked(cache, key) == false);
+		CHECK(cache.Store(key, cooked));
+
+		// Importing the same source again stores identical bytes under the same key.
+		CHECK(cache.Store(key, cooked));
+		CHECK(LoadCooked(cache, key));
+
+		AssetCacheStats stats = cache.GetStats();
+		CHECK(stats.hits == 1);
+		CHECK(stats.misses == 1);
+		CHECK(stats.bytesWritten == 2 * cooked.size());
+		CHECK(stats.bytesRead == cooked.size());
+	}
+
+	// The next launch reads the entry without importing.
+	AssetCache cache(directory.path.string());
+	MappedFile file;
+	CHECK(cache.Load(key, file));
+	CHECK(file.GetSize() == cooked.size());
+	CHECK(std::memcmp(file.GetData(), cooked.data(), cooked.size()) == 0);
+
+	// No temporary files are left behind.
+	unsigned int fileCount = 0;
+	for (const auto& entry : std::filesystem::directory_iterator(directory.path))
+	{
+		(void)entry;
+		fileCount++;
+	}
+	CHECK(fileCount == 1);
+
+	// An edited source or a new importer misses.
+	CHECK(cache.Load(AssetCache::ComputeKey(source.data(), source.size(), "importer 2"), file) == false);
+	source[500]++;
+	CHECK(cache.Load(AssetCache::ComputeKey(source.data(), source.size(), "importer 1"), file) == false);
+}
+
+TEST_CASE("Truncated and corrupted entries are rejected")
+{
+	TempDirectory directory("HumpbackAssetCacheCorrupt");
+	AssetCache cache(directory.path.string());
+	std::vector<uint8_t> cooked = MakeCookedMesh();
+
+	const std::string truncatedKey(64, 'a');
+	const std::string corruptedKey(64, 'b');
+	const std::string emptyKey(64, 'c');
+	CHECK(cache.Store(truncatedKey, cooked));
+	CHECK(cache.Store(corruptedKey, cooked));
+	CHECK(cache.Store(emptyKey, cooked));
+	CHECK(LoadCooked(cache, truncatedKey));
+
+	// A crash or a full disk while another tool wrote the entry.
+	std::filesystem::resize_file(directory.path / truncatedKey, cooked.size() - 100);
+	std::filesystem::resize_file(directory.path / emptyKey, 0);
+
+	// A record pointing past the end of the file.
+	{
+		std::fstream file(directory.path / corruptedKey, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(sizeof(CookedMeshHeader) + offsetof(CookedMeshRecord, vertexOffset));
+		uint64_t offset = cooked.size();
+		file.write((const char*)&offset, sizeof(offset));
+	}
+
+	CHECK(LoadCooked(cache, truncatedKey) == false);
+	CHECK(LoadCooked(cache, corruptedKey) == false);
+	CHECK(LoadCooked(cache, emptyKey) == false);
+
+	// Rejected entries count as misses, so only the first load is a hit.
+	AssetCacheStats stats = cache.GetStats();
+	CHECK(stats.hits == 1);
+	CHECK(stats.misses == 3);
+	CHECK(stats.bytesRead == cooked.size());
+
+	// Storing the entry again repairs it.
+	CHECK(cache.Store(truncatedKey, cooked));
+	CHECK(LoadCooked(cache, truncatedKey));
+}
+
+TEST_CASE("Storing with an empty key fails")
+{
+	TempDirectory directory("HumpbackAssetCacheEmptyKey");
+	AssetCache cache(directory.path.string());
+
+	CHECK(cache.Store("", MakeCookedMesh()) == false);
+
+	MappedFile file;
+	CHECK(cache.Load("", file) == false);
+	CHECK(cache.GetStats().misses == 1);
+}
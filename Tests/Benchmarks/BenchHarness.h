@@ -0,0 +1,49 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+
+namespace Humpback
+{
+	namespace Bench
+	{
+		// Runs func repeatedly and returns the median wall time of one run in milliseconds.
+		template<typename Func>
+		double MeasureMs(unsigned int runs, Func&& func)
+		{
+			std::vector<double> times;
+			times.reserve(runs);
+
+			for (unsigned int i = 0; i < runs; i++)
+			{
+				auto start = std::chrono::steady_clock::now();
+				func();
+				auto end = std::chrono::steady_clock::now();
+
+				times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+			}
+
+			std::sort(times.begin(), times.end());
+			return times[times.size() / 2];
+		}
+
+		// Keeps the optimizer from discarding a result which is otherwise unused.
+		template<typename T>
+		void DoNotOptimize(const T& value)
+		{
+#if defined(_MSC_VER)
+			static const void* volatile sink;
+			sink = &value;
+#else
+			asm volatile("" : : "g"(&value) : "memory");
+#endif
+		}
+	}
+}
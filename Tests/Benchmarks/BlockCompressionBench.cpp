@@ -0,0 +1,83 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cmath>
+
+#include "Benchmarks/BenchHarness.h"
+#include "BlockCompression.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include "MipChain.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	// Gradients with some detail, closer to real textures than noise, which would make every fit equally hard.
+	DecodedImage MakeImage(uint32_t size)
+	{
+		DecodedImage image;
+		image.width = size;
+		image.height = size;
+		image.pixels.resize(image.GetRowPitch() * size);
+
+		for (uint32_t y = 0; y < size; y++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				const float u = (float)x / size;
+				const float v = (float)y / size;
+				uint8_t* p = &image.pixels[((size_t)y * size + x) * 4];
+				p[0] = (uint8_t)(127.5f + 127.5f * std::sin(40.0f * u * v));
+				p[1] = (uint8_t)(255.0f * v);
+				p[2] = (uint8_t)(127.5f + 127.5f * std::cos(25.0f * u));
+				p[3] = (uint8_t)(((x / 16 + y / 16) & 1) != 0 ? 255 : 96);
+			}
+		}
+		GenerateMipChain(image, {});
+		return image;
+	}
+}
+
+
+int main()
+{
+	JobSystem jobSystem;
+	const bool hasSse41 = GetCpuFeatures().sse41;
+	const char* names[] = { "BC1", "BC4", "BC5", "BC7" };
+	const BlockFormat formats[] = { BlockFormat::BC1, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 };
+
+	std::printf("%8s %8s %8s %12s %12s %10s %12s\n", "size", "format", "jobs", "scalar ms", "SSE4.1 ms", "speedup", "Mtexel/s");
+
+	for (uint32_t size : { 512u, 2048u })
+	{
+		DecodedImage image = MakeImage(size);
+		const double texels = (double)size * size * 4.0 / 3.0;
+
+		for (int f = 0; f < 4; f++)
+		{
+			for (JobSystem* pJobSystem : { (JobSystem*)nullptr, &jobSystem })
+			{
+				std::vector<uint8_t> dds;
+				auto run = [&]()
+					{
+						EncodeBlockCompressedDds(image, formats[f], dds, pJobSystem);
+						Bench::DoNotOptimize(dds.data());
+					};
+
+				RestrictCpuFeatures({ false, false, false });
+				double scalarMs = Bench::MeasureMs(3, run);
+				RestrictCpuFeatures({ true, true, true });
+				double simdMs = hasSse41 ? Bench::MeasureMs(3, run) : scalarMs;
+
+				std::printf("%8u %8s %8s %12.1f %12.1f %10.2f %12.1f\n", size, names[f], pJobSystem != nullptr ? "yes" : "no",
+					scalarMs, simdMs, scalarMs / simdMs, texels / (simdMs * 1000.0));
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,190 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <memory>
+#include <random>
+
+#include "Benchmarks/BenchHarness.h"
+#include "BuddyAllocator.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	const uint64_t BLOCK_SIZE = 64ull * 1024 * 1024;
+	const uint64_t MIN_BLOCK_SIZE = 4096;
+
+	struct Allocation
+	{
+		BuddyBlockPool::Allocation placement;
+		uint64_t size;
+	};
+
+	// Resource sizes as GetResourceAllocationInfo reports them for a typical scene: many small
+	// constant and vertex buffers, mid-sized textures and a few large render targets.
+	uint64_t RandomResourceSize(std::mt19937& rng)
+	{
+		unsigned int kind = rng() % 100;
+		if (kind < 50)
+		{
+			return 65536;
+		}
+		if (kind < 80)
+		{
+			return 65536 * (1 + rng() % 16);
+		}
+		if (kind < 97)
+		{
+			return 65536ull << (4 + rng() % 5);
+		}
+		return 8ull * 1024 * 1024 + 65536 * (rng() % 128);
+	}
+
+	// Same as GpuMemoryAllocator::_allocate: first block with room, otherwise a new block.
+	BuddyBlockPool::Allocation Place(BuddyBlockPool& pool, uint64_t size)
+	{
+		BuddyBlockPool::Allocation placement = pool.Allocate(size, 65536);
+		if (placement.block == BuddyBlockPool::INVALID_BLOCK)
+		{
+			pool.AddBlock();
+			placement = pool.Allocate(size, 65536);
+		}
+		return placement;
+	}
+
+	void PrintPool(const char* label, const BuddyBlockPool& pool, size_t resourceCount, uint64_t requested)
+	{
+		uint64_t used = 0;
+		float fragmentation = 0.0f;
+		unsigned int blockCount = 0;
+		for (uint32_t i = 0; i < pool.GetBlockCount(); i++)
+		{
+			if (const BuddyAllocator* block = pool.GetBlock(i))
+			{
+				used += block->GetUsedSize();
+				fragmentation += block->GetFragmentation();
+				blockCount++;
+			}
+		}
+
+		std::printf("%8s %10zu %12.1f %12.1f %10u %12.1f %14.3f\n", label, resourceCount,
+			requested / 1048576.0, blockCount * BLOCK_SIZE / 1048576.0, blockCount,
+			requested > 0 ? 100.0 * (used - requested) / requested : 0.0,
+			blockCount == 0 ? 0.0f : fragmentation / blockCount);
+	}
+}
+
+
+int main()
+{
+	std::printf("Throughput, random allocate/free of 64-256 KB with 65536 alignment in a 1 GB range\n");
+	std::printf("%10s %14s\n", "live", "ns / op");
+
+	for (unsigned int liveTarget : { 16u, 128u, 1024u, 4096u })
+	{
+		BuddyAllocator buddy(1ull << 30, MIN_BLOCK_SIZE);
+		std::mt19937 rng(1);
+		std::vector<uint64_t> live;
+
+		const unsigned int ops = 200000;
+		double ms = Bench::MeasureMs(5, [&]()
+			{
+				for (unsigned int i = 0; i < ops; i++)
+				{
+					if (live.size() < liveTarget || (rng() & 1))
+					{
+						uint64_t offset = buddy.Allocate(65536 * (1 + rng() % 4), 65536);
+						if (offset != BuddyAllocator::INVALID_OFFSET)
+						{
+							live.push_back(offset);
+						}
+					}
+					else
+					{
+						size_t index = rng() % live.size();
+						buddy.Free(live[index]);
+						live[index] = live.back();
+						live.pop_back();
+					}
+				}
+			});
+
+		std::printf("%10u %14.1f\n", liveTarget, ms * 1e6 / ops);
+	}
+
+	std::printf("\nFragmentation of a pool of 64 MB blocks under streaming churn\n");
+	std::printf("%8s %10s %12s %12s %10s %12s %14s\n", "frame", "resources", "requested MB",
+		"reserved MB", "blocks", "rounding %", "fragmentation");
+
+	BuddyBlockPool pool(BLOCK_SIZE, MIN_BLOCK_SIZE);
+	std::mt19937 rng(7);
+	std::vector<Allocation> live;
+	uint64_t requested = 0;
+
+	for (unsigned int frame = 0; frame <= 10000; frame++)
+	{
+		// Streaming: a few resources come and go every frame around a steady working set.
+		unsigned int changes = 1 + rng() % 4;
+		for (unsigned int i = 0; i < changes; i++)
+		{
+			if (live.size() < 2000 && (live.size() < 1500 || (rng() & 1)))
+			{
+				uint64_t size = RandomResourceSize(rng);
+				requested += size;
+				live.push_back({ Place(pool, size), size });
+			}
+			else
+			{
+				size_t index = rng() % live.size();
+				pool.Free(live[index].placement);
+				requested -= live[index].size;
+				live[index] = live.back();
+				live.pop_back();
+			}
+		}
+
+		if (frame % 2000 == 0)
+		{
+			char label[16];
+			std::snprintf(label, sizeof(label), "%u", frame);
+			PrintPool(label, pool, live.size(), requested);
+		}
+	}
+
+	// The working set shrinks to a quarter, then the blocks used less than half are drained the way
+	// GpuMemoryAllocator::Defragment does it.
+	while (live.size() > 500)
+	{
+		size_t index = rng() % live.size();
+		pool.Free(live[index].placement);
+		requested -= live[index].size;
+		live[index] = live.back();
+		live.pop_back();
+	}
+	PrintPool("shrunk", pool, live.size(), requested);
+
+	unsigned int moveCount = 0;
+	double defragmentMs = Bench::MeasureMs(1, [&]()
+		{
+			std::vector<uint32_t> retired = pool.RetireBlocks(0.5f);
+			for (Allocation& allocation : live)
+			{
+				if (pool.IsRetired(allocation.placement.block))
+				{
+					BuddyBlockPool::Allocation target = Place(pool, allocation.size);
+					pool.FreeAfterCopy(allocation.placement);
+					allocation.placement = target;
+					moveCount++;
+				}
+			}
+			pool.FinishSubmission(1);
+			pool.ReleaseCompleted(1);
+		});
+	PrintPool("defrag", pool, live.size(), requested);
+	std::printf("\n%u resources moved, bookkeeping %.3f ms\n", moveCount, defragmentMs);
+
+	return 0;
+}
@@ -0,0 +1,212 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cmath>
+#include <random>
+
+#include "Benchmarks/BenchHarness.h"
+#include "ClusterCuller.h"
+#include "MeshOptimizer.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	struct BenchMesh
+	{
+		const char* name = nullptr;
+		std::vector<float> positions;
+		std::vector<uint32_t> indices;
+		std::vector<Meshlet> meshlets;
+		XMFLOAT3 center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		float radius = 0.0f;
+	};
+
+	// A bumpy sphere, clockwise seen from outside, in the order the importer leaves it.
+	BenchMesh MakeSphere(const char* name, uint32_t stacks, uint32_t slices)
+	{
+		BenchMesh mesh;
+		mesh.name = name;
+		for (uint32_t i = 0; i <= stacks; i++)
+		{
+			for (uint32_t j = 0; j <= slices; j++)
+			{
+				const float theta = 3.14159265f * i / stacks;
+				const float phi = 6.2831853f * j / slices;
+				const float r = 1.0f + 0.2f * std::sin(5.0f * theta) * std::sin(4.0f * phi);
+				mesh.positions.insert(mesh.positions.end(),
+					{ r * std::sin(theta) * std::cos(phi), r * std::cos(theta), r * std::sin(theta) * std::sin(phi) });
+			}
+		}
+		for (uint32_t i = 0; i < stacks; i++)
+		{
+			for (uint32_t j = 0; j < slices; j++)
+			{
+				const uint32_t a = i * (slices + 1) + j;
+				const uint32_t c = a + slices + 1;
+				mesh.indices.insert(mesh.indices.end(), { a, a + 1, c, a + 1, c + 1, c });
+			}
+		}
+		mesh.radius = 1.2f;
+		return mesh;
+	}
+
+	// A terrain like grid facing up.
+	BenchMesh MakeGrid(const char* name, uint32_t size, float extent)
+	{
+		BenchMesh mesh;
+		mesh.name = name;
+		for (uint32_t i = 0; i < size; i++)
+		{
+			for (uint32_t j = 0; j < size; j++)
+			{
+				const float x = -extent + 2.0f * extent * j / (size - 1);
+				const float z = extent - 2.0f * extent * i / (size - 1);
+				mesh.positions.insert(mesh.positions.end(), { x, 0.3f * std::sin(x) * std::cos(z), z });
+			}
+		}
+		for (uint32_t i = 0; i + 1 < size; i++)
+		{
+			for (uint32_t j = 0; j + 1 < size; j++)
+			{
+				const uint32_t a = i * size + j;
+				mesh.indices.insert(mesh.indices.end(), { a, a + 1, a + size, a + size, a + 1, a + size + 1 });
+			}
+		}
+		mesh.radius = extent * 1.4143f;
+		return mesh;
+	}
+
+	ClusterCullingView MakeView(const XMFLOAT3& eye, const XMFLOAT3& target)
+	{
+		const float width = 1920.0f;
+		const float height = 1080.0f;
+		XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&target), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.785f, width / height, 0.5f, 1000.0f);
+
+		ClusterCullingView result;
+		result.frustum = FrustumPlanes::FromViewProj(XMMatrixMultiply(view, proj));
+		XMStoreFloat4x4(&result.view, view);
+		result.cameraPosition = eye;
+		XMFLOAT4X4 p;
+		XMStoreFloat4x4(&p, proj);
+		result.projScaleX = p._11;
+		result.projScaleY = p._22;
+		result.nearZ = 0.5f;
+		result.viewportWidth = width;
+		result.viewportHeight = height;
+		return result;
+	}
+
+	// Cameras on a ring around the center, slightly above it.
+	std::vector<ClusterCullingView> MakeOrbit(const BenchMesh& mesh, float distance, unsigned int count)
+	{
+		std::vector<ClusterCullingView> views;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const float angle = i * 6.2831853f / count;
+			const XMFLOAT3 eye(mesh.center.x + std::sin(angle) * distance, mesh.center.y + 0.3f * distance,
+				mesh.center.z + std::cos(angle) * distance);
+			views.push_back(MakeView(eye, mesh.center));
+		}
+		return views;
+	}
+
+	// Standing on the grid and turning around.
+	std::vector<ClusterCullingView> MakeWalk(unsigned int count)
+	{
+		std::vector<ClusterCullingView> views;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const float angle = i * 6.2831853f / count;
+			views.push_back(MakeView(XMFLOAT3(0.0f, 1.7f, 0.0f), XMFLOAT3(std::sin(angle) * 10.0f, 0.5f, std::cos(angle) * 10.0f)));
+		}
+		return views;
+	}
+}
+
+
+int main()
+{
+	std::vector<BenchMesh> meshes;
+	meshes.push_back(MakeSphere("sphere 32k", 128, 128));
+	meshes.push_back(MakeSphere("sphere 512k", 512, 512));
+	meshes.push_back(MakeGrid("grid 130k", 256, 50.0f));
+
+	std::printf("%-12s %10s %10s %12s %12s %12s\n", "mesh", "triangles", "meshlets", "verts/mlet", "tris/mlet", "build ms");
+	for (BenchMesh& mesh : meshes)
+	{
+		const size_t vertexCount = mesh.positions.size() / 3;
+		OptimizeVertexCache(mesh.indices.data(), mesh.indices.size(), vertexCount, DEFAULT_VERTEX_CACHE_SIZE);
+
+		double buildMs = Bench::MeasureMs(5, [&]()
+			{
+				mesh.meshlets.clear();
+				BuildMeshlets(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), vertexCount, 0, mesh.meshlets);
+			});
+
+		uint64_t vertices = 0;
+		for (const Meshlet& meshlet : mesh.meshlets)
+		{
+			vertices += meshlet.vertexCount;
+		}
+		std::printf("%-12s %10zu %10zu %12.1f %12.1f %12.2f\n", mesh.name, mesh.indices.size() / 3, mesh.meshlets.size(),
+			(double)vertices / mesh.meshlets.size(), mesh.indices.size() / 3.0 / mesh.meshlets.size(), buildMs);
+	}
+
+	std::printf("\n%-12s %-10s %10s %10s %10s %10s %10s %12s\n", "mesh", "view", "culled %", "frustum %", "backface %",
+		"small %", "ranges", "us/object");
+	for (const BenchMesh& mesh : meshes)
+	{
+		struct Scenario
+		{
+			const char* name;
+			std::vector<ClusterCullingView> views;
+		};
+		std::vector<Scenario> scenarios;
+		if (mesh.radius < 10.0f)
+		{
+			scenarios.push_back({ "orbit", MakeOrbit(mesh, 3.0f * mesh.radius, 64) });
+			scenarios.push_back({ "close up", MakeOrbit(mesh, 1.1f * mesh.radius, 64) });
+			scenarios.push_back({ "distant", MakeOrbit(mesh, 300.0f, 64) });
+		}
+		else
+		{
+			scenarios.push_back({ "walk", MakeWalk(64) });
+			scenarios.push_back({ "overview", MakeOrbit(mesh, mesh.radius, 64) });
+		}
+
+		for (const Scenario& scenario : scenarios)
+		{
+			std::vector<IndexRange> ranges;
+			ClusterCullingStats stats;
+			for (const ClusterCullingView& view : scenario.views)
+			{
+				ranges.clear();
+				CullMeshlets(view, mesh.meshlets.data(), (unsigned int)mesh.meshlets.size(), XMMatrixIdentity(), ranges, &stats);
+			}
+
+			double ms = Bench::MeasureMs(5, [&]()
+				{
+					for (const ClusterCullingView& view : scenario.views)
+					{
+						ranges.clear();
+						CullMeshlets(view, mesh.meshlets.data(), (unsigned int)mesh.meshlets.size(), XMMatrixIdentity(), ranges);
+					}
+					Bench::DoNotOptimize(ranges.data());
+				});
+
+			const double count = (double)scenario.views.size();
+			std::printf("%-12s %-10s %10.1f %10.1f %10.1f %10.1f %10.1f %12.1f\n", mesh.name, scenario.name,
+				100.0 * (stats.testedTriangles - stats.visibleTriangles) / stats.testedTriangles,
+				100.0 * stats.frustumCulledCount / stats.testedCount, 100.0 * stats.backfaceCulledCount / stats.testedCount,
+				100.0 * stats.smallCulledCount / stats.testedCount, stats.rangeCount / count, ms * 1000.0 / count);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,308 @@
+// (c) Li Hongcheng
+// 2026-10-17
+//
+// Compares loading a mesh through ASSIMP with mapping its cooked file.
+//
+//   CookedMeshBench [source file]
+//
+// Without a source file a generated OBJ is used. Both paths end with the vertex and index bytes in a
+// staging buffer, which is where the renderer hands them to UploadAllocator.
+
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "assimp/Importer.hpp"
+#include "assimp/postprocess.h"
+#include "assimp/scene.h"
+
+#include "Benchmarks/BenchHarness.h"
+#include "CookedMesh.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	// Same layout as Vertex, without pulling in DirectXMath.
+	struct BenchVertex
+	{
+		float position[3];
+		float normal[3];
+		float uv[2];
+		float tangent[3];
+	};
+
+	static_assert(sizeof(BenchVertex) == 44, "BenchVertex must match Vertex.");
+
+	// The flags HMeshImporter reads its sources with.
+	const unsigned int IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_ConvertToLeftHanded;
+
+	struct ConvertedMesh
+	{
+		std::vector<BenchVertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<float> positions;
+	};
+
+	// A torus of w x h quads per mesh, written as OBJ so ASSIMP has to parse text as it would for a real asset.
+	void WriteTorusObj(const std::string& path, unsigned int meshCount, unsigned int w, unsigned int h)
+	{
+		std::ofstream file(path);
+		unsigned int base = 1;
+
+		for (unsigned int m = 0; m < meshCount; m++)
+		{
+			file << "o mesh" << m << "\n";
+			for (unsigned int y = 0; y < h; y++)
+			{
+				for (unsigned int x = 0; x < w; x++)
+				{
+					float a = 6.2831853f * x / w;
+					float b = 6.2831853f * y / h;
+					float r = 1.0f + 0.3f * std::cos(b);
+					file << "v " << r * std::cos(a) + m * 3.0f << " " << 0.3f * std::sin(b) << " " << r * std::sin(a) << "\n";
+					file << "vn " << std::cos(a) * std::cos(b) << " " << std::sin(b) << " " << std::sin(a) * std::cos(b) << "\n";
+					file << "vt " << (float)x / w << " " << (float)y / h << "\n";
+				}
+			}
+
+			for (unsigned int y = 0; y < h; y++)
+			{
+				for (unsigned int x = 0; x < w; x++)
+				{
+					unsigned int i0 = base + y * w + x;
+					unsigned int i1 = base + y * w + (x + 1) % w;
+					unsigned int i2 = base + ((y + 1) % h) * w + x;
+					unsigned int i3 = base + ((y + 1) % h) * w + (x + 1) % w;
+					file << "f " << i0 << "/" << i0 << "/" << i0 << " " << i1 << "/" << i1 << "/" << i1 << " "
+						<< i3 << "/" << i3 << "/" << i3 << " " << i2 << "/" << i2 << "/" << i2 << "\n";
+				}
+			}
+
+			base += w * h;
+		}
+	}
+
+	std::vector<ConvertedMesh> Convert(const aiScene* pScene)
+	{
+		std::vector<ConvertedMesh> meshes(pScene->mNumMeshes);
+
+		for (unsigned int m = 0; m < pScene->mNumMeshes; m++)
+		{
+			const aiMesh* pAiMesh = pScene->mMeshes[m];
+			ConvertedMesh& mesh = meshes[m];
+
+			mesh.vertices.resize(pAiMesh->mNumVertices);
+			mesh.positions.resize(pAiMesh->mNumVertices * 3);
+			for (unsigned int i = 0; i < pAiMesh->mNumVertices; i++)
+			{
+				BenchVertex& v = mesh.vertices[i];
+				const aiVector3D& p = pAiMesh->mVertices[i];
+				v = {};
+				v.position[0] = mesh.positions[i * 3] = p.x;
+				v.position[1] = mesh.positions[i * 3 + 1] = p.y;
+				v.position[2] = mesh.positions[i * 3 + 2] = p.z;
+				if (pAiMesh->mNormals != nullptr)
+				{
+					v.normal[0] = pAiMesh->mNormals[i].x;
+					v.normal[1] = pAiMesh->mNormals[i].y;
+					v.normal[2] = pAiMesh->mNormals[i].z;
+				}
+				if (pAiMesh->mTextureCoords[0] != nullptr)
+				{
+					v.uv[0] = pAiMesh->mTextureCoords[0][i].x;
+					v.uv[1] = pAiMesh->mTextureCoords[0][i].y;
+				}
+				if (pAiMesh->mTangents != nullptr)
+				{
+					v.tangent[0] = pAiMesh->mTangents[i].x;
+					v.tangent[1] = pAiMesh->mTangents[i].y;
+					v.tangent[2] = pAiMesh->mTangents[i].z;
+				}
+			}
+
+			mesh.indices.reserve(pAiMesh->mNumFaces * 3);
+			for (unsigned int f = 0; f < pAiMesh->mNumFaces; f++)
+			{
+				const aiFace& face = pAiMesh->mFaces[f];
+				if (face.mNumIndices == 3)
+				{
+					mesh.indices.insert(mesh.indices.end(), face.mIndices, face.mIndices + 3);
+				}
+			}
+		}
+
+		return meshes;
+	}
+
+	std::vector<uint8_t> Cook(const std::vector<ConvertedMesh>& meshes)
+	{
+		std::vector<CookedMeshSource> sources(meshes.size());
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			CookedMeshSource& src = sources[i];
+			src.vertices = meshes[i].vertices.data();
+			src.vertexCount = (uint32_t)meshes[i].vertices.size();
+			src.vertexStride = sizeof(BenchVertex);
+			src.indices = meshes[i].indices.data();
+			src.indexCount = (uint32_t)meshes[i].indices.size();
+			src.positions = meshes[i].positions.data();
+
+			CookedSubMesh subMesh = {};
+			std::strncpy(subMesh.name, "mesh", sizeof(subMesh.name) - 1);
+			subMesh.indexCount = src.indexCount;
+			src.subMeshes.push_back(subMesh);
+		}
+
+		return BuildCookedMesh(sources, {});
+	}
+
+	size_t StageAssimp(const std::string& path, std::vector<uint8_t>& staging)
+	{
+		Assimp::Importer importer;
+		const aiScene* pScene = importer.ReadFile(path, IMPORT_FLAGS);
+		if (pScene == nullptr)
+		{
+			return 0;
+		}
+
+		size_t offset = 0;
+		for (const ConvertedMesh& mesh : Convert(pScene))
+		{
+			size_t vertexBytes = mesh.vertices.size() * sizeof(BenchVertex);
+			size_t indexBytes = mesh.indices.size() * sizeof(uint32_t);
+			staging.resize(std::max(staging.size(), offset + vertexBytes + indexBytes));
+			std::memcpy(staging.data() + offset, mesh.vertices.data(), vertexBytes);
+			std::memcpy(staging.data() + offset + vertexBytes, mesh.indices.data(), indexBytes);
+			offset += vertexBytes + indexBytes;
+		}
+
+		return offset;
+	}
+
+	size_t StageCooked(const std::string& path, std::vector<uint8_t>& staging)
+	{
+		CookedMeshFile file;
+		if (file.Open(path) == false)
+		{
+			return 0;
+		}
+
+		size_t offset = 0;
+		for (uint32_t i = 0; i < file.GetMeshCount(); i++)
+		{
+			CookedMeshView view = file.GetMesh(i);
+			staging.resize(std::max(staging.size(), offset + view.vertexByteSize + view.indexByteSize));
+			std::memcpy(staging.data() + offset, view.vertices, view.vertexByteSize);
+			std::memcpy(staging.data() + offset + view.vertexByteSize, view.indices, view.indexByteSize);
+			offset += view.vertexByteSize + view.indexByteSize;
+		}
+
+		return offset;
+	}
+
+	// Drops the file from the page cache so the next load reads it from disk. Not available on Windows,
+	// the cold column is skipped there.
+	bool EvictFromPageCache(const std::string& path)
+	{
+#ifdef _WIN32
+		(void)path;
+		return false;
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+		fdatasync(fd);
+		bool evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+		close(fd);
+		return evicted;
+#endif
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	auto tempDir = std::filesystem::temp_directory_path();
+	std::string sourcePath = argc > 1 ? argv[1] : (tempDir / "HumpbackCookedMeshBench.obj").string();
+	std::string cookedPath = (tempDir / "HumpbackCookedMeshBench.hbmesh").string();
+
+	if (argc <= 1)
+	{
+		// About 4 x 90k vertices, the size of a detailed prop.
+		WriteTorusObj(sourcePath, 4, 300, 300);
+	}
+
+	Assimp::Importer importer;
+	const aiScene* pScene = importer.ReadFile(sourcePath, IMPORT_FLAGS);
+	if (pScene == nullptr)
+	{
+		std::printf("Can't read %s: %s\n", sourcePath.c_str(), importer.GetErrorString());
+		return 1;
+	}
+
+	std::vector<uint8_t> cookedBytes = Cook(Convert(pScene));
+	std::ofstream(cookedPath, std::ios::binary).write((const char*)cookedBytes.data(), cookedBytes.size());
+
+	std::vector<uint8_t> staging;
+	size_t assimpBytes = StageAssimp(sourcePath, staging);
+	size_t cookedStaged = StageCooked(cookedPath, staging);
+	if (assimpBytes == 0 || assimpBytes != cookedStaged)
+	{
+		std::printf("The two paths staged different data: %zu and %zu bytes.\n", assimpBytes, cookedStaged);
+		return 1;
+	}
+
+	std::printf("%s: %u meshes, %.1f MB staged, cooked file %.1f MB\n", sourcePath.c_str(), pScene->mNumMeshes,
+		assimpBytes / 1048576.0, cookedBytes.size() / 1048576.0);
+	std::printf("%10s %12s %12s\n", "path", "warm ms", "cold ms");
+
+	struct Path
+	{
+		const char* name;
+		const std::string& file;
+		size_t (*stage)(const std::string&, std::vector<uint8_t>&);
+	};
+
+	for (const Path& path : { Path{ "ASSIMP", sourcePath, StageAssimp }, Path{ "cooked", cookedPath, StageCooked } })
+	{
+		unsigned int runs = path.stage == StageAssimp ? 5 : 21;
+		double warmMs = Bench::MeasureMs(runs, [&]() { Bench::DoNotOptimize(path.stage(path.file, staging)); });
+
+		double coldMs = Bench::MeasureMs(5, [&]()
+			{
+				// The eviction is part of the measured time but only costs a syscall.
+				EvictFromPageCache(path.file);
+				Bench::DoNotOptimize(path.stage(path.file, staging));
+			});
+
+		if (EvictFromPageCache(path.file))
+		{
+			std::printf("%10s %12.2f %12.2f\n", path.name, warmMs, coldMs);
+		}
+		else
+		{
+			std::printf("%10s %12.2f %12s\n", path.name, warmMs, "-");
+		}
+	}
+
+	std::filesystem::remove(cookedPath);
+	if (argc <= 1)
+	{
+		std::filesystem::remove(sourcePath);
+	}
+
+	return 0;
+}
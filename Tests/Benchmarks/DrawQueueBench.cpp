@@ -0,0 +1,67 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <random>
+
+#include "Benchmarks/BenchHarness.h"
+#include "DrawQueue.h"
+
+
+using namespace Humpback;
+
+
+int main()
+{
+	std::mt19937 rng(3);
+
+	std::printf("%10s %12s %14s %14s %10s\n", "packets", "keys", "radix ms", "std::sort ms", "speedup");
+
+	for (unsigned int count : { 1000u, 10000u, 100000u, 1000000u })
+	{
+		for (int distribution = 0; distribution < 2; distribution++)
+		{
+			// Scene-like keys share most digits, random keys use all eight radix passes.
+			std::vector<uint64_t> keys(count);
+			for (auto& key : keys)
+			{
+				key = distribution == 0 ?
+					DrawQueue::MakeKey(1, rng() % 4, rng() % 500, rng() % 4000, rng() % 300, rng() % 65536) :
+					((uint64_t)rng() << 32) | rng();
+			}
+
+			unsigned int runs = count >= 1000000 ? 11 : 51;
+
+			DrawQueue queue;
+			double radixMs = Bench::MeasureMs(runs, [&]()
+				{
+					queue.Clear();
+					for (unsigned int i = 0; i < count; i++)
+					{
+						queue.Push(keys[i], nullptr);
+					}
+					queue.Sort();
+				});
+
+			std::vector<DrawPacket> packets;
+			double stdMs = Bench::MeasureMs(runs, [&]()
+				{
+					packets.clear();
+					for (unsigned int i = 0; i < count; i++)
+					{
+						packets.push_back({ keys[i], nullptr });
+					}
+					std::sort(packets.begin(), packets.end(), [](const DrawPacket& a, const DrawPacket& b)
+						{
+							return a.key < b.key;
+						});
+				});
+
+			std::printf("%10u %12s %14.3f %14.3f %10.2f\n", count, distribution == 0 ? "scene" : "random",
+				radixMs, stdMs, stdMs / radixMs);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,59 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <random>
+
+#include "Benchmarks/BenchHarness.h"
+#include "CpuFeatures.h"
+#include "FrustumCuller.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+int main()
+{
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> extent(0.1f, 4.0f);
+
+	FrustumPlanes frustum = FrustumPlanes::FromViewProj(XMMatrixMultiply(XMMatrixTranslation(0.0f, -2.0f, 0.0f),
+		XMMatrixPerspectiveFovLH(0.785f, 16.0f / 9.0f, 1.0f, 1000.0f)));
+
+	const CpuFeatures detected = GetCpuFeatures();
+	std::printf("%10s %8s %12s %14s %10s\n", "boxes", "path", "ms", "Mboxes/s", "visible");
+
+	for (unsigned int count : { 1000u, 10000u, 100000u, 1000000u })
+	{
+		FrustumCuller culler;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			culler.AddBox(BoundingBox(XMFLOAT3(position(rng), position(rng) * 0.05f, position(rng)),
+				XMFLOAT3(extent(rng), extent(rng), extent(rng))));
+		}
+
+		for (bool useAvx : { false, true })
+		{
+			if (useAvx && detected.avx == false)
+			{
+				continue;
+			}
+
+			RestrictCpuFeatures({ true, useAvx, useAvx });
+
+			std::vector<unsigned int> visible;
+			visible.reserve(count);
+			double ms = Bench::MeasureMs(count >= 1000000 ? 11 : 101, [&]()
+				{
+					culler.Cull(frustum, visible);
+				});
+
+			std::printf("%10u %8s %12.4f %14.1f %10zu\n", count, useAvx ? "AVX" : "SSE", ms,
+				count / ms / 1000.0, visible.size());
+		}
+	}
+
+	return 0;
+}
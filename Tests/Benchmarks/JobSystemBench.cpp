@@ -0,0 +1,174 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Benchmarks/BenchHarness.h"
+#include "JobSystem.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	// Stands in for ID3D12GraphicsCommandList: every call is encoded into a command buffer
+	// like a driver would do, and counted.
+	class CountingCommandList
+	{
+	public:
+		void Reset()
+		{
+			m_commands.clear();
+			callCount = 0;
+		}
+
+		void SetGraphicsRootConstantBufferView(uint32_t parameter, uint64_t address)
+		{
+			_encode(1, parameter, address);
+		}
+
+		void IASetVertexBuffers(uint64_t address, uint32_t size, uint32_t stride)
+		{
+			_encode(2, size, address ^ stride);
+		}
+
+		void IASetIndexBuffer(uint64_t address, uint32_t size)
+		{
+			_encode(3, size, address);
+		}
+
+		void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, uint32_t startInstance)
+		{
+			_encode(4, indexCount * instanceCount, ((uint64_t)startIndex << 32) | startInstance);
+		}
+
+		uint64_t callCount = 0;
+
+	private:
+		void _encode(uint32_t op, uint32_t a, uint64_t b)
+		{
+			// A little validation work per call, as the debug-free runtime still does.
+			uint64_t hash = (b ^ ((uint64_t)op << 56)) * 0x9E3779B97F4A7C15ull;
+			m_commands.push_back(op | ((uint64_t)a << 8));
+			m_commands.push_back(hash ^ (hash >> 29));
+			++callCount;
+		}
+
+		std::vector<uint64_t> m_commands;
+	};
+
+	struct Draw
+	{
+		uint64_t objectCB;
+		uint64_t vertexBuffer;
+		uint64_t indexBuffer;
+		uint32_t indexCount;
+		uint32_t instanceCount;
+	};
+
+	// Renderer::MinDrawsPerRecordingJob, Renderer.h needs D3D12.
+	const size_t MinDrawsPerRecordingJob = 256;
+
+	void RecordDraws(CountingCommandList& cmdList, const std::vector<Draw>& draws, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			auto& draw = draws[i];
+			cmdList.SetGraphicsRootConstantBufferView(0, draw.objectCB);
+			cmdList.IASetVertexBuffers(draw.vertexBuffer, 1 << 16, 32);
+			cmdList.IASetIndexBuffer(draw.indexBuffer, 1 << 14);
+			cmdList.DrawIndexedInstanced(draw.indexCount, draw.instanceCount, 0, (uint32_t)i);
+		}
+	}
+
+	// Same chunking as Renderer::_recordRenderLayer: at least MinDrawsPerRecordingJob draws per chunk,
+	// at most one chunk per thread, and a single chunk is recorded on the calling thread.
+	uint64_t RecordLayer(JobSystem& jobs, unsigned int threadCount, std::vector<CountingCommandList>& lists,
+		const std::vector<Draw>& draws)
+	{
+		unsigned int chunkCount = (unsigned int)((draws.size() + MinDrawsPerRecordingJob - 1) / MinDrawsPerRecordingJob);
+		chunkCount = std::min(chunkCount, threadCount);
+
+		if (chunkCount <= 1)
+		{
+			lists[0].Reset();
+			RecordDraws(lists[0], draws, 0, draws.size());
+			return lists[0].callCount;
+		}
+
+		size_t chunkSize = (draws.size() + chunkCount - 1) / chunkCount;
+
+		jobs.ParallelFor(chunkCount, [&](unsigned int chunk)
+			{
+				auto& cmdList = lists[chunk];
+				cmdList.Reset();
+
+				size_t begin = chunk * chunkSize;
+				size_t end = std::min(begin + chunkSize, draws.size());
+				RecordDraws(cmdList, draws, begin, end);
+			});
+
+		uint64_t calls = 0;
+		for (unsigned int i = 0; i < chunkCount; i++)
+		{
+			calls += lists[i].callCount;
+		}
+		return calls;
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	const size_t drawCount = 50000;
+
+	std::vector<Draw> draws(drawCount);
+	for (size_t i = 0; i < drawCount; i++)
+	{
+		draws[i] = { 0x10000 + i * 256, 0x200000 + (i % 97) * 65536, 0x900000 + (i % 97) * 16384,
+			(uint32_t)(36 + i % 5000), 1 };
+	}
+
+	// JobSystemBench [max threads], defaults to the hardware threads.
+	unsigned int maxThreads = argc > 1 ? (unsigned int)std::atoi(argv[1]) : std::thread::hardware_concurrency();
+	maxThreads = std::max(1u, maxThreads);
+
+	std::vector<unsigned int> threadCounts;
+	for (unsigned int threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	std::printf("%zu draws, 4 calls each\n", drawCount);
+	std::printf("%8s %10s %10s %10s\n", "threads", "ms", "speedup", "calls");
+
+	double singleMs = 0.0;
+	for (unsigned int threads : threadCounts)
+	{
+		// The calling thread takes part, so one thread needs no worker. The pool has
+		// one at least, it stays idle since a single chunk runs on the caller.
+		auto jobs = std::make_unique<JobSystem>(std::max(1u, threads - 1));
+		std::vector<CountingCommandList> lists(threads);
+
+		uint64_t calls = 0;
+		double ms = Bench::MeasureMs(20, [&]()
+			{
+				calls = RecordLayer(*jobs, threads, lists, draws);
+			});
+
+		if (threads == 1)
+		{
+			singleMs = ms;
+		}
+		std::printf("%8u %10.3f %10.2f %10llu\n", threads, ms, singleMs / ms, (unsigned long long)calls);
+	}
+
+	return 0;
+}
@@ -0,0 +1,161 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cmath>
+#include <memory>
+#include <thread>
+
+#include "Benchmarks/BenchHarness.h"
+#include "MeshCooker.h"
+#include "JobSystem.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	// A width x height patch of a bumpy torus with every attribute the cooker reads.
+	aiMesh* MakeMesh(uint32_t width, uint32_t height, float offset)
+	{
+		aiMesh* mesh = new aiMesh();
+		mesh->mNumVertices = width * height;
+		mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+		mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+		mesh->mTangents = new aiVector3D[mesh->mNumVertices];
+		mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+		mesh->mNumUVComponents[0] = 2;
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				const uint32_t i = y * width + x;
+				const float a = 6.2831853f * x / width;
+				const float b = 6.2831853f * y / height;
+				const float r = 1.0f + 0.3f * std::cos(b);
+				mesh->mVertices[i] = aiVector3D(r * std::cos(a) + offset, 0.3f * std::sin(b), r * std::sin(a));
+				mesh->mNormals[i] = aiVector3D(std::cos(a) * std::cos(b), std::sin(b), std::sin(a) * std::cos(b));
+				mesh->mTangents[i] = aiVector3D(-std::sin(a), 0.0f, std::cos(a));
+				mesh->mTextureCoords[0][i] = aiVector3D((float)x / width, (float)y / height, 0.0f);
+			}
+		}
+
+		mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+		mesh->mNumFaces = 2 * (width - 1) * (height - 1);
+		mesh->mFaces = new aiFace[mesh->mNumFaces];
+		uint32_t face = 0;
+		for (uint32_t y = 0; y + 1 < height; y++)
+		{
+			for (uint32_t x = 0; x + 1 < width; x++)
+			{
+				const uint32_t a = y * width + x;
+				const uint32_t c = a + width;
+				const unsigned int triangles[2][3] = { { a, c, a + 1 }, { a + 1, c, c + 1 } };
+				for (const auto& triangle : triangles)
+				{
+					mesh->mFaces[face].mNumIndices = 3;
+					mesh->mFaces[face].mIndices = new unsigned int[3] { triangle[0], triangle[1], triangle[2] };
+					face++;
+				}
+			}
+		}
+		return mesh;
+	}
+
+	// One node per mesh below the root, plus extraNodes nodes instancing meshes already placed.
+	std::unique_ptr<aiScene> MakeScene(const std::vector<aiMesh*>& meshes, uint32_t extraNodes)
+	{
+		std::unique_ptr<aiScene> scene(new aiScene());
+		scene->mNumMeshes = (unsigned int)meshes.size();
+		scene->mMeshes = new aiMesh*[meshes.size()];
+		std::copy(meshes.begin(), meshes.end(), scene->mMeshes);
+
+		const uint32_t nodeCount = (uint32_t)meshes.size() + extraNodes;
+		aiNode* root = new aiNode();
+		root->mNumChildren = nodeCount;
+		root->mChildren = new aiNode*[nodeCount];
+		for (uint32_t i = 0; i < nodeCount; i++)
+		{
+			aiNode* node = new aiNode();
+			node->mParent = root;
+			node->mNumMeshes = 1;
+			node->mMeshes = new unsigned int[1] { i < meshes.size() ? i : (i * 37) % (uint32_t)meshes.size() };
+			root->mChildren[i] = node;
+		}
+		scene->mRootNode = root;
+		return scene;
+	}
+
+	uint64_t CountFaces(const aiScene* scene)
+	{
+		uint64_t count = 0;
+		for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+		{
+			count += scene->mMeshes[i]->mNumFaces;
+		}
+		return count;
+	}
+}
+
+
+int main()
+{
+	struct Scenario
+	{
+		const char* name;
+		std::unique_ptr<aiScene> scene;
+	};
+	std::vector<Scenario> scenarios;
+
+	// A large mesh that the conversion has to slice, some medium ones and many small ones, a few instanced.
+	std::vector<aiMesh*> meshes = { MakeMesh(450, 450, 0.0f) };
+	for (uint32_t i = 0; i < 20; i++)
+	{
+		meshes.push_back(MakeMesh(100 + i, 100, (float)i));
+	}
+	for (uint32_t i = 0; i < 380; i++)
+	{
+		meshes.push_back(MakeMesh(20 + i % 17, 30 + i % 11, (float)i));
+	}
+	scenarios.push_back({ "mixed", MakeScene(meshes, 40) });
+
+	meshes.clear();
+	for (uint32_t i = 0; i < 400; i++)
+	{
+		meshes.push_back(MakeMesh(40, 40, (float)i));
+	}
+	scenarios.push_back({ "equal", MakeScene(meshes, 0) });
+
+	std::vector<unsigned int> workerCounts = { 0, 1, 3 };
+	const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	if (hardwareThreads > 4)
+	{
+		workerCounts.push_back(hardwareThreads - 1);
+	}
+
+	std::printf("%-8s %8s %10s %10s %12s %12s\n", "scene", "meshes", "faces", "threads", "cook ms", "MB cooked");
+	for (const Scenario& scenario : scenarios)
+	{
+		for (unsigned int workerCount : workerCounts)
+		{
+			std::unique_ptr<JobSystem> jobSystem;
+			if (workerCount > 0)
+			{
+				jobSystem.reset(new JobSystem(workerCount));
+			}
+
+			std::vector<uint8_t> cookedBytes;
+			double ms = Bench::MeasureMs(3, [&]()
+				{
+					MeshCooker::CookScene(scenario.scene.get(), cookedBytes, jobSystem.get());
+				});
+
+			std::printf("%-8s %8u %10llu %10u %12.1f %12.1f\n", scenario.name, scenario.scene->mRootNode->mNumChildren,
+				(unsigned long long)CountFaces(scenario.scene.get()), jobSystem ? jobSystem->GetThreadCount() : 1, ms,
+				cookedBytes.size() / (1024.0 * 1024.0));
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,148 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+
+#include "Benchmarks/BenchHarness.h"
+#include "MeshOptimizer.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	struct BenchVertex
+	{
+		float position[3];
+		float normal[3];
+		float tangent[3];
+		float uv[2];
+	};
+
+	struct BenchMesh
+	{
+		std::vector<BenchVertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<float> positions;
+	};
+
+	// A bumpy lat-long sphere with its vertices and triangles shuffled, like the order importers produce.
+	BenchMesh MakeShuffledSphere(uint32_t stacks, uint32_t slices)
+	{
+		BenchMesh mesh;
+		for (uint32_t i = 0; i <= stacks; i++)
+		{
+			for (uint32_t j = 0; j <= slices; j++)
+			{
+				const float theta = 3.14159265f * i / stacks;
+				const float phi = 6.2831853f * j / slices;
+				const float r = 1.0f + 0.35f * std::sin(6.0f * theta) * std::sin(6.0f * phi);
+				BenchVertex v = {};
+				v.position[0] = r * std::sin(theta) * std::cos(phi);
+				v.position[1] = r * std::cos(theta);
+				v.position[2] = r * std::sin(theta) * std::sin(phi);
+				mesh.vertices.push_back(v);
+			}
+		}
+
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (uint32_t i = 0; i < stacks; i++)
+		{
+			for (uint32_t j = 0; j < slices; j++)
+			{
+				const uint32_t a = i * (slices + 1) + j;
+				const uint32_t c = a + slices + 1;
+				triangles.push_back({ a, c, a + 1 });
+				triangles.push_back({ a + 1, c, c + 1 });
+			}
+		}
+
+		std::mt19937 rng(11);
+		std::vector<uint32_t> remap(mesh.vertices.size());
+		for (uint32_t i = 0; i < remap.size(); i++)
+		{
+			remap[i] = i;
+		}
+		std::shuffle(remap.begin(), remap.end(), rng);
+		std::vector<BenchVertex> shuffled(mesh.vertices.size());
+		for (size_t i = 0; i < mesh.vertices.size(); i++)
+		{
+			shuffled[remap[i]] = mesh.vertices[i];
+		}
+		mesh.vertices.swap(shuffled);
+
+		std::shuffle(triangles.begin(), triangles.end(), rng);
+		for (const auto& t : triangles)
+		{
+			for (uint32_t index : t)
+			{
+				mesh.indices.push_back(remap[index]);
+			}
+		}
+
+		for (const BenchVertex& v : mesh.vertices)
+		{
+			mesh.positions.insert(mesh.positions.end(), v.position, v.position + 3);
+		}
+		return mesh;
+	}
+
+	VertexCacheStats Analyze(const BenchMesh& mesh)
+	{
+		return AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), DEFAULT_VERTEX_CACHE_SIZE);
+	}
+}
+
+
+// The statistics the importer used to print for every scene: ACMR and ATVR before and after each step,
+// and the time each step takes.
+int main()
+{
+	std::printf("%10s %10s %8s %8s %8s %8s %8s %8s %10s %10s %10s\n", "triangles", "vertices", "ACMR in", "cache",
+		"overdraw", "fetch", "ATVR in", "out", "cache ms", "overdr ms", "fetch ms");
+
+	for (uint32_t stacks : { 32u, 128u, 512u })
+	{
+		const BenchMesh source = MakeShuffledSphere(stacks, stacks * 2);
+		const VertexCacheStats input = Analyze(source);
+
+		BenchMesh mesh;
+		std::vector<uint32_t> clusters;
+		double cacheMs = Bench::MeasureMs(5, [&]()
+			{
+				mesh = source;
+				OptimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), DEFAULT_VERTEX_CACHE_SIZE, &clusters);
+			});
+		const BenchMesh afterCache = mesh;
+		const VertexCacheStats cache = Analyze(afterCache);
+
+		double overdrawMs = Bench::MeasureMs(5, [&]()
+			{
+				mesh = afterCache;
+				OptimizeOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.vertices.size(), clusters,
+					DEFAULT_VERTEX_CACHE_SIZE, DEFAULT_OVERDRAW_THRESHOLD);
+			});
+		const BenchMesh afterOverdraw = mesh;
+		const VertexCacheStats overdraw = Analyze(afterOverdraw);
+
+		double fetchMs = Bench::MeasureMs(5, [&]()
+			{
+				mesh = afterOverdraw;
+				OptimizeVertexFetch(mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size(),
+					sizeof(BenchVertex));
+			});
+		const VertexCacheStats fetch = Analyze(mesh);
+
+		// The copies are part of each measurement, small next to the optimizations at these sizes.
+		std::printf("%10llu %10zu %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %10.2f %10.2f %10.2f\n",
+			(unsigned long long)input.triangleCount, source.vertices.size(), input.GetAcmr(), cache.GetAcmr(), overdraw.GetAcmr(),
+			fetch.GetAcmr(), input.GetAtvr(), fetch.GetAtvr(), cacheMs, overdrawMs, fetchMs);
+	}
+
+	return 0;
+}
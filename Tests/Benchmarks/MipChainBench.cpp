@@ -0,0 +1,80 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <random>
+
+#include "Benchmarks/BenchHarness.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include "MipChain.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	DecodedImage MakeNoise(uint32_t size, ImageFormat format)
+	{
+		DecodedImage image;
+		image.width = size;
+		image.height = size;
+		image.format = format;
+		image.pixels.resize(image.GetRowPitch() * size);
+
+		std::mt19937 rng(5);
+		for (uint8_t& byte : image.pixels)
+		{
+			byte = (uint8_t)rng();
+		}
+		return image;
+	}
+}
+
+
+int main()
+{
+	JobSystem jobSystem;
+	const bool hasSse41 = GetCpuFeatures().sse41;
+
+	std::printf("%8s %8s %16s %8s %12s %12s %10s\n", "size", "format", "settings", "jobs", "scalar ms", "SSE4.1 ms", "speedup");
+
+	for (uint32_t size : { 1024u, 2048u })
+	{
+		for (ImageFormat format : { ImageFormat::RGBA8, ImageFormat::RGBA16 })
+		{
+			DecodedImage source = MakeNoise(size, format);
+
+			for (int mode = 0; mode < 3; mode++)
+			{
+				MipChainSettings settings;
+				settings.srgb = mode == 1;
+				settings.preserveAlphaCoverage = mode == 1;
+				settings.normalMap = mode == 2;
+
+				for (JobSystem* pJobSystem : { (JobSystem*)nullptr, &jobSystem })
+				{
+					DecodedImage image;
+					auto run = [&]()
+						{
+							image = source;
+							GenerateMipChain(image, settings, pJobSystem);
+						};
+
+					RestrictCpuFeatures({ false, false, false });
+					double scalarMs = Bench::MeasureMs(5, run);
+					RestrictCpuFeatures({ true, true, true });
+					double simdMs = hasSse41 ? Bench::MeasureMs(5, run) : 0.0;
+
+					std::printf("%8u %8s %16s %8s %12.1f %12.1f %10.2f\n", size,
+						format == ImageFormat::RGBA8 ? "RGBA8" : "RGBA16",
+						mode == 0 ? "linear" : mode == 1 ? "srgb+coverage" : "normal map",
+						pJobSystem != nullptr ? "yes" : "no", scalarMs, simdMs, hasSse41 ? scalarMs / simdMs : 0.0);
+				}
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,176 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <random>
+
+#include "Benchmarks/BenchHarness.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include "OcclusionCuller.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	struct Occluder
+	{
+		XMFLOAT4X4 world;
+		BoundingBox localBox;
+	};
+
+	// Both scenes use the camera buffer size of the renderer.
+	const unsigned int WIDTH = 320;
+	const unsigned int HEIGHT = 180;
+
+	struct Scene
+	{
+		const char* name = nullptr;
+		XMFLOAT4X4 viewProj;
+		std::vector<Occluder> occluders;
+		std::vector<BoundingBox> tested;
+	};
+
+	XMFLOAT4X4 MakeViewProj(FXMVECTOR eye, FXMVECTOR target, float farZ)
+	{
+		XMFLOAT4X4 viewProj;
+		XMStoreFloat4x4(&viewProj, XMMatrixMultiply(XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+			XMMatrixPerspectiveFovLH(0.785f, 16.0f / 9.0f, 1.0f, farZ)));
+		return viewProj;
+	}
+
+	// 40 x 40 blocks with a building each and 4 props around it, seen from the street. The buildings are
+	// tested too, like the renderer tests its occluders.
+	Scene MakeCity()
+	{
+		Scene scene;
+		scene.name = "city";
+		scene.viewProj = MakeViewProj(XMVectorSet(1.0f, 1.8f, -1.0f, 1.0f), XMVectorSet(60.0f, 1.8f, 100.0f, 1.0f), 1000.0f);
+
+		std::mt19937 rng(5);
+		std::uniform_real_distribution<float> height(4.0f, 40.0f);
+		std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+		const BoundingBox unitBox(XMFLOAT3(0.0f, 0.5f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+		for (int z = 0; z < 40; z++)
+		{
+			for (int x = 0; x < 40; x++)
+			{
+				float centerX = (x - 20) * 20.0f + 10.0f;
+				float centerZ = z * 20.0f + 10.0f;
+
+				float buildingHeight = height(rng);
+				Occluder building;
+				XMStoreFloat4x4(&building.world, XMMatrixMultiply(XMMatrixScaling(12.0f, buildingHeight, 12.0f),
+					XMMatrixTranslation(centerX, 0.0f, centerZ)));
+				building.localBox = unitBox;
+				scene.occluders.push_back(building);
+
+				// Props on the sidewalks, each side of the building.
+				for (int side = 0; side < 4; side++)
+				{
+					float dx = side == 0 ? 7.5f : side == 1 ? -7.5f : offset(rng) * 5.0f;
+					float dz = side == 2 ? 7.5f : side == 3 ? -7.5f : offset(rng) * 5.0f;
+					scene.tested.push_back(BoundingBox(XMFLOAT3(centerX + dx, 1.0f, centerZ + dz), XMFLOAT3(0.5f, 1.0f, 0.5f)));
+				}
+				scene.tested.push_back(BoundingBox(XMFLOAT3(centerX, 0.5f * buildingHeight, centerZ),
+					XMFLOAT3(6.0f, 0.5f * buildingHeight, 6.0f)));
+			}
+		}
+
+		return scene;
+	}
+
+	// The renderer's instancing stress scene: 250 x 200 boxes on a 2 m grid, every one an occluder and tested.
+	Scene MakeStress()
+	{
+		Scene scene;
+		scene.name = "stress";
+		scene.viewProj = MakeViewProj(XMVectorSet(0.0f, 6.0f, -220.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), 1000.0f);
+
+		const BoundingBox localBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+		for (int z = 0; z < 200; z++)
+		{
+			for (int x = 0; x < 250; x++)
+			{
+				XMFLOAT3 center((x - 125) * 2.0f, 0.25f, (z - 100) * 2.0f);
+
+				Occluder box;
+				XMStoreFloat4x4(&box.world, XMMatrixTranslation(center.x, center.y, center.z));
+				box.localBox = localBox;
+				scene.occluders.push_back(box);
+
+				scene.tested.push_back(BoundingBox(center, localBox.Extents));
+			}
+		}
+
+		return scene;
+	}
+}
+
+
+int main()
+{
+	JobSystem jobSystem;
+	const CpuFeatures detected = GetCpuFeatures();
+	std::printf("%u threads, AVX2 %s\n\n", jobSystem.GetThreadCount(), detected.avx2 ? "yes" : "no");
+	std::printf("%-8s %6s %8s %10s %8s %14s %10s %8s\n", "scene", "path", "threads", "triangles", "tested",
+		"rasterize ms", "test ms", "hidden");
+
+	Scene scenes[] = { MakeCity(), MakeStress() };
+	for (const Scene& scene : scenes)
+	{
+		// Every path and thread count has to give the same buffer.
+		std::vector<float> firstDepths;
+		for (bool useAvx2 : { false, true })
+		{
+			if (useAvx2 && detected.avx2 == false)
+			{
+				continue;
+			}
+			RestrictCpuFeatures({ true, useAvx2, useAvx2 });
+
+			for (bool useJobSystem : { false, true })
+			{
+				OcclusionCuller culler(WIDTH, HEIGHT, useJobSystem ? &jobSystem : nullptr);
+
+				double rasterizeMs = Bench::MeasureMs(21, [&]()
+					{
+						culler.Begin(XMLoadFloat4x4(&scene.viewProj));
+						for (const Occluder& occluder : scene.occluders)
+						{
+							culler.AddOccluder(XMLoadFloat4x4(&occluder.world), occluder.localBox);
+						}
+						culler.Rasterize();
+					});
+
+				unsigned int hiddenCount = 0;
+				double testMs = Bench::MeasureMs(21, [&]()
+					{
+						hiddenCount = 0;
+						for (const BoundingBox& box : scene.tested)
+						{
+							hiddenCount += culler.IsVisible(box) ? 0 : 1;
+						}
+					});
+				Bench::DoNotOptimize(hiddenCount);
+
+				std::vector<float> depths;
+				culler.GetPixelDepths(depths);
+				if (firstDepths.empty())
+				{
+					firstDepths = depths;
+				}
+
+				std::printf("%-8s %6s %8u %10u %8zu %14.3f %10.3f %8u%s\n", scene.name, useAvx2 ? "AVX2" : "SSE2",
+					useJobSystem ? jobSystem.GetThreadCount() : 1u, culler.GetStats().rasterizedTriangleCount,
+					scene.tested.size(), rasterizeMs, testMs, hiddenCount, depths == firstDepths ? "" : "  MISMATCH");
+			}
+		}
+		RestrictCpuFeatures({ true, true, true });
+	}
+
+	return 0;
+}
@@ -0,0 +1,80 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <string>
+
+#include "Benchmarks/BenchHarness.h"
+#include "RenderGraph.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	// A deferred style frame: every pass reads a few earlier targets and writes its own.
+	void BuildGraph(RenderGraph& graph, unsigned int passCount)
+	{
+		auto backBuffer = graph.ImportResource("BackBuffer", RGResourceState::Present, RGResourceState::Present, true);
+
+		std::vector<RGResourceHandle> targets;
+		for (unsigned int i = 0; i < passCount; i++)
+		{
+			uint64_t size = (uint64_t)(1 + i % 4) * 4 * 1024 * 1024;
+			targets.push_back(graph.CreateTransient("Target" + std::to_string(i), size, 65536));
+		}
+
+		for (unsigned int p = 0; p < passCount; p++)
+		{
+			graph.AddPass("Pass" + std::to_string(p), [&, p](RenderGraph::PassBuilder& builder)
+				{
+					for (unsigned int back = 1; back <= 3 && back * back <= p; back++)
+					{
+						builder.Read(targets[p - back * back], RGResourceState::ShaderResource);
+					}
+					builder.Write(targets[p], RGResourceState::RenderTarget);
+					if (p == passCount - 1)
+					{
+						builder.Write(backBuffer, RGResourceState::RenderTarget);
+					}
+				}, nullptr);
+		}
+	}
+}
+
+
+int main()
+{
+	std::printf("%8s %12s %12s %10s %10s %14s %14s\n",
+		"passes", "build ms", "compile ms", "barriers", "batches", "unaliased MB", "peak MB");
+
+	for (unsigned int passCount : { 8u, 32u, 128u, 512u })
+	{
+		unsigned int runs = passCount >= 512 ? 5 : 50;
+
+		double buildMs = Bench::MeasureMs(runs, [&]()
+			{
+				RenderGraph graph;
+				BuildGraph(graph, passCount);
+				Bench::DoNotOptimize(graph);
+			});
+
+		RenderGraph graph;
+		BuildGraph(graph, passCount);
+		double compileMs = Bench::MeasureMs(runs, [&]()
+			{
+				graph.Compile();
+			});
+
+		RecordingRenderGraphBackend backend;
+		graph.Execute(backend);
+
+		auto& stats = graph.GetStats();
+		std::printf("%8u %12.3f %12.3f %10u %10u %14.1f %14.1f\n", passCount, buildMs, compileMs,
+			stats.barrierCount, stats.barrierBatchCount,
+			stats.transientMemoryUnaliased / (1024.0 * 1024.0), stats.transientMemoryPeak / (1024.0 * 1024.0));
+	}
+
+	return 0;
+}
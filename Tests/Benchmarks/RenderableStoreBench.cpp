@@ -0,0 +1,147 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cstring>
+#include <memory>
+#include <random>
+
+#include "Benchmarks/BenchHarness.h"
+#include "RenderableStore.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	const unsigned int FRAME_RESOURCE_COUNT = 3;
+	const uint32_t OBJECT_COUNT = 1000000;
+	const unsigned int FRAME_COUNT = 30;
+
+	// The per-object state Renderer kept before the store: a heap object with a NumFramesDirty counter.
+	struct OldObject
+	{
+		XMFLOAT4X4 world;
+		int numFramesDirty = FRAME_RESOURCE_COUNT;
+		PositionQuantization quantization;
+		uint32_t materialIndex = 0;
+	};
+}
+
+
+int main()
+{
+	std::printf("%u objects, %u frame resources, ms per frame\n\n", OBJECT_COUNT, FRAME_RESOURCE_COUNT);
+	std::printf("%-10s %12s %12s %12s\n", "changed", "rebuild all", "tracked", "runs");
+
+	for (double fraction : { 0.001, 0.01, 0.1 })
+	{
+		std::vector<std::unique_ptr<OldObject>> oldObjects;
+		RenderableStore store(FRAME_RESOURCE_COUNT);
+		std::vector<ObjectData> oldBuffers[FRAME_RESOURCE_COUNT];
+		std::vector<ObjectData> newBuffers[FRAME_RESOURCE_COUNT];
+		for (unsigned int f = 0; f < FRAME_RESOURCE_COUNT; f++)
+		{
+			oldBuffers[f].resize(OBJECT_COUNT);
+			newBuffers[f].resize(OBJECT_COUNT);
+		}
+
+		for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+		{
+			XMMATRIX world = XMMatrixTranslation((float)i, 0.0f, 0.0f);
+			std::unique_ptr<OldObject> object(new OldObject());
+			XMStoreFloat4x4(&object->world, world);
+			object->materialIndex = i % 7;
+			oldObjects.push_back(std::move(object));
+
+			store.Add(BoundingBox(), PositionQuantization(), i % 7);
+			store.SetWorldTransform(i, world);
+		}
+		store.ClearMoved();
+
+		// Every frame resource takes the initial records before timing.
+		std::vector<UploadTracker::Run> runs;
+		for (unsigned int f = 0; f < FRAME_RESOURCE_COUNT; f++)
+		{
+			runs.clear();
+			store.CollectUploads(f, runs);
+			for (const UploadTracker::Run& run : runs)
+			{
+				std::memcpy(&newBuffers[f][run.first], store.GetObjectData() + run.first, run.count * sizeof(ObjectData));
+			}
+		}
+
+		std::mt19937 rng(1);
+		const uint32_t changeCount = (uint32_t)(OBJECT_COUNT * fraction);
+		std::vector<std::vector<uint32_t>> changed(FRAME_COUNT, std::vector<uint32_t>(changeCount));
+		for (std::vector<uint32_t>& ids : changed)
+		{
+			for (uint32_t& id : ids)
+			{
+				id = rng() % OBJECT_COUNT;
+			}
+		}
+
+		// Set the transforms, scan every object for NumFramesDirty and rebuild every record.
+		unsigned int frame = 0;
+		double oldMs = Bench::MeasureMs(FRAME_COUNT, [&]()
+			{
+				std::vector<ObjectData>& buffer = oldBuffers[frame % FRAME_RESOURCE_COUNT];
+				for (uint32_t id : changed[frame])
+				{
+					XMStoreFloat4x4(&oldObjects[id]->world, XMMatrixTranslation((float)id, (float)frame, 0.0f));
+					oldObjects[id]->numFramesDirty = FRAME_RESOURCE_COUNT;
+				}
+				for (std::unique_ptr<OldObject>& object : oldObjects)
+				{
+					object->numFramesDirty -= object->numFramesDirty > 0 ? 1 : 0;
+				}
+				for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+				{
+					const OldObject& object = *oldObjects[i];
+					ObjectData data;
+					XMStoreFloat4x4(&data.worldMatrix, XMMatrixTranspose(XMLoadFloat4x4(&object.world)));
+					data.positionScale = object.quantization.scale;
+					data.positionOffset = object.quantization.offset;
+					data.materialIndex = object.materialIndex;
+					std::memcpy(&buffer[i], &data, sizeof(data));
+				}
+				frame++;
+			});
+
+		// Set the transforms, collect the stale runs of the frame resource and copy them.
+		frame = 0;
+		size_t runCount = 0;
+		double newMs = Bench::MeasureMs(FRAME_COUNT, [&]()
+			{
+				const unsigned int frameResource = frame % FRAME_RESOURCE_COUNT;
+				for (uint32_t id : changed[frame])
+				{
+					store.SetWorldTransform(id, XMMatrixTranslation((float)id, (float)frame, 0.0f));
+				}
+				store.ClearMoved();
+
+				runs.clear();
+				store.CollectUploads(frameResource, runs);
+				for (const UploadTracker::Run& run : runs)
+				{
+					std::memcpy(&newBuffers[frameResource][run.first], store.GetObjectData() + run.first, run.count * sizeof(ObjectData));
+				}
+				runCount = runs.size();
+				frame++;
+			});
+
+		// Both paths have to leave the same records behind, from the frame resources written last.
+		bool same = true;
+		for (unsigned int f = 0; f < FRAME_RESOURCE_COUNT; f++)
+		{
+			same = same && std::memcmp(oldBuffers[f].data(), newBuffers[f].data(), OBJECT_COUNT * sizeof(ObjectData)) == 0;
+		}
+
+		std::printf("%9.1f%% %12.2f %12.2f %12zu%s\n", fraction * 100.0, oldMs, newMs, runCount, same ? "" : "  MISMATCH");
+	}
+
+	return 0;
+}
@@ -0,0 +1,160 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <random>
+#include <thread>
+
+#include "Benchmarks/BenchHarness.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include "SceneBvh.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	const unsigned int BOX_COUNT = 1000000;
+	const unsigned int FRAME_COUNT = 30;
+
+	// Objects spread over a 2 km square, a few meters high.
+	BoundingBox MakeBox(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+		std::uniform_real_distribution<float> height(0.0f, 100.0f);
+		std::uniform_real_distribution<float> size(0.25f, 2.5f);
+
+		float extent = size(rng);
+		return BoundingBox(XMFLOAT3(position(rng), height(rng), position(rng)), XMFLOAT3(extent, extent, extent));
+	}
+
+	struct Query
+	{
+		const char* name;
+		FrustumPlanes frustum;
+	};
+}
+
+
+int main()
+{
+	std::mt19937 rng(7);
+	JobSystem jobSystem;
+	SceneBvh bvh(&jobSystem);
+	FrustumCuller linear;
+	for (unsigned int i = 0; i < BOX_COUNT; i++)
+	{
+		BoundingBox box = MakeBox(rng);
+		bvh.AddBox(box);
+		linear.AddBox(box);
+	}
+
+	double buildMs = Bench::MeasureMs(1, [&]() { bvh.Update(); });
+	std::printf("%u boxes: build %.1f ms, %u nodes\n\n", BOX_COUNT, buildMs, bvh.GetNodeCount());
+
+	// A camera at the edge of the square and in its middle, and the volume of a directional light.
+	Query queries[] =
+	{
+		{ "camera far 500", FrustumPlanes::FromViewProj(XMMatrixMultiply(XMMatrixTranslation(0.0f, -50.0f, 1000.0f),
+			XMMatrixPerspectiveFovLH(1.0f, 16.0f / 9.0f, 0.1f, 500.0f))) },
+		{ "camera far 2000", FrustumPlanes::FromViewProj(XMMatrixMultiply(XMMatrixTranslation(0.0f, -50.0f, 0.0f),
+			XMMatrixPerspectiveFovLH(1.0f, 16.0f / 9.0f, 0.1f, 2000.0f))) },
+		{ "light volume", FrustumPlanes::FromViewProj(XMMatrixOrthographicOffCenterLH(-150.0f, 150.0f, -50.0f, 150.0f,
+			-200.0f, 200.0f)) },
+	};
+
+	const CpuFeatures detected = GetCpuFeatures();
+	std::printf("%-16s %10s %12s %12s %12s\n", "query", "visible", "linear ms", "BVH SSE ms", "BVH AVX ms");
+	for (const Query& query : queries)
+	{
+		std::vector<unsigned int> visible;
+		visible.reserve(BOX_COUNT);
+
+		double linearMs = Bench::MeasureMs(11, [&]() { linear.Cull(query.frustum, visible); });
+
+		double bvhMs[2] = { 0.0, 0.0 };
+		for (bool useAvx : { false, true })
+		{
+			if (useAvx && detected.avx == false)
+			{
+				continue;
+			}
+
+			RestrictCpuFeatures({ true, useAvx, useAvx });
+			bvhMs[useAvx] = Bench::MeasureMs(11, [&]() { bvh.Cull(query.frustum, visible); });
+		}
+		RestrictCpuFeatures({ true, true, true });
+
+		std::printf("%-16s %10zu %12.3f %12.3f %12.3f\n", query.name, visible.size(), linearMs, bvhMs[0], bvhMs[1]);
+	}
+
+	// A share of the boxes moves a little each frame and the nodes above them are refit.
+	std::printf("\n%-10s %12s %12s %10s\n", "moved", "SetBox ms", "refit ms", "cost");
+	std::uniform_real_distribution<float> jitter(-1.0f, 1.0f);
+	for (double fraction : { 0.001, 0.01, 0.1 })
+	{
+		std::vector<std::vector<std::pair<unsigned int, BoundingBox>>> moves(FRAME_COUNT);
+		for (auto& frameMoves : moves)
+		{
+			for (unsigned int i = 0; i < (unsigned int)(BOX_COUNT * fraction); i++)
+			{
+				unsigned int index = rng() % BOX_COUNT;
+				BoundingBox box = bvh.GetBox(index);
+				box.Center.x += jitter(rng);
+				box.Center.z += jitter(rng);
+				frameMoves.push_back({ index, box });
+			}
+		}
+
+		unsigned int frame = 0;
+		double setMs = Bench::MeasureMs(FRAME_COUNT, [&]()
+			{
+				for (const auto& move : moves[frame])
+				{
+					bvh.SetBox(move.first, move.second);
+				}
+				frame++;
+			});
+
+		// Each frame refits what one frame of moves marked.
+		frame = 0;
+		double refitMs = Bench::MeasureMs(FRAME_COUNT, [&]()
+			{
+				for (const auto& move : moves[frame])
+				{
+					bvh.SetBox(move.first, move.second);
+				}
+				bvh.Update();
+				frame++;
+			}) - setMs;
+
+		std::printf("%9.1f%% %12.3f %12.3f %10.3f\n", fraction * 100.0, setMs, refitMs, bvh.GetCostRatio());
+	}
+
+	// Scattering a fifth of the boxes degrades the tree, the rebuild runs on the job system meanwhile.
+	for (unsigned int i = 0; i < BOX_COUNT / 5; i++)
+	{
+		bvh.SetBox(rng() % BOX_COUNT, MakeBox(rng));
+	}
+	double startMs = Bench::MeasureMs(1, [&]() { bvh.Update(); });
+	float degradedCost = bvh.GetCostRatio();
+
+	unsigned int frameCount = 0;
+	double worstMs = 0.0;
+	auto start = std::chrono::steady_clock::now();
+	while (bvh.GetRebuildCount() == 0)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(16));
+		worstMs = std::max(worstMs, Bench::MeasureMs(1, [&]() { bvh.Update(); }));
+		frameCount++;
+	}
+	double rebuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("\nrebuild: cost %.2f, Update starting it %.3f ms, swapped in after %.0f ms (%u frames, worst Update %.3f ms), "
+		"cost %.2f\n", degradedCost, startMs, rebuildMs, frameCount, worstMs, bvh.GetCostRatio());
+
+	return 0;
+}
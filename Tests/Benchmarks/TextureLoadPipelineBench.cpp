@@ -0,0 +1,126 @@
+// (c) Li Hongcheng
+// 2026-10-17
+//
+// Times TextureLoadPipeline on the textures the renderer loads at startup.
+//
+//   TextureLoadPipelineBench [asset directory]
+//
+// Each configuration is run without a cache, with an empty cache and with a filled one, the stage
+// columns are summed over the worker threads as in TextureLoadTimings.
+
+
+#include <filesystem>
+#include <thread>
+
+#include "Benchmarks/BenchHarness.h"
+#include "AssetCache.h"
+#include "JobSystem.h"
+#include "TextureLoadPipeline.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	// The same limit as the renderer.
+	const uint32_t MAX_TEXTURE_SIZE = 2048;
+
+	std::vector<TextureSource> GetRendererTextures(const std::string& assetDir)
+	{
+		std::vector<TextureSource> sources =
+		{
+			{ "PreviewSphere_Sphere_AlbedoTransparency.png", TextureRole::Albedo },
+			{ "PreviewSphere_Sphere_Normal.png", TextureRole::NormalMap },
+			{ "PreviewSphere_Sphere_MetallicSmoothness.png", TextureRole::Linear },
+			{ "MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_01_Head_AlbedoTransparency.png", TextureRole::Albedo },
+			{ "MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_01_Head_MetallicSmoothness.png", TextureRole::Linear },
+			{ "MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_02_Body_AlbedoTransparency.png", TextureRole::Albedo },
+			{ "MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_02_Body_MetallicSmoothness.png", TextureRole::Linear },
+			{ "MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_03_Base_AlbedoTransparency.png", TextureRole::Albedo },
+			{ "MeetMat/MeetMat_2019_Cameras_03_CleanedMaterialNames_03_Base_MetallicSmoothness.png", TextureRole::Linear },
+			{ "white.png", TextureRole::Linear },
+			{ "black.png", TextureRole::Linear },
+			{ "default_normal_map.png", TextureRole::NormalMap },
+		};
+
+		// Checkouts without some of the assets still time the rest.
+		std::vector<TextureSource> found;
+		for (TextureSource& source : sources)
+		{
+			source.path = assetDir + "/" + source.path;
+			if (std::filesystem::exists(source.path))
+			{
+				found.push_back(source);
+			}
+			else
+			{
+				std::printf("Skipping %s, not found.\n", source.path.c_str());
+			}
+		}
+		return found;
+	}
+
+	void PrintRow(const char* cache, unsigned int workers, bool blockCompress, const TextureLoadTimings& t)
+	{
+		std::printf("%6s %8u %4s %6u %8.1f %10.1f %8.1f %8.1f %8.1f %10.1f %8.1f\n", cache, workers,
+			blockCompress ? "yes" : "no", t.cacheHits, t.decodedBytes / 1048576.0, t.decodeWallMs,
+			t.readMs, t.decodeMs, t.convertMs, t.compressMs, t.cacheWriteMs);
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	std::string assetDir = argc > 1 ? argv[1] : HUMPBACK_SOURCE_DIR "/Assets";
+	std::vector<TextureSource> sources = GetRendererTextures(assetDir);
+
+	std::filesystem::path cacheDir = std::filesystem::temp_directory_path() / "HumpbackTextureLoadPipelineBench";
+
+	// The calling thread works on ParallelFor as well, so there is one more thread than workers.
+	std::vector<unsigned int> workerCounts = { 1, 3 };
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	if (hardwareThreads > 4)
+	{
+		workerCounts.push_back(hardwareThreads - 1);
+	}
+
+	std::printf("%zu textures from %s, size limit %u\n", sources.size(), assetDir.c_str(), MAX_TEXTURE_SIZE);
+	std::printf("%6s %8s %4s %6s %8s %10s %8s %8s %8s %10s %8s\n", "cache", "workers", "bc", "hits", "MB",
+		"wall ms", "read", "decode", "convert", "compress", "write");
+
+	for (bool blockCompress : { false, true })
+	{
+		for (unsigned int workers : workerCounts)
+		{
+			JobSystem jobSystem(workers);
+
+			try
+			{
+				TextureLoadTimings uncached;
+				TextureLoadPipeline(jobSystem, nullptr, MAX_TEXTURE_SIZE, blockCompress).Decode(sources, uncached);
+				PrintRow("none", workers, blockCompress, uncached);
+
+				std::filesystem::remove_all(cacheDir);
+				AssetCache cache(cacheDir.string());
+
+				TextureLoadTimings cold;
+				TextureLoadPipeline(jobSystem, &cache, MAX_TEXTURE_SIZE, blockCompress).Decode(sources, cold);
+				PrintRow("cold", workers, blockCompress, cold);
+
+				TextureLoadTimings warm;
+				TextureLoadPipeline(jobSystem, &cache, MAX_TEXTURE_SIZE, blockCompress).Decode(sources, warm);
+				PrintRow("warm", workers, blockCompress, warm);
+			}
+			catch (const std::exception& e)
+			{
+				std::printf("%s\n", e.what());
+				std::filesystem::remove_all(cacheDir);
+				return 1;
+			}
+		}
+	}
+
+	std::filesystem::remove_all(cacheDir);
+	return 0;
+}
@@ -0,0 +1,177 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <random>
+
+#include "Benchmarks/BenchHarness.h"
+#include "TransformHierarchy.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	const uint32_t NODE_COUNT = 100000;
+	const unsigned int FRAME_COUNT = 200;
+
+	// The pointer tree the hierarchy replaced: children lists and a recursive update of the moved subtrees.
+	struct TreeNode
+	{
+		XMFLOAT4X4A local;
+		XMFLOAT4X4A world;
+		TreeNode* parent = nullptr;
+		std::vector<TreeNode*> children;
+		bool dirty = false;
+	};
+
+	void UpdateSubtree(TreeNode* node, FXMMATRIX parentWorld)
+	{
+		XMMATRIX world = XMMatrixMultiply(XMLoadFloat4x4A(&node->local), parentWorld);
+		XMStoreFloat4x4A(&node->world, world);
+		node->dirty = false;
+		for (TreeNode* child : node->children)
+		{
+			UpdateSubtree(child, world);
+		}
+	}
+
+	XMMATRIX MakeLocalTransform(float angle)
+	{
+		return XMMatrixMultiply(XMMatrixRotationY(angle), XMMatrixTranslation(0.1f, 0.2f, 0.0f));
+	}
+
+	struct Scenario
+	{
+		const char* name;
+		std::vector<uint32_t> parents;
+	};
+
+	// 1000 characters of 100 bones, chains of bones off a spine.
+	Scenario MakeCharacters()
+	{
+		Scenario scenario = { "1000 characters x 100 bones", std::vector<uint32_t>(NODE_COUNT) };
+		for (uint32_t i = 0; i < NODE_COUNT; i++)
+		{
+			uint32_t bone = i % 100;
+			scenario.parents[i] = bone == 0 ? TransformHierarchy::NO_PARENT : (bone % 5 == 1 ? i - bone : i - 1);
+		}
+		return scenario;
+	}
+
+	// Parents within the previous 64 nodes, wide and shallow.
+	Scenario MakeRandomTree(std::mt19937& rng)
+	{
+		Scenario scenario = { "random tree", std::vector<uint32_t>(NODE_COUNT) };
+		for (uint32_t i = 0; i < NODE_COUNT; i++)
+		{
+			scenario.parents[i] = i < 16 ? TransformHierarchy::NO_PARENT : i - 1 - rng() % std::min<uint32_t>(64, i);
+		}
+		return scenario;
+	}
+}
+
+
+int main()
+{
+	std::mt19937 rng(7);
+	std::vector<Scenario> scenarios;
+	scenarios.push_back(MakeCharacters());
+	scenarios.push_back(MakeRandomTree(rng));
+
+	std::printf("%u nodes, 1%% of them re-posed per frame, ms per frame\n\n", NODE_COUNT);
+	std::printf("%-28s %14s %12s %12s %14s\n", "tree", "updates/frame", "dirty pass", "recompute", "pointer tree");
+	for (const Scenario& scenario : scenarios)
+	{
+		TransformHierarchy hierarchy;
+		std::vector<TreeNode> tree(NODE_COUNT);
+		for (uint32_t i = 0; i < NODE_COUNT; i++)
+		{
+			XMMATRIX local = MakeLocalTransform(0.001f * i);
+			hierarchy.AddNode(scenario.parents[i], local);
+
+			XMStoreFloat4x4A(&tree[i].local, local);
+			if (scenario.parents[i] != TransformHierarchy::NO_PARENT)
+			{
+				tree[i].parent = &tree[scenario.parents[i]];
+				tree[i].parent->children.push_back(&tree[i]);
+			}
+		}
+		hierarchy.Update();
+		for (TreeNode& node : tree)
+		{
+			if (node.parent == nullptr)
+			{
+				UpdateSubtree(&node, XMMatrixIdentity());
+			}
+		}
+
+		std::vector<std::vector<uint32_t>> moved(FRAME_COUNT);
+		for (std::vector<uint32_t>& nodes : moved)
+		{
+			for (uint32_t k = 0; k < NODE_COUNT / 100; k++)
+			{
+				nodes.push_back(rng() % NODE_COUNT);
+			}
+		}
+
+		uint64_t updateCount = 0;
+		unsigned int frame = 0;
+		double dirtyMs = Bench::MeasureMs(FRAME_COUNT, [&]()
+			{
+				for (uint32_t node : moved[frame])
+				{
+					hierarchy.SetLocalTransform(node, MakeLocalTransform(0.01f * frame + node));
+				}
+				updateCount += hierarchy.Update().size();
+				frame = (frame + 1) % FRAME_COUNT;
+			});
+
+		// Every world matrix each frame, no dirty tracking.
+		std::vector<XMFLOAT4X4A> world(NODE_COUNT);
+		double recomputeMs = Bench::MeasureMs(FRAME_COUNT, [&]()
+			{
+				for (uint32_t i = 0; i < NODE_COUNT; i++)
+				{
+					XMMATRIX local = hierarchy.GetLocalTransform(i);
+					uint32_t parent = scenario.parents[i];
+					XMStoreFloat4x4A(&world[i], parent == TransformHierarchy::NO_PARENT ? local :
+						XMMatrixMultiply(local, XMLoadFloat4x4A(&world[parent])));
+				}
+				Bench::DoNotOptimize(world.data());
+			});
+
+		// Mark, then recurse from the topmost moved nodes.
+		frame = 0;
+		double treeMs = Bench::MeasureMs(FRAME_COUNT, [&]()
+			{
+				for (uint32_t node : moved[frame])
+				{
+					XMStoreFloat4x4A(&tree[node].local, MakeLocalTransform(0.01f * frame + node));
+					tree[node].dirty = true;
+				}
+				for (uint32_t index : moved[frame])
+				{
+					TreeNode* node = &tree[index];
+					bool ancestorDirty = false;
+					for (TreeNode* parent = node->parent; parent != nullptr && ancestorDirty == false; parent = parent->parent)
+					{
+						ancestorDirty = parent->dirty;
+					}
+					if (node->dirty && ancestorDirty == false)
+					{
+						UpdateSubtree(node, node->parent != nullptr ? XMLoadFloat4x4A(&node->parent->world) : XMMatrixIdentity());
+					}
+				}
+				frame = (frame + 1) % FRAME_COUNT;
+			});
+
+		std::printf("%-28s %14.0f %12.3f %12.3f %14.3f\n", scenario.name, (double)updateCount / FRAME_COUNT, dirtyMs,
+			recomputeMs, treeMs);
+	}
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <random>
+
+#include "Benchmarks/BenchHarness.h"
+#include "JobSystem.h"
+#include "VertexPacking.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+int main()
+{
+	std::mt19937 rng(7);
+	std::normal_distribution<float> normal;
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	const size_t count = 1000000;
+	std::vector<Vertex> vertices(count);
+	std::vector<float> signs(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		Vertex& v = vertices[i];
+		v.position = XMFLOAT3(normal(rng), normal(rng), normal(rng));
+		v.normal = XMFLOAT3(normal(rng), normal(rng), normal(rng));
+		v.tangent = XMFLOAT3(v.normal.y, -v.normal.x, 0.3f);
+		v.uv = XMFLOAT2(unit(rng), unit(rng));
+		signs[i] = i % 3 != 0 ? 1.0f : -1.0f;
+	}
+	const PositionQuantization quantization = GetPositionQuantization(XMFLOAT3(0, 0, 0), XMFLOAT3(6, 6, 6));
+
+	std::vector<PackedVertex> packed(count);
+	std::vector<Vertex> unpacked(count);
+	std::vector<int16_t> codes(count * 2);
+	std::vector<uint16_t> halves(count * 2);
+	JobSystem jobSystem;
+
+	// The parts of PackVertices on their own: two octahedral encodes per vertex dominate.
+	double octahedralMs = Bench::MeasureMs(5, [&]()
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				EncodeOctahedral(vertices[i].normal, &codes[i * 2]);
+			}
+			Bench::DoNotOptimize(codes.data());
+		});
+	double halfMs = Bench::MeasureMs(5, [&]()
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				halves[i * 2] = FloatToHalf(vertices[i].uv.x);
+				halves[i * 2 + 1] = FloatToHalf(vertices[i].uv.y);
+			}
+			Bench::DoNotOptimize(halves.data());
+		});
+	double serialMs = Bench::MeasureMs(5, [&]()
+		{
+			PackVertices(vertices.data(), count, quantization, packed.data(), signs.data());
+			Bench::DoNotOptimize(packed.data());
+		});
+	double parallelMs = Bench::MeasureMs(5, [&]()
+		{
+			PackVertices(vertices.data(), count, quantization, packed.data(), signs.data(), &jobSystem);
+			Bench::DoNotOptimize(packed.data());
+		});
+	double unpackMs = Bench::MeasureMs(5, [&]()
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				unpacked[i] = UnpackVertex(packed[i], quantization);
+			}
+			Bench::DoNotOptimize(unpacked.data());
+		});
+
+	std::printf("%zu vertices, %zu -> %zu bytes each, %u job system threads\n", count, sizeof(Vertex), sizeof(PackedVertex),
+		jobSystem.GetThreadCount());
+	std::printf("%-24s %10s %14s\n", "step", "ms", "M vertices/s");
+	auto printRow = [&](const char* name, double ms)
+		{
+			std::printf("%-24s %10.1f %14.1f\n", name, ms, count / ms / 1000.0);
+		};
+	printRow("octahedral encode", octahedralMs);
+	printRow("float to half (2 uv)", halfMs);
+	printRow("pack, serial", serialMs);
+	printRow("pack, job system", parallelMs);
+	printRow("unpack", unpackMs);
+
+	return 0;
+}
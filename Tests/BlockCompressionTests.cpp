@@ -0,0 +1,524 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+#include "TestHarness.h"
+#include "BlockCompression.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include "MipChain.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	// Magic, DDS_HEADER and DDS_HEADER_DXT10.
+	const size_t DDS_DATA_OFFSET = 4 + 124 + 20;
+
+	const int BC7_WEIGHTS2[4] = { 0, 21, 43, 64 };
+	const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	uint32_t ReadU32(const std::vector<uint8_t>& data, size_t offset)
+	{
+		uint32_t value;
+		std::memcpy(&value, data.data() + offset, 4);
+		return value;
+	}
+
+	class BitReader
+	{
+	public:
+
+		explicit BitReader(const uint8_t* block) : m_block(block) {}
+
+		int Get(int bits)
+		{
+			int value = 0;
+			for (int i = 0; i < bits; i++, m_pos++)
+			{
+				value |= ((m_block[m_pos >> 3] >> (m_pos & 7)) & 1) << i;
+			}
+			return value;
+		}
+
+	private:
+
+		const uint8_t* m_block;
+		int m_pos = 0;
+	};
+
+	// Reference decoders written from the format descriptions, independent of the encoder.
+	// Each fills rgba with the 16 texels of the block, row by row.
+	void DecodeBC1(const uint8_t* block, uint8_t rgba[16][4])
+	{
+		const uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+		const uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+
+		int palette[4][4];
+		for (int k = 0; k < 2; k++)
+		{
+			const uint16_t c = k == 0 ? c0 : c1;
+			const int r = (c >> 11) & 31;
+			const int g = (c >> 5) & 63;
+			const int b = c & 31;
+			palette[k][0] = (r << 3) | (r >> 2);
+			palette[k][1] = (g << 2) | (g >> 4);
+			palette[k][2] = (b << 3) | (b >> 2);
+			palette[k][3] = 255;
+		}
+		for (int ch = 0; ch < 4; ch++)
+		{
+			if (c0 > c1)
+			{
+				palette[2][ch] = (2 * palette[0][ch] + palette[1][ch] + 1) / 3;
+				palette[3][ch] = (palette[0][ch] + 2 * palette[1][ch] + 1) / 3;
+			}
+			else
+			{
+				palette[2][ch] = (palette[0][ch] + palette[1][ch]) / 2;
+				palette[3][ch] = 0;		// Transparent black.
+			}
+		}
+
+		uint32_t indices;
+		std::memcpy(&indices, block + 4, 4);
+		for (int i = 0; i < 16; i++)
+		{
+			for (int ch = 0; ch < 4; ch++)
+			{
+				rgba[i][ch] = (uint8_t)palette[(indices >> (i * 2)) & 3][ch];
+			}
+		}
+	}
+
+	void DecodeBC4(const uint8_t* block, int channel, uint8_t rgba[16][4])
+	{
+		const int r0 = block[0];
+		const int r1 = block[1];
+
+		int palette[8] = { r0, r1 };
+		if (r0 > r1)
+		{
+			for (int k = 1; k < 7; k++)
+			{
+				palette[k + 1] = ((7 - k) * r0 + k * r1 + 3) / 7;
+			}
+		}
+		else
+		{
+			for (int k = 1; k < 5; k++)
+			{
+				palette[k + 1] = ((5 - k) * r0 + k * r1 + 2) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; i++)
+		{
+			indices |= (uint64_t)block[2 + i] << (i * 8);
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			rgba[i][channel] = (uint8_t)palette[(indices >> (i * 3)) & 7];
+		}
+	}
+
+	int InterpolateBC7(int e0, int e1, int weight)
+	{
+		return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+	}
+
+	// Only modes 5 and 6 are produced by the encoder, anything else is reported as a failure.
+	bool DecodeBC7(const uint8_t* block, uint8_t rgba[16][4])
+	{
+		BitReader bits(block);
+		int mode = 0;
+		while (mode < 8 && bits.Get(1) == 0)
+		{
+			mode++;
+		}
+
+		int e0[4];
+		int e1[4];
+		if (mode == 6)
+		{
+			for (int ch = 0; ch < 4; ch++)
+			{
+				e0[ch] = bits.Get(7) << 1;
+				e1[ch] = bits.Get(7) << 1;
+			}
+			const int p0 = bits.Get(1);
+			const int p1 = bits.Get(1);
+			for (int ch = 0; ch < 4; ch++)
+			{
+				e0[ch] |= p0;
+				e1[ch] |= p1;
+			}
+			for (int i = 0; i < 16; i++)
+			{
+				const int index = bits.Get(i == 0 ? 3 : 4);
+				for (int ch = 0; ch < 4; ch++)
+				{
+					rgba[i][ch] = (uint8_t)InterpolateBC7(e0[ch], e1[ch], BC7_WEIGHTS4[index]);
+				}
+			}
+			return true;
+		}
+
+		if (mode == 5)
+		{
+			const int rotation = bits.Get(2);
+			for (int ch = 0; ch < 3; ch++)
+			{
+				e0[ch] = bits.Get(7);
+				e1[ch] = bits.Get(7);
+				e0[ch] = (e0[ch] << 1) | (e0[ch] >> 6);
+				e1[ch] = (e1[ch] << 1) | (e1[ch] >> 6);
+			}
+			e0[3] = bits.Get(8);
+			e1[3] = bits.Get(8);
+			for (int i = 0; i < 16; i++)
+			{
+				const int index = bits.Get(i == 0 ? 1 : 2);
+				for (int ch = 0; ch < 3; ch++)
+				{
+					rgba[i][ch] = (uint8_t)InterpolateBC7(e0[ch], e1[ch], BC7_WEIGHTS2[index]);
+				}
+			}
+			for (int i = 0; i < 16; i++)
+			{
+				const int index = bits.Get(i == 0 ? 1 : 2);
+				rgba[i][3] = (uint8_t)InterpolateBC7(e0[3], e1[3], BC7_WEIGHTS2[index]);
+			}
+			return rotation == 0;
+		}
+
+		return false;
+	}
+
+	// Decodes one level of the DDS into tightly packed RGBA8. Channels the format doesn't store are zero.
+	std::vector<uint8_t> DecodeLevel(const std::vector<uint8_t>& dds, size_t offset, uint32_t width, uint32_t height,
+		BlockFormat format, bool* pValid = nullptr)
+	{
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+		const uint32_t blockSize = GetBlockFormatBlockSize(format);
+
+		std::vector<uint8_t> pixels((size_t)width * height * 4, 0);
+		for (uint32_t by = 0; by < blocksY; by++)
+		{
+			for (uint32_t bx = 0; bx < blocksX; bx++)
+			{
+				const uint8_t* block = dds.data() + offset + ((size_t)by * blocksX + bx) * blockSize;
+				uint8_t rgba[16][4] = {};
+				switch (format)
+				{
+				case BlockFormat::BC1:
+					DecodeBC1(block, rgba);
+					break;
+				case BlockFormat::BC4:
+					DecodeBC4(block, 0, rgba);
+					break;
+				case BlockFormat::BC5:
+					DecodeBC4(block, 0, rgba);
+					DecodeBC4(block + 8, 1, rgba);
+					break;
+				case BlockFormat::BC7:
+					if (DecodeBC7(block, rgba) == false && pValid != nullptr)
+					{
+						*pValid = false;
+					}
+					break;
+				default:
+					break;
+				}
+
+				for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++)
+				{
+					for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++)
+					{
+						std::memcpy(&pixels[(((size_t)by * 4 + y) * width + bx * 4 + x) * 4], rgba[y * 4 + x], 4);
+					}
+				}
+			}
+		}
+		return pixels;
+	}
+
+	int GetChannelCount(BlockFormat format)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			return 3;
+		case BlockFormat::BC4:
+			return 1;
+		case BlockFormat::BC5:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	// PSNR over every level and the channels the format stores, for an RGBA8 image.
+	double ComputePsnr(const DecodedImage& image, BlockFormat format, const std::vector<uint8_t>& dds, bool* pValid = nullptr)
+	{
+		const int channels = GetChannelCount(format);
+		double squaredError = 0.0;
+		uint64_t samples = 0;
+
+		size_t offset = DDS_DATA_OFFSET;
+		for (uint32_t level = 0; level < image.mipLevels; level++)
+		{
+			ImageMipLayout layout = GetImageMipLayout(image.width, image.height, image.format, level);
+			std::vector<uint8_t> decoded = DecodeLevel(dds, offset, layout.width, layout.height, format, pValid);
+			for (uint32_t i = 0; i < layout.width * layout.height; i++)
+			{
+				for (int ch = 0; ch < channels; ch++)
+				{
+					double d = (double)image.pixels[layout.offset + i * 4 + ch] - decoded[i * 4 + ch];
+					squaredError += d * d;
+				}
+			}
+			samples += (uint64_t)layout.width * layout.height * channels;
+			offset += (size_t)((layout.width + 3) / 4) * ((layout.height + 3) / 4) * GetBlockFormatBlockSize(format);
+		}
+
+		const double mse = squaredError / samples;
+		return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+	}
+
+	// Smooth gradients with a soft alpha edge, roughly what albedo and mask textures look like.
+	DecodedImage MakeSmooth(uint32_t width, uint32_t height)
+	{
+		DecodedImage image;
+		image.width = width;
+		image.height = height;
+		image.pixels.resize(image.GetRowPitch() * height);
+
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				const float u = (float)x / width;
+				const float v = (float)y / height;
+				uint8_t* p = &image.pixels[((size_t)y * width + x) * 4];
+				p[0] = (uint8_t)std::lround(255.0f * u);
+				p[1] = (uint8_t)std::lround(127.5f + 127.5f * std::sin(6.0f * v + 2.0f * u));
+				p[2] = (uint8_t)std::lround(255.0f * (1.0f - u) * v);
+				p[3] = (uint8_t)std::lround(255.0f * std::clamp(2.0f * std::sin(4.0f * u) * std::cos(3.0f * v), 0.0f, 1.0f));
+			}
+		}
+		return image;
+	}
+
+	DecodedImage MakeNoise(uint32_t width, uint32_t height, unsigned int seed)
+	{
+		DecodedImage image;
+		image.width = width;
+		image.height = height;
+		image.pixels.resize(image.GetRowPitch() * height);
+
+		std::mt19937 rng(seed);
+		for (uint8_t& byte : image.pixels)
+		{
+			byte = (uint8_t)rng();
+		}
+		return image;
+	}
+
+	const BlockFormat FORMATS[] = { BlockFormat::BC1, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 };
+}
+
+
+TEST_CASE("DDS headers describe every level")
+{
+	DecodedImage image = MakeSmooth(64, 32);
+	GenerateMipChain(image, {});
+	image.srgb = true;
+
+	// DXGI_FORMAT values of the UNORM and UNORM_SRGB variants.
+	const uint32_t dxgiFormats[][2] = { { 71, 72 }, { 80, 80 }, { 83, 83 }, { 98, 99 } };
+	for (int f = 0; f < 4; f++)
+	{
+		const BlockFormat format = FORMATS[f];
+		std::vector<uint8_t> dds;
+		EncodeBlockCompressedDds(image, format, dds);
+
+		uint64_t expectedSize = DDS_DATA_OFFSET;
+		for (uint32_t level = 0; level < image.mipLevels; level++)
+		{
+			ImageMipLayout layout = GetImageMipLayout(64, 32, ImageFormat::RGBA8, level);
+			expectedSize += (uint64_t)((layout.width + 3) / 4) * ((layout.height + 3) / 4) * GetBlockFormatBlockSize(format);
+		}
+		CHECK(dds.size() == expectedSize);
+		CHECK(dds.size() == GetBlockCompressedDdsSize(64, 32, image.mipLevels, format));
+
+		CHECK(ReadU32(dds, 0) == 0x20534444);
+		CHECK(ReadU32(dds, 4) == 124);
+		CHECK(ReadU32(dds, 12) == 32);
+		CHECK(ReadU32(dds, 16) == 64);
+		CHECK(ReadU32(dds, 20) == 16 * 8 * GetBlockFormatBlockSize(format));
+		CHECK(ReadU32(dds, 28) == image.mipLevels);
+		CHECK(ReadU32(dds, 84) == 0x30315844);
+		CHECK(ReadU32(dds, 128) == dxgiFormats[f][1]);
+		CHECK(ReadU32(dds, 132) == 3);
+		CHECK(ReadU32(dds, 140) == 1);
+	}
+
+	image.srgb = false;
+	std::vector<uint8_t> dds;
+	EncodeBlockCompressedDds(image, BlockFormat::BC7, dds);
+	CHECK(ReadU32(dds, 128) == 98);
+}
+
+TEST_CASE("Sizes that aren't whole blocks are rejected")
+{
+	std::vector<uint8_t> dds;
+	CHECK_THROWS(EncodeBlockCompressedDds(MakeNoise(6, 4, 1), BlockFormat::BC1, dds));
+	CHECK_THROWS(EncodeBlockCompressedDds(MakeNoise(4, 2, 1), BlockFormat::BC7, dds));
+	CHECK_THROWS(EncodeBlockCompressedDds(MakeNoise(4, 4, 1), BlockFormat::None, dds));
+
+	CHECK(CanBlockCompress(8, 4));
+	CHECK(CanBlockCompress(4, 6) == false);
+}
+
+TEST_CASE("Constant blocks decode exactly")
+{
+	DecodedImage image = MakeNoise(8, 8, 1);
+	for (size_t i = 0; i < image.pixels.size(); i += 4)
+	{
+		// Exactly representable in RGB565 and with a mode 6 p-bit shared by all channels.
+		image.pixels[i + 0] = 132;
+		image.pixels[i + 1] = 36;
+		image.pixels[i + 2] = 0;
+		image.pixels[i + 3] = 200;
+	}
+
+	for (BlockFormat format : FORMATS)
+	{
+		std::vector<uint8_t> dds;
+		EncodeBlockCompressedDds(image, format, dds);
+		bool valid = true;
+		CHECK(ComputePsnr(image, format, dds, &valid) == 99.0);
+		CHECK(valid);
+	}
+}
+
+TEST_CASE("Decoded quality stays above a PSNR floor")
+{
+	// Measured values sit a few dB above these floors, a drop means the fit or the index search regressed.
+	const double smoothFloor[] = { 38.0, 58.0, 48.0, 41.0 };
+	const double noiseFloor[] = { 13.0, 29.0, 29.0, 14.0 };
+
+	DecodedImage smooth = MakeSmooth(256, 128);
+	GenerateMipChain(smooth, {});
+	DecodedImage noise = MakeNoise(64, 64, 7);
+	GenerateMipChain(noise, {});
+
+	for (int f = 0; f < 4; f++)
+	{
+		std::vector<uint8_t> dds;
+		bool valid = true;
+
+		EncodeBlockCompressedDds(smooth, FORMATS[f], dds);
+		const double smoothPsnr = ComputePsnr(smooth, FORMATS[f], dds, &valid);
+		EncodeBlockCompressedDds(noise, FORMATS[f], dds);
+		const double noisePsnr = ComputePsnr(noise, FORMATS[f], dds, &valid);
+
+		std::printf("  format %d: smooth %.2f dB, noise %.2f dB\n", f, smoothPsnr, noisePsnr);
+		CHECK(smoothPsnr > smoothFloor[f]);
+		CHECK(noisePsnr > noiseFloor[f]);
+		CHECK(valid);
+	}
+}
+
+TEST_CASE("BC7 keeps alpha that doesn't follow the color")
+{
+	// Color and alpha change along different axes, which mode 6 alone can't follow.
+	DecodedImage image = MakeSmooth(32, 32);
+	for (uint32_t y = 0; y < 32; y++)
+	{
+		for (uint32_t x = 0; x < 32; x++)
+		{
+			image.pixels[(y * 32 + x) * 4 + 3] = (uint8_t)(y * 8);
+		}
+	}
+
+	std::vector<uint8_t> dds;
+	EncodeBlockCompressedDds(image, BlockFormat::BC7, dds);
+
+	bool valid = true;
+	std::vector<uint8_t> decoded = DecodeLevel(dds, DDS_DATA_OFFSET, 32, 32, BlockFormat::BC7, &valid);
+	CHECK(valid);
+
+	int worstAlpha = 0;
+	for (size_t i = 3; i < decoded.size(); i += 4)
+	{
+		worstAlpha = std::max(worstAlpha, std::abs((int)decoded[i] - image.pixels[i]));
+	}
+	CHECK(worstAlpha <= 8);
+}
+
+TEST_CASE("Single channel sources fill BC4")
+{
+	DecodedImage image;
+	image.width = 16;
+	image.height = 16;
+	image.format = ImageFormat::R16;
+	image.pixels.resize(image.GetRowPitch() * 16);
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		const uint16_t v = (uint16_t)(i * 257);
+		std::memcpy(&image.pixels[i * 2], &v, 2);
+	}
+
+	std::vector<uint8_t> dds;
+	EncodeBlockCompressedDds(image, BlockFormat::BC4, dds);
+	std::vector<uint8_t> decoded = DecodeLevel(dds, DDS_DATA_OFFSET, 16, 16, BlockFormat::BC4);
+
+	int worst = 0;
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		worst = std::max(worst, std::abs((int)decoded[i * 4] - (int)i));
+	}
+	// A 4x4 block spans a range of 64 over 7 steps.
+	CHECK(worst <= 5);
+}
+
+TEST_CASE("Scalar, SSE4.1 and threaded encodes are identical")
+{
+	JobSystem jobSystem(3);
+	DecodedImage image = MakeSmooth(256, 256);
+	GenerateMipChain(image, {});
+	DecodedImage noise = MakeNoise(128, 64, 3);
+
+	for (const DecodedImage* pImage : { &image, &noise })
+	{
+		for (BlockFormat format : FORMATS)
+		{
+			std::vector<uint8_t> reference;
+			RestrictCpuFeatures({ false, false, false });
+			EncodeBlockCompressedDds(*pImage, format, reference);
+			RestrictCpuFeatures({ true, true, true });
+
+			std::vector<uint8_t> dds;
+			EncodeBlockCompressedDds(*pImage, format, dds);
+			CHECK(dds == reference);
+
+			EncodeBlockCompressedDds(*pImage, format, dds, &jobSystem);
+			CHECK(dds == reference);
+		}
+	}
+}
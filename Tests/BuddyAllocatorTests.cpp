@@ -0,0 +1,350 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "TestHarness.h"
+#include "BuddyAllocator.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	const uint64_t INVALID = BuddyAllocator::INVALID_OFFSET;
+}
+
+
+TEST_CASE("Sizes round up to a power of two block")
+{
+	BuddyAllocator buddy(1 << 20, 4096);
+
+	uint64_t a = buddy.Allocate(5000);
+	CHECK(a == 0);
+	CHECK(buddy.GetUsedSize() == 8192);
+
+	uint64_t b = buddy.Allocate(1);
+	CHECK(b == 8192);
+	CHECK(buddy.GetUsedSize() == 8192 + 4096);
+	CHECK(buddy.GetAllocationCount() == 2);
+
+	CHECK(buddy.Allocate(0) == INVALID);
+	CHECK(buddy.Allocate((1 << 20) + 1) == INVALID);
+}
+
+TEST_CASE("Alignment above the block size is honoured")
+{
+	BuddyAllocator buddy(1 << 20, 4096);
+
+	buddy.Allocate(4096);
+	uint64_t offset = buddy.Allocate(100, 65536);
+	CHECK(offset == 65536);
+	CHECK(offset % 65536 == 0);
+}
+
+TEST_CASE("Freed buddies merge back into one block")
+{
+	BuddyAllocator buddy(1 << 20, 4096);
+
+	std::vector<uint64_t> offsets;
+	for (int i = 0; i < 256; i++)
+	{
+		offsets.push_back(buddy.Allocate(4096));
+	}
+	CHECK(buddy.GetUsedSize() == buddy.GetSize());
+	CHECK(buddy.Allocate(4096) == INVALID);
+
+	// Every other block free: lots of space but none of it contiguous.
+	for (size_t i = 0; i < offsets.size(); i += 2)
+	{
+		buddy.Free(offsets[i]);
+	}
+	CHECK(buddy.GetLargestFreeBlock() == 4096);
+	CHECK(buddy.GetFragmentation() > 0.99f);
+	CHECK(buddy.Allocate(8192) == INVALID);
+
+	for (size_t i = 1; i < offsets.size(); i += 2)
+	{
+		buddy.Free(offsets[i]);
+	}
+	CHECK(buddy.IsEmpty());
+	CHECK(buddy.GetLargestFreeBlock() == buddy.GetSize());
+	CHECK(buddy.GetFragmentation() == 0.0f);
+}
+
+TEST_CASE("Random churn never hands out overlapping ranges")
+{
+	struct Range
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	BuddyAllocator buddy(64ull << 20, 4096);
+	std::mt19937 rng(2);
+	std::vector<Range> live;
+	unsigned int failures = 0;
+
+	for (int i = 0; i < 100000; i++)
+	{
+		if (live.empty() || rng() % 2)
+		{
+			uint64_t size = (4096ull << (rng() % 8)) - rng() % 1000;
+			uint64_t alignment = rng() % 4 == 0 ? 65536 : 1;
+
+			uint64_t offset = buddy.Allocate(size, alignment);
+			if (offset != INVALID)
+			{
+				failures += offset % alignment == 0 && offset + size <= buddy.GetSize() ? 0 : 1;
+				live.push_back({ offset, size });
+			}
+		}
+		else
+		{
+			size_t index = rng() % live.size();
+			buddy.Free(live[index].offset);
+			live[index] = live.back();
+			live.pop_back();
+		}
+	}
+
+	std::sort(live.begin(), live.end(), [](const Range& a, const Range& b) { return a.offset < b.offset; });
+	for (size_t i = 1; i < live.size(); i++)
+	{
+		failures += live[i - 1].offset + live[i - 1].size <= live[i].offset ? 0 : 1;
+	}
+	CHECK(failures == 0);
+	CHECK(buddy.GetAllocationCount() == live.size());
+
+	for (const Range& range : live)
+	{
+		buddy.Free(range.offset);
+	}
+	CHECK(buddy.IsEmpty());
+	CHECK(buddy.GetLargestFreeBlock() == buddy.GetSize());
+}
+
+TEST_CASE("Pool blocks fill in order and released indices are reused")
+{
+	BuddyBlockPool pool(1 << 20, 4096);
+
+	CHECK(pool.Allocate(4096).block == BuddyBlockPool::INVALID_BLOCK);
+	CHECK(pool.AddBlock() == 0);
+
+	BuddyBlockPool::Allocation whole = pool.Allocate(1 << 20);
+	CHECK(whole.block == 0 && whole.offset == 0);
+	CHECK(pool.Allocate(4096).block == BuddyBlockPool::INVALID_BLOCK);
+
+	CHECK(pool.AddBlock() == 1);
+	BuddyBlockPool::Allocation small = pool.Allocate(4096);
+	CHECK(small.block == 1);
+
+	// Block 1 retires and is released once its range moved.
+	pool.Free(whole);
+	CHECK(pool.RetireBlocks(0.5f) == std::vector<uint32_t>{ 1 });
+	pool.FreeAfterCopy(small);
+	pool.FinishSubmission(1);
+	CHECK(pool.ReleaseCompleted(1) == std::vector<uint32_t>{ 1 });
+	CHECK(pool.GetBlock(1) == nullptr);
+	CHECK(pool.GetBlockCount() == 2);
+
+	CHECK(pool.AddBlock() == 1);
+	CHECK(pool.GetBlock(1) != nullptr && pool.GetBlock(1)->IsEmpty());
+	CHECK_THROWS(BuddyBlockPool(1000, 4096));
+}
+
+TEST_CASE("Retiring picks the least used blocks and keeps one open")
+{
+	// Fills each block up while the next ones are made, so every block gets its own share.
+	auto fillBlocks = [](BuddyBlockPool& pool, const std::vector<uint64_t>& sizes)
+		{
+			std::vector<BuddyBlockPool::Allocation> fillers;
+			bool inOrder = true;
+			for (uint64_t size : sizes)
+			{
+				uint32_t block = pool.AddBlock();
+				inOrder = inOrder && pool.Allocate(size).block == block;
+				for (BuddyBlockPool::Allocation filler = pool.Allocate(4096); filler.block != BuddyBlockPool::INVALID_BLOCK;
+					filler = pool.Allocate(4096))
+				{
+					fillers.push_back(filler);
+				}
+			}
+			for (const BuddyBlockPool::Allocation& filler : fillers)
+			{
+				pool.Free(filler);
+			}
+			return inOrder;
+		};
+
+	BuddyBlockPool pool(1 << 20, 4096);
+	CHECK(fillBlocks(pool, { 1 << 18, 1 << 14, 1 << 19, 1 << 12 }));
+	pool.AddBlock();
+
+	// The empty block has nothing to move, the 50% block is over the threshold.
+	CHECK((pool.RetireBlocks(0.4f) == std::vector<uint32_t>{ 3, 1, 0 }));
+	CHECK(pool.IsRetired(0) && pool.IsRetired(1) && pool.IsRetired(3));
+	CHECK(pool.IsRetired(2) == false && pool.IsRetired(4) == false);
+
+	// Retired blocks take no new allocations.
+	CHECK(pool.Allocate(1 << 20).block == 4);
+
+	BuddyBlockPool full(1 << 20, 4096);
+	CHECK(fillBlocks(full, { 4096, 8192, 16384 }));
+	CHECK((full.RetireBlocks(1.0f) == std::vector<uint32_t>{ 0, 1 }));
+	CHECK(full.IsRetired(2) == false);
+	CHECK(full.RetireBlocks(1.0f).empty());
+}
+
+TEST_CASE("Moved ranges are freed after the fence of their copy")
+{
+	BuddyBlockPool pool(1 << 20, 4096);
+	pool.AddBlock();
+	pool.AddBlock();
+	BuddyBlockPool::Allocation a = pool.Allocate(1 << 19);
+	BuddyBlockPool::Allocation b = pool.Allocate(1 << 19);
+	BuddyBlockPool::Allocation c = pool.Allocate(4096);
+	BuddyBlockPool::Allocation d = pool.Allocate(8192);
+	CHECK(a.block == 0 && b.block == 0 && c.block == 1 && d.block == 1);
+
+	CHECK(pool.RetireBlocks(0.25f) == std::vector<uint32_t>{ 1 });
+	CHECK_THROWS(pool.FreeAfterCopy(a));
+
+	// The copies of c and d go out in two submissions.
+	pool.FreeAfterCopy(c);
+	CHECK(pool.ReleaseCompleted(100).empty());
+	pool.FinishSubmission(5);
+	pool.FreeAfterCopy(d);
+	pool.FinishSubmission(6);
+
+	CHECK(pool.ReleaseCompleted(4).empty());
+	CHECK(pool.GetBlock(1)->GetAllocationCount() == 2);
+
+	CHECK(pool.ReleaseCompleted(5).empty());
+	CHECK(pool.GetBlock(1)->GetAllocationCount() == 1);
+	CHECK(pool.IsRetired(1));
+
+	CHECK(pool.ReleaseCompleted(6) == std::vector<uint32_t>{ 1 });
+	CHECK(pool.GetBlock(1) == nullptr);
+	CHECK(pool.GetBlock(0)->GetAllocationCount() == 2);
+}
+
+TEST_CASE("Retired blocks with ranges left in place open again")
+{
+	BuddyBlockPool pool(1 << 20, 4096);
+	pool.AddBlock();
+	pool.AddBlock();
+	pool.Allocate(1 << 19);
+	pool.Allocate(1 << 19);
+	BuddyBlockPool::Allocation moved = pool.Allocate(4096);
+	BuddyBlockPool::Allocation kept = pool.Allocate(4096);
+	CHECK(moved.block == 1 && kept.block == 1);
+
+	// The owner moves one range and refuses the other.
+	CHECK(pool.RetireBlocks(0.25f) == std::vector<uint32_t>{ 1 });
+	pool.FreeAfterCopy(moved);
+	pool.FinishSubmission(1);
+
+	CHECK(pool.ReleaseCompleted(1).empty());
+	CHECK(pool.IsRetired(1) == false);
+	CHECK(pool.GetBlock(1)->GetAllocationCount() == 1);
+	CHECK(pool.Allocate(4096).block == 1);
+}
+
+TEST_CASE("Defragmenting churned blocks frees blocks and keeps the ranges apart")
+{
+	struct Resource
+	{
+		BuddyBlockPool::Allocation allocation;
+		uint64_t size;
+	};
+
+	BuddyBlockPool pool(1 << 22, 4096);
+	std::mt19937 rng(4);
+	std::vector<Resource> live;
+
+	auto place = [&](uint64_t size)
+		{
+			BuddyBlockPool::Allocation allocation = pool.Allocate(size, 65536);
+			if (allocation.block == BuddyBlockPool::INVALID_BLOCK)
+			{
+				pool.AddBlock();
+				allocation = pool.Allocate(size, 65536);
+			}
+			return allocation;
+		};
+
+	for (int i = 0; i < 2000; i++)
+	{
+		uint64_t size = 65536ull * (1 + rng() % 8);
+		live.push_back({ place(size), size });
+	}
+
+	// Most of the resources go away, the rest is spread over every block.
+	for (size_t i = 0; i < live.size();)
+	{
+		if (rng() % 10 != 0)
+		{
+			pool.Free(live[i].allocation);
+			live[i] = live.back();
+			live.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	auto countBlocks = [&]()
+		{
+			unsigned int count = 0;
+			for (uint32_t i = 0; i < pool.GetBlockCount(); i++)
+			{
+				count += pool.GetBlock(i) != nullptr ? 1 : 0;
+			}
+			return count;
+		};
+	unsigned int blocksBefore = countBlocks();
+
+	// Mirrors GpuMemoryAllocator::Defragment, the copies complete with fence 1.
+	std::vector<uint32_t> retired = pool.RetireBlocks(0.5f);
+	CHECK(retired.empty() == false);
+	for (Resource& resource : live)
+	{
+		if (std::find(retired.begin(), retired.end(), resource.allocation.block) != retired.end())
+		{
+			BuddyBlockPool::Allocation target = place(resource.size);
+			CHECK(std::find(retired.begin(), retired.end(), target.block) == retired.end());
+			pool.FreeAfterCopy(resource.allocation);
+			resource.allocation = target;
+		}
+	}
+	pool.FinishSubmission(1);
+	CHECK(pool.ReleaseCompleted(1).size() == retired.size());
+	CHECK(countBlocks() < blocksBefore);
+
+	unsigned int allocationCount = 0;
+	for (uint32_t i = 0; i < pool.GetBlockCount(); i++)
+	{
+		allocationCount += pool.GetBlock(i) != nullptr ? pool.GetBlock(i)->GetAllocationCount() : 0;
+	}
+	CHECK(allocationCount == live.size());
+
+	std::sort(live.begin(), live.end(), [](const Resource& a, const Resource& b)
+		{
+			return a.allocation.block != b.allocation.block ? a.allocation.block < b.allocation.block :
+				a.allocation.offset < b.allocation.offset;
+		});
+	unsigned int overlaps = 0;
+	for (size_t i = 1; i < live.size(); i++)
+	{
+		const BuddyBlockPool::Allocation& a = live[i - 1].allocation;
+		const BuddyBlockPool::Allocation& b = live[i].allocation;
+		overlaps += a.block == b.block && a.offset + live[i - 1].size > b.offset ? 1 : 0;
+	}
+	CHECK(overlaps == 0);
+}
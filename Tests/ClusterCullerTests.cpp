@@ -0,0 +1,382 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <set>
+
+#include "TestHarness.h"
+#include "ClusterCuller.h"
+#include "MeshOptimizer.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	const float VIEWPORT_WIDTH = 1280.0f;
+	const float VIEWPORT_HEIGHT = 720.0f;
+
+	struct TestMesh
+	{
+		std::vector<float> positions;
+		std::vector<uint32_t> indices;
+		std::vector<Meshlet> meshlets;
+	};
+
+	// A bumpy sphere, clockwise seen from outside as imported meshes are, in vertex cache order.
+	TestMesh MakeSphere(uint32_t stacks, uint32_t slices)
+	{
+		TestMesh mesh;
+		for (uint32_t i = 0; i <= stacks; i++)
+		{
+			for (uint32_t j = 0; j <= slices; j++)
+			{
+				const float theta = 3.14159265f * i / stacks;
+				const float phi = 6.2831853f * j / slices;
+				const float r = 1.0f + 0.2f * std::sin(5.0f * theta) * std::sin(4.0f * phi);
+				mesh.positions.insert(mesh.positions.end(),
+					{ r * std::sin(theta) * std::cos(phi), r * std::cos(theta), r * std::sin(theta) * std::sin(phi) });
+			}
+		}
+		for (uint32_t i = 0; i < stacks; i++)
+		{
+			for (uint32_t j = 0; j < slices; j++)
+			{
+				const uint32_t a = i * (slices + 1) + j;
+				const uint32_t c = a + slices + 1;
+				mesh.indices.insert(mesh.indices.end(), { a, a + 1, c, a + 1, c + 1, c });
+			}
+		}
+
+		const size_t vertexCount = mesh.positions.size() / 3;
+		OptimizeVertexCache(mesh.indices.data(), mesh.indices.size(), vertexCount, DEFAULT_VERTEX_CACHE_SIZE);
+		BuildMeshlets(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), vertexCount, 0, mesh.meshlets);
+		return mesh;
+	}
+
+	// A flat grid in the xz plane facing up. Its meshlets start at index 300, like a submesh further into a
+	// shared index buffer.
+	TestMesh MakeGrid(uint32_t rows, uint32_t columns, float size)
+	{
+		TestMesh mesh;
+		for (uint32_t i = 0; i < rows; i++)
+		{
+			for (uint32_t j = 0; j < columns; j++)
+			{
+				mesh.positions.insert(mesh.positions.end(), { -size * 0.5f + size * j / (columns - 1), 0.0f, size * 0.5f - size * i / (rows - 1) });
+			}
+		}
+		for (uint32_t i = 0; i + 1 < rows; i++)
+		{
+			for (uint32_t j = 0; j + 1 < columns; j++)
+			{
+				const uint32_t a = i * columns + j;
+				mesh.indices.insert(mesh.indices.end(), { a, a + 1, a + columns, a + columns, a + 1, a + columns + 1 });
+			}
+		}
+
+		BuildMeshlets(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.positions.size() / 3, 300, mesh.meshlets);
+		return mesh;
+	}
+
+	ClusterCullingView MakeView(const XMFLOAT3& eye, const XMFLOAT3& target, XMMATRIX& viewProj)
+	{
+		XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&target), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		if (std::fabs(eye.x - target.x) < 1e-3f && std::fabs(eye.z - target.z) < 1e-3f)
+		{
+			view = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&target), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f));
+		}
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.785f, VIEWPORT_WIDTH / VIEWPORT_HEIGHT, 1.0f, 1000.0f);
+		viewProj = XMMatrixMultiply(view, proj);
+
+		ClusterCullingView result;
+		result.frustum = FrustumPlanes::FromViewProj(viewProj);
+		XMStoreFloat4x4(&result.view, view);
+		result.cameraPosition = eye;
+		XMFLOAT4X4 p;
+		XMStoreFloat4x4(&p, proj);
+		result.projScaleX = p._11;
+		result.projScaleY = p._22;
+		result.nearZ = 1.0f;
+		result.viewportWidth = VIEWPORT_WIDTH;
+		result.viewportHeight = VIEWPORT_HEIGHT;
+		return result;
+	}
+
+	XMFLOAT3 Transform(const float* p, FXMMATRIX m)
+	{
+		XMFLOAT3 result;
+		XMStoreFloat3(&result, XMVector3TransformCoord(XMVectorSet(p[0], p[1], p[2], 1.0f), m));
+		return result;
+	}
+
+	// Brute force checks that a culled meshlet draws nothing for the reason the stats give.
+	bool IsCulledCorrectly(const TestMesh& mesh, const Meshlet& meshlet, const ClusterCullingStats& stats,
+		const ClusterCullingView& view, FXMMATRIX world, CXMMATRIX viewProj)
+	{
+		const uint32_t first = meshlet.startIndexLocation - mesh.meshlets[0].startIndexLocation;
+		for (uint32_t i = first; i < first + meshlet.indexCount; i += 3)
+		{
+			XMFLOAT3 w[3];
+			for (int k = 0; k < 3; k++)
+			{
+				w[k] = Transform(&mesh.positions[mesh.indices[i + k] * 3], world);
+			}
+
+			if (stats.frustumCulledCount > 0)
+			{
+				// All three corners behind one plane.
+				bool behindOne = false;
+				for (const XMFLOAT4& plane : view.frustum.planes)
+				{
+					bool behindAll = true;
+					for (const XMFLOAT3& p : w)
+					{
+						behindAll = behindAll && plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 0.0f;
+					}
+					behindOne = behindOne || behindAll;
+				}
+				if (behindOne == false)
+				{
+					return false;
+				}
+			}
+			else if (stats.backfaceCulledCount > 0)
+			{
+				// The camera on the back side of the plane. Clockwise triangles face along cross(e1, e2).
+				double e1[3] = { (double)w[1].x - w[0].x, (double)w[1].y - w[0].y, (double)w[1].z - w[0].z };
+				double e2[3] = { (double)w[2].x - w[0].x, (double)w[2].y - w[0].y, (double)w[2].z - w[0].z };
+				double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				double toCamera[3] = { (double)view.cameraPosition.x - w[0].x, (double)view.cameraPosition.y - w[0].y,
+					(double)view.cameraPosition.z - w[0].z };
+				double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				if (length > 1e-12 && n[0] * toCamera[0] + n[1] * toCamera[1] + n[2] * toCamera[2] > 0.0)
+				{
+					return false;
+				}
+			}
+			else
+			{
+				// The screen bounds of the triangle hold no pixel center.
+				float minX = FLT_MAX, maxX = -FLT_MAX, minY = FLT_MAX, maxY = -FLT_MAX;
+				for (const XMFLOAT3& p : w)
+				{
+					XMFLOAT3 ndc;
+					XMStoreFloat3(&ndc, XMVector3TransformCoord(XMLoadFloat3(&p), viewProj));
+					const float x = (ndc.x * 0.5f + 0.5f) * VIEWPORT_WIDTH;
+					const float y = (0.5f - ndc.y * 0.5f) * VIEWPORT_HEIGHT;
+					minX = std::min(minX, x);
+					maxX = std::max(maxX, x);
+					minY = std::min(minY, y);
+					maxY = std::max(maxY, y);
+				}
+				if (std::floor(maxX - 0.5f) >= std::ceil(minX - 0.5f) && std::floor(maxY - 0.5f) >= std::ceil(minY - 0.5f))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Culls every meshlet on its own and checks the culled ones, then culls them all at once and checks the ranges.
+	bool CullAndVerify(const TestMesh& mesh, const ClusterCullingView& view, FXMMATRIX world, CXMMATRIX viewProj,
+		ClusterCullingStats& total)
+	{
+		bool correct = true;
+		std::vector<IndexRange> ranges;
+		for (const Meshlet& meshlet : mesh.meshlets)
+		{
+			ClusterCullingStats stats;
+			ranges.clear();
+			if (CullMeshlets(view, &meshlet, 1, world, ranges, &stats) == 0)
+			{
+				correct = correct && IsCulledCorrectly(mesh, meshlet, stats, view, world, viewProj);
+			}
+		}
+
+		ClusterCullingStats stats;
+		ranges.clear();
+		const unsigned int rangeCount = CullMeshlets(view, mesh.meshlets.data(), (unsigned int)mesh.meshlets.size(), world, ranges, &stats);
+
+		uint64_t triangles = 0;
+		for (size_t i = 0; i < ranges.size(); i++)
+		{
+			triangles += ranges[i].indexCount / 3;
+			// Ranges are in order and touching ones are merged.
+			correct = correct && (i == 0 || ranges[i - 1].startIndexLocation + ranges[i - 1].indexCount < ranges[i].startIndexLocation);
+		}
+		correct = correct && rangeCount == ranges.size() && triangles == stats.visibleTriangles;
+		correct = correct && stats.testedCount == stats.visibleCount + stats.frustumCulledCount + stats.backfaceCulledCount + stats.smallCulledCount;
+
+		total += stats;
+		return correct;
+	}
+
+	std::vector<XMFLOAT3> MakeOrbit(const XMFLOAT3& center, float distance, unsigned int count, unsigned int seed)
+	{
+		std::mt19937 rng(seed);
+		std::normal_distribution<float> normal;
+		std::vector<XMFLOAT3> eyes;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			XMFLOAT3 d(normal(rng), normal(rng), normal(rng));
+			const float length = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+			eyes.push_back(XMFLOAT3(center.x + d.x / length * distance, center.y + d.y / length * distance, center.z + d.z / length * distance));
+		}
+		return eyes;
+	}
+}
+
+
+TEST_CASE("Meshlets cover the mesh in bounded runs")
+{
+	for (const TestMesh& mesh : { MakeSphere(40, 80), MakeGrid(30, 50, 20.0f) })
+	{
+		const uint32_t base = mesh.meshlets[0].startIndexLocation;
+		uint32_t next = base;
+		bool valid = true;
+		for (const Meshlet& meshlet : mesh.meshlets)
+		{
+			valid = valid && meshlet.startIndexLocation == next && meshlet.indexCount % 3 == 0 && meshlet.indexCount > 0;
+			valid = valid && meshlet.indexCount / 3 <= MESHLET_MAX_TRIANGLES;
+			next = meshlet.startIndexLocation + meshlet.indexCount;
+
+			const auto begin = mesh.indices.begin() + (meshlet.startIndexLocation - base);
+			const std::set<uint32_t> vertices(begin, begin + meshlet.indexCount);
+			valid = valid && vertices.size() == meshlet.vertexCount && vertices.size() <= MESHLET_MAX_VERTICES;
+
+			for (uint32_t v : vertices)
+			{
+				const float* p = &mesh.positions[v * 3];
+				const float dx = p[0] - meshlet.center[0];
+				const float dy = p[1] - meshlet.center[1];
+				const float dz = p[2] - meshlet.center[2];
+				valid = valid && std::sqrt(dx * dx + dy * dy + dz * dz) <= meshlet.radius * (1.0f + 1e-5f) + 1e-6f;
+			}
+
+			// Every triangle normal within the cone and every triangle plane in front of the apex.
+			if (meshlet.coneCutoff < 1.0f)
+			{
+				const double cosAngle = std::sqrt(1.0 - (double)meshlet.coneCutoff * meshlet.coneCutoff);
+				for (auto it = begin; it != begin + meshlet.indexCount; it += 3)
+				{
+					const float* a = &mesh.positions[it[0] * 3];
+					const float* b = &mesh.positions[it[1] * 3];
+					const float* c = &mesh.positions[it[2] * 3];
+					double e1[3] = { (double)b[0] - a[0], (double)b[1] - a[1], (double)b[2] - a[2] };
+					double e2[3] = { (double)c[0] - a[0], (double)c[1] - a[1], (double)c[2] - a[2] };
+					double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+					const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+					if (length == 0.0)
+					{
+						continue;
+					}
+					const double along = (n[0] * meshlet.coneAxis[0] + n[1] * meshlet.coneAxis[1] + n[2] * meshlet.coneAxis[2]) / length;
+					const double apex = (n[0] * (a[0] - meshlet.coneApex[0]) + n[1] * (a[1] - meshlet.coneApex[1]) +
+						n[2] * (a[2] - meshlet.coneApex[2])) / length;
+					valid = valid && along >= cosAngle - 1e-6 && apex >= -1e-5;
+				}
+			}
+		}
+		CHECK(valid);
+		CHECK(next == base + mesh.indices.size());
+	}
+}
+
+TEST_CASE("Culled meshlets draw nothing")
+{
+	const TestMesh sphere = MakeSphere(64, 128);
+	const TestMesh grid = MakeGrid(60, 40, 20.0f);
+
+	struct Placement
+	{
+		XMMATRIX world;
+		float distance;
+	};
+	const Placement placements[] =
+	{
+		{ XMMatrixTranslation(2.0f, 1.0f, 0.0f), 3.0f },
+		{ XMMatrixTranslation(2.0f, 1.0f, 0.0f), 0.9f },
+		{ XMMatrixTranslation(2.0f, 1.0f, 0.0f), 400.0f },
+		{ XMMatrixMultiply(XMMatrixScaling(0.3f, 1.5f, 0.6f), XMMatrixTranslation(-4.0f, 0.0f, 0.0f)), 4.0f },
+		{ XMMatrixMultiply(XMMatrixScaling(-1.0f, 1.0f, 1.0f), XMMatrixTranslation(-4.0f, 0.0f, 0.0f)), 3.0f },
+	};
+
+	bool correct = true;
+	ClusterCullingStats total;
+	unsigned int seed = 1;
+	for (const Placement& placement : placements)
+	{
+		XMFLOAT3 center;
+		XMStoreFloat3(&center, placement.world.r[3]);
+		for (const XMFLOAT3& eye : MakeOrbit(center, placement.distance, 48, seed++))
+		{
+			XMMATRIX viewProj;
+			ClusterCullingView view = MakeView(eye, center, viewProj);
+			correct = correct && CullAndVerify(sphere, view, placement.world, viewProj, total);
+		}
+	}
+
+	// Walking over the grid and looking at it from below.
+	for (int i = 0; i < 32; i++)
+	{
+		const float angle = i * 6.2831853f / 32.0f;
+		XMMATRIX viewProj;
+		ClusterCullingView view = MakeView(XMFLOAT3(0.0f, 2.0f, -8.0f), XMFLOAT3(std::sin(angle) * 10.0f, 0.5f, -8.0f + std::cos(angle) * 10.0f), viewProj);
+		correct = correct && CullAndVerify(grid, view, XMMatrixIdentity(), viewProj, total);
+	}
+
+	XMMATRIX viewProj;
+	ClusterCullingView below = MakeView(XMFLOAT3(0.0f, -3.0f, -5.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), viewProj);
+	ClusterCullingStats belowStats;
+	correct = correct && CullAndVerify(grid, below, XMMatrixIdentity(), viewProj, belowStats);
+	total += belowStats;
+
+	CHECK(correct);
+	// Every test took part somewhere.
+	CHECK(total.frustumCulledCount > 0);
+	CHECK(total.backfaceCulledCount > 0);
+	CHECK(total.smallCulledCount > 0);
+	CHECK(belowStats.visibleCount == 0);
+}
+
+TEST_CASE("Disabled tests keep their meshlets")
+{
+	const TestMesh grid = MakeGrid(60, 40, 20.0f);
+	XMMATRIX viewProj;
+	ClusterCullingView view = MakeView(XMFLOAT3(0.0f, -3.0f, -5.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), viewProj);
+
+	// From below every cluster faces away, mirroring the grid turns them around.
+	std::vector<IndexRange> ranges;
+	ClusterCullingStats mirrored;
+	CullMeshlets(view, grid.meshlets.data(), (unsigned int)grid.meshlets.size(), XMMatrixScaling(1.0f, 1.0f, -1.0f), ranges, &mirrored);
+	CHECK(mirrored.backfaceCulledCount == 0);
+
+	view.backfaceCulling = false;
+	ClusterCullingStats noBackface;
+	ranges.clear();
+	CullMeshlets(view, grid.meshlets.data(), (unsigned int)grid.meshlets.size(), XMMatrixIdentity(), ranges, &noBackface);
+	CHECK(noBackface.backfaceCulledCount == 0);
+	CHECK(noBackface.visibleCount > 0);
+
+	// Far away everything is small, unless the pass uses MSAA.
+	const TestMesh sphere = MakeSphere(32, 64);
+	ClusterCullingView far = MakeView(XMFLOAT3(0.0f, 0.0f, -600.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), viewProj);
+	ClusterCullingStats small;
+	ranges.clear();
+	CullMeshlets(far, sphere.meshlets.data(), (unsigned int)sphere.meshlets.size(), XMMatrixIdentity(), ranges, &small);
+	CHECK(small.smallCulledCount > 0);
+
+	far.smallTriangleCulling = false;
+	ClusterCullingStats msaa;
+	ranges.clear();
+	CullMeshlets(far, sphere.meshlets.data(), (unsigned int)sphere.meshlets.size(), XMMatrixIdentity(), ranges, &msaa);
+	CHECK(msaa.smallCulledCount == 0);
+}
@@ -0,0 +1,224 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "TestHarness.h"
+#include "DescriptorIndexAllocator.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	const uint32_t INVALID = DescriptorIndexAllocator::INVALID_INDEX;
+
+	// Pops every free slot, checks each comes out once and returns how many there were.
+	uint32_t DrainDistinct(DescriptorIndexAllocator& allocator, bool& distinct)
+	{
+		std::vector<bool> seen(allocator.GetCapacity(), false);
+		uint32_t count = 0;
+		distinct = true;
+
+		for (uint32_t index = allocator.Allocate(); index != INVALID; index = allocator.Allocate())
+		{
+			distinct &= index < allocator.GetCapacity() && !seen[index];
+			if (index < allocator.GetCapacity())
+			{
+				seen[index] = true;
+			}
+			count++;
+		}
+
+		return count;
+	}
+
+	// Threads allocate and free at random, each slot records how many threads think they own it.
+	void Stress(uint32_t capacity, unsigned int threadCount, unsigned int iterations, size_t maxHeld)
+	{
+		DescriptorIndexAllocator allocator(capacity);
+		std::vector<std::atomic<int>> owners(capacity);
+		std::atomic<unsigned int> doubleHandouts = 0;
+		std::atomic<unsigned int> lostFrees = 0;
+		std::atomic<unsigned int> overCapacity = 0;
+
+		std::vector<std::thread> threads;
+		for (unsigned int t = 0; t < threadCount; t++)
+		{
+			threads.emplace_back([&, t]()
+				{
+					std::vector<uint32_t> held;
+					uint32_t state = t * 7919 + 1;
+
+					for (unsigned int i = 0; i < iterations; i++)
+					{
+						state = state * 1103515245 + 12345;
+						if (((state >> 16) & 1) && held.size() < maxHeld)
+						{
+							uint32_t index = allocator.Allocate();
+							if (index == INVALID)
+							{
+								continue;
+							}
+
+							if (owners[index].fetch_add(1) != 0)
+							{
+								doubleHandouts++;
+							}
+							held.push_back(index);
+						}
+						else if (!held.empty())
+						{
+							uint32_t index = held.back();
+							held.pop_back();
+							if (owners[index].fetch_sub(1) != 1)
+							{
+								lostFrees++;
+							}
+							allocator.Free(index);
+						}
+
+						if (allocator.GetAllocatedCount() > capacity)
+						{
+							overCapacity++;
+						}
+					}
+
+					for (uint32_t index : held)
+					{
+						owners[index].fetch_sub(1);
+						allocator.Free(index);
+					}
+				});
+		}
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		CHECK(doubleHandouts == 0);
+		CHECK(lostFrees == 0);
+		CHECK(overCapacity == 0);
+		CHECK(allocator.GetAllocatedCount() == 0);
+
+		// Nothing was lost or duplicated on the free list.
+		bool distinct = false;
+		CHECK(DrainDistinct(allocator, distinct) == capacity);
+		CHECK(distinct);
+		CHECK(allocator.GetAllocatedCount() == capacity);
+	}
+}
+
+
+TEST_CASE("Indices come out in order and run out at capacity")
+{
+	DescriptorIndexAllocator allocator(4);
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		CHECK(allocator.Allocate() == i);
+	}
+	CHECK(allocator.Allocate() == INVALID);
+	CHECK(allocator.GetAllocatedCount() == 4);
+
+	// The last freed index is reused first.
+	allocator.Free(2);
+	allocator.Free(0);
+	CHECK(allocator.Allocate() == 0);
+	CHECK(allocator.Allocate() == 2);
+
+	CHECK_THROWS(allocator.Free(4));
+
+	DescriptorIndexAllocator empty(0);
+	CHECK(empty.Allocate() == INVALID);
+}
+
+TEST_CASE("Deferred frees wait for their fence")
+{
+	const uint32_t capacity = 1024;
+	DescriptorIndexAllocator allocator(capacity);
+
+	std::vector<uint32_t> indices;
+	for (uint32_t i = 0; i < capacity; i++)
+	{
+		indices.push_back(allocator.Allocate());
+	}
+
+	for (uint32_t i = 0; i < capacity; i++)
+	{
+		allocator.FreeDeferred(indices[i], i / 100 + 1);
+	}
+	CHECK(allocator.GetAllocatedCount() == capacity);
+
+	allocator.ReleaseCompleted(3);
+	CHECK(allocator.GetAllocatedCount() == capacity - 300);
+
+	allocator.ReleaseCompleted(100);
+	CHECK(allocator.GetAllocatedCount() == 0);
+
+	bool distinct = false;
+	CHECK(DrainDistinct(allocator, distinct) == capacity);
+	CHECK(distinct);
+}
+
+TEST_CASE("Concurrent allocate and free keep every index unique")
+{
+	Stress(1024, 8, 200000, 200);
+}
+
+TEST_CASE("Contention on a nearly full heap keeps the free count")
+{
+	// Fewer slots than the threads want, so the head is fought over and often empty.
+	Stress(16, 8, 200000, 4);
+}
+
+TEST_CASE("Deferred frees race with allocations")
+{
+	const uint32_t capacity = 256;
+	DescriptorIndexAllocator allocator(capacity);
+	std::vector<std::atomic<int>> owners(capacity);
+	std::atomic<unsigned int> doubleHandouts = 0;
+	std::atomic<bool> done = false;
+
+	// A loader thread takes slots and hands them back with a fence, the frame thread retires fences.
+	std::thread loader([&]()
+		{
+			for (uint64_t fenceValue = 1; fenceValue <= 20000; fenceValue++)
+			{
+				uint32_t index = allocator.Allocate();
+				if (index == INVALID)
+				{
+					continue;
+				}
+
+				if (owners[index].exchange(1) != 0)
+				{
+					doubleHandouts++;
+				}
+				owners[index].store(0);
+				allocator.FreeDeferred(index, fenceValue);
+			}
+			done = true;
+		});
+
+	uint64_t completed = 0;
+	while (!done)
+	{
+		allocator.ReleaseCompleted(completed += 7);
+		std::this_thread::yield();
+	}
+	loader.join();
+	allocator.ReleaseCompleted(UINT64_MAX);
+
+	CHECK(doubleHandouts == 0);
+	CHECK(allocator.GetAllocatedCount() == 0);
+
+	bool distinct = false;
+	CHECK(DrainDistinct(allocator, distinct) == capacity);
+	CHECK(distinct);
+}
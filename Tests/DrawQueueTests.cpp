@@ -0,0 +1,143 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <random>
+
+#include "TestHarness.h"
+#include "DrawQueue.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	RenderableObject* FakeObject(size_t index)
+	{
+		return reinterpret_cast<RenderableObject*>((index + 1) * 16);
+	}
+}
+
+
+TEST_CASE("Key fields are packed most significant first")
+{
+	CHECK(DrawQueue::PASS_BITS + DrawQueue::PSO_BITS + DrawQueue::MESH_BITS + DrawQueue::GEOMETRY_BITS +
+		DrawQueue::MATERIAL_BITS + DrawQueue::DEPTH_BITS == 64);
+
+	uint64_t key = DrawQueue::MakeKey(0xF, 0x3F, 0x3FFF, 0xFFF, 0xFFF, 0xFFFF);
+	CHECK(key == ~0ull);
+
+	key = DrawQueue::MakeKey(1, 2, 3, 4, 5, 6);
+	CHECK((key & 0xFFFF) == 6);
+	CHECK(((key >> 16) & 0xFFF) == 5);
+	CHECK(((key >> 28) & 0xFFF) == 4);
+	CHECK(DrawQueue::GetMesh(key) == 3);
+	CHECK(((key >> 54) & 0x3F) == 2);
+	CHECK((key >> 60) == 1);
+
+	// Material and depth don't take part in the instancing key.
+	CHECK(DrawQueue::GetGeometryKey(key) == DrawQueue::GetGeometryKey(DrawQueue::MakeKey(1, 2, 3, 4, 4095, 0)));
+	CHECK(DrawQueue::GetGeometryKey(key) != DrawQueue::GetGeometryKey(DrawQueue::MakeKey(1, 2, 3, 5, 5, 6)));
+
+	// The pass dominates everything else.
+	CHECK(DrawQueue::MakeKey(0, 0x3F, 0x3FFF, 0xFFF, 0xFFF, 0xFFFF) < DrawQueue::MakeKey(1, 0, 0, 0, 0, 0));
+}
+
+TEST_CASE("Ids wider than their field throw instead of aliasing")
+{
+	CHECK_THROWS(DrawQueue::MakeKey(16, 0, 0, 0, 0, 0));
+	CHECK_THROWS(DrawQueue::MakeKey(0, 64, 0, 0, 0, 0));
+	CHECK_THROWS(DrawQueue::MakeKey(0, 0, 16384, 0, 0, 0));
+	CHECK_THROWS(DrawQueue::MakeKey(0, 0, 0, 4096, 0, 0));
+	CHECK_THROWS(DrawQueue::MakeKey(0, 0, 0, 0, 4096, 0));
+	CHECK_THROWS(DrawQueue::MakeKey(0, 0, 0, 0, 0, 65536));
+	CHECK_THROWS(DrawQueue::MakeKey(0, 0, 0, 0xFFFFFFFF, 0, 0));
+
+	// Geometry 4095 is the last one which still gets its own key.
+	CHECK(DrawQueue::GetGeometryKey(DrawQueue::MakeKey(0, 0, 0, 4095, 0, 0)) !=
+		DrawQueue::GetGeometryKey(DrawQueue::MakeKey(0, 0, 0, 0, 0, 0)));
+}
+
+TEST_CASE("Depth is quantized and clamped")
+{
+	CHECK(DrawQueue::QuantizeDepth(1.0f, 1.0f, 100.0f) == 0);
+	CHECK(DrawQueue::QuantizeDepth(100.0f, 1.0f, 100.0f) == 0xFFFF);
+	CHECK(DrawQueue::QuantizeDepth(-5.0f, 1.0f, 100.0f) == 0);
+	CHECK(DrawQueue::QuantizeDepth(1000.0f, 1.0f, 100.0f) == 0xFFFF);
+	CHECK(DrawQueue::QuantizeDepth(20.0f, 1.0f, 100.0f) < DrawQueue::QuantizeDepth(21.0f, 1.0f, 100.0f));
+}
+
+TEST_CASE("Radix sort matches a stable sort")
+{
+	std::mt19937 rng(5);
+
+	for (size_t count : { 0u, 1u, 2u, 17u, 1000u, 50000u })
+	{
+		for (int distribution = 0; distribution < 3; distribution++)
+		{
+			DrawQueue queue;
+			std::vector<DrawPacket> expected;
+			for (size_t i = 0; i < count; i++)
+			{
+				uint64_t key;
+				if (distribution == 0)
+				{
+					// Full 64 bit keys.
+					key = ((uint64_t)rng() << 32) | rng();
+				}
+				else if (distribution == 1)
+				{
+					// Realistic keys, most digits are equal and get skipped.
+					key = DrawQueue::MakeKey(1, rng() % 3, rng() % 40, rng() % 200, rng() % 64, 0);
+				}
+				else
+				{
+					// Many duplicates to check the stability.
+					key = rng() % 4;
+				}
+
+				queue.Push(key, FakeObject(i));
+				expected.push_back({ key, FakeObject(i) });
+			}
+
+			std::stable_sort(expected.begin(), expected.end(), [](const DrawPacket& a, const DrawPacket& b)
+				{
+					return a.key < b.key;
+				});
+
+			queue.Sort();
+
+			auto& packets = queue.GetPackets();
+			bool same = packets.size() == expected.size();
+			for (size_t i = 0; same && i < count; i++)
+			{
+				same = packets[i].key == expected[i].key && packets[i].object == expected[i].object;
+			}
+			CHECK(same);
+		}
+	}
+}
+
+TEST_CASE("Sorting twice keeps the order")
+{
+	DrawQueue queue;
+	for (size_t i = 0; i < 100; i++)
+	{
+		queue.Push(DrawQueue::MakeKey(0, 0, (unsigned int)(i % 7), 0, 0, 0), FakeObject(i));
+	}
+	queue.Sort();
+	auto first = queue.GetPackets();
+	queue.Sort();
+
+	bool same = true;
+	for (size_t i = 0; i < first.size(); i++)
+	{
+		same &= first[i].object == queue.GetPackets()[i].object;
+	}
+	CHECK(same);
+
+	queue.Clear();
+	CHECK(queue.GetPackets().empty());
+}
@@ -0,0 +1,145 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cmath>
+#include <random>
+
+#include "TestHarness.h"
+#include "CpuFeatures.h"
+#include "FrustumCuller.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	bool IsInsideReference(const FrustumPlanes& frustum, const BoundingBox& box)
+	{
+		for (auto& plane : frustum.planes)
+		{
+			float dist = plane.x * box.Center.x + plane.y * box.Center.y + plane.z * box.Center.z + plane.w;
+			float radius = std::fabs(plane.x) * box.Extents.x + std::fabs(plane.y) * box.Extents.y +
+				std::fabs(plane.z) * box.Extents.z;
+			if (dist + radius < 0.0f)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	FrustumPlanes MakeFrustum(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+		XMMATRIX view = XMMatrixMultiply(XMMatrixTranslation(-u(rng) * 50.0f, -u(rng) * 10.0f, -u(rng) * 50.0f),
+			XMMatrixRotationY(u(rng) * 6.28f));
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.5f + u(rng), 0.5f + u(rng) * 2.0f, 0.1f + u(rng), 50.0f + u(rng) * 200.0f);
+
+		return FrustumPlanes::FromViewProj(XMMatrixMultiply(view, proj));
+	}
+
+	std::vector<BoundingBox> MakeBoxes(std::mt19937& rng, unsigned int count)
+	{
+		std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+		std::uniform_real_distribution<float> extent(0.0f, 5.0f);
+
+		std::vector<BoundingBox> boxes;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			boxes.push_back(BoundingBox(XMFLOAT3(position(rng), position(rng) * 0.1f, position(rng)),
+				XMFLOAT3(extent(rng), extent(rng), extent(rng))));
+		}
+
+		return boxes;
+	}
+
+	std::vector<unsigned int> CullWith(const CpuFeatures& allowed, const FrustumCuller& culler, const FrustumPlanes& frustum)
+	{
+		RestrictCpuFeatures(allowed);
+
+		std::vector<unsigned int> visible;
+		culler.Cull(frustum, visible);
+
+		RestrictCpuFeatures({ true, true, true });
+		return visible;
+	}
+}
+
+
+TEST_CASE("SSE and AVX paths match the scalar reference")
+{
+	std::mt19937 rng(7);
+
+	// Counts around the 4 and 8 wide batches exercise the padding.
+	for (unsigned int count : { 0u, 1u, 3u, 4u, 5u, 7u, 8u, 9u, 1000u, 4099u })
+	{
+		auto boxes = MakeBoxes(rng, count);
+
+		FrustumCuller culler;
+		for (auto& box : boxes)
+		{
+			culler.AddBox(box);
+		}
+		CHECK(culler.GetBoxCount() == count);
+
+		for (int f = 0; f < 8; f++)
+		{
+			FrustumPlanes frustum = MakeFrustum(rng);
+
+			std::vector<unsigned int> expected;
+			for (unsigned int i = 0; i < count; i++)
+			{
+				if (IsInsideReference(frustum, boxes[i]))
+				{
+					expected.push_back(i);
+				}
+			}
+
+			CHECK(CullWith({ true, false, false }, culler, frustum) == expected);
+			CHECK(CullWith({ true, true, true }, culler, frustum) == expected);
+		}
+	}
+}
+
+TEST_CASE("Restricted features turn the AVX path off")
+{
+	// Informational: a CPU without AVX only runs the SSE path above.
+	std::printf("CPU features: SSE4.1 %d, AVX %d, AVX2 %d\n",
+		GetCpuFeatures().sse41, GetCpuFeatures().avx, GetCpuFeatures().avx2);
+
+	RestrictCpuFeatures({ false, false, false });
+	CHECK(GetCpuFeatures().avx == false);
+	RestrictCpuFeatures({ true, true, true });
+}
+
+TEST_CASE("SetBox and Clear update the culled set")
+{
+	FrustumPlanes frustum = FrustumPlanes::FromViewProj(XMMatrixPerspectiveFovLH(1.0f, 1.0f, 1.0f, 100.0f));
+
+	FrustumCuller culler;
+	unsigned int inFront = culler.AddBox(BoundingBox(XMFLOAT3(0, 0, 10), XMFLOAT3(1, 1, 1)));
+	unsigned int behind = culler.AddBox(BoundingBox(XMFLOAT3(0, 0, -10), XMFLOAT3(1, 1, 1)));
+
+	CullingStats stats;
+	std::vector<unsigned int> visible;
+	culler.Cull(frustum, visible, &stats);
+	CHECK((visible == std::vector<unsigned int>{ inFront }));
+	CHECK(stats.testedCount == 2);
+	CHECK(stats.visibleCount == 1);
+
+	// Straddling the near plane counts as visible.
+	culler.SetBox(behind, BoundingBox(XMFLOAT3(0, 0, 0.5f), XMFLOAT3(1, 1, 1)));
+	culler.Cull(frustum, visible, &stats);
+	CHECK((visible == std::vector<unsigned int>{ inFront, behind }));
+	CHECK(stats.testedCount == 4);
+
+	culler.Clear();
+	culler.Cull(frustum, visible);
+	CHECK(visible.empty());
+	CHECK(culler.GetBoxCount() == 0);
+}
@@ -0,0 +1,260 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <cstring>
+
+#include "TestHarness.h"
+#include "IndexPacking.h"
+#include "CookedMesh.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	struct TestGrid
+	{
+		std::vector<float> positions;
+		std::vector<uint32_t> indices;
+		std::vector<Meshlet> meshlets;
+		uint32_t vertexCount = 0;
+	};
+
+	// width x height vertices, two triangles per cell, row by row.
+	TestGrid MakeGrid(uint32_t width, uint32_t height, bool withMeshlets)
+	{
+		TestGrid grid;
+		grid.vertexCount = width * height;
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				grid.positions.insert(grid.positions.end(), { (float)x, 0.0f, (float)y });
+			}
+		}
+		for (uint32_t y = 0; y + 1 < height; y++)
+		{
+			for (uint32_t x = 0; x + 1 < width; x++)
+			{
+				const uint32_t a = y * width + x;
+				const uint32_t c = a + width;
+				grid.indices.insert(grid.indices.end(), { a, c, a + 1, a + 1, c, c + 1 });
+			}
+		}
+		if (withMeshlets)
+		{
+			BuildMeshlets(grid.indices.data(), grid.indices.size(), grid.positions.data(), grid.vertexCount, 0, grid.meshlets);
+		}
+		return grid;
+	}
+
+	std::vector<IndexSubRange> MakeWholeRange(const TestGrid& grid)
+	{
+		std::vector<IndexSubRange> subRanges(1);
+		subRanges[0].indexCount = (uint32_t)grid.indices.size();
+		subRanges[0].meshletCount = (uint32_t)grid.meshlets.size();
+		return subRanges;
+	}
+
+	// Every drawn index has to decode to the original vertex and stay below the strip cut value. Batches have to
+	// tile their submesh in order, and with meshlets start and end on meshlet boundaries. Returns the draw count.
+	size_t Verify(const std::vector<uint32_t>& indices, const std::vector<IndexSubRange>& subRanges,
+		const std::vector<uint16_t>& indices16, const std::vector<IndexBatch>& batches, const std::vector<Meshlet>& meshlets)
+	{
+		size_t drawCount = 0;
+		for (const IndexSubRange& subRange : subRanges)
+		{
+			const uint32_t end = subRange.startIndexLocation + subRange.indexCount;
+			if (subRange.batchCount == 0)
+			{
+				drawCount++;
+				bool exact = true;
+				for (uint32_t i = subRange.startIndexLocation; i < end; i++)
+				{
+					exact = exact && indices16[i] == indices[i] && indices16[i] < INDEX16_MAX_VERTICES;
+				}
+				CHECK(exact);
+				continue;
+			}
+
+			uint32_t next = subRange.startIndexLocation;
+			uint32_t nextMeshlet = 0;
+			for (uint32_t b = 0; b < subRange.batchCount; b++)
+			{
+				const IndexBatch& batch = batches[subRange.firstBatch + b];
+				drawCount++;
+
+				CHECK(batch.startIndexLocation == next);
+				CHECK(batch.firstMeshlet == nextMeshlet);
+				next += batch.indexCount;
+				nextMeshlet += batch.meshletCount;
+
+				if (subRange.meshletCount > 0)
+				{
+					CHECK(batch.meshletCount > 0);
+					const Meshlet& first = meshlets[subRange.firstMeshlet + batch.firstMeshlet];
+					const Meshlet& last = meshlets[subRange.firstMeshlet + batch.firstMeshlet + batch.meshletCount - 1];
+					CHECK(first.startIndexLocation == batch.startIndexLocation);
+					CHECK(last.startIndexLocation + last.indexCount == batch.startIndexLocation + batch.indexCount);
+				}
+				else
+				{
+					CHECK(batch.indexCount % 3 == 0);
+				}
+
+				bool exact = true;
+				for (uint32_t i = batch.startIndexLocation; i < batch.startIndexLocation + batch.indexCount; i++)
+				{
+					exact = exact && (uint32_t)batch.vertexOffset + indices16[i] == indices[i] && indices16[i] < INDEX16_MAX_VERTICES;
+				}
+				CHECK(exact);
+			}
+			CHECK(next == end);
+			CHECK(nextMeshlet == subRange.meshletCount);
+		}
+		return drawCount;
+	}
+
+	// Packs a grid as one submesh. Each draw addresses at most INDEX16_MAX_VERTICES vertices and the rows
+	// where two batches meet are fetched by both, so the grid needs at least ceil(vertices / window) batches.
+	void PackGrid(uint32_t width, uint32_t height, bool withMeshlets, size_t expectedBatches)
+	{
+		TestGrid grid = MakeGrid(width, height, withMeshlets);
+		std::vector<IndexSubRange> subRanges = MakeWholeRange(grid);
+		std::vector<uint16_t> indices16;
+		std::vector<IndexBatch> batches;
+
+		CHECK(PackIndices16(grid.indices.data(), grid.indices.size(), grid.meshlets.data(), subRanges, indices16, batches));
+		CHECK(indices16.size() == grid.indices.size());
+		CHECK(batches.size() == expectedBatches);
+		CHECK(subRanges[0].firstBatch == 0 && subRanges[0].batchCount == expectedBatches);
+		CHECK(Verify(grid.indices, subRanges, indices16, batches, grid.meshlets) == std::max<size_t>(expectedBatches, 1));
+	}
+
+	bool PackTriangles(const std::vector<uint32_t>& indices, std::vector<uint16_t>& indices16, std::vector<IndexBatch>& batches,
+		std::vector<IndexSubRange>& subRanges)
+	{
+		subRanges.assign(1, IndexSubRange());
+		subRanges[0].indexCount = (uint32_t)indices.size();
+		return PackIndices16(indices.data(), indices.size(), nullptr, subRanges, indices16, batches);
+	}
+}
+
+
+TEST_CASE("Meshes at the 16 bit limit")
+{
+	// 65535 vertices, the largest index is 65534 and the mesh is drawn whole.
+	PackGrid(255, 257, true, 0);
+	PackGrid(5, 13107, true, 0);
+	PackGrid(5, 13107, false, 0);
+
+	// 65536 and 65540 vertices need an index of 65535 or more, which is the cut value, so they are split.
+	PackGrid(256, 256, true, 2);
+	PackGrid(256, 256, false, 2);
+	PackGrid(5, 13108, true, 2);
+	PackGrid(5, 13108, false, 2);
+}
+
+TEST_CASE("Large meshes split between meshlets")
+{
+	PackGrid(300, 300, true, 2);
+	PackGrid(300, 300, false, 2);
+	// A batch spans at most 65535 vertices and overlaps the previous one by a row of 1000.
+	PackGrid(1000, 1000, true, 16);
+}
+
+TEST_CASE("Largest index decides the batching")
+{
+	std::vector<uint16_t> indices16;
+	std::vector<IndexBatch> batches;
+	std::vector<IndexSubRange> subRanges;
+
+	// INDEX16_MAX_VERTICES - 1 still fits the submesh as a whole.
+	CHECK(PackTriangles({ 0, 1, INDEX16_MAX_VERTICES - 1 }, indices16, batches, subRanges));
+	CHECK(batches.empty() && subRanges[0].batchCount == 0);
+	CHECK(indices16.size() == 3 && indices16[2] == 0xFFFE);
+
+	// Rebased by 1 the same span fits one batch.
+	CHECK(PackTriangles({ 1, 2, INDEX16_MAX_VERTICES }, indices16, batches, subRanges));
+	CHECK(batches.size() == 1 && subRanges[0].batchCount == 1);
+	CHECK(batches[0].vertexOffset == 1 && batches[0].indexCount == 3);
+	CHECK(indices16[0] == 0 && indices16[2] == 0xFFFE);
+
+	// A triangle spanning INDEX16_MAX_VERTICES + 1 vertices can't be drawn with 16 bits, nothing is truncated.
+	CHECK(PackTriangles({ 0, 1, INDEX16_MAX_VERTICES }, indices16, batches, subRanges) == false);
+	CHECK(indices16.empty() && batches.empty());
+	CHECK(PackTriangles({ 0, 1, 2, 3, 4, 70000 }, indices16, batches, subRanges) == false);
+	CHECK(indices16.empty() && batches.empty());
+
+	// High but narrow indices are rebased.
+	CHECK(PackTriangles({ 100000, 100001, 100002 }, indices16, batches, subRanges));
+	CHECK(batches.size() == 1 && batches[0].vertexOffset == 100000);
+	CHECK(indices16[0] == 0 && indices16[1] == 1 && indices16[2] == 2);
+}
+
+TEST_CASE("Submeshes are batched on their own")
+{
+	TestGrid small = MakeGrid(10, 10, true);
+	TestGrid large = MakeGrid(300, 300, false);
+
+	const uint32_t smallIndexCount = (uint32_t)small.indices.size();
+	const uint32_t smallMeshletCount = (uint32_t)small.meshlets.size();
+	std::vector<Meshlet> meshlets = small.meshlets;
+	BuildMeshlets(large.indices.data(), large.indices.size(), large.positions.data(), large.vertexCount, smallIndexCount, meshlets);
+
+	std::vector<uint32_t> indices = small.indices;
+	indices.insert(indices.end(), large.indices.begin(), large.indices.end());
+
+	std::vector<IndexSubRange> subRanges(2);
+	subRanges[0].indexCount = smallIndexCount;
+	subRanges[0].meshletCount = smallMeshletCount;
+	subRanges[1].startIndexLocation = smallIndexCount;
+	subRanges[1].indexCount = (uint32_t)large.indices.size();
+	subRanges[1].firstMeshlet = smallMeshletCount;
+	subRanges[1].meshletCount = (uint32_t)meshlets.size() - smallMeshletCount;
+
+	std::vector<uint16_t> indices16;
+	std::vector<IndexBatch> batches;
+	CHECK(PackIndices16(indices.data(), indices.size(), meshlets.data(), subRanges, indices16, batches));
+	CHECK(subRanges[0].batchCount == 0);
+	CHECK(subRanges[1].firstBatch == 0 && subRanges[1].batchCount == 2);
+	CHECK(Verify(indices, subRanges, indices16, batches, meshlets) == 3);
+
+	// The batches survive the cooked file.
+	std::vector<float> vertices(small.vertexCount + large.vertexCount, 0.0f);
+	std::vector<float> positions(vertices.size() * 3, 0.0f);
+
+	CookedMeshSource source;
+	source.vertices = vertices.data();
+	source.vertexCount = (uint32_t)vertices.size();
+	source.vertexStride = sizeof(float);
+	source.positions = positions.data();
+	source.indices = indices16.data();
+	source.indexCount = (uint32_t)indices16.size();
+	source.indexStride = sizeof(uint16_t);
+
+	CookedSubMesh first = {};
+	first.indexCount = subRanges[0].indexCount;
+	first.meshletCount = subRanges[0].meshletCount;
+	CookedSubMesh second = {};
+	second.startIndexLocation = subRanges[1].startIndexLocation;
+	second.indexCount = subRanges[1].indexCount;
+	second.firstMeshlet = subRanges[1].firstMeshlet;
+	second.meshletCount = subRanges[1].meshletCount;
+	second.firstBatch = subRanges[1].firstBatch;
+	second.batchCount = subRanges[1].batchCount;
+	source.subMeshes = { first, second };
+	source.meshlets = meshlets;
+	source.batches = batches;
+
+	std::vector<uint8_t> bytes = BuildCookedMesh({ source }, {});
+	CookedMeshFile file;
+	CHECK(file.Open(bytes.data(), bytes.size()));
+	CookedMeshView view = file.GetMesh(0);
+	CHECK(view.indexStride == sizeof(uint16_t));
+	CHECK(view.batchCount == batches.size());
+	CHECK(std::memcmp(view.batches, batches.data(), batches.size() * sizeof(IndexBatch)) == 0);
+}
@@ -0,0 +1,96 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "TestHarness.h"
+#include "JobSystem.h"
+
+
+using namespace Humpback;
+
+
+TEST_CASE("ParallelFor runs every index once")
+{
+	JobSystem jobs(3);
+	CHECK(jobs.GetThreadCount() == 4);
+
+	for (unsigned int count : { 0u, 1u, 2u, 7u, 1000u })
+	{
+		std::vector<std::atomic<unsigned int>> hits(count);
+		jobs.ParallelFor(count, [&](unsigned int i) { ++hits[i]; });
+
+		bool once = true;
+		for (auto& hit : hits)
+		{
+			once &= hit == 1;
+		}
+		CHECK(once);
+	}
+}
+
+TEST_CASE("ParallelFor rethrows on the calling thread")
+{
+	JobSystem jobs(3);
+
+	// Throwing from worker jobs and from the caller's own job.
+	for (unsigned int throwing : { 0u, 5u, 63u })
+	{
+		std::atomic<unsigned int> finished(0);
+		bool caught = false;
+		try
+		{
+			jobs.ParallelFor(64, [&](unsigned int i)
+				{
+					if (i == throwing)
+					{
+						throw std::runtime_error("Job failed.");
+					}
+					++finished;
+				});
+		}
+		catch (const std::runtime_error&)
+		{
+			caught = true;
+		}
+
+		// The other jobs still ran to completion before the exception was rethrown.
+		CHECK(caught);
+		CHECK(finished == 63);
+	}
+
+	// Every job throwing reports one exception and leaves the pool usable.
+	CHECK_THROWS(jobs.ParallelFor(32, [](unsigned int) { throw std::runtime_error("Job failed."); }));
+
+	std::atomic<unsigned int> sum(0);
+	jobs.ParallelFor(100, [&](unsigned int i) { sum += i; });
+	CHECK(sum == 4950);
+}
+
+TEST_CASE("Submitted jobs report through their future")
+{
+	JobSystem jobs(2);
+
+	std::atomic<bool> ran(false);
+	auto ok = jobs.Submit([&]() { ran = true; });
+	ok.get();
+	CHECK(ran);
+
+	auto failed = jobs.Submit([]() { throw std::runtime_error("Job failed."); });
+	CHECK_THROWS(failed.get());
+}
+
+TEST_CASE("ParallelFor can be called from concurrent jobs")
+{
+	JobSystem jobs(3);
+
+	std::atomic<unsigned int> total(0);
+	auto a = jobs.Submit([&]() { jobs.ParallelFor(200, [&](unsigned int) { ++total; }); });
+	jobs.ParallelFor(200, [&](unsigned int) { ++total; });
+	a.get();
+
+	CHECK(total == 400);
+}
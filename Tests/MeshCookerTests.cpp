@@ -0,0 +1,376 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <map>
+
+#include "TestHarness.h"
+#include "MeshCooker.h"
+#include "JobSystem.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	using Triangle = std::array<float, 9>;
+
+	// A width x height patch of a bumpy torus with normals, tangents and uvs, triangles row by row.
+	// With lines the mesh also carries a point and two lines, the leftovers aiProcess_Triangulate keeps.
+	aiMesh* MakeMesh(uint32_t width, uint32_t height, float offset, bool withLines)
+	{
+		aiMesh* mesh = new aiMesh();
+		mesh->mNumVertices = width * height;
+		mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+		mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+		mesh->mTangents = new aiVector3D[mesh->mNumVertices];
+		mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+		mesh->mNumUVComponents[0] = 2;
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				const uint32_t i = y * width + x;
+				const float a = 6.2831853f * x / width;
+				const float b = 6.2831853f * y / height;
+				const float r = 1.0f + 0.3f * std::cos(b);
+				mesh->mVertices[i] = aiVector3D(r * std::cos(a) + offset, 0.3f * std::sin(b), r * std::sin(a));
+				mesh->mNormals[i] = aiVector3D(std::cos(a) * std::cos(b), std::sin(b), std::sin(a) * std::cos(b));
+				mesh->mTangents[i] = aiVector3D(-std::sin(a), 0.0f, std::cos(a));
+				mesh->mTextureCoords[0][i] = aiVector3D((float)x / width, (float)y / height, 0.0f);
+			}
+		}
+
+		std::vector<std::vector<unsigned int>> faces;
+		for (uint32_t y = 0; y + 1 < height; y++)
+		{
+			for (uint32_t x = 0; x + 1 < width; x++)
+			{
+				const uint32_t a = y * width + x;
+				const uint32_t c = a + width;
+				faces.push_back({ a, c, a + 1 });
+				faces.push_back({ a + 1, c, c + 1 });
+			}
+		}
+		mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+		if (withLines)
+		{
+			faces.insert(faces.begin() + 5, { { 0 }, { 0, 1 }, { width, width + 1 } });
+			mesh->mPrimitiveTypes |= aiPrimitiveType_POINT | aiPrimitiveType_LINE;
+		}
+
+		mesh->mNumFaces = (unsigned int)faces.size();
+		mesh->mFaces = new aiFace[faces.size()];
+		for (size_t i = 0; i < faces.size(); i++)
+		{
+			mesh->mFaces[i].mNumIndices = (unsigned int)faces[i].size();
+			mesh->mFaces[i].mIndices = new unsigned int[faces[i].size()];
+			std::copy(faces[i].begin(), faces[i].end(), mesh->mFaces[i].mIndices);
+		}
+		return mesh;
+	}
+
+	aiNode* MakeNode(std::vector<unsigned int> meshes, const aiVector3D& translation)
+	{
+		aiNode* node = new aiNode();
+		node->mTransformation = aiMatrix4x4();
+		node->mTransformation.a4 = translation.x;
+		node->mTransformation.b4 = translation.y;
+		node->mTransformation.c4 = translation.z;
+		node->mNumMeshes = (unsigned int)meshes.size();
+		node->mMeshes = new unsigned int[meshes.size()];
+		std::copy(meshes.begin(), meshes.end(), node->mMeshes);
+		return node;
+	}
+
+	void AddChildren(aiNode* parent, std::vector<aiNode*> children)
+	{
+		parent->mNumChildren = (unsigned int)children.size();
+		parent->mChildren = new aiNode*[children.size()];
+		for (size_t i = 0; i < children.size(); i++)
+		{
+			children[i]->mParent = parent;
+			parent->mChildren[i] = children[i];
+		}
+	}
+
+	// Owns the meshes and nodes, aiScene frees them.
+	aiScene* MakeScene(std::vector<aiMesh*> meshes, aiNode* root)
+	{
+		aiScene* scene = new aiScene();
+		scene->mNumMeshes = (unsigned int)meshes.size();
+		scene->mMeshes = new aiMesh*[meshes.size()];
+		std::copy(meshes.begin(), meshes.end(), scene->mMeshes);
+		scene->mRootNode = root;
+		return scene;
+	}
+
+	// The triangles of a source mesh by their corner positions, rotated to start at the smallest corner.
+	Triangle MakeTriangle(const float* a, const float* b, const float* c)
+	{
+		std::array<std::array<float, 3>, 3> corners = { { { a[0], a[1], a[2] }, { b[0], b[1], b[2] }, { c[0], c[1], c[2] } } };
+		std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+		Triangle triangle;
+		for (int i = 0; i < 3; i++)
+		{
+			std::copy(corners[i].begin(), corners[i].end(), triangle.begin() + i * 3);
+		}
+		return triangle;
+	}
+
+	std::map<Triangle, int> GetTriangles(const aiMesh* mesh)
+	{
+		std::map<Triangle, int> triangles;
+		for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+		{
+			const aiFace& face = mesh->mFaces[i];
+			if (face.mNumIndices == 3)
+			{
+				triangles[MakeTriangle(&mesh->mVertices[face.mIndices[0]].x, &mesh->mVertices[face.mIndices[1]].x,
+					&mesh->mVertices[face.mIndices[2]].x)]++;
+			}
+		}
+		return triangles;
+	}
+
+	// Decodes the 16 or 32 bit indices of a cooked mesh, with the vertex offsets of its batches.
+	std::vector<uint32_t> GetIndices(const CookedMeshView& view)
+	{
+		std::vector<uint32_t> indices(view.indexCount);
+		for (uint32_t i = 0; i < view.indexCount; i++)
+		{
+			indices[i] = view.indexStride == 2 ? ((const uint16_t*)view.indices)[i] : ((const uint32_t*)view.indices)[i];
+		}
+		for (uint32_t b = 0; b < view.batchCount; b++)
+		{
+			const IndexBatch& batch = view.batches[b];
+			for (uint32_t i = batch.startIndexLocation; i < batch.startIndexLocation + batch.indexCount; i++)
+			{
+				indices[i] += batch.vertexOffset;
+			}
+		}
+		return indices;
+	}
+
+	std::map<Triangle, int> GetTriangles(const CookedMeshView& view)
+	{
+		const Vertex* vertices = (const Vertex*)view.vertices;
+		std::vector<uint32_t> indices = GetIndices(view);
+		std::map<Triangle, int> triangles;
+		for (size_t i = 0; i + 3 <= indices.size(); i += 3)
+		{
+			triangles[MakeTriangle(&vertices[indices[i]].position.x, &vertices[indices[i + 1]].position.x,
+				&vertices[indices[i + 2]].position.x)]++;
+		}
+		return triangles;
+	}
+
+	// Every vertex keeps its attributes, matched by position since the vertices were reordered.
+	bool KeepsAttributes(const aiMesh* mesh, const CookedMeshView& view)
+	{
+		std::map<std::array<float, 3>, unsigned int> sourceVertices;
+		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+		{
+			sourceVertices[{ mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z }] = i;
+		}
+
+		const Vertex* vertices = (const Vertex*)view.vertices;
+		const DirectX::XMFLOAT3* positions = (const DirectX::XMFLOAT3*)view.positions;
+		for (uint32_t i = 0; i < view.vertexCount; i++)
+		{
+			const Vertex& v = vertices[i];
+			auto found = sourceVertices.find({ v.position.x, v.position.y, v.position.z });
+			if (found == sourceVertices.end())
+			{
+				return false;
+			}
+			const unsigned int s = found->second;
+			bool same = v.normal.x == mesh->mNormals[s].x && v.normal.y == mesh->mNormals[s].y && v.normal.z == mesh->mNormals[s].z &&
+				v.tangent.x == mesh->mTangents[s].x && v.tangent.z == mesh->mTangents[s].z &&
+				v.uv.x == mesh->mTextureCoords[0][s].x && v.uv.y == mesh->mTextureCoords[0][s].y &&
+				positions[i].x == v.position.x && positions[i].y == v.position.y && positions[i].z == v.position.z;
+			if (same == false)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	CookedMeshView OpenMesh(const std::vector<uint8_t>& bytes, CookedMeshFile& file, uint32_t index)
+	{
+		CHECK(file.Open(bytes.data(), bytes.size()));
+		return file.GetMesh(index);
+	}
+}
+
+
+TEST_CASE("Cooked meshes keep the source triangles")
+{
+	// The large patch spans several conversion slices and needs 16 bit batches.
+	aiMesh* small = MakeMesh(40, 30, 0.0f, false);
+	aiMesh* large = MakeMesh(400, 250, 5.0f, false);
+	aiNode* root = MakeNode({ 0, 1 }, aiVector3D(0.0f, 0.0f, 0.0f));
+	aiScene* scene = MakeScene({ small, large }, root);
+
+	std::vector<uint8_t> bytes;
+	CHECK(MeshCooker::CookScene(scene, bytes));
+
+	CookedMeshFile file;
+	CHECK(file.Open(bytes.data(), bytes.size()));
+	CHECK(file.GetMeshCount() == 2);
+
+	const aiMesh* sources[] = { small, large };
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		CookedMeshView view = file.GetMesh(i);
+		CHECK(view.vertexCount == sources[i]->mNumVertices);
+		CHECK(view.vertexStride == sizeof(Vertex));
+		CHECK(view.indexCount == sources[i]->mNumFaces * 3);
+		CHECK(view.indexStride == 2);
+		CHECK(GetTriangles(view) == GetTriangles(sources[i]));
+		CHECK(KeepsAttributes(sources[i], view));
+
+		// Bounds reduced over the slices match the whole mesh.
+		float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (unsigned int v = 0; v < sources[i]->mNumVertices; v++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				boundsMin[axis] = std::min(boundsMin[axis], sources[i]->mVertices[v][axis]);
+				boundsMax[axis] = std::max(boundsMax[axis], sources[i]->mVertices[v][axis]);
+			}
+		}
+		const CookedSubMesh& subMesh = view.subMeshes[0];
+		CHECK(view.subMeshCount == 1);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			CHECK(std::abs(subMesh.aabbCenter[axis] - 0.5f * (boundsMin[axis] + boundsMax[axis])) < 1e-5f);
+			CHECK(std::abs(subMesh.aabbExtents[axis] - 0.5f * (boundsMax[axis] - boundsMin[axis])) < 1e-5f);
+		}
+		CHECK(subMesh.meshletCount == view.meshletCount && view.meshletCount > 0);
+	}
+
+	CHECK(file.GetMesh(0).batchCount == 0);
+	CHECK(file.GetMesh(1).batchCount >= 2);
+
+	delete scene;
+}
+
+TEST_CASE("Points and lines are left out")
+{
+	aiMesh* mesh = MakeMesh(20, 20, 0.0f, true);
+	aiScene* scene = MakeScene({ mesh }, MakeNode({ 0 }, aiVector3D(0.0f, 0.0f, 0.0f)));
+
+	std::vector<uint8_t> bytes;
+	CHECK(MeshCooker::CookScene(scene, bytes));
+
+	CookedMeshFile file;
+	CookedMeshView view = OpenMesh(bytes, file, 0);
+	CHECK(view.indexCount == (mesh->mNumFaces - 3) * 3);
+	CHECK(GetTriangles(view) == GetTriangles(mesh));
+
+	delete scene;
+}
+
+TEST_CASE("Shared meshes are cooked once per node")
+{
+	aiMesh* shared = MakeMesh(30, 30, 0.0f, false);
+	aiMesh* other = MakeMesh(10, 10, 3.0f, false);
+
+	// root
+	//   left (shared)
+	//     leaf (other, shared)
+	//   right (shared)
+	aiNode* root = MakeNode({}, aiVector3D(0.0f, 0.0f, 0.0f));
+	aiNode* left = MakeNode({ 0 }, aiVector3D(-2.0f, 0.0f, 0.0f));
+	aiNode* leaf = MakeNode({ 1, 0 }, aiVector3D(0.0f, 1.0f, 0.0f));
+	aiNode* right = MakeNode({ 0 }, aiVector3D(2.0f, 0.0f, 0.5f));
+	AddChildren(left, { leaf });
+	AddChildren(root, { left, right });
+	aiScene* scene = MakeScene({ shared, other }, root);
+
+	std::vector<uint8_t> bytes;
+	CHECK(MeshCooker::CookScene(scene, bytes));
+
+	CookedMeshFile file;
+	CHECK(file.Open(bytes.data(), bytes.size()));
+	CHECK(file.GetMeshCount() == 4);
+
+	// Nodes in pre-order, parents first, with the transform transposed to row vectors.
+	CHECK(file.GetNodeCount() == 4);
+	const uint32_t parents[] = { CookedMeshFormat::NO_NODE, 0, 1, 0 };
+	const float translations[][3] = { { 0.0f, 0.0f, 0.0f }, { -2.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 2.0f, 0.0f, 0.5f } };
+	for (uint32_t i = 0; i < file.GetNodeCount(); i++)
+	{
+		CookedNode node = file.GetNode(i);
+		CHECK(node.parent == parents[i]);
+		CHECK(node.localTransform[12] == translations[i][0]);
+		CHECK(node.localTransform[13] == translations[i][1]);
+		CHECK(node.localTransform[14] == translations[i][2]);
+		CHECK(node.localTransform[3] == 0.0f && node.localTransform[15] == 1.0f);
+	}
+
+	// Draw order follows the nodes, a node's meshes in its own order.
+	const uint32_t meshNodes[] = { 1, 2, 2, 3 };
+	const aiMesh* meshSources[] = { shared, other, shared, shared };
+	std::vector<uint8_t> sharedVertices;
+	for (uint32_t i = 0; i < file.GetMeshCount(); i++)
+	{
+		CookedMeshView view = file.GetMesh(i);
+		CHECK(view.node == meshNodes[i]);
+		CHECK(view.vertexCount == meshSources[i]->mNumVertices);
+		CHECK(GetTriangles(view) == GetTriangles(meshSources[i]));
+
+		// Every instance of the shared mesh holds the same cooked data.
+		if (meshSources[i] == shared)
+		{
+			const uint8_t* vertices = (const uint8_t*)view.vertices;
+			if (sharedVertices.empty())
+			{
+				sharedVertices.assign(vertices, vertices + view.vertexByteSize);
+			}
+			CHECK(std::equal(sharedVertices.begin(), sharedVertices.end(), vertices));
+		}
+	}
+
+	delete scene;
+}
+
+TEST_CASE("Cooking on the job system gives the same bytes")
+{
+	std::vector<aiMesh*> meshes;
+	for (uint32_t i = 0; i < 12; i++)
+	{
+		meshes.push_back(MakeMesh(20 + i * 7, 30 + i * 3, (float)i, i % 4 == 1));
+	}
+	meshes.push_back(MakeMesh(300, 300, -4.0f, false));
+
+	std::vector<aiNode*> children;
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		children.push_back(MakeNode({ i, (i * 5) % (unsigned int)meshes.size() }, aiVector3D((float)i, 0.0f, 0.0f)));
+	}
+	aiNode* root = MakeNode({}, aiVector3D(0.0f, 0.0f, 0.0f));
+	AddChildren(root, children);
+	aiScene* scene = MakeScene(meshes, root);
+
+	std::vector<uint8_t> serial;
+	CHECK(MeshCooker::CookScene(scene, serial));
+
+	for (unsigned int workerCount : { 1u, 3u, 8u })
+	{
+		JobSystem jobSystem(workerCount);
+		std::vector<uint8_t> parallel;
+		CHECK(MeshCooker::CookScene(scene, parallel, &jobSystem));
+		CHECK(parallel == serial);
+	}
+
+	delete scene;
+}
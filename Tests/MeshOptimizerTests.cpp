@@ -0,0 +1,252 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <random>
+
+#include "TestHarness.h"
+#include "MeshOptimizer.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	struct TestVertex
+	{
+		float position[3];
+		uint32_t id;		// Index in the generated mesh, follows the vertex through reordering.
+	};
+
+	struct TestMesh
+	{
+		std::vector<TestVertex> vertices;
+		std::vector<uint32_t> indices;
+
+		std::vector<float> GetPositions() const
+		{
+			std::vector<float> positions;
+			for (const TestVertex& v : vertices)
+			{
+				positions.insert(positions.end(), v.position, v.position + 3);
+			}
+			return positions;
+		}
+	};
+
+	// A bumpy lat-long sphere with its vertices and triangles shuffled, like the order importers produce.
+	TestMesh MakeShuffledSphere(uint32_t stacks, uint32_t slices, unsigned int seed)
+	{
+		TestMesh mesh;
+		for (uint32_t i = 0; i <= stacks; i++)
+		{
+			for (uint32_t j = 0; j <= slices; j++)
+			{
+				const float theta = 3.14159265f * i / stacks;
+				const float phi = 6.2831853f * j / slices;
+				const float r = 1.0f + 0.35f * std::sin(6.0f * theta) * std::sin(6.0f * phi);
+				TestVertex v = { { r * std::sin(theta) * std::cos(phi), r * std::cos(theta), r * std::sin(theta) * std::sin(phi) },
+					(uint32_t)mesh.vertices.size() };
+				mesh.vertices.push_back(v);
+			}
+		}
+		for (uint32_t i = 0; i < stacks; i++)
+		{
+			for (uint32_t j = 0; j < slices; j++)
+			{
+				const uint32_t a = i * (slices + 1) + j;
+				const uint32_t c = a + slices + 1;
+				mesh.indices.insert(mesh.indices.end(), { a, c, a + 1, a + 1, c, c + 1 });
+			}
+		}
+
+		std::mt19937 rng(seed);
+		std::vector<uint32_t> remap(mesh.vertices.size());
+		for (uint32_t i = 0; i < remap.size(); i++)
+		{
+			remap[i] = i;
+		}
+		std::shuffle(remap.begin(), remap.end(), rng);
+
+		std::vector<TestVertex> shuffled(mesh.vertices.size());
+		for (size_t i = 0; i < mesh.vertices.size(); i++)
+		{
+			shuffled[remap[i]] = mesh.vertices[i];
+		}
+		mesh.vertices.swap(shuffled);
+
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			triangles.push_back({ remap[mesh.indices[i]], remap[mesh.indices[i + 1]], remap[mesh.indices[i + 2]] });
+		}
+		std::shuffle(triangles.begin(), triangles.end(), rng);
+		mesh.indices.clear();
+		for (const auto& t : triangles)
+		{
+			mesh.indices.insert(mesh.indices.end(), t.begin(), t.end());
+		}
+		return mesh;
+	}
+
+	// Triangles by the ids of their vertices, rotated to start at the smallest so the winding is kept.
+	std::map<std::array<uint32_t, 3>, int> GetTriangleSet(const TestMesh& mesh)
+	{
+		std::map<std::array<uint32_t, 3>, int> triangles;
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			std::array<uint32_t, 3> t =
+			{
+				mesh.vertices[mesh.indices[i]].id, mesh.vertices[mesh.indices[i + 1]].id, mesh.vertices[mesh.indices[i + 2]].id,
+			};
+			std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+			triangles[t]++;
+		}
+		return triangles;
+	}
+
+	float GetAcmr(const TestMesh& mesh)
+	{
+		return AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), DEFAULT_VERTEX_CACHE_SIZE).GetAcmr();
+	}
+}
+
+
+TEST_CASE("Cache statistics follow a FIFO")
+{
+	const uint32_t quad[] = { 0, 1, 2, 2, 1, 3 };
+	VertexCacheStats stats = AnalyzeVertexCache(quad, 6, 4, 16);
+	CHECK(stats.triangleCount == 2);
+	CHECK(stats.vertexCount == 4);
+	CHECK(stats.transformedVertices == 4);
+	CHECK(stats.GetAcmr() == 2.0f);
+	CHECK(stats.GetAtvr() == 1.0f);
+
+	// Three new vertices push the first triangle out of a three entry cache.
+	const uint32_t evicted[] = { 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+	stats = AnalyzeVertexCache(evicted, 9, 6, 3);
+	CHECK(stats.transformedVertices == 9);
+	CHECK(stats.GetAtvr() == 1.5f);
+
+	// A hit doesn't move an entry in a FIFO: 0 is still the oldest when 3 comes in.
+	const uint32_t hits[] = { 0, 1, 2, 0, 2, 3, 1, 2, 0 };
+	stats = AnalyzeVertexCache(hits, 9, 4, 3);
+	CHECK(stats.transformedVertices == 5);
+
+	// Vertices no index uses don't count.
+	stats = AnalyzeVertexCache(quad, 6, 100, 16);
+	CHECK(stats.vertexCount == 4);
+
+	VertexCacheStats sum;
+	sum += AnalyzeVertexCache(quad, 6, 4, 16);
+	sum += AnalyzeVertexCache(evicted, 9, 6, 3);
+	CHECK(sum.triangleCount == 5);
+	CHECK(sum.vertexCount == 10);
+	CHECK(sum.transformedVertices == 13);
+
+	CHECK(AnalyzeVertexCache(nullptr, 0, 0, 16).GetAcmr() == 0.0f);
+}
+
+TEST_CASE("Vertex cache order keeps every triangle")
+{
+	for (uint32_t size : { 4u, 30u, 96u })
+	{
+		TestMesh mesh = MakeShuffledSphere(size, size * 2, size);
+		const auto triangles = GetTriangleSet(mesh);
+		const float acmrBefore = GetAcmr(mesh);
+
+		std::vector<uint32_t> clusters;
+		OptimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), DEFAULT_VERTEX_CACHE_SIZE, &clusters);
+
+		CHECK(GetTriangleSet(mesh) == triangles);
+		CHECK(GetAcmr(mesh) < acmrBefore);
+		if (size >= 30)
+		{
+			// A grid allows 0.5, Tipsify gets within a few tenths of that.
+			CHECK(GetAcmr(mesh) < 0.75f);
+		}
+
+		const uint32_t triangleCount = (uint32_t)mesh.indices.size() / 3;
+		CHECK(clusters.empty() == false && clusters[0] == 0);
+		CHECK(std::is_sorted(clusters.begin(), clusters.end()));
+		CHECK(std::adjacent_find(clusters.begin(), clusters.end()) == clusters.end());
+		CHECK(clusters.back() < triangleCount);
+	}
+}
+
+TEST_CASE("Overdraw order stays within the cache threshold")
+{
+	TestMesh mesh = MakeShuffledSphere(64, 128, 3);
+	const auto triangles = GetTriangleSet(mesh);
+
+	std::vector<uint32_t> clusters;
+	OptimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), DEFAULT_VERTEX_CACHE_SIZE, &clusters);
+	const float acmrCache = GetAcmr(mesh);
+
+	std::vector<float> positions = mesh.GetPositions();
+	OptimizeOverdraw(mesh.indices.data(), mesh.indices.size(), positions.data(), mesh.vertices.size(), clusters,
+		DEFAULT_VERTEX_CACHE_SIZE, DEFAULT_OVERDRAW_THRESHOLD);
+
+	CHECK(GetTriangleSet(mesh) == triangles);
+	// Each cluster starts cold after reordering, which costs a little on top of the threshold.
+	CHECK(GetAcmr(mesh) <= acmrCache * DEFAULT_OVERDRAW_THRESHOLD + 0.05f);
+
+	// With a threshold of 1 no cluster is split, only sorted.
+	TestMesh same = MakeShuffledSphere(64, 128, 3);
+	OptimizeVertexCache(same.indices.data(), same.indices.size(), same.vertices.size(), DEFAULT_VERTEX_CACHE_SIZE, &clusters);
+	positions = same.GetPositions();
+	OptimizeOverdraw(same.indices.data(), same.indices.size(), positions.data(), same.vertices.size(), clusters,
+		DEFAULT_VERTEX_CACHE_SIZE, 1.0f);
+	CHECK(GetTriangleSet(same) == triangles);
+}
+
+TEST_CASE("Fetch order follows the first use")
+{
+	TestMesh mesh = MakeShuffledSphere(40, 80, 9);
+	const uint32_t usedCount = (uint32_t)mesh.vertices.size();
+
+	// Vertices no triangle uses, between the used ones.
+	std::mt19937 rng(1);
+	for (uint32_t i = 0; i < 50; i++)
+	{
+		const uint32_t position = rng() % (uint32_t)mesh.vertices.size();
+		mesh.vertices.insert(mesh.vertices.begin() + position, { { 0.0f, 0.0f, 0.0f }, usedCount + i });
+		for (uint32_t& index : mesh.indices)
+		{
+			index += index >= position ? 1 : 0;
+		}
+	}
+	const auto triangles = GetTriangleSet(mesh);
+
+	OptimizeVertexFetch(mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size(), sizeof(TestVertex));
+
+	CHECK(GetTriangleSet(mesh) == triangles);
+
+	uint32_t next = 0;
+	bool firstUseOrder = true;
+	for (uint32_t index : mesh.indices)
+	{
+		if (index == next)
+		{
+			next++;
+		}
+		else
+		{
+			firstUseOrder = firstUseOrder && index < next;
+		}
+	}
+	CHECK(firstUseOrder);
+	CHECK(next == usedCount);
+
+	bool unusedAtEnd = true;
+	for (uint32_t i = usedCount; i < mesh.vertices.size(); i++)
+	{
+		unusedAtEnd = unusedAtEnd && mesh.vertices[i].id >= usedCount;
+	}
+	CHECK(unusedAtEnd);
+}
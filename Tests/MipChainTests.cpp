@@ -0,0 +1,337 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+#include "TestHarness.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include "MipChain.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	double SrgbToLinear(double c)
+	{
+		return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+	}
+
+	double LinearToSrgb(double c)
+	{
+		return c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1.0 / 2.4) - 0.055;
+	}
+
+	DecodedImage MakeNoise(uint32_t width, uint32_t height, ImageFormat format, unsigned int seed)
+	{
+		DecodedImage image;
+		image.width = width;
+		image.height = height;
+		image.format = format;
+		image.pixels.resize(image.GetRowPitch() * height);
+
+		std::mt19937 rng(seed);
+		for (uint8_t& byte : image.pixels)
+		{
+			byte = (uint8_t)rng();
+		}
+		return image;
+	}
+
+	uint32_t GetSample(const DecodedImage& image, uint64_t offset, size_t index)
+	{
+		if (image.format == ImageFormat::RGBA16 || image.format == ImageFormat::R16)
+		{
+			return ((const uint16_t*)(image.pixels.data() + offset))[index];
+		}
+		return image.pixels[offset + index];
+	}
+
+	// Builds the whole chain in double with exact area weights and returns the largest difference
+	// from the generated levels, in quantization steps.
+	int MaxDifferenceFromReference(const DecodedImage& image, bool srgb)
+	{
+		const bool is16 = image.format == ImageFormat::RGBA16;
+		const double maxValue = is16 ? 65535.0 : 255.0;
+
+		uint32_t width = image.width;
+		uint32_t height = image.height;
+		std::vector<double> current((size_t)width * height * 4);
+		for (size_t i = 0; i < current.size(); i++)
+		{
+			double v = GetSample(image, 0, i) / maxValue;
+			current[i] = srgb && i % 4 != 3 ? SrgbToLinear(v) : v;
+		}
+
+		int worst = 0;
+		for (uint32_t level = 1; level < image.mipLevels; level++)
+		{
+			uint32_t dstWidth = std::max(1u, width >> 1);
+			uint32_t dstHeight = std::max(1u, height >> 1);
+			double scaleX = (double)width / dstWidth;
+			double scaleY = (double)height / dstHeight;
+
+			std::vector<double> next((size_t)dstWidth * dstHeight * 4, 0.0);
+			for (uint32_t y = 0; y < dstHeight; y++)
+			{
+				for (uint32_t x = 0; x < dstWidth; x++)
+				{
+					for (uint32_t sy = (uint32_t)(y * scaleY); sy < std::min((double)height, std::ceil((y + 1) * scaleY)); sy++)
+					{
+						double wy = (std::min((y + 1) * scaleY, sy + 1.0) - std::max(y * scaleY, (double)sy)) / scaleY;
+						for (uint32_t sx = (uint32_t)(x * scaleX); sx < std::min((double)width, std::ceil((x + 1) * scaleX)); sx++)
+						{
+							double wx = (std::min((x + 1) * scaleX, sx + 1.0) - std::max(x * scaleX, (double)sx)) / scaleX;
+							for (int c = 0; c < 4; c++)
+							{
+								next[((size_t)y * dstWidth + x) * 4 + c] += wx * wy * current[((size_t)sy * width + sx) * 4 + c];
+							}
+						}
+					}
+				}
+			}
+
+			ImageMipLayout layout = GetImageMipLayout(image.width, image.height, image.format, level);
+			for (size_t i = 0; i < next.size(); i++)
+			{
+				double v = std::min(1.0, std::max(0.0, next[i]));
+				if (srgb && i % 4 != 3)
+				{
+					v = LinearToSrgb(v);
+				}
+				int expected = (int)std::lround(v * maxValue);
+				worst = std::max(worst, std::abs(expected - (int)GetSample(image, layout.offset, i)));
+			}
+
+			current.swap(next);
+			width = dstWidth;
+			height = dstHeight;
+		}
+
+		return worst;
+	}
+
+	float CoverageAt(const DecodedImage& image, uint32_t level)
+	{
+		ImageMipLayout layout = GetImageMipLayout(image.width, image.height, image.format, level);
+		uint32_t covered = 0;
+		for (uint32_t i = 0; i < layout.width * layout.height; i++)
+		{
+			covered += image.pixels[layout.offset + i * 4 + 3] > 127 ? 1 : 0;
+		}
+		return (float)covered / (layout.width * layout.height);
+	}
+}
+
+
+TEST_CASE("Full chain down to 1x1")
+{
+	DecodedImage image = MakeNoise(37, 5, ImageFormat::RGBA8, 1);
+	GenerateMipChain(image, {});
+
+	CHECK(image.mipLevels == 6);
+	CHECK(image.pixels.size() == GetImageByteSize(37, 5, ImageFormat::RGBA8, 6));
+
+	ImageMipLayout last = GetImageMipLayout(37, 5, ImageFormat::RGBA8, 5);
+	CHECK(last.width == 1);
+	CHECK(last.height == 1);
+}
+
+TEST_CASE("Levels match an exact area filter")
+{
+	JobSystem jobSystem(3);
+	const uint32_t sizes[][2] = { { 64, 64 }, { 37, 5 }, { 1, 9 }, { 128, 33 }, { 3, 3 }, { 256, 1 } };
+
+	for (ImageFormat format : { ImageFormat::RGBA8, ImageFormat::RGBA16 })
+	{
+		for (bool srgb : { false, true })
+		{
+			for (const auto& size : sizes)
+			{
+				DecodedImage image = MakeNoise(size[0], size[1], format, size[0] * 7 + size[1]);
+				MipChainSettings settings;
+				settings.srgb = srgb;
+				GenerateMipChain(image, settings, &jobSystem);
+
+				CHECK(MaxDifferenceFromReference(image, srgb) <= 1);
+			}
+		}
+	}
+}
+
+TEST_CASE("Single channel images are filtered")
+{
+	for (ImageFormat format : { ImageFormat::R8, ImageFormat::R16 })
+	{
+		DecodedImage image;
+		image.width = 4;
+		image.height = 2;
+		image.format = format;
+		image.pixels.resize(image.GetRowPitch() * 2, 0);
+
+		// Left half at full intensity.
+		const uint32_t one = format == ImageFormat::R8 ? 255 : 65535;
+		for (uint32_t y = 0; y < 2; y++)
+		{
+			for (uint32_t x = 0; x < 2; x++)
+			{
+				if (format == ImageFormat::R8)
+				{
+					image.pixels[y * 4 + x] = (uint8_t)one;
+				}
+				else
+				{
+					((uint16_t*)image.pixels.data())[y * 4 + x] = (uint16_t)one;
+				}
+			}
+		}
+
+		GenerateMipChain(image, {});
+		ImageMipLayout level1 = GetImageMipLayout(4, 2, format, 1);
+		ImageMipLayout level2 = GetImageMipLayout(4, 2, format, 2);
+		CHECK(GetSample(image, level1.offset, 0) == one);
+		CHECK(GetSample(image, level1.offset, 1) == 0);
+		CHECK(GetSample(image, level2.offset, 0) == (one + 1) / 2);
+	}
+}
+
+TEST_CASE("Normal maps stay unit length")
+{
+	const uint32_t size = 256;
+	DecodedImage image;
+	image.width = size;
+	image.height = size;
+	image.format = ImageFormat::RGBA8;
+	image.pixels.resize((size_t)size * size * 4);
+
+	std::mt19937 rng(3);
+	std::normal_distribution<float> gauss;
+	for (size_t i = 0; i < (size_t)size * size; i++)
+	{
+		float n[3] = { gauss(rng) * 0.4f, gauss(rng) * 0.4f, 1.0f };
+		float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		for (int c = 0; c < 3; c++)
+		{
+			image.pixels[i * 4 + c] = (uint8_t)std::lround((n[c] / length * 0.5f + 0.5f) * 255.0f);
+		}
+		image.pixels[i * 4 + 3] = 255;
+	}
+
+	MipChainSettings settings;
+	settings.normalMap = true;
+	GenerateMipChain(image, settings);
+
+	double worst = 0.0;
+	bool alphaKept = true;
+	for (uint32_t level = 1; level < image.mipLevels; level++)
+	{
+		ImageMipLayout layout = GetImageMipLayout(size, size, image.format, level);
+		for (uint32_t i = 0; i < layout.width * layout.height; i++)
+		{
+			const uint8_t* p = &image.pixels[layout.offset + i * 4];
+			double x = p[0] / 127.5 - 1.0;
+			double y = p[1] / 127.5 - 1.0;
+			double z = p[2] / 127.5 - 1.0;
+			worst = std::max(worst, std::abs(std::sqrt(x * x + y * y + z * z) - 1.0));
+			alphaKept &= p[3] == 255;
+		}
+	}
+
+	// One 8 bit step on each axis.
+	CHECK(worst < 0.015);
+	CHECK(alphaKept);
+}
+
+TEST_CASE("Alpha coverage is preserved")
+{
+	const uint32_t size = 512;
+	DecodedImage source;
+	source.width = size;
+	source.height = size;
+	source.format = ImageFormat::RGBA8;
+	source.pixels.resize((size_t)size * size * 4);
+
+	// Sparse foliage: 30% of the texels pass the alpha test.
+	std::mt19937 rng(9);
+	for (size_t i = 0; i < (size_t)size * size; i++)
+	{
+		source.pixels[i * 4] = source.pixels[i * 4 + 1] = source.pixels[i * 4 + 2] = 200;
+		source.pixels[i * 4 + 3] = rng() % 100 < 30 ? 255 : 0;
+	}
+
+	MipChainSettings settings;
+	settings.srgb = true;
+
+	DecodedImage plain = source;
+	GenerateMipChain(plain, settings);
+
+	settings.preserveAlphaCoverage = true;
+	DecodedImage preserved = source;
+	GenerateMipChain(preserved, settings);
+
+	// The first levels only hold a few distinct alpha values, so the coverage can't be matched exactly.
+	float target = CoverageAt(source, 0);
+	bool close = true;
+	for (uint32_t level = 1; level < 7; level++)
+	{
+		close &= std::abs(CoverageAt(preserved, level) - target) < 0.06f;
+	}
+	CHECK(close);
+
+	// Without it the averaged alpha of 0.3 falls below the reference and the foliage disappears.
+	CHECK(CoverageAt(plain, 4) < 0.05f);
+
+	// Opaque images are left alone.
+	DecodedImage opaque = MakeNoise(64, 64, ImageFormat::RGBA8, 1);
+	for (size_t i = 3; i < opaque.pixels.size(); i += 4)
+	{
+		opaque.pixels[i] = 255;
+	}
+	GenerateMipChain(opaque, settings);
+	bool allOpaque = true;
+	for (size_t i = 3; i < opaque.pixels.size(); i += 4)
+	{
+		allOpaque &= opaque.pixels[i] == 255;
+	}
+	CHECK(allOpaque);
+}
+
+TEST_CASE("SSE4.1 and scalar paths agree")
+{
+	JobSystem jobSystem(3);
+
+	for (ImageFormat format : { ImageFormat::RGBA8, ImageFormat::RGBA16 })
+	{
+		for (int mode = 0; mode < 3; mode++)
+		{
+			MipChainSettings settings;
+			settings.srgb = mode == 1;
+			settings.preserveAlphaCoverage = mode == 1;
+			settings.normalMap = mode == 2;
+
+			DecodedImage source = MakeNoise(129, 67, format, 11 + mode);
+
+			RestrictCpuFeatures({ false, false, false });
+			DecodedImage scalar = source;
+			GenerateMipChain(scalar, settings, &jobSystem);
+			RestrictCpuFeatures({ true, true, true });
+
+			DecodedImage simd = source;
+			GenerateMipChain(simd, settings, &jobSystem);
+
+			// Only halfway rounding and the order of the tap sums differ.
+			int worst = 0;
+			for (size_t i = 0; i < scalar.pixels.size() / (format == ImageFormat::RGBA16 ? 2 : 1); i++)
+			{
+				worst = std::max(worst, std::abs((int)GetSample(scalar, 0, i) - (int)GetSample(simd, 0, i)));
+			}
+			CHECK(worst <= 1);
+			CHECK(scalar.mipLevels == simd.mipLevels);
+		}
+	}
+}
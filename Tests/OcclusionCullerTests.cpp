@@ -0,0 +1,357 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <random>
+
+#include "TestHarness.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include "OcclusionCuller.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	const unsigned int WIDTH = 320;
+	const unsigned int HEIGHT = 180;
+	const unsigned int TILES_X = WIDTH / OcclusionCuller::TILE_WIDTH;
+	const unsigned int TILES_Y = HEIGHT / OcclusionCuller::TILE_HEIGHT;
+	const int32_t SUBPIXELS = 16;
+
+	// Screen space triangle with its corners on the 1/16 pixel grid the culler snaps to, at one depth.
+	struct Triangle
+	{
+		int32_t x[3];
+		int32_t y[3];
+		float z;
+	};
+
+	// Maps x and y in pixels to clip space, z stays and w is 1.
+	XMMATRIX MakeScreenProjection()
+	{
+		return XMMatrixMultiply(XMMatrixScaling(2.0f / WIDTH, -2.0f / HEIGHT, 1.0f), XMMatrixTranslation(-1.0f, 1.0f, 0.0f));
+	}
+
+	// Scalar reference of the masked depth buffer: every pixel center is tested against the unclamped
+	// 64 bit edge functions, and the tiles are updated in triangle order.
+	class ReferenceBuffer
+	{
+	public:
+		ReferenceBuffer() :
+			m_tileDepth(TILES_X * TILES_Y, 1.0f),
+			m_maskDepth(TILES_X * TILES_Y, 0.0f),
+			m_mask(TILES_X * TILES_Y, 0)
+		{
+		}
+
+		void Draw(const Triangle& t)
+		{
+			// Counter-clockwise and degenerate triangles are culled.
+			int64_t area = (int64_t)(t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (int64_t)(t.y[1] - t.y[0]) * (t.x[2] - t.x[0]);
+			if (area <= 0)
+			{
+				return;
+			}
+
+			int minX, minY, maxX, maxY;
+			GetPixelBounds(t, minX, minY, maxX, maxY);
+
+			for (int ty = minY / (int)OcclusionCuller::TILE_HEIGHT; ty <= maxY / (int)OcclusionCuller::TILE_HEIGHT; ty++)
+			{
+				for (int tx = minX / (int)OcclusionCuller::TILE_WIDTH; tx <= maxX / (int)OcclusionCuller::TILE_WIDTH; tx++)
+				{
+					uint32_t coverage = 0;
+					for (unsigned int row = 0; row < OcclusionCuller::TILE_HEIGHT; row++)
+					{
+						for (unsigned int column = 0; column < OcclusionCuller::TILE_WIDTH; column++)
+						{
+							if (IsCovered(t, tx * OcclusionCuller::TILE_WIDTH + column, ty * OcclusionCuller::TILE_HEIGHT + row))
+							{
+								coverage |= 1u << (row * OcclusionCuller::TILE_WIDTH + column);
+							}
+						}
+					}
+
+					if (coverage != 0)
+					{
+						_updateTile(ty * TILES_X + tx, coverage, t.z);
+					}
+				}
+			}
+		}
+
+		std::vector<float> GetPixelDepths() const
+		{
+			std::vector<float> depths(WIDTH * HEIGHT);
+			for (unsigned int y = 0; y < HEIGHT; y++)
+			{
+				for (unsigned int x = 0; x < WIDTH; x++)
+				{
+					uint32_t tile = (y / OcclusionCuller::TILE_HEIGHT) * TILES_X + x / OcclusionCuller::TILE_WIDTH;
+					uint32_t bit = 1u << ((y % OcclusionCuller::TILE_HEIGHT) * OcclusionCuller::TILE_WIDTH + x % OcclusionCuller::TILE_WIDTH);
+					depths[y * WIDTH + x] = (m_mask[tile] & bit) ? m_maskDepth[tile] : m_tileDepth[tile];
+				}
+			}
+			return depths;
+		}
+
+		// The on screen pixels around the triangle, a pixel wider than its corners on each side.
+		static void GetPixelBounds(const Triangle& t, int& minX, int& minY, int& maxX, int& maxY)
+		{
+			minX = std::max(std::min(t.x[0], std::min(t.x[1], t.x[2])) / SUBPIXELS - 1, 0);
+			minY = std::max(std::min(t.y[0], std::min(t.y[1], t.y[2])) / SUBPIXELS - 1, 0);
+			maxX = std::min(std::max(t.x[0], std::max(t.x[1], t.x[2])) / SUBPIXELS + 1, (int)WIDTH - 1);
+			maxY = std::min(std::max(t.y[0], std::max(t.y[1], t.y[2])) / SUBPIXELS + 1, (int)HEIGHT - 1);
+		}
+
+		// Pixel centers on an edge belong to the triangle when the edge runs up the screen, or to the right
+		// along a row, so triangles sharing an edge never both cover a pixel.
+		static bool IsCovered(const Triangle& t, int px, int py)
+		{
+			int64_t x = (int64_t)px * SUBPIXELS + SUBPIXELS / 2;
+			int64_t y = (int64_t)py * SUBPIXELS + SUBPIXELS / 2;
+			for (unsigned int e = 0; e < 3; e++)
+			{
+				unsigned int i = e;
+				unsigned int j = (e + 1) % 3;
+				int64_t dx = t.x[j] - t.x[i];
+				int64_t dy = t.y[j] - t.y[i];
+				int64_t value = dx * (y - t.y[i]) - dy * (x - t.x[i]);
+				bool owned = dy < 0 || (dy == 0 && dx > 0);
+				if (value < 0 || (value == 0 && owned == false))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+	private:
+		void _updateTile(uint32_t tile, uint32_t coverage, float depth)
+		{
+			if (depth >= m_tileDepth[tile])
+			{
+				return;
+			}
+
+			if (m_maskDepth[tile] - depth > m_tileDepth[tile] - m_maskDepth[tile])
+			{
+				m_maskDepth[tile] = 0.0f;
+				m_mask[tile] = 0;
+			}
+
+			m_maskDepth[tile] = std::max(m_maskDepth[tile], depth);
+			m_mask[tile] |= coverage;
+			if (m_mask[tile] == 0xFFFFFFFFu)
+			{
+				m_tileDepth[tile] = m_maskDepth[tile];
+				m_maskDepth[tile] = 0.0f;
+				m_mask[tile] = 0;
+			}
+		}
+
+		std::vector<float> m_tileDepth;
+		std::vector<float> m_maskDepth;
+		std::vector<uint32_t> m_mask;
+	};
+
+	std::vector<float> RasterizeWith(const CpuFeatures& allowed, JobSystem* jobSystem, const std::vector<Triangle>& triangles)
+	{
+		std::vector<XMFLOAT3> vertices;
+		std::vector<uint32_t> indices;
+		for (const Triangle& t : triangles)
+		{
+			for (unsigned int v = 0; v < 3; v++)
+			{
+				indices.push_back((uint32_t)vertices.size());
+				vertices.push_back(XMFLOAT3((float)t.x[v] / SUBPIXELS, (float)t.y[v] / SUBPIXELS, t.z));
+			}
+		}
+
+		RestrictCpuFeatures(allowed);
+
+		OcclusionCuller culler(WIDTH, HEIGHT, jobSystem);
+		culler.Begin(MakeScreenProjection());
+		culler.AddOccluder(XMMatrixIdentity(), vertices.data(), (unsigned int)vertices.size(), indices.data(),
+			(unsigned int)indices.size());
+		culler.Rasterize();
+
+		RestrictCpuFeatures({ true, true, true });
+
+		std::vector<float> depths;
+		culler.GetPixelDepths(depths);
+		return depths;
+	}
+
+	// The SSE2 and the AVX2 path, alone and on worker threads, have to match the reference at every pixel.
+	bool MatchesReference(const std::vector<Triangle>& triangles)
+	{
+		ReferenceBuffer reference;
+		for (const Triangle& t : triangles)
+		{
+			reference.Draw(t);
+		}
+		std::vector<float> expected = reference.GetPixelDepths();
+
+		JobSystem jobSystem(3);
+		bool same = true;
+		for (bool useAvx2 : { false, true })
+		{
+			for (JobSystem* jobs : { (JobSystem*)nullptr, &jobSystem })
+			{
+				same = same && RasterizeWith({ true, useAvx2, useAvx2 }, jobs, triangles) == expected;
+			}
+		}
+		return same;
+	}
+
+	Triangle MakeTriangle(std::mt19937& rng, int32_t minCoord, int32_t maxCoord, int32_t size)
+	{
+		std::uniform_int_distribution<int32_t> position(minCoord, maxCoord);
+		std::uniform_int_distribution<int32_t> offset(-size, size);
+		std::uniform_real_distribution<float> depth(0.05f, 0.95f);
+
+		Triangle t;
+		t.x[0] = position(rng);
+		t.y[0] = position(rng) * (int32_t)HEIGHT / (int32_t)WIDTH;
+		for (unsigned int v = 1; v < 3; v++)
+		{
+			t.x[v] = t.x[0] + offset(rng);
+			t.y[v] = t.y[0] + offset(rng);
+		}
+		t.z = depth(rng);
+		return t;
+	}
+
+	// Two triangles per cell, corners on pixel centers so the edges run through them.
+	void AddQuadGrid(std::vector<Triangle>& triangles, int32_t cellSize, float depth)
+	{
+		for (int32_t y = -cellSize; y < (int32_t)HEIGHT + cellSize; y += cellSize)
+		{
+			for (int32_t x = -cellSize; x < (int32_t)WIDTH + cellSize; x += cellSize)
+			{
+				int32_t x0 = x * SUBPIXELS + SUBPIXELS / 2;
+				int32_t y0 = y * SUBPIXELS + SUBPIXELS / 2;
+				int32_t x1 = x0 + cellSize * SUBPIXELS;
+				int32_t y1 = y0 + cellSize * SUBPIXELS;
+				triangles.push_back({ { x0, x1, x1 }, { y0, y0, y1 }, depth });
+				triangles.push_back({ { x0, x1, x0 }, { y0, y1, y1 }, depth });
+			}
+		}
+	}
+}
+
+
+TEST_CASE("Shared edges cover every pixel once")
+{
+	std::vector<Triangle> triangles;
+	AddQuadGrid(triangles, 3, 0.5f);
+
+	std::vector<int> counts(WIDTH * HEIGHT, 0);
+	for (const Triangle& t : triangles)
+	{
+		int minX, minY, maxX, maxY;
+		ReferenceBuffer::GetPixelBounds(t, minX, minY, maxX, maxY);
+		for (int py = minY; py <= maxY; py++)
+		{
+			for (int px = minX; px <= maxX; px++)
+			{
+				counts[py * WIDTH + px] += ReferenceBuffer::IsCovered(t, px, py) ? 1 : 0;
+			}
+		}
+	}
+	CHECK(std::all_of(counts.begin(), counts.end(), [](int count) { return count == 1; }));
+}
+
+TEST_CASE("Random triangles match the scalar reference")
+{
+	std::mt19937 rng(11);
+	const int32_t width = (int32_t)WIDTH * SUBPIXELS;
+
+	// Slivers, tile sized and screen sized triangles, half of them facing away.
+	std::vector<Triangle> triangles;
+	for (int i = 0; i < 600; i++)
+	{
+		triangles.push_back(MakeTriangle(rng, 0, width, 4 * SUBPIXELS));
+	}
+	for (int i = 0; i < 200; i++)
+	{
+		triangles.push_back(MakeTriangle(rng, 0, width, 40 * SUBPIXELS));
+	}
+	for (int i = 0; i < 20; i++)
+	{
+		triangles.push_back(MakeTriangle(rng, -width / 2, width * 3 / 2, width));
+	}
+	CHECK(MatchesReference(triangles));
+}
+
+TEST_CASE("Closed surfaces fill the tiles")
+{
+	// Full masks move the tile depth nearer, the nearer layers start new masks.
+	std::vector<Triangle> triangles;
+	AddQuadGrid(triangles, 7, 0.8f);
+	AddQuadGrid(triangles, 5, 0.6f);
+
+	std::mt19937 rng(5);
+	const int32_t width = (int32_t)WIDTH * SUBPIXELS;
+	for (int i = 0; i < 100; i++)
+	{
+		triangles.push_back(MakeTriangle(rng, 0, width, 20 * SUBPIXELS));
+	}
+	AddQuadGrid(triangles, 16, 0.3f);
+	CHECK(MatchesReference(triangles));
+}
+
+TEST_CASE("Triangles reaching into the guard band")
+{
+	// Edge functions far outside the screen are clamped at the tile origins, the coverage has to stay exact.
+	const int32_t w = (int32_t)WIDTH * SUBPIXELS;
+	const int32_t h = (int32_t)HEIGHT * SUBPIXELS;
+	std::vector<Triangle> triangles =
+	{
+		{ { -w / 2, w * 3 / 2, -w / 2 }, { -h / 2, h / 3, h * 3 / 2 }, 0.7f },
+		{ { w * 3 / 2, w * 3 / 2, -w / 3 }, { -h / 2, h * 3 / 2, h / 2 + 5 }, 0.5f },
+		{ { w / 2 + 3, w * 3 / 2, -w / 2 }, { -h / 2, h + 7, h - 9 }, 0.4f },
+	};
+	CHECK(MatchesReference(triangles));
+}
+
+TEST_CASE("Boxes behind an occluder are hidden")
+{
+	XMMATRIX viewProj = XMMatrixMultiply(XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, -10.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),
+		XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)), XMMatrixPerspectiveFovLH(0.785f, 16.0f / 9.0f, 1.0f, 1000.0f));
+
+	JobSystem jobSystem(2);
+	for (bool useAvx2 : { false, true })
+	{
+		RestrictCpuFeatures({ true, useAvx2, useAvx2 });
+
+		OcclusionCuller culler(WIDTH, HEIGHT, &jobSystem);
+		culler.Begin(viewProj);
+		culler.AddOccluder(XMMatrixIdentity(), BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(4.0f, 3.0f, 0.1f)));
+		culler.Rasterize();
+
+		CHECK(culler.IsVisible(BoundingBox(XMFLOAT3(0.0f, 0.0f, 5.0f), XMFLOAT3(1.0f, 1.0f, 1.0f))) == false);
+		CHECK(culler.IsVisible(BoundingBox(XMFLOAT3(0.0f, 0.0f, -3.0f), XMFLOAT3(1.0f, 1.0f, 1.0f))));
+		CHECK(culler.IsVisible(BoundingBox(XMFLOAT3(7.0f, 0.0f, 5.0f), XMFLOAT3(1.0f, 1.0f, 1.0f))));
+		CHECK(culler.IsVisible(BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f))));
+		CHECK(culler.GetStats().occludedCount == 1 && culler.GetStats().testedCount == 4);
+	}
+	RestrictCpuFeatures({ true, true, true });
+}
+
+TEST_CASE("Buffer size is checked")
+{
+	CHECK_THROWS(OcclusionCuller(0, 4));
+	CHECK_THROWS(OcclusionCuller(36, 4));
+	CHECK_THROWS(OcclusionCuller(8, 6));
+	CHECK_THROWS(OcclusionCuller(1032, 4));
+
+	OcclusionCuller culler(1024, 1024);
+	CHECK(culler.GetWidth() == 1024 && culler.GetHeight() == 1024);
+}
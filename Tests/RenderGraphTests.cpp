@@ -0,0 +1,424 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+
+#include "TestHarness.h"
+#include "RenderGraph.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	std::string MakeName(const char* prefix, unsigned int index)
+	{
+		std::string name = prefix;
+		name += std::to_string(index);
+		return name;
+	}
+
+	struct FrameGraph
+	{
+		RGResourceHandle shadowMap;
+		RGResourceHandle depthStencil;
+		RGResourceHandle backBuffer;
+		RGResourceHandle normalDepth;
+		RGResourceHandle ambientMap;
+		RGResourceHandle ambientBlur;
+	};
+
+	// Same layout as Renderer::_buildRenderGraph.
+	FrameGraph BuildFrameGraph(RenderGraph& graph)
+	{
+		FrameGraph g;
+		g.shadowMap = graph.ImportResource("ShadowMap", RGResourceState::GenericRead, RGResourceState::GenericRead);
+		g.depthStencil = graph.ImportResource("DepthStencil", RGResourceState::DepthWrite, RGResourceState::DepthWrite);
+		g.backBuffer = graph.ImportResource("BackBuffer", RGResourceState::Present, RGResourceState::Present, true);
+		g.normalDepth = graph.CreateTransient("NormalDepth", 1920 * 1080 * 8, 65536);
+		g.ambientMap = graph.CreateTransient("AmbientMap", 960 * 540 * 2, 65536);
+		g.ambientBlur = graph.CreateTransient("AmbientBlur", 960 * 540 * 2, 65536);
+
+		graph.AddPass("ShadowMap", [&](RenderGraph::PassBuilder& builder)
+			{
+				builder.Write(g.shadowMap, RGResourceState::DepthWrite);
+			}, nullptr);
+
+		graph.AddPass("NormalDepth", [&](RenderGraph::PassBuilder& builder)
+			{
+				builder.Write(g.normalDepth, RGResourceState::RenderTarget);
+				builder.Write(g.depthStencil, RGResourceState::DepthWrite);
+			}, nullptr);
+
+		graph.AddPass("SSAO", [&](RenderGraph::PassBuilder& builder)
+			{
+				builder.Read(g.normalDepth, RGResourceState::GenericRead);
+				builder.Read(g.depthStencil, RGResourceState::ShaderResource);
+				builder.Write(g.ambientMap, RGResourceState::GenericRead);
+				builder.Write(g.ambientBlur, RGResourceState::GenericRead);
+			}, nullptr);
+
+		graph.AddPass("Main", [&](RenderGraph::PassBuilder& builder)
+			{
+				builder.Read(g.shadowMap, RGResourceState::GenericRead);
+				builder.Read(g.ambientMap, RGResourceState::GenericRead);
+				builder.Write(g.depthStencil, RGResourceState::DepthWrite);
+				builder.Write(g.backBuffer, RGResourceState::RenderTarget);
+			}, nullptr);
+
+		return g;
+	}
+
+	unsigned int CountBarriers(const RecordingRenderGraphBackend& backend, RGResourceHandle resource, bool isAliasing)
+	{
+		return (unsigned int)std::count_if(backend.barriers.begin(), backend.barriers.end(), [&](const RGBarrier& b)
+			{
+				return b.resource == resource && b.isAliasing == isAliasing;
+			});
+	}
+
+	// T0 -> T1 -> T2 -> output, each transient is only alive for two consecutive passes.
+	void BuildChain(RenderGraph& graph, RGResourceHandle t[3], RGResourceHandle& output)
+	{
+		output = graph.ImportResource("Output", RGResourceState::Present, RGResourceState::Present, true);
+
+		graph.AddPass("P0", [&](RenderGraph::PassBuilder& builder)
+			{
+				builder.Write(t[0], RGResourceState::RenderTarget);
+			}, nullptr);
+		graph.AddPass("P1", [&](RenderGraph::PassBuilder& builder)
+			{
+				builder.Read(t[0], RGResourceState::ShaderResource);
+				builder.Write(t[1], RGResourceState::RenderTarget);
+			}, nullptr);
+		graph.AddPass("P2", [&](RenderGraph::PassBuilder& builder)
+			{
+				builder.Read(t[1], RGResourceState::ShaderResource);
+				builder.Write(t[2], RGResourceState::RenderTarget);
+			}, nullptr);
+		graph.AddPass("P3", [&](RenderGraph::PassBuilder& builder)
+			{
+				builder.Read(t[2], RGResourceState::ShaderResource);
+				builder.Write(output, RGResourceState::RenderTarget);
+			}, nullptr);
+	}
+}
+
+
+TEST_CASE("Frame graph merges its barriers into batches")
+{
+	RenderGraph graph;
+	FrameGraph g = BuildFrameGraph(graph);
+	graph.Compile();
+
+	RecordingRenderGraphBackend backend;
+	graph.Execute(backend);
+
+	auto& stats = graph.GetStats();
+	CHECK(stats.passCount == 4);
+	CHECK(stats.culledPassCount == 0);
+	CHECK(stats.barrierCount == 11);
+	CHECK(stats.barrierBatchCount == 5);
+	CHECK(backend.barrierCount == stats.barrierCount);
+	CHECK(backend.batchCount == stats.barrierBatchCount);
+	CHECK((backend.passes == std::vector<std::string>{ "ShadowMap", "NormalDepth", "SSAO", "Main" }));
+
+	// Every transient is activated once, normal-depth goes back to its first state for the next frame.
+	CHECK(CountBarriers(backend, g.normalDepth, true) == 1);
+	CHECK(CountBarriers(backend, g.ambientMap, true) == 1);
+	CHECK(CountBarriers(backend, g.ambientBlur, true) == 1);
+	CHECK(CountBarriers(backend, g.normalDepth, false) == 2);
+	CHECK(graph.GetTransientState(g.normalDepth) == RGResourceState::RenderTarget);
+	CHECK(graph.GetTransientState(g.ambientMap) == RGResourceState::GenericRead);
+
+	CHECK(backend.barriers.back().resource == g.backBuffer);
+	CHECK(backend.barriers.back().after == RGResourceState::Present);
+
+	// The SSAO targets are all alive during the SSAO pass and can't share memory.
+	CHECK(graph.GetTransientOffset(g.ambientMap) >= 1920 * 1080 * 8);
+	CHECK(graph.GetTransientOffset(g.ambientBlur) >= 1920 * 1080 * 8);
+	CHECK(graph.GetTransientOffset(g.ambientMap) != graph.GetTransientOffset(g.ambientBlur));
+	CHECK(stats.transientMemoryPeak >= stats.transientMemoryUnaliased);
+}
+
+TEST_CASE("Executing twice records the same barriers")
+{
+	RenderGraph graph;
+	BuildFrameGraph(graph);
+
+	RecordingRenderGraphBackend first;
+	graph.Execute(first);
+	RecordingRenderGraphBackend second;
+	graph.Execute(second);
+
+	CHECK(graph.IsCompiled());
+	CHECK(first.barrierCount == second.barrierCount);
+	CHECK(first.batchCount == second.batchCount);
+	CHECK(first.passes == second.passes);
+}
+
+TEST_CASE("Passes without consumers are culled")
+{
+	RenderGraph graph;
+	auto output = graph.ImportResource("Output", RGResourceState::Present, RGResourceState::Present, true);
+	auto unused = graph.CreateTransient("Unused", 1024, 1);
+	auto debug = graph.CreateTransient("Debug", 1024, 1);
+
+	graph.AddPass("Dead", [&](RenderGraph::PassBuilder& builder)
+		{
+			builder.Write(unused, RGResourceState::RenderTarget);
+		}, nullptr);
+	graph.AddPass("Capture", [&](RenderGraph::PassBuilder& builder)
+		{
+			builder.Write(debug, RGResourceState::RenderTarget);
+			builder.HasSideEffect();
+		}, nullptr);
+	graph.AddPass("Present", [&](RenderGraph::PassBuilder& builder)
+		{
+			builder.Write(output, RGResourceState::RenderTarget);
+		}, nullptr);
+	graph.Compile();
+
+	CHECK(graph.IsPassCulled("Dead"));
+	CHECK(graph.IsPassCulled("Capture") == false);
+	CHECK(graph.IsPassCulled("Present") == false);
+	CHECK(graph.GetStats().culledPassCount == 1);
+	CHECK(graph.GetStats().passCount == 2);
+
+	// The culled pass' transient takes no memory and gets no state.
+	CHECK(graph.GetStats().transientMemoryUnaliased == 1024);
+	CHECK(graph.GetTransientState(unused) == RGResourceState::Undefined);
+
+	RecordingRenderGraphBackend backend;
+	graph.Execute(backend);
+	CHECK((backend.passes == std::vector<std::string>{ "Capture", "Present" }));
+	CHECK(CountBarriers(backend, unused, true) == 0);
+}
+
+TEST_CASE("Culling propagates through the readers")
+{
+	RenderGraph graph;
+	auto output = graph.ImportResource("Output", RGResourceState::Present, RGResourceState::Present, true);
+	auto a = graph.CreateTransient("A", 64, 1);
+	auto b = graph.CreateTransient("B", 64, 1);
+
+	// B is only read by a pass which is culled itself, so its producer goes as well.
+	graph.AddPass("WriteA", [&](RenderGraph::PassBuilder& builder) { builder.Write(a, RGResourceState::RenderTarget); }, nullptr);
+	graph.AddPass("WriteB", [&](RenderGraph::PassBuilder& builder) { builder.Write(b, RGResourceState::RenderTarget); }, nullptr);
+	graph.AddPass("ReadB", [&](RenderGraph::PassBuilder& builder)
+		{
+			builder.Read(b, RGResourceState::ShaderResource);
+			builder.Write(graph.CreateTransient("Scratch", 64, 1), RGResourceState::RenderTarget);
+		}, nullptr);
+	graph.AddPass("Final", [&](RenderGraph::PassBuilder& builder)
+		{
+			builder.Read(a, RGResourceState::ShaderResource);
+			builder.Write(output, RGResourceState::RenderTarget);
+		}, nullptr);
+	graph.Compile();
+
+	CHECK(graph.IsPassCulled("WriteA") == false);
+	CHECK(graph.IsPassCulled("WriteB"));
+	CHECK(graph.IsPassCulled("ReadB"));
+	CHECK(graph.IsPassCulled("Final") == false);
+	CHECK(graph.IsPassCulled("Missing"));
+}
+
+TEST_CASE("Transients with disjoint lifetimes share memory")
+{
+	RenderGraph graph;
+	RGResourceHandle t[3] =
+	{
+		graph.CreateTransient("T0", 1000, 1),
+		graph.CreateTransient("T1", 600, 1),
+		graph.CreateTransient("T2", 1000, 1),
+	};
+	RGResourceHandle output;
+	BuildChain(graph, t, output);
+	graph.Compile();
+
+	auto& stats = graph.GetStats();
+	CHECK(stats.transientMemoryUnaliased == 2600);
+	CHECK(stats.transientMemoryPeak == 1600);
+	CHECK(graph.GetTransientOffset(t[0]) == 0);
+	CHECK(graph.GetTransientOffset(t[2]) == 0);
+	CHECK(graph.GetTransientOffset(t[1]) == 1000);
+
+	// T2 takes over the memory of T0.
+	RecordingRenderGraphBackend backend;
+	graph.Execute(backend);
+	auto alias = std::find_if(backend.barriers.begin(), backend.barriers.end(), [&](const RGBarrier& b)
+		{
+			return b.isAliasing && b.resource == t[2];
+		});
+	CHECK(alias != backend.barriers.end());
+	CHECK(alias != backend.barriers.end() && alias->aliasBefore == t[0]);
+	CHECK(alias != backend.barriers.end() && alias->after == RGResourceState::RenderTarget);
+
+	auto first = std::find_if(backend.barriers.begin(), backend.barriers.end(), [&](const RGBarrier& b)
+		{
+			return b.isAliasing && b.resource == t[0];
+		});
+	CHECK(first != backend.barriers.end() && first->aliasBefore == RG_INVALID_HANDLE);
+}
+
+TEST_CASE("Aliased offsets respect the alignment")
+{
+	RenderGraph graph;
+	RGResourceHandle t[3] =
+	{
+		graph.CreateTransient("T0", 100, 256),
+		graph.CreateTransient("T1", 100, 256),
+		graph.CreateTransient("T2", 100, 256),
+	};
+	RGResourceHandle output;
+	BuildChain(graph, t, output);
+	graph.Compile();
+
+	for (auto handle : t)
+	{
+		CHECK(graph.GetTransientOffset(handle) % 256 == 0);
+	}
+	CHECK(graph.GetTransientOffset(t[0]) != graph.GetTransientOffset(t[1]));
+	CHECK(graph.GetTransientOffset(t[1]) != graph.GetTransientOffset(t[2]));
+	CHECK(graph.GetStats().transientMemoryPeak == 356);
+}
+
+TEST_CASE("Overlapping transients never share memory")
+{
+	// Many transients with random lifetimes, every pair alive at the same time must be disjoint.
+	RenderGraph graph;
+	auto output = graph.ImportResource("Output", RGResourceState::Present, RGResourceState::Present, true);
+
+	const unsigned int passCount = 64;
+	std::vector<RGResourceHandle> transients;
+	std::vector<uint64_t> sizes;
+	std::vector<uint64_t> alignments;
+	std::vector<unsigned int> readFrom;
+	unsigned int seed = 12345;
+	auto next = [&]() { seed = seed * 1103515245 + 12345; return (seed >> 16) & 0x7fff; };
+
+	for (unsigned int i = 0; i < passCount; i++)
+	{
+		sizes.push_back(256 + next() % 4096);
+		alignments.push_back(1ull << (next() % 9));
+		readFrom.push_back(i == 0 ? 0 : next() % i);
+		transients.push_back(graph.CreateTransient(MakeName("T", i), sizes[i], alignments[i]));
+	}
+
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		graph.AddPass(MakeName("P", p), [&, p](RenderGraph::PassBuilder& builder)
+			{
+				if (p > 0)
+				{
+					builder.Read(transients[readFrom[p]], RGResourceState::ShaderResource);
+					builder.Read(transients[p - 1], RGResourceState::ShaderResource);
+				}
+				builder.Write(transients[p], RGResourceState::RenderTarget);
+				if (p == passCount - 1)
+				{
+					builder.Write(output, RGResourceState::RenderTarget);
+				}
+			}, nullptr);
+	}
+	graph.Compile();
+
+	// The schedule is the declaration order here, a transient lives from its writer to its last reader.
+	std::vector<int> lastUse(passCount);
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		lastUse[p] = (int)p;
+		if (p > 0)
+		{
+			lastUse[readFrom[p]] = (int)p;
+			lastUse[p - 1] = (int)p;
+		}
+	}
+
+	for (unsigned int i = 0; i < passCount; i++)
+	{
+		CHECK(graph.GetTransientOffset(transients[i]) % alignments[i] == 0);
+	}
+
+	unsigned int overlaps = 0;
+	uint64_t peak = 0;
+	for (unsigned int i = 0; i < passCount; i++)
+	{
+		uint64_t beginI = graph.GetTransientOffset(transients[i]);
+		peak = std::max(peak, beginI + sizes[i]);
+		for (unsigned int j = i + 1; j < passCount; j++)
+		{
+			bool alive = (int)i <= lastUse[j] && (int)j <= lastUse[i];
+			uint64_t beginJ = graph.GetTransientOffset(transients[j]);
+			bool shared = beginI < beginJ + sizes[j] && beginJ < beginI + sizes[i];
+			overlaps += alive && shared ? 1 : 0;
+		}
+	}
+
+	CHECK(overlaps == 0);
+	CHECK(graph.GetStats().transientMemoryPeak == peak);
+	CHECK(graph.GetStats().transientMemoryPeak < graph.GetStats().transientMemoryUnaliased);
+}
+
+TEST_CASE("Dependencies order the schedule")
+{
+	RenderGraph graph;
+	auto output = graph.ImportResource("Output", RGResourceState::Present, RGResourceState::Present, true);
+	auto shared = graph.ImportResource("Shared", RGResourceState::GenericRead, RGResourceState::GenericRead);
+
+	// Declared out of order: the consumer before its producer still runs after it,
+	// since the reader only sees the imported contents.
+	graph.AddPass("Reader", [&](RenderGraph::PassBuilder& builder)
+		{
+			builder.Read(shared, RGResourceState::ShaderResource);
+			builder.Write(output, RGResourceState::RenderTarget);
+		}, nullptr);
+	graph.AddPass("Writer", [&](RenderGraph::PassBuilder& builder)
+		{
+			builder.Write(shared, RGResourceState::RenderTarget);
+			builder.HasSideEffect();
+		}, nullptr);
+
+	RecordingRenderGraphBackend backend;
+	graph.Execute(backend);
+
+	// Write after read keeps the declaration order.
+	CHECK((backend.passes == std::vector<std::string>{ "Reader", "Writer" }));
+	CHECK(graph.GetResourceName(shared) == "Shared");
+	CHECK(graph.IsTransient(shared) == false);
+}
+
+TEST_CASE("Conflicting states in one pass throw")
+{
+	RenderGraph graph;
+	auto output = graph.ImportResource("Output", RGResourceState::Present, RGResourceState::Present, true);
+	auto texture = graph.CreateTransient("Texture", 64, 1);
+
+	graph.AddPass("Setup", [&](RenderGraph::PassBuilder& builder)
+		{
+			builder.Write(texture, RGResourceState::RenderTarget);
+		}, nullptr);
+	graph.AddPass("Bad", [&](RenderGraph::PassBuilder& builder)
+		{
+			builder.Read(texture, RGResourceState::ShaderResource);
+			builder.Read(texture, RGResourceState::CopySource);
+			builder.Write(output, RGResourceState::RenderTarget);
+		}, nullptr);
+
+	CHECK_THROWS(graph.Compile());
+}
+
+TEST_CASE("Invalid handles are rejected")
+{
+	RenderGraph graph;
+	CHECK_THROWS(graph.AddPass("Bad", [](RenderGraph::PassBuilder& builder)
+		{
+			builder.Read(7, RGResourceState::ShaderResource);
+		}, nullptr));
+
+	graph.Clear();
+	CHECK(graph.GetResourceCount() == 0);
+}
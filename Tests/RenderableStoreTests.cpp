@@ -0,0 +1,158 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <cstring>
+#include <memory>
+#include <random>
+
+#include "TestHarness.h"
+#include "RenderableStore.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	const unsigned int FRAME_RESOURCE_COUNT = 3;
+
+	PositionQuantization MakeQuantization(float scale)
+	{
+		PositionQuantization quantization;
+		quantization.scale = XMFLOAT3(scale, scale * 2.0f, scale * 3.0f);
+		quantization.offset = XMFLOAT3(-scale, 0.0f, scale);
+		return quantization;
+	}
+
+	std::unique_ptr<RenderableStore> MakeStore(uint32_t count)
+	{
+		std::unique_ptr<RenderableStore> store(new RenderableStore(FRAME_RESOURCE_COUNT));
+		for (uint32_t i = 0; i < count; i++)
+		{
+			BoundingBox bounds(XMFLOAT3((float)i, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+			store->Add(bounds, MakeQuantization(0.5f + i), i % 7);
+		}
+		return store;
+	}
+
+	// The record Renderer used to build for every instance each frame.
+	ObjectData MakeRecord(FXMMATRIX world, const PositionQuantization& quantization, uint32_t materialIndex)
+	{
+		ObjectData data;
+		XMStoreFloat4x4(&data.worldMatrix, XMMatrixTranspose(world));
+		data.positionScale = quantization.scale;
+		data.positionOffset = quantization.offset;
+		data.materialIndex = materialIndex;
+		return data;
+	}
+}
+
+
+TEST_CASE("Objects start at the origin")
+{
+	std::unique_ptr<RenderableStore> store = MakeStore(10);
+	CHECK(store->GetCount() == 10);
+
+	for (uint32_t id = 0; id < 10; id++)
+	{
+		ObjectData expected = MakeRecord(XMMatrixIdentity(), MakeQuantization(0.5f + id), id % 7);
+		CHECK(std::memcmp(&store->GetObjectData()[id], &expected, sizeof(ObjectData)) == 0);
+		CHECK(store->GetLocalBounds(id).Center.x == (float)id);
+		CHECK(store->GetMaterial(id) == id % 7);
+		XMFLOAT3 position = store->GetPosition(id);
+		CHECK(position.x == 0.0f && position.y == 0.0f && position.z == 0.0f);
+	}
+	CHECK(store->GetMoved().empty());
+}
+
+TEST_CASE("Moved objects are listed once")
+{
+	std::unique_ptr<RenderableStore> store = MakeStore(10);
+
+	store->SetWorldTransform(4, XMMatrixTranslation(1.0f, 2.0f, 3.0f));
+	store->SetWorldTransform(2, XMMatrixTranslation(0.0f, 0.0f, 1.0f));
+	store->SetWorldTransform(4, XMMatrixTranslation(4.0f, 5.0f, 6.0f));
+	store->SetMaterial(6, 1);
+	CHECK(store->GetMoved() == std::vector<uint32_t>({ 4, 2 }));
+
+	XMFLOAT3 position = store->GetPosition(4);
+	CHECK(position.x == 4.0f && position.y == 5.0f && position.z == 6.0f);
+	CHECK(store->GetMaterial(6) == 1);
+
+	// The GPU record holds the transposed world matrix.
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, store->GetWorldTransform(4));
+	const XMFLOAT4X4& record = store->GetObjectData()[4].worldMatrix;
+	CHECK(record._14 == world._41 && record._24 == world._42 && record._34 == world._43);
+
+	store->ClearMoved();
+	CHECK(store->GetMoved().empty());
+	store->SetWorldTransform(2, XMMatrixIdentity());
+	CHECK(store->GetMoved() == std::vector<uint32_t>({ 2 }));
+}
+
+TEST_CASE("Collected runs keep every frame resource in sync")
+{
+	const uint32_t count = 5000;
+	std::unique_ptr<RenderableStore> store = MakeStore(count);
+
+	// What the object buffer of each frame resource holds, and the records rebuilt from scratch.
+	std::vector<ObjectData> buffers[FRAME_RESOURCE_COUNT];
+	for (std::vector<ObjectData>& buffer : buffers)
+	{
+		buffer.resize(count);
+		std::memset((void*)buffer.data(), 0xCD, buffer.size() * sizeof(ObjectData));
+	}
+	std::vector<XMFLOAT4X4> worlds(count);
+	std::vector<uint32_t> materials(count);
+	for (uint32_t id = 0; id < count; id++)
+	{
+		XMStoreFloat4x4(&worlds[id], XMMatrixIdentity());
+		materials[id] = id % 7;
+	}
+
+	std::mt19937 rng(23);
+	bool inSync = true;
+	uint64_t uploaded = 0;
+	for (unsigned int frame = 0; frame < 60; frame++)
+	{
+		// From a few objects to most of them.
+		const uint32_t changeCount = frame % 10 == 9 ? count : 1 + rng() % (count / 50);
+		for (uint32_t i = 0; i < changeCount; i++)
+		{
+			uint32_t id = rng() % count;
+			if (rng() % 4 == 0)
+			{
+				materials[id] = rng() % 7;
+				store->SetMaterial(id, materials[id]);
+			}
+			else
+			{
+				XMMATRIX world = XMMatrixTranslation((float)frame, (float)id, 0.5f);
+				XMStoreFloat4x4(&worlds[id], world);
+				store->SetWorldTransform(id, world);
+			}
+		}
+		store->ClearMoved();
+
+		const unsigned int frameResource = frame % FRAME_RESOURCE_COUNT;
+		std::vector<UploadTracker::Run> runs;
+		store->CollectUploads(frameResource, runs);
+		for (const UploadTracker::Run& run : runs)
+		{
+			std::memcpy(&buffers[frameResource][run.first], store->GetObjectData() + run.first, run.count * sizeof(ObjectData));
+			uploaded += run.count;
+		}
+
+		for (uint32_t id = 0; id < count; id++)
+		{
+			ObjectData expected = MakeRecord(XMLoadFloat4x4(&worlds[id]), MakeQuantization(0.5f + id), materials[id]);
+			inSync = inSync && std::memcmp(&buffers[frameResource][id], &expected, sizeof(ObjectData)) == 0;
+		}
+	}
+	CHECK(inSync);
+	// Only the changed records are copied, far fewer than rebuilding every record each frame.
+	CHECK(uploaded < 60ull * count / 2);
+}
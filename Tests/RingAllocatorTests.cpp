@@ -0,0 +1,222 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <random>
+#include <vector>
+
+#include "TestHarness.h"
+#include "RingAllocator.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	const uint64_t INVALID = RingAllocator::INVALID_OFFSET;
+}
+
+
+TEST_CASE("Offsets are aligned and padding is counted as used")
+{
+	RingAllocator ring(1024);
+
+	CHECK(ring.Allocate(100, 1) == 0);
+	CHECK(ring.Allocate(10, 256) == 256);
+	CHECK(ring.Allocate(4, 4) == 268);
+	CHECK(ring.GetUsedSize() == 272);
+
+	CHECK(ring.Allocate(0, 1) == INVALID);
+	CHECK(ring.Allocate(2048, 1) == INVALID);
+	CHECK(ring.GetUsedSize() == 272);
+}
+
+TEST_CASE("The ring fills up exactly")
+{
+	RingAllocator ring(256);
+
+	for (uint64_t i = 0; i < 4; i++)
+	{
+		CHECK(ring.Allocate(64, 64) == i * 64);
+	}
+	CHECK(ring.IsFull());
+	CHECK(ring.Allocate(1, 1) == INVALID);
+
+	ring.FinishSubmission(1);
+	ring.ReleaseCompleted(1);
+	CHECK(ring.IsEmpty());
+	CHECK(ring.Allocate(256, 256) == 0);
+}
+
+TEST_CASE("Allocations wrap around once the tail has moved")
+{
+	RingAllocator ring(1024);
+
+	CHECK(ring.Allocate(100, 1) == 0);
+	CHECK(ring.Allocate(10, 256) == 256);
+	ring.FinishSubmission(1);
+
+	CHECK(ring.Allocate(700, 1) == 266);
+	ring.FinishSubmission(2);
+
+	ring.ReleaseCompleted(1);
+	CHECK(ring.GetUsedSize() == 700);
+
+	// 58 bytes are left at the end, the block goes to the start and the skipped bytes are charged to it.
+	CHECK(ring.Allocate(200, 1) == 0);
+	CHECK(ring.GetUsedSize() == 700 + 58 + 200);
+
+	// Between the new head and the tail at 266 there are only 66 bytes.
+	CHECK(ring.Allocate(100, 1) == INVALID);
+	CHECK(ring.Allocate(64, 2) == 200);
+	ring.FinishSubmission(3);
+
+	// The skipped bytes belong to the wrapping submission and come back with it.
+	ring.ReleaseCompleted(2);
+	CHECK(ring.GetUsedSize() == 58 + 200 + 64);
+	ring.ReleaseCompleted(3);
+	CHECK(ring.IsEmpty());
+}
+
+TEST_CASE("Allocations larger than the tail fail until space retires")
+{
+	RingAllocator ring(1000);
+
+	CHECK(ring.Allocate(600, 1) == 0);
+	ring.FinishSubmission(1);
+	CHECK(ring.Allocate(300, 1) == 600);
+	ring.FinishSubmission(2);
+
+	// 100 bytes at the end and nothing in front of the tail.
+	CHECK(ring.Allocate(150, 1) == INVALID);
+	CHECK(ring.GetUsedSize() == 900);
+
+	// Alignment can push a block that would fit unaligned past the end.
+	CHECK(ring.Allocate(90, 64) == INVALID);
+
+	ring.ReleaseCompleted(1);
+	CHECK(ring.Allocate(150, 1) == 0);
+	CHECK(ring.GetUsedSize() == 300 + 100 + 150);
+
+	// Larger than the free range in front of the tail, with the head already wrapped.
+	CHECK(ring.Allocate(500, 1) == INVALID);
+	CHECK(ring.Allocate(450, 1) == 150);
+	CHECK(ring.IsFull());
+}
+
+TEST_CASE("A ring sized to one aligned block takes it at offset zero")
+{
+	// UploadAllocator creates such a page for uploads bigger than its page size.
+	const uint64_t alignment = 512;
+	const uint64_t size = 70000;
+	RingAllocator ring((size + alignment - 1) & ~(alignment - 1));
+
+	CHECK(ring.Allocate(size, alignment) == 0);
+	CHECK(ring.Allocate(size, alignment) == INVALID);
+}
+
+TEST_CASE("Submissions retire in fence order")
+{
+	RingAllocator ring(4096);
+
+	ring.Allocate(1000, 1);
+	ring.FinishSubmission(5);
+	ring.Allocate(1000, 1);
+	ring.FinishSubmission(6);
+	ring.Allocate(1000, 1);
+	ring.FinishSubmission(7);
+
+	// Nothing pending, no empty submission is recorded.
+	ring.FinishSubmission(8);
+
+	ring.ReleaseCompleted(4);
+	CHECK(ring.GetUsedSize() == 3000);
+	ring.ReleaseCompleted(6);
+	CHECK(ring.GetUsedSize() == 1000);
+
+	// Blocks allocated after the last FinishSubmission stay until their own submission retires.
+	ring.Allocate(500, 1);
+	ring.ReleaseCompleted(100);
+	CHECK(ring.GetUsedSize() == 500);
+	ring.FinishSubmission(101);
+	ring.ReleaseCompleted(101);
+	CHECK(ring.IsEmpty());
+
+	// An empty ring starts from zero again.
+	CHECK(ring.Allocate(4096, 1) == 0);
+}
+
+TEST_CASE("Live blocks never overlap")
+{
+	struct Block
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint64_t fenceValue;
+	};
+
+	const uint64_t ringSize = 4096;
+	RingAllocator ring(ringSize);
+
+	std::mt19937 rng(1);
+	std::vector<Block> live;
+	uint64_t fenceValue = 0;
+	uint64_t completed = 0;
+	unsigned int failures = 0;
+	unsigned int allocations = 0;
+
+	for (int i = 0; i < 100000; i++)
+	{
+		uint64_t size = 1 + rng() % 700;
+		uint64_t alignment = 1ull << (rng() % 6);
+
+		uint64_t offset = ring.Allocate(size, alignment);
+		if (offset != INVALID)
+		{
+			allocations++;
+			bool valid = offset % alignment == 0 && offset + size <= ringSize;
+			for (const Block& block : live)
+			{
+				valid &= offset + size <= block.offset || block.offset + block.size <= offset;
+			}
+			failures += valid ? 0 : 1;
+			live.push_back({ offset, size, fenceValue + 1 });
+		}
+
+		if (rng() % 3 == 0)
+		{
+			ring.FinishSubmission(++fenceValue);
+		}
+
+		if (rng() % 4 == 0 && completed < fenceValue)
+		{
+			completed += 1 + rng() % (fenceValue - completed);
+			ring.ReleaseCompleted(completed);
+
+			std::vector<Block> kept;
+			for (const Block& block : live)
+			{
+				if (block.fenceValue > completed)
+				{
+					kept.push_back(block);
+				}
+			}
+			live.swap(kept);
+		}
+
+		uint64_t liveSize = 0;
+		for (const Block& block : live)
+		{
+			liveSize += block.size;
+		}
+		failures += ring.GetUsedSize() >= liveSize ? 0 : 1;
+	}
+
+	CHECK(failures == 0);
+	CHECK(allocations > 10000);
+
+	ring.FinishSubmission(++fenceValue);
+	ring.ReleaseCompleted(fenceValue);
+	CHECK(ring.IsEmpty());
+}
@@ -0,0 +1,224 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <future>
+#include <random>
+
+#include "TestHarness.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include "SceneBvh.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	FrustumPlanes MakeFrustum(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+		XMMATRIX view = XMMatrixMultiply(XMMatrixTranslation(-u(rng) * 50.0f, -u(rng) * 10.0f, -u(rng) * 50.0f),
+			XMMatrixRotationY(u(rng) * 6.28f));
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.5f + u(rng), 0.5f + u(rng) * 2.0f, 0.1f + u(rng), 50.0f + u(rng) * 200.0f);
+
+		return FrustumPlanes::FromViewProj(XMMatrixMultiply(view, proj));
+	}
+
+	BoundingBox MakeBox(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+		std::uniform_real_distribution<float> extent(0.0f, 5.0f);
+
+		return BoundingBox(XMFLOAT3(position(rng), position(rng) * 0.1f, position(rng)),
+			XMFLOAT3(extent(rng), extent(rng), extent(rng)));
+	}
+
+	std::vector<unsigned int> CullSorted(const SceneBvh& bvh, const FrustumPlanes& frustum)
+	{
+		std::vector<unsigned int> visible;
+		bvh.Cull(frustum, visible);
+		std::sort(visible.begin(), visible.end());
+		return visible;
+	}
+
+	// The tree has to find exactly the boxes the linear culler finds, on the SSE and the AVX path.
+	bool MatchesLinear(const SceneBvh& bvh, const FrustumCuller& linear, std::mt19937& rng)
+	{
+		bool same = true;
+		for (int i = 0; i < 20; i++)
+		{
+			FrustumPlanes frustum = MakeFrustum(rng);
+
+			std::vector<unsigned int> expected;
+			linear.Cull(frustum, expected);
+
+			RestrictCpuFeatures({ true, false, false });
+			same = same && CullSorted(bvh, frustum) == expected;
+			RestrictCpuFeatures({ true, true, true });
+			same = same && CullSorted(bvh, frustum) == expected;
+		}
+
+		return same;
+	}
+}
+
+
+TEST_CASE("Queries match the linear culler")
+{
+	std::mt19937 rng(3);
+
+	// Counts around the 8 wide nodes.
+	for (unsigned int count : { 0u, 1u, 7u, 8u, 9u, 64u, 65u, 5000u })
+	{
+		SceneBvh bvh;
+		FrustumCuller linear;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			BoundingBox box = MakeBox(rng);
+			bvh.AddBox(box);
+			linear.AddBox(box);
+		}
+		bvh.Update();
+
+		CHECK(MatchesLinear(bvh, linear, rng));
+	}
+}
+
+TEST_CASE("Moved boxes are found after the refit")
+{
+	std::mt19937 rng(5);
+	SceneBvh bvh;
+	FrustumCuller linear;
+	for (unsigned int i = 0; i < 5000; i++)
+	{
+		BoundingBox box = MakeBox(rng);
+		bvh.AddBox(box);
+		linear.AddBox(box);
+	}
+	bvh.Update();
+
+	// Small moves keep the tree, the cost only grows a little.
+	std::uniform_real_distribution<float> jitter(-1.0f, 1.0f);
+	for (int frame = 0; frame < 5; frame++)
+	{
+		for (int i = 0; i < 100; i++)
+		{
+			unsigned int index = rng() % bvh.GetBoxCount();
+			BoundingBox box = bvh.GetBox(index);
+			box.Center.x += jitter(rng);
+			box.Center.z += jitter(rng);
+			bvh.SetBox(index, box);
+			linear.SetBox(index, box);
+		}
+		bvh.Update();
+	}
+	CHECK(bvh.GetRebuildCount() == 0);
+	CHECK(bvh.GetCostRatio() >= 1.0f && bvh.GetCostRatio() < 1.5f);
+	CHECK(MatchesLinear(bvh, linear, rng));
+
+	// Boxes added later are in the next tree.
+	for (int i = 0; i < 10; i++)
+	{
+		BoundingBox box = MakeBox(rng);
+		bvh.AddBox(box);
+		linear.AddBox(box);
+	}
+	std::vector<unsigned int> visible;
+	CHECK_THROWS(bvh.Cull(MakeFrustum(rng), visible));
+	bvh.Update();
+	CHECK(MatchesLinear(bvh, linear, rng));
+}
+
+TEST_CASE("A degraded tree is rebuilt")
+{
+	for (bool useJobSystem : { false, true })
+	{
+		std::mt19937 rng(7);
+		JobSystem jobSystem(2);
+		SceneBvh bvh(useJobSystem ? &jobSystem : nullptr);
+		FrustumCuller linear;
+		for (unsigned int i = 0; i < 5000; i++)
+		{
+			BoundingBox box = MakeBox(rng);
+			bvh.AddBox(box);
+			linear.AddBox(box);
+		}
+		bvh.Update();
+
+		// Scattered boxes stretch the nodes far past the threshold.
+		for (unsigned int i = 0; i < 1000; i++)
+		{
+			unsigned int index = rng() % bvh.GetBoxCount();
+			BoundingBox box = MakeBox(rng);
+			bvh.SetBox(index, box);
+			linear.SetBox(index, box);
+		}
+		bvh.Update();
+		CHECK(MatchesLinear(bvh, linear, rng));
+
+		// Nothing moves while the rebuild runs, so the new tree is as tight as a fresh build.
+		while (bvh.IsRebuilding())
+		{
+			bvh.Update();
+		}
+		CHECK(bvh.GetRebuildCount() == 1);
+		CHECK(bvh.GetCostRatio() < 1.5f);
+		CHECK(MatchesLinear(bvh, linear, rng));
+
+		bvh.Clear();
+		CHECK(bvh.GetBoxCount() == 0);
+	}
+}
+
+TEST_CASE("Boxes set during a rebuild are refit into the new tree")
+{
+	std::mt19937 rng(9);
+	JobSystem jobSystem(1);
+	SceneBvh bvh(&jobSystem);
+	FrustumCuller linear;
+	for (unsigned int i = 0; i < 5000; i++)
+	{
+		BoundingBox box = MakeBox(rng);
+		bvh.AddBox(box);
+		linear.AddBox(box);
+	}
+	bvh.Update();
+
+	// The only worker waits, so the rebuild queued behind it can't finish before the boxes below are set.
+	std::promise<void> release;
+	std::shared_future<void> released = release.get_future().share();
+	std::future<void> blocker = jobSystem.Submit([released]() { released.wait(); });
+
+	for (unsigned int i = 0; i < 1000; i++)
+	{
+		unsigned int index = rng() % bvh.GetBoxCount();
+		BoundingBox box = MakeBox(rng);
+		bvh.SetBox(index, box);
+		linear.SetBox(index, box);
+	}
+	bvh.Update();
+	CHECK(bvh.IsRebuilding());
+
+	for (unsigned int i = 0; i < 200; i++)
+	{
+		unsigned int index = rng() % bvh.GetBoxCount();
+		BoundingBox box = MakeBox(rng);
+		bvh.SetBox(index, box);
+		linear.SetBox(index, box);
+		bvh.Update();
+	}
+	release.set_value();
+	blocker.get();
+
+	while (bvh.IsRebuilding())
+	{
+		bvh.Update();
+	}
+	CHECK(bvh.GetRebuildCount() == 1);
+	CHECK(MatchesLinear(bvh, linear, rng));
+}
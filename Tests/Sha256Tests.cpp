@@ -0,0 +1,81 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <string>
+#include <vector>
+
+#include "TestHarness.h"
+#include "Sha256.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	std::string Hash(const std::string& text)
+	{
+		Sha256 hash;
+		hash.Update(text);
+		return Sha256::ToHex(hash.Finish());
+	}
+}
+
+
+// Known answers from FIPS 180-4 and the NIST CAVP short and long message sets.
+TEST_CASE("Known answer vectors")
+{
+	CHECK(Hash("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	CHECK(Hash("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+	CHECK(Hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+		"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+	CHECK(Hash("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu") ==
+		"cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1");
+	CHECK(Hash("The quick brown fox jumps over the lazy dog") ==
+		"d7a8fbb307d7809469ca9abcb0082e4f8d5651e46d3cdb762d02d0bf37c9e592");
+}
+
+TEST_CASE("One million a")
+{
+	Sha256 hash;
+	std::string block(1000, 'a');
+	for (int i = 0; i < 1000; i++)
+	{
+		hash.Update(block);
+	}
+	CHECK(Sha256::ToHex(hash.Finish()) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST_CASE("Padding around the block boundary")
+{
+	// 55 bytes still fit the length in the same block, 56 to 64 need a second one.
+	CHECK(Hash(std::string(55, 'a')) == "9f4390f8d30c2dd92ec9f095b65e2b9ae9b0a925a5258e241c9f1e910f734318");
+	CHECK(Hash(std::string(56, 'a')) == "b35439a4ac6f0948b6d6f9e3c6af0f5f590ce20f1bde7090ef7970686ec6738a");
+	CHECK(Hash(std::string(64, 'a')) == "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb");
+}
+
+TEST_CASE("Splitting the input does not change the digest")
+{
+	std::vector<uint8_t> data(1000);
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		data[i] = (uint8_t)(i * 31 + 7);
+	}
+
+	Sha256 whole;
+	whole.Update(data.data(), data.size());
+	Sha256::Digest expected = whole.Finish();
+
+	bool same = true;
+	for (size_t split : { 1, 55, 63, 64, 65, 128, 999 })
+	{
+		Sha256 parts;
+		for (size_t offset = 0; offset < data.size(); offset += split)
+		{
+			parts.Update(data.data() + offset, std::min(split, data.size() - offset));
+		}
+		same &= parts.Finish() == expected;
+	}
+	CHECK(same);
+}
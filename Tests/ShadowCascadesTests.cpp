@@ -0,0 +1,274 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "TestHarness.h"
+#include "ShadowCascades.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	const unsigned int RESOLUTION = 2048;
+	const float FOV_Y = 0.785f;
+	const float ASPECT = 16.0f / 9.0f;
+
+	XMMATRIX MakeCameraView(const XMFLOAT3& position, float pitch, float yaw)
+	{
+		XMMATRIX world = XMMatrixMultiply(XMMatrixRotationRollPitchYaw(pitch, yaw, 0.0f),
+			XMMatrixTranslation(position.x, position.y, position.z));
+		return XMMatrixInverse(nullptr, world);
+	}
+
+	// The 8 world space corners of the frustum slice between two view depths.
+	void GetSliceCorners(FXMMATRIX invView, float tanHalfFovX, float tanHalfFovY, float sliceNear, float sliceFar,
+		XMFLOAT3* corners)
+	{
+		unsigned int k = 0;
+		for (float z : { sliceNear, sliceFar })
+		{
+			for (unsigned int i = 0; i < 4; i++)
+			{
+				float x = ((i & 1) ? tanHalfFovX : -tanHalfFovX) * z;
+				float y = ((i & 2) ? tanHalfFovY : -tanHalfFovY) * z;
+				XMStoreFloat3(&corners[k++], XMVector3TransformCoord(XMVectorSet(x, y, z, 1.0f), invView));
+			}
+		}
+	}
+
+	XMFLOAT3 ProjectToCascade(const ShadowCascade& cascade, const XMFLOAT3& point)
+	{
+		XMMATRIX viewProj = XMMatrixMultiply(XMLoadFloat4x4(&cascade.view), XMLoadFloat4x4(&cascade.proj));
+		XMFLOAT3 projected;
+		XMStoreFloat3(&projected, XMVector3TransformCoord(XMLoadFloat3(&point), viewProj));
+		return projected;
+	}
+
+	// Whether two clip space coordinates lie equally far into their shadow map texels.
+	bool IsSameTexelOffset(float a, float b)
+	{
+		float texelA = (a * 0.5f + 0.5f) * RESOLUTION;
+		float texelB = (b * 0.5f + 0.5f) * RESOLUTION;
+		float offset = std::fabs((texelA - std::floor(texelA)) - (texelB - std::floor(texelB)));
+		return std::min(offset, 1.0f - offset) < 0.02f;
+	}
+
+	// A random light from above and a camera walking over the scene.
+	struct View
+	{
+		XMVECTOR lightDir;
+		XMFLOAT3 position;
+		float pitch;
+		float yaw;
+	};
+
+	View MakeView(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+		View view;
+		view.lightDir = XMVector3Normalize(XMVectorSet(u(rng) - 0.5f, -0.2f - u(rng), u(rng) - 0.5f, 0.0f));
+		view.position = XMFLOAT3(u(rng) * 100.0f - 50.0f, 1.0f + u(rng) * 10.0f, u(rng) * 100.0f - 50.0f);
+		view.pitch = u(rng) - 0.5f;
+		view.yaw = u(rng) * 6.28f;
+		return view;
+	}
+
+	const BoundingBox CASTERS(XMFLOAT3(0.0f, 10.0f, 0.0f), XMFLOAT3(200.0f, 10.0f, 200.0f));
+}
+
+
+TEST_CASE("Splits blend the uniform and the logarithmic split")
+{
+	float splits[ShadowCascades::MAX_CASCADES + 1];
+
+	ShadowCascades::ComputeSplits(1.0f, 101.0f, 4, 0.0f, splits);
+	CHECK(splits[0] == 1.0f && splits[4] == 101.0f);
+	CHECK(std::fabs(splits[1] - 26.0f) < 1e-4f && std::fabs(splits[2] - 51.0f) < 1e-4f && std::fabs(splits[3] - 76.0f) < 1e-4f);
+
+	ShadowCascades::ComputeSplits(1.0f, 10000.0f, 4, 1.0f, splits);
+	CHECK(std::fabs(splits[1] - 10.0f) < 1e-3f && std::fabs(splits[2] - 100.0f) < 1e-2f && std::fabs(splits[3] - 1000.0f) < 0.1f);
+}
+
+TEST_CASE("Splits increase from near to far")
+{
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+	bool increasing = true;
+	for (unsigned int t = 0; t < 1000; t++)
+	{
+		float nearZ = 0.1f + u(rng) * 2.0f;
+		float farZ = nearZ + 1.0f + u(rng) * 500.0f;
+		unsigned int count = 1 + t % ShadowCascades::MAX_CASCADES;
+
+		float splits[ShadowCascades::MAX_CASCADES + 1];
+		ShadowCascades::ComputeSplits(nearZ, farZ, count, u(rng), splits);
+
+		increasing = increasing && splits[0] == nearZ && splits[count] == farZ;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			increasing = increasing && splits[i] < splits[i + 1];
+		}
+	}
+	CHECK(increasing);
+}
+
+TEST_CASE("Slice spheres enclose the slice corners")
+{
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+	bool encloses = true;
+	bool sameRadius = true;
+	float worstSlack = 0.0f;
+	for (unsigned int t = 0; t < 1000; t++)
+	{
+		float tanHalfFovY = std::tan((0.3f + u(rng) * 1.5f) * 0.5f);
+		float tanHalfFovX = tanHalfFovY * (0.5f + u(rng) * 2.0f);
+		float sliceNear = 0.1f + u(rng) * 20.0f;
+		float sliceFar = sliceNear + 0.1f + u(rng) * 300.0f;
+
+		XMMATRIX invView = XMMatrixInverse(nullptr, MakeCameraView(XMFLOAT3(u(rng) * 100.0f, u(rng) * 100.0f, u(rng) * 100.0f),
+			u(rng) * 3.0f - 1.5f, u(rng) * 6.28f));
+		BoundingSphere sphere = ShadowCascades::GetSliceSphere(invView, tanHalfFovX, tanHalfFovY, sliceNear, sliceFar);
+
+		// The size depends on the slice only, not on where the camera looks.
+		BoundingSphere axisSphere = ShadowCascades::GetSliceSphere(XMMatrixIdentity(), tanHalfFovX, tanHalfFovY, sliceNear, sliceFar);
+		sameRadius = sameRadius && sphere.Radius == axisSphere.Radius;
+
+		XMFLOAT3 corners[8];
+		GetSliceCorners(invView, tanHalfFovX, tanHalfFovY, sliceNear, sliceFar, corners);
+
+		float farthest = 0.0f;
+		for (const XMFLOAT3& corner : corners)
+		{
+			farthest = std::max(farthest, XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&corner), XMLoadFloat3(&sphere.Center)))));
+		}
+		encloses = encloses && farthest <= sphere.Radius * (1.0f + 1e-4f);
+		worstSlack = std::max(worstSlack, (sphere.Radius - farthest) / sphere.Radius);
+	}
+	CHECK(encloses);
+	CHECK(sameRadius);
+
+	// The smallest sphere touches the farthest corners.
+	CHECK(worstSlack < 1e-3f);
+}
+
+TEST_CASE("Cascades cover their slices and the casters")
+{
+	std::mt19937 rng(7);
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(FOV_Y, ASPECT, 1.0f, 1000.0f);
+	float tanHalfFovY = std::tan(FOV_Y * 0.5f);
+
+	ShadowCascades cascades(RESOLUTION);
+	float texelSizes[ShadowCascades::MAX_CASCADES] = {};
+	bool covered = true;
+	bool castersInside = true;
+	bool onGrid = true;
+	bool sameSize = true;
+	for (unsigned int t = 0; t < 300; t++)
+	{
+		View v = MakeView(rng);
+		XMMATRIX view = MakeCameraView(v.position, v.pitch, v.yaw);
+		cascades.Update(view, proj, 1.0f, 1000.0f, v.lightDir, CASTERS);
+
+		for (unsigned int i = 0; i < cascades.GetCascadeCount(); i++)
+		{
+			const ShadowCascade& cascade = cascades.GetCascade(i);
+
+			// Turning the camera or the light doesn't change the texel size.
+			texelSizes[i] = t == 0 ? cascade.texelSize : texelSizes[i];
+			sameSize = sameSize && cascade.texelSize == texelSizes[i];
+
+			// The slice stays inside by about a texel for the filter kernel.
+			const float border = 0.98f * 2.0f / RESOLUTION;
+			XMFLOAT3 corners[8];
+			GetSliceCorners(XMMatrixInverse(nullptr, view), tanHalfFovY * ASPECT, tanHalfFovY, cascade.splitNear, cascade.splitFar, corners);
+			for (const XMFLOAT3& corner : corners)
+			{
+				XMFLOAT3 p = ProjectToCascade(cascade, corner);
+				covered = covered && std::fabs(p.x) <= 1.0f - border && std::fabs(p.y) <= 1.0f - border && p.z >= 0.0f && p.z <= 1.0f;
+			}
+
+			// Casters in front of the slice still write depth.
+			XMFLOAT3 casterCorners[BoundingBox::CORNER_COUNT];
+			CASTERS.GetCorners(casterCorners);
+			for (const XMFLOAT3& corner : casterCorners)
+			{
+				castersInside = castersInside && ProjectToCascade(cascade, corner).z >= -1e-5f;
+			}
+
+			// The left edge of the projection lies on the texel grid of the light view.
+			float left = (-1.0f - cascade.proj._41) / cascade.proj._11;
+			float texels = left / cascade.texelSize;
+			onGrid = onGrid && std::fabs(texels - std::round(texels)) < 1e-2f;
+		}
+	}
+	CHECK(covered);
+	CHECK(castersInside);
+	CHECK(onGrid);
+	CHECK(sameSize);
+}
+
+TEST_CASE("Sub-texel camera moves keep the texels in place")
+{
+	std::mt19937 rng(11);
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(FOV_Y, ASPECT, 1.0f, 1000.0f);
+
+	bool steady = true;
+	for (unsigned int t = 0; t < 300; t++)
+	{
+		View v = MakeView(rng);
+		ShadowCascades cascades(RESOLUTION);
+		cascades.Update(MakeCameraView(v.position, v.pitch, v.yaw), proj, 1.0f, 1000.0f, v.lightDir, CASTERS);
+
+		for (unsigned int i = 0; i < cascades.GetCascadeCount(); i++)
+		{
+			const ShadowCascade& cascade = cascades.GetCascade(i);
+
+			XMFLOAT3 moved(v.position.x + cascade.texelSize * 0.37f, v.position.y, v.position.z - cascade.texelSize * 0.21f);
+			ShadowCascades other(RESOLUTION);
+			other.Update(MakeCameraView(moved, v.pitch, v.yaw), proj, 1.0f, 1000.0f, v.lightDir, CASTERS);
+
+			// A world point keeps its position within its shadow map texel, the projection moved in whole texels.
+			XMFLOAT3 point(v.position.x + 3.0f, v.position.y - 1.0f, v.position.z + 5.0f);
+			XMFLOAT3 before = ProjectToCascade(cascade, point);
+			XMFLOAT3 after = ProjectToCascade(other.GetCascade(i), point);
+			steady = steady && IsSameTexelOffset(before.x, after.x) && IsSameTexelOffset(before.y, after.y);
+		}
+	}
+	CHECK(steady);
+}
+
+TEST_CASE("Fewer cascades end at the shadow distance")
+{
+	ShadowCascades cascades(RESOLUTION);
+	cascades.SetCascadeCount(2);
+	cascades.Update(MakeCameraView(XMFLOAT3(0.0f, 2.0f, 0.0f), 0.0f, 0.0f), XMMatrixPerspectiveFovLH(FOV_Y, ASPECT, 1.0f, 1000.0f),
+		1.0f, 1000.0f, XMVectorSet(0.3f, -1.0f, 0.2f, 0.0f), CASTERS);
+
+	CHECK(cascades.GetCascade(0).splitNear == 1.0f);
+	CHECK(cascades.GetCascade(0).splitFar == cascades.GetCascade(1).splitNear);
+	CHECK(cascades.GetCascade(1).splitFar == cascades.GetShadowDistance());
+	CHECK(cascades.GetCascade(0).texelSize < cascades.GetCascade(1).texelSize);
+}
+
+TEST_CASE("Invalid settings throw")
+{
+	CHECK_THROWS(ShadowCascades(RESOLUTION, 0));
+	CHECK_THROWS(ShadowCascades(RESOLUTION, ShadowCascades::MAX_CASCADES + 1));
+	CHECK_THROWS(ShadowCascades(2047));
+	CHECK_THROWS(ShadowCascades(4));
+
+	ShadowCascades cascades(RESOLUTION);
+	CHECK_THROWS(cascades.SetCascadeCount(0));
+	CHECK(cascades.GetCascadeCount() == ShadowCascades::MAX_CASCADES);
+}
@@ -0,0 +1,84 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#pragma once
+
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+
+namespace Humpback
+{
+	namespace Test
+	{
+		struct TestCase
+		{
+			const char* name;
+			std::function<void()> func;
+		};
+
+		inline std::vector<TestCase>& GetTestCases()
+		{
+			static std::vector<TestCase> testCases;
+			return testCases;
+		}
+
+		inline unsigned int& GetFailureCount()
+		{
+			static unsigned int failureCount = 0;
+			return failureCount;
+		}
+
+		inline void ReportFailure(const char* file, int line, const char* expression)
+		{
+			std::printf("%s(%d): check failed: %s\n", file, line, expression);
+			++GetFailureCount();
+		}
+
+		struct Registrar
+		{
+			Registrar(const char* name, std::function<void()> func)
+			{
+				GetTestCases().push_back({ name, std::move(func) });
+			}
+		};
+	}
+}
+
+
+#define HB_CONCAT_IMPL(a, b) a##b
+#define HB_CONCAT(a, b) HB_CONCAT_IMPL(a, b)
+
+#define TEST_CASE(name) \
+	static void HB_CONCAT(TestFunc_, __LINE__)(); \
+	static Humpback::Test::Registrar HB_CONCAT(TestRegistrar_, __LINE__)(name, &HB_CONCAT(TestFunc_, __LINE__)); \
+	static void HB_CONCAT(TestFunc_, __LINE__)()
+
+#define CHECK(expression) \
+	do \
+	{ \
+		if (!(expression)) \
+		{ \
+			Humpback::Test::ReportFailure(__FILE__, __LINE__, #expression); \
+		} \
+	} while (0)
+
+#define CHECK_THROWS(expression) \
+	do \
+	{ \
+		bool threw = false; \
+		try \
+		{ \
+			expression; \
+		} \
+		catch (...) \
+		{ \
+			threw = true; \
+		} \
+		if (threw == false) \
+		{ \
+			Humpback::Test::ReportFailure(__FILE__, __LINE__, "throws " #expression); \
+		} \
+	} while (0)
@@ -0,0 +1,37 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <exception>
+
+#include "TestHarness.h"
+
+
+int main()
+{
+	using namespace Humpback::Test;
+
+	unsigned int failedCases = 0;
+	for (auto& testCase : GetTestCases())
+	{
+		unsigned int failuresBefore = GetFailureCount();
+
+		try
+		{
+			testCase.func();
+		}
+		catch (const std::exception& e)
+		{
+			std::printf("%s: unexpected exception: %s\n", testCase.name, e.what());
+			++GetFailureCount();
+		}
+
+		bool passed = GetFailureCount() == failuresBefore;
+		failedCases += passed ? 0 : 1;
+		std::printf("[%s] %s\n", passed ? "  OK  " : "FAILED", testCase.name);
+	}
+
+	std::printf("%zu test cases, %u failed.\n", GetTestCases().size(), failedCases);
+
+	return failedCases == 0 ? 0 : 1;
+}
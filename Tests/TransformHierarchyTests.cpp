@@ -0,0 +1,183 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <set>
+
+#include "TestHarness.h"
+#include "TransformHierarchy.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	XMMATRIX MakeLocalTransform(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> angle(-3.0f, 3.0f);
+		std::uniform_real_distribution<float> offset(-2.0f, 2.0f);
+		std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+		return XMMatrixMultiply(XMMatrixMultiply(XMMatrixScaling(scale(rng), scale(rng), scale(rng)), XMMatrixRotationY(angle(rng))),
+			XMMatrixTranslation(offset(rng), offset(rng), offset(rng)));
+	}
+
+	// Parents within the previous span nodes, the first roots nodes are roots.
+	std::vector<uint32_t> MakeParents(uint32_t count, uint32_t roots, uint32_t span, std::mt19937& rng)
+	{
+		std::vector<uint32_t> parents(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			parents[i] = i < roots ? TransformHierarchy::NO_PARENT : i - 1 - rng() % std::min(span, i);
+		}
+		return parents;
+	}
+
+	// Every world transform recomputed from the local ones, the result the hierarchy has to match exactly.
+	std::vector<XMFLOAT4X4A> ComputeWorldTransforms(const TransformHierarchy& hierarchy)
+	{
+		std::vector<XMFLOAT4X4A> world(hierarchy.GetNodeCount());
+		for (uint32_t i = 0; i < hierarchy.GetNodeCount(); i++)
+		{
+			uint32_t parent = hierarchy.GetParent(i);
+			XMMATRIX local = hierarchy.GetLocalTransform(i);
+			XMStoreFloat4x4A(&world[i], parent == TransformHierarchy::NO_PARENT ? local : XMMatrixMultiply(local, XMLoadFloat4x4A(&world[parent])));
+		}
+		return world;
+	}
+
+	bool MatchesRecompute(const TransformHierarchy& hierarchy)
+	{
+		std::vector<XMFLOAT4X4A> expected = ComputeWorldTransforms(hierarchy);
+		return std::memcmp(expected.data(), hierarchy.GetWorldTransforms(), expected.size() * sizeof(XMFLOAT4X4A)) == 0;
+	}
+
+	// The moved nodes and everything below them, in ascending order.
+	std::vector<uint32_t> GetSubtrees(const TransformHierarchy& hierarchy, const std::set<uint32_t>& moved)
+	{
+		std::vector<uint8_t> inside(hierarchy.GetNodeCount(), 0);
+		std::vector<uint32_t> nodes;
+		for (uint32_t i = 0; i < hierarchy.GetNodeCount(); i++)
+		{
+			uint32_t parent = hierarchy.GetParent(i);
+			inside[i] = moved.count(i) > 0 || (parent != TransformHierarchy::NO_PARENT && inside[parent]);
+			if (inside[i])
+			{
+				nodes.push_back(i);
+			}
+		}
+		return nodes;
+	}
+
+	std::vector<uint32_t> GetAllNodes(uint32_t count)
+	{
+		std::vector<uint32_t> nodes(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			nodes[i] = i;
+		}
+		return nodes;
+	}
+}
+
+
+TEST_CASE("World transforms follow the parents")
+{
+	std::mt19937 rng(3);
+	for (uint32_t span : { 1u, 8u, 1000u })
+	{
+		TransformHierarchy hierarchy;
+		for (uint32_t parent : MakeParents(5000, 4, span, rng))
+		{
+			hierarchy.AddNode(parent, MakeLocalTransform(rng));
+		}
+
+		CHECK(hierarchy.Update() == GetAllNodes(5000));
+		CHECK(MatchesRecompute(hierarchy));
+		CHECK(hierarchy.Update().empty());
+	}
+
+	// A chain of translations adds up.
+	TransformHierarchy chain;
+	uint32_t node = TransformHierarchy::NO_PARENT;
+	for (int i = 0; i < 10; i++)
+	{
+		node = chain.AddNode(node, XMMatrixTranslation(1.0f, 0.0f, 0.5f));
+	}
+	chain.Update();
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, chain.GetWorldTransform(node));
+	CHECK(world._41 == 10.0f && world._42 == 0.0f && world._43 == 5.0f);
+}
+
+TEST_CASE("Only the moved subtrees are updated")
+{
+	std::mt19937 rng(11);
+	TransformHierarchy hierarchy;
+	for (uint32_t parent : MakeParents(20000, 16, 64, rng))
+	{
+		hierarchy.AddNode(parent, MakeLocalTransform(rng));
+	}
+	hierarchy.Update();
+
+	for (uint32_t movedCount : { 1u, 10u, 200u, 5000u })
+	{
+		std::set<uint32_t> moved;
+		for (uint32_t i = 0; i < movedCount; i++)
+		{
+			uint32_t node = rng() % hierarchy.GetNodeCount();
+			moved.insert(node);
+			hierarchy.SetLocalTransform(node, MakeLocalTransform(rng));
+		}
+
+		CHECK(hierarchy.Update() == GetSubtrees(hierarchy, moved));
+		CHECK(MatchesRecompute(hierarchy));
+	}
+
+	// Setting the same node twice updates it once, with the last transform.
+	hierarchy.SetLocalTransform(7, XMMatrixTranslation(1.0f, 2.0f, 3.0f));
+	hierarchy.SetLocalTransform(7, XMMatrixTranslation(4.0f, 5.0f, 6.0f));
+	CHECK(hierarchy.Update() == GetSubtrees(hierarchy, { 7 }));
+	XMFLOAT4X4 local;
+	XMStoreFloat4x4(&local, hierarchy.GetLocalTransform(7));
+	CHECK(local._41 == 4.0f && local._42 == 5.0f && local._43 == 6.0f);
+	CHECK(MatchesRecompute(hierarchy));
+}
+
+TEST_CASE("Nodes added later are updated with the next pass")
+{
+	std::mt19937 rng(5);
+	TransformHierarchy hierarchy;
+	for (uint32_t i = 0; i < 100; i++)
+	{
+		hierarchy.AddNode(i == 0 ? TransformHierarchy::NO_PARENT : i - 1, MakeLocalTransform(rng));
+	}
+	hierarchy.Update();
+
+	uint32_t leaf = hierarchy.AddNode(50, MakeLocalTransform(rng));
+	uint32_t root = hierarchy.AddNode(TransformHierarchy::NO_PARENT, MakeLocalTransform(rng));
+	CHECK(hierarchy.Update() == std::vector<uint32_t>({ leaf, root }));
+	CHECK(MatchesRecompute(hierarchy));
+
+	hierarchy.Clear();
+	CHECK(hierarchy.GetNodeCount() == 0);
+	CHECK(hierarchy.Update().empty());
+	CHECK(hierarchy.AddNode(TransformHierarchy::NO_PARENT, XMMatrixIdentity()) == 0);
+	CHECK(hierarchy.AddNode(0, XMMatrixIdentity()) == 1);
+	CHECK(hierarchy.Update() == GetAllNodes(2));
+}
+
+TEST_CASE("Parents have to come first")
+{
+	TransformHierarchy hierarchy;
+	CHECK_THROWS(hierarchy.AddNode(0, XMMatrixIdentity()));
+	hierarchy.AddNode(TransformHierarchy::NO_PARENT, XMMatrixIdentity());
+	CHECK_THROWS(hierarchy.AddNode(1, XMMatrixIdentity()));
+	CHECK_THROWS(hierarchy.AddNode(5, XMMatrixIdentity()));
+	CHECK(hierarchy.GetNodeCount() == 1);
+	CHECK(hierarchy.AddNode(0, XMMatrixIdentity()) == 1);
+}
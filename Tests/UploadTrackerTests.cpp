@@ -0,0 +1,200 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <random>
+
+#include "TestHarness.h"
+#include "UploadTracker.h"
+
+
+using namespace Humpback;
+
+
+namespace
+{
+	// The pending frame resources of every element as plain flags, what the tracker has to agree with.
+	class ReferenceTracker
+	{
+	public:
+		explicit ReferenceTracker(unsigned int frameResourceCount) : m_frameResourceCount(frameResourceCount)
+		{
+		}
+
+		void Resize(uint32_t count)
+		{
+			m_pending.resize(count, std::vector<bool>(m_frameResourceCount, true));
+		}
+
+		void Mark(uint32_t index)
+		{
+			m_pending[index].assign(m_frameResourceCount, true);
+		}
+
+		uint32_t GetPendingCount(unsigned int frameResource) const
+		{
+			uint32_t count = 0;
+			for (const std::vector<bool>& pending : m_pending)
+			{
+				count += pending[frameResource] ? 1 : 0;
+			}
+			return count;
+		}
+
+		// The longest runs of pending elements, in ascending order.
+		std::vector<UploadTracker::Run> Collect(unsigned int frameResource)
+		{
+			std::vector<UploadTracker::Run> runs;
+			for (uint32_t i = 0; i < m_pending.size(); i++)
+			{
+				if (m_pending[i][frameResource] == false)
+				{
+					continue;
+				}
+				m_pending[i][frameResource] = false;
+
+				if (runs.empty() == false && runs.back().first + runs.back().count == i)
+				{
+					runs.back().count++;
+				}
+				else
+				{
+					runs.push_back({ i, 1 });
+				}
+			}
+			return runs;
+		}
+
+	private:
+		unsigned int m_frameResourceCount;
+		std::vector<std::vector<bool>> m_pending;
+	};
+
+	bool SameRuns(const std::vector<UploadTracker::Run>& a, const std::vector<UploadTracker::Run>& b)
+	{
+		if (a.size() != b.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			if (a[i].first != b[i].first || a[i].count != b[i].count)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+
+TEST_CASE("New elements are pending for every frame resource")
+{
+	UploadTracker tracker(3);
+	tracker.Resize(20);
+	for (unsigned int f = 0; f < 3; f++)
+	{
+		CHECK(tracker.GetPendingCount(f) == 20);
+	}
+
+	std::vector<UploadTracker::Run> runs;
+	tracker.Collect(1, runs);
+	CHECK(runs.size() == 1 && runs[0].first == 0 && runs[0].count == 20);
+	CHECK(tracker.GetPendingCount(1) == 0);
+	CHECK(tracker.GetPendingCount(0) == 20);
+
+	// Nothing is left for that frame resource, Collect appends nothing.
+	tracker.Collect(1, runs);
+	CHECK(runs.size() == 1);
+
+	// Growing adds pending elements, shrinking drops the ones past the end.
+	tracker.Resize(25);
+	CHECK(tracker.GetPendingCount(1) == 5);
+	CHECK(tracker.GetPendingCount(2) == 25);
+	tracker.Resize(10);
+	CHECK(tracker.GetPendingCount(1) == 0);
+	CHECK(tracker.GetPendingCount(2) == 10);
+	CHECK(tracker.GetCount() == 10);
+}
+
+TEST_CASE("Marked elements reach every frame resource once")
+{
+	UploadTracker tracker(2);
+	tracker.Resize(100);
+	std::vector<UploadTracker::Run> runs;
+	tracker.Collect(0, runs);
+	tracker.Collect(1, runs);
+
+	// Marking twice before a collect counts once. Neighbours join a run.
+	tracker.Mark(40);
+	tracker.Mark(40);
+	tracker.Mark(41);
+	tracker.Mark(7);
+	tracker.Mark(99);
+	CHECK(tracker.GetPendingCount(0) == 4 && tracker.GetPendingCount(1) == 4);
+
+	runs.clear();
+	tracker.Collect(0, runs);
+	CHECK(SameRuns(runs, std::vector<UploadTracker::Run>({ { 7, 1 }, { 40, 2 }, { 99, 1 } })));
+
+	// Marking again before the other frame resource collected keeps it pending there once.
+	tracker.Mark(41);
+	CHECK(tracker.GetPendingCount(0) == 1 && tracker.GetPendingCount(1) == 4);
+
+	runs.clear();
+	tracker.Collect(1, runs);
+	CHECK(SameRuns(runs, std::vector<UploadTracker::Run>({ { 7, 1 }, { 40, 2 }, { 99, 1 } })));
+	runs.clear();
+	tracker.Collect(0, runs);
+	CHECK(SameRuns(runs, std::vector<UploadTracker::Run>({ { 41, 1 } })));
+}
+
+TEST_CASE("Runs match a per element scan")
+{
+	std::mt19937 rng(17);
+	for (unsigned int frameResourceCount : { 1u, 3u, 8u })
+	{
+		// Changes from sparse, collected from the sorted lists, to dense, collected by walking the flags.
+		for (uint32_t count : { 1u, 7u, 8u, 9u, 63u, 64u, 1000u, 4099u })
+		{
+			UploadTracker tracker(frameResourceCount);
+			ReferenceTracker reference(frameResourceCount);
+			tracker.Resize(count);
+			reference.Resize(count);
+
+			bool same = true;
+			for (unsigned int frame = 0; frame < 40; frame++)
+			{
+				const uint32_t markCount = rng() % (frame % 4 == 3 ? count + 1 : count / 16 + 2);
+				for (uint32_t i = 0; i < markCount; i++)
+				{
+					// Clustered marks make long runs, scattered ones short runs.
+					uint32_t index = frame % 2 == 0 ? rng() % count : (rng() % 4 + frame * 13) % count;
+					tracker.Mark(index);
+					reference.Mark(index);
+				}
+
+				const unsigned int frameResource = frame % frameResourceCount;
+				for (unsigned int f = 0; f < frameResourceCount; f++)
+				{
+					same = same && tracker.GetPendingCount(f) == reference.GetPendingCount(f);
+				}
+
+				std::vector<UploadTracker::Run> runs;
+				tracker.Collect(frameResource, runs);
+				same = same && SameRuns(runs, reference.Collect(frameResource));
+			}
+			CHECK(same);
+		}
+	}
+}
+
+TEST_CASE("Frame resource count is limited to 8")
+{
+	CHECK_THROWS(UploadTracker(0));
+	CHECK_THROWS(UploadTracker(9));
+
+	UploadTracker tracker(8);
+	tracker.Resize(3);
+	CHECK(tracker.GetPendingCount(7) == 3);
+}
@@ -0,0 +1,169 @@
+// (c) Li Hongcheng
+// 2026-10-17
+
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include "MeshOptimizer.h"
+#include "TestHarness.h"
+#include "Vertex.h"
+
+
+using namespace Humpback;
+using namespace DirectX;
+
+
+namespace
+{
+	bool SameBits(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return std::memcmp(&a, &b, sizeof(XMFLOAT3)) == 0;
+	}
+
+	struct TestMesh
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+
+		// Two submeshes, the second one's indices are relative to its base vertex.
+		size_t baseVertex = 0;
+		size_t firstIndex = 0;
+	};
+
+	TestMesh MakeMesh(std::mt19937& rng, unsigned int gridSize)
+	{
+		std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+
+		TestMesh mesh;
+		for (int part = 0; part < 2; part++)
+		{
+			if (part == 1)
+			{
+				mesh.baseVertex = mesh.vertices.size();
+				mesh.firstIndex = mesh.indices.size();
+			}
+
+			for (unsigned int y = 0; y <= gridSize; y++)
+			{
+				for (unsigned int x = 0; x <= gridSize; x++)
+				{
+					Vertex v;
+					v.position = XMFLOAT3((float)x + u(rng) * 0.1f, u(rng), (float)y + part * 100.0f);
+					v.normal = XMFLOAT3(u(rng), 1.0f, u(rng));
+					v.uv = XMFLOAT2((float)x / gridSize, (float)y / gridSize);
+					v.tangent = XMFLOAT3(1.0f, u(rng), 0.0f);
+					mesh.vertices.push_back(v);
+				}
+			}
+
+			for (unsigned int y = 0; y < gridSize; y++)
+			{
+				for (unsigned int x = 0; x < gridSize; x++)
+				{
+					uint32_t i0 = y * (gridSize + 1) + x;
+					uint32_t i1 = i0 + 1;
+					uint32_t i2 = i0 + gridSize + 1;
+					uint32_t i3 = i2 + 1;
+					mesh.indices.insert(mesh.indices.end(), { i0, i2, i1, i1, i2, i3 });
+				}
+			}
+		}
+
+		return mesh;
+	}
+}
+
+
+TEST_CASE("Position stream has one element per vertex")
+{
+	CHECK(BuildPositionStream({}).empty());
+
+	std::mt19937 rng(11);
+	TestMesh mesh = MakeMesh(rng, 17);
+	auto positions = BuildPositionStream(mesh.vertices);
+
+	CHECK(positions.size() == mesh.vertices.size());
+	CHECK(sizeof(positions[0]) == 12);
+}
+
+TEST_CASE("Both streams fetch the same triangles after the vertex fetch reorder")
+{
+	std::mt19937 rng(3);
+	TestMesh mesh = MakeMesh(rng, 31);
+
+	// Shuffle the triangles of each submesh so the reorder has vertices to move.
+	size_t submeshIndices[2][2] = { { 0, mesh.firstIndex }, { mesh.firstIndex, mesh.indices.size() } };
+	size_t submeshVertices[2][2] = { { 0, mesh.baseVertex }, { mesh.baseVertex, mesh.vertices.size() } };
+	for (auto& range : submeshIndices)
+	{
+		size_t triangleCount = (range[1] - range[0]) / 3;
+		for (size_t t = triangleCount - 1; t > 0; t--)
+		{
+			size_t other = std::uniform_int_distribution<size_t>(0, t)(rng);
+			std::swap_ranges(mesh.indices.begin() + range[0] + t * 3, mesh.indices.begin() + range[0] + t * 3 + 3,
+				mesh.indices.begin() + range[0] + other * 3);
+		}
+	}
+
+	auto fetchTriangle = [&](const XMFLOAT3* positions, size_t stride, size_t t, XMFLOAT3* triangle)
+		{
+			size_t baseVertex = t * 3 >= mesh.firstIndex ? mesh.baseVertex : 0;
+			for (size_t k = 0; k < 3; k++)
+			{
+				size_t vertex = baseVertex + mesh.indices[t * 3 + k];
+				triangle[k] = *(const XMFLOAT3*)((const uint8_t*)positions + vertex * stride);
+			}
+		};
+
+	size_t triangleCount = mesh.indices.size() / 3;
+	std::vector<XMFLOAT3> before(triangleCount * 3);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		fetchTriangle(&mesh.vertices[0].position, sizeof(Vertex), t, &before[t * 3]);
+	}
+
+	// Like MeshCooker: each submesh is renumbered on its own and the position stream is built afterwards.
+	std::vector<Vertex> original = mesh.vertices;
+	for (int part = 0; part < 2; part++)
+	{
+		OptimizeVertexFetch(mesh.indices.data() + submeshIndices[part][0], submeshIndices[part][1] - submeshIndices[part][0],
+			mesh.vertices.data() + submeshVertices[part][0], submeshVertices[part][1] - submeshVertices[part][0], sizeof(Vertex));
+	}
+	CHECK(std::memcmp(original.data(), mesh.vertices.data(), original.size() * sizeof(Vertex)) != 0);
+
+	auto positions = BuildPositionStream(mesh.vertices);
+
+	// A depth-only draw and the full draw share the index buffer and base vertex, so both passes
+	// rasterize identical depth, and the triangles are the ones before the reorder.
+	unsigned int mismatches = 0;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		XMFLOAT3 depthOnly[3];
+		XMFLOAT3 full[3];
+		fetchTriangle(positions.data(), sizeof(XMFLOAT3), t, depthOnly);
+		fetchTriangle(&mesh.vertices[0].position, sizeof(Vertex), t, full);
+
+		for (size_t k = 0; k < 3; k++)
+		{
+			bool same = SameBits(depthOnly[k], full[k]) && SameBits(full[k], before[t * 3 + k]);
+			mismatches += same ? 0 : 1;
+		}
+	}
+	CHECK(mismatches == 0);
+}
+
+TEST_CASE("Position stream keeps special float values")
+{
+	std::vector<Vertex> vertices(3);
+	vertices[0].position = XMFLOAT3(-0.0f, 1e-40f, 3.4e38f);
+	vertices[1].position = XMFLOAT3(1.0f, -2.0f, 0.5f);
+	vertices[2].position = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+	auto positions = BuildPositionStream(vertices);
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		CHECK(SameBits(positions[i], vertices[i].position));
+	}
+}